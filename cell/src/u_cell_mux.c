@@ -90,10 +90,32 @@
 #include "u_cell_mux.h"
 #include "u_cell_mux_private.h"
 
+#ifndef U_CFG_LOG_LEVEL_CELL_MUX
+/** The minimum level of the leveled logging of this module; the
+ * (copious) CMUX debug prints are at #U_LOG_LEVEL_DEBUG and so
+ * are only compiled in if U_CELL_MUX_ENABLE_DEBUG is defined or
+ * this is overridden.
+ */
+# ifdef U_CELL_MUX_ENABLE_DEBUG
+#  define U_CFG_LOG_LEVEL_CELL_MUX U_LOG_LEVEL_DEBUG
+# else
+#  define U_CFG_LOG_LEVEL_CELL_MUX U_LOG_LEVEL_INFO
+# endif
+#endif
+#define U_LOG_MODULE_LEVEL U_CFG_LOG_LEVEL_CELL_MUX
+#include "u_log.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_CELL_MUX_LOG_HEX_BYTES_PER_LINE
+/** The number of bytes per line when CMUX frames are printed
+ * for debug.
+ */
+# define U_CELL_MUX_LOG_HEX_BYTES_PER_LINE 16
+#endif
+
 #ifndef U_CELL_MUX_SABM_TIMEOUT_MS
 /** How long to wait for SABM to be agreed with the module (i.e. for
  * UA to come back for it).
@@ -201,6 +223,31 @@ static const char gMuxCldCommandFrame[] = {0xf9, 0x03, 0xff, 0x05, 0xc3, 0x01, 0
  * STATIC FUNCTIONS: HELPER FUNCTIONS FOR VIRTUAL SERIAL PORT
  * -------------------------------------------------------------- */
 
+// Print some CMUX bytes in hex, a line at a time rather than a
+// character at a time; only call this inside
+// U_LOG_IS_ENABLED(U_LOG_LEVEL_DEBUG) so that it is compiled out
+// when not required.
+static void logHex(int32_t channel, const char *pDescription,
+                   const char *pBuffer, size_t length)
+{
+    const char hexDigits[] = "0123456789abcdef";
+    char hex[(U_CELL_MUX_LOG_HEX_BYTES_PER_LINE * 3) + 1];
+    size_t x = 0;
+    size_t y;
+
+    U_LOG_DEBUG("U_CELL_CMUX_%d: %s %d byte(s):\n", (int) channel,
+                pDescription, (int) length);
+    while (x < length) {
+        for (y = 0; (y < U_CELL_MUX_LOG_HEX_BYTES_PER_LINE) && (x < length); y++, x++) {
+            hex[y * 3] = ' ';
+            hex[(y * 3) + 1] = hexDigits[(((uint8_t) *(pBuffer + x)) >> 4) & 0x0f];
+            hex[(y * 3) + 2] = hexDigits[((uint8_t) *(pBuffer + x)) & 0x0f];
+        }
+        hex[y * 3] = 0;
+        U_LOG_DEBUG("U_CELL_CMUX_%d: %s\n", (int) channel, hex);
+    }
+}
+
 // Event handler, common to all virtual serial ports.
 static void eventHandler(void *pParam, size_t paramLength)
 {
@@ -478,10 +525,8 @@ static int32_t sendFlowControl(uCellMuxPrivateContext_t *pContext,
         buffer[3] |= 0x02;   // Flow control is set to "please Mr Modem, do not send to us"
     }
 
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-    uPortLog("U_CELL_CMUX_%d: %s [%02x%02x%02x%02x].\n", channel,
-             stopNotGo ? "STOP" : "START", buffer[0], buffer[1], buffer[2], buffer[3]);
-#endif
+    U_LOG_DEBUG("U_CELL_CMUX_%d: %s [%02x%02x%02x%02x].\n", channel,
+                stopNotGo ? "STOP" : "START", buffer[0], buffer[1], buffer[2], buffer[3]);
 
     return serialWriteInnards(pDeviceSerial, buffer, sizeof(buffer));
 }
@@ -512,13 +557,9 @@ static int32_t sendCommandCheckResponse(uDeviceSerial_t *pDeviceSerial,
         pTraffic->wantedResponseFrameType = pFrameCheck->type;
         errorCode = uPortUartWrite(pChannelContext->pContext->underlyingStreamHandle, buffer, length);
         if (errorCode == length) {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-            uPortLog("U_CELL_CMUX_%d: tx %d byte(s): ", pChannelContext->channel, errorCode);
-            for (int32_t x = 0; x < errorCode; x++) {
-                uPortLog("[%02x]", buffer[x]);
+            if (U_LOG_IS_ENABLED(U_LOG_LEVEL_DEBUG)) {
+                logHex(pChannelContext->channel, "tx", buffer, errorCode);
             }
-            uPortLog(".\n");
-#endif
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
             if (timeoutMs > 0) {
                 errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
@@ -529,14 +570,12 @@ static int32_t sendCommandCheckResponse(uDeviceSerial_t *pDeviceSerial,
                     uPortTaskBlock(10);
                 }
                 if (pTraffic->wantedResponseFrameType == U_CELL_MUX_PRIVATE_FRAME_TYPE_NONE) {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
                     if (pChannelContext->channel == 0) {
                         // For the control channel we need to print the frame type out
                         // here as the message is removed before it gets to cmuxDecode()
-                        uPortLog("U_CELL_CMUX_%d: rx frame type 0x%02x.\n", pChannelContext->channel,
-                                 pFrameCheck->type);
+                        U_LOG_DEBUG("U_CELL_CMUX_%d: rx frame type 0x%02x.\n", pChannelContext->channel,
+                                    pFrameCheck->type);
                     }
-#endif
                     if (pFrameCheck->informationLengthBytes > 0) {
                         // Need to look for the right information field contents also
                         length = serialReadInnards(pTraffic, buffer, sizeof(buffer));
@@ -548,29 +587,20 @@ static int32_t sendCommandCheckResponse(uDeviceSerial_t *pDeviceSerial,
                             length--;
                         }
                         if (length >= (int32_t) pFrameCheck->informationLengthBytes) {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                            uPortLog("U_CELL_CMUX_%d: decoded I-field %d byte(s):",
-                                     pChannelContext->channel,
-                                     pFrameCheck->informationLengthBytes);
-                            for (size_t x = 0; x < pFrameCheck->informationLengthBytes; x++) {
-                                uPortLog(" %02x", *(pTmp + x));
+                            if (U_LOG_IS_ENABLED(U_LOG_LEVEL_DEBUG)) {
+                                logHex(pChannelContext->channel, "decoded I-field", pTmp,
+                                       pFrameCheck->informationLengthBytes);
                             }
-                            uPortLog(".\n");
-#endif
                             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                         }
                     } else {
                         errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                     }
                 } else {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                    uPortLog("U_CELL_CMUX_%d: no response.\n", pChannelContext->channel);
-#endif
+                    U_LOG_DEBUG("U_CELL_CMUX_%d: no response.\n", pChannelContext->channel);
                 }
             } else {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                uPortLog("U_CELL_CMUX_%d: not waiting for a response.\n", pChannelContext->channel);
-#endif
+                U_LOG_DEBUG("U_CELL_CMUX_%d: not waiting for a response.\n", pChannelContext->channel);
             }
         }
     } else {
@@ -777,9 +807,7 @@ static int32_t serialRead(struct uDeviceSerial_t *pDeviceSerial,
                         uPortUartEventSend(pChannelContext->pContext->underlyingStreamHandle,
                                            U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED);
                     }
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                    uPortLog("U_CELL_CMUX: decoding retriggered.\n");
-#endif
+                    U_LOG_DEBUG("U_CELL_CMUX: decoding retriggered.\n");
                 }
             }
         }
@@ -813,6 +841,103 @@ static int32_t serialWrite(struct uDeviceSerial_t *pDeviceSerial,
     return sizeOrErrorCode;
 }
 
+// Scatter-gather write to the virtual serial interface: rather than
+// each segment becoming one or more CMUX frames of its own, the
+// segments are gathered so that every frame, except perhaps the
+// last, carries the maximum information length.
+static int32_t serialWriteV(struct uDeviceSerial_t *pDeviceSerial,
+                            const uDeviceSerialSegment_t *pSegments,
+                            size_t numSegments)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uCellMuxPrivateChannelContext_t *pChannelContext = (uCellMuxPrivateChannelContext_t *)
+                                                       pUInterfaceContext(pDeviceSerial);
+    char *pGather = NULL;
+    size_t gatherSize = 0;
+    size_t totalSize = 0;
+    size_t sizeWritten = 0;
+    size_t thisSize;
+    const char *pData;
+    size_t dataSize;
+
+    if ((pChannelContext != NULL) && !pChannelContext->markedForDeletion &&
+        ((pSegments != NULL) || (numSegments == 0))) {
+
+        U_PORT_MUTEX_LOCK(pChannelContext->mutexUserDataWrite);
+
+        sizeOrErrorCode = (int32_t) U_CELL_ERROR_NOT_CONNECTED;
+        if (U_CELL_MUX_IS_OPEN(pChannelContext->state)) {
+            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            for (size_t x = 0; x < numSegments; x++) {
+                totalSize += pSegments[x].sizeBytes;
+            }
+            if (totalSize > U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES) {
+                totalSize = U_CELL_MUX_PRIVATE_INFORMATION_LENGTH_MAX_BYTES;
+            }
+            if ((numSegments > 1) && (totalSize > 0)) {
+                pGather = (char *) pUPortMalloc(totalSize);
+                if (pGather == NULL) {
+                    sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                }
+            }
+            for (size_t x = 0; (x < numSegments) && (sizeOrErrorCode >= 0); x++) {
+                pData = (const char *) pSegments[x].pData;
+                dataSize = pSegments[x].sizeBytes;
+                if ((pGather == NULL) ||
+                    ((gatherSize == 0) && (dataSize >= totalSize))) {
+                    // Nothing gathered and the segment will fill at
+                    // least one frame: send whole frames straight
+                    // from the segment, no need to copy
+                    thisSize = dataSize;
+                    if (pGather != NULL) {
+                        thisSize -= thisSize % totalSize;
+                    }
+                    if (thisSize > 0) {
+                        sizeOrErrorCode = serialWriteInnards(pDeviceSerial, pData, thisSize);
+                        if (sizeOrErrorCode >= 0) {
+                            sizeWritten += thisSize;
+                            pData += thisSize;
+                            dataSize -= thisSize;
+                        }
+                    }
+                }
+                while ((dataSize > 0) && (sizeOrErrorCode >= 0)) {
+                    // Gather the rest, sending when a frame is full
+                    thisSize = totalSize - gatherSize;
+                    if (thisSize > dataSize) {
+                        thisSize = dataSize;
+                    }
+                    memcpy(pGather + gatherSize, pData, thisSize);
+                    gatherSize += thisSize;
+                    pData += thisSize;
+                    dataSize -= thisSize;
+                    if (gatherSize == totalSize) {
+                        sizeOrErrorCode = serialWriteInnards(pDeviceSerial, pGather, gatherSize);
+                        if (sizeOrErrorCode >= 0) {
+                            sizeWritten += gatherSize;
+                            gatherSize = 0;
+                        }
+                    }
+                }
+            }
+            if ((gatherSize > 0) && (sizeOrErrorCode >= 0)) {
+                sizeOrErrorCode = serialWriteInnards(pDeviceSerial, pGather, gatherSize);
+                if (sizeOrErrorCode >= 0) {
+                    sizeWritten += gatherSize;
+                }
+            }
+            if (sizeOrErrorCode >= 0) {
+                sizeOrErrorCode = (int32_t) sizeWritten;
+            }
+            uPortFree(pGather);
+        }
+
+        U_PORT_MUTEX_UNLOCK(pChannelContext->mutexUserDataWrite);
+    }
+
+    return sizeOrErrorCode;
+}
+
 // Set an event callback on the virtual serial interface.
 static int32_t serialEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
                                       uint32_t filter,
@@ -1068,6 +1193,7 @@ static void initSerialInterface(struct uDeviceSerial_t *pDeviceSerial)
     pDeviceSerial->ctsResume = serialCtsResume;
     pDeviceSerial->discardOnOverflow = serialDiscardOnOverflow;
     pDeviceSerial->isDiscardOnOverflowEnabled = serialIsDiscardOnOverflowEnabled;
+    pDeviceSerial->writeV = serialWriteV;
 }
 
 /* ----------------------------------------------------------------
@@ -1216,13 +1342,9 @@ static void controlChannelInformation(uCellMuxPrivateContext_t *pContext,
     //
     // Of these, we only care about the FC (flow control) bit and we only care
     // about it when C/R is 1.  An FC of 1 means "do not send data".
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-    uPortLog("U_CELL_CMUX_0: MSC in:");
-    for (size_t x = 0; x < size; x++) {
-        uPortLog(" %02x", *(pBuffer + x));
+    if (U_LOG_IS_ENABLED(U_LOG_LEVEL_DEBUG)) {
+        logHex(0, "MSC in", (const char *) pBuffer, size);
     }
-    uPortLog(".\n");
-#endif
     if ((size >= 4) && ((*pBuffer == 0xe1) || (*pBuffer == 0xe3)) && (*(pBuffer + 1) >= 5)) {
         isCommand = ((*pBuffer & 0x02) == 0x02);
         mscChannel = *(pBuffer + 2) >> 2;
@@ -1241,13 +1363,9 @@ static void controlChannelInformation(uCellMuxPrivateContext_t *pContext,
             // with the same contents but with the C/R bit set to 0
             pDeviceSerial = pUCellMuxPrivateGetDeviceSerial(pContext, 0);
             *pBuffer &= ~0x02;
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-            uPortLog("U_CELL_CMUX_0: MSC out:");
-            for (size_t x = 0; x < size; x++) {
-                uPortLog(" %02x", *(pBuffer + x));
+            if (U_LOG_IS_ENABLED(U_LOG_LEVEL_DEBUG)) {
+                logHex(0, "MSC out", (const char *) pBuffer, size);
             }
-            uPortLog(".\n");
-#endif
             serialWriteInnards(pDeviceSerial, pBuffer, size);
         }
     }
@@ -1384,10 +1502,8 @@ static void cmuxDecode(uCellMuxPrivateContext_t *pContext, uint32_t eventBitMap)
                     pTraffic = &(pChannelContext->traffic);
                     if (!pChannelContext->markedForDeletion) {
                         // Check if the frame type was wanted
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                        uPortLog("U_CELL_CMUX_%d: rx frame type 0x%02x.\n", pChannelContext->channel,
-                                 parserContext.type);
-#endif
+                        U_LOG_DEBUG("U_CELL_CMUX_%d: rx frame type 0x%02x.\n", pChannelContext->channel,
+                                    parserContext.type);
                         if (pChannelContext->traffic.wantedResponseFrameType == parserContext.type) {
                             pChannelContext->traffic.wantedResponseFrameType = U_CELL_MUX_PRIVATE_FRAME_TYPE_NONE;
                         }
@@ -1422,13 +1538,11 @@ static void cmuxDecode(uCellMuxPrivateContext_t *pContext, uint32_t eventBitMap)
                                         if (parserContext.informationLengthBytes > bufferLength) {
                                             parserContext.informationLengthBytes = bufferLength;
                                         }
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                                        uPortLog("U_CELL_CMUX_%d: writing %d byte(s) of decoded I-field, buffer %d/%d.\n",
-                                                 pChannelContext->channel,
-                                                 parserContext.informationLengthBytes,
-                                                 serialGetReceiveSizeInnards(pDeviceSerial),
-                                                 pTraffic->rxBufferSizeBytes);
-#endif
+                                        U_LOG_DEBUG("U_CELL_CMUX_%d: writing %d byte(s) of decoded I-field, buffer %d/%d.\n",
+                                                    pChannelContext->channel,
+                                                    (int) parserContext.informationLengthBytes,
+                                                    serialGetReceiveSizeInnards(pDeviceSerial),
+                                                    (int) pTraffic->rxBufferSizeBytes);
                                         //  Move the user's information-field bytes into the main buffer
                                         pRxBufferRead = pTraffic->pRxBufferRead;
                                         if (pTraffic->pRxBufferWrite >= pRxBufferRead) {
@@ -1478,17 +1592,13 @@ static void cmuxDecode(uCellMuxPrivateContext_t *pContext, uint32_t eventBitMap)
                                         if (discardLength > 0) {
                                             uRingBufferReadHandle(&(pContext->ringBuffer), pContext->readHandle,
                                                                   NULL, discardLength);
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                                            uPortLog("U_CELL_CMUX_%d: discarded %d byte(s) of I-field.\n",
-                                                     pChannelContext->channel, discardLength);
-#endif
+                                            U_LOG_DEBUG("U_CELL_CMUX_%d: discarded %d byte(s) of I-field.\n",
+                                                        pChannelContext->channel, (int) discardLength);
                                         }
                                     } else {
                                         // Not enough room to decode more of the information field
                                         // on this channel, we are stalled
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                                        uPortLog("U_CELL_CMUX: stalled.\n");
-#endif
+                                        U_LOG_DEBUG("U_CELL_CMUX: stalled.\n");
                                         stalled = true;
                                     }
 
@@ -1598,15 +1708,13 @@ static void cmuxReceiveCallback(const uAtClientStreamHandle_t *pStream,
                     }
                 }
 
-#ifdef U_CELL_MUX_ENABLE_DEBUG
                 // -1 below since we lose one byte in the ring buffer implementation
-                uPortLog("U_CELL_CMUX: rx %d byte(s) (ctrl %d/%d, ring %d/%d).\n",
-                         receiveSizeOrError,
-                         pContext->holdingBufferIndex,
-                         sizeof(pContext->holdingBuffer),
-                         uRingBufferDataSizeHandle(&(pContext->ringBuffer), pContext->readHandle),
-                         sizeof(pContext->linearBuffer) - 1);
-#endif
+                U_LOG_DEBUG("U_CELL_CMUX: rx %d byte(s) (ctrl %d/%d, ring %d/%d).\n",
+                            receiveSizeOrError,
+                            (int) pContext->holdingBufferIndex,
+                            (int) sizeof(pContext->holdingBuffer),
+                            (int) uRingBufferDataSizeHandle(&(pContext->ringBuffer), pContext->readHandle),
+                            (int) sizeof(pContext->linearBuffer) - 1);
 
                 // Decode control and then data
                 cmuxDecodeControl(pContext);
@@ -1722,18 +1830,14 @@ int32_t uCellMuxPrivateEnable(uCellPrivateInstance_t *pInstance)
                         pContext->savedAtHandle = atHandle;
                         errorCode = openChannel(pContext, U_CELL_MUX_PRIVATE_CHANNEL_ID_CONTROL, 0);
                         if (errorCode == 0) {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                            uPortLog("U_CELL_CMUX_0: control channel open.\n");
-#endif
+                            U_LOG_DEBUG("U_CELL_CMUX_0: control channel open.\n");
                             // Channel 0 is up, now we need channel 1, on which
                             // we will need a data buffer for the information field carrying the
                             // user data (i.e. AT commands)
                             errorCode = openChannel(pContext, U_CELL_MUX_PRIVATE_CHANNEL_ID_AT,
                                                     U_CELL_MUX_PRIVATE_VIRTUAL_SERIAL_BUFFER_LENGTH_BYTES);
                             if (errorCode == 0) {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                                uPortLog("U_CELL_CMUX_1: AT channel open, flushing stored URCs...\n");
-#endif
+                                U_LOG_DEBUG("U_CELL_CMUX_1: AT channel open, flushing stored URCs...\n");
                                 pDeviceSerial = pUCellMuxPrivateGetDeviceSerial(pContext, U_CELL_MUX_PRIVATE_CHANNEL_ID_AT);
                                 // Some modules (e.g. SARA-R422) can have stored up loads of URCs
                                 // which they like to emit over the new mux channel; flush these
@@ -1747,15 +1851,11 @@ int32_t uCellMuxPrivateEnable(uCellPrivateInstance_t *pInstance)
                                 stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
                                 atHandle = uAtClientAddExt(&stream, NULL, U_CELL_AT_BUFFER_LENGTH_BYTES);
                                 if (atHandle != NULL) {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                                    uPortLog("U_CELL_CMUX: AT client added.\n");
-#endif
+                                    U_LOG_DEBUG("U_CELL_CMUX: AT client added.\n");
                                     errorCode = uCellMuxPrivateCopyAtClient(pContext->savedAtHandle,
                                                                             atHandle);
                                     if (errorCode == 0) {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                                        uPortLog("U_CELL_CMUX: existing AT client copied, CMUX is running.\n");
-#endif
+                                        U_LOG_DEBUG("U_CELL_CMUX: existing AT client copied, CMUX is running.\n");
                                         // Now that we have everything, we set the AT handle
                                         // of our instance to the new AT handle, leaving the
                                         // old AT handle locked
@@ -1844,9 +1944,7 @@ int32_t uCellMuxPrivateAddChannel(uCellPrivateInstance_t *pInstance,
                     errorCode = openChannel(pContext, (uint8_t) channel,
                                             U_CELL_MUX_PRIVATE_VIRTUAL_SERIAL_BUFFER_LENGTH_BYTES);
                     if (errorCode == 0) {
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                        uPortLog("U_CELL_CMUX_%d: channel added.\n", channel);
-#endif
+                        U_LOG_DEBUG("U_CELL_CMUX_%d: channel added.\n", channel);
                         *ppDeviceSerial = pUCellMuxPrivateGetDeviceSerial(pContext, (uint8_t) channel);
                     }
                 }
@@ -1905,9 +2003,7 @@ int32_t uCellMuxPrivateDisable(uCellPrivateInstance_t *pInstance)
                 uGnssUpdateAtHandle(pInstance->atHandle, atHandle);
                 pInstance->atHandle = atHandle;
                 pContext->savedAtHandle = NULL;
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-                uPortLog("U_CELL_CMUX: closed.\n");
-#endif
+                U_LOG_DEBUG("U_CELL_CMUX: closed.\n");
             }
             // Give the module a moment for the MUX switcheroo
             uPortTaskBlock(U_CELL_MUX_PRIVATE_ENABLE_DISABLE_DELAY_MS);
@@ -1949,9 +2045,7 @@ void uCellMuxPrivateCloseChannel(uCellMuxPrivateContext_t *pContext, uint8_t cha
 
     if (pDeviceSerial != NULL) {
         pDeviceSerial->close(pDeviceSerial);
-#ifdef U_CELL_MUX_ENABLE_DEBUG
-        uPortLog("U_CELL_CMUX_%d: channel closed.\n", channel);
-#endif
+        U_LOG_DEBUG("U_CELL_CMUX_%d: channel closed.\n", channel);
     }
 }
 
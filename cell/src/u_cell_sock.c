@@ -101,6 +101,19 @@
 #define U_CELL_SOCK_SARA_R422_DNS_DELAY_MILLISECONDS 500
 #endif
 
+#ifndef U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES
+/** When sockets are in hex mode the received hex string is read,
+ * and decoded into the caller's buffer, in chunks of this many
+ * characters, using a buffer of this size on the stack; must be
+ * an even number.
+ */
+# define U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES 64
+#endif
+
+#if (U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES < 2) || (U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES % 2 != 0)
+# error U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES must be an even number of at least 2
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -618,6 +631,59 @@ int32_t setHexMode(uDeviceHandle_t cellHandle, bool hexModeOnNotOff)
  * STATIC FUNCTIONS: MISC
  * -------------------------------------------------------------- */
 
+// Read the quoted data field at the end of a +USORD or +USORF
+// response, receivedSize bytes of it as reported by the module,
+// straight into pData: up to dataSizeBytes is written to pData,
+// anything beyond that is thrown away.  In binary mode the bytes
+// are read directly, in hex mode they are decoded a chunk at a
+// time; either way no intermediate buffer for the whole of the
+// data is needed.  The stop tag is ignored while this is done,
+// since binary data may contain anything, hence the caller must
+// follow this with uAtClientResponseStop() as normal.
+static void readData(uAtClientHandle_t atHandle, bool hexMode,
+                     char *pData, int32_t dataSizeBytes,
+                     int32_t receivedSize)
+{
+    char hex[U_CELL_SOCK_HEX_READ_CHUNK_LENGTH_BYTES];
+    int32_t thisSize;
+
+    if (dataSizeBytes > receivedSize) {
+        dataSizeBytes = receivedSize;
+    }
+    // Don't stop for anything!
+    uAtClientIgnoreStopTag(atHandle);
+    // Get the leading quote mark out of the way
+    uAtClientReadBytes(atHandle, NULL, 1, true);
+    if (hexMode) {
+        // Two characters of hex for every byte
+        while ((receivedSize > 0) && (uAtClientErrorGet(atHandle) == 0)) {
+            thisSize = receivedSize * 2;
+            if (thisSize > (int32_t) sizeof(hex)) {
+                thisSize = (int32_t) sizeof(hex);
+            }
+            thisSize = (int32_t) uAtClientReadBytes(atHandle, hex, thisSize, true) / 2;
+            if (thisSize > dataSizeBytes) {
+                thisSize = dataSizeBytes;
+            }
+            if (thisSize > 0) {
+                pData += uHexToBin(hex, thisSize * 2, pData);
+                dataSizeBytes -= thisSize;
+            }
+            receivedSize -= (int32_t) sizeof(hex) / 2;
+        }
+    } else {
+        // First the bit we want
+        uAtClientReadBytes(atHandle, pData, dataSizeBytes, true);
+        if (receivedSize > dataSizeBytes) {
+            //...and then the rest poured away to NULL
+            uAtClientReadBytes(atHandle, NULL,
+                               receivedSize - dataSizeBytes, true);
+        }
+    }
+    // Make sure to wait for the stop tag before we finish
+    uAtClientRestoreStopTag(atHandle);
+}
+
 // Do AT+USOCTL for an operation with an integer return value.
 static int32_t doUsoctl(uDeviceHandle_t cellHandle, int32_t sockHandle,
                         int32_t operation)
@@ -1364,8 +1430,6 @@ int32_t uCellSockReceiveFrom(uDeviceHandle_t cellHandle,
     int32_t x;
     int32_t port = -1;
     int32_t receivedSize = -1;
-    int32_t readLength;
-    char *pHexBuffer = NULL;
 
     buffer[0] = 0;  // In case of slip-ups
 
@@ -1457,48 +1521,9 @@ int32_t uCellSockReceiveFrom(uDeviceHandle_t cellHandle,
                         dataSizeBytes = receivedSize;
                     }
                     if (receivedSize > 0) {
-                        if (pInstance->socketsHexMode) {
-                            // In hex mode we need a buffer to dump
-                            // the hex into and then we can decode it
-                            negErrnoLocalOrSize = -U_SOCK_ENOMEM;
-                            //lint -e{647} Suppress suspicious truncation
-                            pHexBuffer = (char *) pUPortMalloc(receivedSize * 2 + 1);  // +1 for terminator
-                        }
-                        if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
-                            if (pHexBuffer != NULL) {
-                                // In hex mode we can read in the whole string
-                                //lint -e{647} Suppress suspicious truncation
-                                readLength = uAtClientReadString(atHandle, pHexBuffer,
-                                                                 receivedSize * 2 + 1, false);
-                                if (readLength > 0) {
-                                    x = (int32_t) dataSizeBytes * 2;
-                                    if (readLength > x) {
-                                        readLength = x;
-                                    }
-                                    uHexToBin(pHexBuffer, readLength, (char *) pData);
-                                }
-                                // Free memory
-                                uPortFree(pHexBuffer);
-                            } else {
-                                // Binary mode, don't stop for anything!
-                                uAtClientIgnoreStopTag(atHandle);
-                                // Get the leading quote mark out of the way
-                                uAtClientReadBytes(atHandle, NULL, 1, true);
-                                // Now read out all the actual data,
-                                // first the bit we want
-                                uAtClientReadBytes(atHandle, (char *) pData,
-                                                   dataSizeBytes, true);
-                                if (receivedSize > (int32_t) dataSizeBytes) {
-                                    //...and then the rest poured away to NULL
-                                    uAtClientReadBytes(atHandle, NULL,
-                                                       receivedSize -
-                                                       dataSizeBytes, true);
-                                }
-                                // Make sure to wait for the stop tag before
-                                // we finish
-                                uAtClientRestoreStopTag(atHandle);
-                            }
-                        }
+                        readData(atHandle, pInstance->socketsHexMode,
+                                 (char *) pData, (int32_t) dataSizeBytes,
+                                 receivedSize);
                     }
                     uAtClientResponseStop(atHandle);
                     // BEFORE unlocking, work out what's happened.
@@ -1694,8 +1719,6 @@ int32_t uCellSockRead(uDeviceHandle_t cellHandle,
     int32_t thisWantedReceiveSize;
     int32_t thisActualReceiveSize;
     int32_t totalReceivedSize = 0;
-    int32_t readLength;
-    char *pHexBuffer = NULL;
 
     // Find the instance
     pInstance = pUCellPrivateGetInstance(cellHandle);
@@ -1774,46 +1797,9 @@ int32_t uCellSockRead(uDeviceHandle_t cellHandle,
                             thisActualReceiveSize = (int32_t) dataSizeBytes;
                         }
                         if (thisActualReceiveSize > 0) {
-                            if (pInstance->socketsHexMode) {
-                                // In hex mode we need a buffer to dump
-                                // the hex into and then we can decode it
-                                negErrnoLocalOrSize = -U_SOCK_ENOMEM;
-                                //lint -e{647} Suppress suspicious truncation
-                                pHexBuffer = (char *) pUPortMalloc(thisActualReceiveSize * 2 + 1);  // +1 for terminator
-                            }
-                            if (!pInstance->socketsHexMode || (pHexBuffer != NULL)) {
-                                negErrnoLocalOrSize = U_SOCK_ENONE;
-                                if (pHexBuffer != NULL) {
-                                    // In hex mode we can read in the whole string
-                                    //lint -e{647} Suppress suspicious truncation
-                                    readLength = uAtClientReadString(atHandle, pHexBuffer,
-                                                                     thisActualReceiveSize * 2 + 1,
-                                                                     false);
-                                    if (readLength > 0) {
-                                        x = ((int32_t) dataSizeBytes) * 2;
-                                        if (readLength > x) {
-                                            readLength = x;
-                                        }
-                                        uHexToBin(pHexBuffer, readLength,
-                                                  (char *) pData + totalReceivedSize);
-                                    }
-                                    // Free memory
-                                    uPortFree(pHexBuffer);
-                                } else {
-                                    // Binary mode, don't stop for anything!
-                                    uAtClientIgnoreStopTag(atHandle);
-                                    // Get the leading quote mark out of the way
-                                    uAtClientReadBytes(atHandle, NULL, 1, true);
-                                    // Now read out the available data
-                                    uAtClientReadBytes(atHandle,
-                                                       (char *) pData +
-                                                       totalReceivedSize,
-                                                       thisActualReceiveSize, true);
-                                    // Make sure we wait for the stop tag before
-                                    // going around again
-                                    uAtClientRestoreStopTag(atHandle);
-                                }
-                            }
+                            readData(atHandle, pInstance->socketsHexMode,
+                                     (char *) pData + totalReceivedSize,
+                                     thisActualReceiveSize, thisActualReceiveSize);
                         }
                         uAtClientResponseStop(atHandle);
                         // BEFORE unlocking, work out what's happened.
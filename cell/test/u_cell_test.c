@@ -23,7 +23,8 @@
 /** @file
  * @brief Tests for the cellular "general" API: these should pass on all
  * platforms where one or preferably two UARTs are available.  No
- * cellular module is actually used in this set of tests.
+ * cellular module is actually used in this set of tests: where
+ * module behaviour is required a scripted stand-in is used instead.
  * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
  * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
  * macro.
@@ -36,6 +37,9 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
+#include "stdlib.h"    // strtol()
+#include "stdio.h"     // snprintf()
+#include "string.h"    // memcpy(), memcmp(), strncmp()
 
 #include "u_cfg_sw.h"
 #include "u_cfg_app_platform_specific.h"
@@ -50,10 +54,18 @@
 
 #include "u_test_util_resource_check.h"
 
+#include "u_interface.h"
+#include "u_device_serial.h"
+
 #include "u_at_client.h"
 
+#include "u_hex_bin_convert.h"
+
+#include "u_sock.h"
+
 #include "u_cell_module_type.h"
 #include "u_cell.h"
+#include "u_cell_sock.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -71,6 +83,21 @@
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Context for the scripted module stand-in, the other end of a
+ * virtual serial device, see moduleWrite().
+ */
+typedef struct {
+    char rx[256];  /**< what the "module" has sent to the AT client. */
+    size_t rxSize;
+    size_t rxIndex;
+    char command[32];
+    size_t commandLength;
+    bool hexMode;
+    const char *pPayload; /**< the socket data the "module" has. */
+    size_t payloadSize;
+    size_t numUsord; /**< the number of AT+USORD data reads. */
+} uCellTestModule_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -83,10 +110,145 @@ static int32_t gUartAHandle = -1;
  */
 static int32_t gUartBHandle = -1;
 
+/** Socket data for the scripted module stand-in: deliberately
+ * includes things that would confuse a text parser and is
+ * longer than a single hex read chunk.
+ */
+static const char gSockPayload[] = "\"OK\"\r\nERROR\r\n\0\xff\x80\x01+USORD: 0,3\r\n"
+                                   "0123456789abcdefghijklmnop";
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Read what the scripted module stand-in has "sent".
+static int32_t moduleRead(struct uDeviceSerial_t *pDeviceSerial,
+                          void *pBuffer, size_t sizeBytes)
+{
+    uCellTestModule_t *pModule = (uCellTestModule_t *) pUInterfaceContext(pDeviceSerial);
+
+    if (sizeBytes > pModule->rxSize - pModule->rxIndex) {
+        sizeBytes = pModule->rxSize - pModule->rxIndex;
+    }
+    memcpy(pBuffer, pModule->rx + pModule->rxIndex, sizeBytes);
+    pModule->rxIndex += sizeBytes;
+
+    return (int32_t) sizeBytes;
+}
+
+// Get the amount of data the scripted module stand-in has "sent".
+static int32_t moduleGetReceiveSize(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uCellTestModule_t *pModule = (uCellTestModule_t *) pUInterfaceContext(pDeviceSerial);
+
+    return (int32_t) (pModule->rxSize - pModule->rxIndex);
+}
+
+// Add a response from the scripted module stand-in.
+static void moduleRespond(uCellTestModule_t *pModule,
+                          const char *pData, size_t size)
+{
+    // Throw away what has already been read
+    memmove(pModule->rx, pModule->rx + pModule->rxIndex,
+            pModule->rxSize - pModule->rxIndex);
+    pModule->rxSize -= pModule->rxIndex;
+    pModule->rxIndex = 0;
+    if (size > sizeof(pModule->rx) - pModule->rxSize) {
+        size = sizeof(pModule->rx) - pModule->rxSize;
+    }
+    memcpy(pModule->rx + pModule->rxSize, pData, size);
+    pModule->rxSize += size;
+}
+
+// The scripted module stand-in: "AT+USOCR=" gets socket 0, "AT+UDCONF=1,"
+// sets hex mode, "AT+USORD=0,0" gets the amount of payload left,
+// "AT+USORD=0,n" gets up to n bytes of the payload, in binary or hex
+// as appropriate, and anything else just gets "OK".
+static int32_t moduleWrite(struct uDeviceSerial_t *pDeviceSerial,
+                           const void *pBuffer, size_t sizeBytes)
+{
+    uCellTestModule_t *pModule = (uCellTestModule_t *) pUInterfaceContext(pDeviceSerial);
+    const char *pData = (const char *) pBuffer;
+    char buffer[160];
+    size_t length;
+    int32_t x;
+
+    for (size_t y = 0; y < sizeBytes; y++) {
+        if (pData[y] == '\r') {
+            pModule->command[pModule->commandLength] = 0;
+            pModule->commandLength = 0;
+            if (strncmp(pModule->command, "AT+USOCR=", 9) == 0) {
+                length = snprintf(buffer, sizeof(buffer), "\r\n+USOCR: 0\r\n");
+                moduleRespond(pModule, buffer, length);
+            } else if (strncmp(pModule->command, "AT+UDCONF=1,", 12) == 0) {
+                pModule->hexMode = (pModule->command[12] == '1');
+            } else if (strncmp(pModule->command, "AT+USORD=0,", 11) == 0) {
+                x = strtol(pModule->command + 11, NULL, 10);
+                if (x == 0) {
+                    length = snprintf(buffer, sizeof(buffer), "\r\n+USORD: 0,%d\r\n",
+                                      (int) pModule->payloadSize);
+                    moduleRespond(pModule, buffer, length);
+                } else {
+                    if (x > (int32_t) pModule->payloadSize) {
+                        x = (int32_t) pModule->payloadSize;
+                    }
+                    length = snprintf(buffer, sizeof(buffer), "\r\n+USORD: 0,%d,\"", (int) x);
+                    if (pModule->hexMode) {
+                        length += uBinToHex(pModule->pPayload, x, buffer + length);
+                    } else {
+                        memcpy(buffer + length, pModule->pPayload, x);
+                        length += x;
+                    }
+                    buffer[length] = '"';
+                    length++;
+                    length += snprintf(buffer + length, sizeof(buffer) - length, "\r\n");
+                    moduleRespond(pModule, buffer, length);
+                    pModule->pPayload += x;
+                    pModule->payloadSize -= x;
+                    pModule->numUsord++;
+                }
+            }
+            moduleRespond(pModule, "\r\nOK\r\n", 6);
+        } else if ((pData[y] != '\n') &&
+                   (pModule->commandLength < sizeof(pModule->command) - 1)) {
+            pModule->command[pModule->commandLength] = pData[y];
+            pModule->commandLength++;
+        }
+    }
+
+    return (int32_t) sizeBytes;
+}
+
+// Set the event callback of the scripted module stand-in: since
+// the stand-in only ever responds to commands, which the AT
+// client reads directly, the callback is never called.
+static int32_t moduleEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
+                                      uint32_t filter,
+                                      void (*pFunction)(struct uDeviceSerial_t *,
+                                                        uint32_t,
+                                                        void *),
+                                      void *pParam,
+                                      size_t stackSizeBytes,
+                                      int32_t priority)
+{
+    (void) pDeviceSerial;
+    (void) filter;
+    (void) pFunction;
+    (void) pParam;
+    (void) stackSizeBytes;
+    (void) priority;
+    return 0;
+}
+
+// Populate the vector table of the scripted module stand-in.
+static void moduleInit(struct uDeviceSerial_t *pDeviceSerial)
+{
+    pDeviceSerial->read = moduleRead;
+    pDeviceSerial->getReceiveSize = moduleGetReceiveSize;
+    pDeviceSerial->write = moduleWrite;
+    pDeviceSerial->eventCallbackSet = moduleEventCallbackSet;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -343,6 +505,89 @@ U_PORT_TEST_FUNCTION("[cell]", "cellAdd")
 }
 #endif
 
+/** Read socket data, in binary and in hex mode, from a scripted
+ * module stand-in; no UART or module is required.
+ */
+U_PORT_TEST_FUNCTION("[cell]", "cellSockReadScripted")
+{
+    uAtClientStreamHandle_t stream;
+    uAtClientHandle_t atClientHandle;
+    uDeviceSerial_t *pDeviceSerial;
+    uCellTestModule_t *pModule;
+    uDeviceHandle_t devHandle;
+    int32_t sockHandle;
+    char buffer[sizeof(gSockPayload)];
+    size_t length;
+    int32_t x;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+    U_PORT_TEST_ASSERT(uCellInit() == 0);
+    U_PORT_TEST_ASSERT(uCellSockInit() == 0);
+
+    pDeviceSerial = pUDeviceSerialCreate(moduleInit, sizeof(uCellTestModule_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    pModule = (uCellTestModule_t *) pUInterfaceContext(pDeviceSerial);
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_CELL_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    U_PORT_TEST_ASSERT(uCellAdd(U_CELL_MODULE_TYPE_SARA_R5, atClientHandle,
+                                -1, -1, -1, false, &devHandle) == 0);
+    // No need to hang around between commands with a stand-in
+    U_PORT_TEST_ASSERT(uCellAtCommandDelaySet(devHandle, 0) == 0);
+    U_PORT_TEST_ASSERT(uCellSockInitInstance(devHandle) == 0);
+
+    for (size_t hexMode = 0; hexMode < 2; hexMode++) {
+        U_TEST_PRINT_LINE("reading %d byte(s) of socket data in %s mode...",
+                          sizeof(gSockPayload), hexMode ? "hex" : "binary");
+        if (hexMode) {
+            U_PORT_TEST_ASSERT(uCellSockHexModeOn(devHandle) == 0);
+            U_PORT_TEST_ASSERT(pModule->hexMode);
+        }
+        pModule->pPayload = gSockPayload;
+        pModule->payloadSize = sizeof(gSockPayload);
+        pModule->numUsord = 0;
+        sockHandle = uCellSockCreate(devHandle, U_SOCK_TYPE_STREAM, U_SOCK_PROTOCOL_TCP);
+        U_PORT_TEST_ASSERT(sockHandle >= 0);
+        memset(buffer, 0x55, sizeof(buffer));
+        length = 0;
+        // Read it in two pieces, the first odd-sized
+        x = uCellSockRead(devHandle, sockHandle, buffer, 11);
+        U_PORT_TEST_ASSERT(x == 11);
+        length += x;
+        x = uCellSockRead(devHandle, sockHandle, buffer + length, sizeof(buffer) - length);
+        U_TEST_PRINT_LINE("read %d byte(s) with %d AT+USORD data read(s).",
+                          length + x, pModule->numUsord);
+        U_PORT_TEST_ASSERT(x == (int32_t) (sizeof(buffer) - length));
+        U_PORT_TEST_ASSERT(memcmp(buffer, gSockPayload, sizeof(gSockPayload)) == 0);
+        U_PORT_TEST_ASSERT(pModule->payloadSize == 0);
+        U_PORT_TEST_ASSERT(uCellSockClose(devHandle, sockHandle, NULL) == 0);
+    }
+
+    // Let the closed callback complete
+    uPortTaskBlock(100);
+    uCellSockDeinit();
+    uCellRemove(devHandle);
+    uAtClientRemove(atClientHandle);
+    uDeviceSerialDelete(pDeviceSerial);
+    uCellDeinit();
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
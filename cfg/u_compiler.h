@@ -150,6 +150,71 @@
 #define U_ATOMIC_DECREMENT(pPtr) __atomic_fetch_sub(pPtr, 1, __ATOMIC_SEQ_CST)
 #endif
 
+/** U_ATOMIC_LOAD_ACQUIRE: return the value of a variable atomically
+ * with acquire ordering, i.e. no memory access that follows it in
+ * program order may be moved before it; use in conjunction with
+ * U_ATOMIC_STORE_RELEASE() to pass ownership of data between two
+ * threads without a mutex.
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition; there is no portable way to
+ * express an acquire ordering as an expression in MSVC C, hence
+ * this is a plain fetch and code relying on the ordering should
+ * not be compiled for MSVC.
+ */
+# define U_ATOMIC_LOAD_ACQUIRE(pPtr) *(pPtr)
+#else
+/** Default (GCC) definition.
+ */
+#define U_ATOMIC_LOAD_ACQUIRE(pPtr) __atomic_load_n(pPtr, __ATOMIC_ACQUIRE)
+#endif
+
+/** U_ATOMIC_STORE_RELEASE: set the value of a variable atomically
+ * with release ordering, i.e. no memory access that precedes it in
+ * program order may be moved after it; see U_ATOMIC_LOAD_ACQUIRE().
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition; a plain store, see the note
+ * against U_ATOMIC_LOAD_ACQUIRE().
+ */
+# define U_ATOMIC_STORE_RELEASE(pPtr, value) *(pPtr) = (value)
+#else
+/** Default (GCC) definition.
+ */
+#define U_ATOMIC_STORE_RELEASE(pPtr, value) __atomic_store_n(pPtr, value, __ATOMIC_RELEASE)
+#endif
+
+/** U_ATOMIC_MEMORY_BARRIER: a full memory barrier, i.e. no memory
+ * access may be moved across it in either direction, for use where
+ * a sequence of plain accesses must be ordered against an atomic one.
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition; requires inclusion of windows.h.
+ */
+# define U_ATOMIC_MEMORY_BARRIER() MemoryBarrier()
+#else
+/** Default (GCC) definition.
+ */
+#define U_ATOMIC_MEMORY_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+/** U_ATOMIC_COMPARE_AND_SWAP: if the 32-bit variable pointed to
+ * by pPtr is equal to expected, set it to desired, all atomically,
+ * returning true if that was done, else false.
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition; requires inclusion of windows.h.
+ */
+# define U_ATOMIC_COMPARE_AND_SWAP(pPtr, expected, desired)                      \
+    (InterlockedCompareExchange((volatile long *) (pPtr), (long) (desired),       \
+                                (long) (expected)) == (long) (expected))
+#else
+/** Default (GCC) definition.
+ */
+#define U_ATOMIC_COMPARE_AND_SWAP(pPtr, expected, desired) \
+    __sync_bool_compare_and_swap(pPtr, expected, desired)
+#endif
+
 /** @}*/
 
 #endif // _U_COMPILER_H_
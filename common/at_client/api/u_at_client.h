@@ -427,6 +427,15 @@ extern "C" {
 # define U_AT_CLIENT_ACTIVITY_PIN_HYSTERESIS_INTERVAL_MS 10
 #endif
 
+#ifndef U_AT_CLIENT_STATS_PRINT_INTERVAL_SECONDS
+/** Only relevant if U_CFG_AT_CLIENT_STATS is defined: if this is
+ * greater than zero then uAtClientUnlock() will print the statistics
+ * of an AT client, as uAtClientStatsPrint() does, at most this often;
+ * value in seconds.
+ */
+# define U_AT_CLIENT_STATS_PRINT_INTERVAL_SECONDS 0
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -477,6 +486,81 @@ typedef struct {
     int32_t code;
 } uAtClientDeviceError_t;
 
+/** A single AT command for uAtClientPipeline().
+ */
+typedef struct {
+    const char *pCommand;          /**< the complete AT command, e.g.
+                                        "AT+CSQ", without the
+                                        terminating carriage return;
+                                        cannot be NULL. */
+    const char *pResponsePrefix;   /**< the prefix of the information
+                                        response, e.g. "+CSQ:", NULL
+                                        if there is none. */
+    void (*pResponseCallback) (uAtClientHandle_t, size_t, void *); /**< the
+                                        callback to call, with the AT
+                                        handle, the index of this command
+                                        and pResponseCallbackParam, when
+                                        pResponsePrefix has been found;
+                                        it should read the parameters of
+                                        the information response with
+                                        uAtClientReadInt() etc., just as
+                                        would be done after a call to
+                                        uAtClientResponseStart() (which it
+                                        may call again, with the same
+                                        prefix, to read further lines).
+                                        It must NOT call uAtClientLock(),
+                                        uAtClientResponseStop() or
+                                        uAtClientUnlock(); may be NULL. */
+    void *pResponseCallbackParam;  /**< user parameter passed to
+                                        pResponseCallback. */
+    int32_t errorCode;             /**< populated by uAtClientPipeline():
+                                        zero if the AT server responded
+                                        with OK, else negative error
+                                        code. */
+    uAtClientDeviceError_t deviceError; /**< populated by uAtClientPipeline()
+                                             with any ERROR, +CME ERROR or
+                                             +CMS ERROR the AT server
+                                             responded with. */
+} uAtClientPipelineCommand_t;
+
+/** Statistics for an AT client, see uAtClientStatsGet(); these are
+ * only collected if U_CFG_AT_CLIENT_STATS is defined, otherwise
+ * the code that collects them is compiled out.  Times are in
+ * milliseconds.
+ */
+typedef struct {
+    uint32_t numCommands;          /**< the number of AT commands sent,
+                                        including pipelined ones. */
+    uint32_t numBytesTx;           /**< the number of bytes written to
+                                        the stream. */
+    uint32_t numBytesRx;           /**< the number of bytes read from
+                                        the stream, including URCs. */
+    uint32_t numLocks;             /**< the number of times the stream
+                                        was locked and unlocked. */
+    uint32_t lockedTotalMs;        /**< the total time the stream has
+                                        been locked for. */
+    uint32_t lockedMaxMs;          /**< the longest time the stream
+                                        was locked for. */
+    uint32_t numFirstBytes;        /**< the number of AT commands that
+                                        were followed by a response. */
+    uint32_t firstByteTotalMs;     /**< the total time from sending the
+                                        end of an AT command to receiving
+                                        the first byte of the response;
+                                        divide by numFirstBytes to get
+                                        the average. */
+    uint32_t firstByteMaxMs;       /**< the longest time from sending the
+                                        end of an AT command to receiving
+                                        the first byte of the response. */
+    uint32_t numUrcs;              /**< the number of URCs handled; see
+                                        uAtClientStatsUrcGet() for the
+                                        number per prefix. */
+    uint32_t numTimeouts;          /**< the number of AT timeouts. */
+    int32_t numConsecutiveTimeouts; /**< the current number of
+                                         consecutive AT timeouts. */
+    int32_t numConsecutiveTimeoutsMax; /**< the largest number of
+                                            consecutive AT timeouts. */
+} uAtClientStats_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: INITIALISATION AND CONFIGURATION
  * -------------------------------------------------------------- */
@@ -931,6 +1015,30 @@ size_t uAtClientWriteBytes(uAtClientHandle_t atHandle,
                            size_t lengthBytes,
                            bool standalone);
 
+/** Write a number of segments of bytes to the AT interface,
+ * a "scatter-gather" version of uAtClientWriteBytes(): this
+ * is useful where binary data to be sent is spread across
+ * several buffers (e.g. a header, a body and a trailer) since
+ * it avoids the need to copy them into a single buffer first
+ * and, where the underlying stream supports it (e.g. the
+ * Linux port, which maps it to writev(), or a CMUX virtual
+ * serial port, where fewer frames are sent), writes them
+ * to the stream in a single operation.  The segments are
+ * treated exactly as if they had been passed as one contiguous
+ * buffer to uAtClientWriteBytes().
+ *
+ * @param atHandle       the handle of the AT client.
+ * @param[in] pSegments  a pointer to an array of segments
+ *                       to be written.
+ * @param numSegments    the number of entries in pSegments.
+ * @param standalone     as for uAtClientWriteBytes().
+ * @return               the number of bytes written.
+ */
+size_t uAtClientWriteBytesV(uAtClientHandle_t atHandle,
+                            const uDeviceSerialSegment_t *pSegments,
+                            size_t numSegments,
+                            bool standalone);
+
 /** Write a part of a string argument to AT command sequence.
  * Used after uAtClientCommandStart() has been called to
  * start the AT command sequence.
@@ -1229,6 +1337,59 @@ void uAtClientSkipBytes(uAtClientHandle_t atHandle,
 int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
                                char character);
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: PIPELINED AT COMMANDS
+ * -------------------------------------------------------------- */
+
+/** Send a number of independent AT commands, keeping up to
+ * maxInFlight of them outstanding at the AT server at any one
+ * time, and match the responses back to the commands in order.
+ * Normally the AT interface sits idle while the MCU formats the
+ * next command and parses the last response; with this function
+ * the next commands are already on their way while the response
+ * to the first is being read, hiding the round-trip time of the
+ * stream.
+ *
+ * The AT client is locked for the duration, so this function should
+ * NOT be called between uAtClientLock() and uAtClientUnlock().  URCs
+ * that arrive while the responses are being read are handled as
+ * usual.  An ERROR, +CME ERROR or +CMS ERROR in the response to one
+ * command is recorded against that command and does not affect the
+ * others.  However, if no response at all arrives for a command
+ * within the AT timeout, the responses can no longer be matched to
+ * the commands; no further commands are sent, that command and all
+ * those following it are given the same error code and, before this
+ * function returns, the responses to any commands already sent are
+ * read and thrown away, so that they do not upset what follows; this
+ * takes up to one more AT timeout.
+ *
+ * IMPORTANT: an AT server is only obliged to accept a new command
+ * once it has sent the final result code of the previous one.
+ * Whether it queues commands which arrive before then, ignores them
+ * or aborts the current command depends on the module and on the
+ * command; only use a maxInFlight of more than one with commands
+ * that the module is known to queue correctly.  With a maxInFlight
+ * of one this function is safe with any AT server and still saves
+ * the overhead of locking and unlocking for each command.  Commands
+ * which require a prompt (e.g. the `@` of AT+USOWR in binary mode)
+ * or which are followed by data cannot be sent with this function.
+ *
+ * @param atHandle          the handle of the AT client.
+ * @param[in,out] pCommands an array of numCommands commands; the
+ *                          errorCode and deviceError fields of each
+ *                          will be populated by this function.
+ * @param numCommands       the number of commands at pCommands.
+ * @param maxInFlight       the maximum number of commands which may
+ *                          be outstanding at the AT server at any one
+ *                          time; zero is treated as one.
+ * @return                  the number of commands to which the AT
+ *                          server responded with OK, else negative
+ *                          error code.
+ */
+int32_t uAtClientPipeline(uAtClientHandle_t atHandle,
+                          uAtClientPipelineCommand_t *pCommands,
+                          size_t numCommands, size_t maxInFlight);
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: HANDLE UNSOLICITED RESPONSES
  * -------------------------------------------------------------- */
@@ -1844,6 +2005,61 @@ int32_t uAtClientGetAti(uAtClientHandle_t atHandle,
                         char *pBuffer,
                         size_t lengthBytes);
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: STATISTICS
+ * -------------------------------------------------------------- */
+
+/** Get the statistics of an AT client; only supported if
+ * U_CFG_AT_CLIENT_STATS is defined.  The statistics are counted
+ * from when the AT client was added or uAtClientStatsReset() was
+ * last called.
+ *
+ * @param atHandle     the handle of the AT client.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ * @return             zero on success else negative error code,
+ *                     #U_ERROR_COMMON_NOT_SUPPORTED if
+ *                     U_CFG_AT_CLIENT_STATS is not defined.
+ */
+int32_t uAtClientStatsGet(uAtClientHandle_t atHandle,
+                          uAtClientStats_t *pStats);
+
+/** Get the number of times the URC handler with the given index
+ * (in the order the URC handlers are stored, most recently added
+ * first) has been called; only supported if U_CFG_AT_CLIENT_STATS
+ * is defined.  Call this with an index starting at zero, and
+ * increasing, until it returns #U_ERROR_COMMON_NOT_FOUND to get
+ * all of them.
+ *
+ * @param atHandle       the handle of the AT client.
+ * @param index          the index of the URC handler.
+ * @param[out] ppPrefix  a place to put a pointer to the prefix of
+ *                       the URC handler, which remains valid until
+ *                       the URC handler is removed; may be NULL.
+ * @return               on success the number of times the URC
+ *                       handler has been called, else negative
+ *                       error code.
+ */
+int32_t uAtClientStatsUrcGet(uAtClientHandle_t atHandle, size_t index,
+                             const char **ppPrefix);
+
+/** Reset the statistics of an AT client, including those of each
+ * URC handler; only supported if U_CFG_AT_CLIENT_STATS is defined.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          zero on success else negative error code.
+ */
+int32_t uAtClientStatsReset(uAtClientHandle_t atHandle);
+
+/** Print the statistics of an AT client, including those of each
+ * URC handler; only supported if U_CFG_AT_CLIENT_STATS is defined.
+ * This is also done by uAtClientUnlock() periodically if
+ * #U_AT_CLIENT_STATS_PRINT_INTERVAL_SECONDS is greater than zero.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          zero on success else negative error code.
+ */
+int32_t uAtClientStatsPrint(uAtClientHandle_t atHandle);
+
 #ifdef __cplusplus
 }
 #endif
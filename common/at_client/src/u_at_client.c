@@ -69,6 +69,17 @@
 #include "u_short_range_edm_stream.h"
 
 #include "u_hex_bin_convert.h"
+#include "u_trace.h"
+
+#ifndef U_CFG_LOG_LEVEL_AT_CLIENT
+/** The minimum level of the leveled logging of this module; AT
+ * printing, as switched on by uAtClientPrintAtSet(), is at
+ * #U_LOG_LEVEL_INFO.
+ */
+# define U_CFG_LOG_LEVEL_AT_CLIENT U_CFG_LOG_LEVEL
+#endif
+#define U_LOG_MODULE_LEVEL U_CFG_LOG_LEVEL_AT_CLIENT
+#include "u_log.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -260,6 +271,16 @@
  */
 #define U_AT_CLIENT_PRINT_TIMESTAMP_BUFFER_SIZE_BYTES 27
 
+/** The size of the buffer that printAt() assembles a line of AT
+ * print in; with deferred logging this is limited so that the
+ * line, which is logged as a "%s" argument, is not truncated.
+ */
+#if defined(U_CFG_LOG_DEFERRED) && (U_LOG_DEFERRED_STRING_MAX_LENGTH_BYTES < 80)
+# define U_AT_CLIENT_PRINT_LINE_LENGTH_BYTES (U_LOG_DEFERRED_STRING_MAX_LENGTH_BYTES + 1)
+#else
+# define U_AT_CLIENT_PRINT_LINE_LENGTH_BYTES 80
+#endif
+
 // Do some cross-checking
 #if (U_AT_CLIENT_CALLBACK_TASK_PRIORITY >= U_AT_CLIENT_URC_TASK_PRIORITY)
 # error U_AT_CLIENT_CALLBACK_TASK_PRIORITY must be less than U_AT_CLIENT_URC_TASK_PRIORITY
@@ -296,6 +317,53 @@
 # define LOG_IF(cond, place)
 #endif
 
+#ifdef U_CFG_AT_CLIENT_STATS
+/** Macros for collecting the statistics of an AT client, see
+ * uAtClientStatsGet(); they compile out to nothing if
+ * U_CFG_AT_CLIENT_STATS is not defined.  This one adds to a
+ * statistic.
+ */
+# define STATS_ADD(pClient, field, value) (pClient)->stats.field += (uint32_t) (value)
+
+/** Macros for collecting statistics: note that the end of an
+ * AT command has been sent, after which the time to the first
+ * byte of the response is measured.
+ */
+# define STATS_COMMAND_SENT(pClient) {                                        \
+                                         (pClient)->statsCommandSentMs =      \
+                                             uPortGetTickTimeMs();            \
+                                         (pClient)->statsFirstBytePending =   \
+                                             true;                            \
+                                     }
+
+/** Macros for collecting statistics: note that bytes have been
+ * received.
+ */
+# define STATS_RX(pClient, length, inCallback) statsRx(pClient, length, inCallback)
+
+/** Macros for collecting statistics: note that the stream has
+ * been locked.
+ */
+# define STATS_LOCK(pClient) (pClient)->statsLockStartMs = uPortGetTickTimeMs()
+
+/** Macros for collecting statistics: note that the stream has
+ * been unlocked, printing the statistics if they are due.
+ */
+# define STATS_UNLOCK(pClient) statsUnlock(pClient)
+
+/** Macros for collecting statistics: note that there has been
+ * an AT timeout.
+ */
+# define STATS_TIMEOUT(pClient) statsTimeout(pClient)
+#else
+# define STATS_ADD(pClient, field, value)
+# define STATS_COMMAND_SENT(pClient)
+# define STATS_RX(pClient, length, inCallback)
+# define STATS_LOCK(pClient)
+# define STATS_UNLOCK(pClient)
+# define STATS_TIMEOUT(pClient)
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -329,9 +397,28 @@ typedef struct uAtClientUrc_t {
     size_t prefixLength;       /** The length of pPrefix. */
     void (*pHandler) (uAtClientHandle_t, void *); /** The handler to call if pPrefix is matched. */
     void *pHandlerParam;       /** The parameter to pass to pHandler. */
+#ifdef U_CFG_AT_CLIENT_STATS
+    uint32_t count;            /** The number of times pHandler has been called. */
+#endif
     struct uAtClientUrc_t *pNext;
 } uAtClientUrc_t;
 
+/** A node of the URC prefix trie: this is a radix trie, i.e. each
+ * node may carry several characters of prefix, built from pUrcList
+ * by urcTrieRebuild().  All of the nodes of a trie are in a single
+ * array, linked by index, node zero being the root (which has an
+ * empty label).
+ */
+typedef struct {
+    const char *pLabel;   /** The characters of this node, pointing into
+                              the pPrefix of a URC. */
+    uint16_t labelLength; /** The number of characters at pLabel. */
+    int16_t firstChild;   /** The index of the first child, -1 if none. */
+    int16_t nextSibling;  /** The index of the next sibling, -1 if none. */
+    uAtClientUrc_t *pUrc; /** The URC whose prefix ends at this node, NULL
+                              if there is none. */
+} uAtClientUrcTrieNode_t;
+
 /** The definition of a tag.
  */
 typedef struct {
@@ -437,6 +524,7 @@ typedef struct uAtClientInstance_t {
     int32_t numConsecutiveAtTimeouts; /** The number of consecutive AT timeouts. */
     /** Callback to call if numConsecutiveAtTimeouts > 0. */
     void (*pConsecutiveTimeoutsCallback) (uAtClientHandle_t, int32_t *);
+    bool isDraining; /** True while uAtClientPipeline() reads unwanted responses. */
     char delimiter; /** The delimiter used between parameters. */
     int32_t delayMs; /** The delay from ending one AT command to starting the next. */
     uErrorCode_t error; /** The current error status. */
@@ -445,6 +533,7 @@ typedef struct uAtClientInstance_t {
     uAtClientTag_t stopTag; /** The stop tag for the current scope. */
     uAtClientUrc_t *pUrcList; /** Linked-list anchor for URC handlers. */
     uAtClientUrc_t *pUrcRead;  /** Pointer used when reading the URC handlers. */
+    uAtClientUrcTrieNode_t *pUrcTrie; /** Index of pUrcList by prefix, NULL if there is none. */
     uTimeoutStart_t lastResponseStop; /** The time the last response ended in milliseconds. */
     int32_t lockTimeMs; /** The time when the stream was locked. */
     uTimeoutStart_t lastTxTime; /** The time when the last transmit activity was carried out. */
@@ -470,6 +559,13 @@ typedef struct uAtClientInstance_t {
                                    as its fourth parameter. */
     uAtClientWakeUp_t *pWakeUp; /** Pointer to a wake-up handler structure. */
     uAtClientActivityPin_t *pActivityPin; /** Pointer to an activity pin structure. */
+#ifdef U_CFG_AT_CLIENT_STATS
+    uAtClientStats_t stats; /** The statistics, see uAtClientStatsGet(). */
+    int32_t statsLockStartMs; /** The time when the stream was locked, for stats. */
+    int32_t statsCommandSentMs; /** The time when the end of a command was sent, for stats. */
+    bool statsFirstBytePending; /** True if waiting for the first byte of a response. */
+    uTimeoutStart_t statsPrintTime; /** The time the statistics were last printed. */
+#endif
     struct uAtClientInstance_t *pNext;
 } uAtClientInstance_t;
 
@@ -737,6 +833,97 @@ static void printLogDebug(const uAtClientDetailedDebug_t *pDebug,
 }
 #endif
 
+#ifdef U_CFG_AT_CLIENT_STATS
+// Update the statistics when bytes have been received.
+static void statsRx(uAtClientInstance_t *pClient, int32_t length,
+                    bool inCallback)
+{
+    int32_t timeMs;
+
+    pClient->stats.numBytesRx += (uint32_t) length;
+    // Bytes read by the URC callback can't be a response
+    if (!inCallback && pClient->statsFirstBytePending) {
+        pClient->statsFirstBytePending = false;
+        timeMs = uPortGetTickTimeMs() - pClient->statsCommandSentMs;
+        pClient->stats.numFirstBytes++;
+        pClient->stats.firstByteTotalMs += (uint32_t) timeMs;
+        if ((uint32_t) timeMs > pClient->stats.firstByteMaxMs) {
+            pClient->stats.firstByteMaxMs = (uint32_t) timeMs;
+        }
+    }
+}
+
+// Update the statistics when there has been an AT timeout;
+// numConsecutiveAtTimeouts should already have been incremented.
+static void statsTimeout(uAtClientInstance_t *pClient)
+{
+    pClient->stats.numTimeouts++;
+    if (pClient->numConsecutiveAtTimeouts > pClient->stats.numConsecutiveTimeoutsMax) {
+        pClient->stats.numConsecutiveTimeoutsMax = pClient->numConsecutiveAtTimeouts;
+    }
+}
+
+// Print the statistics; pClient->mutex should be locked before
+// this is called.
+static void statsPrint(const uAtClientInstance_t *pClient)
+{
+#if U_CFG_ENABLE_LOGGING
+    const uAtClientStats_t *pStats = &(pClient->stats);
+    const uAtClientUrc_t *pUrc = pClient->pUrcList;
+    uint32_t firstByteAverageMs = 0;
+
+    if (pStats->numFirstBytes > 0) {
+        firstByteAverageMs = pStats->firstByteTotalMs / pStats->numFirstBytes;
+    }
+    uPortLog("U_AT_CLIENT_%d-%d: %u command(s), %u byte(s) sent, %u byte(s)"
+             " received.\n", pClient->stream.type,
+             U_AT_CLIENT_HANDLE_FOR_PRINT(pClient), pStats->numCommands,
+             pStats->numBytesTx, pStats->numBytesRx);
+    uPortLog("U_AT_CLIENT_%d-%d: locked %u time(s), %u ms in total, %u ms"
+             " max; first response byte %u ms average, %u ms max.\n",
+             pClient->stream.type, U_AT_CLIENT_HANDLE_FOR_PRINT(pClient),
+             pStats->numLocks, pStats->lockedTotalMs, pStats->lockedMaxMs,
+             firstByteAverageMs, pStats->firstByteMaxMs);
+    uPortLog("U_AT_CLIENT_%d-%d: %u timeout(s), %d consecutive, %d max"
+             " consecutive; %u URC(s).\n", pClient->stream.type,
+             U_AT_CLIENT_HANDLE_FOR_PRINT(pClient), pStats->numTimeouts,
+             pClient->numConsecutiveAtTimeouts,
+             pStats->numConsecutiveTimeoutsMax, pStats->numUrcs);
+    for (; pUrc != NULL; pUrc = pUrc->pNext) {
+        if (pUrc->count > 0) {
+            uPortLog("U_AT_CLIENT_%d-%d: URC \"%s\" %u.\n",
+                     pClient->stream.type, U_AT_CLIENT_HANDLE_FOR_PRINT(pClient),
+                     pUrc->pPrefix, pUrc->count);
+        }
+    }
+#else
+    (void) pClient;
+#endif
+}
+
+// Update the statistics when the stream has been unlocked;
+// pClient->mutex should be locked before this is called.
+static void statsUnlock(uAtClientInstance_t *pClient)
+{
+    uint32_t timeMs = (uint32_t) (uPortGetTickTimeMs() - pClient->statsLockStartMs);
+
+    pClient->stats.numLocks++;
+    pClient->stats.lockedTotalMs += timeMs;
+    if (timeMs > pClient->stats.lockedMaxMs) {
+        pClient->stats.lockedMaxMs = timeMs;
+    }
+    // Any response has had its chance
+    pClient->statsFirstBytePending = false;
+#if U_AT_CLIENT_STATS_PRINT_INTERVAL_SECONDS > 0
+    if (uTimeoutExpiredSeconds(pClient->statsPrintTime,
+                               U_AT_CLIENT_STATS_PRINT_INTERVAL_SECONDS)) {
+        pClient->statsPrintTime = uTimeoutStart();
+        statsPrint(pClient);
+    }
+#endif
+}
+#endif
+
 // Find an AT client instance in the list by stream handle.
 // gMutex should be locked before this is called.
 static uAtClientInstance_t *pGetAtClientInstance(const uAtClientStreamHandle_t *pStream)
@@ -889,6 +1076,7 @@ static void removeClient(uAtClientInstance_t *pClient)
         pClient->pUrcList = pUrc->pNext;
         uPortFree(pUrc);
     }
+    uPortFree(pClient->pUrcTrie);
 
     // Remove any activity pin
     uPortFree(pClient->pActivityPin);
@@ -930,6 +1118,182 @@ static void removeClient(uAtClientInstance_t *pClient)
     uPortFree(pClient);
 }
 
+// Compare the prefixes of two URCs, for qsort().
+static int urcCompare(const void *pA, const void *pB)
+{
+    return strcmp((*(const uAtClientUrc_t **) pA)->pPrefix,
+                  (*(const uAtClientUrc_t **) pB)->pPrefix);
+}
+
+// Build one level of the URC prefix trie from numUrcs URCs at
+// ppUrc, sorted by prefix, all of which share the first depth
+// characters and are longer than that; returns the index of the
+// first node of the level (or -1 if there is nothing to do),
+// incrementing *pNumNodes for each node added.  If pNodes is NULL
+// the nodes are only counted.
+static int32_t urcTrieBuildLevel(uAtClientUrc_t **ppUrc, size_t numUrcs,
+                                 size_t depth,
+                                 uAtClientUrcTrieNode_t *pNodes,
+                                 size_t *pNumNodes)
+{
+    int32_t first = -1;
+    int32_t previous = -1;
+    int32_t index;
+    int32_t child;
+    const char *pFirst;
+    const char *pLast;
+    size_t length;
+    size_t x = 0;
+    size_t y;
+    size_t z;
+
+    while (x < numUrcs) {
+        // Find the group which shares the character at depth
+        y = x + 1;
+        while ((y < numUrcs) && (ppUrc[y]->pPrefix[depth] == ppUrc[x]->pPrefix[depth])) {
+            y++;
+        }
+        // Since the group is sorted, the characters common to the
+        // whole group are those common to its first and last members
+        pFirst = ppUrc[x]->pPrefix;
+        pLast = ppUrc[y - 1]->pPrefix;
+        length = depth + 1;
+        while ((pFirst[length] != 0) && (pFirst[length] == pLast[length])) {
+            length++;
+        }
+        index = (int32_t) *pNumNodes;
+        (*pNumNodes)++;
+        if (pNodes != NULL) {
+            pNodes[index].pLabel = pFirst + depth;
+            pNodes[index].labelLength = (uint16_t) (length - depth);
+            pNodes[index].firstChild = -1;
+            pNodes[index].nextSibling = -1;
+            pNodes[index].pUrc = NULL;
+            if (previous >= 0) {
+                pNodes[previous].nextSibling = (int16_t) index;
+            }
+        }
+        if (first < 0) {
+            first = index;
+        }
+        previous = index;
+        // Only the first member of the group can end at this node
+        z = x;
+        if (ppUrc[x]->prefixLength == length) {
+            if (pNodes != NULL) {
+                pNodes[index].pUrc = ppUrc[x];
+            }
+            z++;
+        }
+        child = urcTrieBuildLevel(ppUrc + z, y - z, length, pNodes, pNumNodes);
+        if (pNodes != NULL) {
+            pNodes[index].firstChild = (int16_t) child;
+        }
+        x = y;
+    }
+
+    return first;
+}
+
+// Rebuild the URC prefix trie from pUrcList: urcPermittedMutex
+// must be locked before this is called, and the trie must only
+// be looked at with it locked, see bufferMatchOneUrc().  If there
+// is no memory for it the trie is left out and bufferMatchOneUrc()
+// will fall back to walking pUrcList.
+static void urcTrieRebuild(uAtClientInstance_t *pClient)
+{
+    uAtClientUrc_t **ppUrc;
+    uAtClientUrcTrieNode_t *pNodes;
+    size_t numUrcs = 0;
+    size_t numNodes = 1;
+    size_t skip = 0;
+
+    uPortFree(pClient->pUrcTrie);
+    pClient->pUrcTrie = NULL;
+
+    for (uAtClientUrc_t *pUrc = pClient->pUrcList; pUrc != NULL; pUrc = pUrc->pNext) {
+        numUrcs++;
+    }
+    if (numUrcs > 0) {
+        ppUrc = (uAtClientUrc_t **) pUPortMalloc(numUrcs * sizeof(uAtClientUrc_t *));
+        if (ppUrc != NULL) {
+            numUrcs = 0;
+            for (uAtClientUrc_t *pUrc = pClient->pUrcList; pUrc != NULL; pUrc = pUrc->pNext) {
+                ppUrc[numUrcs] = pUrc;
+                numUrcs++;
+            }
+            qsort(ppUrc, numUrcs, sizeof(ppUrc[0]), urcCompare);
+            // An empty prefix, which can only be first, lives
+            // in the root node
+            if (ppUrc[0]->prefixLength == 0) {
+                skip = 1;
+            }
+            // Count the nodes, then populate them
+            urcTrieBuildLevel(ppUrc + skip, numUrcs - skip, 0, NULL, &numNodes);
+            if (numNodes <= INT16_MAX) {
+                pNodes = (uAtClientUrcTrieNode_t *) pUPortMalloc(numNodes * sizeof(uAtClientUrcTrieNode_t));
+                if (pNodes != NULL) {
+                    pNodes[0].pLabel = "";
+                    pNodes[0].labelLength = 0;
+                    pNodes[0].nextSibling = -1;
+                    pNodes[0].pUrc = NULL;
+                    if (skip > 0) {
+                        pNodes[0].pUrc = ppUrc[0];
+                    }
+                    numNodes = 1;
+                    pNodes[0].firstChild = (int16_t) urcTrieBuildLevel(ppUrc + skip, numUrcs - skip,
+                                                                       0, pNodes, &numNodes);
+                    pClient->pUrcTrie = pNodes;
+                }
+            }
+            uPortFree(ppUrc);
+        }
+    }
+}
+
+// Find the URC whose prefix is the longest match for the length
+// bytes at pData in the URC prefix trie, returning NULL if there is
+// none; *pNumFound is set to the number of URCs whose prefix
+// matched, which will be more than one if a prefix is itself the
+// prefix of another.
+static uAtClientUrc_t *pUrcTrieFind(const uAtClientUrcTrieNode_t *pTrie,
+                                    const char *pData, size_t length,
+                                    size_t *pNumFound)
+{
+    const uAtClientUrcTrieNode_t *pNode;
+    uAtClientUrc_t *pUrc = pTrie->pUrc;
+    size_t numFound = 0;
+    size_t depth = 0;
+    int32_t index = pTrie->firstChild;
+
+    if (pUrc != NULL) {
+        numFound++;
+    }
+    while ((index >= 0) && (depth < length)) {
+        pNode = pTrie + index;
+        if (*pNode->pLabel == pData[depth]) {
+            // Only one child can start with this character so, if
+            // the rest of the label doesn't match, we're done
+            index = -1;
+            if ((length - depth >= pNode->labelLength) &&
+                (memcmp(pNode->pLabel, pData + depth, pNode->labelLength) == 0)) {
+                depth += pNode->labelLength;
+                if (pNode->pUrc != NULL) {
+                    pUrc = pNode->pUrc;
+                    numFound++;
+                }
+                index = pNode->firstChild;
+            }
+        } else {
+            index = pNode->nextSibling;
+        }
+    }
+
+    *pNumFound = numFound;
+
+    return pUrc;
+}
+
 // Get the next URC handler from pUrcRead.
 static int32_t urcHandlerGetNext(uAtClientInstance_t *pClient,
                                  const char **ppPrefix,
@@ -1128,19 +1492,45 @@ static const char *pMemStr(const char *pBuffer,
     return pPos;
 }
 
-// Print out AT commands and responses.
+#if U_CFG_ENABLE_LOGGING
+// Add a string to the line being assembled by printAt(), printing
+// the line first if there isn't room.
+static void printAtAdd(char *pLine, size_t *pLength, const char *pString)
+{
+    size_t length = strlen(pString);
+
+    if (*pLength + length >= U_AT_CLIENT_PRINT_LINE_LENGTH_BYTES) {
+        U_LOG_INFO("%s", pLine);
+        *pLength = 0;
+        *pLine = 0;
+    }
+    if (length >= U_AT_CLIENT_PRINT_LINE_LENGTH_BYTES) {
+        length = U_AT_CLIENT_PRINT_LINE_LENGTH_BYTES - 1;
+    }
+    memcpy(pLine + *pLength, pString, length);
+    *pLength += length;
+    *(pLine + *pLength) = 0;
+}
+#endif
+
+// Print out AT commands and responses; rather than printing
+// each character, which is slow, the print is assembled a line
+// at a time.
 static void printAt(uAtClientInstance_t *pClient,
                     const char *pAt, size_t length, bool sending)
 {
+#if U_CFG_ENABLE_LOGGING
     char c;
     bool timestamp = true;
     char prefixBuffer[32];
-#if U_CFG_ENABLE_LOGGING
     char timestampBuffer[U_AT_CLIENT_PRINT_TIMESTAMP_BUFFER_SIZE_BYTES];
-#endif
+    char line[U_AT_CLIENT_PRINT_LINE_LENGTH_BYTES];
+    size_t lineLength = 0;
+    char hex[5];
 
-    if (pClient->printAtOn) {
+    if (U_LOG_IS_ENABLED(U_LOG_LEVEL_INFO) && pClient->printAtOn) {
         prefixBuffer[0] = 0;
+        line[0] = 0;
         if (gPrintTimestampOriginSeconds >= 0) {
             if (sending) {
                 timestamp = false;
@@ -1166,34 +1556,52 @@ static void printAt(uAtClientInstance_t *pClient,
                          (int) U_AT_CLIENT_HANDLE_FOR_PRINT(pClient));
             }
         }
+        hex[1] = 0;
         for (size_t x = 0; x < length; x++) {
             if (timestamp) {
-                uPortLog("%s%s", prefixBuffer,
-                         pPrintTimestamp(pClient->debugOn ? " " : NULL,
-                                         ": ", timestampBuffer, sizeof(timestampBuffer)));
+                printAtAdd(line, &lineLength, prefixBuffer);
+                printAtAdd(line, &lineLength,
+                           pPrintTimestamp(pClient->debugOn ? " " : NULL,
+                                           ": ", timestampBuffer, sizeof(timestampBuffer)));
                 timestamp = false;
             }
             c = *pAt++;
             if (!isprint((int32_t) c)) {
 #ifdef U_AT_CLIENT_PRINT_CONTROL_CHARACTERS
-                uPortLog("[%02x]", (unsigned char) c);
+                snprintf(hex, sizeof(hex), "[%02x]", (unsigned char) c);
+                printAtAdd(line, &lineLength, hex);
 #else
                 if (c == '\r') {
-                    // Convert \r\n into \n
-                    uPortLog("%c", '\n');
+                    // Convert \r\n into \n and print the line
+                    printAtAdd(line, &lineLength, "\n");
+                    U_LOG_INFO("%s", line);
+                    lineLength = 0;
+                    line[0] = 0;
                 } else if (c == '\n') {
                     timestamp = true;
                 } else {
                     // Print the hex
-                    uPortLog("[%02x]", (unsigned char) c);
+                    snprintf(hex, sizeof(hex), "[%02x]", (unsigned char) c);
+                    printAtAdd(line, &lineLength, hex);
                 }
 #endif
             } else {
                 // Print the ASCII character
-                uPortLog("%c", c);
+                hex[0] = c;
+                hex[1] = 0;
+                printAtAdd(line, &lineLength, hex);
             }
         }
+        if (lineLength > 0) {
+            U_LOG_INFO("%s", line);
+        }
     }
+#else
+    (void) pClient;
+    (void) pAt;
+    (void) length;
+    (void) sending;
+#endif
 }
 
 // Set error.
@@ -1226,27 +1634,32 @@ static void clearError(uAtClientInstance_t *pClient)
 }
 
 // Increment the number of consecutive timeouts
-// and call the callback if there is one
+// and call the callback if there is one; does nothing
+// while draining, where a timeout is expected
 static void consecutiveTimeout(uAtClientInstance_t *pClient)
 {
     uAtClientCallback_t cb = {0}; // Keep Valgrind happy (otherwise the last four bytes will be uninitialised)
 
-    U_PORT_MUTEX_LOCK(gMutexEventQueue);
+    if (!pClient->isDraining) {
 
-    pClient->numConsecutiveAtTimeouts++;
-    if (pClient->pConsecutiveTimeoutsCallback != NULL) {
-        // pConsecutiveTimeoutsCallback second parameter
-        // is an int32_t pointer but of course the generic
-        // callback function is a void pointer so
-        // need to cast here
-        cb.pFunction = (void (*) (uAtClientHandle_t, void *)) pClient->pConsecutiveTimeoutsCallback;
-        cb.atHandle = (uAtClientHandle_t) pClient;
-        cb.pParam = &(pClient->numConsecutiveAtTimeouts);
-        cb.atClientMagicNumber = pClient->magicNumber;
-        uPortEventQueueSend(gEventQueueHandle, &cb, sizeof(cb));
-    }
+        U_PORT_MUTEX_LOCK(gMutexEventQueue);
 
-    U_PORT_MUTEX_UNLOCK(gMutexEventQueue);
+        pClient->numConsecutiveAtTimeouts++;
+        STATS_TIMEOUT(pClient);
+        if (pClient->pConsecutiveTimeoutsCallback != NULL) {
+            // pConsecutiveTimeoutsCallback second parameter
+            // is an int32_t pointer but of course the generic
+            // callback function is a void pointer so
+            // need to cast here
+            cb.pFunction = (void (*) (uAtClientHandle_t, void *)) pClient->pConsecutiveTimeoutsCallback;
+            cb.atHandle = (uAtClientHandle_t) pClient;
+            cb.pParam = &(pClient->numConsecutiveAtTimeouts);
+            cb.atClientMagicNumber = pClient->magicNumber;
+            uPortEventQueueSend(gEventQueueHandle, &cb, sizeof(cb));
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutexEventQueue);
+    }
 }
 
 // Calculate the remaining time for polling based on the start
@@ -1541,6 +1954,8 @@ static bool bufferFill(uAtClientInstance_t *pClient,
         LOG_BUFFER_FILL(4);
 
         if (readLength > 0) {
+            U_TRACE_INSTANT(U_TRACE_EVENT_AT_CLIENT_BUFFER_FILL, readLength);
+            STATS_RX(pClient, readLength, eventIsCallback);
             // lengthBuffered is advanced by the amount we have
             // read in; may not be the same as the amount of data
             // available in the buffer for the AT client as
@@ -1896,51 +2311,107 @@ static void informationResponseStop(uAtClientInstance_t *pClient)
     }
 }
 
-// Iterate through URCs and check if one of them matches the current
-// contents of the receive buffer. If a URC is matched, set the
-// scope to information response and, after the URC's handler has
-// returned, finish off the information response scope by consuming
-// up to CR/LF.
-static bool bufferMatchOneUrc(uAtClientInstance_t *pClient)
+// Check if the given URC matches the current contents of the
+// receive buffer. If it does, set the scope to information response
+// and, after the URC's handler has returned, finish off the
+// information response scope by consuming up to CR/LF.
+static bool bufferMatchUrc(uAtClientInstance_t *pClient,
+                           const uAtClientUrc_t *pUrc)
 {
-    size_t prefixLength = 0;
+    size_t prefixLength = pUrc->prefixLength;
     bool found = false;
     int32_t now;
     uErrorCode_t savedError;
 
+    if (pClient->pReceiveBuffer->length >= prefixLength) {
+        // Do the check ignoring nulls at the start in case
+        // a URC is emitted near power-on which can suffer from
+        // such nulls
+        if (bufferMatch(pClient, pUrc->pPrefix, prefixLength, true)) {
+            setScope(pClient, U_AT_CLIENT_SCOPE_INFORMATION);
+            now = uPortGetTickTimeMs();
+            // Before heading off into URCness, save
+            // the current error state and reset
+            // it so that the URC doesn't suffer the error
+            savedError = pClient->error;
+            pClient->error = U_ERROR_COMMON_SUCCESS;
+            if (processAsync(pClient->magicNumber) && pUrc->pHandler) {
+                pUrc->pHandler(pClient, pUrc->pHandlerParam);
+            }
+            informationResponseStop(pClient);
+            // Put the error state back again
+            pClient->error = savedError;
+            // Add the amount of time spent in the URC
+            // world to the start time
+            pClient->lockTimeMs += uPortGetTickTimeMs() - now;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+// Find a URC that matches the current contents of the receive buffer
+// and, if there is one, handle it as bufferMatchUrc() does.  The URC
+// prefix trie, if present, is used to find the one URC that could
+// match; pUrcList is only walked, in order, if there is no trie or
+// if more than one prefix matches, since then the one that was
+// registered last must win.  The trie is replaced whenever a URC
+// handler is added or removed, under urcPermittedMutex, so it is
+// only used if urcPermittedMutexLocked is true or urcPermittedMutex
+// can be locked without waiting: waiting could deadlock with a URC
+// handler that is itself waiting on pClient->mutex.  Walking
+// pUrcList is always safe.
+static bool bufferMatchOneUrc(uAtClientInstance_t *pClient,
+                              bool urcPermittedMutexLocked)
+{
+    uAtClientReceiveBuffer_t *pReceiveBuffer = pClient->pReceiveBuffer;
+    uAtClientUrc_t *pUrc = pClient->pUrcList;
+    const char *pData;
+    size_t length;
+    size_t numFound = 2;
+    bool found = false;
+
     bufferRewind(pClient);
 
-    for (uAtClientUrc_t *pUrc = pClient->pUrcList;
-         !found && (pUrc != NULL);
-         pUrc = pUrc->pNext) {
-        prefixLength = pUrc->prefixLength;
-        if (pClient->pReceiveBuffer->length >= prefixLength) {
-            // Do the check ignoring nulls at the start in case
-            // a URC is emitted near power-on which can suffer from
-            // such nulls
-            if (bufferMatch(pClient, pUrc->pPrefix, prefixLength, true)) {
-                setScope(pClient, U_AT_CLIENT_SCOPE_INFORMATION);
-                now = uPortGetTickTimeMs();
-                // Before heading off into URCness, save
-                // the current error state and reset
-                // it so that the URC doesn't suffer the error
-                savedError = pClient->error;
-                pClient->error = U_ERROR_COMMON_SUCCESS;
-                if (processAsync(pClient->magicNumber) && pUrc->pHandler) {
-                    pUrc->pHandler(pClient, pUrc->pHandlerParam);
-                }
-                informationResponseStop(pClient);
-                // Put the error state back again
-                pClient->error = savedError;
-                // Put the error state back again
-                // Add the amount of time spent in the URC
-                // world to the start time
-                pClient->lockTimeMs += uPortGetTickTimeMs() - now;
-                found = true;
+    if (urcPermittedMutexLocked ||
+        (uPortMutexTryLock(pClient->urcPermittedMutex, 0) == 0)) {
+        if (pClient->pUrcTrie != NULL) {
+            pData = U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) + pReceiveBuffer->readIndex;
+            length = pReceiveBuffer->length - pReceiveBuffer->readIndex;
+            // Skip nulls at the start, see bufferMatchUrc()
+            while ((length > 0) && (*pData == 0)) {
+                pData++;
+                length--;
+            }
+            pUrc = pUrcTrieFind(pClient->pUrcTrie, pData, length, &numFound);
+            if (numFound > 1) {
+                pUrc = pClient->pUrcList;
+            }
+        }
+        if (!urcPermittedMutexLocked) {
+            uPortMutexUnlock(pClient->urcPermittedMutex);
+        }
+    }
+
+    if (numFound == 1) {
+        found = bufferMatchUrc(pClient, pUrc);
+    } else if (numFound > 1) {
+        while (!found && (pUrc != NULL)) {
+            found = bufferMatchUrc(pClient, pUrc);
+            if (!found) {
+                pUrc = pUrc->pNext;
             }
         }
     }
 
+#ifdef U_CFG_AT_CLIENT_STATS
+    if (found) {
+        pUrc->count++;
+        pClient->stats.numUrcs++;
+    }
+#endif
+
     return found;
 }
 
@@ -2167,7 +2638,7 @@ static bool processResponse(uAtClientInstance_t *pClient,
                     processingDone = true;
                 } else {
                     // No prefix match, check for a URC
-                    if (checkUrc && bufferMatchOneUrc(pClient)) {
+                    if (checkUrc && bufferMatchOneUrc(pClient, false)) {
                         // Just loop again
                     } else {
                         // If no matches were found, see if there's
@@ -2212,7 +2683,8 @@ static bool processResponse(uAtClientInstance_t *pClient,
     return prefixMatched;
 }
 
-// Write data to the stream.
+// Call the wake-up handler, if there is one and the
+// inactivity timeout has expired; used by write() and writeV().
 //
 // Design note concerning the wake-up handler
 // process below; first the needs:
@@ -2236,6 +2708,80 @@ static bool processResponse(uAtClientInstance_t *pClient,
 // not match then it _also_ blocks on inWakeUpHandlerMutex
 // before proceeding, hence holding off processing until
 // the wake-up process has completed.
+static void wakeUpIfRequired(uAtClientInstance_t *pClient)
+{
+    int32_t savedLockTimeMs;
+    int32_t wakeUpDurationMs = 0;
+    uAtClientScope_t savedScope;
+    uAtClientTag_t savedStopTag;
+    bool savedDelimiterRequired;
+    uAtClientDeviceError_t savedDeviceError;
+
+    if ((pClient->pWakeUp != NULL) &&
+        uTimeoutExpiredMs(pClient->lastTxTime,
+                          pClient->pWakeUp->inactivityTimeoutMs) &&
+        (uPortMutexTryLock(pClient->pWakeUp->inWakeUpHandlerMutex, 0) == 0)) {
+        // We have a wake-up handler, the inactivity timeout
+        // has expired and we've managed to lock the wake-up
+        // handler mutex (if we aren't able to lock the wake-up
+        // handler mutex  then we must already be in the wake-up
+        // handler, having recursed, so can just continue); now
+        // we need to call the wake-up handler function.
+        // Set wakeUpTask to the current task handle so
+        // that any future calls can be locked against the
+        // separate pWakeUp->mutex if they come from the task
+        // we're in at the moment, the one dealing with the wake-up
+        uPortTaskGetHandle(&(pClient->pWakeUp->wakeUpTask));
+        // The pClient->mutex will have been locked on the way
+        // into here by U_AT_CLIENT_LOCK_CLIENT_MUTEX.
+        // Remember the lock time and measure how long
+        // waking-up takes in order to correct for it
+        savedLockTimeMs = pClient->lockTimeMs;
+        wakeUpDurationMs = uPortGetTickTimeMs();
+        // Remember the dynamic things that the
+        // wake-up handler might overwrite
+        savedScope = pClient->scope;
+        savedStopTag = pClient->stopTag;
+        savedDelimiterRequired = pClient->delimiterRequired;
+        savedDeviceError = pClient->deviceError;
+        // Reset the scope, stopTag and delimiterRequired
+        pClient->scope = U_AT_CLIENT_SCOPE_NONE;
+        pClient->stopTag.pTagDef = &gNoStopTag;
+        pClient->stopTag.found = false;
+        pClient->delimiterRequired = false;
+        // Now actually call the wake-up callback which may recurse
+        // back into here
+        if (pClient->pWakeUp->pHandler((uAtClientHandle_t) pClient,
+                                       pClient->pWakeUp->pParam) != 0) {
+            setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
+        }
+        // At this point all of the calls back into here
+        // performed as part of the wake-up process will have
+        // been completed; there may have been calls from other
+        // tasks but they will have been blocked on the normal
+        // mutex before reaching here.
+        // We can now set the wakeUpTask back to NULL and all
+        // blocking will be on the normal mutex again
+        pClient->pWakeUp->wakeUpTask = NULL;
+        // Put all the saved things back
+        pClient->scope = savedScope;
+        pClient->stopTag = savedStopTag;
+        pClient->delimiterRequired = savedDelimiterRequired;
+        pClient->deviceError = savedDeviceError;
+        // Set the adjusted lock time, allowing for potential
+        // wrap in uPortGetTickTimeMs()
+        wakeUpDurationMs = uPortGetTickTimeMs() - wakeUpDurationMs;
+        if (wakeUpDurationMs > 0) {
+            pClient->lockTimeMs = savedLockTimeMs + wakeUpDurationMs;
+        } else {
+            pClient->lockTimeMs = uPortGetTickTimeMs();
+        }
+        // We are no longer in the wake-up handler
+        uPortMutexUnlock(pClient->pWakeUp->inWakeUpHandlerMutex);
+    }
+}
+
+// Write data to the stream.
 static size_t write(uAtClientInstance_t *pClient,
                     const char *pData, size_t length,
                     bool andFlush)
@@ -2252,79 +2798,12 @@ static size_t write(uAtClientInstance_t *pClient,
     // the ORing with andFlush below is confusing it?
     // codechecker_suppress [cppcheck-pointerOutOfBoundsCond] "pDataStart + length is not out of bounds"
     const char *pDataEnd = pDataStart + length;
-    int32_t savedLockTimeMs;
-    int32_t wakeUpDurationMs = 0;
-    uAtClientScope_t savedScope;
-    uAtClientTag_t savedStopTag;
-    bool savedDelimiterRequired;
-    uAtClientDeviceError_t savedDeviceError;
     uDeviceSerial_t *pDeviceSerial;
 
     while (((pData < pDataEnd) || andFlush) &&
            (pClient->error == U_ERROR_COMMON_SUCCESS)) {
         lengthToWrite = length - (pData - pDataStart);
-        if ((pClient->pWakeUp != NULL) &&
-            uTimeoutExpiredMs(pClient->lastTxTime,
-                              pClient->pWakeUp->inactivityTimeoutMs) &&
-            (uPortMutexTryLock(pClient->pWakeUp->inWakeUpHandlerMutex, 0) == 0)) {
-            // We have a wake-up handler, the inactivity timeout
-            // has expired and we've managed to lock the wake-up
-            // handler mutex (if we aren't able to lock the wake-up
-            // handler mutex  then we must already be in the wake-up
-            // handler, having recursed, so can just continue); now
-            // we need to call the wake-up handler function.
-            // Set wakeUpTask to the current task handle so
-            // that any future calls can be locked against the
-            // separate pWakeUp->mutex if they come from the task
-            // we're in at the moment, the one dealing with the wake-up
-            uPortTaskGetHandle(&(pClient->pWakeUp->wakeUpTask));
-            // The pClient->mutex will have been locked on the way
-            // into here by U_AT_CLIENT_LOCK_CLIENT_MUTEX.
-            // Remember the lock time and measure how long
-            // waking-up takes in order to correct for it
-            savedLockTimeMs = pClient->lockTimeMs;
-            wakeUpDurationMs = uPortGetTickTimeMs();
-            // Remember the dynamic things that the
-            // wake-up handler might overwrite
-            savedScope = pClient->scope;
-            savedStopTag = pClient->stopTag;
-            savedDelimiterRequired = pClient->delimiterRequired;
-            savedDeviceError = pClient->deviceError;
-            // Reset the scope, stopTag and delimiterRequired
-            pClient->scope = U_AT_CLIENT_SCOPE_NONE;
-            pClient->stopTag.pTagDef = &gNoStopTag;
-            pClient->stopTag.found = false;
-            pClient->delimiterRequired = false;
-            // Now actually call the wake-up callback which may recurse
-            // back into here
-            if (pClient->pWakeUp->pHandler((uAtClientHandle_t) pClient,
-                                           pClient->pWakeUp->pParam) != 0) {
-                setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
-            }
-            // At this point all of the calls back into here
-            // performed as part of the wake-up process will have
-            // been completed; there may have been calls from other
-            // tasks but they will have been blocked on the normal
-            // mutex before reaching here.
-            // We can now set the wakeUpTask back to NULL and all
-            // blocking will be on the normal mutex again
-            pClient->pWakeUp->wakeUpTask = NULL;
-            // Put all the saved things back
-            pClient->scope = savedScope;
-            pClient->stopTag = savedStopTag;
-            pClient->delimiterRequired = savedDelimiterRequired;
-            pClient->deviceError = savedDeviceError;
-            // Set the adjusted lock time, allowing for potential
-            // wrap in uPortGetTickTimeMs()
-            wakeUpDurationMs = uPortGetTickTimeMs() - wakeUpDurationMs;
-            if (wakeUpDurationMs > 0) {
-                pClient->lockTimeMs = savedLockTimeMs + wakeUpDurationMs;
-            } else {
-                pClient->lockTimeMs = uPortGetTickTimeMs();
-            }
-            // We are no longer in the wake-up handler
-            uPortMutexUnlock(pClient->pWakeUp->inWakeUpHandlerMutex);
-        }
+        wakeUpIfRequired(pClient);
 
         if (pClient->error == U_ERROR_COMMON_SUCCESS) {
             if (pClient->pInterceptTx != NULL) {
@@ -2374,6 +2853,7 @@ static size_t write(uAtClientInstance_t *pClient,
                     pDataToWrite += thisLengthWritten;
                     lengthToWrite -= thisLengthWritten;
                     pClient->lastTxTime = uTimeoutStart();
+                    STATS_ADD(pClient, numBytesTx, thisLengthWritten);
                 } else {
                     setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
                 }
@@ -2395,6 +2875,135 @@ static size_t write(uAtClientInstance_t *pClient,
     return length;
 }
 
+// Write a number of segments of data to the stream; where the
+// stream supports it they are passed down in a single call,
+// otherwise they are written one at a time with write().
+static size_t writeV(uAtClientInstance_t *pClient,
+                     const uDeviceSerialSegment_t *pSegments,
+                     size_t numSegments, bool andFlush)
+{
+    int32_t thisLengthWritten = 0;
+    size_t length = 0;
+    size_t lengthToWrite;
+    size_t offset;
+    size_t x = 0;
+    uDeviceSerialSegment_t partial = {NULL, 0};
+    const uDeviceSerialSegment_t *pSegmentsToWrite;
+    size_t numSegmentsToWrite;
+    uDeviceSerial_t *pDeviceSerial;
+
+    if ((pClient->pInterceptTx != NULL) ||
+        ((pClient->stream.type != U_AT_CLIENT_STREAM_TYPE_UART) &&
+         (pClient->stream.type != U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL))) {
+        // An intercept function works on contiguous data so
+        // there is nothing to be gained here: write the segments
+        // one at a time, flushing on the last if required
+        for (x = 0; x < numSegments; x++) {
+            length += write(pClient, (const char *) pSegments[x].pData,
+                            pSegments[x].sizeBytes,
+                            andFlush && (x + 1 == numSegments));
+        }
+    } else {
+        for (x = 0; x < numSegments; x++) {
+            length += pSegments[x].sizeBytes;
+        }
+        lengthToWrite = length;
+        x = 0;
+        if ((lengthToWrite > 0) && (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+            // Wake-up is only needed once for the lot
+            wakeUpIfRequired(pClient);
+        }
+        while ((lengthToWrite > 0) &&
+               (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+            // If a previous call has left part of a segment
+            // unwritten, send the rest of that on its own
+            pSegmentsToWrite = pSegments + x;
+            numSegmentsToWrite = numSegments - x;
+            if (partial.sizeBytes > 0) {
+                pSegmentsToWrite = &partial;
+                numSegmentsToWrite = 1;
+            }
+            switch (pClient->stream.type) {
+                case U_AT_CLIENT_STREAM_TYPE_UART:
+                    thisLengthWritten = uPortUartWriteV(pClient->stream.handle.int32,
+                                                        pSegmentsToWrite,
+                                                        numSegmentsToWrite);
+                    break;
+                case U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL:
+                    pDeviceSerial = pClient->stream.handle.pDeviceSerial;
+                    thisLengthWritten = pDeviceSerial->writeV(pDeviceSerial,
+                                                              pSegmentsToWrite,
+                                                              numSegmentsToWrite);
+                    break;
+                default:
+                    break;
+            }
+            if (thisLengthWritten > 0) {
+                lengthToWrite -= thisLengthWritten;
+                pClient->lastTxTime = uTimeoutStart();
+                STATS_ADD(pClient, numBytesTx, thisLengthWritten);
+                offset = (size_t) thisLengthWritten;
+                if (partial.sizeBytes > 0) {
+                    partial.pData = ((const char *) partial.pData) + offset;
+                    partial.sizeBytes -= offset;
+                } else {
+                    // Step over the segments that were written in full
+                    while ((x < numSegments) && (offset >= pSegments[x].sizeBytes)) {
+                        offset -= pSegments[x].sizeBytes;
+                        x++;
+                    }
+                    if (offset > 0) {
+                        partial.pData = ((const char *) pSegments[x].pData) + offset;
+                        partial.sizeBytes = pSegments[x].sizeBytes - offset;
+                        x++;
+                    }
+                }
+            } else {
+                setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
+            }
+        }
+
+        if (pClient->error == U_ERROR_COMMON_SUCCESS) {
+            for (x = 0; x < numSegments; x++) {
+                printAt(pClient, (const char *) pSegments[x].pData,
+                        pSegments[x].sizeBytes, true);
+            }
+        } else {
+            length = 0;
+        }
+    }
+
+    return length;
+}
+
+// Send a complete AT command, including the command delimiter,
+// for uAtClientPipeline(); if waitDelay is true the delay period
+// since the last response is obeyed first, as in
+// uAtClientCommandStart().
+static void pipelineSend(uAtClientInstance_t *pClient,
+                         const char *pCommand, bool waitDelay)
+{
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    if (pClient->error == U_ERROR_COMMON_SUCCESS) {
+        if (waitDelay && (pClient->delayMs > 0)) {
+            while (!uTimeoutExpiredMs(pClient->lastResponseStop,
+                                      pClient->delayMs)) {
+                uPortTaskBlock(10);
+            }
+        }
+        pClient->delimiterRequired = false;
+        write(pClient, pCommand, strlen(pCommand), false);
+        write(pClient, U_AT_CLIENT_COMMAND_DELIMITER,
+              U_AT_CLIENT_COMMAND_DELIMITER_LENGTH_BYTES,
+              true);
+        STATS_ADD(pClient, numCommands, 1);
+        STATS_COMMAND_SENT(pClient);
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+}
+
 // Do common checks before sending parameters
 // and also deal with the need for a delimiter.
 static bool writeCheckAndDelimit(uAtClientInstance_t *pClient)
@@ -2650,7 +3259,7 @@ static void urcCallback(const uAtClientStreamHandle_t *pStream,
                             pClient->scope = U_AT_CLIENT_SCOPE_NONE;
                             for (size_t x = 0; x < U_AT_CLIENT_URC_DATA_LOOP_GUARD; x++) {
                                 // Search through the URCs
-                                if (bufferMatchOneUrc(pClient)) {
+                                if (bufferMatchOneUrc(pClient, true)) {
                                     // If there's a bufferMatch, see if more data is available
                                     sizeOrError = getReceiveSizeForUrc(pClient);
                                     if ((sizeOrError <= 0) &&
@@ -2823,6 +3432,9 @@ static uAtClientHandle_t clientAdd(const uAtClientStreamHandle_t *pStream,
                         pClient->urcMaxStringLength = U_AT_CLIENT_INITIAL_URC_LENGTH;
                         pClient->maxRespLength = U_AT_CLIENT_MAX_LENGTH_INFORMATION_RESPONSE_PREFIX;
                         pClient->lastResponseStop = timeoutStart;
+#ifdef U_CFG_AT_CLIENT_STATS
+                        pClient->statsPrintTime = timeoutStart;
+#endif
                         // Set up the buffer and its protection markers
                         pClient->pReceiveBuffer->dataBufferSize = receiveBufferSize -
                                                                   U_AT_CLIENT_BUFFER_OVERHEAD_BYTES;
@@ -3276,6 +3888,8 @@ void uAtClientLock(uAtClientHandle_t atHandle)
         }
         clearError(pClient);
         pClient->lockTimeMs = uPortGetTickTimeMs();
+        STATS_LOCK(pClient);
+        U_TRACE_BEGIN(U_TRACE_EVENT_AT_CLIENT_TRANSACTION, pClient->stream.handle.int32);
     }
 }
 
@@ -3375,6 +3989,8 @@ int32_t uAtClientUnlock(uAtClientHandle_t atHandle)
         }
 
         U_ASSERT(U_AT_CLIENT_GUARD_CHECK(pClient->pReceiveBuffer));
+        U_TRACE_END(U_TRACE_EVENT_AT_CLIENT_TRANSACTION, (int32_t) pClient->error);
+        STATS_UNLOCK(pClient);
     }
 
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
@@ -3405,6 +4021,7 @@ void uAtClientCommandStart(uAtClientHandle_t atHandle,
         // because that is useful during testing
         if (pCommand != NULL) {
             write(pClient, pCommand, strlen(pCommand), false);
+            STATS_ADD(pClient, numCommands, 1);
         }
     }
 
@@ -3506,6 +4123,30 @@ size_t uAtClientWriteBytes(uAtClientHandle_t atHandle,
     return writeLength;
 }
 
+size_t uAtClientWriteBytesV(uAtClientHandle_t atHandle,
+                            const uDeviceSerialSegment_t *pSegments,
+                            size_t numSegments,
+                            bool standalone)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    size_t writeLength = 0;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    // As uAtClientWriteBytes(): do write check and delimit if
+    // required, else just check for errors
+    if (((pSegments != NULL) || (numSegments == 0)) &&
+        (standalone || writeCheckAndDelimit(pClient)) &&
+        (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+        // writeV() will set device error if there's a problem
+        writeLength = writeV(pClient, pSegments, numSegments, standalone);
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return writeLength;
+}
+
 void uAtClientWritePartialString(uAtClientHandle_t atHandle,
                                  bool isFirst,
                                  const char *pParam)
@@ -3547,6 +4188,7 @@ void uAtClientCommandStop(uAtClientHandle_t atHandle)
         write(pClient, U_AT_CLIENT_COMMAND_DELIMITER,
               U_AT_CLIENT_COMMAND_DELIMITER_LENGTH_BYTES,
               true);
+        STATS_COMMAND_SENT(pClient);
     }
 
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
@@ -3937,7 +4579,7 @@ int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
                     // Need to remove any CR/LF's at the start
                     while (bufferMatch(pClient, U_AT_CLIENT_CRLF,
                                        U_AT_CLIENT_CRLF_LENGTH_BYTES, false)) {}
-                    urcFound = bufferMatchOneUrc(pClient);
+                    urcFound = bufferMatchOneUrc(pClient, false);
                 } while (urcFound);
 
                 // Check for a device error landing in the buffer
@@ -3984,6 +4626,111 @@ int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
     return (int32_t) errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: PIPELINED AT COMMANDS
+ * -------------------------------------------------------------- */
+
+// Send a number of AT commands, pipelined.
+int32_t uAtClientPipeline(uAtClientHandle_t atHandle,
+                          uAtClientPipelineCommand_t *pCommands,
+                          size_t numCommands, size_t maxInFlight)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t errorCodeOrNumOk = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int32_t errorCodeAbort = (int32_t) U_ERROR_COMMON_SUCCESS;
+    uAtClientPipelineCommand_t *pCommand;
+    size_t numSent = 0;
+    size_t numDone = 0;
+    size_t numRead = 0;
+    int32_t numConsecutiveAtTimeouts;
+    bool isDraining;
+    bool isOk = (pClient != NULL) && ((pCommands != NULL) || (numCommands == 0));
+
+    for (size_t x = 0; isOk && (x < numCommands); x++) {
+        isOk = (pCommands[x].pCommand != NULL);
+    }
+
+    if (isOk) {
+        if (maxInFlight == 0) {
+            maxInFlight = 1;
+        }
+        errorCodeOrNumOk = 0;
+
+        uAtClientLock(atHandle);
+
+        while (numDone < numCommands) {
+            // Keep the pipeline full; the inter-command delay
+            // only applies when nothing is outstanding
+            while ((errorCodeAbort == (int32_t) U_ERROR_COMMON_SUCCESS) &&
+                   (numSent < numCommands) && (numSent - numDone < maxInFlight)) {
+                pipelineSend(pClient, pCommands[numSent].pCommand, numSent == numDone);
+                errorCodeAbort = (int32_t) pClient->error;
+                if (errorCodeAbort == (int32_t) U_ERROR_COMMON_SUCCESS) {
+                    numSent++;
+                }
+            }
+
+            // Read the response to the oldest outstanding command
+            pCommand = &(pCommands[numDone]);
+            pCommand->errorCode = errorCodeAbort;
+            pCommand->deviceError.type = U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR;
+            pCommand->deviceError.code = 0;
+            if (errorCodeAbort == (int32_t) U_ERROR_COMMON_SUCCESS) {
+                // The AT timeout runs from the start of each response
+                pClient->lockTimeMs = uPortGetTickTimeMs();
+                if ((uAtClientResponseStart(atHandle, pCommand->pResponsePrefix) == 0) &&
+                    (pCommand->pResponsePrefix != NULL) &&
+                    (pCommand->pResponseCallback != NULL)) {
+                    pCommand->pResponseCallback(atHandle, numDone,
+                                                pCommand->pResponseCallbackParam);
+                }
+                uAtClientResponseStop(atHandle);
+                pCommand->errorCode = (int32_t) pClient->error;
+                pCommand->deviceError = pClient->deviceError;
+                if (pCommand->errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+                    errorCodeOrNumOk++;
+                    numRead++;
+                } else if (pCommand->deviceError.type == U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR) {
+                    // Not an error response from the AT server, so a timeout
+                    // or similar: we've lost track of which response is which
+                    errorCodeAbort = pCommand->errorCode;
+                } else {
+                    numRead++;
+                }
+                // Don't let the outcome of this command affect the next
+                clearError(pClient);
+            }
+            numDone++;
+        }
+
+        // If we had to abort, the responses to the commands that were
+        // sent but not read, including the one we gave up on, may still
+        // arrive: read up to the final result code of each of them, so
+        // that they don't end up in the next transaction, stopping if
+        // nothing more turns up; none of this counts towards, or
+        // resets, the number of consecutive AT timeouts
+        isDraining = (errorCodeAbort != (int32_t) U_ERROR_COMMON_SUCCESS);
+        numConsecutiveAtTimeouts = pClient->numConsecutiveAtTimeouts;
+        pClient->isDraining = isDraining;
+        for (size_t x = numRead; isDraining && (x < numSent); x++) {
+            pClient->lockTimeMs = uPortGetTickTimeMs();
+            uAtClientResponseStart(atHandle, NULL);
+            uAtClientResponseStop(atHandle);
+            // An error that isn't from the AT server means that
+            // nothing more is coming
+            isDraining = (pClient->error == U_ERROR_COMMON_SUCCESS) ||
+                         (pClient->deviceError.type != U_AT_CLIENT_DEVICE_ERROR_TYPE_NO_ERROR);
+            clearError(pClient);
+        }
+        pClient->isDraining = false;
+        pClient->numConsecutiveAtTimeouts = numConsecutiveAtTimeouts;
+
+        uAtClientUnlock(atHandle);
+    }
+
+    return errorCodeOrNumOk;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: HANDLE UNSOLICITED RESPONSES
  * -------------------------------------------------------------- */
@@ -4029,6 +4776,9 @@ int32_t uAtClientSetUrcHandler(uAtClientHandle_t atHandle,
                 pUrc->prefixLength = prefixLength;
                 pUrc->pHandler = pHandler;
                 pUrc->pHandlerParam = pHandlerParam;
+#ifdef U_CFG_AT_CLIENT_STATS
+                pUrc->count = 0;
+#endif
 
                 errorCode = U_ERROR_COMMON_SUCCESS;
             }
@@ -4055,6 +4805,7 @@ int32_t uAtClientSetUrcHandler(uAtClientHandle_t atHandle,
 
         pUrc->pNext = pClient->pUrcList;
         pClient->pUrcList = pUrc;
+        urcTrieRebuild(pClient);
 
         U_PORT_MUTEX_UNLOCK(pClient->urcPermittedMutex);
     }
@@ -4086,6 +4837,7 @@ void uAtClientRemoveUrcHandler(uAtClientHandle_t atHandle,
             } else {
                 pClient->pUrcList = pCurrent->pNext;
             }
+            urcTrieRebuild(pClient);
 
             U_PORT_MUTEX_UNLOCK(pClient->urcPermittedMutex);
 
@@ -4261,7 +5013,7 @@ int32_t uAtClientUrcDirect(uAtClientHandle_t atHandle,
                 // another URC might arrive while we're waiting for
                 // _this_ URC. If we don't find a URC either then
                 // try to bring in more stuff, blocking until done
-                if (!prefixFound && !bufferMatchOneUrc(pClient) &&
+                if (!prefixFound && !bufferMatchOneUrc(pClient, false) &&
                     !bufferFill(pClient, true)) {
                     // nuffin: set an error to get us out of here
                     setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
@@ -4650,4 +5402,124 @@ int32_t uAtClientGetAti(uAtClientHandle_t atHandle,
     return errorCodeOrLength;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: STATISTICS
+ * -------------------------------------------------------------- */
+
+// Get the statistics of an AT client.
+int32_t uAtClientStatsGet(uAtClientHandle_t atHandle,
+                          uAtClientStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+#ifdef U_CFG_AT_CLIENT_STATS
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+
+    errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    if ((pClient != NULL) && (pStats != NULL)) {
+
+        U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+        *pStats = pClient->stats;
+        pStats->numConsecutiveTimeouts = pClient->numConsecutiveAtTimeouts;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+        U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+    }
+#else
+    (void) atHandle;
+    (void) pStats;
+#endif
+
+    return errorCode;
+}
+
+// Get the number of times a URC handler has been called.
+int32_t uAtClientStatsUrcGet(uAtClientHandle_t atHandle, size_t index,
+                             const char **ppPrefix)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+#ifdef U_CFG_AT_CLIENT_STATS
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    const uAtClientUrc_t *pUrc;
+
+    errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    if (pClient != NULL) {
+
+        U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+        pUrc = pClient->pUrcList;
+        for (size_t x = 0; (x < index) && (pUrc != NULL); x++) {
+            pUrc = pUrc->pNext;
+        }
+        if (pUrc != NULL) {
+            if (ppPrefix != NULL) {
+                *ppPrefix = pUrc->pPrefix;
+            }
+            errorCodeOrCount = (int32_t) pUrc->count;
+        }
+
+        U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+    }
+#else
+    (void) atHandle;
+    (void) index;
+    (void) ppPrefix;
+#endif
+
+    return errorCodeOrCount;
+}
+
+// Reset the statistics of an AT client.
+int32_t uAtClientStatsReset(uAtClientHandle_t atHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+#ifdef U_CFG_AT_CLIENT_STATS
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uAtClientUrc_t *pUrc;
+
+    errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    if (pClient != NULL) {
+
+        U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+        memset(&(pClient->stats), 0, sizeof(pClient->stats));
+        for (pUrc = pClient->pUrcList; pUrc != NULL; pUrc = pUrc->pNext) {
+            pUrc->count = 0;
+        }
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+        U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+    }
+#else
+    (void) atHandle;
+#endif
+
+    return errorCode;
+}
+
+// Print the statistics of an AT client.
+int32_t uAtClientStatsPrint(uAtClientHandle_t atHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+#ifdef U_CFG_AT_CLIENT_STATS
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+
+    errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    if (pClient != NULL) {
+
+        U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+        statsPrint(pClient);
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+        U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+    }
+#else
+    (void) atHandle;
+#endif
+
+    return errorCode;
+}
+
 // End of file
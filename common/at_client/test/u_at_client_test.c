@@ -55,6 +55,9 @@
 #include "u_port_debug.h"
 #include "u_port_uart.h"
 
+#include "u_interface.h"
+#include "u_device_serial.h"
+
 #include "u_test_util_resource_check.h"
 
 #include "u_timeout.h"
@@ -137,6 +140,16 @@
  * we need room for initial and trailing line endings. */
 #define U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES (256 + 4 + U_AT_CLIENT_BUFFER_OVERHEAD_BYTES)
 
+/** The number of URCs to register for the URC benchmark.
+ */
+#define U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS 50
+
+#ifndef U_AT_CLIENT_TEST_URC_BENCHMARK_DURATION_MS
+/** How long to run the URC benchmark for.
+ */
+# define U_AT_CLIENT_TEST_URC_BENCHMARK_DURATION_MS 1000
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -153,6 +166,48 @@ typedef struct {
     int32_t responseLastError;
 } uAtClientTestCheckCommandResponse_t;
 
+/** Context data for the virtual serial device used by the tests
+ * that need no UART, which "receives" the contents of a buffer.
+ */
+typedef struct {
+    const char *pData;
+    size_t size;
+    size_t index;
+    void (*pEventCallback)(struct uDeviceSerial_t *, uint32_t, void *);
+    void *pEventCallbackParam;
+    bool isCallback; /**< what eventIsCallback() should return. */
+    void (*pWrite)(struct uDeviceSerial_t *, const char *, size_t); /**< called
+                                                                         with whatever
+                                                                         the AT client
+                                                                         writes, may be
+                                                                         NULL. */
+} uAtClientTestSerial_t;
+
+/** Context for pipelineServerWrite().
+ */
+typedef struct {
+    char command[32];
+    size_t commandLength;
+    size_t numCommands; /**< the number of commands received. */
+    size_t maxNumAhead; /**< the largest number of commands received
+                             beyond the one whose response was being
+                             read, see pipelineResponseCallback(). */
+    bool isHeld;        /**< true if responses are being held back,
+                             see pipelineServerRelease(). */
+    size_t sizeHeld;    /**< the size of the data, including that
+                             held back, while isHeld is true. */
+} uAtClientTestPipelineServer_t;
+
+/** Context for writeVCapture().
+ */
+typedef struct {
+    char data[64];
+    size_t length;
+    size_t numWriteV;      /**< the number of calls to testSerialWriteV(). */
+    size_t maxSizeWriteV;  /**< the most testSerialWriteV() will write in
+                                one go, zero for no limit. */
+} uAtClientTestWriteV_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -165,6 +220,36 @@ static int32_t gUartAHandle = -1;
  */
 static int32_t gUartBHandle = -1;
 
+/** The prefixes of the URCs registered by the URC benchmark.
+ */
+static char gUrcBenchmarkPrefix[U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS][12];
+
+/** The data "received" by the URC benchmark: one line for each URC.
+ */
+static char gUrcBenchmarkData[U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS * 16];
+
+/** The data "sent" by the AT server of the pipeline test.
+ */
+static char gPipelineServerData[512];
+
+/** Context for the AT server of the pipeline test.
+ */
+static uAtClientTestPipelineServer_t gPipelineServer;
+
+/** Timer used by the AT server of the pipeline test to hold
+ * back responses.
+ */
+static uPortTimerHandle_t gPipelineServerTimerHandle = NULL;
+
+/** The number of times the consecutive AT timeout callback has
+ * been called during the pipeline test.
+ */
+static volatile int32_t gPipelineNumConsecutiveTimeoutCalls = 0;
+
+/** Context for the scatter-gather write test.
+ */
+static uAtClientTestWriteV_t gWriteV;
+
 #if (U_CFG_TEST_UART_A >= 0)
 
 /** Store the last consecutive AT time-out call-back here.
@@ -188,6 +273,298 @@ static const char *gpInterceptTxDataLast = NULL;
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Read from the test virtual serial device.
+static int32_t testSerialRead(struct uDeviceSerial_t *pDeviceSerial,
+                              void *pBuffer, size_t sizeBytes)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext(pDeviceSerial);
+
+    if (sizeBytes > pContext->size - pContext->index) {
+        sizeBytes = pContext->size - pContext->index;
+    }
+    memcpy(pBuffer, pContext->pData + pContext->index, sizeBytes);
+    pContext->index += sizeBytes;
+
+    return (int32_t) sizeBytes;
+}
+
+// Get the receive size of the test virtual serial device.
+static int32_t testSerialGetReceiveSize(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext(pDeviceSerial);
+
+    return (int32_t) (pContext->size - pContext->index);
+}
+
+// Write to the test virtual serial device: passed to pWrite, if
+// there is one, else thrown away.
+static int32_t testSerialWrite(struct uDeviceSerial_t *pDeviceSerial,
+                               const void *pBuffer, size_t sizeBytes)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext(pDeviceSerial);
+
+    if (pContext->pWrite != NULL) {
+        pContext->pWrite(pDeviceSerial, (const char *) pBuffer, sizeBytes);
+    }
+
+    return (int32_t) sizeBytes;
+}
+
+// Scatter-gather write to the test virtual serial device: as
+// testSerialWrite() but counts the calls and will write no more
+// than gWriteV.maxSizeWriteV bytes in one go, if that is non-zero,
+// so that short writes can be tested.
+static int32_t testSerialWriteV(struct uDeviceSerial_t *pDeviceSerial,
+                                const uDeviceSerialSegment_t *pSegments,
+                                size_t numSegments)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext(pDeviceSerial);
+    size_t sizeWritten = 0;
+    size_t thisSize;
+
+    gWriteV.numWriteV++;
+    for (size_t x = 0; x < numSegments; x++) {
+        thisSize = pSegments[x].sizeBytes;
+        if ((gWriteV.maxSizeWriteV > 0) &&
+            (sizeWritten + thisSize > gWriteV.maxSizeWriteV)) {
+            thisSize = gWriteV.maxSizeWriteV - sizeWritten;
+        }
+        if (pContext->pWrite != NULL) {
+            pContext->pWrite(pDeviceSerial, (const char *) pSegments[x].pData, thisSize);
+        }
+        sizeWritten += thisSize;
+    }
+
+    return (int32_t) sizeWritten;
+}
+
+// Set the event callback of the test virtual serial device;
+// the callback is called directly by the test, so no task is needed.
+static int32_t testSerialEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
+                                          uint32_t filter,
+                                          void (*pFunction)(struct uDeviceSerial_t *,
+                                                            uint32_t,
+                                                            void *),
+                                          void *pParam,
+                                          size_t stackSizeBytes,
+                                          int32_t priority)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext(pDeviceSerial);
+    (void) filter;
+    (void) stackSizeBytes;
+    (void) priority;
+
+    pContext->pEventCallback = pFunction;
+    pContext->pEventCallbackParam = pParam;
+
+    return 0;
+}
+
+// Remove the event callback of the test virtual serial device.
+static void testSerialEventCallbackRemove(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext(pDeviceSerial);
+
+    pContext->pEventCallback = NULL;
+    pContext->pEventCallbackParam = NULL;
+}
+
+// Whether the test virtual serial device is in its callback.
+static bool testSerialEventIsCallback(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext(pDeviceSerial);
+
+    return pContext->isCallback;
+}
+
+// Populate the vector table of the test virtual serial device.
+static void testSerialInit(struct uDeviceSerial_t *pDeviceSerial)
+{
+    pDeviceSerial->read = testSerialRead;
+    pDeviceSerial->getReceiveSize = testSerialGetReceiveSize;
+    pDeviceSerial->write = testSerialWrite;
+    pDeviceSerial->eventCallbackSet = testSerialEventCallbackSet;
+    pDeviceSerial->eventCallbackRemove = testSerialEventCallbackRemove;
+    pDeviceSerial->eventIsCallback = testSerialEventIsCallback;
+}
+
+// As testSerialInit() but with a scatter-gather write function.
+static void testSerialInitWriteV(struct uDeviceSerial_t *pDeviceSerial)
+{
+    testSerialInit(pDeviceSerial);
+    pDeviceSerial->writeV = testSerialWriteV;
+}
+
+// "Receive" the given data on the test virtual serial device,
+// calling the AT client's callback directly.
+static void testSerialReceive(struct uDeviceSerial_t *pDeviceSerial,
+                              const char *pData, size_t size)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext(pDeviceSerial);
+
+    pContext->pData = pData;
+    pContext->size = size;
+    pContext->index = 0;
+    if (pContext->pEventCallback != NULL) {
+        pContext->isCallback = true;
+        pContext->pEventCallback(pDeviceSerial, U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED,
+                                 pContext->pEventCallbackParam);
+        pContext->isCallback = false;
+    }
+}
+
+// The AT server for the pipeline test, called with whatever the
+// AT client writes: when a complete command has arrived the response
+// is appended to gPipelineServerData; "AT+ERR" gets ERROR, "AT+CME"
+// gets "+CME ERROR: 3", "AT+NUMn" gets "+NUM: n" then OK, preceded by
+// a URC "+UUBM00: 1", "AT+MUTE" gets nothing at all, anything else
+// gets just OK.  "AT+LATE" also
+// starts gPipelineServerTimerHandle: its response, and those to any
+// commands that follow, are held back until the timer calls
+// pipelineServerRelease().
+static void pipelineServerWrite(struct uDeviceSerial_t *pDeviceSerial,
+                                const char *pData, size_t size)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext(pDeviceSerial);
+    uAtClientTestPipelineServer_t *pServer = &gPipelineServer;
+    size_t length;
+    char *pResponse;
+    size_t responseSize;
+
+    for (size_t x = 0; x < size; x++) {
+        if (pData[x] == '\r') {
+            // Data the AT client has already read can be
+            // thrown away, then append the response
+            length = pContext->size;
+            if (pServer->isHeld) {
+                length = pServer->sizeHeld;
+            }
+            length -= pContext->index;
+            memmove(gPipelineServerData, gPipelineServerData + pContext->index, length);
+            pContext->pData = gPipelineServerData;
+            pContext->size -= pContext->index;
+            pContext->index = 0;
+            pResponse = gPipelineServerData + length;
+            responseSize = sizeof(gPipelineServerData) - length;
+            pServer->command[pServer->commandLength] = 0;
+            if (strcmp(pServer->command, "AT+ERR") == 0) {
+                length += snprintf(pResponse, responseSize, "\r\nERROR\r\n");
+            } else if (strcmp(pServer->command, "AT+CME") == 0) {
+                length += snprintf(pResponse, responseSize, "\r\n+CME ERROR: 3\r\n");
+            } else if (strncmp(pServer->command, "AT+NUM", 6) == 0) {
+                length += snprintf(pResponse, responseSize, "\r\n+UUBM00: 1\r\n"
+                                   "\r\n+NUM: %s\r\n\r\nOK\r\n", pServer->command + 6);
+            } else if (strcmp(pServer->command, "AT+MUTE") == 0) {
+                // No response
+            } else {
+                length += snprintf(pResponse, responseSize, "\r\nOK\r\n");
+                if ((strcmp(pServer->command, "AT+LATE") == 0) && !pServer->isHeld) {
+                    // Release only what came before this response
+                    pServer->isHeld = true;
+                    pContext->size = pResponse - gPipelineServerData;
+                    uPortTimerStart(gPipelineServerTimerHandle);
+                }
+            }
+            if (pServer->isHeld) {
+                pServer->sizeHeld = length;
+            } else {
+                pContext->size = length;
+            }
+            pServer->commandLength = 0;
+            pServer->numCommands++;
+        } else if (pServer->commandLength < sizeof(pServer->command) - 1) {
+            pServer->command[pServer->commandLength] = pData[x];
+            pServer->commandLength++;
+        }
+    }
+}
+
+// Timer callback for the pipeline test: let the AT client have the
+// responses that the AT server has been holding back.
+static void pipelineServerRelease(const uPortTimerHandle_t timerHandle,
+                                  void *pParameter)
+{
+    uAtClientTestSerial_t *pContext = (uAtClientTestSerial_t *)
+                                      pUInterfaceContext((uDeviceSerial_t *) pParameter);
+
+    (void) timerHandle;
+
+    pContext->size = gPipelineServer.sizeHeld;
+    gPipelineServer.isHeld = false;
+}
+
+// Capture whatever the AT client writes for the scatter-gather
+// write test.
+static void writeVCapture(struct uDeviceSerial_t *pDeviceSerial,
+                          const char *pData, size_t size)
+{
+    (void) pDeviceSerial;
+
+    if (size > sizeof(gWriteV.data) - gWriteV.length) {
+        size = sizeof(gWriteV.data) - gWriteV.length;
+    }
+    memcpy(gWriteV.data + gWriteV.length, pData, size);
+    gWriteV.length += size;
+}
+
+// Response callback for the pipeline test: reads the integer
+// and stores it in the int32_t pointed-to by pParam, also noting
+// how far ahead of this response the commands have got.
+static void pipelineResponseCallback(uAtClientHandle_t atClientHandle,
+                                     size_t index, void *pParam)
+{
+    size_t numAhead = gPipelineServer.numCommands - (index + 1);
+
+    if (numAhead > gPipelineServer.maxNumAhead) {
+        gPipelineServer.maxNumAhead = numAhead;
+    }
+    *((int32_t *) pParam) = uAtClientReadInt(atClientHandle);
+}
+
+// Consecutive AT timeout callback for the pipeline test: just
+// counts calls.
+//lint -e{818} suppress "could be declared as pointing to const", callback
+// has to follow function signature
+static void pipelineConsecutiveTimeoutCallback(uAtClientHandle_t atClientHandle,
+                                               int32_t *pCount)
+{
+    (void) atClientHandle;
+    (void) pCount;
+
+    gPipelineNumConsecutiveTimeoutCalls++;
+}
+
+// URC handler for the URC benchmark: reads the integer parameter
+// and adds it to the int32_t pointed-to by pParameters.
+static void urcBenchmarkHandler(uAtClientHandle_t atClientHandle, void *pParameters)
+{
+    int32_t *pCount = (int32_t *) pParameters;
+    int32_t x;
+
+    x = uAtClientReadInt(atClientHandle);
+    if (x > 0) {
+        *pCount += x;
+    }
+}
+
+// URC handler for the URC benchmark: just counts calls in the
+// int32_t pointed-to by pParameters.
+static void urcBenchmarkCountHandler(uAtClientHandle_t atClientHandle, void *pParameters)
+{
+    (void) atClientHandle;
+
+    (*((int32_t *) pParameters))++;
+}
+
 #if (U_CFG_TEST_UART_A >= 0)
 
 // AT consecutive timeout callback, used by some of the tests below
@@ -1729,6 +2106,377 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientCommandSet2")
 # endif
 #endif
 
+/** Measure how many URC lines per second the AT client can
+ * dispatch with #U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS URCs
+ * registered, using a virtual serial device that "receives" a
+ * buffer of URC lines, so no UART is required; also checks that,
+ * where one URC prefix is the prefix of another, the URC handler
+ * registered last wins, as it always has.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientUrcBenchmark")
+{
+    uAtClientHandle_t atClientHandle;
+    uAtClientStreamHandle_t stream;
+    uDeviceSerial_t *pDeviceSerial;
+    int32_t count[U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS] = {0};
+    int32_t countNest[2] = {0};
+    size_t dataSize = 0;
+    int32_t numLines = 0;
+    int32_t startTimeMs;
+    int32_t durationMs = 0;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUDeviceSerialCreate(testSerialInit,
+                                         sizeof(uAtClientTestSerial_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    // Don't hang around waiting for more data, there won't be any
+    uAtClientReadRetryDelaySet(atClientHandle, 0);
+    uAtClientTimeoutUrcSet(atClientHandle, 0);
+
+    // Register the URCs and create one line of data for each
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS; x++) {
+        snprintf(gUrcBenchmarkPrefix[x], sizeof(gUrcBenchmarkPrefix[x]), "+UUBM%02d:", (int) x);
+        U_PORT_TEST_ASSERT(uAtClientSetUrcHandler(atClientHandle, gUrcBenchmarkPrefix[x],
+                                                  urcBenchmarkHandler, &(count[x])) == 0);
+        dataSize += snprintf(gUrcBenchmarkData + dataSize, sizeof(gUrcBenchmarkData) - dataSize,
+                             "%s 1\r\n", gUrcBenchmarkPrefix[x]);
+    }
+
+    U_TEST_PRINT_LINE("dispatching URCs for %d ms with %d URCs registered...",
+                      U_AT_CLIENT_TEST_URC_BENCHMARK_DURATION_MS,
+                      U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS);
+    startTimeMs = uPortGetTickTimeMs();
+    while (durationMs < U_AT_CLIENT_TEST_URC_BENCHMARK_DURATION_MS) {
+        testSerialReceive(pDeviceSerial, gUrcBenchmarkData, dataSize);
+        numLines += U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS;
+        durationMs = uPortGetTickTimeMs() - startTimeMs;
+    }
+    U_TEST_PRINT_LINE("%d URC line(s) in %d ms, %d lines/second.", numLines, durationMs,
+                      (int32_t) (((int64_t) numLines * 1000) / (durationMs > 0 ? durationMs : 1)));
+    // Every line should have been dispatched to the right handler
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS; x++) {
+        U_PORT_TEST_ASSERT(count[x] == numLines / U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS);
+    }
+
+    U_TEST_PRINT_LINE("checking URCs whose prefixes nest...");
+    U_PORT_TEST_ASSERT(uAtClientSetUrcHandler(atClientHandle, "+UUBMNEST",
+                                              urcBenchmarkCountHandler, &(countNest[0])) == 0);
+    U_PORT_TEST_ASSERT(uAtClientSetUrcHandler(atClientHandle, "+UUBMNEST:",
+                                              urcBenchmarkCountHandler, &(countNest[1])) == 0);
+    testSerialReceive(pDeviceSerial, "+UUBMNEST: 1\r\n", 14);
+    U_PORT_TEST_ASSERT((countNest[0] == 0) && (countNest[1] == 1));
+    uAtClientRemoveUrcHandler(atClientHandle, "+UUBMNEST:");
+    testSerialReceive(pDeviceSerial, "+UUBMNEST: 1\r\n", 14);
+    U_PORT_TEST_ASSERT((countNest[0] == 1) && (countNest[1] == 1));
+    // Something that isn't a URC at all shouldn't upset anything
+    testSerialReceive(pDeviceSerial, "+UUBX: 1\r\n+UUBM0: 1\r\n", 22);
+    testSerialReceive(pDeviceSerial, gUrcBenchmarkData, dataSize);
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS; x++) {
+        U_PORT_TEST_ASSERT(count[x] == (numLines / U_AT_CLIENT_TEST_URC_BENCHMARK_NUM_URCS) + 1);
+    }
+
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+    uDeviceSerialDelete(pDeviceSerial);
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test pipelined AT commands, using a virtual serial device
+ * with a simple AT server behind it, so no UART is required.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientPipeline")
+{
+    uAtClientHandle_t atClientHandle;
+    uAtClientStreamHandle_t stream;
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientTestSerial_t *pContext;
+    uAtClientPipelineCommand_t command[6] = {0};
+    int32_t value[6];
+    int32_t urcCount = 0;
+    uAtClientStats_t stats;
+    const char *pPrefix = NULL;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUDeviceSerialCreate(testSerialInit, sizeof(uAtClientTestSerial_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    pContext = (uAtClientTestSerial_t *) pUInterfaceContext(pDeviceSerial);
+    pContext->pData = gPipelineServerData;
+    pContext->pWrite = pipelineServerWrite;
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientReadRetryDelaySet(atClientHandle, 0);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+    U_PORT_TEST_ASSERT(uAtClientSetUrcHandler(atClientHandle, "+UUBM00:",
+                                              urcBenchmarkCountHandler, &urcCount) == 0);
+
+    command[0].pCommand = "AT+NUM0";
+    command[1].pCommand = "AT+NUM1";
+    command[2].pCommand = "AT+ERR";
+    command[3].pCommand = "AT+NUM3";
+    command[4].pCommand = "AT+CME";
+    command[5].pCommand = "AT";
+    for (size_t x = 0; x < sizeof(command) / sizeof(command[0]); x++) {
+        value[x] = -1;
+        command[x].pResponsePrefix = "+NUM:";
+        command[x].pResponseCallback = pipelineResponseCallback;
+        command[x].pResponseCallbackParam = &(value[x]);
+    }
+
+    U_TEST_PRINT_LINE("testing bad parameters...");
+    U_PORT_TEST_ASSERT(uAtClientPipeline(atClientHandle, NULL, 1, 1) < 0);
+    U_PORT_TEST_ASSERT(uAtClientPipeline(atClientHandle, NULL, 0, 1) == 0);
+
+    for (size_t maxInFlight = 0; maxInFlight < 4; maxInFlight++) {
+        U_TEST_PRINT_LINE("sending %d commands with up to %d in flight...",
+                          sizeof(command) / sizeof(command[0]), maxInFlight);
+        memset(&gPipelineServer, 0, sizeof(gPipelineServer));
+        pContext->size = 0;
+        pContext->index = 0;
+        urcCount = 0;
+        for (size_t x = 0; x < sizeof(command) / sizeof(command[0]); x++) {
+            value[x] = -1;
+        }
+        U_PORT_TEST_ASSERT(uAtClientPipeline(atClientHandle, command,
+                                             sizeof(command) / sizeof(command[0]),
+                                             maxInFlight) == 4);
+        U_PORT_TEST_ASSERT(gPipelineServer.numCommands == sizeof(command) / sizeof(command[0]));
+        // Commands can only have got ahead if allowed to
+        U_TEST_PRINT_LINE("at most %d command(s) were ahead of a response.",
+                          gPipelineServer.maxNumAhead);
+        if (maxInFlight <= 1) {
+            U_PORT_TEST_ASSERT(gPipelineServer.maxNumAhead == 0);
+        } else {
+            U_PORT_TEST_ASSERT(gPipelineServer.maxNumAhead == maxInFlight - 1);
+        }
+        // Each response should have been matched to its command
+        U_PORT_TEST_ASSERT((command[0].errorCode == 0) && (value[0] == 0));
+        U_PORT_TEST_ASSERT((command[1].errorCode == 0) && (value[1] == 1));
+        U_PORT_TEST_ASSERT((command[2].errorCode < 0) && (value[2] == -1));
+        U_PORT_TEST_ASSERT(command[2].deviceError.type == U_AT_CLIENT_DEVICE_ERROR_TYPE_ERROR);
+        U_PORT_TEST_ASSERT((command[3].errorCode == 0) && (value[3] == 3));
+        U_PORT_TEST_ASSERT((command[4].errorCode < 0) && (value[4] == -1));
+        U_PORT_TEST_ASSERT((command[4].deviceError.type == U_AT_CLIENT_DEVICE_ERROR_TYPE_CME) &&
+                           (command[4].deviceError.code == 3));
+        U_PORT_TEST_ASSERT((command[5].errorCode == 0) && (value[5] == -1));
+        // The URCs in between should have been handled
+        U_PORT_TEST_ASSERT(urcCount == 3);
+    }
+
+    U_TEST_PRINT_LINE("checking statistics...");
+#ifdef U_CFG_AT_CLIENT_STATS
+    U_PORT_TEST_ASSERT(uAtClientStatsPrint(atClientHandle) == 0);
+    U_PORT_TEST_ASSERT(uAtClientStatsGet(atClientHandle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numCommands == 4 * sizeof(command) / sizeof(command[0]));
+    U_PORT_TEST_ASSERT(stats.numLocks >= 4);
+    U_PORT_TEST_ASSERT(stats.numBytesTx > 0);
+    U_PORT_TEST_ASSERT(stats.numBytesRx > stats.numBytesTx);
+    U_PORT_TEST_ASSERT(stats.numFirstBytes > 0);
+    U_PORT_TEST_ASSERT(stats.firstByteMaxMs <= stats.firstByteTotalMs);
+    U_PORT_TEST_ASSERT(stats.lockedMaxMs <= stats.lockedTotalMs);
+    U_PORT_TEST_ASSERT(stats.numUrcs == 4 * 3);
+    U_PORT_TEST_ASSERT(stats.numTimeouts == 0);
+    U_PORT_TEST_ASSERT(uAtClientStatsUrcGet(atClientHandle, 0, &pPrefix) == 4 * 3);
+    U_PORT_TEST_ASSERT((pPrefix != NULL) && (strcmp(pPrefix, "+UUBM00:") == 0));
+    U_PORT_TEST_ASSERT(uAtClientStatsUrcGet(atClientHandle, 1, NULL) ==
+                       (int32_t) U_ERROR_COMMON_NOT_FOUND);
+    U_PORT_TEST_ASSERT(uAtClientStatsReset(atClientHandle) == 0);
+    U_PORT_TEST_ASSERT(uAtClientStatsGet(atClientHandle, &stats) == 0);
+    U_PORT_TEST_ASSERT((stats.numCommands == 0) && (stats.numUrcs == 0));
+    U_PORT_TEST_ASSERT(uAtClientStatsUrcGet(atClientHandle, 0, NULL) == 0);
+#else
+    U_PORT_TEST_ASSERT(uAtClientStatsGet(atClientHandle, &stats) ==
+                       (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+    U_PORT_TEST_ASSERT(uAtClientStatsUrcGet(atClientHandle, 0, &pPrefix) ==
+                       (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+#endif
+
+    // A response that arrives after the AT timeout aborts the pipeline;
+    // it and the responses to the commands already sent behind it must
+    // not be left for the next transaction to trip over, nor should
+    // reading them count as further consecutive AT timeouts
+    U_TEST_PRINT_LINE("testing a late response...");
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS / 4);
+    gPipelineNumConsecutiveTimeoutCalls = 0;
+    uAtClientTimeoutCallbackSet(atClientHandle, pipelineConsecutiveTimeoutCallback);
+    U_PORT_TEST_ASSERT(uPortTimerCreate(&gPipelineServerTimerHandle, "atPipeline",
+                                        pipelineServerRelease, pDeviceSerial,
+                                        (U_AT_CLIENT_TEST_AT_TIMEOUT_MS / 8) * 3, false) == 0);
+    memset(&gPipelineServer, 0, sizeof(gPipelineServer));
+    pContext->size = 0;
+    pContext->index = 0;
+    command[1].pCommand = "AT+LATE";
+    command[2].pCommand = "AT+NUM2";
+    command[3].pCommand = "AT+MUTE";
+    for (size_t x = 0; x < 4; x++) {
+        value[x] = -1;
+    }
+    U_PORT_TEST_ASSERT(uAtClientPipeline(atClientHandle, command, 4, 4) == 1);
+    U_PORT_TEST_ASSERT(gPipelineServer.numCommands == 4);
+    U_PORT_TEST_ASSERT((command[0].errorCode == 0) && (value[0] == 0));
+    for (size_t x = 1; x < 4; x++) {
+        U_PORT_TEST_ASSERT((command[x].errorCode < 0) && (value[x] == -1));
+    }
+    U_PORT_TEST_ASSERT(!gPipelineServer.isHeld);
+    U_PORT_TEST_ASSERT(pContext->index == pContext->size);
+    // Give the callback, which is called from the AT client's
+    // event queue, time to run: only the timeout on AT+LATE
+    // should have been counted, not the one on AT+MUTE that
+    // ended the drain
+    uPortTaskBlock(U_AT_CLIENT_TEST_AT_TIMEOUT_MS / 4);
+    U_TEST_PRINT_LINE("consecutive AT timeout callback called %d time(s).",
+                      gPipelineNumConsecutiveTimeoutCalls);
+    U_PORT_TEST_ASSERT(gPipelineNumConsecutiveTimeoutCalls == 1);
+    uPortTimerDelete(gPipelineServerTimerHandle);
+    gPipelineServerTimerHandle = NULL;
+    value[5] = -1;
+    command[5].pCommand = "AT+NUM5";
+    U_PORT_TEST_ASSERT(uAtClientPipeline(atClientHandle, &(command[5]), 1, 1) == 1);
+    U_PORT_TEST_ASSERT(value[5] == 5);
+
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+    uDeviceSerialDelete(pDeviceSerial);
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test the scatter-gather write, uAtClientWriteBytesV(), using
+ * a virtual serial device so that no UART is required.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientWriteBytesV")
+{
+    uAtClientHandle_t atClientHandle;
+    uAtClientStreamHandle_t stream;
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientTestSerial_t *pContext;
+    uDeviceSerialSegment_t segment[4];
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUDeviceSerialCreate(testSerialInitWriteV,
+                                         sizeof(uAtClientTestSerial_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    pContext = (uAtClientTestSerial_t *) pUInterfaceContext(pDeviceSerial);
+    pContext->pWrite = writeVCapture;
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+
+    segment[0].pData = "abc";
+    segment[0].sizeBytes = 3;
+    segment[1].pData = NULL;
+    segment[1].sizeBytes = 0;
+    segment[2].pData = "defgh";
+    segment[2].sizeBytes = 5;
+    segment[3].pData = "ij";
+    segment[3].sizeBytes = 2;
+
+    U_TEST_PRINT_LINE("testing standalone scatter-gather write...");
+    memset(&gWriteV, 0, sizeof(gWriteV));
+    uAtClientLock(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientWriteBytesV(atClientHandle, segment, 4, true) == 10);
+    U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+    U_PORT_TEST_ASSERT(gWriteV.numWriteV == 1);
+    U_PORT_TEST_ASSERT((gWriteV.length == 10) &&
+                       (memcmp(gWriteV.data, "abcdefghij", 10) == 0));
+
+    U_TEST_PRINT_LINE("testing scatter-gather write with short writes...");
+    for (size_t x = 1; x < 10; x++) {
+        memset(&gWriteV, 0, sizeof(gWriteV));
+        gWriteV.maxSizeWriteV = x;
+        uAtClientLock(atClientHandle);
+        U_PORT_TEST_ASSERT(uAtClientWriteBytesV(atClientHandle, segment, 4, true) == 10);
+        U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+        U_PORT_TEST_ASSERT(gWriteV.numWriteV > 1);
+        U_PORT_TEST_ASSERT((gWriteV.length == 10) &&
+                           (memcmp(gWriteV.data, "abcdefghij", 10) == 0));
+    }
+
+    U_TEST_PRINT_LINE("testing scatter-gather write as a parameter...");
+    memset(&gWriteV, 0, sizeof(gWriteV));
+    uAtClientLock(atClientHandle);
+    uAtClientCommandStart(atClientHandle, "AT+TEST=");
+    uAtClientWriteInt(atClientHandle, 1);
+    U_PORT_TEST_ASSERT(uAtClientWriteBytesV(atClientHandle, segment, 4, false) == 10);
+    uAtClientCommandStop(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+    gWriteV.data[gWriteV.length] = 0;
+    U_TEST_PRINT_LINE("wrote \"%s\".", gWriteV.data);
+    U_PORT_TEST_ASSERT(strcmp(gWriteV.data, "AT+TEST=1,abcdefghij\r") == 0);
+
+    U_TEST_PRINT_LINE("testing default scatter-gather write...");
+    // A serial device without a writeV() of its own gets the
+    // default, which should call write() for each segment
+    uAtClientRemove(atClientHandle);
+    uDeviceSerialDelete(pDeviceSerial);
+    pDeviceSerial = pUDeviceSerialCreate(testSerialInit, sizeof(uAtClientTestSerial_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    pContext = (uAtClientTestSerial_t *) pUInterfaceContext(pDeviceSerial);
+    pContext->pWrite = writeVCapture;
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    memset(&gWriteV, 0, sizeof(gWriteV));
+    uAtClientLock(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientWriteBytesV(atClientHandle, segment, 4, true) == 10);
+    U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+    U_PORT_TEST_ASSERT(gWriteV.numWriteV == 0);
+    U_PORT_TEST_ASSERT((gWriteV.length == 10) &&
+                       (memcmp(gWriteV.data, "abcdefghij", 10) == 0));
+
+    uAtClientRemove(atClientHandle);
+    uAtClientDeinit();
+    uDeviceSerialDelete(pDeviceSerial);
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
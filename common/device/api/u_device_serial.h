@@ -22,6 +22,8 @@
  * of another module should be included here; otherwise
  * please keep #includes to your .c files. */
 
+#include "u_port_uart.h" // uPortUartSegment_t
+
 /** \addtogroup device Device
  *  @{
  */
@@ -71,7 +73,7 @@ extern "C" {
 
 /** The version of this API.
  */
-#define U_DEVICE_SERIAL_VERSION 2
+#define U_DEVICE_SERIAL_VERSION 3
 
 /** The event which means that received data is available; this
  * will be sent if the receive buffer goes from empty to containing
@@ -101,6 +103,12 @@ extern "C" {
 // Forward declaration.
 struct uDeviceSerial_t;
 
+/** A segment of data for #uDeviceSerialWriteV_t; the same as
+ * that used by uPortUartWriteV() so that one array of segments
+ * may be passed to either.
+ */
+typedef uPortUartSegment_t uDeviceSerialSegment_t;
+
 /** Open a serial device.  If the device has already been
  * opened this function returns an error.
  *
@@ -163,6 +171,25 @@ typedef int32_t (*uDeviceSerialRead_t)(struct uDeviceSerial_t *pDeviceSerial,
 typedef int32_t (*uDeviceSerialWrite_t)(struct uDeviceSerial_t *pDeviceSerial,
                                         const void *pBuffer, size_t sizeBytes);
 
+/** Write a number of segments of data to the given serial device
+ * as a single operation, a "scatter-gather" write.  Will block
+ * until all of the data has been written or an error has occurred.
+ * Segments with a sizeBytes of zero are skipped.  Where this is
+ * not implemented by the serial device the default implementation
+ * calls #uDeviceSerialWrite_t for each segment in turn.
+ *
+ * This function is only present in #U_DEVICE_SERIAL_VERSION 3 and later
+ *
+ * @param pDeviceSerial  the serial device; cannot be NULL.
+ * @param[in] pSegments  a pointer to an array of segments to send.
+ * @param numSegments    the number of entries in pSegments.
+ * @return               the number of bytes sent or negative
+ *                       error code.
+ */
+typedef int32_t (*uDeviceSerialWriteV_t)(struct uDeviceSerial_t *pDeviceSerial,
+                                         const uDeviceSerialSegment_t *pSegments,
+                                         size_t numSegments);
+
 /** Set a callback to be called when an event occurs on the serial
  * interface. pFunction will be called asynchronously in its own
  * task, for which the stack size and priority can be specified.
@@ -418,6 +445,7 @@ typedef struct uDeviceSerial_t {
     uDeviceSerialCtsResume_t ctsResume;
     uDeviceSerialDiscardOnOverflow_t discardOnOverflow;
     uDeviceSerialIsDiscardOnOverflowEnabled_t isDiscardOnOverflowEnabled;
+    uDeviceSerialWriteV_t writeV;
 } uDeviceSerial_t;
 
 /** The initialisation callback; this should populate the table
@@ -81,6 +81,41 @@ static int32_t serialDefaultWrite(struct uDeviceSerial_t *pDeviceSerial,
     return (int32_t) U_ERROR_COMMON_NOT_IMPLEMENTED;
 }
 
+// Note: unlike the other defaults this one does something useful,
+// calling the write() function of the device for each segment.
+static int32_t serialDefaultWriteV(struct uDeviceSerial_t *pDeviceSerial,
+                                   const uDeviceSerialSegment_t *pSegments,
+                                   size_t numSegments)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int32_t thisSizeOrErrorCode;
+    size_t sizeWritten = 0;
+
+    if ((pSegments != NULL) || (numSegments == 0)) {
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        for (size_t x = 0; (x < numSegments) && (sizeOrErrorCode >= 0); x++) {
+            if (pSegments[x].sizeBytes > 0) {
+                thisSizeOrErrorCode = pDeviceSerial->write(pDeviceSerial,
+                                                           pSegments[x].pData,
+                                                           pSegments[x].sizeBytes);
+                if (thisSizeOrErrorCode >= 0) {
+                    sizeWritten += thisSizeOrErrorCode;
+                    if ((size_t) thisSizeOrErrorCode < pSegments[x].sizeBytes) {
+                        break;
+                    }
+                } else {
+                    sizeOrErrorCode = thisSizeOrErrorCode;
+                }
+            }
+        }
+        if (sizeOrErrorCode >= 0) {
+            sizeOrErrorCode = (int32_t) sizeWritten;
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
 static int32_t serialDefaultEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
                                              uint32_t filter,
                                              void (*pFunction)(struct uDeviceSerial_t *,
@@ -176,6 +211,7 @@ static void init(uInterfaceTable_t pInterfaceTable, void *pInitParam)
     pDeviceSerial->ctsResume = serialDefaultVoid;
     pDeviceSerial->discardOnOverflow = serialDefaultDiscardOnOverflow;
     pDeviceSerial->isDiscardOnOverflowEnabled = serialDefaultBool;
+    pDeviceSerial->writeV = serialDefaultWriteV;
 
     if (pInit != NULL) {
         pInit(pInterfaceTable);
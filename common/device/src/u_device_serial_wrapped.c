@@ -144,6 +144,16 @@ static int32_t serialWrappedUartWrite(struct uDeviceSerial_t *pDeviceSerial,
     return uPortUartWrite(pContext->uartHandle, pBuffer, sizeBytes);
 }
 
+// Scatter-gather write to the virtual serial device, mapped to a real one.
+static int32_t serialWrappedUartWriteV(struct uDeviceSerial_t *pDeviceSerial,
+                                       const uDeviceSerialSegment_t *pSegments,
+                                       size_t numSegments)
+{
+    uDeviceSerialWrappedUartContext_t *pContext = (uDeviceSerialWrappedUartContext_t *)
+                                                  pUInterfaceContext(pDeviceSerial);
+    return uPortUartWriteV(pContext->uartHandle, pSegments, numSegments);
+}
+
 // Set an event callback on the virtual serial device, mapped to a real one.
 static int32_t serialWrappedUartEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
                                                  uint32_t filter,
@@ -313,6 +323,7 @@ static void init(uInterfaceTable_t pInterfaceTable, void *pInitParam)
     pDeviceSerial->ctsResume = serialWrappedUartCtsResume;
     pDeviceSerial->discardOnOverflow = serialWrappedUartDiscardOnOverflow;
     pDeviceSerial->isDiscardOnOverflowEnabled = serialWrappedUartIsDiscardOnOverflowEnabled;
+    pDeviceSerial->writeV = serialWrappedUartWriteV;
 
     *pContext = *((uDeviceSerialWrappedUartContext_t *) pInitParam);
     pContext->pDeviceSerial = pDeviceSerial;
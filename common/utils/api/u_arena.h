@@ -0,0 +1,162 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_ARENA_H_
+#define _U_ARENA_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __utils
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines an arena allocator API: an arena
+ * is created on a block of memory provided by the caller (static or
+ * on the stack) and allocations are made from it by simply moving
+ * an offset along; nothing is freed individually, instead all of
+ * the memory allocated since a mark was taken is returned in one go
+ * by uArenaRelease(), or all of it by uArenaReset().  This is
+ * intended for the short-lived buffers of a single transaction or
+ * decode, which would otherwise fragment the heap over time.
+ *
+ * Should the block be exhausted an allocation overflows onto the
+ * heap; such allocations are tracked by the arena and are freed by
+ * uArenaRelease()/uArenaReset() in the same way, so the caller need
+ * not care where the memory came from.  The statistics of an arena
+ * may be used to size the block so that this never happens.
+ *
+ * The API functions are NOT thread-safe: an arena should be used
+ * by one task at a time.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_ARENA_ALIGNMENT_BYTES
+/** The alignment of every allocation from an arena; must be
+ * a power of two.
+ */
+# define U_ARENA_ALIGNMENT_BYTES 8
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** An arena; the fields should be treated as read-only by
+ * the caller.
+ */
+typedef struct {
+    char *pBlock; /**< the start of the block, aligned. */
+    size_t size; /**< the usable size of the block. */
+    size_t offset; /**< the number of bytes of the block in use. */
+    size_t peakOffset; /**< the most bytes of the block that have been in use. */
+    void *pOverflowList; /**< allocations that overflowed onto the heap. */
+    int32_t overflowCount; /**< the number of allocations that overflowed. */
+    int32_t failedAllocCount; /**< the number of allocations that failed. */
+} uArena_t;
+
+/** A mark in an arena, see uArenaMark().
+ */
+typedef struct {
+    size_t offset;
+    void *pOverflowList;
+} uArenaMark_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Create an arena on a block of memory.  No memory is allocated
+ * by this function; the block must remain valid for as long as
+ * the arena is in use.
+ *
+ * @param[out] pArena  a pointer to the arena to initialise; cannot
+ *                     be NULL.
+ * @param[in] pBlock   the block of memory that allocations should
+ *                     be made from; need not be aligned.  May be
+ *                     NULL, in which case all allocations overflow
+ *                     onto the heap.
+ * @param size         the number of bytes at pBlock.
+ * @return             zero on success else negative error code.
+ */
+int32_t uArenaInit(uArena_t *pArena, void *pBlock, size_t size);
+
+/** Allocate memory from an arena.  The memory is aligned to
+ * #U_ARENA_ALIGNMENT_BYTES.  If pArena is NULL this is exactly
+ * pUPortMalloc(), allowing code to be written once for both
+ * cases; the memory should then be freed with uArenaFree().
+ *
+ * @param[in] pArena  a pointer to the arena; may be NULL.
+ * @param size        the number of bytes required.
+ * @return            a pointer to the memory or NULL if there
+ *                    is no memory available.
+ */
+void *pUArenaAlloc(uArena_t *pArena, size_t size);
+
+/** Free memory obtained from pUArenaAlloc().  If pArena is
+ * NULL this is exactly uPortFree(), otherwise it does nothing:
+ * the memory is returned by uArenaRelease() or uArenaReset().
+ *
+ * @param[in] pArena  a pointer to the arena that was passed
+ *                    to pUArenaAlloc(); may be NULL.
+ * @param[in] pMem    the memory to free; may be NULL.
+ */
+void uArenaFree(uArena_t *pArena, void *pMem);
+
+/** Take a mark in an arena, for use with uArenaRelease(),
+ * usually at the start of a scope.
+ *
+ * @param[in] pArena  a pointer to the arena; cannot be NULL.
+ * @return            the mark.
+ */
+uArenaMark_t uArenaMark(const uArena_t *pArena);
+
+/** Return all of the memory allocated from an arena since
+ * a mark was taken, usually at the end of a scope; marks must
+ * be released in the reverse order to that in which they were
+ * taken.
+ *
+ * @param[in] pArena  a pointer to the arena; cannot be NULL.
+ * @param mark        the mark, as returned by uArenaMark().
+ */
+void uArenaRelease(uArena_t *pArena, uArenaMark_t mark);
+
+/** Return all of the memory allocated from an arena; the
+ * statistics are retained.
+ *
+ * @param[in] pArena  a pointer to the arena; cannot be NULL.
+ */
+void uArenaReset(uArena_t *pArena);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_ARENA_H_
+
+// End of file
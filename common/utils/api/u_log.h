@@ -0,0 +1,277 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_LOG_H_
+#define _U_LOG_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __utils
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines leveled logging macros and a
+ * deferred log, which moves the cost of formatting a log print out
+ * of the calling task.
+ *
+ * The macros U_LOG_ERROR(), U_LOG_WARN(), U_LOG_INFO(), U_LOG_DEBUG()
+ * and U_LOG_VERBOSE() take the same parameters as uPortLog().  A
+ * module that uses them may set its own minimum level by defining
+ * U_LOG_MODULE_LEVEL before including this header file (normally to
+ * a U_CFG_LOG_LEVEL_XXX value that the user may override), otherwise
+ * #U_CFG_LOG_LEVEL applies.  A print below the minimum level, or any
+ * print if #U_CFG_ENABLE_LOGGING is 0, is compiled out entirely: its
+ * parameters are not even evaluated.
+ *
+ * If U_CFG_LOG_DEFERRED is defined then, once uLogDeferredInit() has
+ * been called, the prints that remain only store the format string
+ * pointer and the arguments in a ring buffer and a low priority task
+ * does the formatting and the output later; this takes the cost of
+ * logging off time-critical tasks such as those handling a UART or
+ * URCs.  Since the format string is stored as a pointer it must be a
+ * string literal, or at least must remain valid; the contents of "%s"
+ * arguments are copied.
+ *
+ * The file that includes this header must already have included
+ * "u_cfg_sw.h" and "u_port_debug.h".
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** Log level: nothing is printed.
+ */
+#define U_LOG_LEVEL_NONE    0
+
+/** Log level: errors only.
+ */
+#define U_LOG_LEVEL_ERROR   1
+
+/** Log level: warnings and errors.
+ */
+#define U_LOG_LEVEL_WARN    2
+
+/** Log level: information that is normally printed.
+ */
+#define U_LOG_LEVEL_INFO    3
+
+/** Log level: debug information, printed by default.
+ */
+#define U_LOG_LEVEL_DEBUG   4
+
+/** Log level: everything.
+ */
+#define U_LOG_LEVEL_VERBOSE 5
+
+#ifndef U_CFG_LOG_LEVEL
+/** The minimum log level for any module that does not set its own
+ * with U_LOG_MODULE_LEVEL; the default keeps everything that ubxlib
+ * has always printed.
+ */
+# define U_CFG_LOG_LEVEL U_LOG_LEVEL_DEBUG
+#endif
+
+#ifndef U_LOG_MODULE_LEVEL
+/** The minimum log level of the module including this header file;
+ * define it before including this header file to override it.
+ */
+# define U_LOG_MODULE_LEVEL U_CFG_LOG_LEVEL
+#endif
+
+#ifndef U_LOG_DEFERRED_BUFFER_LENGTH_BYTES
+/** The size of the ring buffer used by the deferred log.
+ */
+# define U_LOG_DEFERRED_BUFFER_LENGTH_BYTES 2048
+#endif
+
+#ifndef U_LOG_DEFERRED_RECORD_MAX_LENGTH_BYTES
+/** The maximum size of a single record in the deferred log: the
+ * format string pointer plus all of the arguments, including the
+ * copied contents of any "%s" arguments; arguments that do not
+ * fit are not printed.  This much is needed on the stack of any
+ * task that logs.
+ */
+# define U_LOG_DEFERRED_RECORD_MAX_LENGTH_BYTES 128
+#endif
+
+#ifndef U_LOG_DEFERRED_STRING_MAX_LENGTH_BYTES
+/** The maximum number of characters of a "%s" argument that is
+ * copied into the deferred log.
+ */
+# define U_LOG_DEFERRED_STRING_MAX_LENGTH_BYTES 64
+#endif
+
+#ifndef U_LOG_DEFERRED_LINE_MAX_LENGTH_BYTES
+/** The size of the buffer the deferred log formats a record into;
+ * a print that is longer is output in more than one piece.
+ */
+# define U_LOG_DEFERRED_LINE_MAX_LENGTH_BYTES 128
+#endif
+
+#ifndef U_LOG_DEFERRED_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that formats the deferred log.
+ */
+# define U_LOG_DEFERRED_TASK_STACK_SIZE_BYTES 2304
+#endif
+
+#ifndef U_LOG_DEFERRED_TASK_PRIORITY
+/** The priority of the task that formats the deferred log: low,
+ * so that logging does not get in the way.
+ */
+# define U_LOG_DEFERRED_TASK_PRIORITY (U_CFG_OS_PRIORITY_MIN + 1)
+#endif
+
+/** Evaluates to true if a print at the given level is compiled in
+ * for the module including this header file; since it is a constant
+ * it may be used to compile out code that only exists to prepare
+ * a log print.
+ */
+#if U_CFG_ENABLE_LOGGING
+# define U_LOG_IS_ENABLED(level) ((level) <= U_LOG_MODULE_LEVEL)
+#else
+# define U_LOG_IS_ENABLED(level) 0
+#endif
+
+/** The function that a print that is compiled in ends up calling.
+ */
+#ifdef U_CFG_LOG_DEFERRED
+# define U_LOG_OUTPUT(format, ...) \
+             /*lint -e{507} suppress size incompatibility warnings in printf() */ \
+             uLogDeferred(format, ##__VA_ARGS__)
+#else
+# define U_LOG_OUTPUT(format, ...) \
+             /*lint -e{507} suppress size incompatibility warnings in printf() */ \
+             uPortLogF(format, ##__VA_ARGS__)
+#endif
+
+/** Print at the given level; the constant condition is removed by
+ * the compiler so that, where the level is below the minimum, no
+ * code is generated.
+ */
+#define U_LOG_AT_LEVEL(level, format, ...)                 \
+    do {                                                   \
+        if (U_LOG_IS_ENABLED(level)) {                     \
+            U_LOG_OUTPUT(format, ##__VA_ARGS__);           \
+        }                                                  \
+    } while (0)
+
+/** Print an error.
+ */
+#define U_LOG_ERROR(format, ...) U_LOG_AT_LEVEL(U_LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+
+/** Print a warning.
+ */
+#define U_LOG_WARN(format, ...) U_LOG_AT_LEVEL(U_LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+
+/** Print information.
+ */
+#define U_LOG_INFO(format, ...) U_LOG_AT_LEVEL(U_LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+
+/** Print debug information.
+ */
+#define U_LOG_DEBUG(format, ...) U_LOG_AT_LEVEL(U_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+
+/** Print verbose debug information.
+ */
+#define U_LOG_VERBOSE(format, ...) U_LOG_AT_LEVEL(U_LOG_LEVEL_VERBOSE, format, ##__VA_ARGS__)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The function that the deferred log calls to output formatted
+ * text.
+ *
+ * @param[in] pString  the null-terminated text, which will often
+ *                     be a whole line but may be part of one.
+ * @param[in] pParam   the parameter passed to uLogDeferredInit().
+ */
+typedef void (*uLogDeferredOutput_t)(const char *pString, void *pParam);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Start the deferred log: allocates a ring buffer of
+ * #U_LOG_DEFERRED_BUFFER_LENGTH_BYTES and starts the task that
+ * formats what is put into it.  If the deferred log is already
+ * running this does nothing.
+ *
+ * @param[in] pOutput  the function to output the formatted text;
+ *                     use NULL to output it with uPortLog().
+ * @param[in] pParam   a parameter that will be passed to pOutput;
+ *                     may be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uLogDeferredInit(uLogDeferredOutput_t pOutput, void *pParam);
+
+/** Stop the deferred log, outputting anything it contains first.
+ * Nothing may be calling uLogDeferred() at the same time.
+ */
+void uLogDeferredDeinit();
+
+/** printf()-style deferred logging; this is not usually called
+ * directly, use the U_LOG_XXX() macros with U_CFG_LOG_DEFERRED
+ * defined instead.  The format string is scanned for its arguments,
+ * which are stored, along with the format string pointer, in the
+ * ring buffer of the deferred log; if there is no room the print
+ * is lost.  If uLogDeferredInit() has not been called the print is
+ * formatted and output with uPortLog() immediately.  This does not
+ * support "%n" or wide characters and it must not be called from
+ * an interrupt.
+ *
+ * @param[in] pFormat a printf() style format string, which must
+ *                    remain valid until it has been output,
+ *                    e.g. a string literal.
+ * @param ...         variable argument list.
+ */
+void uLogDeferred(const char *pFormat, ...);
+
+/** Wait until everything that has been put into the deferred log
+ * has been output.
+ *
+ * @param timeoutMs  the maximum time to wait in milliseconds.
+ * @return           zero on success, else negative error code, e.g.
+ *                   #U_ERROR_COMMON_TIMEOUT.
+ */
+int32_t uLogDeferredFlush(int32_t timeoutMs);
+
+/** Get the number of prints that have been lost by the deferred log
+ * because there was no room for them; the count is also output by
+ * the deferred log whenever it increases.
+ *
+ * @return the number of prints lost since uLogDeferredInit().
+ */
+int32_t uLogDeferredGetNumLost();
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_LOG_H_
+
+// End of file
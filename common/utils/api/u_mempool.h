@@ -29,8 +29,18 @@
 /** @file
  * @brief This header file defines a memory pool API, used internally by the short range
  * API for efficient EDM transport.  The API functions are thread-safe except for the
- * uMemPoolInit() and uMemPoolDeinit() APIs, which should not be called while any
- * of the other API calls are in progress.
+ * uMemPoolInit(), uMemPoolDeinit() and uMemPoolFreeAllMem() APIs, which should not be
+ * called while any of the other API calls are in progress.  Allocating and freeing a
+ * block does not take a mutex: the free list is lock-free, held as an index into the
+ * pool plus a tag which changes on every update, so that a block being freed and
+ * allocated again while another thread is part way through an update is detected;
+ * where the compiler does not support acquire/release atomics (MSVC) the free list
+ * is instead protected by the mutex of the pool.  A pool may hold at most
+ * #U_MEMPOOL_MAX_NUM_BLOCKS blocks.
+ *
+ * Also defined here is a facade over a set of pools of increasing block size,
+ * uMemPoolClasses_t, so that buffers of different sizes may come from one
+ * allocator.
  */
 #ifdef __cplusplus
 extern "C" {
@@ -40,6 +50,17 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The maximum number of blocks in a pool: the free list head
+ * holds a block index in 16 bits, the rest being the tag.
+ */
+#define U_MEMPOOL_MAX_NUM_BLOCKS 0xFFFF
+
+#ifndef U_MEMPOOL_CLASSES_MAX_NUM
+/** The maximum number of size classes in a #uMemPoolClasses_t.
+ */
+# define U_MEMPOOL_CLASSES_MAX_NUM 4
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -48,11 +69,33 @@ typedef struct {
     uint32_t blockSize; /**< the size of each block. */
     int32_t usedBlockCount; /**< the number of currently used blocks. */
     int32_t totalBlockCount; /**< the total number of blocks. */
-    struct uMemPoolFree *pFreeList; /**< linked list of free blocks. */
+    int32_t peakUsedBlockCount; /**< the high-water mark of usedBlockCount. */
+    int32_t failedAllocCount; /**< the number of allocations that failed. */
+    uint32_t freeHead; /**< the free list: tag in the upper 16 bits, index
+                            of the first free block in the lower 16 bits. */
     uint8_t *pBuffer; /**< data buffer (sub-divided into blocks). */
-    uPortMutexHandle_t mutex; /**< mutex for thread protection. */
+    uPortMutexHandle_t mutex; /**< mutex protecting creation of the data buffer. */
 } uMemPoolDesc_t;
 
+/** Statistics for a memory pool, see uMemPoolStatsGet().
+ */
+typedef struct {
+    uint32_t blockSize; /**< the size of each block. */
+    int32_t totalBlockCount; /**< the total number of blocks. */
+    int32_t usedBlockCount; /**< the number of currently used blocks. */
+    int32_t peakUsedBlockCount; /**< the most blocks that have been in use at once. */
+    int32_t failedAllocCount; /**< the number of allocations that failed. */
+} uMemPoolStats_t;
+
+/** A set of memory pools of increasing block size: an allocation
+ * comes from the pool of the smallest block size that will fit
+ * it or, if that pool is exhausted, the next one up.
+ */
+typedef struct {
+    size_t numClasses; /**< the number of entries in pool[] that are in use. */
+    uMemPoolDesc_t pool[U_MEMPOOL_CLASSES_MAX_NUM]; /**< the pools, smallest first. */
+} uMemPoolClasses_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -98,6 +141,51 @@ void uMemPoolFreeMem(uMemPoolDesc_t *pMemPool, void *ptr);
  */
 void uMemPoolFreeAllMem(uMemPoolDesc_t *pMemPool);
 
+/** Get the statistics of a memory pool.
+ *
+ * @param pMemPool      pointer to the memory pool.
+ * @param pStats        a place to put the statistics.
+ * @return              zero on success else negative error code.
+ */
+int32_t uMemPoolStatsGet(const uMemPoolDesc_t *pMemPool, uMemPoolStats_t *pStats);
+
+/** Initialise a set of memory pools, one per size class.
+ *
+ * @param pClasses      pointer to an empty set of memory pools.
+ * @param pBlockSize    the block size of each class, smallest first.
+ * @param pNumOfBlks    the number of blocks in each class.
+ * @param numClasses    the number of entries at pBlockSize and at
+ *                      pNumOfBlks; may be no more than
+ *                      #U_MEMPOOL_CLASSES_MAX_NUM.
+ * @return              zero on success else negative error code.
+ */
+int32_t uMemPoolClassesInit(uMemPoolClasses_t *pClasses,
+                            const uint32_t *pBlockSize,
+                            const int32_t *pNumOfBlks,
+                            size_t numClasses);
+
+/** Deinitialise a set of memory pools, freeing all of them.
+ *
+ * @param pClasses      pointer to the set of memory pools.
+ */
+void uMemPoolClassesDeinit(uMemPoolClasses_t *pClasses);
+
+/** Allocate memory from a set of memory pools.
+ *
+ * @param pClasses      pointer to the set of memory pools.
+ * @param size          the number of bytes required.
+ * @return              pointer to the block or NULL if there is
+ *                      no free block big enough.
+ */
+void *uMemPoolClassesAllocMem(uMemPoolClasses_t *pClasses, size_t size);
+
+/** Free memory allocated from a set of memory pools.
+ *
+ * @param pClasses      pointer to the set of memory pools.
+ * @param ptr           pointer to the block that need to be freed.
+ */
+void uMemPoolClassesFreeMem(uMemPoolClasses_t *pClasses, void *ptr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,6 +40,11 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The maximum number of spans that may be needed to describe
+ * a contiguous region of a ring buffer, see uRingBufferSpan_t.
+ */
+#define U_RING_BUFFER_SPAN_MAX_NUM 2
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -74,6 +79,11 @@ typedef struct {
     size_t maxNumReadPointers;      /**< will always be at least 1 for the
                                          "normal" read case. */
     uint64_t dataReadLockBitmap;
+    uint64_t spanReadLockBitmap;    /**< the read handles locked by
+                                         uRingBufferReadSpanAcquireHandle()
+                                         rather than by the caller, to be
+                                         unlocked again by
+                                         uRingBufferReadSpanCommitHandle(). */
     bool isMalloced;                /**< true if pDataRead was allocated. */
     char *pDataWrite;
     size_t size;
@@ -99,8 +109,21 @@ typedef struct {
                                          as a result of add or forced add
                                          being unable to write into the
                                          ring buffer. */
+    bool isLockFree;                /**< true if the ring buffer was created
+                                         with uRingBufferCreateLockFree(). */
 } uRingBuffer_t;
 
+/** A linear span of a ring buffer, as returned by
+ * uRingBufferWriteSpanAcquire(), uRingBufferReadSpanAcquire()
+ * etc.; always used in arrays of #U_RING_BUFFER_SPAN_MAX_NUM
+ * since a region of a ring buffer may wrap.
+ */
+typedef struct {
+    char *pData;   /**< pointer to the start of the span, NULL if
+                        the span is empty. */
+    size_t length; /**< the length of the span in bytes. */
+} uRingBufferSpan_t;
+
 typedef void *uParseHandle_t; //!< Parser handle.
 
 /** Parser function prototype, used with uRingBufferParseHandle().
@@ -113,6 +136,19 @@ typedef void *uParseHandle_t; //!< Parser handle.
  */
 typedef int32_t (*U_RING_BUFFER_PARSER_f)(uParseHandle_t parseHandle, void *pUserParam);
 
+/** A record of a single complete message found by
+ * uRingBufferParseBatchHandle().
+ */
+typedef struct {
+    size_t offset;       /**< the offset of the start of the message
+                              from the read pointer of the handle at
+                              the time uRingBufferParseBatchHandle()
+                              was called. */
+    size_t length;       /**< the length of the message in bytes. */
+    int32_t parserIndex; /**< the index of the parser in the parser
+                              list which found the message. */
+} uRingBufferParseRecord_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -148,6 +184,46 @@ void uRingBufferDump(uRingBuffer_t *pRingBuffer);
 int32_t uRingBufferCreate(uRingBuffer_t *pRingBuffer, char *pLinearBuffer,
                           size_t size);
 
+/** Create a new ring buffer from a linear buffer for the case where
+ * there is a single producer (one task calling uRingBufferAdd())
+ * and a single consumer (one task calling uRingBufferRead()); in this
+ * case no mutex is taken on the data path: the read and write
+ * pointers are passed between the two tasks using acquire/release
+ * atomic operations.
+ *
+ * For a ring buffer created in this way:
+ *
+ * - uRingBufferAdd(), uRingBufferWriteSpanAcquire(),
+ *   uRingBufferWriteSpanCommit() and uRingBufferStatAddLoss() may
+ *   only be called by the producer,
+ * - uRingBufferRead(), uRingBufferPeek(), uRingBufferFlush(),
+ *   uRingBufferFlushValue(), uRingBufferReadSpanAcquire(),
+ *   uRingBufferReadSpanCommit() and uRingBufferParseHandle() (with
+ *   a handle of 0) may only be called by the consumer,
+ * - uRingBufferDataSize() and uRingBufferAvailableSize() may be
+ *   called by either,
+ * - uRingBufferForceAdd() and uRingBufferForceWriteSpanAcquire() will
+ *   NOT move the read pointer on, since it belongs to the consumer,
+ *   i.e. they behave as uRingBufferAdd() and
+ *   uRingBufferWriteSpanAcquire(),
+ * - uRingBufferReset() and uRingBufferDelete() must only be
+ *   called when neither producer nor consumer is active.
+ *
+ * Read handles are not supported.  Note that, where the compiler
+ * does not support acquire/release atomics (MSVC), this is the
+ * same as calling uRingBufferCreate().
+ *
+ * @param[in] pRingBuffer   a pointer to a ring buffer, cannot be NULL.
+ * @param[in] pLinearBuffer a pointer to the linear buffer.
+ * @param size              the size of the linear buffer in bytes; the
+ *                          ring buffer will be of maximum size this
+ *                          number minus one as one byte is used to
+ *                          prevent pointer-wrap.
+ * @return                  zero on success else negative error code.
+ */
+int32_t uRingBufferCreateLockFree(uRingBuffer_t *pRingBuffer, char *pLinearBuffer,
+                                  size_t size);
+
 /** Delete a ring buffer.
  *
  * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
@@ -455,6 +531,132 @@ void uRingBufferFlushHandle(uRingBuffer_t *pRingBuffer, int32_t handle);
 size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
                                      int32_t handle);
 
+/* ----------------------------------------------------------------
+ * FUNCTIONS: SPANS
+ * -------------------------------------------------------------- */
+
+/** Get direct access to the free space in a ring buffer, so that data
+ * can be written into it in place (e.g. by a UART driver) rather than
+ * being copied in with uRingBufferAdd().  The free space is returned as
+ * up to two spans, the second being used if the free space wraps
+ * around the end of the linear buffer.  Once data has been written
+ * to the spans, call uRingBufferWriteSpanCommit() to make it
+ * available to readers; nothing is available to readers until then.
+ *
+ * There must only be one writer to a ring buffer while a write span
+ * is acquired, i.e. no calls to uRingBufferAdd()/uRingBufferForceAdd()
+ * or another acquire until uRingBufferWriteSpanCommit() has been
+ * called.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param[out] pSpans     a pointer to an array of
+ *                        #U_RING_BUFFER_SPAN_MAX_NUM spans, cannot
+ *                        be NULL.
+ * @return                the total length of the spans, which will be
+ *                        the same as uRingBufferAvailableSize().
+ */
+size_t uRingBufferWriteSpanAcquire(uRingBuffer_t *pRingBuffer,
+                                   uRingBufferSpan_t *pSpans);
+
+/** As uRingBufferWriteSpanAcquire() but, like uRingBufferForceAdd(),
+ * moves any non-locked read pointers on so that there are at least
+ * length bytes of free space in the spans.  Data is lost from the
+ * ring buffer at the point of this call, not on commit.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param length          the amount of free space required.
+ * @param[out] pSpans     a pointer to an array of
+ *                        #U_RING_BUFFER_SPAN_MAX_NUM spans, cannot
+ *                        be NULL.
+ * @return                the total length of the spans, which will be
+ *                        at least length or zero if it was not
+ *                        possible to create that much free space.
+ */
+size_t uRingBufferForceWriteSpanAcquire(uRingBuffer_t *pRingBuffer,
+                                        size_t length,
+                                        uRingBufferSpan_t *pSpans);
+
+/** Commit data that has been written into the spans returned by
+ * uRingBufferWriteSpanAcquire() or uRingBufferForceWriteSpanAcquire(),
+ * making it available to readers.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param length          the number of bytes written, starting at
+ *                        the first span and continuing into the
+ *                        second.
+ * @return                the number of bytes committed, which may be
+ *                        less than length if length is greater than
+ *                        the free space in the ring buffer.
+ */
+size_t uRingBufferWriteSpanCommit(uRingBuffer_t *pRingBuffer, size_t length);
+
+/** Get direct access to the data at the "normal" read pointer (i.e.
+ * that which would be returned by uRingBufferRead()) without copying
+ * it; up to two spans are returned, the second being used if the data
+ * wraps around the end of the linear buffer.  Once the data has been
+ * consumed, call uRingBufferReadSpanCommit() to move the read
+ * pointer on.  Note that uRingBufferForceAdd() may overwrite the
+ * data in the spans while they are acquired; if that is a problem,
+ * use uRingBufferReadSpanAcquireHandle().
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param[out] pSpans     a pointer to an array of
+ *                        #U_RING_BUFFER_SPAN_MAX_NUM spans, cannot
+ *                        be NULL.
+ * @return                the total length of the spans, which will be
+ *                        the same as uRingBufferDataSize().
+ */
+size_t uRingBufferReadSpanAcquire(uRingBuffer_t *pRingBuffer,
+                                  uRingBufferSpan_t *pSpans);
+
+/** Move the "normal" read pointer on after data acquired with
+ * uRingBufferReadSpanAcquire() has been consumed.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param length          the number of bytes consumed.
+ * @return                the number of bytes by which the read pointer
+ *                        was moved on.
+ */
+size_t uRingBufferReadSpanCommit(uRingBuffer_t *pRingBuffer, size_t length);
+
+/** Like uRingBufferReadSpanAcquire() but for an entity that has
+ * previously obtained a read handle by calling
+ * uRingBufferTakeReadHandle().  The read handle is locked, as if
+ * uRingBufferLockReadHandle() had been called, so that
+ * uRingBufferForceAdd() cannot overwrite the data in the spans; it
+ * is unlocked again by uRingBufferReadSpanCommitHandle(), which
+ * MUST be called, even if no data is consumed.  If the read handle
+ * was already locked with uRingBufferLockReadHandle() it remains
+ * locked.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param handle          a read handle, as originally returned by
+ *                        uRingBufferTakeReadHandle().
+ * @param[out] pSpans     a pointer to an array of
+ *                        #U_RING_BUFFER_SPAN_MAX_NUM spans, cannot
+ *                        be NULL.
+ * @return                the total length of the spans, which will be
+ *                        the same as uRingBufferDataSizeHandle().
+ */
+size_t uRingBufferReadSpanAcquireHandle(uRingBuffer_t *pRingBuffer,
+                                        int32_t handle,
+                                        uRingBufferSpan_t *pSpans);
+
+/** Move the read pointer of a read handle on after data acquired with
+ * uRingBufferReadSpanAcquireHandle() has been consumed, and unlock
+ * the read handle unless it was locked before
+ * uRingBufferReadSpanAcquireHandle() was called.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param handle          a read handle, as originally returned by
+ *                        uRingBufferTakeReadHandle().
+ * @param length          the number of bytes consumed, may be zero.
+ * @return                the number of bytes by which the read pointer
+ *                        was moved on.
+ */
+size_t uRingBufferReadSpanCommitHandle(uRingBuffer_t *pRingBuffer,
+                                       int32_t handle, size_t length);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: PARSER
  * -------------------------------------------------------------- */
@@ -473,6 +675,69 @@ size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
 size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
                               U_RING_BUFFER_PARSER_f *pParserList, void *pUserParam);
 
+/** Run a set of parsers over the contents of the ring buffer, in
+ * a single pass, returning a record of every complete message
+ * found.  This is a batched version of uRingBufferParseHandle():
+ * where that function has to be called once per message, each call
+ * re-taking the lock and re-scanning from the read pointer, this
+ * function walks the buffered data once and fills in pRecords with
+ * the offset, length and parser index of each complete message, in
+ * the order they appear.  Any bytes between records are ones that
+ * no parser recognised (i.e. junk) and may be discarded by the
+ * caller.  Nothing is read from the ring buffer: the caller reads,
+ * or discards, the data afterwards, e.g. with uRingBufferReadHandle().
+ *
+ * Parsing stops when all of the buffered data has been consumed,
+ * when a parser returns #U_ERROR_COMMON_TIMEOUT (i.e. there is the
+ * start of a message which is not yet complete), or when
+ * maxNumRecords have been found; the offset at which parsing stopped
+ * is returned in *pOffsetEnd, hence if *pOffsetEnd is less than the
+ * amount of data available for the handle then there is a partial
+ * message, starting at *pOffsetEnd, which the caller should leave
+ * in place.
+ *
+ * Since each parser is called with the number of bytes discarded
+ * set to zero, uRingBufferBytesDiscardUnprotected() will always
+ * return zero when called from a parser that is being run by this
+ * function.
+ *
+ * Note that, if the ring buffer is written-to with
+ * uRingBufferForceAdd() while the caller is processing the records,
+ * the read pointer of the handle may be moved on, invalidating the
+ * records; in that case the caller should use uRingBufferLockReadHandle()
+ * to prevent this.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param handle            a read handle, as originally returned by
+ *                          uRingBufferTakeReadHandle().
+ * @param[in] pParserList   a pointer to a list of parsers, terminated by
+ *                          a NULL pointer.
+ * @param[in] pUserParams   a user parameter to pass to each parser in the
+ *                          list; if userParamSize is non-zero this is
+ *                          taken to be an array of maxNumRecords user
+ *                          parameters, each of userParamSize bytes, and
+ *                          the parser that finds record n will have
+ *                          been passed entry n of the array; if
+ *                          userParamSize is zero the same user
+ *                          parameter is passed for every record.
+ * @param userParamSize     the size of each entry in pUserParams, may be
+ *                          zero.
+ * @param[out] pRecords     a pointer to an array of maxNumRecords records,
+ *                          cannot be NULL.
+ * @param maxNumRecords     the number of entries at pRecords.
+ * @param[out] pOffsetEnd   a pointer to a place to put the offset from
+ *                          the read pointer of the handle up to which
+ *                          all data has been accounted for, either as
+ *                          records or as junk; may be NULL.
+ * @return                  on success the number of records written
+ *                          to pRecords, else negative error code.
+ */
+int32_t uRingBufferParseBatchHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                    U_RING_BUFFER_PARSER_f *pParserList,
+                                    void *pUserParams, size_t userParamSize,
+                                    uRingBufferParseRecord_t *pRecords,
+                                    size_t maxNumRecords, size_t *pOffsetEnd);
+
 /** Get a byte from the ring buffer while in a parser function.
  *
  * IMPORTANT: unlike all of the other ring-buffer functions, this function
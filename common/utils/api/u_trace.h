@@ -0,0 +1,276 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_TRACE_H_
+#define _U_TRACE_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __utils
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines a low-overhead binary trace API.
+ *
+ * At the bottom is a trace ring: a power-of-two number of fixed-size
+ * entries, each carrying a 32-bit event, a 32-bit parameter and a
+ * microsecond time-stamp, which any number of tasks (or interrupts)
+ * may write to at the same time without a mutex.  A writer reserves
+ * an entry by atomically incrementing a reserve index, fills it in
+ * and then publishes it by writing the entry's sequence stamp; a
+ * reader uses the stamp to tell a complete entry from one that is
+ * being written or has since been overwritten, so it never returns
+ * a mangled entry.  When the ring is full the oldest entries are
+ * overwritten.  The ring is laid out as a #uTraceRing_t header
+ * followed immediately by the entries so that the memory of the
+ * ring, e.g. captured with a debugger, can be decoded offline.
+ *
+ * On top of that is a single global trace used by the core code
+ * to record AT client transactions, ring buffer fills and GNSS
+ * message dispatch: the U_TRACE_BEGIN(), U_TRACE_END(), etc.
+ * macros compile to nothing unless U_CFG_TRACE is defined and,
+ * where they are compiled in, do nothing until uTraceInit() has
+ * been called.  The output of uTraceDump() may be converted to a
+ * Chrome trace (view it at https://ui.perfetto.dev or
+ * chrome://tracing) with u_trace_decode.py, which can be found in
+ * the same directory as this file.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifndef U_TRACE_ENTRIES_MAX_NUM
+/** The number of entries in the global trace if uTraceInit()
+ * is asked to allocate the memory for it; must be a power of two.
+ */
+# define U_TRACE_ENTRIES_MAX_NUM 256
+#endif
+
+/** Increment this if you change #uTraceRing_t, #uTraceEntry_t or
+ * the way events are encoded by uTrace(); u_trace_decode.py should
+ * be updated to match.
+ */
+#define U_TRACE_VERSION 1
+
+/** The number of bytes of memory required for a trace ring with
+ * the given number of entries.
+ */
+#define U_TRACE_RING_SIZE(numEntries) (sizeof(uTraceRing_t) +                \
+                                       (sizeof(uTraceEntry_t) * (numEntries)))
+
+#ifdef U_CFG_TRACE
+/** Mark the start of something that takes time in the global trace.
+ */
+# define U_TRACE_BEGIN(event, parameter) uTrace(U_TRACE_PHASE_BEGIN, event, parameter)
+/** Mark the end of something begun with U_TRACE_BEGIN().
+ */
+# define U_TRACE_END(event, parameter) uTrace(U_TRACE_PHASE_END, event, parameter)
+/** Mark something that happened at a single instant in the global trace.
+ */
+# define U_TRACE_INSTANT(event, parameter) uTrace(U_TRACE_PHASE_INSTANT, event, parameter)
+/** Record the value of a counter in the global trace.
+ */
+# define U_TRACE_COUNTER(event, parameter) uTrace(U_TRACE_PHASE_COUNTER, event, parameter)
+#else
+# define U_TRACE_BEGIN(event, parameter)
+# define U_TRACE_END(event, parameter)
+# define U_TRACE_INSTANT(event, parameter)
+# define U_TRACE_COUNTER(event, parameter)
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The kind of thing an event in the global trace represents;
+ * the values match the way Chrome trace events are drawn.
+ */
+typedef enum {
+    U_TRACE_PHASE_INSTANT = 0,
+    U_TRACE_PHASE_BEGIN = 1,
+    U_TRACE_PHASE_END = 2,
+    U_TRACE_PHASE_COUNTER = 3
+} uTracePhase_t;
+
+/** The events of the global trace.  u_trace_decode.py reads the
+ * names from this enum so just add new events to the end, before
+ * the user events, and they will be decoded.  At most 16384 events
+ * are possible.
+ */
+typedef enum {
+    U_TRACE_EVENT_NONE = 0,
+    U_TRACE_EVENT_START,
+    U_TRACE_EVENT_AT_CLIENT_TRANSACTION, /**< parameter: the stream handle at the
+                                              start, the error code at the end. */
+    U_TRACE_EVENT_AT_CLIENT_BUFFER_FILL, /**< parameter: the number of bytes read. */
+    U_TRACE_EVENT_GNSS_RING_BUFFER_FILL, /**< parameter: the number of bytes read. */
+    U_TRACE_EVENT_GNSS_MSG_DISPATCH, /**< parameter: at the start, the UBX class/ID (in
+                                          the upper/lower byte) or the protocol type of
+                                          the message shifted up by 16; at the end, the
+                                          length of the message. */
+    U_TRACE_EVENT_USER_0,
+    U_TRACE_EVENT_USER_1,
+    U_TRACE_EVENT_USER_2,
+    U_TRACE_EVENT_USER_3
+} uTraceEvent_t;
+
+/** An entry in a trace ring; all fields are 32 bits wide so that
+ * a dump is easy to decode on another platform.
+ */
+typedef struct {
+    uint32_t sequence; /**< one more than the index of the entry
+                            when it was written, zero while it is
+                            being written. */
+    uint32_t timeUs; /**< uPortGetTickTimeUs() when it was written. */
+    uint32_t event; /**< the event; for the global trace this is the
+                         phase in the upper two bits, the event in the
+                         next 14 bits and a tag identifying the task
+                         in the lower 16 bits. */
+    int32_t parameter; /**< the parameter that came with the event. */
+} uTraceEntry_t;
+
+/** The header of a trace ring, followed in memory by the entries.
+ */
+typedef struct {
+    uint32_t magicWord;
+    uint32_t version;
+    uint32_t numEntries; /**< always a power of two. */
+    uint32_t reserveIndex; /**< the index of the next entry to be written. */
+} uTraceRing_t;
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: TRACE RING
+ * -------------------------------------------------------------- */
+
+/** Create a trace ring in a block of memory.
+ *
+ * @param[in] pRing        the memory for the trace ring, which must be
+ *                         at least U_TRACE_RING_SIZE(numEntries) bytes
+ *                         and aligned to 4 bytes; cannot be NULL.
+ * @param numEntries       the number of entries, must be a power of two.
+ * @param keepContents     if true and pRing already contains a trace
+ *                         ring of the same size and version, e.g.
+ *                         because it is in RAM that is not initialised
+ *                         at reset, then the entries are kept.
+ * @return                 zero on success else negative error code.
+ */
+int32_t uTraceRingInit(void *pRing, size_t numEntries, bool keepContents);
+
+/** Write an entry to a trace ring.  This may be called by any number
+ * of tasks at the same time, takes no mutex and does not block.
+ *
+ * @param[in] pRing     the trace ring, as passed to uTraceRingInit();
+ *                      may be NULL, in which case nothing happens.
+ * @param event         the event.
+ * @param parameter     the parameter.
+ */
+void uTraceRingWrite(void *pRing, uint32_t event, int32_t parameter);
+
+/** Read entries from a trace ring, in the order they were reserved,
+ * starting at a given sequence number.  This does not remove the
+ * entries from the ring and it does not interfere with writers;
+ * if more than one task is to read the same ring, each should
+ * keep its own sequence number.  Entries that have been overwritten
+ * since the sequence number was last updated are skipped, as are
+ * entries that were overwritten while they were being read; reading
+ * stops at an entry that is still being written.
+ *
+ * @param[in] pRing          the trace ring; cannot be NULL.
+ * @param[in,out] pSequence  a pointer to the index of the next entry to
+ *                           read, zero at the start, which is updated
+ *                           to follow the entries read; cannot be NULL.
+ * @param[out] pEntries      a place to put the entries; cannot be NULL.
+ * @param numEntries         the number of entries at pEntries.
+ * @param[out] pNumLost      a place to put the number of entries that
+ *                           were skipped; may be NULL.
+ * @return                   the number of entries read.
+ */
+size_t uTraceRingRead(const void *pRing, uint32_t *pSequence,
+                      uTraceEntry_t *pEntries, size_t numEntries,
+                      size_t *pNumLost);
+
+/** Get the number of entries in a trace ring that have not yet
+ * been read, including any that will turn out to be lost.
+ *
+ * @param[in] pRing    the trace ring; cannot be NULL.
+ * @param sequence     the index of the next entry to read, as
+ *                     updated by uTraceRingRead().
+ * @return             the number of unread entries.
+ */
+size_t uTraceRingGetNumEntries(const void *pRing, uint32_t sequence);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: GLOBAL TRACE
+ * -------------------------------------------------------------- */
+
+/** Start the global trace.  Note that this is not thread-safe
+ * with respect to uTraceDeinit().
+ *
+ * @param[in] pBuffer  memory for the global trace, aligned to 4 bytes;
+ *                     if NULL then U_TRACE_RING_SIZE(U_TRACE_ENTRIES_MAX_NUM)
+ *                     bytes will be allocated, and free'ed by
+ *                     uTraceDeinit().
+ * @param size         the number of bytes at pBuffer; the number of
+ *                     entries is the largest power of two that fits.
+ *                     Ignored if pBuffer is NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uTraceInit(void *pBuffer, size_t size);
+
+/** Stop the global trace.  Anything still calling uTrace() must
+ * have finished before this is called.
+ */
+void uTraceDeinit();
+
+/** Write an event to the global trace; you would normally use
+ * U_TRACE_BEGIN(), U_TRACE_END(), U_TRACE_INSTANT() or
+ * U_TRACE_COUNTER(), which compile to nothing unless U_CFG_TRACE
+ * is defined, rather than calling this directly.  Does nothing
+ * if uTraceInit() has not been called.
+ *
+ * @param phase      the phase.
+ * @param event      the event.
+ * @param parameter  the parameter.
+ */
+void uTrace(uTracePhase_t phase, uTraceEvent_t event, int32_t parameter);
+
+/** Print the contents of the global trace using uPortLog(), one line
+ * per entry, in the form expected by u_trace_decode.py.  The entries
+ * are not removed.
+ *
+ * @return the number of entries printed, or negative error code
+ *         if uTraceInit() has not been called.
+ */
+int32_t uTraceDump();
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_TRACE_H_
+
+// End of file
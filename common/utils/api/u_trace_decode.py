@@ -0,0 +1,210 @@
+#!/usr/bin/env python
+
+'''Convert a ubxlib binary trace into a Chrome trace JSON file.'''
+
+import os
+import sys # For exit() and stdout
+import re
+import json
+import struct
+import argparse
+
+# This script reads the output of uTraceDump(), as captured in a
+# log file, or the raw memory of a trace ring (a uTraceRing_t header
+# followed by the entries, e.g. saved from a debugger) and writes a
+# JSON file in the Chrome trace event format that can be viewed at
+# https://ui.perfetto.dev or chrome://tracing.
+#
+# It works like this:
+#
+# 1. Finds the enum uTraceEvent_t in u_trace.h (which is expected
+#    to be in the same directory as this script, unless told
+#    otherwise) to get the names of the events.
+#
+# 2. Reads the entries from the input: if the input contains lines
+#    beginning "U_TRACE: " (which may be anywhere in a line, so that
+#    a log with time-stamps etc. prefixed can be used) it is taken to
+#    be the output of uTraceDump(), otherwise it is taken to be the
+#    raw memory of a trace ring, in which case the entries are put
+#    back in sequence order and any that are incomplete are dropped.
+#
+# 3. Decodes the event of each entry into phase, event name and
+#    task tag, unwraps the 32-bit microsecond time-stamps and writes
+#    the Chrome trace events, one thread row per task tag.
+
+# The version of the trace format this script understands, must
+# be the same as U_TRACE_VERSION in u_trace.h
+TRACE_VERSION = 1
+
+# The magic word at the start of a trace ring
+TRACE_MAGIC_WORD = 0x55545243
+
+# The default location of u_trace.h
+HEADER_FILE_DEFAULT = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                   "u_trace.h")
+
+# The enum in u_trace.h that gives the event names
+ENUM_NAME_EVENT = "uTraceEvent_t"
+
+# The prefix on every entry of that enum
+ENUM_ENTRY_PREFIX_EVENT = "U_TRACE_EVENT_"
+
+# The prefix uTraceDump() puts on each line
+DUMP_PREFIX = "U_TRACE: "
+
+# Chrome trace phases, indexed by uTracePhase_t
+PHASES = ["i", "B", "E", "C"]
+
+def read_event_names(header_file):
+    '''Return a list of event names from the enum in u_trace.h'''
+    names = []
+    with open(header_file, "r", encoding="utf8") as file:
+        contents = file.read()
+    # Remove comments, then find the body of the enum
+    contents = re.sub(r"/\*.*?\*/", "", contents, flags=re.DOTALL)
+    contents = re.sub(r"//[^\n]*", "", contents)
+    match = re.search(r"typedef\s+enum\s*\{([^}]*)\}\s*" + ENUM_NAME_EVENT,
+                      contents)
+    if match:
+        for item in match.group(1).split(","):
+            item = item.strip()
+            if item:
+                # No explicit values are allowed other than the first
+                name = item.split("=")[0].strip()
+                if name.startswith(ENUM_ENTRY_PREFIX_EVENT):
+                    name = name[len(ENUM_ENTRY_PREFIX_EVENT):]
+                names.append(name.lower())
+    return names
+
+def read_entries_dump(lines):
+    '''Return the entries (sequence, time, event, parameter) from uTraceDump() output'''
+    entries = []
+    pattern = re.compile(re.escape(DUMP_PREFIX) + r"([0-9a-fA-F]{8}) ([0-9a-fA-F]{8})"
+                         r" ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8})")
+    version = re.compile(re.escape(DUMP_PREFIX) + r"version (\d+)")
+    for line in lines:
+        match = version.search(line)
+        if match and int(match.group(1)) != TRACE_VERSION:
+            print(f"Warning: trace is version {match.group(1)}, this script"
+                  f" understands version {TRACE_VERSION}.", file=sys.stderr)
+        match = pattern.search(line)
+        if match:
+            entries.append(tuple(int(x, 16) for x in match.groups()))
+    return entries
+
+def read_entries_binary(data, big_endian):
+    '''Return the entries (sequence, time, event, parameter) from a raw trace ring'''
+    entries = []
+    endian = ">" if big_endian else "<"
+    if len(data) < 16:
+        print("Error: too short to be a trace ring.", file=sys.stderr)
+        return entries
+    magic_word, version, num_entries, reserve_index = struct.unpack(endian + "4I",
+                                                                     data[:16])
+    if magic_word != TRACE_MAGIC_WORD:
+        print(f"Error: magic word is 0x{magic_word:08x}, expected"
+              f" 0x{TRACE_MAGIC_WORD:08x} (wrong endianness?).", file=sys.stderr)
+        return entries
+    if version != TRACE_VERSION:
+        print(f"Warning: trace is version {version}, this script"
+              f" understands version {TRACE_VERSION}.", file=sys.stderr)
+    num_entries = min(num_entries, (len(data) - 16) // 16)
+    for index in range(num_entries):
+        entry = struct.unpack(endian + "4I", data[16 + (index * 16): 32 + (index * 16)])
+        # Keep only those entries that were complete and are from
+        # the most recent lap of the ring
+        if entry[0] != 0 and ((reserve_index - entry[0]) & 0xFFFFFFFF) < num_entries:
+            entries.append(entry)
+    # Put them in the order they were written, bearing in mind
+    # that the sequence numbers may have wrapped
+    entries.sort(key=lambda entry: (entry[0] - reserve_index - 1) & 0xFFFFFFFF)
+    return entries
+
+def to_chrome_trace(entries, event_names, process_name):
+    '''Return a Chrome trace dictionary for the given entries'''
+    trace_events = []
+    task_tags = set()
+    time_offset = 0
+    time_last = None
+    for sequence, time_us, event, parameter in entries:
+        # Unwrap the time-stamp; entries may be slightly out of
+        # time order when tasks collide, hence the big margin
+        if time_last is not None and time_us < time_last and time_last - time_us > 0x80000000:
+            time_offset += 0x100000000
+        time_last = time_us
+        if parameter >= 0x80000000:
+            parameter -= 0x100000000
+        phase = PHASES[(event >> 30) & 0x03]
+        event_id = (event >> 16) & 0x3FFF
+        task_tag = event & 0xFFFF
+        task_tags.add(task_tag)
+        name = f"event_{event_id}"
+        if event_id < len(event_names):
+            name = event_names[event_id]
+        trace_event = {"name": name, "ph": phase, "ts": time_us + time_offset,
+                       "pid": 0, "tid": task_tag}
+        if phase == "C":
+            trace_event["args"] = {name: parameter}
+        else:
+            trace_event["args"] = {"parameter": parameter, "sequence": sequence}
+        if phase == "i":
+            trace_event["s"] = "t"
+        trace_events.append(trace_event)
+    # Name the process and the threads
+    trace_events.append({"name": "process_name", "ph": "M", "pid": 0,
+                         "args": {"name": process_name}})
+    for task_tag in task_tags:
+        trace_events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": task_tag,
+                             "args": {"name": f"task 0x{task_tag:04x}"}})
+    return {"traceEvents": trace_events, "displayTimeUnit": "ms"}
+
+def main():
+    '''Main as a function'''
+    return_value = 1
+
+    parser = argparse.ArgumentParser(description="A script to convert a ubxlib"
+                                     " binary trace, either the output of"
+                                     " uTraceDump() or the raw memory of a trace"
+                                     " ring, into a Chrome trace JSON file.")
+    parser.add_argument("input", help="the log file or binary dump to convert.")
+    parser.add_argument("-o", "--output", help="the JSON file to write; if not"
+                        " given the JSON is written to stdout.")
+    parser.add_argument("-e", "--header", default=HEADER_FILE_DEFAULT, help="the"
+                        " path to u_trace.h, from which the event names are read;"
+                        " default " + HEADER_FILE_DEFAULT + ".")
+    parser.add_argument("-b", "--big-endian", action="store_true", help="the binary"
+                        " dump is from a big-endian MCU.")
+    parser.add_argument("-n", "--name", default="ubxlib", help="the name to give"
+                        " the process in the trace.")
+    args = parser.parse_args()
+
+    event_names = []
+    if os.path.isfile(args.header):
+        event_names = read_event_names(args.header)
+    else:
+        print(f"Warning: {args.header} not found, events will not be named.", file=sys.stderr)
+
+    with open(args.input, "rb") as file:
+        data = file.read()
+    lines = data.decode("utf8", errors="replace").splitlines()
+    if any(DUMP_PREFIX in line for line in lines):
+        entries = read_entries_dump(lines)
+    else:
+        entries = read_entries_binary(data, args.big_endian)
+
+    if entries:
+        trace = to_chrome_trace(entries, event_names, args.name)
+        if args.output:
+            with open(args.output, "w", encoding="utf8") as file:
+                json.dump(trace, file, indent=1)
+            print(f"{len(entries)} trace entries written to {args.output}.")
+        else:
+            json.dump(trace, sys.stdout, indent=1)
+        return_value = 0
+    else:
+        print(f"No trace entries found in {args.input}.", file=sys.stderr)
+
+    return return_value
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the arena allocator.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_error_common.h"
+#include "u_port_os.h"
+#include "u_port_heap.h"
+#include "u_arena.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+// Round a size up to the arena alignment.
+#define U_ARENA_ALIGN_SIZE(size) \
+    (((size) + U_ARENA_ALIGNMENT_BYTES - 1) & ~((size_t) U_ARENA_ALIGNMENT_BYTES - 1))
+
+// The size of the header on an allocation that has overflowed
+// onto the heap, which links it into the overflow list; rounded
+// up so that what follows it remains aligned.
+#define U_ARENA_OVERFLOW_HEADER_SIZE U_ARENA_ALIGN_SIZE(sizeof(void *))
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Free the overflow allocations of an arena, newest first,
+// until pStop is reached.
+static void freeOverflow(uArena_t *pArena, void *pStop)
+{
+    void *pThis = pArena->pOverflowList;
+    void *pNext;
+
+    while ((pThis != NULL) && (pThis != pStop)) {
+        pNext = *((void **) pThis);
+        uPortFree(pThis);
+        pThis = pNext;
+    }
+    pArena->pOverflowList = pThis;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Create an arena on a block of memory.
+int32_t uArenaInit(uArena_t *pArena, void *pBlock, size_t size)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t skip;
+
+    if ((pArena != NULL) && ((pBlock != NULL) || (size == 0))) {
+        pArena->pBlock = (char *) pBlock;
+        pArena->size = 0;
+        if (pBlock != NULL) {
+            // Move the start of the block up to the alignment boundary
+            skip = U_ARENA_ALIGN_SIZE((uintptr_t) pBlock) - (uintptr_t) pBlock;
+            if (size > skip) {
+                pArena->pBlock += skip;
+                pArena->size = size - skip;
+            }
+        }
+        pArena->offset = 0;
+        pArena->peakOffset = 0;
+        pArena->pOverflowList = NULL;
+        pArena->overflowCount = 0;
+        pArena->failedAllocCount = 0;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Allocate memory from an arena.
+void *pUArenaAlloc(uArena_t *pArena, size_t size)
+{
+    void *pMem = NULL;
+    char *pOverflow;
+    size_t alignedSize = U_ARENA_ALIGN_SIZE(size);
+
+    if (pArena == NULL) {
+        pMem = pUPortMalloc(size);
+    } else if ((alignedSize >= size) && (pArena->size - pArena->offset >= alignedSize)) {
+        pMem = pArena->pBlock + pArena->offset;
+        pArena->offset += alignedSize;
+        if (pArena->offset > pArena->peakOffset) {
+            pArena->peakOffset = pArena->offset;
+        }
+    } else if (size + U_ARENA_OVERFLOW_HEADER_SIZE > size) {
+        // No room in the block: overflow onto the heap, linking
+        // the allocation into the list so that it is freed on release
+        pOverflow = (char *) pUPortMalloc(size + U_ARENA_OVERFLOW_HEADER_SIZE);
+        if (pOverflow != NULL) {
+            *((void **) pOverflow) = pArena->pOverflowList;
+            pArena->pOverflowList = pOverflow;
+            pArena->overflowCount++;
+            pMem = pOverflow + U_ARENA_OVERFLOW_HEADER_SIZE;
+        }
+    }
+
+    if ((pMem == NULL) && (pArena != NULL)) {
+        pArena->failedAllocCount++;
+    }
+
+    return pMem;
+}
+
+// Free memory obtained from pUArenaAlloc().
+void uArenaFree(uArena_t *pArena, void *pMem)
+{
+    if (pArena == NULL) {
+        uPortFree(pMem);
+    }
+}
+
+// Take a mark in an arena.
+uArenaMark_t uArenaMark(const uArena_t *pArena)
+{
+    uArenaMark_t mark;
+
+    mark.offset = pArena->offset;
+    mark.pOverflowList = pArena->pOverflowList;
+
+    return mark;
+}
+
+// Return the memory allocated from an arena since a mark.
+void uArenaRelease(uArena_t *pArena, uArenaMark_t mark)
+{
+    freeOverflow(pArena, mark.pOverflowList);
+    if (mark.offset < pArena->offset) {
+        pArena->offset = mark.offset;
+    }
+}
+
+// Return all of the memory allocated from an arena.
+void uArenaReset(uArena_t *pArena)
+{
+    freeOverflow(pArena, NULL);
+    pArena->offset = 0;
+}
+
+// End of file
@@ -21,7 +21,7 @@
  */
 
 /** @file
- * @brief functions to assist with time manipulation.
+ * @brief Implementation of base 64 encode and decode.
  */
 
 #ifdef U_CFG_OVERRIDE
@@ -31,18 +31,65 @@
 #include "stddef.h"    // size_t
 #include "stdint.h"    // int32_t etc.
 
-#include "u_base64.h"
+#include "u_compiler.h" // U_INLINE
 
-// The base64.h implementation we use calls puts() so
-// we define it here to remove it
-//lint -e(683) Suppress warning about puts() being redefined.
-#define puts(x)
-#include "base64.h"
+#include "u_base64.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_CFG_BASE64_SMALL
+/** A row of #gBase64Pair: the 64 pairs of base 64 characters that
+ * begin with the character h.
+ */
+#define U_BASE64_PAIR_ROW(h) \
+    {h, 'A'}, {h, 'B'}, {h, 'C'}, {h, 'D'}, {h, 'E'}, {h, 'F'}, {h, 'G'}, {h, 'H'}, \
+    {h, 'I'}, {h, 'J'}, {h, 'K'}, {h, 'L'}, {h, 'M'}, {h, 'N'}, {h, 'O'}, {h, 'P'}, \
+    {h, 'Q'}, {h, 'R'}, {h, 'S'}, {h, 'T'}, {h, 'U'}, {h, 'V'}, {h, 'W'}, {h, 'X'}, \
+    {h, 'Y'}, {h, 'Z'}, {h, 'a'}, {h, 'b'}, {h, 'c'}, {h, 'd'}, {h, 'e'}, {h, 'f'}, \
+    {h, 'g'}, {h, 'h'}, {h, 'i'}, {h, 'j'}, {h, 'k'}, {h, 'l'}, {h, 'm'}, {h, 'n'}, \
+    {h, 'o'}, {h, 'p'}, {h, 'q'}, {h, 'r'}, {h, 's'}, {h, 't'}, {h, 'u'}, {h, 'v'}, \
+    {h, 'w'}, {h, 'x'}, {h, 'y'}, {h, 'z'}, {h, '0'}, {h, '1'}, {h, '2'}, {h, '3'}, \
+    {h, '4'}, {h, '5'}, {h, '6'}, {h, '7'}, {h, '8'}, {h, '9'}, {h, '+'}, {h, '/'}
+#endif
+
+/** The value of each base 64 character, expanded through X(); a
+ * character that is not base 64 is taken to be zero, there is no
+ * error checking.
+ */
+#define U_BASE64_VALUES(X) \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(62), X(0), X(0), X(0), X(63), \
+    X(52), X(53), X(54), X(55), X(56), X(57), X(58), X(59), X(60), X(61), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(1), X(2), X(3), X(4), X(5), X(6), \
+    X(7), X(8), X(9), X(10), X(11), X(12), X(13), X(14), X(15), X(16), X(17), X(18), \
+    X(19), X(20), X(21), X(22), X(23), X(24), X(25), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(26), X(27), X(28), X(29), X(30), X(31), X(32), X(33), X(34), X(35), X(36), \
+    X(37), X(38), X(39), X(40), X(41), X(42), X(43), X(44), X(45), X(46), X(47), X(48), \
+    X(49), X(50), X(51), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), X(0), \
+    X(0), X(0), X(0), X(0)
+
+/** Shifts for U_BASE64_VALUES(), giving the value of a character
+ * in each of the four positions of a 24-bit group.
+ */
+#define U_BASE64_SHIFT_0(v) ((v) << 18)
+#define U_BASE64_SHIFT_1(v) ((v) << 12)
+#define U_BASE64_SHIFT_2(v) ((v) << 6)
+#define U_BASE64_SHIFT_3(v) (v)
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -51,10 +98,132 @@
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
+#ifndef U_CFG_BASE64_SMALL
+
+/** The pair of base 64 characters for each 12-bit value, so that
+ * encoding three bytes is two look-ups; 8 kbytes, define
+ * U_CFG_BASE64_SMALL to use a 64 byte alphabet instead.
+ */
+static const char gBase64Pair[4096][2] = {
+    U_BASE64_PAIR_ROW('A'), U_BASE64_PAIR_ROW('B'),
+    U_BASE64_PAIR_ROW('C'), U_BASE64_PAIR_ROW('D'),
+    U_BASE64_PAIR_ROW('E'), U_BASE64_PAIR_ROW('F'),
+    U_BASE64_PAIR_ROW('G'), U_BASE64_PAIR_ROW('H'),
+    U_BASE64_PAIR_ROW('I'), U_BASE64_PAIR_ROW('J'),
+    U_BASE64_PAIR_ROW('K'), U_BASE64_PAIR_ROW('L'),
+    U_BASE64_PAIR_ROW('M'), U_BASE64_PAIR_ROW('N'),
+    U_BASE64_PAIR_ROW('O'), U_BASE64_PAIR_ROW('P'),
+    U_BASE64_PAIR_ROW('Q'), U_BASE64_PAIR_ROW('R'),
+    U_BASE64_PAIR_ROW('S'), U_BASE64_PAIR_ROW('T'),
+    U_BASE64_PAIR_ROW('U'), U_BASE64_PAIR_ROW('V'),
+    U_BASE64_PAIR_ROW('W'), U_BASE64_PAIR_ROW('X'),
+    U_BASE64_PAIR_ROW('Y'), U_BASE64_PAIR_ROW('Z'),
+    U_BASE64_PAIR_ROW('a'), U_BASE64_PAIR_ROW('b'),
+    U_BASE64_PAIR_ROW('c'), U_BASE64_PAIR_ROW('d'),
+    U_BASE64_PAIR_ROW('e'), U_BASE64_PAIR_ROW('f'),
+    U_BASE64_PAIR_ROW('g'), U_BASE64_PAIR_ROW('h'),
+    U_BASE64_PAIR_ROW('i'), U_BASE64_PAIR_ROW('j'),
+    U_BASE64_PAIR_ROW('k'), U_BASE64_PAIR_ROW('l'),
+    U_BASE64_PAIR_ROW('m'), U_BASE64_PAIR_ROW('n'),
+    U_BASE64_PAIR_ROW('o'), U_BASE64_PAIR_ROW('p'),
+    U_BASE64_PAIR_ROW('q'), U_BASE64_PAIR_ROW('r'),
+    U_BASE64_PAIR_ROW('s'), U_BASE64_PAIR_ROW('t'),
+    U_BASE64_PAIR_ROW('u'), U_BASE64_PAIR_ROW('v'),
+    U_BASE64_PAIR_ROW('w'), U_BASE64_PAIR_ROW('x'),
+    U_BASE64_PAIR_ROW('y'), U_BASE64_PAIR_ROW('z'),
+    U_BASE64_PAIR_ROW('0'), U_BASE64_PAIR_ROW('1'),
+    U_BASE64_PAIR_ROW('2'), U_BASE64_PAIR_ROW('3'),
+    U_BASE64_PAIR_ROW('4'), U_BASE64_PAIR_ROW('5'),
+    U_BASE64_PAIR_ROW('6'), U_BASE64_PAIR_ROW('7'),
+    U_BASE64_PAIR_ROW('8'), U_BASE64_PAIR_ROW('9'),
+    U_BASE64_PAIR_ROW('+'), U_BASE64_PAIR_ROW('/')
+};
+
+/** The value of each character in each position of a group of
+ * four, already shifted into place, so that decoding a group is
+ * four look-ups ORed together; 4 kbytes, define
+ * U_CFG_BASE64_SMALL to use a single 256 byte table instead.
+ */
+static const uint32_t gBase64Value[4][256] = {
+    {U_BASE64_VALUES(U_BASE64_SHIFT_0)},
+    {U_BASE64_VALUES(U_BASE64_SHIFT_1)},
+    {U_BASE64_VALUES(U_BASE64_SHIFT_2)},
+    {U_BASE64_VALUES(U_BASE64_SHIFT_3)}
+};
+
+#else
+
+/** The base 64 alphabet.
+ */
+static const char gBase64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/** The value of each base 64 character.
+ */
+static const uint8_t gBase64Value[256] = {U_BASE64_VALUES(U_BASE64_SHIFT_3)};
+
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Write the first numChars (two to four) base 64 characters of the
+// 24-bit group x to pBase64.
+static U_INLINE void encodeGroup(uint32_t x, size_t numChars, char *pBase64)
+{
+#ifndef U_CFG_BASE64_SMALL
+    const char *pPair = gBase64Pair[x >> 12];
+
+    *pBase64 = *pPair;
+    *(pBase64 + 1) = *(pPair + 1);
+    pPair = gBase64Pair[x & 0xfff];
+    if (numChars > 2) {
+        *(pBase64 + 2) = *pPair;
+    }
+    if (numChars > 3) {
+        *(pBase64 + 3) = *(pPair + 1);
+    }
+#else
+    *pBase64 = gBase64Alphabet[x >> 18];
+    *(pBase64 + 1) = gBase64Alphabet[(x >> 12) & 0x3f];
+    if (numChars > 2) {
+        *(pBase64 + 2) = gBase64Alphabet[(x >> 6) & 0x3f];
+    }
+    if (numChars > 3) {
+        *(pBase64 + 3) = gBase64Alphabet[x & 0x3f];
+    }
+#endif
+}
+
+// Return the 24-bit group for the first numChars (two to four) base
+// 64 characters at pBase64, any not read being taken as zero.
+static U_INLINE uint32_t decodeGroup(const unsigned char *pBase64, size_t numChars)
+{
+    uint32_t x = 0;
+
+#ifndef U_CFG_BASE64_SMALL
+    x = gBase64Value[0][*pBase64] | gBase64Value[1][*(pBase64 + 1)];
+    if (numChars > 2) {
+        x |= gBase64Value[2][*(pBase64 + 2)];
+    }
+    if (numChars > 3) {
+        x |= gBase64Value[3][*(pBase64 + 3)];
+    }
+#else
+    x = (((uint32_t) gBase64Value[*pBase64]) << 18) |
+        (((uint32_t) gBase64Value[*(pBase64 + 1)]) << 12);
+    if (numChars > 2) {
+        x |= ((uint32_t) gBase64Value[*(pBase64 + 2)]) << 6;
+    }
+    if (numChars > 3) {
+        x |= gBase64Value[*(pBase64 + 3)];
+    }
+#endif
+
+    return x;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -63,18 +232,32 @@
 int32_t uBase64Encode(const char *pBinary, size_t binaryLengthBytes,
                       char *pBase64, size_t base64LengthBytes)
 {
-    int32_t bytesEncoded = 0;
+    const unsigned char *pByte = (const unsigned char *) pBinary;
+    size_t remainder = binaryLengthBytes % 3;
+    // Every three bytes, or part thereof, becomes four characters
+    int32_t bytesEncoded = (int32_t) (((binaryLengthBytes + 2) / 3) * 4);
+    uint32_t x;
 
-    // Determine the required length of decode buffer by calling
-    // base64() with NULL
-    //lint -e(712) Suppress loss of precision
-    base64(pBinary, binaryLengthBytes,
-           (int *) &(bytesEncoded), NULL); // *NOPAD* stop AStyle offsetting &
     if ((pBase64 != NULL) && ((int32_t) base64LengthBytes >= bytesEncoded)) {
-        // Now do the encode
-        //lint -e(712) Suppress loss of precision
-        base64((const void *) pBinary, binaryLengthBytes,
-               (int *) &(bytesEncoded), pBase64);  // *NOPAD* stop AStyle offsetting &
+        for (size_t y = binaryLengthBytes / 3; y > 0; y--) {
+            x = (((uint32_t) *pByte) << 16) | (((uint32_t) * (pByte + 1)) << 8) | *(pByte + 2);
+            encodeGroup(x, 4, pBase64);
+            pByte += 3;
+            pBase64 += 4;
+        }
+        if (remainder > 0) {
+            // One byte makes two characters and two bytes three,
+            // padded out to four with '='
+            x = ((uint32_t) *pByte) << 16;
+            if (remainder > 1) {
+                x |= ((uint32_t) * (pByte + 1)) << 8;
+            }
+            encodeGroup(x, remainder + 1, pBase64);
+            *(pBase64 + 3) = '=';
+            if (remainder == 1) {
+                *(pBase64 + 2) = '=';
+            }
+        }
     }
 
     return bytesEncoded;
@@ -84,18 +267,45 @@ int32_t uBase64Encode(const char *pBinary, size_t binaryLengthBytes,
 int32_t uBase64Decode(const char *pBase64, size_t base64LengthBytes,
                       char *pBinary, size_t binaryLengthBytes)
 {
-    int32_t bytesDecoded = 0;
+    const unsigned char *pChar = (const unsigned char *) pBase64;
+    size_t numChars = base64LengthBytes;
+    size_t remainder;
+    int32_t bytesDecoded;
+    uint32_t x;
+
+    // Up to two '=' of padding on the end are ignored
+    if ((numChars >= 2) && (*(pChar + numChars - 1) == '=')) {
+        numChars--;
+        if (*(pChar + numChars - 1) == '=') {
+            numChars--;
+        }
+    }
+    // Every four characters becomes three bytes, then two or three
+    // left over become one or two bytes (a single one is ignored)
+    remainder = numChars % 4;
+    bytesDecoded = (int32_t) ((numChars / 4) * 3);
+    if (remainder > 1) {
+        bytesDecoded += (int32_t) (remainder - 1);
+    }
 
-    // Determine the required length of decode buffer by calling
-    // unbase64() with NULL
-    //lint -e(712) Suppress loss of precision
-    unbase64(pBase64, base64LengthBytes, (int *) & (bytesDecoded),
-             NULL);  // *NOPAD* stop AStyle offsetting &
     if ((pBinary != NULL) && ((int32_t) binaryLengthBytes >= bytesDecoded)) {
-        // Now do the decode
-        //lint -e(712) Suppress loss of precision
-        unbase64(pBase64, base64LengthBytes,
-                 (int *) &(bytesDecoded), pBinary);  // *NOPAD* stop AStyle offsetting &
+        // Since each group is read before its (shorter) output is
+        // written, pBinary may be the same as pBase64
+        for (size_t y = numChars / 4; y > 0; y--) {
+            x = decodeGroup(pChar, 4);
+            *pBinary = (char) (x >> 16);
+            *(pBinary + 1) = (char) (x >> 8);
+            *(pBinary + 2) = (char) x;
+            pChar += 4;
+            pBinary += 3;
+        }
+        if (remainder > 1) {
+            x = decodeGroup(pChar, remainder);
+            *pBinary = (char) (x >> 16);
+            if (remainder > 2) {
+                *(pBinary + 1) = (char) (x >> 8);
+            }
+        }
     }
 
     return bytesDecoded;
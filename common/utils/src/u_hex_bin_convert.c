@@ -35,12 +35,22 @@
 
 #include "u_assert.h"
 
+#include "u_port_codec.h"
+
 #include "u_hex_bin_convert.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** A row of #gHexPair: the sixteen pairs of ASCII hex characters
+ * that begin with the character h.
+ */
+#define U_HEX_BIN_CONVERT_PAIR_ROW(h) {h, '0'}, {h, '1'}, {h, '2'}, {h, '3'}, \
+                                      {h, '4'}, {h, '5'}, {h, '6'}, {h, '7'}, \
+                                      {h, '8'}, {h, '9'}, {h, 'A'}, {h, 'B'}, \
+                                      {h, 'C'}, {h, 'D'}, {h, 'E'}, {h, 'F'}
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -49,24 +59,75 @@
  * VARIABLES
  * -------------------------------------------------------------- */
 
-static const char gHex[] = {'0', '1', '2', '3', '4', '5', '6', '7',
-                            '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
-                           };
+/** The pair of ASCII hex characters for each byte value, so that
+ * encoding is a single look-up per byte; used for whatever
+ * uPortCodecBinToHex() leaves over, which is everything unless
+ * U_CFG_CODEC_VECTOR is defined.
+ */
+static const char gHexPair[256][2] = {
+    U_HEX_BIN_CONVERT_PAIR_ROW('0'), U_HEX_BIN_CONVERT_PAIR_ROW('1'),
+    U_HEX_BIN_CONVERT_PAIR_ROW('2'), U_HEX_BIN_CONVERT_PAIR_ROW('3'),
+    U_HEX_BIN_CONVERT_PAIR_ROW('4'), U_HEX_BIN_CONVERT_PAIR_ROW('5'),
+    U_HEX_BIN_CONVERT_PAIR_ROW('6'), U_HEX_BIN_CONVERT_PAIR_ROW('7'),
+    U_HEX_BIN_CONVERT_PAIR_ROW('8'), U_HEX_BIN_CONVERT_PAIR_ROW('9'),
+    U_HEX_BIN_CONVERT_PAIR_ROW('A'), U_HEX_BIN_CONVERT_PAIR_ROW('B'),
+    U_HEX_BIN_CONVERT_PAIR_ROW('C'), U_HEX_BIN_CONVERT_PAIR_ROW('D'),
+    U_HEX_BIN_CONVERT_PAIR_ROW('E'), U_HEX_BIN_CONVERT_PAIR_ROW('F')
+};
+
+/** The value of each ASCII hex character, upper or lower case,
+ * or 0xff if the character is not hex; the top bit being set
+ * allows several characters to be checked at once by ORing
+ * their values together.
+ */
+static const uint8_t gHexValue[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+       0,    1,    2,    3,    4,    5,    6,    7,    8,    9, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff,   10,   11,   12,   13,   14,   15, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff,   10,   11,   12,   13,   14,   15, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
 
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
 size_t uBinToHex(const char *pBin, size_t binLength, char *pHex)
 {
+    const unsigned char *pByte;
+    const char *pPair;
+    size_t length;
+
     U_ASSERT(pHex != NULL);
 
-    for (size_t x = 0; x < binLength; x++) {
-        *pHex = gHex[((unsigned char) * pBin) >> 4];
+    // Let the port layer do what it can, e.g. with vectors...
+    length = uPortCodecBinToHex(pBin, binLength, pHex);
+    pByte = (const unsigned char *) pBin + length;
+    pHex += length * 2;
+
+    // ...then the rest from the table
+    for (size_t x = length; x < binLength; x++) {
+        pPair = gHexPair[*pByte];
+        *pHex = *pPair;
         pHex++;
-        *pHex = gHex[*pBin & 0x0f];
+        *pHex = *(pPair + 1);
         pHex++;
-        pBin++;
+        pByte++;
     }
 
     return binLength * 2;
@@ -74,36 +135,58 @@ size_t uBinToHex(const char *pBin, size_t binLength, char *pHex)
 
 size_t uHexToBin(const char *pHex, size_t hexLength, char *pBin)
 {
-    bool success = true;
+    const unsigned char *pChar;
     size_t length;
-    char z[2];
+    size_t binLength = hexLength / 2;
+    uint8_t v0;
+    uint8_t v1;
+    uint8_t v2;
+    uint8_t v3;
+    uint8_t v4;
+    uint8_t v5;
+    uint8_t v6;
+    uint8_t v7;
 
     U_ASSERT(pBin != NULL);
 
-    for (length = 0; (length < hexLength / 2) && success; length++) {
-        z[0] = *pHex - '0';
-        pHex++;
-        z[1] = *pHex - '0';
-        pHex++;
-        for (size_t y = 0; (y < sizeof(z)) && success; y++) {
-            if (z[y] > 9) {
-                // Must be A to F or a to f
-                z[y] -= 'A' - '0';
-                z[y] += 10;
-            }
-            if (z[y] > 15) {
-                // Must be a to f
-                z[y] -= 'a' - 'A';
-            }
-            // Cast here to shut-up a warning under ESP-IDF
-            // which appears to have chars as unsigned and
-            // hence thinks the first condition is always true
-            success = ((signed char) z[y] >= 0) && (z[y] <= 15);
+    // Let the port layer do what it can, e.g. with vectors...
+    length = uPortCodecHexToBin(pHex, hexLength, pBin);
+    pChar = (const unsigned char *) pHex + (length * 2);
+    pBin += length;
+
+    // ...then four bytes at a time, with a single validity check
+    while (length + 4 <= binLength) {
+        v0 = gHexValue[pChar[0]];
+        v1 = gHexValue[pChar[1]];
+        v2 = gHexValue[pChar[2]];
+        v3 = gHexValue[pChar[3]];
+        v4 = gHexValue[pChar[4]];
+        v5 = gHexValue[pChar[5]];
+        v6 = gHexValue[pChar[6]];
+        v7 = gHexValue[pChar[7]];
+        if ((v0 | v1 | v2 | v3 | v4 | v5 | v6 | v7) & 0x80) {
+            // Let the loop below find where exactly it stops
+            break;
         }
-        if (success) {
-            *pBin = (char) (((z[0] & 0x0f) << 4) | z[1]);
-            pBin++;
+        *pBin = (char) ((v0 << 4) | v1);
+        *(pBin + 1) = (char) ((v2 << 4) | v3);
+        *(pBin + 2) = (char) ((v4 << 4) | v5);
+        *(pBin + 3) = (char) ((v6 << 4) | v7);
+        pBin += 4;
+        pChar += 8;
+        length += 4;
+    }
+
+    // ...then a byte at a time, stopping at anything that isn't hex
+    for (; length < binLength; length++) {
+        v0 = gHexValue[pChar[0]];
+        v1 = gHexValue[pChar[1]];
+        if ((v0 | v1) & 0x80) {
+            break;
         }
+        *pBin = (char) ((v0 << 4) | v1);
+        pBin++;
+        pChar += 2;
     }
 
     return length;
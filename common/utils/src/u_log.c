@@ -0,0 +1,862 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the deferred log.
+ *
+ * A record in the ring buffer is a uint16_t giving the length of
+ * the whole record, the format string pointer and then the
+ * arguments in the order they appear in the format string, each
+ * stored as the type it was passed as or, for a "%s", as a copy of
+ * the null-terminated string.  Nothing is aligned, everything is
+ * memcpy()ed.  There is no need to store what type each argument
+ * is since the task that does the formatting can work that out by
+ * scanning the format string, just as uLogDeferred() did.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "stdarg.h"    // va_list
+#include "stdio.h"     // snprintf()
+#include "string.h"    // memcpy(), strlen()
+
+#include "u_compiler.h" // U_ATOMIC_XXX()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_heap.h"
+#include "u_port_debug.h"
+
+#include "u_ringbuffer.h"
+
+#include "u_log.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The longest conversion specification that can be re-formatted,
+ * including the '%', the null terminator and room for any '*'
+ * to be replaced by a number.
+ */
+#define U_LOG_SPEC_MAX_LENGTH_BYTES 32
+
+/** The size of the header of a record: the length and the
+ * format string pointer.
+ */
+#define U_LOG_RECORD_HEADER_LENGTH_BYTES (sizeof(uint16_t) + sizeof(const char *))
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The type of argument that a conversion specification takes.
+ */
+typedef enum {
+    U_LOG_ARG_TYPE_NONE, /**< "%%". */
+    U_LOG_ARG_TYPE_INT,
+    U_LOG_ARG_TYPE_LONG,
+    U_LOG_ARG_TYPE_LONG_LONG,
+    U_LOG_ARG_TYPE_SIZE,
+    U_LOG_ARG_TYPE_PTRDIFF,
+    U_LOG_ARG_TYPE_INTMAX,
+    U_LOG_ARG_TYPE_DOUBLE,
+    U_LOG_ARG_TYPE_LONG_DOUBLE,
+    U_LOG_ARG_TYPE_POINTER,
+    U_LOG_ARG_TYPE_STRING,
+    U_LOG_ARG_TYPE_UNSUPPORTED
+} uLogArgType_t;
+
+/** A parsed conversion specification.
+ */
+typedef struct {
+    size_t length; /**< the number of characters after the '%'. */
+    size_t numStars; /**< the number of '*' int arguments it takes. */
+    uLogArgType_t type; /**< the type of the argument it takes. */
+} uLogSpec_t;
+
+/** Where formatted text is assembled before being output.
+ */
+typedef struct {
+    char buffer[U_LOG_DEFERRED_LINE_MAX_LENGTH_BYTES];
+    size_t length;
+    uLogDeferredOutput_t pOutput;
+    void *pOutputParam;
+} uLogLine_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The ring buffer of records, valid while gInitialised is true.
+ */
+static uRingBuffer_t gRingBuffer;
+
+/** The memory for gRingBuffer.
+ */
+static char *gpLinearBuffer = NULL;
+
+/** Set to true once the deferred log is running.
+ */
+static bool gInitialised = false;
+
+/** Given whenever a record is added to the ring buffer.
+ */
+static uPortSemaphoreHandle_t gSemaphore = NULL;
+
+/** Held by the task while it is running.
+ */
+static uPortMutexHandle_t gTaskRunningMutex = NULL;
+
+/** Handle of the task.
+ */
+static uPortTaskHandle_t gTaskHandle = NULL;
+
+/** Set to true to make the task exit.
+ */
+static volatile bool gTaskExit = false;
+
+/** Non-zero while the task has a record out of the ring buffer.
+ */
+static volatile int32_t gTaskBusy = 0;
+
+/** Where the task assembles its output.
+ */
+static uLogLine_t gLine;
+
+/** The record that the task is formatting.
+ */
+static char gRecord[U_LOG_DEFERRED_RECORD_MAX_LENGTH_BYTES];
+
+/** The number of records that were lost.
+ */
+static int32_t gNumLost = 0;
+
+/** The number of lost records that have been reported.
+ */
+static int32_t gNumLostReported = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: FORMAT STRING SCANNING
+ * -------------------------------------------------------------- */
+
+// Parse the conversion specification that follows a '%'; this
+// is a cheap scan, not a validation: anything it doesn't
+// understand is marked as unsupported.
+static void parseSpec(const char *pFormat, uLogSpec_t *pSpec)
+{
+    const char *pStart = pFormat;
+    size_t lengthModifier = 0;
+
+    pSpec->numStars = 0;
+    pSpec->type = U_LOG_ARG_TYPE_UNSUPPORTED;
+
+    // Flags
+    while ((*pFormat == '-') || (*pFormat == '+') || (*pFormat == ' ') ||
+           (*pFormat == '#') || (*pFormat == '0')) {
+        pFormat++;
+    }
+    // Width
+    if (*pFormat == '*') {
+        pSpec->numStars++;
+        pFormat++;
+    } else {
+        while ((*pFormat >= '0') && (*pFormat <= '9')) {
+            pFormat++;
+        }
+    }
+    // Precision
+    if (*pFormat == '.') {
+        pFormat++;
+        if (*pFormat == '*') {
+            pSpec->numStars++;
+            pFormat++;
+        } else {
+            while ((*pFormat >= '0') && (*pFormat <= '9')) {
+                pFormat++;
+            }
+        }
+    }
+    // Length modifier: remember it as a character, doubled
+    // ones ("hh" and "ll") being given in upper case
+    switch (*pFormat) {
+        case 'h':
+        case 'l':
+            lengthModifier = *pFormat;
+            pFormat++;
+            if (*pFormat == lengthModifier) {
+                lengthModifier -= 'a' - 'A';
+                pFormat++;
+            }
+            break;
+        case 'j':
+        case 'z':
+        case 't':
+        case 'L':
+            lengthModifier = *pFormat;
+            pFormat++;
+            break;
+        default:
+            break;
+    }
+    // Conversion
+    switch (*pFormat) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            switch (lengthModifier) {
+                case 'l':
+                    pSpec->type = U_LOG_ARG_TYPE_LONG;
+                    break;
+                case 'L':
+                    pSpec->type = U_LOG_ARG_TYPE_LONG_LONG;
+                    break;
+                case 'z':
+                    pSpec->type = U_LOG_ARG_TYPE_SIZE;
+                    break;
+                case 't':
+                    pSpec->type = U_LOG_ARG_TYPE_PTRDIFF;
+                    break;
+                case 'j':
+                    pSpec->type = U_LOG_ARG_TYPE_INTMAX;
+                    break;
+                default:
+                    // "h" and "hh" arguments are promoted to int
+                    pSpec->type = U_LOG_ARG_TYPE_INT;
+                    break;
+            }
+            break;
+        case 'c':
+            if (lengthModifier == 0) {
+                pSpec->type = U_LOG_ARG_TYPE_INT;
+            }
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            pSpec->type = U_LOG_ARG_TYPE_DOUBLE;
+            if (lengthModifier == 'L') {
+                pSpec->type = U_LOG_ARG_TYPE_LONG_DOUBLE;
+            }
+            break;
+        case 'p':
+            pSpec->type = U_LOG_ARG_TYPE_POINTER;
+            break;
+        case 's':
+            if (lengthModifier == 0) {
+                pSpec->type = U_LOG_ARG_TYPE_STRING;
+            }
+            break;
+        case '%':
+            pSpec->type = U_LOG_ARG_TYPE_NONE;
+            break;
+        default:
+            break;
+    }
+    if (*pFormat != 0) {
+        pFormat++;
+    }
+
+    pSpec->length = pFormat - pStart;
+}
+
+// Add a value to a record, returning false if there is no room.
+static bool recordAdd(char *pRecord, size_t *pLength,
+                      const void *pValue, size_t size)
+{
+    bool added = false;
+
+    if (*pLength + size <= U_LOG_DEFERRED_RECORD_MAX_LENGTH_BYTES) {
+        memcpy(pRecord + *pLength, pValue, size);
+        *pLength += size;
+        added = true;
+    }
+
+    return added;
+}
+
+// Fill a record with the format string pointer and arguments,
+// returning its length.
+static size_t recordFill(char *pRecord, const char *pFormat, va_list args)
+{
+    size_t length = U_LOG_RECORD_HEADER_LENGTH_BYTES;
+    uint16_t lengthStored;
+    uLogSpec_t spec;
+    bool room = true;
+    size_t x;
+    int intValue;
+    long longValue;
+    long long longLongValue;
+    size_t sizeValue;
+    ptrdiff_t ptrdiffValue;
+    intmax_t intmaxValue;
+    double doubleValue;
+    long double longDoubleValue;
+    void *pPointerValue;
+    const char *pStringValue;
+
+    memcpy(pRecord + sizeof(lengthStored), &pFormat, sizeof(pFormat));
+    while (room && (*pFormat != 0)) {
+        if (*pFormat != '%') {
+            pFormat++;
+            continue;
+        }
+        pFormat++;
+        parseSpec(pFormat, &spec);
+        pFormat += spec.length;
+        for (x = 0; room && (x < spec.numStars); x++) {
+            intValue = va_arg(args, int);
+            room = recordAdd(pRecord, &length, &intValue, sizeof(intValue));
+        }
+        if (room) {
+            switch (spec.type) {
+                case U_LOG_ARG_TYPE_INT:
+                    intValue = va_arg(args, int);
+                    room = recordAdd(pRecord, &length, &intValue, sizeof(intValue));
+                    break;
+                case U_LOG_ARG_TYPE_LONG:
+                    longValue = va_arg(args, long);
+                    room = recordAdd(pRecord, &length, &longValue, sizeof(longValue));
+                    break;
+                case U_LOG_ARG_TYPE_LONG_LONG:
+                    longLongValue = va_arg(args, long long);
+                    room = recordAdd(pRecord, &length, &longLongValue, sizeof(longLongValue));
+                    break;
+                case U_LOG_ARG_TYPE_SIZE:
+                    sizeValue = va_arg(args, size_t);
+                    room = recordAdd(pRecord, &length, &sizeValue, sizeof(sizeValue));
+                    break;
+                case U_LOG_ARG_TYPE_PTRDIFF:
+                    ptrdiffValue = va_arg(args, ptrdiff_t);
+                    room = recordAdd(pRecord, &length, &ptrdiffValue, sizeof(ptrdiffValue));
+                    break;
+                case U_LOG_ARG_TYPE_INTMAX:
+                    intmaxValue = va_arg(args, intmax_t);
+                    room = recordAdd(pRecord, &length, &intmaxValue, sizeof(intmaxValue));
+                    break;
+                case U_LOG_ARG_TYPE_DOUBLE:
+                    doubleValue = va_arg(args, double);
+                    room = recordAdd(pRecord, &length, &doubleValue, sizeof(doubleValue));
+                    break;
+                case U_LOG_ARG_TYPE_LONG_DOUBLE:
+                    longDoubleValue = va_arg(args, long double);
+                    room = recordAdd(pRecord, &length, &longDoubleValue, sizeof(longDoubleValue));
+                    break;
+                case U_LOG_ARG_TYPE_POINTER:
+                    pPointerValue = va_arg(args, void *);
+                    room = recordAdd(pRecord, &length, &pPointerValue, sizeof(pPointerValue));
+                    break;
+                case U_LOG_ARG_TYPE_STRING:
+                    pStringValue = va_arg(args, const char *);
+                    if (pStringValue == NULL) {
+                        pStringValue = "(null)";
+                    }
+                    x = strlen(pStringValue);
+                    if (x > U_LOG_DEFERRED_STRING_MAX_LENGTH_BYTES) {
+                        x = U_LOG_DEFERRED_STRING_MAX_LENGTH_BYTES;
+                    }
+                    // Truncate the string, rather than lose it, if it
+                    // is the last thing that won't fit
+                    if (length + x + 1 > U_LOG_DEFERRED_RECORD_MAX_LENGTH_BYTES) {
+                        x = 0;
+                        if (length < U_LOG_DEFERRED_RECORD_MAX_LENGTH_BYTES) {
+                            x = U_LOG_DEFERRED_RECORD_MAX_LENGTH_BYTES - length - 1;
+                        }
+                    }
+                    room = recordAdd(pRecord, &length, pStringValue, x) &&
+                           recordAdd(pRecord, &length, "", 1);
+                    break;
+                case U_LOG_ARG_TYPE_NONE:
+                    break;
+                default:
+                    // Can't know what comes next, stop here
+                    room = false;
+                    break;
+            }
+        }
+    }
+
+    lengthStored = (uint16_t) length;
+    memcpy(pRecord, &lengthStored, sizeof(lengthStored));
+
+    return length;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: FORMATTING
+ * -------------------------------------------------------------- */
+
+// Output whatever is in a line.
+static void lineFlush(uLogLine_t *pLine)
+{
+    if (pLine->length > 0) {
+        pLine->buffer[pLine->length] = 0;
+        if (pLine->pOutput != NULL) {
+            pLine->pOutput(pLine->buffer, pLine->pOutputParam);
+        } else {
+            uPortLog("%s", pLine->buffer);
+        }
+        pLine->length = 0;
+    }
+}
+
+// Add a literal character to a line.
+static void lineAddChar(uLogLine_t *pLine, char character)
+{
+    if (pLine->length >= sizeof(pLine->buffer) - 1) {
+        lineFlush(pLine);
+    }
+    pLine->buffer[pLine->length] = character;
+    pLine->length++;
+}
+
+// Take a value from a record, returning false if it's not there.
+static bool recordTake(const char *pRecord, size_t recordLength,
+                       size_t *pOffset, void *pValue, size_t size)
+{
+    bool taken = false;
+
+    if (*pOffset + size <= recordLength) {
+        memcpy(pValue, pRecord + *pOffset, size);
+        *pOffset += size;
+        taken = true;
+    }
+
+    return taken;
+}
+
+// Format one conversion specification into a line, taking its
+// arguments from a record; returns false if the arguments weren't
+// all there.
+static bool formatSpec(uLogLine_t *pLine, const char *pFormat,
+                       const uLogSpec_t *pSpec, const char *pRecord,
+                       size_t recordLength, size_t *pOffset)
+{
+    char spec[U_LOG_SPEC_MAX_LENGTH_BYTES];
+    size_t specLength = 0;
+    bool taken = true;
+    int intValue;
+    long longValue;
+    long long longLongValue;
+    size_t sizeValue;
+    ptrdiff_t ptrdiffValue;
+    intmax_t intmaxValue;
+    double doubleValue;
+    long double longDoubleValue;
+    void *pPointerValue;
+    const char *pStringValue = NULL;
+    size_t space;
+    int length = -1;
+    bool retry;
+
+    // Rebuild the specification with any '*' replaced by the
+    // number from the record, leaving room for the longest
+    // number that can replace the last '*'
+    spec[specLength] = '%';
+    specLength++;
+    for (size_t x = 0; taken && (x < pSpec->length) &&
+         (specLength < sizeof(spec) - 13); x++) {
+        if (pFormat[x] == '*') {
+            taken = recordTake(pRecord, recordLength, pOffset, &intValue, sizeof(intValue));
+            if (taken) {
+                if (intValue >= 0) {
+                    specLength += snprintf(spec + specLength, sizeof(spec) - specLength,
+                                           "%d", intValue);
+                } else if ((x > 0) && (pFormat[x - 1] == '.')) {
+                    // Negative precision is as if it were not there
+                    specLength--;
+                } else {
+                    // Negative width is a '-' flag and a positive width
+                    specLength += snprintf(spec + specLength, sizeof(spec) - specLength,
+                                           "-%d", -intValue);
+                }
+            }
+        } else {
+            spec[specLength] = pFormat[x];
+            specLength++;
+        }
+    }
+    spec[specLength] = 0;
+
+    if (taken) {
+        switch (pSpec->type) {
+            case U_LOG_ARG_TYPE_INT:
+                taken = recordTake(pRecord, recordLength, pOffset, &intValue, sizeof(intValue));
+                break;
+            case U_LOG_ARG_TYPE_LONG:
+                taken = recordTake(pRecord, recordLength, pOffset, &longValue, sizeof(longValue));
+                break;
+            case U_LOG_ARG_TYPE_LONG_LONG:
+                taken = recordTake(pRecord, recordLength, pOffset,
+                                   &longLongValue, sizeof(longLongValue));
+                break;
+            case U_LOG_ARG_TYPE_SIZE:
+                taken = recordTake(pRecord, recordLength, pOffset, &sizeValue, sizeof(sizeValue));
+                break;
+            case U_LOG_ARG_TYPE_PTRDIFF:
+                taken = recordTake(pRecord, recordLength, pOffset,
+                                   &ptrdiffValue, sizeof(ptrdiffValue));
+                break;
+            case U_LOG_ARG_TYPE_INTMAX:
+                taken = recordTake(pRecord, recordLength, pOffset,
+                                   &intmaxValue, sizeof(intmaxValue));
+                break;
+            case U_LOG_ARG_TYPE_DOUBLE:
+                taken = recordTake(pRecord, recordLength, pOffset,
+                                   &doubleValue, sizeof(doubleValue));
+                break;
+            case U_LOG_ARG_TYPE_LONG_DOUBLE:
+                taken = recordTake(pRecord, recordLength, pOffset, &longDoubleValue,
+                                   sizeof(longDoubleValue));
+                break;
+            case U_LOG_ARG_TYPE_POINTER:
+                taken = recordTake(pRecord, recordLength, pOffset,
+                                   &pPointerValue, sizeof(pPointerValue));
+                break;
+            case U_LOG_ARG_TYPE_STRING:
+                taken = false;
+                if (*pOffset < recordLength) {
+                    pStringValue = pRecord + *pOffset;
+                    *pOffset += strlen(pStringValue) + 1;
+                    taken = true;
+                }
+                break;
+            case U_LOG_ARG_TYPE_NONE:
+                lineAddChar(pLine, '%');
+                break;
+            default:
+                taken = false;
+                break;
+        }
+    }
+
+    if (taken && (pSpec->type != U_LOG_ARG_TYPE_NONE)) {
+        // Format into what's left of the line; if it doesn't
+        // fit, output the line and try again with all of it
+        do {
+            retry = false;
+            space = sizeof(pLine->buffer) - pLine->length;
+            switch (pSpec->type) {
+                case U_LOG_ARG_TYPE_INT:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, intValue);
+                    break;
+                case U_LOG_ARG_TYPE_LONG:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, longValue);
+                    break;
+                case U_LOG_ARG_TYPE_LONG_LONG:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, longLongValue);
+                    break;
+                case U_LOG_ARG_TYPE_SIZE:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, sizeValue);
+                    break;
+                case U_LOG_ARG_TYPE_PTRDIFF:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, ptrdiffValue);
+                    break;
+                case U_LOG_ARG_TYPE_INTMAX:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, intmaxValue);
+                    break;
+                case U_LOG_ARG_TYPE_DOUBLE:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, doubleValue);
+                    break;
+                case U_LOG_ARG_TYPE_LONG_DOUBLE:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, longDoubleValue);
+                    break;
+                case U_LOG_ARG_TYPE_POINTER:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, pPointerValue);
+                    break;
+                case U_LOG_ARG_TYPE_STRING:
+                    length = snprintf(pLine->buffer + pLine->length, space, spec, pStringValue);
+                    break;
+                default:
+                    break;
+            }
+            if (length >= (int) space) {
+                if (pLine->length > 0) {
+                    lineFlush(pLine);
+                    retry = true;
+                } else {
+                    // Doesn't fit even on its own: it is truncated
+                    length = (int) space - 1;
+                }
+            }
+        } while (retry);
+        if (length > 0) {
+            pLine->length += length;
+        }
+    }
+
+    return taken;
+}
+
+// Format a record and output it.
+static void recordOutput(uLogLine_t *pLine, const char *pRecord)
+{
+    uint16_t recordLength;
+    size_t offset = U_LOG_RECORD_HEADER_LENGTH_BYTES;
+    const char *pFormat;
+    uLogSpec_t spec;
+    bool complete = true;
+
+    memcpy(&recordLength, pRecord, sizeof(recordLength));
+    memcpy((void *) &pFormat, pRecord + sizeof(recordLength), sizeof(pFormat));
+    while (complete && (*pFormat != 0)) {
+        if (*pFormat != '%') {
+            lineAddChar(pLine, *pFormat);
+            pFormat++;
+            continue;
+        }
+        pFormat++;
+        parseSpec(pFormat, &spec);
+        complete = formatSpec(pLine, pFormat, &spec, pRecord, recordLength, &offset);
+        pFormat += spec.length;
+    }
+    if (!complete) {
+        // The record was cut short: say so, keeping any newline
+        lineAddChar(pLine, '.');
+        lineAddChar(pLine, '.');
+        lineAddChar(pLine, '.');
+        if (strchr(pFormat, '\n') != NULL) {
+            lineAddChar(pLine, '\n');
+        }
+    }
+    lineFlush(pLine);
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: TASK
+ * -------------------------------------------------------------- */
+
+// Output everything in the ring buffer.
+static void drain()
+{
+    uint16_t recordLength;
+    int32_t numLost;
+
+    do {
+        // Busy from before the read until after the output,
+        // so that uLogDeferredFlush() can't miss a record
+        gTaskBusy = 1;
+        recordLength = 0;
+        if (uRingBufferPeek(&gRingBuffer, (char *) &recordLength,
+                            sizeof(recordLength), 0) == sizeof(recordLength)) {
+            if ((recordLength >= U_LOG_RECORD_HEADER_LENGTH_BYTES) &&
+                (recordLength <= sizeof(gRecord)) &&
+                (uRingBufferRead(&gRingBuffer, gRecord, recordLength) == recordLength)) {
+                recordOutput(&gLine, gRecord);
+            } else {
+                // Can't happen since records are added whole but,
+                // just in case, don't get stuck
+                uRingBufferReset(&gRingBuffer);
+                recordLength = 0;
+            }
+        }
+        gTaskBusy = 0;
+    } while (recordLength > 0);
+
+    numLost = U_ATOMIC_GET(&gNumLost);
+    if (numLost != gNumLostReported) {
+        gNumLostReported = numLost;
+        gLine.length = snprintf(gLine.buffer, sizeof(gLine.buffer),
+                                "U_LOG: %d print(s) lost.\n", (int) numLost);
+        lineFlush(&gLine);
+    }
+}
+
+// The task that formats and outputs the records.
+static void taskFunction(void *pParam)
+{
+    (void) pParam;
+
+    U_PORT_MUTEX_LOCK(gTaskRunningMutex);
+
+    while (!gTaskExit) {
+        uPortSemaphoreTake(gSemaphore);
+        drain();
+    }
+
+    U_PORT_MUTEX_UNLOCK(gTaskRunningMutex);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Start the deferred log.
+int32_t uLogDeferredInit(uLogDeferredOutput_t pOutput, void *pParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (!gInitialised) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        gpLinearBuffer = (char *) pUPortMalloc(U_LOG_DEFERRED_BUFFER_LENGTH_BYTES);
+        if (gpLinearBuffer != NULL) {
+            errorCode = uRingBufferCreate(&gRingBuffer, gpLinearBuffer,
+                                          U_LOG_DEFERRED_BUFFER_LENGTH_BYTES);
+            if (errorCode == 0) {
+                errorCode = uPortSemaphoreCreate(&gSemaphore, 0, 1);
+            }
+            if (errorCode == 0) {
+                errorCode = uPortMutexCreate(&gTaskRunningMutex);
+            }
+            if (errorCode == 0) {
+                gLine.length = 0;
+                gLine.pOutput = pOutput;
+                gLine.pOutputParam = pParam;
+                gTaskExit = false;
+                gTaskBusy = 0;
+                gNumLost = 0;
+                gNumLostReported = 0;
+                errorCode = uPortTaskCreate(taskFunction, "logDeferred",
+                                            U_LOG_DEFERRED_TASK_STACK_SIZE_BYTES,
+                                            NULL, U_LOG_DEFERRED_TASK_PRIORITY,
+                                            &gTaskHandle);
+                if (errorCode == 0) {
+                    // Wait for the task to lock the mutex,
+                    // which shows it is running
+                    while (uPortMutexTryLock(gTaskRunningMutex, 0) == 0) {
+                        uPortMutexUnlock(gTaskRunningMutex);
+                        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                    }
+                    U_ATOMIC_STORE_RELEASE(&gInitialised, true);
+                }
+            }
+        }
+        if (errorCode != 0) {
+            // Tidy up
+            if (gTaskRunningMutex != NULL) {
+                uPortMutexDelete(gTaskRunningMutex);
+                gTaskRunningMutex = NULL;
+            }
+            if (gSemaphore != NULL) {
+                uPortSemaphoreDelete(gSemaphore);
+                gSemaphore = NULL;
+            }
+            if (gpLinearBuffer != NULL) {
+                uRingBufferDelete(&gRingBuffer);
+                uPortFree(gpLinearBuffer);
+                gpLinearBuffer = NULL;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Stop the deferred log.
+void uLogDeferredDeinit()
+{
+    if (gInitialised) {
+        U_ATOMIC_STORE_RELEASE(&gInitialised, false);
+        // The task drains the ring buffer before it checks
+        // whether it should exit
+        gTaskExit = true;
+        uPortSemaphoreGive(gSemaphore);
+        U_PORT_MUTEX_LOCK(gTaskRunningMutex);
+        U_PORT_MUTEX_UNLOCK(gTaskRunningMutex);
+        // Let the task actually exit
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        uPortMutexDelete(gTaskRunningMutex);
+        gTaskRunningMutex = NULL;
+        uPortSemaphoreDelete(gSemaphore);
+        gSemaphore = NULL;
+        uRingBufferDelete(&gRingBuffer);
+        uPortFree(gpLinearBuffer);
+        gpLinearBuffer = NULL;
+        gTaskHandle = NULL;
+    }
+}
+
+// printf()-style deferred logging.
+void uLogDeferred(const char *pFormat, ...)
+{
+    char record[U_LOG_DEFERRED_RECORD_MAX_LENGTH_BYTES];
+    uLogLine_t line;
+    size_t length;
+    va_list args;
+
+    if (pFormat != NULL) {
+        va_start(args, pFormat);
+        length = recordFill(record, pFormat, args);
+        va_end(args);
+        if (U_ATOMIC_LOAD_ACQUIRE(&gInitialised)) {
+            if (uRingBufferAdd(&gRingBuffer, record, length)) {
+                uPortSemaphoreGive(gSemaphore);
+            } else {
+                U_ATOMIC_INCREMENT(&gNumLost);
+            }
+        } else {
+            // No task, format it here and now
+            line.length = 0;
+            line.pOutput = NULL;
+            line.pOutputParam = NULL;
+            recordOutput(&line, record);
+        }
+    }
+}
+
+// Wait for the deferred log to be output.
+int32_t uLogDeferredFlush(int32_t timeoutMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+
+    while (U_ATOMIC_LOAD_ACQUIRE(&gInitialised) &&
+           ((uRingBufferDataSize(&gRingBuffer) > 0) || gTaskBusy) &&
+           (errorCode == 0)) {
+        if (uPortGetTickTimeMs() - startTimeMs > timeoutMs) {
+            errorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        } else {
+            uPortTaskBlock(10);
+        }
+    }
+
+    return errorCode;
+}
+
+// Get the number of prints lost.
+int32_t uLogDeferredGetNumLost()
+{
+    return U_ATOMIC_GET(&gNumLost);
+}
+
+// End of file
@@ -33,6 +33,7 @@
 #include "stdbool.h"
 
 #include "u_cfg_sw.h"
+#include "u_compiler.h" // U_ATOMIC_xxx
 #include "u_assert.h"
 #include "u_port.h"
 #include "u_port_os.h"
@@ -41,6 +42,14 @@
 #include "u_mempool.h"
 #include "u_error_common.h"
 
+#ifndef U_CFG_LOG_LEVEL_MEMPOOL
+// The minimum level of the leveled logging of this module; buffer
+// allocation/freeing is logged at U_LOG_LEVEL_DEBUG.
+# define U_CFG_LOG_LEVEL_MEMPOOL U_CFG_LOG_LEVEL
+#endif
+#define U_LOG_MODULE_LEVEL U_CFG_LOG_LEVEL_MEMPOOL
+#include "u_log.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -52,11 +61,15 @@
 # define U_MEMPOOL_USE_BUF_FENCE 1
 #endif
 
+// Round a size up so that each block is aligned for a pointer.
+#define U_ALIGN_SIZE(size) \
+    (((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
 #if U_MEMPOOL_USE_BUF_FENCE
 # define U_REAL_BLOCK_SIZE(userBlockSize) \
-    (userBlockSize + sizeof(uint16_t))
+    U_ALIGN_SIZE(userBlockSize + sizeof(uint16_t))
 #else
-# define U_REAL_BLOCK_SIZE(userBlockSize) (userBlockSize)
+# define U_REAL_BLOCK_SIZE(userBlockSize) U_ALIGN_SIZE(userBlockSize)
 #endif
 
 #define U_BUFFER_SIZE(pMemPool) \
@@ -64,12 +77,23 @@
 
 #define U_FENCE_MAGIC 0xBEEF
 
+// The block index in the free list head that means "none".
+#define U_FREE_INDEX_NONE 0xFFFF
+
+// Make a new free list head from an old one and a block index:
+// the tag, the upper 16 bits, is incremented every time.
+#define U_FREE_HEAD(oldHead, index) \
+    ((((oldHead) + 0x10000) & 0xFFFF0000) | ((index) & 0xFFFF))
+
+#define U_BLOCK(pMemPool, index) \
+    ((uMemPoolFreeList_t *) &pMemPool->pBuffer[(index) * U_REAL_BLOCK_SIZE(pMemPool->blockSize)])
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
-typedef struct uMemPoolFree {
-    struct uMemPoolFree *pNext;
+typedef struct {
+    volatile uint32_t nextIndex;
 } uMemPoolFreeList_t;
 
 /* ----------------------------------------------------------------
@@ -86,21 +110,112 @@ typedef struct uMemPoolFree {
 
 static void initFreeList(uMemPoolDesc_t *pMemPool)
 {
-    // Initialize the freed linked list
+    // Initialize the free list
     U_ASSERT(pMemPool->pBuffer != NULL);
-    uMemPoolFreeList_t *pLastFree = (uMemPoolFreeList_t *)pMemPool->pBuffer;
-    pMemPool->pFreeList = pLastFree;
-    for (int i = 1; i < pMemPool->totalBlockCount; i++) {
-        uMemPoolFreeList_t *pFree;
-        size_t realBlockSize = U_REAL_BLOCK_SIZE(pMemPool->blockSize);
-        pFree = (uMemPoolFreeList_t *)&pMemPool->pBuffer[i * realBlockSize];
-        pLastFree->pNext = pFree;
-        pLastFree = pFree;
+    for (int32_t i = 0; i < pMemPool->totalBlockCount; i++) {
+        U_BLOCK(pMemPool, i)->nextIndex = i + 1;
     }
-    pLastFree->pNext = NULL;
+    U_BLOCK(pMemPool, pMemPool->totalBlockCount - 1)->nextIndex = U_FREE_INDEX_NONE;
+    U_ATOMIC_STORE_RELEASE(&pMemPool->freeHead, U_FREE_HEAD(pMemPool->freeHead, 0));
     pMemPool->usedBlockCount = 0;
 }
 
+// Take a block off the free list; the value of the nextIndex
+// read from a block may be stale if another thread has taken it
+// in the meantime, in which case the tag will have changed and
+// the compare-and-swap will fail.
+static void *popFree(uMemPoolDesc_t *pMemPool)
+{
+    uint32_t head;
+    uint32_t index;
+
+#ifdef _MSC_VER
+    // For MSVC the mutex is used instead: see the note against
+    // U_ATOMIC_LOAD_ACQUIRE() in u_compiler.h
+    void *pMem = NULL;
+
+    U_PORT_MUTEX_LOCK(pMemPool->mutex);
+
+    head = pMemPool->freeHead;
+    index = head & 0xFFFF;
+    if (index != U_FREE_INDEX_NONE) {
+        pMemPool->freeHead = U_FREE_HEAD(head, U_BLOCK(pMemPool, index)->nextIndex);
+        pMem = U_BLOCK(pMemPool, index);
+    }
+
+    U_PORT_MUTEX_UNLOCK(pMemPool->mutex);
+
+    return pMem;
+#else
+    do {
+        head = U_ATOMIC_LOAD_ACQUIRE(&pMemPool->freeHead);
+        index = head & 0xFFFF;
+        if (index == U_FREE_INDEX_NONE) {
+            return NULL;
+        }
+    } while (!U_ATOMIC_COMPARE_AND_SWAP(&pMemPool->freeHead, head,
+                                        U_FREE_HEAD(head, U_BLOCK(pMemPool, index)->nextIndex)));
+
+    return U_BLOCK(pMemPool, index);
+#endif
+}
+
+// Put a block back on the free list.
+static void pushFree(uMemPoolDesc_t *pMemPool, void *pMem)
+{
+    uMemPoolFreeList_t *pFree = (uMemPoolFreeList_t *) pMem;
+    uint32_t index = ((uint8_t *) pMem - pMemPool->pBuffer) /
+                     U_REAL_BLOCK_SIZE(pMemPool->blockSize);
+    uint32_t head;
+
+#ifdef _MSC_VER
+    // For MSVC the mutex is used instead, as in popFree()
+    U_PORT_MUTEX_LOCK(pMemPool->mutex);
+
+    head = pMemPool->freeHead;
+    pFree->nextIndex = head & 0xFFFF;
+    pMemPool->freeHead = U_FREE_HEAD(head, index);
+
+    U_PORT_MUTEX_UNLOCK(pMemPool->mutex);
+#else
+    do {
+        head = U_ATOMIC_LOAD_ACQUIRE(&pMemPool->freeHead);
+        pFree->nextIndex = head & 0xFFFF;
+    } while (!U_ATOMIC_COMPARE_AND_SWAP(&pMemPool->freeHead, head, U_FREE_HEAD(head, index)));
+#endif
+}
+
+// Allocate the data buffer of a pool, if that hasn't already been
+// done, returning true if there is a data buffer.
+static bool createBuffer(uMemPoolDesc_t *pMemPool)
+{
+    uint8_t *pBuffer = NULL;
+
+#ifndef _MSC_VER
+    // Not for MSVC, which always takes the mutex: see the note
+    // against U_ATOMIC_LOAD_ACQUIRE() in u_compiler.h
+    pBuffer = U_ATOMIC_LOAD_ACQUIRE(&pMemPool->pBuffer);
+#endif
+    if (pBuffer == NULL) {
+        U_PORT_MUTEX_LOCK(pMemPool->mutex);
+        // Check again now that we have the lock
+        pBuffer = pMemPool->pBuffer;
+        if (pBuffer == NULL) {
+            pBuffer = (uint8_t *)pUPortMalloc(U_BUFFER_SIZE(pMemPool));
+            U_LOG_DEBUG("U_MEM_POOL: allocated buffer %p.\n", pBuffer);
+            if (pBuffer != NULL) {
+                pMemPool->pBuffer = pBuffer;
+                initFreeList(pMemPool);
+                // Publish the buffer only once the free list is in place
+                U_ATOMIC_STORE_RELEASE(&pMemPool->pBuffer, pBuffer);
+            }
+        }
+        U_PORT_MUTEX_UNLOCK(pMemPool->mutex);
+    }
+
+    return (pBuffer != NULL);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -109,11 +224,13 @@ int32_t uMemPoolInit(uMemPoolDesc_t *pMemPool, uint32_t blockSize, int32_t blkCo
 {
     int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
 
-    if ((pMemPool != NULL) && (blockSize >= sizeof(uMemPoolFreeList_t))) {
+    if ((pMemPool != NULL) && (blockSize >= sizeof(uMemPoolFreeList_t)) &&
+        (blkCount > 0) && (blkCount <= U_MEMPOOL_MAX_NUM_BLOCKS)) {
         memset(pMemPool, 0, sizeof(uMemPoolDesc_t));
         pMemPool->blockSize = blockSize;
         pMemPool->usedBlockCount = 0;
         pMemPool->totalBlockCount = blkCount;
+        pMemPool->freeHead = U_FREE_INDEX_NONE;
 
         err = uPortMutexCreate(&pMemPool->mutex);
     }
@@ -128,7 +245,7 @@ void uMemPoolDeinit(uMemPoolDesc_t *pMemPool)
         U_PORT_MUTEX_LOCK(pMemPool->mutex);
 
         if (pMemPool->pBuffer != NULL) {
-            uPortLog("U_MEM_POOL: freeing buffer %p.\n", pMemPool->pBuffer);
+            U_LOG_DEBUG("U_MEM_POOL: freeing buffer %p.\n", pMemPool->pBuffer);
             uPortFree(pMemPool->pBuffer);
         }
         U_PORT_MUTEX_UNLOCK(pMemPool->mutex);
@@ -141,38 +258,35 @@ void uMemPoolDeinit(uMemPoolDesc_t *pMemPool)
 void *uMemPoolAllocMem(uMemPoolDesc_t *pMemPool)
 {
     void *pAllocMem = NULL;
+    int32_t used;
+    int32_t peak;
 
     if ((pMemPool != NULL) && (pMemPool->mutex != NULL)) {
 
-        U_PORT_MUTEX_LOCK(pMemPool->mutex);
-
         // If this is the first call to uMemPoolAllocMem we need to
         // allocate the buffer
-        if (pMemPool->pBuffer == NULL) {
-            pMemPool->pBuffer = (uint8_t *)pUPortMalloc(U_BUFFER_SIZE(pMemPool));
-            uPortLog("U_MEM_POOL: allocated buffer %p.\n", pMemPool->pBuffer);
-            if (pMemPool->pBuffer != NULL) {
-                initFreeList(pMemPool);
-            }
+        if (createBuffer(pMemPool)) {
+            // Grab the free memory available in the free list
+            pAllocMem = popFree(pMemPool);
         }
 
-        // Grab the free memory available in the free list
-        if (pMemPool->pFreeList) {
-            pAllocMem = pMemPool->pFreeList;
-            pMemPool->pFreeList = pMemPool->pFreeList->pNext;
-            pMemPool->usedBlockCount++;
-        }
-
-#if U_MEMPOOL_USE_BUF_FENCE
-        // Add the memory fence right after the user allocation
         if (pAllocMem != NULL) {
+            U_ATOMIC_INCREMENT(&pMemPool->usedBlockCount);
+            // Keep the high-water mark
+            used = U_ATOMIC_GET(&pMemPool->usedBlockCount);
+            do {
+                peak = U_ATOMIC_GET(&pMemPool->peakUsedBlockCount);
+            } while ((used > peak) &&
+                     !U_ATOMIC_COMPARE_AND_SWAP(&pMemPool->peakUsedBlockCount, peak, used));
+#if U_MEMPOOL_USE_BUF_FENCE
+            // Add the memory fence right after the user allocation
             uint8_t *pDataPtr = (uint8_t *)pAllocMem;
             uint16_t *pMagic = (uint16_t *)&pDataPtr[pMemPool->blockSize];
             *pMagic = U_FENCE_MAGIC;
-        }
 #endif
-
-        U_PORT_MUTEX_UNLOCK(pMemPool->mutex);
+        } else {
+            U_ATOMIC_INCREMENT(&pMemPool->failedAllocCount);
+        }
     }
 
     return pAllocMem;
@@ -180,10 +294,7 @@ void *uMemPoolAllocMem(uMemPoolDesc_t *pMemPool)
 
 void uMemPoolFreeMem(uMemPoolDesc_t *pMemPool, void *pMem)
 {
-    void *pMemNext;
-
     if ((pMemPool != NULL) && (pMem != NULL) && (pMemPool->mutex != NULL)) {
-        U_PORT_MUTEX_LOCK(pMemPool->mutex);
         // Make sure the memory segment is within our buffer
         U_ASSERT((uint8_t *)pMem >= pMemPool->pBuffer);
         U_ASSERT((uint8_t *)pMem < (pMemPool->pBuffer + U_BUFFER_SIZE(pMemPool)));
@@ -197,12 +308,9 @@ void uMemPoolFreeMem(uMemPoolDesc_t *pMemPool, void *pMem)
         *pMagic = 0;
 #endif
 
-        // Add the freed memory reference before the head
-        pMemNext = pMemPool->pFreeList;
-        pMemPool->pFreeList = (uMemPoolFreeList_t *)pMem;
-        pMemPool->pFreeList->pNext = (uMemPoolFreeList_t *)pMemNext;
-        pMemPool->usedBlockCount--;
-        U_PORT_MUTEX_UNLOCK(pMemPool->mutex);
+        // Put the freed memory back at the head of the free list
+        pushFree(pMemPool, pMem);
+        U_ATOMIC_DECREMENT(&pMemPool->usedBlockCount);
     }
 }
 
@@ -210,9 +318,101 @@ void uMemPoolFreeAllMem(uMemPoolDesc_t *pMemPool)
 {
     if ((pMemPool != NULL) && (pMemPool->mutex != NULL)) {
         U_PORT_MUTEX_LOCK(pMemPool->mutex);
-        initFreeList(pMemPool);
+        if (pMemPool->pBuffer != NULL) {
+            initFreeList(pMemPool);
+        }
         U_PORT_MUTEX_UNLOCK(pMemPool->mutex);
     }
 }
 
+int32_t uMemPoolStatsGet(const uMemPoolDesc_t *pMemPool, uMemPoolStats_t *pStats)
+{
+    int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pMemPool != NULL) && (pStats != NULL)) {
+        pStats->blockSize = pMemPool->blockSize;
+        pStats->totalBlockCount = pMemPool->totalBlockCount;
+        pStats->usedBlockCount = U_ATOMIC_GET(&pMemPool->usedBlockCount);
+        pStats->peakUsedBlockCount = U_ATOMIC_GET(&pMemPool->peakUsedBlockCount);
+        pStats->failedAllocCount = U_ATOMIC_GET(&pMemPool->failedAllocCount);
+        err = (int32_t)U_ERROR_COMMON_SUCCESS;
+    }
+
+    return err;
+}
+
+int32_t uMemPoolClassesInit(uMemPoolClasses_t *pClasses,
+                            const uint32_t *pBlockSize,
+                            const int32_t *pNumOfBlks,
+                            size_t numClasses)
+{
+    int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pClasses != NULL) && (pBlockSize != NULL) && (pNumOfBlks != NULL) &&
+        (numClasses > 0) && (numClasses <= U_MEMPOOL_CLASSES_MAX_NUM)) {
+        memset(pClasses, 0, sizeof(*pClasses));
+        err = (int32_t)U_ERROR_COMMON_SUCCESS;
+        for (size_t x = 0; (x < numClasses) && (err == 0); x++) {
+            // The classes must be in increasing order of size
+            if ((x == 0) || (pBlockSize[x] > pBlockSize[x - 1])) {
+                err = uMemPoolInit(&pClasses->pool[x], pBlockSize[x], pNumOfBlks[x]);
+            } else {
+                err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+            }
+            if (err == 0) {
+                pClasses->numClasses++;
+            }
+        }
+        if (err != 0) {
+            uMemPoolClassesDeinit(pClasses);
+        }
+    }
+
+    return err;
+}
+
+void uMemPoolClassesDeinit(uMemPoolClasses_t *pClasses)
+{
+    if (pClasses != NULL) {
+        for (size_t x = 0; x < pClasses->numClasses; x++) {
+            uMemPoolDeinit(&pClasses->pool[x]);
+        }
+        pClasses->numClasses = 0;
+    }
+}
+
+void *uMemPoolClassesAllocMem(uMemPoolClasses_t *pClasses, size_t size)
+{
+    void *pAllocMem = NULL;
+
+    if (pClasses != NULL) {
+        for (size_t x = 0; (x < pClasses->numClasses) && (pAllocMem == NULL); x++) {
+            if (size <= pClasses->pool[x].blockSize) {
+                pAllocMem = uMemPoolAllocMem(&pClasses->pool[x]);
+            }
+        }
+    }
+
+    return pAllocMem;
+}
+
+void uMemPoolClassesFreeMem(uMemPoolClasses_t *pClasses, void *pMem)
+{
+    uMemPoolDesc_t *pMemPool;
+    bool found = false;
+
+    if ((pClasses != NULL) && (pMem != NULL)) {
+        // Find the pool by address
+        for (size_t x = 0; (x < pClasses->numClasses) && !found; x++) {
+            pMemPool = &pClasses->pool[x];
+            if ((pMemPool->pBuffer != NULL) && ((uint8_t *)pMem >= pMemPool->pBuffer) &&
+                ((uint8_t *)pMem < (pMemPool->pBuffer + U_BUFFER_SIZE(pMemPool)))) {
+                uMemPoolFreeMem(pMemPool, pMem);
+                found = true;
+            }
+        }
+        U_ASSERT(found);
+    }
+}
+
 // End of file
@@ -56,6 +56,22 @@
  */
 #define U_RINGBUFFER_PREFIX "U_RINGBUFFER: "
 
+/** Helper to lock the ring buffer mutex, unless the ring buffer
+ * is lock-free (see uRingBufferCreateLockFree()), in which case
+ * the operations that use this are safe without it; like
+ * U_PORT_MUTEX_LOCK() this opens a brace so it must always be
+ * balanced with U_RINGBUFFER_UNLOCK().
+ */
+#define U_RINGBUFFER_LOCK(pRingBuffer) { if (!(pRingBuffer)->isLockFree) {                      \
+                                             uPortMutexLock((uPortMutexHandle_t) (pRingBuffer)->mutex); \
+                                         }
+
+/** Helper to unlock the ring buffer mutex, see U_RINGBUFFER_LOCK().
+ */
+#define U_RINGBUFFER_UNLOCK(pRingBuffer) if (!(pRingBuffer)->isLockFree) {                        \
+                                             uPortMutexUnlock((uPortMutexHandle_t) (pRingBuffer)->mutex); \
+                                         } }
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -118,6 +134,76 @@ static U_INLINE const char *pPtrOffset(const char *pData, size_t offset,
     return pData;
 }
 
+// Copy length bytes out of the ring buffer, starting at pSource,
+// into pData (which may be NULL if the data is to be thrown away),
+// in at most two contiguous chunks, returning the new source pointer.
+// The caller must have checked that length bytes are available.
+static const char *copyOut(char *pData, const char *pSource, size_t length,
+                           const char *pBuffer, size_t bufferSize)
+{
+    size_t chunk = (pBuffer + bufferSize) - pSource;
+
+    if (chunk > length) {
+        chunk = length;
+    }
+    if (pData != NULL) {
+        memcpy(pData, pSource, chunk);
+        // Second chunk, if there is one, starts at the beginning
+        // of the linear buffer
+        memcpy(pData + chunk, pBuffer, length - chunk);
+    }
+
+    return pPtrOffset(pSource, length, pBuffer, bufferSize);
+}
+
+// Copy length bytes from pData into the ring buffer at pDest
+// in at most two contiguous chunks, returning the new write
+// pointer.  The caller must have checked that there is room.
+static char *copyIn(char *pDest, const char *pData, size_t length,
+                    char *pBuffer, size_t bufferSize)
+{
+    size_t chunk = (pBuffer + bufferSize) - pDest;
+
+    if (chunk > length) {
+        chunk = length;
+    }
+    memcpy(pDest, pData, chunk);
+    memcpy(pBuffer, pData + chunk, length - chunk);
+
+    return (char *) pPtrOffset(pDest, length, pBuffer, bufferSize);
+}
+
+// Get the write pointer: an acquire since, for a lock-free ring
+// buffer, this may be called by the consumer while the producer
+// is writing it.
+static U_INLINE char *pGetWrite(const uRingBuffer_t *pRingBuffer)
+{
+    return U_ATOMIC_LOAD_ACQUIRE(&(pRingBuffer->pDataWrite));
+}
+
+// Set the write pointer: a release so that, for a lock-free ring
+// buffer, the consumer sees the data before it sees the pointer move.
+static U_INLINE void setWrite(uRingBuffer_t *pRingBuffer, char *pWrite)
+{
+    U_ATOMIC_STORE_RELEASE(&(pRingBuffer->pDataWrite), pWrite);
+}
+
+// Get a read pointer, acquire for the same reason as pGetWrite().
+static U_INLINE const char *pGetRead(const uRingBuffer_t *pRingBuffer,
+                                     size_t x)
+{
+    return U_ATOMIC_LOAD_ACQUIRE(&(pRingBuffer->pDataRead[x]));
+}
+
+// Set a read pointer: a release so that, for a lock-free ring
+// buffer, the producer does not overwrite data before the consumer
+// has finished with it.
+static U_INLINE void setRead(uRingBuffer_t *pRingBuffer, size_t x,
+                             const char *pRead)
+{
+    U_ATOMIC_STORE_RELEASE(&(pRingBuffer->pDataRead[x]), pRead);
+}
+
 // The ring buffer's mutex should be locked before this is called
 static void bufferReset(uRingBuffer_t *pRingBuffer)
 {
@@ -154,32 +240,29 @@ static size_t read(uRingBuffer_t *pRingBuffer, int32_t handle, char *pData,
     if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
         (pRingBuffer->pDataRead[handle] != NULL)) {
 
-        pSource = pPtrOffset(pRingBuffer->pDataRead[handle], offset,
+        pSource = pPtrOffset(pGetRead(pRingBuffer, handle), offset,
                              pRingBuffer->pBuffer, pRingBuffer->size);
-        available = ptrDiff(pSource, pRingBuffer->pDataWrite, pRingBuffer->size);
+        available = ptrDiff(pSource, pGetWrite(pRingBuffer), pRingBuffer->size);
         if (length > available) {
             length = available;
         }
 
-        while (bytesRead < length) {
-            if (pData != NULL) {
-                *pData = *pSource;
-                pData++;
-            }
-            pSource = pPtrInc(pSource, pRingBuffer->pBuffer, pRingBuffer->size);
-            bytesRead++;
-        }
+        pSource = copyOut(pData, pSource, length, pRingBuffer->pBuffer,
+                          pRingBuffer->size);
+        bytesRead = length;
         if (destructive) {
-            pRingBuffer->pDataRead[handle] = pSource;
+            setRead(pRingBuffer, handle, pSource);
         }
     }
 
     return bytesRead;
 }
 
+// Make room for length bytes in the ring buffer, moving read
+// pointers on where that is permitted.
 // The ring buffer's mutex should be locked before this is called
-static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
-                size_t length, bool destructive)
+static bool makeRoom(uRingBuffer_t *pRingBuffer, size_t length,
+                     bool destructive)
 {
     bool dataFitsInBuffer = true;
     size_t lost;
@@ -191,15 +274,18 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
         for (size_t x = 0; (x < pRingBuffer->maxNumReadPointers) &&
              (dataFitsInBuffer || destructive); x++) {
             if (pRingBuffer->pDataRead[x] != NULL) {
-                used = ptrDiff(pRingBuffer->pDataRead[x], pRingBuffer->pDataWrite, pRingBuffer->size);
+                used = ptrDiff(pGetRead(pRingBuffer, x), pRingBuffer->pDataWrite, pRingBuffer->size);
                 used++; // Account for the fact that we can't have the pointers overlap
                 if (used + length > pRingBuffer->size) {
                     // If we're on the "normal" read pointer (0) and it can't be used (because
                     // of the readHandleRequired flag) OR we are being destructive (so a
                     // forced add) and this data read pointer is not locked, then we
                     // throw away enough data to make it fit.
-                    if (((x == 0) && pRingBuffer->readHandleRequired) ||
-                        (destructive && ((x == 0) || (pRingBuffer->dataReadLockBitmap & (1ULL << (x - 1))) == 0))) {
+                    // A lock-free ring buffer can never do this as the
+                    // read pointer belongs to the consumer.
+                    if (!pRingBuffer->isLockFree &&
+                        (((x == 0) && pRingBuffer->readHandleRequired) ||
+                         (destructive && ((x == 0) || (pRingBuffer->dataReadLockBitmap & (1ULL << (x - 1))) == 0)))) {
                         lost = read(pRingBuffer, x, NULL, used + length - pRingBuffer->size, 0, true);
                         if (x == 0) {
                             pRingBuffer->statReadLossNormalBytes += lost;
@@ -214,14 +300,18 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
         }
     }
 
+    return dataFitsInBuffer;
+}
+
+// The ring buffer's mutex should be locked before this is called
+static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
+                size_t length, bool destructive)
+{
+    bool dataFitsInBuffer = makeRoom(pRingBuffer, length, destructive);
+
     if (dataFitsInBuffer) {
-        while (length > 0) {
-            *(pRingBuffer->pDataWrite) = *pData;
-            pRingBuffer->pDataWrite = (char *) pPtrInc(pRingBuffer->pDataWrite, pRingBuffer->pBuffer,
-                                                       pRingBuffer->size);
-            length--;
-            pData++;
-        }
+        setWrite(pRingBuffer, copyIn(pRingBuffer->pDataWrite, pData, length,
+                                     pRingBuffer->pBuffer, pRingBuffer->size));
     } else {
         pRingBuffer->statAddLossBytes += length;
     }
@@ -229,6 +319,32 @@ static bool add(uRingBuffer_t *pRingBuffer, const char *pData,
     return dataFitsInBuffer;
 }
 
+// Populate an array of U_RING_BUFFER_SPAN_MAX_NUM spans to describe
+// length bytes of the ring buffer beginning at pStart, returning
+// length; pStart and pBuffer may be NULL if length is zero.
+static size_t fillSpans(uRingBufferSpan_t *pSpans, const char *pStart,
+                        size_t length, char *pBuffer, size_t bufferSize)
+{
+    size_t chunk;
+
+    memset(pSpans, 0, sizeof(uRingBufferSpan_t) * U_RING_BUFFER_SPAN_MAX_NUM);
+    if (length > 0) {
+        chunk = (pBuffer + bufferSize) - pStart;
+        if (chunk > length) {
+            chunk = length;
+        }
+        // Casting away const here since the span may be a write span
+        pSpans[0].pData = (char *) pStart;
+        pSpans[0].length = chunk;
+        if (length > chunk) {
+            pSpans[1].pData = pBuffer;
+            pSpans[1].length = length - chunk;
+        }
+    }
+
+    return length;
+}
+
 // This function does the ring buffer mutex locking itself.
 static size_t lock(uRingBuffer_t *pRingBuffer, int32_t handle, bool lockNotUnlock)
 {
@@ -239,6 +355,9 @@ static size_t lock(uRingBuffer_t *pRingBuffer, int32_t handle, bool lockNotUnloc
         U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
 
         if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers)) {
+            // An explicit lock or unlock takes over from any lock
+            // taken by uRingBufferReadSpanAcquireHandle()
+            pRingBuffer->spanReadLockBitmap &= ~(1ULL << (handle - 1));
             if (lockNotUnlock) {
                 pRingBuffer->dataReadLockBitmap |= 1ULL << (handle - 1);
                 dataSize = ptrDiff(pRingBuffer->pDataRead[handle], pRingBuffer->pDataWrite, pRingBuffer->size);
@@ -253,51 +372,60 @@ static size_t lock(uRingBuffer_t *pRingBuffer, int32_t handle, bool lockNotUnloc
     return dataSize;
 }
 
-// This function does the ring buffer mutex locking itself.
-static size_t availableSize(const uRingBuffer_t *pRingBuffer, bool max)
+// The ring buffer's mutex should be locked before this is called
+static size_t availableSizeUnprotected(const uRingBuffer_t *pRingBuffer, bool max)
 {
-    size_t size = 0;
+    size_t size = pRingBuffer->size;
     size_t y = 0;
     bool foundADataReadPointer = false;
 
-    if (pRingBuffer->pBuffer != NULL) {
-
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
-
-        size = pRingBuffer->size;
-        for (size_t x = 0; x < pRingBuffer->maxNumReadPointers; x++) {
-            // If a read handle is required we ignore the data behind
-            // the "normal" read pointer as it's not possible to get
-            // at it
-            if ((pRingBuffer->pDataRead[x] != NULL) &&
-                ((x > 0) || !pRingBuffer->readHandleRequired)) {
-                // If we're doing max then we only take into account
-                // locked data buffer pointers and we ignore 0 since
-                // it is not lockable
-                if (!max || ((x > 0) && (pRingBuffer->dataReadLockBitmap & (1ULL << (x - 1))))) {
-                    y = pRingBuffer->size - ptrDiff(pRingBuffer->pDataRead[x], pRingBuffer->pDataWrite,
-                                                    pRingBuffer->size);
-                    if (y < size) {
-                        size = y;
-                    }
-                    foundADataReadPointer = true;
+    for (size_t x = 0; x < pRingBuffer->maxNumReadPointers; x++) {
+        // If a read handle is required we ignore the data behind
+        // the "normal" read pointer as it's not possible to get
+        // at it
+        if ((pRingBuffer->pDataRead[x] != NULL) &&
+            ((x > 0) || !pRingBuffer->readHandleRequired)) {
+            // If we're doing max then we only take into account
+            // locked data buffer pointers and we ignore 0 since
+            // it is not lockable
+            if (!max || ((x > 0) && (pRingBuffer->dataReadLockBitmap & (1ULL << (x - 1))))) {
+                y = pRingBuffer->size - ptrDiff(pGetRead(pRingBuffer, x), pGetWrite(pRingBuffer),
+                                                pRingBuffer->size);
+                if (y < size) {
+                    size = y;
                 }
+                foundADataReadPointer = true;
             }
         }
+    }
 
-        if (!max && !foundADataReadPointer) {
-            // If we didn't find a single data read pointer,
-            // and we're not doing max, report what is in the
-            // buffer anyway
-            size = pRingBuffer->size - ptrDiff(pRingBuffer->pBuffer, pRingBuffer->pDataWrite,
-                                               pRingBuffer->size);
-        }
-        if (size > 0) {
-            //  Must keep one to prevent pointer wrap
-            size--;
-        }
+    if (!max && !foundADataReadPointer) {
+        // If we didn't find a single data read pointer,
+        // and we're not doing max, report what is in the
+        // buffer anyway
+        size = pRingBuffer->size - ptrDiff(pRingBuffer->pBuffer, pGetWrite(pRingBuffer),
+                                           pRingBuffer->size);
+    }
+    if (size > 0) {
+        //  Must keep one to prevent pointer wrap
+        size--;
+    }
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    return size;
+}
+
+// This function does the ring buffer mutex locking itself.
+static size_t availableSize(const uRingBuffer_t *pRingBuffer, bool max)
+{
+    size_t size = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_RINGBUFFER_LOCK(pRingBuffer);
+
+        size = availableSizeUnprotected(pRingBuffer, max);
+
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 
     return size;
@@ -398,6 +526,22 @@ int32_t uRingBufferCreate(uRingBuffer_t *pRingBuffer, char *pLinearBuffer, size_
     return createCommon(pRingBuffer, pLinearBuffer, size);
 }
 
+int32_t uRingBufferCreateLockFree(uRingBuffer_t *pRingBuffer, char *pLinearBuffer,
+                                  size_t size)
+{
+    int32_t errorCode = uRingBufferCreate(pRingBuffer, pLinearBuffer, size);
+
+#ifndef _MSC_VER
+    // Not for MSVC: see the note against U_ATOMIC_LOAD_ACQUIRE()
+    // in u_compiler.h
+    if (errorCode == 0) {
+        pRingBuffer->isLockFree = true;
+    }
+#endif
+
+    return errorCode;
+}
+
 void uRingBufferDelete(uRingBuffer_t *pRingBuffer)
 {
     if ((pRingBuffer != NULL) && (pRingBuffer->mutex != NULL)) {
@@ -420,11 +564,11 @@ bool uRingBufferAdd(uRingBuffer_t *pRingBuffer, const char *pData, size_t length
 
     if (pRingBuffer->pBuffer != NULL) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
         dataFitsInBuffer = add(pRingBuffer, pData, length, false);
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 
     return dataFitsInBuffer;
@@ -436,11 +580,11 @@ bool uRingBufferForceAdd(uRingBuffer_t *pRingBuffer, const char *pData, size_t l
 
     if (pRingBuffer->pBuffer != NULL) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
         dataFitsInBuffer = add(pRingBuffer, pData, length, true);
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 
     return dataFitsInBuffer;
@@ -452,11 +596,11 @@ size_t uRingBufferRead(uRingBuffer_t *pRingBuffer, char *pData, size_t length)
 
     if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
         bytesRead = read(pRingBuffer, 0, pData, length, 0, true);
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 
     return bytesRead;
@@ -469,11 +613,11 @@ size_t uRingBufferPeek(uRingBuffer_t *pRingBuffer, char *pData, size_t length,
 
     if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
         bytesRead = read(pRingBuffer, 0, pData, length, offset, false);
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 
     return bytesRead;
@@ -485,14 +629,14 @@ size_t uRingBufferDataSize(const uRingBuffer_t *pRingBuffer)
 
     if (pRingBuffer->pBuffer != NULL) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
         if (!pRingBuffer->readHandleRequired) {
             // Only report if the non-handled read can be used
-            dataSize = ptrDiff(pRingBuffer->pDataRead[0], pRingBuffer->pDataWrite, pRingBuffer->size);
+            dataSize = ptrDiff(pGetRead(pRingBuffer, 0), pGetWrite(pRingBuffer), pRingBuffer->size);
         }
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 
     return dataSize;
@@ -507,11 +651,11 @@ void uRingBufferFlush(uRingBuffer_t *pRingBuffer)
 {
     if (pRingBuffer->pBuffer != NULL) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
-        pRingBuffer->pDataRead[0] = pRingBuffer->pDataWrite;
+        setRead(pRingBuffer, 0, pGetWrite(pRingBuffer));
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 }
 
@@ -523,21 +667,21 @@ void uRingBufferFlushValue(uRingBuffer_t *pRingBuffer, char value, size_t length
 
     if (pRingBuffer->pBuffer != NULL) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
-        pData = pRingBuffer->pDataRead[0];
-        dataSize = ptrDiff(pData, pRingBuffer->pDataWrite, pRingBuffer->size);
+        pData = pGetRead(pRingBuffer, 0);
+        dataSize = ptrDiff(pData, pGetWrite(pRingBuffer), pRingBuffer->size);
         if (dataSize >= length) {
             while ((bytesRead < dataSize) && (*pData == value)) {
                 pData = pPtrInc(pData, pRingBuffer->pBuffer, pRingBuffer->size);
                 bytesRead++;
             }
             if (bytesRead >= length) {
-                pRingBuffer->pDataRead[0] = pData;
+                setRead(pRingBuffer, 0, pData);
             }
         }
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 }
 
@@ -559,11 +703,11 @@ size_t uRingBufferStatReadLoss(uRingBuffer_t *pRingBuffer)
 
     if (pRingBuffer->pBuffer != NULL) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
         bytesLost = pRingBuffer->statReadLossNormalBytes;
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 
     return bytesLost;
@@ -575,11 +719,11 @@ size_t uRingBufferStatAddLoss(uRingBuffer_t *pRingBuffer)
 
     if (pRingBuffer->pBuffer != NULL) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
         bytesLost = pRingBuffer->statAddLossBytes;
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 
     return bytesLost;
@@ -677,6 +821,7 @@ void uRingBufferGiveReadHandle(uRingBuffer_t *pRingBuffer, int32_t handle)
         if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers)) {
             pRingBuffer->pDataRead[handle] = NULL;
             pRingBuffer->dataReadLockBitmap &= ~(1ULL << (handle - 1));
+            pRingBuffer->spanReadLockBitmap &= ~(1ULL << (handle - 1));
         }
 
         U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
@@ -808,6 +953,180 @@ size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
     return bytesLost;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: SPANS
+ * -------------------------------------------------------------- */
+
+size_t uRingBufferWriteSpanAcquire(uRingBuffer_t *pRingBuffer,
+                                   uRingBufferSpan_t *pSpans)
+{
+    size_t length = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_RINGBUFFER_LOCK(pRingBuffer);
+
+        length = fillSpans(pSpans, pRingBuffer->pDataWrite,
+                           availableSizeUnprotected(pRingBuffer, false),
+                           pRingBuffer->pBuffer, pRingBuffer->size);
+
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
+    } else {
+        memset(pSpans, 0, sizeof(uRingBufferSpan_t) * U_RING_BUFFER_SPAN_MAX_NUM);
+    }
+
+    return length;
+}
+
+size_t uRingBufferForceWriteSpanAcquire(uRingBuffer_t *pRingBuffer,
+                                        size_t length,
+                                        uRingBufferSpan_t *pSpans)
+{
+    size_t available = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_RINGBUFFER_LOCK(pRingBuffer);
+
+        if (makeRoom(pRingBuffer, length, true)) {
+            available = availableSizeUnprotected(pRingBuffer, false);
+        }
+        fillSpans(pSpans, pRingBuffer->pDataWrite, available,
+                  pRingBuffer->pBuffer, pRingBuffer->size);
+
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
+    } else {
+        memset(pSpans, 0, sizeof(uRingBufferSpan_t) * U_RING_BUFFER_SPAN_MAX_NUM);
+    }
+
+    return available;
+}
+
+size_t uRingBufferWriteSpanCommit(uRingBuffer_t *pRingBuffer, size_t length)
+{
+    size_t available;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_RINGBUFFER_LOCK(pRingBuffer);
+
+        available = availableSizeUnprotected(pRingBuffer, false);
+        if (length > available) {
+            length = available;
+        }
+        // Non-destructive, this will only move the "normal" read
+        // pointer on if it is not in use
+        if (makeRoom(pRingBuffer, length, false)) {
+            setWrite(pRingBuffer, (char *) pPtrOffset(pRingBuffer->pDataWrite, length,
+                                                      pRingBuffer->pBuffer,
+                                                      pRingBuffer->size));
+        } else {
+            length = 0;
+        }
+
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
+    } else {
+        length = 0;
+    }
+
+    return length;
+}
+
+size_t uRingBufferReadSpanAcquire(uRingBuffer_t *pRingBuffer,
+                                  uRingBufferSpan_t *pSpans)
+{
+    size_t length = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
+
+        U_RINGBUFFER_LOCK(pRingBuffer);
+
+        length = fillSpans(pSpans, pGetRead(pRingBuffer, 0),
+                           ptrDiff(pGetRead(pRingBuffer, 0), pGetWrite(pRingBuffer),
+                                   pRingBuffer->size),
+                           pRingBuffer->pBuffer, pRingBuffer->size);
+
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
+    } else {
+        memset(pSpans, 0, sizeof(uRingBufferSpan_t) * U_RING_BUFFER_SPAN_MAX_NUM);
+    }
+
+    return length;
+}
+
+size_t uRingBufferReadSpanCommit(uRingBuffer_t *pRingBuffer, size_t length)
+{
+    size_t bytesRead = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && !pRingBuffer->readHandleRequired) {
+
+        U_RINGBUFFER_LOCK(pRingBuffer);
+
+        bytesRead = read(pRingBuffer, 0, NULL, length, 0, true);
+
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
+    }
+
+    return bytesRead;
+}
+
+size_t uRingBufferReadSpanAcquireHandle(uRingBuffer_t *pRingBuffer,
+                                        int32_t handle,
+                                        uRingBufferSpan_t *pSpans)
+{
+    size_t length = 0;
+
+    memset(pSpans, 0, sizeof(uRingBufferSpan_t) * U_RING_BUFFER_SPAN_MAX_NUM);
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            // Lock the read handle so that a forced add cannot
+            // push the data out from under the caller, remembering
+            // if it is us that locked it
+            if ((pRingBuffer->dataReadLockBitmap & (1ULL << (handle - 1))) == 0) {
+                pRingBuffer->dataReadLockBitmap |= 1ULL << (handle - 1);
+                pRingBuffer->spanReadLockBitmap |= 1ULL << (handle - 1);
+            }
+            length = fillSpans(pSpans, pRingBuffer->pDataRead[handle],
+                               ptrDiff(pRingBuffer->pDataRead[handle],
+                                       pRingBuffer->pDataWrite, pRingBuffer->size),
+                               pRingBuffer->pBuffer, pRingBuffer->size);
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return length;
+}
+
+size_t uRingBufferReadSpanCommitHandle(uRingBuffer_t *pRingBuffer,
+                                       int32_t handle, size_t length)
+{
+    size_t bytesRead = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 1) && (handle < (int32_t) pRingBuffer->maxNumReadPointers)) {
+            bytesRead = read(pRingBuffer, handle, NULL, length, 0, true);
+            // Only unlock the read handle if it was locked by
+            // uRingBufferReadSpanAcquireHandle()
+            if (pRingBuffer->spanReadLockBitmap & (1ULL << (handle - 1))) {
+                pRingBuffer->dataReadLockBitmap &= ~(1ULL << (handle - 1));
+                pRingBuffer->spanReadLockBitmap &= ~(1ULL << (handle - 1));
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return bytesRead;
+}
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: PARSER
  * -------------------------------------------------------------- */
@@ -819,13 +1138,13 @@ size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
 
     if (pRingBuffer->pBuffer != NULL) {
 
-        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_LOCK(pRingBuffer);
 
         if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
             (pRingBuffer->pDataRead[handle] != NULL)) {
             const char *pOffset = pPtrOffset(pRingBuffer->pDataRead[handle], 0, pRingBuffer->pBuffer,
                                              pRingBuffer->size);
-            size_t bytesAvailable = ptrDiff(pOffset, pRingBuffer->pDataWrite, pRingBuffer->size);
+            size_t bytesAvailable = ptrDiff(pOffset, pGetWrite(pRingBuffer), pRingBuffer->size);
             size_t bytesDiscard  = 0;
             errorCodeOrLength = U_ERROR_COMMON_TIMEOUT;
             while (bytesAvailable) {
@@ -861,12 +1180,85 @@ size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
             }
         }
 
-        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
     }
 
     return errorCodeOrLength;
 }
 
+int32_t uRingBufferParseBatchHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                    U_RING_BUFFER_PARSER_f *pParserList,
+                                    void *pUserParams, size_t userParamSize,
+                                    uRingBufferParseRecord_t *pRecords,
+                                    size_t maxNumRecords, size_t *pOffsetEnd)
+{
+    int32_t errorCodeOrNumRecords = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t offset = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && (pParserList != NULL) &&
+        (pRecords != NULL)) {
+
+        U_RINGBUFFER_LOCK(pRingBuffer);
+
+        if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            const char *pOffset = pPtrOffset(pRingBuffer->pDataRead[handle], 0, pRingBuffer->pBuffer,
+                                             pRingBuffer->size);
+            size_t bytesAvailable = ptrDiff(pOffset, pGetWrite(pRingBuffer), pRingBuffer->size);
+            size_t numRecords = 0;
+            bool keepGoing = true;
+            while ((bytesAvailable > 0) && (numRecords < maxNumRecords) && keepGoing) {
+                U_RING_BUFFER_PARSER_f *pParser = pParserList;
+                char *pUserParam = (char *) pUserParams + (numRecords * userParamSize);
+                int32_t errorCode = U_ERROR_COMMON_NOT_FOUND;
+                size_t bytesParsed = 0;
+                // Find the right protocol
+                while ((*pParser != NULL) && (errorCode == U_ERROR_COMMON_NOT_FOUND)) {
+                    uRingBufferParseContext_t ctx = {
+                        .pRingBuffer    = pRingBuffer,
+                        .pSource        = pOffset,
+                        .bytesAvailable = bytesAvailable,
+                        .bytesParsed    = 0,
+                        .bytesDiscard   = 0
+                    };
+                    errorCode = (*pParser)(&ctx, pUserParam);
+                    bytesParsed = ctx.bytesParsed;
+                    pParser++;
+                }
+                if ((errorCode == U_ERROR_COMMON_SUCCESS) && (bytesParsed > 0)) {
+                    // A complete message: record it and move past it
+                    pRecords[numRecords].offset = offset;
+                    pRecords[numRecords].length = bytesParsed;
+                    pRecords[numRecords].parserIndex = (int32_t) (pParser - pParserList) - 1;
+                    numRecords++;
+                    pOffset = pPtrOffset(pOffset, bytesParsed, pRingBuffer->pBuffer,
+                                         pRingBuffer->size);
+                    offset += bytesParsed;
+                    bytesAvailable -= bytesParsed;
+                } else if (errorCode == U_ERROR_COMMON_NOT_FOUND) {
+                    // Junk: step over it
+                    pOffset = pPtrInc(pOffset, pRingBuffer->pBuffer, pRingBuffer->size);
+                    offset++;
+                    bytesAvailable--;
+                } else {
+                    // The start of a message that is not yet
+                    // complete: leave it for next time
+                    keepGoing = false;
+                }
+            }
+            errorCodeOrNumRecords = (int32_t) numRecords;
+        }
+
+        U_RINGBUFFER_UNLOCK(pRingBuffer);
+    }
+
+    if (pOffsetEnd != NULL) {
+        *pOffsetEnd = offset;
+    }
+
+    return errorCodeOrNumRecords;
+}
+
 bool uRingBufferGetByteUnprotected(uParseHandle_t parseHandle, void *p)
 {
     uRingBufferParseContext_t *pCtx = (uRingBufferParseContext_t *)parseHandle;
@@ -0,0 +1,319 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Implementation of the binary trace.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_compiler.h" // U_ATOMIC_XXX()
+
+#include "u_cfg_sw.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_heap.h"
+#include "u_port_debug.h"
+
+#include "u_trace.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The magic word at the start of a trace ring: "UTRC".
+ */
+#define U_TRACE_MAGIC_WORD 0x55545243
+
+/** The prefix on the lines printed by uTraceDump(), which
+ * u_trace_decode.py looks for.
+ */
+#define U_TRACE_DUMP_PREFIX "U_TRACE: "
+
+/** Get a pointer to the entry of a trace ring with the given index.
+ */
+#define U_TRACE_RING_ENTRY(pRing, index) (((uTraceEntry_t *) ((pRing) + 1)) + \
+                                          ((index) & ((pRing)->numEntries - 1)))
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The global trace ring.
+ */
+static uTraceRing_t *gpTraceRing = NULL;
+
+/** Keep track of whether we allocated gpTraceRing.
+ */
+static bool gTraceRingMalloced = false;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return a 16-bit tag for the current task, for the Chrome
+// trace viewer to put each task's events on its own row.
+static uint32_t taskTag()
+{
+    uPortTaskHandle_t taskHandle = NULL;
+    uintptr_t x;
+
+    uPortTaskGetHandle(&taskHandle);
+    x = (uintptr_t) taskHandle;
+    // Task handles are generally pointers, which have not
+    // much in their bottom bits, so mix them down
+    x ^= x >> 16;
+#if UINTPTR_MAX > 0xFFFFFFFF
+    x ^= x >> 32;
+#endif
+
+    return (uint32_t) (x & 0xFFFF);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TRACE RING
+ * -------------------------------------------------------------- */
+
+// Create a trace ring.
+int32_t uTraceRingInit(void *pRing, size_t numEntries, bool keepContents)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uTraceRing_t *pHeader = (uTraceRing_t *) pRing;
+
+    if ((pHeader != NULL) && (numEntries > 0) && ((numEntries & (numEntries - 1)) == 0) &&
+        (numEntries <= 0x80000000)) {
+        if (!keepContents || (pHeader->magicWord != U_TRACE_MAGIC_WORD) ||
+            (pHeader->version != U_TRACE_VERSION) ||
+            (pHeader->numEntries != numEntries)) {
+            memset(pHeader, 0, U_TRACE_RING_SIZE(numEntries));
+            pHeader->version = U_TRACE_VERSION;
+            pHeader->numEntries = (uint32_t) numEntries;
+            pHeader->reserveIndex = 0;
+            U_ATOMIC_STORE_RELEASE(&(pHeader->magicWord), U_TRACE_MAGIC_WORD);
+        }
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Write an entry to a trace ring.
+void uTraceRingWrite(void *pRing, uint32_t event, int32_t parameter)
+{
+    uTraceRing_t *pHeader = (uTraceRing_t *) pRing;
+    uTraceEntry_t *pEntry;
+    uint32_t index;
+    uint32_t timeUs;
+
+    if (pHeader != NULL) {
+        // Reserve an entry
+        do {
+            index = U_ATOMIC_GET(&(pHeader->reserveIndex));
+        } while (!U_ATOMIC_COMPARE_AND_SWAP(&(pHeader->reserveIndex), index, index + 1));
+        // Take the time after reserving so that the time-stamps
+        // follow the order of the entries as closely as possible
+        timeUs = (uint32_t) uPortGetTickTimeUs();
+        pEntry = U_TRACE_RING_ENTRY(pHeader, index);
+        // Mark the entry as being written: the barrier stops the
+        // writes below being seen before this one
+        U_ATOMIC_STORE_RELEASE(&(pEntry->sequence), 0);
+        U_ATOMIC_MEMORY_BARRIER();
+        pEntry->timeUs = timeUs;
+        pEntry->event = event;
+        pEntry->parameter = parameter;
+        // Publish it
+        U_ATOMIC_STORE_RELEASE(&(pEntry->sequence), index + 1);
+    }
+}
+
+// Read entries from a trace ring.
+size_t uTraceRingRead(const void *pRing, uint32_t *pSequence,
+                      uTraceEntry_t *pEntries, size_t numEntries,
+                      size_t *pNumLost)
+{
+    const uTraceRing_t *pHeader = (const uTraceRing_t *) pRing;
+    const uTraceEntry_t *pEntry;
+    size_t count = 0;
+    size_t numLost = 0;
+    uint32_t next = *pSequence;
+    uint32_t reserveIndex;
+    uint32_t sequence;
+
+    reserveIndex = U_ATOMIC_LOAD_ACQUIRE(&(pHeader->reserveIndex));
+    if (reserveIndex - next > pHeader->numEntries) {
+        // We've been lapped: skip what has gone
+        numLost += reserveIndex - pHeader->numEntries - next;
+        next = reserveIndex - pHeader->numEntries;
+    }
+
+    while ((next != reserveIndex) && (count < numEntries)) {
+        pEntry = U_TRACE_RING_ENTRY(pHeader, next);
+        sequence = U_ATOMIC_LOAD_ACQUIRE(&(pEntry->sequence));
+        if (sequence != next + 1) {
+            if ((int32_t) (sequence - (next + 1)) > 0) {
+                // Overwritten by a later lap
+                numLost++;
+                next++;
+                continue;
+            }
+            // Still being written, come back for it later
+            break;
+        }
+        pEntries->timeUs = pEntry->timeUs;
+        pEntries->event = pEntry->event;
+        pEntries->parameter = pEntry->parameter;
+        U_ATOMIC_MEMORY_BARRIER();
+        // If the sequence stamp has changed under us then the
+        // copy may be a mix of two entries so throw it away
+        if (U_ATOMIC_GET(&(pEntry->sequence)) == sequence) {
+            pEntries->sequence = sequence;
+            pEntries++;
+            count++;
+        } else {
+            numLost++;
+        }
+        next++;
+    }
+
+    *pSequence = next;
+    if (pNumLost != NULL) {
+        *pNumLost = numLost;
+    }
+
+    return count;
+}
+
+// Get the number of unread entries in a trace ring.
+size_t uTraceRingGetNumEntries(const void *pRing, uint32_t sequence)
+{
+    const uTraceRing_t *pHeader = (const uTraceRing_t *) pRing;
+    uint32_t numEntries;
+
+    numEntries = U_ATOMIC_LOAD_ACQUIRE(&(pHeader->reserveIndex)) - sequence;
+    if (numEntries > pHeader->numEntries) {
+        numEntries = pHeader->numEntries;
+    }
+
+    return numEntries;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: GLOBAL TRACE
+ * -------------------------------------------------------------- */
+
+// Start the global trace.
+int32_t uTraceInit(void *pBuffer, size_t size)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    size_t numEntries = U_TRACE_ENTRIES_MAX_NUM;
+    bool malloced = false;
+
+    if (gpTraceRing == NULL) {
+        if (pBuffer == NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            pBuffer = pUPortMalloc(U_TRACE_RING_SIZE(numEntries));
+            malloced = true;
+        } else {
+            // Find the largest power of two number of entries that fits
+            numEntries = 0;
+            if (size >= U_TRACE_RING_SIZE(1)) {
+                numEntries = 1;
+                while (U_TRACE_RING_SIZE(numEntries << 1) <= size) {
+                    numEntries <<= 1;
+                }
+            }
+        }
+        if (pBuffer != NULL) {
+            errorCode = uTraceRingInit(pBuffer, numEntries, false);
+            if (errorCode == 0) {
+                gTraceRingMalloced = malloced;
+                U_ATOMIC_STORE_RELEASE(&gpTraceRing, (uTraceRing_t *) pBuffer);
+                uTrace(U_TRACE_PHASE_INSTANT, U_TRACE_EVENT_START, U_TRACE_VERSION);
+            } else if (malloced) {
+                uPortFree(pBuffer);
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Stop the global trace.
+void uTraceDeinit()
+{
+    uTraceRing_t *pRing = gpTraceRing;
+
+    if (pRing != NULL) {
+        U_ATOMIC_STORE_RELEASE(&gpTraceRing, NULL);
+        if (gTraceRingMalloced) {
+            uPortFree(pRing);
+            gTraceRingMalloced = false;
+        }
+    }
+}
+
+// Write an event to the global trace.
+void uTrace(uTracePhase_t phase, uTraceEvent_t event, int32_t parameter)
+{
+    uTraceRing_t *pRing = U_ATOMIC_LOAD_ACQUIRE(&gpTraceRing);
+
+    if (pRing != NULL) {
+        uTraceRingWrite(pRing, (((uint32_t) phase) << 30) |
+                        ((((uint32_t) event) & 0x3FFF) << 16) | taskTag(),
+                        parameter);
+    }
+}
+
+// Print the global trace.
+int32_t uTraceDump()
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uTraceRing_t *pRing = U_ATOMIC_LOAD_ACQUIRE(&gpTraceRing);
+    uTraceEntry_t entry;
+    uint32_t sequence = 0;
+
+    if (pRing != NULL) {
+        errorCodeOrCount = 0;
+        uPortLog(U_TRACE_DUMP_PREFIX "version %d, %d entries.\n",
+                 U_TRACE_VERSION, (int) pRing->numEntries);
+        while (uTraceRingRead(pRing, &sequence, &entry, 1, NULL) > 0) {
+            uPortLog(U_TRACE_DUMP_PREFIX "%08x %08x %08x %08x\n",
+                     entry.sequence, entry.timeUs, entry.event,
+                     (uint32_t) entry.parameter);
+            errorCodeOrCount++;
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// End of file
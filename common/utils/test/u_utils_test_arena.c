@@ -0,0 +1,206 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the arena API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* struct timeval in some cases. */
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_heap.h"
+#include "u_port_debug.h"
+
+#include "u_test_util_resource_check.h"
+
+#include "u_arena.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_ARENA_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The size of the block the arena is created on.
+ */
+#define TEST_BLOCK_SIZE 128
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The block the arena is created on; one more than is needed
+ * so that an unaligned start can be tested.
+ */
+static char gBlock[TEST_BLOCK_SIZE + 1];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+static bool isAllBytes(const char *pBuf, size_t size, char cmpByte)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (pBuf[i] != cmpByte) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool isAligned(const void *pMem)
+{
+    return ((uintptr_t) pMem % U_ARENA_ALIGNMENT_BYTES) == 0;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+U_PORT_TEST_FUNCTION("[arena]", "arenaBasic")
+{
+    uArena_t arena;
+    uArenaMark_t mark;
+    char *pBuf1;
+    char *pBuf2;
+    char *pBuf3;
+    int32_t mallocCount;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_PORT_TEST_ASSERT(uArenaInit(NULL, gBlock, sizeof(gBlock)) < 0);
+    U_PORT_TEST_ASSERT(uArenaInit(&arena, NULL, sizeof(gBlock)) < 0);
+
+    // Start the arena one byte into the block so that it has
+    // to align it
+    U_PORT_TEST_ASSERT(uArenaInit(&arena, gBlock + 1, TEST_BLOCK_SIZE) == 0);
+    U_PORT_TEST_ASSERT(isAligned(arena.pBlock));
+    U_PORT_TEST_ASSERT(arena.size <= TEST_BLOCK_SIZE);
+    U_PORT_TEST_ASSERT(arena.size > TEST_BLOCK_SIZE - U_ARENA_ALIGNMENT_BYTES);
+
+    mallocCount = uPortHeapMallocCount();
+
+    // Allocate two odd-sized buffers: they should be aligned,
+    // should not overlap and should not touch the heap
+    pBuf1 = (char *) pUArenaAlloc(&arena, 3);
+    U_PORT_TEST_ASSERT(pBuf1 != NULL);
+    U_PORT_TEST_ASSERT(isAligned(pBuf1));
+    memset(pBuf1, 0xAA, 3);
+    pBuf2 = (char *) pUArenaAlloc(&arena, 5);
+    U_PORT_TEST_ASSERT(pBuf2 != NULL);
+    U_PORT_TEST_ASSERT(isAligned(pBuf2));
+    memset(pBuf2, 0x55, 5);
+    U_PORT_TEST_ASSERT(isAllBytes(pBuf1, 3, (char) 0xAA));
+    U_PORT_TEST_ASSERT(uPortHeapMallocCount() == mallocCount);
+    // Freeing does nothing
+    uArenaFree(&arena, pBuf1);
+    U_PORT_TEST_ASSERT(arena.offset == U_ARENA_ALIGNMENT_BYTES * 2);
+
+    // Take a mark, allocate more and release back to the mark:
+    // the next allocation should reuse the memory
+    mark = uArenaMark(&arena);
+    pBuf3 = (char *) pUArenaAlloc(&arena, 16);
+    U_PORT_TEST_ASSERT(pBuf3 != NULL);
+    uArenaRelease(&arena, mark);
+    U_PORT_TEST_ASSERT(arena.offset == U_ARENA_ALIGNMENT_BYTES * 2);
+    U_PORT_TEST_ASSERT(pUArenaAlloc(&arena, 1) == pBuf3);
+    U_PORT_TEST_ASSERT(isAllBytes(pBuf2, 5, 0x55));
+    U_PORT_TEST_ASSERT(arena.peakOffset == (U_ARENA_ALIGNMENT_BYTES * 2) + 16);
+    U_PORT_TEST_ASSERT(uPortHeapMallocCount() == mallocCount);
+
+    // Exhaust the block: the allocation should overflow onto
+    // the heap and be returned to it on release, as should
+    // allocations nested inside another mark
+    mark = uArenaMark(&arena);
+    pBuf1 = (char *) pUArenaAlloc(&arena, TEST_BLOCK_SIZE);
+    U_PORT_TEST_ASSERT(pBuf1 != NULL);
+    U_PORT_TEST_ASSERT(isAligned(pBuf1));
+    U_PORT_TEST_ASSERT((pBuf1 < arena.pBlock) || (pBuf1 >= arena.pBlock + arena.size));
+    memset(pBuf1, 0x11, TEST_BLOCK_SIZE);
+    U_PORT_TEST_ASSERT(arena.overflowCount == 1);
+    (void) uArenaMark(&arena);
+    pBuf2 = (char *) pUArenaAlloc(&arena, TEST_BLOCK_SIZE * 2);
+    U_PORT_TEST_ASSERT(pBuf2 != NULL);
+    memset(pBuf2, 0x22, TEST_BLOCK_SIZE * 2);
+    U_PORT_TEST_ASSERT(isAllBytes(pBuf1, TEST_BLOCK_SIZE, 0x11));
+    U_PORT_TEST_ASSERT(arena.overflowCount == 2);
+    U_PORT_TEST_ASSERT(uPortHeapMallocCount() == mallocCount + 2);
+    uArenaRelease(&arena, mark);
+    U_PORT_TEST_ASSERT(arena.pOverflowList == NULL);
+    U_TEST_PRINT_LINE("peak %d byte(s) of %d, %d overflow(s), %d failure(s).",
+                      (int) arena.peakOffset, (int) arena.size,
+                      arena.overflowCount, arena.failedAllocCount);
+    U_PORT_TEST_ASSERT(arena.failedAllocCount == 0);
+
+    // Reset should leave the statistics alone
+    uArenaReset(&arena);
+    U_PORT_TEST_ASSERT(arena.offset == 0);
+    U_PORT_TEST_ASSERT(arena.overflowCount == 2);
+
+    // With no arena it is just the heap
+    pBuf1 = (char *) pUArenaAlloc(NULL, 10);
+    U_PORT_TEST_ASSERT(pBuf1 != NULL);
+    U_PORT_TEST_ASSERT(uPortHeapMallocCount() == mallocCount + 3);
+    uArenaFree(NULL, pBuf1);
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+// End of file
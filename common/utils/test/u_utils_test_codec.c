@@ -0,0 +1,448 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the hex and base64 codecs, uBinToHex(),
+ * uHexToBin(), uBase64Encode() and uBase64Decode().
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcmp(), memset(), strlen()
+#include "stdio.h"     // snprintf()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+
+#include "u_test_util_resource_check.h"
+
+#include "u_hex_bin_convert.h"
+#include "u_base64.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_CODEC_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_TEST_UTILS_CODEC_ROUND_TRIP_MAX_LENGTH
+/** The longest binary buffer to round-trip, every length up
+ * to this is tried at every alignment from 0 to 7.
+ */
+# define U_TEST_UTILS_CODEC_ROUND_TRIP_MAX_LENGTH 100
+#endif
+
+#ifndef U_TEST_UTILS_CODEC_BENCHMARK_LENGTH
+/** The size of binary buffer to use in the benchmark.
+ */
+# define U_TEST_UTILS_CODEC_BENCHMARK_LENGTH 1024
+#endif
+
+#ifndef U_TEST_UTILS_CODEC_BENCHMARK_DURATION_MS
+/** How long to run each measurement of the benchmark for.
+ */
+# define U_TEST_UTILS_CODEC_BENCHMARK_DURATION_MS 500
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The things the benchmark can measure.
+ */
+typedef enum {
+    U_TEST_CODEC_REFERENCE_BIN_TO_HEX,
+    U_TEST_CODEC_REFERENCE_HEX_TO_BIN,
+    U_TEST_CODEC_BIN_TO_HEX,
+    U_TEST_CODEC_HEX_TO_BIN,
+    U_TEST_CODEC_BASE64_ENCODE,
+    U_TEST_CODEC_BASE64_DECODE,
+    U_TEST_CODEC_MAX_NUM
+} uTestCodec_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Names for uTestCodec_t, for printing.
+ */
+static const char *const gpCodecName[] = {"byte-at-a-time uBinToHex()",
+                                          "byte-at-a-time uHexToBin()",
+                                          "uBinToHex()",
+                                          "uHexToBin()",
+                                          "uBase64Encode()",
+                                          "uBase64Decode()"
+                                         };
+
+/** Binary data; +8 to allow for alignment offsets.
+ */
+static char gBin[U_TEST_UTILS_CODEC_BENCHMARK_LENGTH + 8];
+
+/** Encoded data.
+ */
+static char gEncoded[(U_TEST_UTILS_CODEC_BENCHMARK_LENGTH * 2) + 8];
+
+/** Decoded data; +8 to allow for alignment offsets.
+ */
+static char gDecoded[U_TEST_UTILS_CODEC_BENCHMARK_LENGTH + 8];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Reference hex encoder: one nibble at a time.
+static size_t referenceBinToHex(const char *pBin, size_t binLength, char *pHex)
+{
+    const char *pHexChars = "0123456789ABCDEF";
+
+    for (size_t x = 0; x < binLength; x++) {
+        *pHex = pHexChars[((unsigned char) * pBin) >> 4];
+        pHex++;
+        *pHex = pHexChars[*pBin & 0x0f];
+        pHex++;
+        pBin++;
+    }
+
+    return binLength * 2;
+}
+
+// Reference value of an ASCII hex character, -1 if it is not one.
+static int32_t referenceHexValue(char c)
+{
+    int32_t value = -1;
+
+    if ((c >= '0') && (c <= '9')) {
+        value = c - '0';
+    } else if ((c >= 'A') && (c <= 'F')) {
+        value = c - 'A' + 10;
+    } else if ((c >= 'a') && (c <= 'f')) {
+        value = c - 'a' + 10;
+    }
+
+    return value;
+}
+
+// Reference hex decoder: one nibble at a time, with range checks,
+// stopping at the first character that isn't hex.
+static size_t referenceHexToBin(const char *pHex, size_t hexLength, char *pBin)
+{
+    size_t length = 0;
+    int32_t a;
+    int32_t b;
+
+    while (length < hexLength / 2) {
+        a = referenceHexValue(*pHex);
+        b = referenceHexValue(*(pHex + 1));
+        if ((a < 0) || (b < 0)) {
+            break;
+        }
+        *pBin = (char) ((a << 4) | b);
+        pBin++;
+        pHex += 2;
+        length++;
+    }
+
+    return length;
+}
+
+// Fill a buffer with pseudo-random stuff.
+static void fill(char *pBuffer, size_t size, uint32_t seed)
+{
+    for (size_t x = 0; x < size; x++) {
+        // Linear congruential, good enough for this
+        seed = (seed * 1103515245) + 12345;
+        *pBuffer = (char) (seed >> 16);
+        pBuffer++;
+    }
+}
+
+// Run the given codec on gBin/gEncoded for
+// U_TEST_UTILS_CODEC_BENCHMARK_DURATION_MS and return the
+// throughput in kbytes of binary data per second, or -1 if the
+// output was wrong.
+static int32_t measure(uTestCodec_t codec, size_t encodedLength)
+{
+    int32_t kBytesPerSecond = -1;
+    bool dataGood = true;
+    size_t bytesDone = 0;
+    int32_t durationMs = 0;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+    size_t length = 0;
+    size_t size = U_TEST_UTILS_CODEC_BENCHMARK_LENGTH;
+
+    while (dataGood && (durationMs < U_TEST_UTILS_CODEC_BENCHMARK_DURATION_MS)) {
+        for (size_t x = 0; x < 100; x++) {
+            switch (codec) {
+                case U_TEST_CODEC_REFERENCE_BIN_TO_HEX:
+                    length = referenceBinToHex(gBin, size, gEncoded);
+                    break;
+                case U_TEST_CODEC_REFERENCE_HEX_TO_BIN:
+                    length = referenceHexToBin(gEncoded, size * 2, gDecoded);
+                    break;
+                case U_TEST_CODEC_BIN_TO_HEX:
+                    length = uBinToHex(gBin, size, gEncoded);
+                    break;
+                case U_TEST_CODEC_HEX_TO_BIN:
+                    length = uHexToBin(gEncoded, size * 2, gDecoded);
+                    break;
+                case U_TEST_CODEC_BASE64_ENCODE:
+                    length = (size_t) uBase64Encode(gBin, size, gEncoded, sizeof(gEncoded));
+                    break;
+                case U_TEST_CODEC_BASE64_DECODE:
+                    length = (size_t) uBase64Decode(gEncoded, encodedLength,
+                                                    gDecoded, sizeof(gDecoded));
+                    break;
+                default:
+                    break;
+            }
+            bytesDone += size;
+        }
+        switch (codec) {
+            case U_TEST_CODEC_REFERENCE_BIN_TO_HEX:
+            case U_TEST_CODEC_BIN_TO_HEX:
+            case U_TEST_CODEC_BASE64_ENCODE:
+                dataGood = (length == encodedLength);
+                break;
+            default:
+                dataGood = (length == size) && (memcmp(gDecoded, gBin, size) == 0);
+                break;
+        }
+        durationMs = uPortGetTickTimeMs() - startTimeMs;
+    }
+
+    if (dataGood && (durationMs > 0)) {
+        kBytesPerSecond = (int32_t) (((int64_t) bytesDone * 1000) / (durationMs * 1024));
+    }
+
+    return kBytesPerSecond;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Exhaustive test of uBinToHex() and uHexToBin(): every byte
+ * value, every pair of characters, every length up to
+ * #U_TEST_UTILS_CODEC_ROUND_TRIP_MAX_LENGTH at every alignment
+ * and an invalid character at every position.
+ */
+U_PORT_TEST_FUNCTION("[codec]", "codecHexExhaustive")
+{
+    int32_t resourceCount;
+    char hex[3];
+    char bin[4];
+    int32_t a;
+    int32_t b;
+    size_t length;
+
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_TEST_PRINT_LINE("encoding every byte value...");
+    for (int32_t x = 0; x < 256; x++) {
+        bin[0] = (char) x;
+        U_PORT_TEST_ASSERT(uBinToHex(bin, 1, gEncoded) == 2);
+        snprintf(hex, sizeof(hex), "%02X", (unsigned int) x);
+        U_PORT_TEST_ASSERT((gEncoded[0] == hex[0]) && (gEncoded[1] == hex[1]));
+    }
+
+    U_TEST_PRINT_LINE("decoding every pair of characters...");
+    for (int32_t x = 0; x < 0x10000; x++) {
+        hex[0] = (char) (x >> 8);
+        hex[1] = (char) x;
+        bin[0] = 0x55;
+        a = referenceHexValue(hex[0]);
+        b = referenceHexValue(hex[1]);
+        length = uHexToBin(hex, 2, bin);
+        if ((a >= 0) && (b >= 0)) {
+            U_PORT_TEST_ASSERT(length == 1);
+            U_PORT_TEST_ASSERT(bin[0] == (char) ((a << 4) | b));
+        } else {
+            U_PORT_TEST_ASSERT(length == 0);
+            U_PORT_TEST_ASSERT(bin[0] == 0x55);
+        }
+    }
+
+    U_TEST_PRINT_LINE("round-tripping all lengths up to %d byte(s) at all alignments...",
+                      U_TEST_UTILS_CODEC_ROUND_TRIP_MAX_LENGTH);
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t x = 0; x <= U_TEST_UTILS_CODEC_ROUND_TRIP_MAX_LENGTH; x++) {
+            fill(gBin + offset, x, (uint32_t) ((offset << 16) | x));
+            memset(gEncoded, 0x55, sizeof(gEncoded));
+            U_PORT_TEST_ASSERT(uBinToHex(gBin + offset, x, gEncoded + offset) == x * 2);
+            // Nothing beyond the end should have been touched
+            U_PORT_TEST_ASSERT(gEncoded[offset + (x * 2)] == 0x55);
+            referenceBinToHex(gBin + offset, x, gDecoded);
+            U_PORT_TEST_ASSERT(memcmp(gEncoded + offset, gDecoded, x * 2) == 0);
+            memset(gDecoded, 0x55, sizeof(gDecoded));
+            U_PORT_TEST_ASSERT(uHexToBin(gEncoded + offset, x * 2, gDecoded + offset) == x);
+            U_PORT_TEST_ASSERT(gDecoded[offset + x] == 0x55);
+            U_PORT_TEST_ASSERT(memcmp(gDecoded + offset, gBin + offset, x) == 0);
+            // Lower case should work just as well
+            for (size_t y = 0; y < x * 2; y++) {
+                if (gEncoded[offset + y] >= 'A') {
+                    gEncoded[offset + y] += 'a' - 'A';
+                }
+            }
+            U_PORT_TEST_ASSERT(uHexToBin(gEncoded + offset, x * 2, gDecoded + offset) == x);
+            U_PORT_TEST_ASSERT(memcmp(gDecoded + offset, gBin + offset, x) == 0);
+            // An odd trailing character should be ignored
+            gEncoded[offset + (x * 2)] = '1';
+            U_PORT_TEST_ASSERT(uHexToBin(gEncoded + offset, (x * 2) + 1, gDecoded + offset) == x);
+        }
+    }
+
+    U_TEST_PRINT_LINE("checking an invalid character at every position...");
+    length = U_TEST_UTILS_CODEC_ROUND_TRIP_MAX_LENGTH;
+    fill(gBin, length, 0);
+    uBinToHex(gBin, length, gEncoded);
+    for (size_t x = 0; x < length * 2; x++) {
+        a = gEncoded[x];
+        gEncoded[x] = 'g';
+        memset(gDecoded, 0x55, sizeof(gDecoded));
+        U_PORT_TEST_ASSERT(uHexToBin(gEncoded, length * 2, gDecoded) == x / 2);
+        U_PORT_TEST_ASSERT(memcmp(gDecoded, gBin, x / 2) == 0);
+        U_PORT_TEST_ASSERT(gDecoded[x / 2] == 0x55);
+        gEncoded[x] = (char) a;
+    }
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test uBase64Encode() and uBase64Decode(): the RFC 4648 test
+ * vectors, with and without padding, and then a round-trip of every
+ * length up to #U_TEST_UTILS_CODEC_ROUND_TRIP_MAX_LENGTH at every
+ * alignment.
+ */
+U_PORT_TEST_FUNCTION("[codec]", "codecBase64RoundTrip")
+{
+    int32_t resourceCount;
+    const char *pVector[][2] = {{"f", "Zg=="},
+        {"fo", "Zm8="},
+        {"foo", "Zm9v"},
+        {"foob", "Zm9vYg=="},
+        {"fooba", "Zm9vYmE="},
+        {"foobar", "Zm9vYmFy"}
+    };
+    int32_t length;
+
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_TEST_PRINT_LINE("checking the RFC 4648 test vectors...");
+    for (size_t x = 0; x < sizeof(pVector) / sizeof(pVector[0]); x++) {
+        length = uBase64Encode(pVector[x][0], strlen(pVector[x][0]), NULL, 0);
+        U_PORT_TEST_ASSERT(length == (int32_t) strlen(pVector[x][1]));
+        length = uBase64Encode(pVector[x][0], strlen(pVector[x][0]),
+                               gEncoded, sizeof(gEncoded));
+        U_PORT_TEST_ASSERT(length == (int32_t) strlen(pVector[x][1]));
+        U_PORT_TEST_ASSERT(memcmp(gEncoded, pVector[x][1], length) == 0);
+        length = uBase64Decode(pVector[x][1], strlen(pVector[x][1]), gDecoded, sizeof(gDecoded));
+        U_PORT_TEST_ASSERT(length == (int32_t) strlen(pVector[x][0]));
+        U_PORT_TEST_ASSERT(memcmp(gDecoded, pVector[x][0], length) == 0);
+        // Without the padding the result should be the same
+        memset(gDecoded, 0, sizeof(gDecoded));
+        length = uBase64Decode(pVector[x][1], strcspn(pVector[x][1], "="),
+                               gDecoded, sizeof(gDecoded));
+        U_PORT_TEST_ASSERT(length == (int32_t) strlen(pVector[x][0]));
+        U_PORT_TEST_ASSERT(memcmp(gDecoded, pVector[x][0], length) == 0);
+    }
+
+    U_TEST_PRINT_LINE("round-tripping all lengths up to %d byte(s) at all alignments...",
+                      U_TEST_UTILS_CODEC_ROUND_TRIP_MAX_LENGTH);
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t x = 1; x <= U_TEST_UTILS_CODEC_ROUND_TRIP_MAX_LENGTH; x++) {
+            fill(gBin + offset, x, (uint32_t) ((offset << 16) | x));
+            length = uBase64Encode(gBin + offset, x, gEncoded + offset,
+                                   sizeof(gEncoded) - offset);
+            U_PORT_TEST_ASSERT(length == (int32_t) (((x + 2) / 3) * 4));
+            memset(gDecoded, 0x55, sizeof(gDecoded));
+            U_PORT_TEST_ASSERT(uBase64Decode(gEncoded + offset, length,
+                                             gDecoded + offset,
+                                             sizeof(gDecoded) - offset) == (int32_t) x);
+            U_PORT_TEST_ASSERT(gDecoded[offset + x] == 0x55);
+            U_PORT_TEST_ASSERT(memcmp(gDecoded + offset, gBin + offset, x) == 0);
+        }
+    }
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Measure the throughput of the codecs, comparing the hex ones
+ * with a nibble-at-a-time reference implementation; this is for
+ * information, it will only fail if the data is corrupted.
+ */
+U_PORT_TEST_FUNCTION("[codec]", "codecBenchmark")
+{
+    int32_t resourceCount;
+    int32_t kBytesPerSecond[U_TEST_CODEC_MAX_NUM];
+    size_t encodedLength;
+
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    fill(gBin, U_TEST_UTILS_CODEC_BENCHMARK_LENGTH, 0);
+    U_TEST_PRINT_LINE("measuring throughput with %d bytes of binary data for %d ms"
+                      " per codec.", U_TEST_UTILS_CODEC_BENCHMARK_LENGTH,
+                      U_TEST_UTILS_CODEC_BENCHMARK_DURATION_MS);
+    for (size_t x = 0; x < U_TEST_CODEC_MAX_NUM; x++) {
+        // The decoders need the output of the encoders
+        encodedLength = U_TEST_UTILS_CODEC_BENCHMARK_LENGTH * 2;
+        if (x >= U_TEST_CODEC_BASE64_ENCODE) {
+            encodedLength = (size_t) uBase64Encode(gBin, U_TEST_UTILS_CODEC_BENCHMARK_LENGTH,
+                                                   gEncoded, sizeof(gEncoded));
+        } else {
+            uBinToHex(gBin, U_TEST_UTILS_CODEC_BENCHMARK_LENGTH, gEncoded);
+        }
+        kBytesPerSecond[x] = measure((uTestCodec_t) x, encodedLength);
+        U_TEST_PRINT_LINE("%s: %d kbytes/second.", gpCodecName[x], kBytesPerSecond[x]);
+        U_PORT_TEST_ASSERT(kBytesPerSecond[x] >= 0);
+    }
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+// End of file
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the leveled/deferred log API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "stdio.h"     // snprintf()
+#include "string.h"    // memset(), strcmp()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* struct timeval in some cases. */
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_heap.h"
+#include "u_port_debug.h"
+
+#include "u_test_util_resource_check.h"
+
+// This test file logs at INFO level and above only, so
+// that it can check that U_LOG_DEBUG() etc. are compiled out
+#define U_LOG_MODULE_LEVEL U_LOG_LEVEL_INFO
+#include "u_log.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_LOG_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The size of the buffer that the output of the deferred log
+ * is captured into.
+ */
+#define TEST_CAPTURE_LENGTH_BYTES 512
+
+/** The number of prints to throw at the deferred log when
+ * checking for loss.
+ */
+#define TEST_NUM_PRINTS 500
+
+/** Print with the deferred log and with snprintf(), then check
+ * that the results are the same.
+ */
+#define TEST_CHECK(format, ...)                                              \
+    do {                                                                     \
+        snprintf(gExpected, sizeof(gExpected), format, ##__VA_ARGS__);       \
+        captureReset();                                                      \
+        uLogDeferred(format, ##__VA_ARGS__);                                 \
+        U_PORT_TEST_ASSERT(uLogDeferredFlush(1000) == 0);                    \
+        if (strcmp(gCapture, gExpected) != 0) {                              \
+            U_TEST_PRINT_LINE("expected \"%s\", got \"%s\".", gExpected,     \
+                              gCapture);                                     \
+            U_PORT_TEST_ASSERT(false);                                       \
+        }                                                                    \
+    } while (0)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Where the output of the deferred log is captured.
+ */
+static char gCapture[TEST_CAPTURE_LENGTH_BYTES];
+
+/** The number of characters in gCapture.
+ */
+static size_t gCaptureLength = 0;
+
+/** The number of times the output callback has been called with
+ * a string beginning "L:".
+ */
+static int32_t gCaptureLineCount = 0;
+
+/** What is expected to be in gCapture.
+ */
+static char gExpected[TEST_CAPTURE_LENGTH_BYTES];
+
+/** A string longer than U_LOG_DEFERRED_STRING_MAX_LENGTH_BYTES.
+ */
+static char gLongString[U_LOG_DEFERRED_STRING_MAX_LENGTH_BYTES + 10];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Empty the capture buffer.
+static void captureReset()
+{
+    gCaptureLength = 0;
+    gCapture[0] = 0;
+    gCaptureLineCount = 0;
+}
+
+// Output callback for the deferred log.
+static void captureCallback(const char *pString, void *pParam)
+{
+    size_t length = strlen(pString);
+
+    (void) pParam;
+
+    if ((pString[0] == 'L') && (pString[1] == ':')) {
+        gCaptureLineCount++;
+    }
+    if (gCaptureLength + length >= sizeof(gCapture)) {
+        length = sizeof(gCapture) - gCaptureLength - 1;
+    }
+    memcpy(gCapture + gCaptureLength, pString, length);
+    gCaptureLength += length;
+    gCapture[gCaptureLength] = 0;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Check that prints below the module level are compiled out.
+ */
+U_PORT_TEST_FUNCTION("[log]", "logLevel")
+{
+    int32_t x = 0;
+
+    // The arguments of a print that is compiled out are not evaluated
+    U_LOG_VERBOSE(U_TEST_PREFIX "this should not appear %d.\n", x++);
+    U_LOG_DEBUG(U_TEST_PREFIX "this should not appear %d.\n", x++);
+    U_PORT_TEST_ASSERT(x == 0);
+    U_PORT_TEST_ASSERT(!U_LOG_IS_ENABLED(U_LOG_LEVEL_DEBUG));
+    U_LOG_INFO(U_TEST_PREFIX "this should appear %d.\n", x++);
+    U_LOG_WARN(U_TEST_PREFIX "this should appear %d.\n", x++);
+    U_LOG_ERROR(U_TEST_PREFIX "this should appear %d.\n", x++);
+#if U_CFG_ENABLE_LOGGING
+    U_PORT_TEST_ASSERT(U_LOG_IS_ENABLED(U_LOG_LEVEL_INFO));
+    U_PORT_TEST_ASSERT(x == 3);
+#else
+    U_PORT_TEST_ASSERT(x == 0);
+#endif
+}
+
+/** Check that the deferred log formats things as printf() would.
+ */
+U_PORT_TEST_FUNCTION("[log]", "logDeferred")
+{
+    int32_t heapUsed;
+    int32_t resourceCount;
+    int32_t numLost;
+    int x = 42;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    heapUsed = uPortGetHeapFree();
+
+    U_PORT_TEST_ASSERT(uLogDeferredInit(captureCallback, NULL) == 0);
+    // A second call does nothing
+    U_PORT_TEST_ASSERT(uLogDeferredInit(captureCallback, NULL) == 0);
+
+    TEST_CHECK("just text\n");
+    TEST_CHECK("%d %i %u %x %X %o %c %%\n", -1, 2, 3U, 0xabU, 0xcdU, 8U, 'z');
+    TEST_CHECK("[%5d] [%-5d] [%05d] [%+d] [% d] [%#x]\n", 1, 2, 3, 4, 5, 6U);
+    TEST_CHECK("[%*d] [%*d] [%.*d] [%.*d]\n", 4, 1, -4, 2, 3, 3, -1, 4);
+    TEST_CHECK("%hhd %hd %ld %lld %zu %td %jd\n", (signed char) -5, (short) -300,
+               -70000L, -5000000000LL, (size_t) 12345, (ptrdiff_t) -2, (intmax_t) 99);
+    TEST_CHECK("%f %.3f %e %g %10.2f %Lf\n", 1.5, -2.25, 12345.678, 0.0001, 3.14159,
+               (long double) 0.5);
+    TEST_CHECK("%p %p\n", (void *) &x, NULL);
+    TEST_CHECK("[%s] [%10s] [%-10s] [%.3s] [%s]\n", "abc", "def", "ghi", "jklmnop", "");
+
+    // Long strings are truncated
+    memset(gLongString, 'a', sizeof(gLongString) - 1);
+    gLongString[sizeof(gLongString) - 1] = 0;
+    snprintf(gExpected, sizeof(gExpected), "[%.*s]\n",
+             U_LOG_DEFERRED_STRING_MAX_LENGTH_BYTES, gLongString);
+    captureReset();
+    uLogDeferred("[%s]\n", gLongString);
+    U_PORT_TEST_ASSERT(uLogDeferredFlush(1000) == 0);
+    U_PORT_TEST_ASSERT(strcmp(gCapture, gExpected) == 0);
+
+    // Output longer than a line comes out in pieces but is complete
+    TEST_CHECK("[%100d] [%-100d]\n", 1, 2);
+
+    // Arguments that don't fit in a record are replaced with "..."
+    captureReset();
+    uLogDeferred("%s %s %s %d\n", gLongString, gLongString, gLongString, x);
+    U_PORT_TEST_ASSERT(uLogDeferredFlush(1000) == 0);
+    U_TEST_PRINT_LINE("cut-short print came out as \"%s\".", gCapture);
+    U_PORT_TEST_ASSERT(gCaptureLength > 5);
+    U_PORT_TEST_ASSERT(strcmp(gCapture + gCaptureLength - 4, "...\n") == 0);
+
+    // Throw lots at it: what comes out plus what is lost
+    // should be everything
+    captureReset();
+    for (int32_t y = 0; y < TEST_NUM_PRINTS; y++) {
+        uLogDeferred("L: print %d of %d, %s.\n", (int) y, TEST_NUM_PRINTS, gLongString);
+    }
+    U_PORT_TEST_ASSERT(uLogDeferredFlush(10000) == 0);
+    numLost = uLogDeferredGetNumLost();
+    U_TEST_PRINT_LINE("%d print(s) output, %d lost.", gCaptureLineCount, numLost);
+    U_PORT_TEST_ASSERT(gCaptureLineCount + numLost == TEST_NUM_PRINTS);
+
+    uLogDeferredDeinit();
+    // Without the task, prints come out immediately
+    uLogDeferred(U_TEST_PREFIX "deferred log stopped, %d.\n", x);
+
+    // Check that we haven't leaked any memory
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+// End of file
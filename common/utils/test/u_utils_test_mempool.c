@@ -35,6 +35,7 @@
 #include "string.h"        // strncpy(), strcmp(), memcpy(), memset()
 
 #include "u_cfg_sw.h"
+#include "u_compiler.h" // U_ATOMIC_INCREMENT
 #include "u_cfg_app_platform_specific.h"
 #include "u_cfg_test_platform_specific.h"
 #include "u_cfg_os_platform_specific.h"
@@ -66,6 +67,15 @@
 #define TEST_BLOCK_COUNT 8
 #define TEST_BLOCK_SIZE  64
 
+/** The number of tasks to run at once in the threaded test.
+ */
+#define TEST_NUM_TASKS 4
+
+/** The number of times each task allocates and frees a block
+ * in the threaded test.
+ */
+#define TEST_NUM_ITERATIONS 10000
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -74,6 +84,19 @@
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The pool shared by the tasks of the threaded test.
+ */
+static uMemPoolDesc_t gMempoolDesc;
+
+/** The number of tasks of the threaded test that have finished.
+ */
+static volatile int32_t gTasksDone = 0;
+
+/** The number of times a task of the threaded test found that a
+ * block it had been given had been overwritten by another task.
+ */
+static volatile int32_t gCorruptCount = 0;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -88,6 +111,32 @@ static bool isAllBytes(uint8_t *pBuf, size_t size, uint8_t cmpByte)
     return true;
 }
 
+// Task for the threaded test: allocate a block, fill it with
+// a pattern unique to this task, check it is still there, free it.
+static void allocFreeTask(void *pParameter)
+{
+    uint8_t pattern = (uint8_t) (intptr_t) pParameter;
+    uint8_t *pBuf;
+
+    for (int32_t i = 0; i < TEST_NUM_ITERATIONS; i++) {
+        pBuf = (uint8_t *)uMemPoolAllocMem(&gMempoolDesc);
+        if (pBuf != NULL) {
+            memset(pBuf, pattern, TEST_BLOCK_SIZE);
+            if ((i % 100) == 0) {
+                // Give the others a chance to trample on it
+                uPortTaskBlock(1);
+            }
+            if (!isAllBytes(pBuf, TEST_BLOCK_SIZE, pattern)) {
+                gCorruptCount++;
+            }
+            uMemPoolFreeMem(&gMempoolDesc, pBuf);
+        }
+    }
+
+    U_ATOMIC_INCREMENT(&gTasksDone);
+    uPortTaskDelete(NULL);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -223,4 +272,186 @@ U_PORT_TEST_FUNCTION("[mempool]", "mempoolFreeAllMem")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+U_PORT_TEST_FUNCTION("[mempool]", "mempoolStats")
+{
+    int32_t errCode;
+    uMemPoolDesc_t mempoolDesc;
+    uMemPoolStats_t stats;
+    uint8_t *pBuf[TEST_BLOCK_COUNT];
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // More blocks than the free list can index should be refused
+    U_PORT_TEST_ASSERT(uMemPoolInit(&mempoolDesc, TEST_BLOCK_SIZE,
+                                    U_MEMPOOL_MAX_NUM_BLOCKS + 1) < 0);
+
+    errCode = uMemPoolInit(&mempoolDesc, TEST_BLOCK_SIZE, TEST_BLOCK_COUNT);
+    U_PORT_TEST_ASSERT(errCode == U_ERROR_COMMON_SUCCESS);
+
+    // Use half the blocks, free them, then use all of them and one more
+    for (int32_t i = 0; i < TEST_BLOCK_COUNT / 2; i++) {
+        pBuf[i] = (uint8_t *)uMemPoolAllocMem(&mempoolDesc);
+        U_PORT_TEST_ASSERT(pBuf[i] != NULL);
+    }
+    U_PORT_TEST_ASSERT(uMemPoolStatsGet(&mempoolDesc, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.usedBlockCount == TEST_BLOCK_COUNT / 2);
+    U_PORT_TEST_ASSERT(stats.peakUsedBlockCount == TEST_BLOCK_COUNT / 2);
+    for (int32_t i = 0; i < TEST_BLOCK_COUNT / 2; i++) {
+        uMemPoolFreeMem(&mempoolDesc, (void *)pBuf[i]);
+    }
+    for (int32_t i = 0; i < TEST_BLOCK_COUNT; i++) {
+        pBuf[i] = (uint8_t *)uMemPoolAllocMem(&mempoolDesc);
+        U_PORT_TEST_ASSERT(pBuf[i] != NULL);
+    }
+    U_PORT_TEST_ASSERT(uMemPoolAllocMem(&mempoolDesc) == NULL);
+    for (int32_t i = 0; i < TEST_BLOCK_COUNT; i++) {
+        uMemPoolFreeMem(&mempoolDesc, (void *)pBuf[i]);
+    }
+
+    U_PORT_TEST_ASSERT(uMemPoolStatsGet(&mempoolDesc, &stats) == 0);
+    U_TEST_PRINT_LINE("%d block(s) of %d byte(s): %d used, peak %d, %d failed allocation(s).",
+                      stats.totalBlockCount, stats.blockSize, stats.usedBlockCount,
+                      stats.peakUsedBlockCount, stats.failedAllocCount);
+    U_PORT_TEST_ASSERT(stats.blockSize == TEST_BLOCK_SIZE);
+    U_PORT_TEST_ASSERT(stats.totalBlockCount == TEST_BLOCK_COUNT);
+    U_PORT_TEST_ASSERT(stats.usedBlockCount == 0);
+    U_PORT_TEST_ASSERT(stats.peakUsedBlockCount == TEST_BLOCK_COUNT);
+    U_PORT_TEST_ASSERT(stats.failedAllocCount == 1);
+
+    uMemPoolDeinit(&mempoolDesc);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+U_PORT_TEST_FUNCTION("[mempool]", "mempoolClasses")
+{
+    uMemPoolClasses_t classes;
+    const uint32_t blockSize[] = {16, TEST_BLOCK_SIZE, TEST_BLOCK_SIZE * 4};
+    const int32_t numOfBlks[] = {TEST_BLOCK_COUNT, TEST_BLOCK_COUNT, 1};
+    const uint32_t badBlockSize[] = {TEST_BLOCK_SIZE, 16};
+    uint8_t *pSmall[TEST_BLOCK_COUNT];
+    uint8_t *pBuf1;
+    uint8_t *pBuf2;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // The classes must be in increasing order of size
+    U_PORT_TEST_ASSERT(uMemPoolClassesInit(&classes, badBlockSize, numOfBlks,
+                                           sizeof(badBlockSize) / sizeof(badBlockSize[0])) < 0);
+
+    U_PORT_TEST_ASSERT(uMemPoolClassesInit(&classes, blockSize, numOfBlks,
+                                           sizeof(blockSize) / sizeof(blockSize[0])) == 0);
+
+    // Small allocations should come from the small class until it
+    // is exhausted, then from the next class up
+    for (int32_t i = 0; i < TEST_BLOCK_COUNT; i++) {
+        pSmall[i] = (uint8_t *)uMemPoolClassesAllocMem(&classes, 10);
+        U_PORT_TEST_ASSERT(pSmall[i] != NULL);
+        memset(pSmall[i], 0xAA, 10);
+    }
+    pBuf1 = (uint8_t *)uMemPoolClassesAllocMem(&classes, 10);
+    U_PORT_TEST_ASSERT(pBuf1 != NULL);
+    memset(pBuf1, 0xBB, TEST_BLOCK_SIZE);
+    U_PORT_TEST_ASSERT(classes.pool[0].usedBlockCount == TEST_BLOCK_COUNT);
+    U_PORT_TEST_ASSERT(classes.pool[1].usedBlockCount == 1);
+
+    // A big allocation should come from the big class, and only once
+    pBuf2 = (uint8_t *)uMemPoolClassesAllocMem(&classes, TEST_BLOCK_SIZE + 1);
+    U_PORT_TEST_ASSERT(pBuf2 != NULL);
+    memset(pBuf2, 0xCC, TEST_BLOCK_SIZE * 4);
+    U_PORT_TEST_ASSERT(uMemPoolClassesAllocMem(&classes, TEST_BLOCK_SIZE + 1) == NULL);
+    // ...and anything bigger than the biggest class should fail
+    U_PORT_TEST_ASSERT(uMemPoolClassesAllocMem(&classes, (TEST_BLOCK_SIZE * 4) + 1) == NULL);
+
+    for (int32_t i = 0; i < TEST_BLOCK_COUNT; i++) {
+        U_PORT_TEST_ASSERT(isAllBytes(pSmall[i], 10, 0xAA));
+        uMemPoolClassesFreeMem(&classes, pSmall[i]);
+    }
+    U_PORT_TEST_ASSERT(isAllBytes(pBuf1, TEST_BLOCK_SIZE, 0xBB));
+    uMemPoolClassesFreeMem(&classes, pBuf1);
+    U_PORT_TEST_ASSERT(isAllBytes(pBuf2, TEST_BLOCK_SIZE * 4, 0xCC));
+    uMemPoolClassesFreeMem(&classes, pBuf2);
+    for (size_t x = 0; x < classes.numClasses; x++) {
+        U_PORT_TEST_ASSERT(classes.pool[x].usedBlockCount == 0);
+    }
+
+    uMemPoolClassesDeinit(&classes);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+U_PORT_TEST_FUNCTION("[mempool]", "mempoolThreads")
+{
+    int32_t errCode;
+    uPortTaskHandle_t taskHandle;
+    uMemPoolStats_t stats;
+    int32_t startTimeMs;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Fewer blocks than there are tasks, so that they fight
+    errCode = uMemPoolInit(&gMempoolDesc, TEST_BLOCK_SIZE, TEST_NUM_TASKS - 1);
+    U_PORT_TEST_ASSERT(errCode == U_ERROR_COMMON_SUCCESS);
+    gTasksDone = 0;
+    gCorruptCount = 0;
+
+    U_TEST_PRINT_LINE("%d tasks each allocating and freeing %d time(s)...",
+                      TEST_NUM_TASKS, TEST_NUM_ITERATIONS);
+    startTimeMs = uPortGetTickTimeMs();
+    for (int32_t i = 0; i < TEST_NUM_TASKS; i++) {
+        U_PORT_TEST_ASSERT(uPortTaskCreate(allocFreeTask, "allocFreeTask",
+                                           U_CFG_OS_APP_TASK_STACK_SIZE_BYTES,
+                                           (void *) (intptr_t) (i + 1),
+                                           U_CFG_OS_APP_TASK_PRIORITY,
+                                           &taskHandle) == 0);
+    }
+    while ((U_ATOMIC_GET(&gTasksDone) < TEST_NUM_TASKS) &&
+           (uPortGetTickTimeMs() - startTimeMs < 60000)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(uMemPoolStatsGet(&gMempoolDesc, &stats) == 0);
+    U_TEST_PRINT_LINE("took %d ms, peak %d block(s) used, %d failed allocation(s),"
+                      " %d corruption(s).", uPortGetTickTimeMs() - startTimeMs,
+                      stats.peakUsedBlockCount, stats.failedAllocCount, gCorruptCount);
+    U_PORT_TEST_ASSERT(gTasksDone == TEST_NUM_TASKS);
+    U_PORT_TEST_ASSERT(gCorruptCount == 0);
+    U_PORT_TEST_ASSERT(stats.usedBlockCount == 0);
+    U_PORT_TEST_ASSERT(stats.peakUsedBlockCount <= TEST_NUM_TASKS - 1);
+    // Give the tasks time to be deleted
+    uPortTaskBlock(100);
+
+    uMemPoolDeinit(&gMempoolDesc);
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 // End of file
\ No newline at end of file
@@ -34,6 +34,7 @@
 #include "string.h"    // strncpy(), strcmp(), memcpy(), memset()
 
 #include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
 #include "u_cfg_app_platform_specific.h"
 #include "u_cfg_test_platform_specific.h"
 
@@ -76,14 +77,95 @@
 # define U_TEST_UTILS_RINGBUFFER_FILL_CHAR 0x5a
 #endif
 
+#ifndef U_TEST_UTILS_RINGBUFFER_THROUGHPUT_CHUNK_MAX_SIZE
+/** The largest chunk size to use when measuring throughput.
+ */
+# define U_TEST_UTILS_RINGBUFFER_THROUGHPUT_CHUNK_MAX_SIZE (1024 * 8)
+#endif
+
+#ifndef U_TEST_UTILS_RINGBUFFER_THROUGHPUT_SIZE
+/** The size of ring buffer to use when measuring throughput:
+ * deliberately not a multiple of any of the chunk sizes so
+ * that the wrap point keeps moving.
+ */
+# define U_TEST_UTILS_RINGBUFFER_THROUGHPUT_SIZE ((U_TEST_UTILS_RINGBUFFER_THROUGHPUT_CHUNK_MAX_SIZE * 2) + 7)
+#endif
+
+#ifndef U_TEST_UTILS_RINGBUFFER_THROUGHPUT_DURATION_MS
+/** How long to measure throughput for at each chunk size, for each
+ * of the reference and the real implementation.
+ */
+# define U_TEST_UTILS_RINGBUFFER_THROUGHPUT_DURATION_MS 1000
+#endif
+
+#ifndef U_TEST_UTILS_RINGBUFFER_TWO_TASK_BYTES
+/** The number of bytes to pass between a producer task and a
+ * consumer task when testing the lock-free ring buffer.
+ */
+# define U_TEST_UTILS_RINGBUFFER_TWO_TASK_BYTES (1024 * 1024 * 4)
+#endif
+
+#ifndef U_TEST_UTILS_RINGBUFFER_TWO_TASK_SPIN_COUNT
+/** When the producer finds the ring buffer full, or the consumer
+ * finds it empty, they yield; after this many yields in a row
+ * they will block for a millisecond to avoid starving a lower
+ * priority task.
+ */
+# define U_TEST_UTILS_RINGBUFFER_TWO_TASK_SPIN_COUNT 100
+#endif
+
+#ifndef U_TEST_UTILS_RINGBUFFER_THROUGHPUT_BLOCK_SIZE
+/** The number of bytes to move between checks of the time
+ * when measuring throughput.
+ */
+# define U_TEST_UTILS_RINGBUFFER_THROUGHPUT_BLOCK_SIZE (1024 * 64)
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A byte-at-a-time ring buffer, the way uRingBuffer used to work,
+ * used as a reference when measuring throughput.
+ */
+typedef struct {
+    char *pBuffer;
+    size_t size;
+    const char *pRead;
+    char *pWrite;
+    uPortMutexHandle_t mutex;
+} uTestRingBufferReference_t;
+
+/** Context for the producer task in the two-task test.
+ */
+typedef struct {
+    uRingBuffer_t *pRingBuffer;
+    size_t length;
+    volatile bool done;
+} uTestRingBufferProducer_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
 
+/** The chunk sizes to measure throughput with.
+ */
+static const size_t gThroughputChunkSize[] = {64, 1024,
+                                              U_TEST_UTILS_RINGBUFFER_THROUGHPUT_CHUNK_MAX_SIZE
+                                             };
+
+/** Linear buffer for the throughput test.
+ */
+static char gThroughputLinearBuffer[U_TEST_UTILS_RINGBUFFER_THROUGHPUT_SIZE];
+
+/** Source data for the throughput test.
+ */
+static char gThroughputDataIn[U_TEST_UTILS_RINGBUFFER_THROUGHPUT_CHUNK_MAX_SIZE];
+
+/** Destination for the throughput test.
+ */
+static char gThroughputDataOut[U_TEST_UTILS_RINGBUFFER_THROUGHPUT_CHUNK_MAX_SIZE];
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -108,6 +190,263 @@ static void printBuffer(const char *pTitle, const char *pStr, size_t length)
     uPortTaskBlock(10);
 }
 
+// Add to the reference ring buffer, a byte at a time.
+static bool referenceAdd(uTestRingBufferReference_t *pRef,
+                         const char *pData, size_t length)
+{
+    bool added = false;
+    size_t used;
+
+    U_PORT_MUTEX_LOCK(pRef->mutex);
+
+    if (pRef->pWrite >= pRef->pRead) {
+        used = pRef->pWrite - pRef->pRead;
+    } else {
+        used = pRef->size - (pRef->pRead - pRef->pWrite);
+    }
+    if (used + length + 1 <= pRef->size) {
+        while (length > 0) {
+            *(pRef->pWrite) = *pData;
+            pRef->pWrite++;
+            if (pRef->pWrite >= pRef->pBuffer + pRef->size) {
+                pRef->pWrite = pRef->pBuffer;
+            }
+            pData++;
+            length--;
+        }
+        added = true;
+    }
+
+    U_PORT_MUTEX_UNLOCK(pRef->mutex);
+
+    return added;
+}
+
+// Read from the reference ring buffer, a byte at a time.
+static size_t referenceRead(uTestRingBufferReference_t *pRef,
+                            char *pData, size_t length)
+{
+    size_t bytesRead = 0;
+
+    U_PORT_MUTEX_LOCK(pRef->mutex);
+
+    while ((bytesRead < length) && (pRef->pRead != pRef->pWrite)) {
+        *pData = *(pRef->pRead);
+        pRef->pRead++;
+        if (pRef->pRead >= pRef->pBuffer + pRef->size) {
+            pRef->pRead = pRef->pBuffer;
+        }
+        pData++;
+        bytesRead++;
+    }
+
+    U_PORT_MUTEX_UNLOCK(pRef->mutex);
+
+    return bytesRead;
+}
+
+// The byte expected at a given position in the two-task test: not
+// simply a counter so that a chunk repeated 256 bytes later
+// is detected.
+static char twoTaskByte(size_t position)
+{
+    return (char) (position + (position >> 8));
+}
+
+// Yield, or block for a while if we have been yielding for a while.
+static void twoTaskBackOff(size_t *pSpinCount)
+{
+    (*pSpinCount)++;
+    if (*pSpinCount >= U_TEST_UTILS_RINGBUFFER_TWO_TASK_SPIN_COUNT) {
+        uPortTaskBlock(1);
+        *pSpinCount = 0;
+    } else {
+        uPortTaskBlock(0);
+    }
+}
+
+// Producer task for the two-task test: writes the data in chunks
+// of varying size so that the wrap point moves around.
+static void twoTaskProducer(void *pParameter)
+{
+    uTestRingBufferProducer_t *pProducer = (uTestRingBufferProducer_t *) pParameter;
+    char buffer[251];
+    size_t position = 0;
+    size_t chunkSize = 1;
+    size_t spinCount = 0;
+
+    while (position < pProducer->length) {
+        if (chunkSize > pProducer->length - position) {
+            chunkSize = pProducer->length - position;
+        }
+        for (size_t x = 0; x < chunkSize; x++) {
+            buffer[x] = twoTaskByte(position + x);
+        }
+        if (uRingBufferAdd(pProducer->pRingBuffer, buffer, chunkSize)) {
+            position += chunkSize;
+            chunkSize = (chunkSize * 7 + 3) % sizeof(buffer) + 1;
+            spinCount = 0;
+        } else {
+            twoTaskBackOff(&spinCount);
+        }
+    }
+
+    pProducer->done = true;
+    uPortTaskDelete(NULL);
+}
+
+// Run the two-task test on the given ring buffer, the caller being
+// the consumer; returns the throughput in kbytes per second, or
+// negative if the data that came out was not what went in.
+static int32_t twoTaskRun(uRingBuffer_t *pRingBuffer)
+{
+    int32_t kBytesPerSecond = -1;
+    uTestRingBufferProducer_t producer = {0};
+    uPortTaskHandle_t taskHandle = NULL;
+    char buffer[97];
+    size_t position = 0;
+    size_t spinCount = 0;
+    size_t y;
+    bool dataGood = true;
+    int32_t startTimeMs;
+    int32_t durationMs;
+
+    producer.pRingBuffer = pRingBuffer;
+    producer.length = U_TEST_UTILS_RINGBUFFER_TWO_TASK_BYTES;
+    startTimeMs = uPortGetTickTimeMs();
+    if (uPortTaskCreate(twoTaskProducer, "rbProducer",
+                        U_CFG_TEST_OS_TASK_STACK_SIZE_BYTES,
+                        &producer, U_CFG_TEST_OS_TASK_PRIORITY,
+                        &taskHandle) == 0) {
+        while (dataGood && (position < producer.length)) {
+            y = uRingBufferRead(pRingBuffer, buffer, sizeof(buffer));
+            if (y > 0) {
+                for (size_t x = 0; dataGood && (x < y); x++) {
+                    dataGood = (buffer[x] == twoTaskByte(position + x));
+                }
+                if (!dataGood) {
+                    U_TEST_PRINT_LINE("data mismatch between byte %d and byte %d.",
+                                      position, position + y);
+                }
+                position += y;
+                spinCount = 0;
+            } else {
+                twoTaskBackOff(&spinCount);
+            }
+        }
+        durationMs = uPortGetTickTimeMs() - startTimeMs;
+        // If there was a data error, drain the ring buffer so that
+        // the producer can complete
+        while (!producer.done) {
+            uRingBufferRead(pRingBuffer, NULL, producer.length);
+            uPortTaskBlock(1);
+        }
+        // Give the producer task time to delete itself
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        if (dataGood && (uRingBufferDataSize(pRingBuffer) == 0)) {
+            if (durationMs <= 0) {
+                durationMs = 1;
+            }
+            kBytesPerSecond = (int32_t) (((int64_t) position * 1000) / (durationMs * 1024));
+        }
+    }
+
+    return kBytesPerSecond;
+}
+
+// Move data through either the reference or the real ring buffer,
+// in chunks of chunkSize, for the throughput test duration,
+// returning the throughput in kbytes per second, or negative if
+// the data that came out was not what went in.
+static int32_t measureThroughput(uTestRingBufferReference_t *pRef,
+                                 uRingBuffer_t *pRingBuffer,
+                                 size_t chunkSize)
+{
+    int32_t kBytesPerSecond = -1;
+    bool dataGood = true;
+    size_t bytesMoved = 0;
+    size_t y;
+    int32_t durationMs = 0;
+    int32_t startTimeMs = uPortGetTickTimeMs();
+
+    while (dataGood && (durationMs < U_TEST_UTILS_RINGBUFFER_THROUGHPUT_DURATION_MS)) {
+        for (size_t x = 0; dataGood &&
+             (x < U_TEST_UTILS_RINGBUFFER_THROUGHPUT_BLOCK_SIZE); x += chunkSize) {
+            if (pRef != NULL) {
+                dataGood = referenceAdd(pRef, gThroughputDataIn, chunkSize);
+                y = referenceRead(pRef, gThroughputDataOut, chunkSize);
+            } else {
+                dataGood = uRingBufferAdd(pRingBuffer, gThroughputDataIn, chunkSize);
+                y = uRingBufferRead(pRingBuffer, gThroughputDataOut, chunkSize);
+            }
+            dataGood = dataGood && (y == chunkSize);
+            bytesMoved += y;
+        }
+        // Check the last chunk: the wrap point in the ring buffer moves
+        // with every chunk so over time this checks all the cases
+        dataGood = dataGood && (memcmp(gThroughputDataOut, gThroughputDataIn, chunkSize) == 0);
+        durationMs = uPortGetTickTimeMs() - startTimeMs;
+    }
+
+    if (dataGood && (durationMs > 0)) {
+        kBytesPerSecond = (int32_t) (((int64_t) bytesMoved * 1000) / (durationMs * 1024));
+    }
+
+    return kBytesPerSecond;
+}
+
+// Parser for the batch parse test: a message is an STX character,
+// a length byte and then that many bytes of payload; the first byte
+// of the payload is written to pUserParam on success.
+static int32_t parseStx(uParseHandle_t parseHandle, void *pUserParam)
+{
+    char c = 0;
+    char length = 0;
+    char first = 0;
+
+    if (!uRingBufferGetByteUnprotected(parseHandle, &c) || (c != 0x02)) {
+        return U_ERROR_COMMON_NOT_FOUND;
+    }
+    if (!uRingBufferGetByteUnprotected(parseHandle, &length)) {
+        return U_ERROR_COMMON_TIMEOUT;
+    }
+    for (size_t x = 0; x < (size_t) length; x++) {
+        if (!uRingBufferGetByteUnprotected(parseHandle, &c)) {
+            return U_ERROR_COMMON_TIMEOUT;
+        }
+        if (x == 0) {
+            first = c;
+        }
+    }
+    *((char *) pUserParam) = first;
+
+    return U_ERROR_COMMON_SUCCESS;
+}
+
+// Parser for the batch parse test: a message is a '$' followed by
+// anything up to and including a '\n'; the first character after
+// the '$' is written to pUserParam on success.
+static int32_t parseDollar(uParseHandle_t parseHandle, void *pUserParam)
+{
+    char c = 0;
+    char first = 0;
+
+    if (!uRingBufferGetByteUnprotected(parseHandle, &c) || (c != '$')) {
+        return U_ERROR_COMMON_NOT_FOUND;
+    }
+    do {
+        if (!uRingBufferGetByteUnprotected(parseHandle, &c)) {
+            return U_ERROR_COMMON_TIMEOUT;
+        }
+        if (first == 0) {
+            first = c;
+        }
+    } while (c != '\n');
+    *((char *) pUserParam) = first;
+
+    return U_ERROR_COMMON_SUCCESS;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -882,4 +1221,343 @@ U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferBasic")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+/** Test the span API of the ring buffer.
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferSpan")
+{
+    int32_t resourceCount;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    char bufferIn[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    char bufferOut[U_TEST_UTILS_RINGBUFFER_SIZE + 1];
+    uRingBufferSpan_t span[U_RING_BUFFER_SPAN_MAX_NUM];
+    int32_t handle;
+    size_t y;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    for (size_t x = 0; x < sizeof(bufferIn); x++) {
+        bufferIn[x] = (char) x;
+    }
+    memset(linearBuffer, 0, sizeof(linearBuffer));
+
+    // An uninitialised ring buffer should give us nothing
+    U_TEST_PRINT_LINE("testing spans on an uninitialised ring buffer...");
+    U_PORT_TEST_ASSERT(uRingBufferWriteSpanAcquire(&ringBuffer, span) == 0);
+    U_PORT_TEST_ASSERT((span[0].pData == NULL) && (span[0].length == 0));
+    U_PORT_TEST_ASSERT((span[1].pData == NULL) && (span[1].length == 0));
+    U_PORT_TEST_ASSERT(uRingBufferWriteSpanCommit(&ringBuffer, 1) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferReadSpanAcquire(&ringBuffer, span) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferReadSpanCommit(&ringBuffer, 1) == 0);
+
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, linearBuffer,
+                                                       sizeof(linearBuffer), 1) == 0);
+
+    // Write into the empty ring buffer through a span: no wrap
+    U_TEST_PRINT_LINE("testing write span without wrap...");
+    y = uRingBufferWriteSpanAcquire(&ringBuffer, span);
+    U_PORT_TEST_ASSERT(y == sizeof(linearBuffer) - 1);
+    U_PORT_TEST_ASSERT((span[0].pData == linearBuffer) && (span[0].length == y));
+    U_PORT_TEST_ASSERT((span[1].pData == NULL) && (span[1].length == 0));
+    memcpy(span[0].pData, bufferIn, 7);
+    // Nothing should be readable until commit
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferWriteSpanCommit(&ringBuffer, 7) == 7);
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == 7);
+    memset(bufferOut, U_TEST_UTILS_RINGBUFFER_FILL_CHAR, sizeof(bufferOut));
+    U_PORT_TEST_ASSERT(uRingBufferRead(&ringBuffer, bufferOut, sizeof(bufferOut)) == 7);
+    U_PORT_TEST_ASSERT(memcmp(bufferOut, bufferIn, 7) == 0);
+
+    // Take a read handle, which will start at the current write
+    // pointer, then write through a span that wraps
+    U_TEST_PRINT_LINE("testing write span with wrap...");
+    handle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(handle >= 0);
+    y = uRingBufferWriteSpanAcquire(&ringBuffer, span);
+    U_PORT_TEST_ASSERT(y == sizeof(linearBuffer) - 1);
+    U_PORT_TEST_ASSERT((span[0].pData == linearBuffer + 7) &&
+                       (span[0].length == sizeof(linearBuffer) - 7));
+    U_PORT_TEST_ASSERT((span[1].pData == linearBuffer) &&
+                       (span[1].length == y - span[0].length));
+    memcpy(span[0].pData, bufferIn, span[0].length);
+    memcpy(span[1].pData, bufferIn + span[0].length, 8 - span[0].length);
+    // Committing more than there is room for should be limited
+    U_PORT_TEST_ASSERT(uRingBufferWriteSpanCommit(&ringBuffer, 8) == 8);
+    U_PORT_TEST_ASSERT(uRingBufferWriteSpanCommit(&ringBuffer, sizeof(linearBuffer)) == 2);
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == sizeof(linearBuffer) - 1);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == sizeof(linearBuffer) - 1);
+    U_PORT_TEST_ASSERT(uRingBufferWriteSpanAcquire(&ringBuffer, span) == 0);
+    U_PORT_TEST_ASSERT((span[0].pData == NULL) && (span[1].pData == NULL));
+
+    // Read in place through the "normal" read pointer
+    U_TEST_PRINT_LINE("testing read span...");
+    y = uRingBufferReadSpanAcquire(&ringBuffer, span);
+    U_PORT_TEST_ASSERT(y == sizeof(linearBuffer) - 1);
+    U_PORT_TEST_ASSERT(span[0].length + span[1].length == y);
+    U_PORT_TEST_ASSERT(memcmp(span[0].pData, bufferIn, span[0].length) == 0);
+    U_PORT_TEST_ASSERT(memcmp(span[1].pData, bufferIn + span[0].length,
+                              8 - span[0].length) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferReadSpanCommit(&ringBuffer, 8) == 8);
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == 2);
+    U_PORT_TEST_ASSERT(uRingBufferReadSpanCommit(&ringBuffer, sizeof(linearBuffer)) == 2);
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferReadSpanAcquire(&ringBuffer, span) == 0);
+
+    // Read in place through the read handle: while the span is
+    // acquired the handle is locked and a forced add cannot
+    // push the data out
+    U_TEST_PRINT_LINE("testing read span with a handle...");
+    y = uRingBufferReadSpanAcquireHandle(&ringBuffer, handle, span);
+    U_PORT_TEST_ASSERT(y == sizeof(linearBuffer) - 1);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandleIsLocked(&ringBuffer, handle));
+    U_PORT_TEST_ASSERT(memcmp(span[0].pData, bufferIn, span[0].length) == 0);
+    U_PORT_TEST_ASSERT(!uRingBufferForceAdd(&ringBuffer, bufferIn, 1));
+    U_PORT_TEST_ASSERT(uRingBufferForceWriteSpanAcquire(&ringBuffer, 1, span) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferReadSpanCommitHandle(&ringBuffer, handle, 3) == 3);
+    U_PORT_TEST_ASSERT(!uRingBufferReadHandleIsLocked(&ringBuffer, handle));
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == sizeof(linearBuffer) - 4);
+
+    // A read handle that was already locked should stay locked
+    U_PORT_TEST_ASSERT(uRingBufferLockReadHandle(&ringBuffer, handle) == sizeof(linearBuffer) - 4);
+    U_PORT_TEST_ASSERT(uRingBufferReadSpanAcquireHandle(&ringBuffer, handle,
+                                                        span) == sizeof(linearBuffer) - 4);
+    U_PORT_TEST_ASSERT(uRingBufferReadSpanCommitHandle(&ringBuffer, handle, 0) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandleIsLocked(&ringBuffer, handle));
+    uRingBufferUnlockReadHandle(&ringBuffer, handle);
+    U_PORT_TEST_ASSERT(!uRingBufferReadHandleIsLocked(&ringBuffer, handle));
+
+    // Now a forced write span should push data out of the unlocked
+    // read handle
+    U_TEST_PRINT_LINE("testing forced write span...");
+    y = uRingBufferForceWriteSpanAcquire(&ringBuffer, 5, span);
+    U_PORT_TEST_ASSERT(y >= 5);
+    U_PORT_TEST_ASSERT(uRingBufferStatReadLossHandle(&ringBuffer, handle) == 2);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == sizeof(linearBuffer) - 6);
+    U_PORT_TEST_ASSERT(span[0].length + span[1].length == y);
+    U_PORT_TEST_ASSERT(uRingBufferWriteSpanCommit(&ringBuffer, 5) == 5);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == sizeof(linearBuffer) - 1);
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == 5);
+
+    uRingBufferGiveReadHandle(&ringBuffer, handle);
+    uRingBufferDelete(&ringBuffer);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test a lock-free ring buffer with a producer task and a consumer
+ * task (on Linux, two pthreads), checking data integrity, and
+ * compare its throughput with that of a normal ring buffer.
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferLockFree")
+{
+    int32_t resourceCount;
+    uRingBuffer_t ringBuffer = {0};
+    int32_t kBytesPerSecondLocked;
+    int32_t kBytesPerSecondLockFree;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    // Needed for tasks
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_TEST_PRINT_LINE("passing %d byte(s) between two tasks through a"
+                      " normal ring buffer...", U_TEST_UTILS_RINGBUFFER_TWO_TASK_BYTES);
+    U_PORT_TEST_ASSERT(uRingBufferCreate(&ringBuffer, gThroughputLinearBuffer,
+                                         sizeof(gThroughputLinearBuffer)) == 0);
+    U_PORT_TEST_ASSERT(!ringBuffer.isLockFree);
+    kBytesPerSecondLocked = twoTaskRun(&ringBuffer);
+    U_PORT_TEST_ASSERT(kBytesPerSecondLocked >= 0);
+    uRingBufferDelete(&ringBuffer);
+
+    U_TEST_PRINT_LINE("passing %d byte(s) between two tasks through a"
+                      " lock-free ring buffer...", U_TEST_UTILS_RINGBUFFER_TWO_TASK_BYTES);
+    U_PORT_TEST_ASSERT(uRingBufferCreateLockFree(&ringBuffer, gThroughputLinearBuffer,
+                                                 sizeof(gThroughputLinearBuffer)) == 0);
+    kBytesPerSecondLockFree = twoTaskRun(&ringBuffer);
+    U_PORT_TEST_ASSERT(kBytesPerSecondLockFree >= 0);
+    // A forced add must not push data out from under the consumer
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, gThroughputDataIn,
+                                      sizeof(gThroughputLinearBuffer) - 2));
+    U_PORT_TEST_ASSERT(!uRingBufferForceAdd(&ringBuffer, gThroughputDataIn, 2));
+    U_PORT_TEST_ASSERT(uRingBufferStatReadLoss(&ringBuffer) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferDataSize(&ringBuffer) == sizeof(gThroughputLinearBuffer) - 2);
+    uRingBufferDelete(&ringBuffer);
+
+    U_TEST_PRINT_LINE("normal ring buffer %d kbytes/second, lock-free ring"
+                      " buffer %d kbytes/second.", kBytesPerSecondLocked,
+                      kBytesPerSecondLockFree);
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test uRingBufferParseBatchHandle().
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferParseBatch")
+{
+    int32_t resourceCount;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[32];
+    U_RING_BUFFER_PARSER_f parserList[] = {parseStx, parseDollar, NULL};
+    // Some junk, an STX message, a '$' message, more junk and
+    // then the start of an STX message that is not yet complete
+    const char data[] = {'a', 'b', 0x02, 3, '1', '2', '3', '$', 'A', 'B', '\n',
+                         'z', 0x02, 5, 'x'
+                        };
+    const char dataRest[] = {'y', 'z', 'z', 'z'};
+    uRingBufferParseRecord_t record[4];
+    char userParam[4];
+    size_t offsetEnd;
+    int32_t handle;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, linearBuffer,
+                                                       sizeof(linearBuffer), 1) == 0);
+    uRingBufferSetReadRequiresHandle(&ringBuffer, true);
+    handle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(handle >= 0);
+
+    U_TEST_PRINT_LINE("testing batch parse with bad parameters...");
+    U_PORT_TEST_ASSERT(uRingBufferParseBatchHandle(&ringBuffer, handle, parserList,
+                                                   userParam, sizeof(userParam[0]), NULL,
+                                                   4, &offsetEnd) < 0);
+    U_PORT_TEST_ASSERT(uRingBufferParseBatchHandle(&ringBuffer, handle + 1, parserList,
+                                                   userParam, sizeof(userParam[0]), record,
+                                                   4, &offsetEnd) < 0);
+    // Nothing in the buffer, nothing found
+    U_PORT_TEST_ASSERT(uRingBufferParseBatchHandle(&ringBuffer, handle, parserList,
+                                                   userParam, sizeof(userParam[0]), record,
+                                                   4, &offsetEnd) == 0);
+    U_PORT_TEST_ASSERT(offsetEnd == 0);
+
+    // Move the pointers on so that the data wraps
+    memset(userParam, 0, sizeof(userParam));
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, linearBuffer, 25));
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 25) == 25);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, data, sizeof(data)));
+
+    U_TEST_PRINT_LINE("testing batch parse of two messages and a partial one...");
+    U_PORT_TEST_ASSERT(uRingBufferParseBatchHandle(&ringBuffer, handle, parserList,
+                                                   userParam, sizeof(userParam[0]), record,
+                                                   4, &offsetEnd) == 2);
+    U_PORT_TEST_ASSERT((record[0].offset == 2) && (record[0].length == 5) &&
+                       (record[0].parserIndex == 0) && (userParam[0] == '1'));
+    U_PORT_TEST_ASSERT((record[1].offset == 7) && (record[1].length == 4) &&
+                       (record[1].parserIndex == 1) && (userParam[1] == 'A'));
+    U_PORT_TEST_ASSERT(offsetEnd == 12);
+    // Nothing should have been read
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == sizeof(data));
+
+    U_TEST_PRINT_LINE("testing batch parse limited to one record...");
+    U_PORT_TEST_ASSERT(uRingBufferParseBatchHandle(&ringBuffer, handle, parserList,
+                                                   userParam, sizeof(userParam[0]), record,
+                                                   1, &offsetEnd) == 1);
+    U_PORT_TEST_ASSERT((record[0].offset == 2) && (record[0].length == 5));
+    U_PORT_TEST_ASSERT(offsetEnd == 7);
+
+    // Read out what was accounted for, complete the partial
+    // message and parse again, this time with a single user
+    // parameter for all records
+    U_TEST_PRINT_LINE("testing batch parse of a completed message...");
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 12) == 12);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, dataRest, sizeof(dataRest)));
+    memset(userParam, 0, sizeof(userParam));
+    U_PORT_TEST_ASSERT(uRingBufferParseBatchHandle(&ringBuffer, handle, parserList,
+                                                   userParam, 0, record,
+                                                   4, &offsetEnd) == 1);
+    U_PORT_TEST_ASSERT((record[0].offset == 0) && (record[0].length == 7) &&
+                       (record[0].parserIndex == 0) && (userParam[0] == 'x'));
+    U_PORT_TEST_ASSERT(offsetEnd == 7);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, offsetEnd) == 7);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == 0);
+
+    uRingBufferGiveReadHandle(&ringBuffer, handle);
+    uRingBufferDelete(&ringBuffer);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Measure the throughput of uRingBufferAdd()/uRingBufferRead() at
+ * a range of chunk sizes, comparing it with a byte-at-a-time
+ * reference implementation; this is for information, it will
+ * only fail if the data is corrupted.
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferThroughput")
+{
+    int32_t resourceCount;
+    uRingBuffer_t ringBuffer = {0};
+    uTestRingBufferReference_t reference = {0};
+    size_t chunkSize;
+    int32_t referenceKBytesPerSecond;
+    int32_t kBytesPerSecond;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    for (size_t x = 0; x < sizeof(gThroughputDataIn); x++) {
+        gThroughputDataIn[x] = (char) (x * 7);
+    }
+
+    U_PORT_TEST_ASSERT(uPortMutexCreate(&reference.mutex) == 0);
+    reference.pBuffer = gThroughputLinearBuffer;
+    reference.size = sizeof(gThroughputLinearBuffer);
+    U_PORT_TEST_ASSERT(uRingBufferCreate(&ringBuffer, gThroughputLinearBuffer,
+                                         sizeof(gThroughputLinearBuffer)) == 0);
+
+    U_TEST_PRINT_LINE("measuring throughput with a %d byte ring buffer for %d ms"
+                      " per chunk size.", sizeof(gThroughputLinearBuffer),
+                      U_TEST_UTILS_RINGBUFFER_THROUGHPUT_DURATION_MS);
+    for (size_t x = 0; x < sizeof(gThroughputChunkSize) / sizeof(gThroughputChunkSize[0]); x++) {
+        chunkSize = gThroughputChunkSize[x];
+        // The two share the same linear buffer, so reset both
+        reference.pRead = reference.pBuffer;
+        reference.pWrite = reference.pBuffer;
+        referenceKBytesPerSecond = measureThroughput(&reference, NULL, chunkSize);
+        U_PORT_TEST_ASSERT(referenceKBytesPerSecond >= 0);
+        uRingBufferReset(&ringBuffer);
+        kBytesPerSecond = measureThroughput(NULL, &ringBuffer, chunkSize);
+        U_PORT_TEST_ASSERT(kBytesPerSecond >= 0);
+        U_TEST_PRINT_LINE("%5d byte chunks: byte-at-a-time %d kbytes/second,"
+                          " uRingBuffer %d kbytes/second.", chunkSize,
+                          referenceKBytesPerSecond, kBytesPerSecond);
+    }
+
+    uRingBufferDelete(&ringBuffer);
+    uPortMutexDelete(reference.mutex);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 // End of file
\ No newline at end of file
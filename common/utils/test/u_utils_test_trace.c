@@ -0,0 +1,330 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Test for the trace API
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_compiler.h" // U_ATOMIC_XXX()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* struct timeval in some cases. */
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_heap.h"
+#include "u_port_debug.h"
+
+#include "u_test_util_resource_check.h"
+
+#include "u_trace.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_TRACE_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+/** The number of tasks writing to the trace ring at once.
+ */
+#define TEST_NUM_TASKS 4
+
+/** The number of entries each task writes.
+ */
+#define TEST_NUM_WRITES 1000
+
+/** The number of entries in the large trace ring, which has
+ * room for everything the tasks write.
+ */
+#define TEST_RING_LARGE_NUM_ENTRIES 4096
+
+/** The number of entries in the small trace ring, which the
+ * tasks will lap many times.
+ */
+#define TEST_RING_SMALL_NUM_ENTRIES 16
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The memory for the trace ring: uint32_t to get the alignment.
+ */
+static uint32_t gRing[U_TRACE_RING_SIZE(TEST_RING_LARGE_NUM_ENTRIES) / sizeof(uint32_t)];
+
+/** The number of tasks that have finished.
+ */
+static volatile int32_t gTasksDone = 0;
+
+/** Place to read entries into.
+ */
+static uTraceEntry_t gEntries[TEST_RING_LARGE_NUM_ENTRIES];
+
+/** The next count expected from each task.
+ */
+static uint32_t gNextCount[TEST_NUM_TASKS];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Task that writes entries to the trace ring: the event is the task
+// index in the upper byte and a count in the rest, the parameter is
+// the inverse of the event so that the reader can tell if an entry
+// has been mangled.
+static void writeTask(void *pParameter)
+{
+    uint32_t taskIndex = (uint32_t) (intptr_t) pParameter;
+    uint32_t event;
+
+    for (uint32_t x = 0; x < TEST_NUM_WRITES; x++) {
+        event = (taskIndex << 24) | x;
+        uTraceRingWrite(gRing, event, (int32_t) ~event);
+        if ((x % 100) == 0) {
+            // Let the others in
+            uPortTaskBlock(1);
+        }
+    }
+
+    U_ATOMIC_INCREMENT(&gTasksDone);
+    uPortTaskDelete(NULL);
+}
+
+// Start the write tasks.
+static void startTasks()
+{
+    uPortTaskHandle_t taskHandle;
+
+    gTasksDone = 0;
+    for (size_t x = 0; x < TEST_NUM_TASKS; x++) {
+        gNextCount[x] = 0;
+        U_PORT_TEST_ASSERT(uPortTaskCreate(writeTask, "traceWriteTask",
+                                           U_CFG_OS_APP_TASK_STACK_SIZE_BYTES,
+                                           (void *) (intptr_t) x,
+                                           U_CFG_OS_APP_TASK_PRIORITY,
+                                           &taskHandle) == 0);
+    }
+}
+
+// Check that entries are intact and that those from any one task are
+// in order, returning the number of entries that are bad.
+static int32_t checkEntries(const uTraceEntry_t *pEntry, size_t numEntries,
+                            bool allowGaps)
+{
+    int32_t badCount = 0;
+    uint32_t taskIndex;
+    uint32_t count;
+
+    for (size_t x = 0; x < numEntries; x++, pEntry++) {
+        taskIndex = pEntry->event >> 24;
+        count = pEntry->event & 0xFFFFFF;
+        if ((pEntry->parameter != (int32_t) ~pEntry->event) ||
+            (taskIndex >= TEST_NUM_TASKS) || (count < gNextCount[taskIndex]) ||
+            (!allowGaps && (count != gNextCount[taskIndex]))) {
+            U_TEST_PRINT_LINE("bad entry: sequence %u, event 0x%08x, parameter 0x%08x.",
+                              pEntry->sequence, pEntry->event, pEntry->parameter);
+            badCount++;
+        } else {
+            gNextCount[taskIndex] = count + 1;
+        }
+    }
+
+    return badCount;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: TESTS
+ * -------------------------------------------------------------- */
+
+/** Test a trace ring with several tasks writing to it at once.
+ */
+U_PORT_TEST_FUNCTION("[trace]", "traceRing")
+{
+    uint32_t sequence = 0;
+    size_t numRead;
+    size_t numLost;
+    size_t totalRead = 0;
+    size_t totalLost = 0;
+    int32_t badCount = 0;
+    int32_t startTimeMs;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_PORT_TEST_ASSERT(uTraceRingInit(NULL, TEST_RING_LARGE_NUM_ENTRIES, false) < 0);
+    U_PORT_TEST_ASSERT(uTraceRingInit(gRing, 0, false) < 0);
+    U_PORT_TEST_ASSERT(uTraceRingInit(gRing, TEST_RING_LARGE_NUM_ENTRIES - 1, false) < 0);
+
+    // First with a ring that is large enough for everything:
+    // nothing should be lost and nothing should be out of order
+    U_PORT_TEST_ASSERT(uTraceRingInit(gRing, TEST_RING_LARGE_NUM_ENTRIES, false) == 0);
+    U_TEST_PRINT_LINE("%d tasks each writing %d entries to a ring of %d entries...",
+                      TEST_NUM_TASKS, TEST_NUM_WRITES, TEST_RING_LARGE_NUM_ENTRIES);
+    startTimeMs = uPortGetTickTimeMs();
+    startTasks();
+    while ((U_ATOMIC_GET(&gTasksDone) < TEST_NUM_TASKS) &&
+           (uPortGetTickTimeMs() - startTimeMs < 60000)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(gTasksDone == TEST_NUM_TASKS);
+    U_PORT_TEST_ASSERT(uTraceRingGetNumEntries(gRing,
+                                               sequence) == TEST_NUM_TASKS * TEST_NUM_WRITES);
+    numRead = uTraceRingRead(gRing, &sequence, gEntries,
+                             sizeof(gEntries) / sizeof(gEntries[0]), &numLost);
+    U_TEST_PRINT_LINE("read %d entries, %d lost.", numRead, numLost);
+    U_PORT_TEST_ASSERT(numRead == TEST_NUM_TASKS * TEST_NUM_WRITES);
+    U_PORT_TEST_ASSERT(numLost == 0);
+    U_PORT_TEST_ASSERT(sequence == TEST_NUM_TASKS * TEST_NUM_WRITES);
+    U_PORT_TEST_ASSERT(uTraceRingGetNumEntries(gRing, sequence) == 0);
+    for (size_t x = 0; x < numRead; x++) {
+        U_PORT_TEST_ASSERT(gEntries[x].sequence == x + 1);
+    }
+    U_PORT_TEST_ASSERT(checkEntries(gEntries, numRead, false) == 0);
+    for (size_t x = 0; x < TEST_NUM_TASKS; x++) {
+        U_PORT_TEST_ASSERT(gNextCount[x] == TEST_NUM_WRITES);
+    }
+    // Give the tasks time to be deleted
+    uPortTaskBlock(100);
+
+    // Now with a small ring, reading while the tasks are writing:
+    // lots will be lost but nothing that is read should be mangled
+    // and every entry should be either read or counted as lost
+    U_PORT_TEST_ASSERT(uTraceRingInit(gRing, TEST_RING_SMALL_NUM_ENTRIES, false) == 0);
+    U_TEST_PRINT_LINE("%d tasks each writing %d entries to a ring of %d entries"
+                      " while reading...", TEST_NUM_TASKS, TEST_NUM_WRITES,
+                      TEST_RING_SMALL_NUM_ENTRIES);
+    sequence = 0;
+    startTimeMs = uPortGetTickTimeMs();
+    startTasks();
+    do {
+        numRead = uTraceRingRead(gRing, &sequence, gEntries,
+                                 TEST_RING_SMALL_NUM_ENTRIES / 2, &numLost);
+        badCount += checkEntries(gEntries, numRead, true);
+        totalRead += numRead;
+        totalLost += numLost;
+    } while (((U_ATOMIC_GET(&gTasksDone) < TEST_NUM_TASKS) ||
+              (numRead > 0) || (numLost > 0)) &&
+             (uPortGetTickTimeMs() - startTimeMs < 60000));
+    U_TEST_PRINT_LINE("read %d entries, %d lost, %d bad.", totalRead, totalLost, badCount);
+    U_PORT_TEST_ASSERT(gTasksDone == TEST_NUM_TASKS);
+    U_PORT_TEST_ASSERT(badCount == 0);
+    U_PORT_TEST_ASSERT(totalRead + totalLost == TEST_NUM_TASKS * TEST_NUM_WRITES);
+    U_PORT_TEST_ASSERT(totalRead >= TEST_RING_SMALL_NUM_ENTRIES);
+    // Give the tasks time to be deleted
+    uPortTaskBlock(100);
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test the global trace.
+ */
+U_PORT_TEST_FUNCTION("[trace]", "traceGlobal")
+{
+    int32_t heapUsed;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    heapUsed = uPortGetHeapFree();
+
+    // Nothing should happen before initialisation
+    uTrace(U_TRACE_PHASE_INSTANT, U_TRACE_EVENT_USER_0, 0);
+    U_PORT_TEST_ASSERT(uTraceDump() < 0);
+
+    // Too small
+    U_PORT_TEST_ASSERT(uTraceInit(gRing, sizeof(uTraceRing_t)) < 0);
+
+    // With a buffer given, the number of entries is the largest
+    // power of two that fits, and the start is recorded
+    U_PORT_TEST_ASSERT(uTraceInit(gRing, U_TRACE_RING_SIZE(7)) == 0);
+    U_PORT_TEST_ASSERT(((uTraceRing_t *) gRing)->numEntries == 4);
+    uTrace(U_TRACE_PHASE_BEGIN, U_TRACE_EVENT_USER_0, 1);
+    uTrace(U_TRACE_PHASE_END, U_TRACE_EVENT_USER_0, 2);
+    U_PORT_TEST_ASSERT(uTraceDump() == 3);
+    // Wrap it: only the last four should be printed
+    for (int32_t x = 0; x < 10; x++) {
+        uTrace(U_TRACE_PHASE_COUNTER, U_TRACE_EVENT_USER_1, x);
+    }
+    U_PORT_TEST_ASSERT(uTraceDump() == 4);
+    uTraceDeinit();
+    U_PORT_TEST_ASSERT(uTraceDump() < 0);
+
+    // With the memory allocated for us
+    U_PORT_TEST_ASSERT(uTraceInit(NULL, 0) == 0);
+    uTrace(U_TRACE_PHASE_INSTANT, U_TRACE_EVENT_USER_2, -1);
+    U_PORT_TEST_ASSERT(uTraceDump() == 2);
+    uTraceDeinit();
+
+    // Check that we haven't leaked any memory
+    heapUsed -= uPortGetHeapFree();
+    U_TEST_PRINT_LINE("we have leaked %d byte(s).", heapUsed);
+    // heapUsed < 0 for the Zephyr case where the heap can look
+    // like it increases (negative leak)
+    U_PORT_TEST_ASSERT(heapUsed <= 0);
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+// End of file
@@ -22,8 +22,16 @@
  * of another module should be included here; otherwise
  * please keep #includes to your .c files. */
 
+#include "u_arena.h"
 #include "u_gnss_dec_ubx_nav_pvt.h"
 #include "u_gnss_dec_ubx_nav_hpposllh.h"
+#include "u_gnss_dec_ubx_nav_dop.h"
+#include "u_gnss_dec_ubx_nav_status.h"
+#include "u_gnss_dec_ubx_nav_sat.h"
+#include "u_gnss_dec_ubx_nav_sig.h"
+#include "u_gnss_dec_ubx_rxm_rawx.h"
+#include "u_gnss_dec_ubx_tim_tp.h"
+#include "u_gnss_dec_ubx_esf_meas.h"
 
 /** \addtogroup _GNSS
  *  @{
@@ -37,6 +45,11 @@
  * to obtain high precision position from a HPG GNSS device
  * by requesting it to emit the UBX-NAV-HPPOSLLH message.
  *
+ * uGnssDecUbx() decodes a UBX message into a structure provided
+ * by the caller, without allocating any memory, which is the
+ * thing to use when decoding a high-rate stream of messages
+ * such as UBX-RXM-RAWX or UBX-ESF-MEAS.
+ *
  * The functions are thread-safe with the exception of
  * uGnssDecSetCallback().
  */
@@ -58,6 +71,13 @@ extern "C" {
 typedef union {
     uGnssDecUbxNavPvt_t           ubxNavPvt;      /**< UBX-NAV-PVT. */
     uGnssDecUbxNavHpposllh_t      ubxNavHpposllh; /**< UBX-NAV-HPPOSLLH. */
+    uGnssDecUbxNavDop_t           ubxNavDop;      /**< UBX-NAV-DOP. */
+    uGnssDecUbxNavStatus_t        ubxNavStatus;   /**< UBX-NAV-STATUS. */
+    uGnssDecUbxNavSat_t           ubxNavSat;      /**< UBX-NAV-SAT. */
+    uGnssDecUbxNavSig_t           ubxNavSig;      /**< UBX-NAV-SIG. */
+    uGnssDecUbxRxmRawx_t          ubxRxmRawx;     /**< UBX-RXM-RAWX. */
+    uGnssDecUbxTimTp_t            ubxTimTp;       /**< UBX-TIM-TP. */
+    uGnssDecUbxEsfMeas_t          ubxEsfMeas;     /**< UBX-ESF-MEAS. */
 } uGnssDecUnion_t;
 
 /** The result of attempting to decode a message, returned by
@@ -155,12 +175,17 @@ typedef int32_t (uGnssDecFunction_t) (uGnssMessageId_t *pId,
  * and must include all headers; no checking of checksums etc. on the
  * end of a known message is performed, hence they may be omitted.
  *
- * Currently only a very limited set of messages (actually just
- * UBX-NAV-PVT and UBX-NAV-HPPOSLLH, the latter useful if you wish
- * to use a high precision GNSS (HPG) device to its full extent) are
- * supported; see the top of the file u_gnss_dec.c for instructions
- * on how to add more decoders, or use uGnssDecSetCallback() to
- * hook-in your own decoders at run-time.
+ * Currently only a limited set of UBX messages (UBX-NAV-PVT,
+ * UBX-NAV-HPPOSLLH, the latter useful if you wish to use a high
+ * precision GNSS (HPG) device to its full extent, UBX-NAV-DOP,
+ * UBX-NAV-STATUS, UBX-NAV-SAT, UBX-NAV-SIG, UBX-RXM-RAWX,
+ * UBX-TIM-TP and UBX-ESF-MEAS) are supported; see the top of the
+ * file u_gnss_dec.c for instructions on how to add more decoders,
+ * or use uGnssDecSetCallback() to hook-in your own decoders at
+ * run-time.  Note that, since the message body is allocated at the
+ * size of the structure for that message, some of which (e.g.
+ * UBX-RXM-RAWX) are large, if you are decoding a stream of messages
+ * you may prefer to use uGnssDecUbx().
  *
  * If only a partial decode is possible then the errorCode field of
  * the returned structure will be negative but the protocol type
@@ -186,6 +211,83 @@ typedef int32_t (uGnssDecFunction_t) (uGnssMessageId_t *pId,
  */
 uGnssDec_t *pUGnssDecAlloc(const char *pBuffer, size_t size);
 
+/** As pUGnssDecAlloc() but the returned message structure and the
+ * decoded message body are allocated from an arena, so that decoding
+ * a stream of messages need not touch the heap; the memory is returned
+ * when the caller releases the arena (see uArenaRelease()), there is
+ * no need to call uGnssDecFree().  Only the built-in decoders are
+ * used: a callback set with uGnssDecSetCallback() is NOT called since
+ * it allocates the message body with pUPortMalloc(); should you need
+ * that, use pUGnssDecAlloc().
+ *
+ * @param[in] pBuffer     the buffer containing the message to be
+ *                        decoded; cannot be NULL.
+ * @param size            the amount of data at pBuffer.
+ * @param[in] pArena      the arena to allocate from; cannot be NULL.
+ * @return                on success a pointer to the decoded
+ *                        message, else NULL.
+ */
+uGnssDec_t *pUGnssDecArenaAlloc(const char *pBuffer, size_t size,
+                                uArena_t *pArena);
+
+/** Decode a UBX message into a structure provided by the caller;
+ * no memory is allocated.  As for pUGnssDecAlloc() the message
+ * must begin at the start of pBuffer and must include the header;
+ * the checksum bytes may be omitted.  The same set of UBX messages
+ * as pUGnssDecAlloc() is supported (see uGnssDecGetIdList()) but
+ * a callback set with uGnssDecSetCallback() is NOT called.
+ *
+ * If a message contains a repeated block (e.g. the satellites of
+ * UBX-NAV-SAT), the number of elements populated is written to the
+ * numDecoded member of the structure; any blocks beyond the size of
+ * the array in the structure are ignored.  Fields that are beyond
+ * the end of the received message are set to zero.
+ *
+ * Example usage:
+ *
+ * ```
+ * uGnssDecUbxNavSat_t navSat;
+ *
+ * if (uGnssDecUbx(pBuffer, size, &navSat, sizeof(navSat)) ==
+ *     U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_SAT_MESSAGE_CLASS,
+ *                        U_GNSS_DEC_UBX_NAV_SAT_MESSAGE_ID)) {
+ *     // Do something with navSat
+ * }
+ * ```
+ *
+ * Or, if the message type is not known in advance, decode into
+ * a #uGnssDecUnion_t and use the returned message ID to determine
+ * which member of the union to look at.
+ *
+ * @param[in] pBuffer     the buffer containing the message to be
+ *                        decoded; cannot be NULL.
+ * @param size            the amount of data at pBuffer.
+ * @param[out] pBody      a pointer to the structure to decode into,
+ *                        which must be of the type that matches the
+ *                        message (e.g. #uGnssDecUbxNavSat_t for
+ *                        UBX-NAV-SAT) or a #uGnssDecUnion_t; cannot
+ *                        be NULL.  The contents are only valid if
+ *                        the return value is the message ID (or
+ *                        #U_ERROR_COMMON_BAD_DATA, in which case
+ *                        the repeated blocks that were present in
+ *                        the message have been decoded).
+ * @param bodySize        the amount of storage at pBody.
+ * @return                on success the UBX message class and
+ *                        message ID, as U_GNSS_UBX_MESSAGE() would
+ *                        return them, else negative error code:
+ *                        #U_ERROR_COMMON_UNKNOWN if the message is
+ *                        not a UBX message,
+ *                        #U_ERROR_COMMON_NOT_SUPPORTED if it is
+ *                        a UBX message that cannot be decoded,
+ *                        #U_ERROR_COMMON_TRUNCATED if the message
+ *                        is incomplete, #U_ERROR_COMMON_NO_MEMORY
+ *                        if bodySize is too small for the message
+ *                        or #U_ERROR_COMMON_BAD_DATA if the message
+ *                        has fewer repeated blocks than it indicates.
+ */
+int32_t uGnssDecUbx(const char *pBuffer, size_t size,
+                    void *pBody, size_t bodySize);
+
 /** Free the memory returned by pUGnssDecAlloc().
  *
  * @param[in] pDec the pointer returned by pUGnssDecAlloc(); may
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_DEC_UBX_ESF_MEAS_H_
+#define _U_GNSS_DEC_UBX_ESF_MEAS_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the types of a UBX-ESF-MEAS
+ * message.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The message class of a UBX-ESF-MEAS message.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_MESSAGE_CLASS 0x10
+
+/** The message ID of a UBX-ESF-MEAS message.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_MESSAGE_ID 0x02
+
+/** The minimum length of the body of a UBX-ESF-MEAS message.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_BODY_MIN_LENGTH 8
+
+/** The maximum number of measurements in a UBX-ESF-MEAS message,
+ * limited by the width of the numMeas bit-field of "flags"; all
+ * of them are decoded.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_DATA_MAX_NUM 31
+
+/** Bit mask for the #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT
+ * field of #uGnssDecUbxEsfMeasFlags_t.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT_MASK (0x03 << U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT)
+
+/** Bit mask for the #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS field of
+ * #uGnssDecUbxEsfMeasFlags_t.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS_MASK (0x1f << U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS)
+
+/** Bit mask for the data field of the "data" field of
+ * #uGnssDecUbxEsfMeasData_t; the meaning and scaling depends
+ * on the data type.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_DATA_DATA_FIELD_MASK 0x00ffffffUL
+
+/** Bit mask for the data type of the "data" field of
+ * #uGnssDecUbxEsfMeasData_t, shift down by 24 bits after
+ * masking; e.g. 5 is gyroscope z-axis angular rate, 11
+ * speed, 16 accelerometer x-axis specific force.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_DATA_DATA_TYPE_MASK 0x3f000000UL
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Bit fields of the "flags" field of #uGnssDecUbxEsfMeas_t; use
+ * these to mask specific bits, e.g.
+ *
+ * `if (flags & (1 << U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_CALIB_TTAG_VALID)) {`
+ *
+ * ...would determine if the calibTtag field is valid.
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT = 0,   /**< not a single bit,
+                                                             the start of a 2-bit
+                                                             field, use
+                                                             #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT_MASK
+                                                             to mask it: 0 none,
+                                                             1 on external input 0,
+                                                             2 on external input 1. */
+    U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_EDGE = 2,   /**< time mark signal was
+                                                             supplied just after a
+                                                             falling edge, else a
+                                                             rising edge. */
+    U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_CALIB_TTAG_VALID = 3, /**< the calibTtag field
+                                                             is valid. */
+    U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS = 11         /**< not a single bit,
+                                                             the start of a 5-bit
+                                                             field, use
+                                                             #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS_MASK
+                                                             to mask it: the number
+                                                             of measurements. */
+} uGnssDecUbxEsfMeasFlags_t;
+
+/** The repeated part of a UBX-ESF-MEAS message, one per
+ * measurement.
+ */
+typedef struct {
+    uint32_t data; /**< the data, see
+                        #U_GNSS_DEC_UBX_ESF_MEAS_DATA_DATA_FIELD_MASK
+                        and #U_GNSS_DEC_UBX_ESF_MEAS_DATA_DATA_TYPE_MASK. */
+} uGnssDecUbxEsfMeasData_t;
+
+/** UBX-ESF-MEAS message structure; the naming and type of each
+ * element follows that of the interface manual.
+ */
+typedef struct {
+    uint32_t timeTag;   /**< time tag of the measurement generated by
+                             the external sensor. */
+    uint16_t flags;     /**< see #uGnssDecUbxEsfMeasFlags_t. */
+    uint16_t id;        /**< identification number of the data
+                             provider. */
+    size_t numDecoded;  /**< the number of entries of data that have
+                             been populated. */
+    uGnssDecUbxEsfMeasData_t data[U_GNSS_DEC_UBX_ESF_MEAS_DATA_MAX_NUM]; /**< the
+                                                                              measurements. */
+    uint32_t calibTtag; /**< receiver local time calibrated in
+                             milliseconds, only populated if the
+                             #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_CALIB_TTAG_VALID
+                             bit of flags is set. */
+} uGnssDecUbxEsfMeas_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_DEC_UBX_ESF_MEAS_H_
+
+// End of file
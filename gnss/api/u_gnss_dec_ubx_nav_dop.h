@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_DEC_UBX_NAV_DOP_H_
+#define _U_GNSS_DEC_UBX_NAV_DOP_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the types of a UBX-NAV-DOP
+ * message.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The message class of a UBX-NAV-DOP message.
+ */
+#define U_GNSS_DEC_UBX_NAV_DOP_MESSAGE_CLASS 0x01
+
+/** The message ID of a UBX-NAV-DOP message.
+ */
+#define U_GNSS_DEC_UBX_NAV_DOP_MESSAGE_ID 0x04
+
+/** The minimum length of the body of a UBX-NAV-DOP message.
+ */
+#define U_GNSS_DEC_UBX_NAV_DOP_BODY_MIN_LENGTH 18
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** UBX-NAV-DOP message structure; the naming and type of each
+ * element follows that of the interface manual.  All of the
+ * dilution of precision values are unitless, times 100.
+ */
+typedef struct {
+    uint32_t iTOW; /**< GPS time of week of the navigation epoch
+                        in milliseconds. */
+    uint16_t gDOP; /**< geometric DOP times 100. */
+    uint16_t pDOP; /**< position DOP times 100. */
+    uint16_t tDOP; /**< time DOP times 100. */
+    uint16_t vDOP; /**< vertical DOP times 100. */
+    uint16_t hDOP; /**< horizontal DOP times 100. */
+    uint16_t nDOP; /**< northing DOP times 100. */
+    uint16_t eDOP; /**< easting DOP times 100. */
+} uGnssDecUbxNavDop_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_DEC_UBX_NAV_DOP_H_
+
+// End of file
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_DEC_UBX_RXM_RAWX_H_
+#define _U_GNSS_DEC_UBX_RXM_RAWX_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the types of a UBX-RXM-RAWX
+ * message.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The message class of a UBX-RXM-RAWX message.
+ */
+#define U_GNSS_DEC_UBX_RXM_RAWX_MESSAGE_CLASS 0x02
+
+/** The message ID of a UBX-RXM-RAWX message.
+ */
+#define U_GNSS_DEC_UBX_RXM_RAWX_MESSAGE_ID 0x15
+
+/** The minimum length of the body of a UBX-RXM-RAWX message.
+ */
+#define U_GNSS_DEC_UBX_RXM_RAWX_BODY_MIN_LENGTH 16
+
+#ifndef U_GNSS_DEC_UBX_RXM_RAWX_MEAS_MAX_NUM
+/** The maximum number of measurements that will be decoded from
+ * a UBX-RXM-RAWX message, the size of the meas array in
+ * #uGnssDecUbxRxmRawx_t; any more are ignored.
+ */
+# define U_GNSS_DEC_UBX_RXM_RAWX_MEAS_MAX_NUM 64
+#endif
+
+/** Bit mask for the standard deviation fields prStdev, cpStdev
+ * and doStdev of #uGnssDecUbxRxmRawxMeas_t.
+ */
+#define U_GNSS_DEC_UBX_RXM_RAWX_STDEV_MASK 0x0f
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Bit fields of the "recStat" field of #uGnssDecUbxRxmRawx_t; use
+ * these to mask specific bits, e.g.
+ *
+ * `if (recStat & (1 << U_GNSS_DEC_UBX_RXM_RAWX_REC_STAT_LEAP_SEC)) {`
+ *
+ * ...would determine if leap seconds have been determined.
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_RXM_RAWX_REC_STAT_LEAP_SEC = 0, /**< leap seconds have
+                                                        been determined. */
+    U_GNSS_DEC_UBX_RXM_RAWX_REC_STAT_CLK_RESET = 1 /**< a clock reset has
+                                                        been applied;
+                                                        typically the carrier
+                                                        phase measurements
+                                                        should be treated as
+                                                        discontinuous. */
+} uGnssDecUbxRxmRawxRecStat_t;
+
+/** Bit fields of the "trkStat" field of #uGnssDecUbxRxmRawxMeas_t.
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_RXM_RAWX_TRK_STAT_PR_VALID = 0,    /**< the pseudorange
+                                                           is valid. */
+    U_GNSS_DEC_UBX_RXM_RAWX_TRK_STAT_CP_VALID = 1,    /**< the carrier phase
+                                                           is valid. */
+    U_GNSS_DEC_UBX_RXM_RAWX_TRK_STAT_HALF_CYC = 2,    /**< half cycle is valid. */
+    U_GNSS_DEC_UBX_RXM_RAWX_TRK_STAT_SUB_HALF_CYC = 3 /**< half cycle has been
+                                                           subtracted from the
+                                                           phase. */
+} uGnssDecUbxRxmRawxTrkStat_t;
+
+/** The repeated part of a UBX-RXM-RAWX message, one per
+ * measurement.
+ */
+typedef struct {
+    double prMes;      /**< pseudorange measurement in metres. */
+    double cpMes;      /**< carrier phase measurement in cycles. */
+    float doMes;       /**< Doppler measurement in Hz, positive
+                            sign for approaching satellites. */
+    uint8_t gnssId;    /**< GNSS identifier, 0 GPS, 1 SBAS, 2 Galileo,
+                            3 BeiDou, 5 QZSS, 6 GLONASS, 7 NavIC. */
+    uint8_t svId;      /**< satellite identifier. */
+    uint8_t sigId;     /**< signal identifier, the meaning of which
+                            depends on gnssId. */
+    uint8_t freqId;    /**< GLONASS frequency slot plus 7, range 0 to 13. */
+    uint16_t locktime; /**< carrier phase locktime counter in
+                            milliseconds, maximum 64500. */
+    uint8_t cno;       /**< carrier to noise ratio in dBHz. */
+    uint8_t prStdev;   /**< estimated pseudorange standard deviation:
+                            mask with #U_GNSS_DEC_UBX_RXM_RAWX_STDEV_MASK
+                            to get n, the deviation being 0.01 * 2^n
+                            metres. */
+    uint8_t cpStdev;   /**< estimated carrier phase standard deviation:
+                            mask with #U_GNSS_DEC_UBX_RXM_RAWX_STDEV_MASK
+                            to get n, the deviation being 0.004 * n
+                            cycles. */
+    uint8_t doStdev;   /**< estimated Doppler standard deviation:
+                            mask with #U_GNSS_DEC_UBX_RXM_RAWX_STDEV_MASK
+                            to get n, the deviation being 0.002 * 2^n
+                            Hz. */
+    uint8_t trkStat;   /**< see #uGnssDecUbxRxmRawxTrkStat_t. */
+} uGnssDecUbxRxmRawxMeas_t;
+
+/** UBX-RXM-RAWX message structure; the naming and type of each
+ * element follows that of the interface manual.
+ */
+typedef struct {
+    double rcvTow;     /**< measurement time of week in receiver local
+                            time, in seconds. */
+    uint16_t week;     /**< GPS week number in receiver local time. */
+    int8_t leapS;      /**< GPS leap seconds (GPS-UTC). */
+    uint8_t numMeas;   /**< the number of measurements in the message,
+                            which may be larger than numDecoded. */
+    uint8_t recStat;   /**< see #uGnssDecUbxRxmRawxRecStat_t. */
+    uint8_t version;   /**< message version. */
+    size_t numDecoded; /**< the number of entries of meas that have
+                            been populated, at most
+                            #U_GNSS_DEC_UBX_RXM_RAWX_MEAS_MAX_NUM. */
+    uGnssDecUbxRxmRawxMeas_t meas[U_GNSS_DEC_UBX_RXM_RAWX_MEAS_MAX_NUM]; /**< the
+                                                                              measurements. */
+} uGnssDecUbxRxmRawx_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_DEC_UBX_RXM_RAWX_H_
+
+// End of file
@@ -0,0 +1,377 @@
+#!/usr/bin/env python
+
+'''Update the file u_gnss_dec.c with UBX message decode tables.'''
+
+import os
+import sys # For exit()
+import shutil # For copyfile()
+import argparse
+
+# This script reads the message definition file
+# u_gnss_dec_ubx_table.txt and re-writes the message
+# tables in the file u_gnss_dec.c, which are used
+# by the table-driven UBX decoder in that file.
+#
+# It works like this:
+#
+# 1. Reads the definition file line by line, ignoring
+#    blank lines and lines beginning with '#'.  Each
+#    "message" line starts a new message, each "field"
+#    line adds a field to it, a "block" line describes
+#    a repeated block of fields, each "bfield" line adds
+#    a field to that block and each "tail" line adds
+#    a field which follows the repeated blocks; see the
+#    top of the definition file for the format of each.
+#
+# 2. For each message it creates a list of field
+#    descriptors, e.g.:
+#
+#    static const uGnssDecUbxField_t gUbxNavDopFieldList[] = {
+#        U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavDop_t, iTOW, 0, U4),
+#        ...
+#    };
+#
+#    ...plus, if the message has one, a block descriptor,
+#    and finally the list of message IDs returned by
+#    uGnssDecGetIdList() and the list of message descriptors,
+#    in the same order as the messages appear in the
+#    definition file.
+#
+# 3. It looks for two markers in the target file:
+#
+#    // *** DO NOT MODIFY THIS LINE OR BELOW: AUTO-GENERATED BY u_gnss_dec_ubx_table.py ***
+#
+#   ...and
+#
+#    // *** DO NOT MODIFY THIS LINE OR ABOVE: DO NOT MODIFY AREA ENDS ***
+#
+#    ...erases anything between them and and writes all of the
+#    generated tables there instead.  A backup is made of the
+#    current file, just in case.
+
+# The message definition file
+DEFINITION_FILE_NAME = "u_gnss_dec_ubx_table.txt"
+
+# The file to be modified
+TARGET_FILE_NAME = os.path.join("..", "src", "u_gnss_dec.c")
+
+# The file extension to be used for the back-up of the file
+BACKUP_EXTENSION = "_bak"
+
+# The prefix of the macros that define the message class,
+# message ID and minimum body length of a message
+MESSAGE_MACRO_PREFIX = "U_GNSS_DEC_UBX_"
+
+# The prefix of all generated variable names
+VARIABLE_PREFIX = "gUbx"
+
+# The marker to look for, beyond which we can re-write the target
+# file up to FILE_REWRITE_MARKER_END
+FILE_REWRITE_MARKER_START = "// *** DO NOT MODIFY THIS LINE OR BELOW: AUTO-GENERATED BY u_gnss_dec_ubx_table.py ***"
+
+# The marker up to which the target file can be re-written
+FILE_REWRITE_MARKER_END = "// *** DO NOT MODIFY THIS LINE OR ABOVE: DO NOT MODIFY AREA ENDS ***"
+
+# The field types of the interface manual that can be decoded,
+# each of which must have a matching U_GNSS_DEC_UBX_TYPE_xxx
+# entry in uGnssDecUbxType_t, and their lengths in bytes
+FIELD_TYPE_LIST = [("U1", 1), ("I1", 1), ("X1", 1), ("E1", 1),
+                   ("U2", 2), ("I2", 2), ("X2", 2), ("E2", 2),
+                   ("U4", 4), ("I4", 4), ("X4", 4), ("E4", 4),
+                   ("U8", 8), ("I8", 8), ("R4", 4), ("R8", 8)]
+
+def field_type_length(field_type):
+    '''Return the length of a field type, or -1 if the type is not known'''
+    length = -1
+    for field_type_tuple in FIELD_TYPE_LIST:
+        if field_type_tuple[0] == field_type:
+            length = field_type_tuple[1]
+            break
+    return length
+
+def camel_case(name):
+    '''Convert a message name, e.g. NAV_PVT, into camel case, e.g. NavPvt'''
+    camel = ""
+    for bit in name.split("_"):
+        camel += bit[0].upper() + bit[1:].lower()
+    return camel
+
+def read_field(bits, line_number):
+    '''Read a field from a split line, returning a (offset, type, member) tuple or None'''
+    field = None
+    if len(bits) == 4:
+        try:
+            offset = int(bits[1], 0)
+            if field_type_length(bits[2]) > 0:
+                field = (offset, bits[2], bits[3])
+            else:
+                print(f"Line {line_number}: unknown field type \"{bits[2]}\".")
+        except ValueError:
+            print(f"Line {line_number}: malformed offset \"{bits[1]}\".")
+    else:
+        print(f"Line {line_number}: expected \"{bits[0]} <offset> <type> <member>\".")
+    return field
+
+def read_block(bits, line_number):
+    '''Read a block from a split line, returning a dictionary or None'''
+    block = None
+    if len(bits) == 10:
+        try:
+            block = {"offset": int(bits[1], 0),
+                     "length": int(bits[2], 0),
+                     "count_offset": int(bits[3], 0),
+                     "count_type": bits[4],
+                     "count_shift": int(bits[5], 0),
+                     "count_mask": int(bits[6], 0),
+                     "array": bits[7],
+                     "element_type": bits[8],
+                     "count_member": bits[9],
+                     "field_list": [],
+                     "tail_list": []}
+            if field_type_length(block["count_type"]) <= 0:
+                print(f"Line {line_number}: unknown count type \"{block['count_type']}\".")
+                block = None
+        except ValueError:
+            print(f"Line {line_number}: malformed number in block definition.")
+    else:
+        print(f"Line {line_number}: expected \"block <offset> <length> <count offset>" \
+              " <count type> <count shift> <count mask> <array member> <element type>" \
+              " <count member>\".")
+    return block
+
+def read_definitions(line_list):
+    '''Read the message definitions from a list of lines, returning a list of dictionaries'''
+    message_list = []
+    message = None
+    success = True
+
+    for idx, line in enumerate(line_list):
+        line_number = idx + 1
+        bits = line.split()
+        if not bits or bits[0].startswith("#"):
+            continue
+        if bits[0] == "message":
+            if len(bits) == 3:
+                message = {"name": bits[1], "type": bits[2],
+                           "field_list": [], "block": None}
+                message_list.append(message)
+            else:
+                print(f"Line {line_number}: expected \"message <NAME> <structure type>\".")
+                success = False
+        elif message is None:
+            print(f"Line {line_number}: \"{bits[0]}\" before any \"message\" line.")
+            success = False
+        elif bits[0] == "field":
+            field = read_field(bits, line_number)
+            if field:
+                message["field_list"].append(field)
+            else:
+                success = False
+        elif bits[0] == "block":
+            if message["block"] is None:
+                message["block"] = read_block(bits, line_number)
+                if message["block"] is None:
+                    success = False
+            else:
+                print(f"Line {line_number}: only one block is allowed per message.")
+                success = False
+        elif bits[0] in ("bfield", "tail"):
+            field = read_field(bits, line_number)
+            if field and message["block"] is not None:
+                if bits[0] == "bfield":
+                    message["block"]["field_list"].append(field)
+                else:
+                    message["block"]["tail_list"].append(field)
+            else:
+                if message["block"] is None:
+                    print(f"Line {line_number}: \"{bits[0]}\" before any \"block\" line.")
+                success = False
+        else:
+            print(f"Line {line_number}: unknown keyword \"{bits[0]}\".")
+            success = False
+        if not success:
+            message_list = []
+            break
+
+    return message_list
+
+def field_list_lines(variable_name, struct_type, field_list):
+    '''Return the lines of C code for a list of field descriptors'''
+    line_list = [f"static const uGnssDecUbxField_t {variable_name}[] = {{\n"]
+    for idx, field in enumerate(field_list):
+        line = f"    U_GNSS_DEC_UBX_FIELD({struct_type}, {field[2]}, {field[0]}, {field[1]})"
+        if idx < len(field_list) - 1:
+            line += ","
+        line_list.append(line + "\n")
+    line_list.append("};\n")
+    line_list.append("\n")
+    return line_list
+
+def create_tables(message_list):
+    '''Create the lines of C code for all of the message tables'''
+    line_list = []
+    id_line_list = []
+    message_line_list = []
+
+    for idx, message in enumerate(message_list):
+        prefix = VARIABLE_PREFIX + camel_case(message["name"])
+        field_list_name = prefix + "FieldList"
+        block_name = "NULL"
+        line_list.append(f"// UBX-{message['name'].replace('_', '-')}.\n")
+        line_list += field_list_lines(field_list_name, message["type"], message["field_list"])
+        block = message["block"]
+        if block is not None:
+            block_field_list_name = prefix + "BlockFieldList"
+            tail_field_list_name = "NULL"
+            tail_field_list_num = "0"
+            line_list += field_list_lines(block_field_list_name, block["element_type"],
+                                          block["field_list"])
+            if block["tail_list"]:
+                tail_field_list_name = prefix + "TailFieldList"
+                tail_field_list_num = f"U_GNSS_DEC_UBX_FIELD_LIST_NUM({tail_field_list_name})"
+                line_list += field_list_lines(tail_field_list_name, message["type"],
+                                              block["tail_list"])
+            block_name = "&" + prefix + "Block"
+            line_list.append(f"static const uGnssDecUbxBlock_t {prefix}Block =\n")
+            line_list.append(f"    U_GNSS_DEC_UBX_BLOCK({message['type']}, {block['offset']}, "
+                             f"{block['length']}, {block['count_offset']}, "
+                             f"{block['count_type']}, {block['count_shift']}, "
+                             f"0x{block['count_mask']:x},\n")
+            line_list.append(f"                         {block['array']}, "
+                             f"{block['element_type']}, {block['count_member']},\n")
+            line_list.append(f"                         {block_field_list_name},\n")
+            line_list.append(f"                         {tail_field_list_name},\n")
+            line_list.append(f"                         {tail_field_list_num});\n")
+            line_list.append("\n")
+        separator = ","
+        if idx == len(message_list) - 1:
+            separator = ""
+        macro_prefix = MESSAGE_MACRO_PREFIX + message["name"]
+        id_line_list.append("    {\n")
+        id_line_list.append("        .type = U_GNSS_PROTOCOL_UBX,\n")
+        id_line_list.append(f"        .id.ubx = U_GNSS_UBX_MESSAGE({macro_prefix}_MESSAGE_CLASS, "
+                            f"{macro_prefix}_MESSAGE_ID)\n")
+        id_line_list.append("    }" + separator + "\n")
+        message_line_list.append(f"    U_GNSS_DEC_UBX_MESSAGE({message['name']}, {message['type']}, "
+                                 f"{field_list_name}, {block_name}){separator}\n")
+
+    line_list.append("/** The list of known message IDs; order is important,\n")
+    line_list.append(" * MUST be in the same order as gUbxMessageList and both lists\n")
+    line_list.append(" * must contain the same number of elements.\n")
+    line_list.append(" */\n")
+    line_list.append("static const uGnssMessageId_t gIdList[] = {\n")
+    line_list += id_line_list
+    line_list.append("};\n")
+    line_list.append("\n")
+    line_list.append("/** The list of UBX message decode tables; order is important,\n")
+    line_list.append(" * MUST be in the same order as gIdList and both lists must\n")
+    line_list.append(" * contain the same number of elements.\n")
+    line_list.append(" */\n")
+    line_list.append("static const uGnssDecUbxMessage_t gUbxMessageList[] = {\n")
+    line_list += message_line_list
+    line_list.append("};\n")
+
+    return line_list
+
+def rewrite_line_list(table_line_list, input_line_list):
+    '''Re-write the line_list with the tables'''
+    output_line_list = []
+    start_marker_index = -1
+    end_marker_index = -1
+    output_line_list_one = []
+    output_line_list_three = []
+
+    for idx, line in enumerate(input_line_list):
+        # Make a list of all lines up to and include the start marker
+        output_line_list_one.append(line)
+        if line.startswith(FILE_REWRITE_MARKER_START):
+            start_marker_index = idx
+            break
+
+    if start_marker_index >= 0:
+        # Make a list of all lines from [including] the end marker to the end of the list
+        for idx, line in enumerate(input_line_list[start_marker_index:]):
+            if end_marker_index < 0 and line.startswith(FILE_REWRITE_MARKER_END):
+                end_marker_index = idx
+            if end_marker_index >= 0:
+                output_line_list_three.append(line)
+
+    if start_marker_index < 0:
+        print("Could not find the start marker \"{}\" in the file, stopping.".  \
+              format(FILE_REWRITE_MARKER_START))
+    else:
+        if end_marker_index < 0:
+            print("Could not find the end marker \"{}\" in the file, stopping.".  \
+                  format(FILE_REWRITE_MARKER_END))
+        else:
+            # Combine the three lists
+            output_line_list = output_line_list_one + ["\n"] + table_line_list + \
+                               ["\n"] + output_line_list_three
+
+    return output_line_list
+
+def copy_file(source, destination):
+    '''Copy a file from source to destination'''
+    success = False
+
+    try:
+        print(f"Copying {source} to {destination}...")
+        shutil.copyfile(source, destination)
+        success = True
+    except OSError as error:
+        print(f"Error when copying {source} to {destination}: {error}")
+    return success
+
+def main(definition_file, target_file):
+    '''Main as a function'''
+    return_value = 1
+    message_list = []
+    line_list = []
+
+    if os.path.isfile(definition_file):
+        with open(definition_file, "r", encoding="utf8") as file:
+            print(f"Reading message definitions from {definition_file}...")
+            message_list = read_definitions(file.readlines())
+        if message_list:
+            print(f"Found {len(message_list)} message definition(s).")
+            if os.path.isfile(target_file):
+                with open(target_file, "r", encoding="utf8") as file:
+                    # Read the lot in
+                    print(f"Reading file {target_file}...")
+                    line_list = file.readlines()
+                if line_list:
+                    line_list = rewrite_line_list(create_tables(message_list), line_list)
+                if line_list:
+                    # Done everything; make a back-up copy of the file
+                    if copy_file(target_file, target_file + BACKUP_EXTENSION):
+                        #... and write line_list back to the file
+                        with open(target_file, "w", encoding="utf8") as file:
+                            file.writelines(line_list)
+                            print("{} has been re-written.".format(target_file))
+                            return_value = 0
+            else:
+                print(f"\"{target_file}\" is not a file.")
+        else:
+            print(f"No valid message definitions found in {definition_file}, stopping.")
+    else:
+        print(f"\"{definition_file}\" is not a file.")
+
+    return return_value
+
+if __name__ == "__main__":
+    PARSER = argparse.ArgumentParser(description="A script to"         \
+                                     " update the UBX message decode"  \
+                                     " tables in " + TARGET_FILE_NAME + \
+                                     " from the message definitions in " + \
+                                     DEFINITION_FILE_NAME + ".\n")
+    PARSER.add_argument("-d", default=DEFINITION_FILE_NAME, help="the" \
+                        " message definition file, default " + DEFINITION_FILE_NAME)
+    PARSER.add_argument("-f", default=TARGET_FILE_NAME, help="the" \
+                        " file name to update, default " + TARGET_FILE_NAME)
+    ARGS = PARSER.parse_args()
+
+    # Call main()
+    RETURN_VALUE = main(ARGS.d, ARGS.f)
+
+    sys.exit(RETURN_VALUE)
+
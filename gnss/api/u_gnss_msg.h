@@ -52,12 +52,13 @@ extern "C" {
 #endif
 
 #ifndef U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES
-/** A temporary buffer, used as a staging post to get stuff
- * from a streaming source (e.g. I2C or UART or SPI) into the
- * ring buffer; must be less than
- * #U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES - 1 but, since this
- * is just a "chunking" temporary buffer, a rather smaller
- * value is usually a good idea anyway.
+/** The maximum amount of data read from a streaming source
+ * (e.g. I2C or UART or SPI) into the ring buffer in one go;
+ * must be less than #U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES - 1
+ * but, since this is just a "chunking" size, a rather smaller
+ * value is usually a good idea anyway.  The data is read
+ * directly into the ring buffer: the name is historical, no
+ * temporary buffer of this size is allocated.
  */
 # define U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES (U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES / 8)
 #endif
@@ -81,6 +82,35 @@ extern "C" {
 # define U_GNSS_MSG_RECEIVE_TASK_STACK_SIZE_BYTES (1024 * 3)
 #endif
 
+#ifndef U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT
+/** If this is 1 (the default) then, where the transport is UART or
+ * virtual serial, the task started by uGnssMsgReceiveStart() sets the
+ * event callback of the transport, for data received, and waits on that
+ * rather than checking the transport at intervals; this reduces the
+ * time from a message arriving to the callback being called and means
+ * that the task does not wake up needlessly.  Set this to 0 if your
+ * application needs the event callback of the UART that the GNSS chip
+ * is connected to for itself.
+ */
+# define U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT 1
+#endif
+
+#ifndef U_GNSS_MSG_RECEIVE_DATA_EVENT_STACK_SIZE_BYTES
+/** The stack size for the event callback of the transport when
+ * #U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT is 1: all it does is give
+ * a semaphore.
+ */
+# define U_GNSS_MSG_RECEIVE_DATA_EVENT_STACK_SIZE_BYTES U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES
+#endif
+
+#ifndef U_GNSS_MSG_RECEIVE_DATA_EVENT_PRIORITY
+/** The priority of the event callback of the transport when
+ * #U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT is 1: the same as that of
+ * the task started by uGnssMsgReceiveStart().
+ */
+# define U_GNSS_MSG_RECEIVE_DATA_EVENT_PRIORITY (U_CFG_OS_PRIORITY_MAX - 5)
+#endif
+
 #ifndef U_GNSS_MSG_RECEIVE_TASK_QUEUE_LENGTH
 /** The length of the queue controlling the message receive
  * task: just need the one.
@@ -351,6 +381,13 @@ int32_t uGnssMsgReceive(uDeviceHandle_t gnssHandle,
  * be in C code on this MCU and so whether you do it in your
  * application or this API does it internally is a moot point.
  *
+ * Note: where the transport is UART or virtual serial then, while
+ * any message receive is active, the event callback of that transport
+ * is used to wake the message receive task when data arrives (see
+ * #U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT); if the event callback is
+ * already in use, or the transport is I2C or SPI, the task checks the
+ * transport at intervals instead.
+ *
  * @param gnssHandle             the handle of the GNSS instance.
  * @param[in] pMessageId         a pointer to the message ID to capture;
  *                               a copy will be taken so this may be
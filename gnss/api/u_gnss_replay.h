@@ -0,0 +1,224 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_REPLAY_H_
+#define _U_GNSS_REPLAY_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+#include "u_device_serial.h"
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the record/replay functions of
+ * the GNSS API.  These allow the byte stream from a GNSS chip to
+ * be captured and later fed back into this API, at real-time, a
+ * scaled speed, or as fast as it will go, with no GNSS chip
+ * present, e.g. to benchmark message decoding and dispatch.
+ *
+ * A capture begins with a header of #U_GNSS_REPLAY_HEADER_LENGTH_BYTES:
+ * the eight characters #U_GNSS_REPLAY_MAGIC followed by
+ * #U_GNSS_REPLAY_VERSION as a little-endian uint32_t.  Records follow,
+ * each being #U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES of header,
+ * the time at which the data arrived in milliseconds since the
+ * recording started and the length of the data in bytes, both
+ * little-endian uint32_t, followed by that many bytes of data exactly
+ * as they were received from the GNSS chip.
+ *
+ * No file system is assumed: uGnssReplayRecordStart() passes a
+ * capture to a callback, which might write it to a file, and
+ * pUGnssReplayCreate() replays a capture from memory.  The replay
+ * is a virtual serial device (see u_device_serial.h) which should
+ * be passed to uGnssAdd() with the transport type
+ * #U_GNSS_TRANSPORT_VIRTUAL_SERIAL, e.g.:
+ *
+ * ```
+ * uGnssTransportHandle_t transportHandle;
+ * transportHandle.pDeviceSerial = pUGnssReplayCreate(pCapture, captureSize,
+ *                                                    U_GNSS_REPLAY_SPEED_MAX);
+ * uGnssAdd(U_GNSS_MODULE_TYPE_M9, U_GNSS_TRANSPORT_VIRTUAL_SERIAL,
+ *          transportHandle, -1, true, &gnssHandle);
+ * uGnssMsgReceiveStart(gnssHandle, &messageId, callback, NULL);
+ * transportHandle.pDeviceSerial->open(transportHandle.pDeviceSerial, NULL, 0);
+ * while (!uGnssReplayIsFinished(transportHandle.pDeviceSerial)) {
+ *     uPortTaskBlock(100);
+ * }
+ * ```
+ *
+ * Like a serial port, a replay delivers nothing until it is opened,
+ * so open it once whatever is to receive the data is in place;
+ * otherwise, in a replay at maximum speed, the data may all have
+ * gone before anyone is listening.
+ *
+ * Anything this API sends to a replay is discarded, hence only those
+ * parts of this API that listen to the output of the GNSS chip, e.g.
+ * the uGnssMsg API, streamed position and geofencing, will be of use;
+ * anything that waits for a response from the GNSS chip will time
+ * out.  The data is delivered most quickly if
+ * #U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT is 1, the default.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The eight characters at the start of a capture; not
+ * null-terminated in the capture.
+ */
+#define U_GNSS_REPLAY_MAGIC "uGnssRpl"
+
+/** The version of the capture format.
+ */
+#define U_GNSS_REPLAY_VERSION 1
+
+/** The length of the header at the start of a capture.
+ */
+#define U_GNSS_REPLAY_HEADER_LENGTH_BYTES 12
+
+/** The length of the header at the start of each record of
+ * a capture.
+ */
+#define U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES 8
+
+/** The speed to pass to pUGnssReplayCreate() for a replay at
+ * the speed at which the capture was recorded.
+ */
+#define U_GNSS_REPLAY_SPEED_REAL_TIME 100
+
+/** The speed to pass to pUGnssReplayCreate() for a replay as
+ * fast as this API can take the data.
+ */
+#define U_GNSS_REPLAY_SPEED_MAX 0
+
+#ifndef U_GNSS_REPLAY_RECEIVE_SIZE_MAX_BYTES
+/** The most that a replay will report as being available to
+ * read at any one time; this bounds the time taken to find out
+ * how much data has become due.
+ */
+# define U_GNSS_REPLAY_RECEIVE_SIZE_MAX_BYTES 4096
+#endif
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: RECORD
+ * -------------------------------------------------------------- */
+
+/** Start recording the data received from a GNSS chip.  The capture
+ * header is passed to pCallback before this function returns; then,
+ * each time data is brought in from the GNSS chip, the record header
+ * and the data are passed to pCallback.  Only data that this API
+ * receives is recorded, so something (e.g. uGnssMsgReceiveStart())
+ * must be reading from the GNSS chip.  Recording is stopped by
+ * uGnssReplayRecordStop() or when the GNSS instance is removed.
+ * Only streaming transports (i.e. not #U_GNSS_TRANSPORT_AT) may be
+ * recorded.
+ *
+ * @param gnssHandle          the handle of the GNSS instance.
+ * @param[in] pCallback       the function that will be called with
+ *                            the capture, a piece at a time; it
+ *                            is called with the parameters
+ *                            gnssHandle, a pointer to the data, the
+ *                            number of bytes of data and
+ *                            pCallbackParam.  pCallback should return
+ *                            quickly since it is called while data is
+ *                            being received from the GNSS chip; it
+ *                            must not call into this API.  Cannot be
+ *                            NULL.
+ * @param[in] pCallbackParam  a parameter that will be passed to
+ *                            pCallback as its last parameter; may
+ *                            be NULL.
+ * @return                    zero on success else negative error code;
+ *                            #U_ERROR_COMMON_BUSY if a recording is
+ *                            already in progress.
+ */
+int32_t uGnssReplayRecordStart(uDeviceHandle_t gnssHandle,
+                               void (*pCallback) (uDeviceHandle_t gnssHandle,
+                                                  const char *pData,
+                                                  size_t size,
+                                                  void *pCallbackParam),
+                               void *pCallbackParam);
+
+/** Stop recording the data received from a GNSS chip; once this
+ * function has returned the callback given to
+ * uGnssReplayRecordStart() will not be called again.
+ *
+ * @param gnssHandle the handle of the GNSS instance.
+ * @return           zero on success else negative error code.
+ */
+int32_t uGnssReplayRecordStop(uDeviceHandle_t gnssHandle);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: REPLAY
+ * -------------------------------------------------------------- */
+
+/** Create a virtual serial device which replays a capture.  Nothing
+ * is replayed until the open() function of the device is called,
+ * which starts the replay from the beginning, and close() stops it;
+ * the time-line of the replay starts when data is first asked for
+ * after open() has been called.
+ *
+ * @param[in] pCapture  the capture, which must remain valid until
+ *                      uGnssReplayDelete() has been called; cannot
+ *                      be NULL.
+ * @param size          the number of bytes at pCapture.
+ * @param speedPercent  the speed of the replay as a percentage of the
+ *                      speed at which the capture was recorded, e.g.
+ *                      #U_GNSS_REPLAY_SPEED_REAL_TIME for real-time,
+ *                      1000 for ten times real-time, or
+ *                      #U_GNSS_REPLAY_SPEED_MAX for as fast as
+ *                      possible; cannot be negative.
+ * @return              on success a pointer to the virtual serial
+ *                      device, else NULL (e.g. if the capture header
+ *                      is not valid).
+ */
+uDeviceSerial_t *pUGnssReplayCreate(const char *pCapture, size_t size,
+                                    int32_t speedPercent);
+
+/** Determine whether all of the data of a replay has been read.
+ *
+ * @param[in] pDeviceSerial  the replay, as returned by
+ *                           pUGnssReplayCreate(); cannot be NULL.
+ * @return                   true if the replay is open and the
+ *                           whole capture has been read, else false.
+ */
+bool uGnssReplayIsFinished(uDeviceSerial_t *pDeviceSerial);
+
+/** Delete a replay; uGnssRemove() must have been called on any
+ * GNSS instance using the replay before this is called.
+ *
+ * @param[in] pDeviceSerial  the replay, as returned by
+ *                           pUGnssReplayCreate().
+ */
+void uGnssReplayDelete(uDeviceSerial_t *pDeviceSerial);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_REPLAY_H_
+
+// End of file
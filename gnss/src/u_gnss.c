@@ -166,6 +166,8 @@ static void deleteGnssInstance(uGnssPrivateInstance_t *pInstance)
             uGnssPrivateCleanUpStreamedPos(pInstance);
             // Stop asynchronus message receive from happening
             uGnssPrivateStopMsgReceive(pInstance);
+            // Free any recording
+            uPortFree(pInstance->pReplayRecord);
             // Free the SPI buffer, if there is one
             if (pInstance->pSpiRingBuffer != NULL) {
                 uRingBufferDelete(pInstance->pSpiRingBuffer);
@@ -178,7 +180,9 @@ static void deleteGnssInstance(uGnssPrivateInstance_t *pInstance)
                 uPortFree(pInstance->pLinearBuffer);
             }
             // This can go now too
-            uPortFree(pInstance->pTemporaryBuffer);
+            if (pInstance->ringBufferWriteMutex != NULL) {
+                uPortMutexDelete(pInstance->ringBufferWriteMutex);
+            }
             // Unlink any geofences and free the fence context
             uGeofenceContextFree((uGeofenceContext_t **) &pInstance->pFenceContext);
             // Delete the transport mutex
@@ -423,10 +427,9 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                             // which we stream messages received from the module
                             pInstance->pLinearBuffer = (char *) pUPortMalloc(U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES);
                             if (pInstance->pLinearBuffer != NULL) {
-                                // Also need a temporary buffer to get stuff out
-                                // of the UART/I2C/SPI in the first place
-                                pInstance->pTemporaryBuffer = (char *) pUPortMalloc(U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
-                                if (pInstance->pTemporaryBuffer != NULL) {
+                                // Data is read from the UART/I2C/SPI straight into
+                                // the ring buffer, one task at a time
+                                if (uPortMutexCreate(&(pInstance->ringBufferWriteMutex)) == 0) {
                                     // +2 below to keep one for ourselves and one for the
                                     // blocking transparent receive function
                                     errorCode = uRingBufferCreateWithReadHandle(&(pInstance->ringBuffer),
@@ -491,7 +494,9 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                             uRingBufferDelete(&(pInstance->ringBuffer));
                             uPortFree(pInstance->pLinearBuffer);
                         }
-                        uPortFree(pInstance->pTemporaryBuffer);
+                        if (pInstance->ringBufferWriteMutex != NULL) {
+                            uPortMutexDelete(pInstance->ringBufferWriteMutex);
+                        }
                         if (pInstance->transportMutex != NULL) {
                             uPortMutexDelete(pInstance->transportMutex);
                         }
@@ -70,6 +70,16 @@
 # define U_GNSS_CFG_MAX_NUM_VAL_GET_SEGMENTS 50
 #endif
 
+#ifndef U_GNSS_CFG_VAL_GET_ARENA_SIZE_BYTES
+/** The size of the block, on the stack, from which the transient
+ * buffers of a VALGET exchange are allocated; the default is kept
+ * small, to limit stack use, but is enough for the single key ID
+ * of valGetByte() over a streamed transport without touching the
+ * heap, anything larger overflows onto the heap.
+ */
+# define U_GNSS_CFG_VAL_GET_ARENA_SIZE_BYTES 64
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -355,17 +365,22 @@ static int32_t valGetByte(uGnssPrivateInstance_t *pInstance,
     char *pMessage;
     size_t messageInSizeBytes;
     uint32_t y;
+    char arenaBlock[U_GNSS_CFG_VAL_GET_ARENA_SIZE_BYTES];
+    uArena_t arena;
+
+    uArenaInit(&arena, arenaBlock, sizeof(arenaBlock));
 
     // The 4-byte message header is all zeroes: version 0,
     // 0 for the RAM layer, position 0, so all we have to
     // do is copy in the key Id
     *((uint32_t *) &(messageOut[4])) = uUbxProtocolUint32Encode(keyId); // *NOPAD*
     // Send it off and wait for the response
-    errorCodeOrByteValue = uGnssPrivateSendReceiveUbxMessageAlloc(pInstance,
+    errorCodeOrByteValue = uGnssPrivateSendReceiveUbxMessageArena(pInstance,
                                                                   0x06, 0x8b,
                                                                   messageOut,
                                                                   sizeof(messageOut),
-                                                                  &pMessageIn);
+                                                                  &pMessageIn,
+                                                                  &arena);
     // 4 below since there must be at least four bytes of header
     if ((errorCodeOrByteValue >= 4) && (pMessageIn != NULL)) {
         messageInSizeBytes = (size_t) errorCodeOrByteValue;
@@ -384,8 +399,8 @@ static int32_t valGetByte(uGnssPrivateInstance_t *pInstance,
         }
     }
 
-    // Free memory from uGnssPrivateSendReceiveUbxMessageAlloc()
-    uPortFree(pMessageIn);
+    // Free any memory that overflowed from the arena
+    uArenaReset(&arena);
 
     return errorCodeOrByteValue;
 }
@@ -434,14 +449,19 @@ int32_t uGnssCfgPrivateValGetListAlloc(uGnssPrivateInstance_t *pInstance,
     size_t messageOutSize = 4 + (4 * numKeyIds);
     uGnssCfgValGetMessageBody_t messageIn[U_GNSS_CFG_MAX_NUM_VAL_GET_SEGMENTS] = {0};
     size_t messageInCount = 0;
+    char arenaBlock[U_GNSS_CFG_VAL_GET_ARENA_SIZE_BYTES];
+    uArena_t arena;
 
     if ((pInstance != NULL) && (pKeyIdList != NULL) && (numKeyIds > 0) &&
         (pList != NULL) && (encodedLayer >= 0)) {
         errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
         if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_CFGVALXXX)) {
             errorCodeOrCount = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+            // All of the memory of the exchange, other than the
+            // list that is returned, comes from the arena
+            uArenaInit(&arena, arenaBlock, sizeof(arenaBlock));
             // Get memory for the body of the UBX-CFG-VALGET message
-            pMessageOut = (char *) pUPortMalloc(messageOutSize);
+            pMessageOut = (char *) pUArenaAlloc(&arena, messageOutSize);
             if (pMessageOut != NULL) {
                 // Assemble the message
                 *pMessageOut       = 0; // Version
@@ -456,11 +476,12 @@ int32_t uGnssCfgPrivateValGetListAlloc(uGnssPrivateInstance_t *pInstance,
                     *((uint16_t *) (pMessageOut + 2)) = uUbxProtocolUint16Encode((uint16_t) (messageInCount *
                                                                                              U_GNSS_CFG_VAL_MSG_MAX_NUM_VALUES));
                     // Send it off and wait for the response
-                    errorCodeOrCount = uGnssPrivateSendReceiveUbxMessageAlloc(pInstance,
+                    errorCodeOrCount = uGnssPrivateSendReceiveUbxMessageArena(pInstance,
                                                                               0x06, 0x8b,
                                                                               pMessageOut,
                                                                               messageOutSize,
-                                                                              &(messageIn[messageInCount].pBody));
+                                                                              &(messageIn[messageInCount].pBody),
+                                                                              &arena);
                     if (errorCodeOrCount >= 0) {
                         messageIn[messageInCount].size = errorCodeOrCount;
                         messageInCount++;
@@ -476,15 +497,12 @@ int32_t uGnssCfgPrivateValGetListAlloc(uGnssPrivateInstance_t *pInstance,
                 // an error code
                 if (messageInCount > 0) {
                     errorCodeOrCount = unpackMessageAlloc(messageIn, messageInCount, pList);
-                    // Free the memory that was allocated by the send/receive calls
-                    for (size_t x = 0; x < messageInCount; x++) {
-                        uPortFree(messageIn[x].pBody);
-                    }
                 }
-
-                // Free the memory that was used for the outgoing message
-                uPortFree(pMessageOut);
             }
+
+            // Free the memory that was used for the outgoing message
+            // and the responses, should any of it have overflowed
+            uArenaReset(&arena);
         }
     }
 
@@ -25,7 +25,15 @@
  * API, used for decoding a useful subset of messages from a GNSS
  * device.
  *
- * To add a new message to the set of message decoders:
+ * UBX messages are decoded by a single table-driven decoder: the
+ * layout of each message is described by tables which are generated
+ * from the message definition file api/u_gnss_dec_ubx_table.txt by
+ * the script api/u_gnss_dec_ubx_table.py.  The same tables are used
+ * both by pUGnssDecAlloc()/pUGnssDecArenaAlloc(), which allocate the
+ * decoded message body, and by uGnssDecUbx(), which decodes into a
+ * structure provided by the caller and never allocates.
+ *
+ * To add a new UBX message to the set of message decoders:
  *
  * 1.  Create a .h file in the "api" directory which defines the
  * message; for example, if you were creating a decoder for the
@@ -39,39 +47,37 @@
  * interface manual: see u_gnss_dec_ubx_nav_pvt.h for an example.
  * Make sure to follow the usual pattern for the header file gating
  * \#defines and the _MESSAGE_CLASS, _MESSAGE_ID and _BODY_MIN_LENGTH
- * macros.  You may also choose to define helper functions which
- * convert the elements of the structure as defined by the GNSS
+ * macros.  If the message contains a repeated block, represent it
+ * as an array of structures with a size_t member before it to carry
+ * the number of elements populated: see u_gnss_dec_ubx_nav_sat.h
+ * for an example.  You may also choose to define helper functions
+ * which convert the elements of the structure as defined by the GNSS
  * device interface manual into more friendly structures.
  *
  * 2. \#include this new header file in u_gnss_dec.h, add it to
  * ubxlib.h and add the new message struct to the #uGnssDecUnion_t
- * in this file.
- *
- * 3. Create the static decode function for the message here,
- * following the naming pattern, e.g. for UBX-XXX-YYY the function
- * would be named ubxXxxYyyAlloc(); the function  must have the
- * function signature of #uGnssDecKnownFunction_t.
+ * in u_gnss_dec.h.
  *
- * 4. Add the static function to the gpFunctionList array and add
- * its message ID to the gIdList array, making sure to put it in the
- * same position in both.
+ * 3. Describe the fields of the message in u_gnss_dec_ubx_table.txt
+ * (the format is explained at the top of that file) and run
+ * u_gnss_dec_ubx_table.py to re-generate the tables at the end of
+ * the STATIC VARIABLES section of this file.
  *
- * 5. If in step (1) you chose to include helper functions, add a
+ * 4. If in step (1) you chose to include helper functions, add a
  * .c file in this src directory, of the same name as the .h file,
  * which implements the helper functions; see u_gnss_dec_ubx_nav_pvt.c
  * for an example.
  *
- * 6. Add at least one test vector for the function to the
+ * 5. Add at least one test vector for the message to the
  * gTestDataKnownSet array in u_gnss_dec_test.c, using the pattern
  * of gUbxNavPvt as an example, and a spot-test for each helper
  * function if there are any (again, see the handling of UBX-NAV-PVT
  * for an example).
  *
- * Obviously it would be possible to add NMEA messages, or RTCM messages,
- * in the same way, just replacing "ubx" with "nmea" or "rtcm", but note
- * that this code does not use NMEA or RTCM messages and we want to avoid
- * code bloat, hence the uGnssDecSetCallback() hook to allow a customer
- * to add their own decoders at run-time.
+ * Obviously it would be possible to add decoders for NMEA or RTCM
+ * messages, but note that this code does not use NMEA or RTCM messages
+ * and we want to avoid code bloat, hence the uGnssDecSetCallback() hook
+ * to allow a customer to add their own decoders at run-time.
  */
 
 #ifdef U_CFG_OVERRIDE
@@ -104,38 +110,153 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** Flag in a #uGnssDecUbxType_t indicating that the field is signed.
+ */
+#define U_GNSS_DEC_UBX_TYPE_FLAG_SIGNED 0x10
+
+/** Mask to obtain the length of a field in bytes from a
+ * #uGnssDecUbxType_t.
+ */
+#define U_GNSS_DEC_UBX_TYPE_LENGTH_MASK 0x0f
+
+/** Helper to make a #uGnssDecUbxField_t, used by the generated
+ * tables.
+ *
+ * @param structType    the type of the structure that the field
+ *                      is decoded into.
+ * @param member        the member of structType that the field
+ *                      is decoded into.
+ * @param payloadOffset the offset of the field in the message payload
+ *                      (or in the repeated block).
+ * @param type          the type of the field as written in the
+ *                      interface manual, e.g. U4.
+ */
+#define U_GNSS_DEC_UBX_FIELD(structType, member, payloadOffset, type) \
+    {payloadOffset, U_GNSS_DEC_UBX_TYPE_##type,                       \
+     sizeof(((structType *) 0)->member), offsetof(structType, member)}
+
+/** Helper to count the entries of a field list.
+ */
+#define U_GNSS_DEC_UBX_FIELD_LIST_NUM(fieldList) (sizeof(fieldList) / sizeof(uGnssDecUbxField_t))
+
+/** Helper to make a #uGnssDecUbxBlock_t, used by the generated
+ * tables; see u_gnss_dec_ubx_table.txt for the meaning of the
+ * parameters.
+ */
+#define U_GNSS_DEC_UBX_BLOCK(structType, payloadOffset, length,                    \
+                             countOffset, countType, countShift, countMask,        \
+                             array, elementType, numDecoded,                       \
+                             pFieldList, pTailFieldList, numTailFields)            \
+    {payloadOffset, length, countOffset, U_GNSS_DEC_UBX_TYPE_##countType,          \
+     countShift, countMask, offsetof(structType, array), sizeof(elementType),      \
+     sizeof(((structType *) 0)->array) / sizeof(elementType),                      \
+     offsetof(structType, numDecoded),                                             \
+     pFieldList, U_GNSS_DEC_UBX_FIELD_LIST_NUM(pFieldList),                        \
+     pTailFieldList, numTailFields}
+
+/** Helper to make a #uGnssDecUbxMessage_t, used by the generated
+ * tables.
+ *
+ * @param name       the name of the message, e.g. NAV_PVT, such
+ *                   that U_GNSS_DEC_UBX_<name>_MESSAGE_CLASS,
+ *                   U_GNSS_DEC_UBX_<name>_MESSAGE_ID and
+ *                   U_GNSS_DEC_UBX_<name>_BODY_MIN_LENGTH exist.
+ * @param structType the type of the structure the message is
+ *                   decoded into.
+ * @param pFieldList the list of fields of the message.
+ * @param pBlock     pointer to the repeated block of the message,
+ *                   NULL if there is none.
+ */
+#define U_GNSS_DEC_UBX_MESSAGE(name, structType, pFieldList, pBlock)               \
+    {U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_##name##_MESSAGE_CLASS,                     \
+                        U_GNSS_DEC_UBX_##name##_MESSAGE_ID),                       \
+     U_GNSS_DEC_UBX_##name##_BODY_MIN_LENGTH, sizeof(structType),                  \
+     pFieldList, U_GNSS_DEC_UBX_FIELD_LIST_NUM(pFieldList), pBlock}
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
-/** Private version of function that can be hooked into
- * pUGnssDecAlloc() by uGnssDecSetCallback() to decode message types
- * that _are_ known to this code.
- *
- * @param[in] pBuffer             the buffer pointer that was passed to
- *                                pUGnssDecAlloc().
- * @param size                    the number of bytes at pBuffer;
- *                                for a known protocol it _might_
- *                                be that any FCS/check-sum bytes
- *                                on the end have been removed
- *                                by the caller, hence the function
- *                                should not _require_ them to be
- *                                present in the count.
- * @param[out] ppBody             a pointer to a place to put the
- *                                decoded message body, which the
- *                                callback should allocate using
- *                                pUPortMalloc(); will never be NULL.
- * @return                        zero on a successful decode, else
- *                                negative error code, preferably
- *                                from the set suggested for the
- *                                errorCode field of #uGnssDec_t.
+/** The types of field in a UBX message, as written in the interface
+ * manual: the lower nibble is the length of the field in bytes,
+ * #U_GNSS_DEC_UBX_TYPE_FLAG_SIGNED is set for a signed field;
+ * bit-fields, enumerations and reals are decoded as unsigned
+ * values of the same length (the bits of a real being copied
+ * directly into the float or double member).
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_TYPE_U1 = 0x01,
+    U_GNSS_DEC_UBX_TYPE_X1 = 0x01,
+    U_GNSS_DEC_UBX_TYPE_E1 = 0x01,
+    U_GNSS_DEC_UBX_TYPE_U2 = 0x02,
+    U_GNSS_DEC_UBX_TYPE_X2 = 0x02,
+    U_GNSS_DEC_UBX_TYPE_E2 = 0x02,
+    U_GNSS_DEC_UBX_TYPE_U4 = 0x04,
+    U_GNSS_DEC_UBX_TYPE_X4 = 0x04,
+    U_GNSS_DEC_UBX_TYPE_E4 = 0x04,
+    U_GNSS_DEC_UBX_TYPE_R4 = 0x04,
+    U_GNSS_DEC_UBX_TYPE_U8 = 0x08,
+    U_GNSS_DEC_UBX_TYPE_R8 = 0x08,
+    U_GNSS_DEC_UBX_TYPE_I1 = U_GNSS_DEC_UBX_TYPE_FLAG_SIGNED | 0x01,
+    U_GNSS_DEC_UBX_TYPE_I2 = U_GNSS_DEC_UBX_TYPE_FLAG_SIGNED | 0x02,
+    U_GNSS_DEC_UBX_TYPE_I4 = U_GNSS_DEC_UBX_TYPE_FLAG_SIGNED | 0x04,
+    U_GNSS_DEC_UBX_TYPE_I8 = U_GNSS_DEC_UBX_TYPE_FLAG_SIGNED | 0x08
+} uGnssDecUbxType_t;
+
+/** Description of a single field of a UBX message.
+ */
+typedef struct {
+    uint16_t payloadOffset; /**< offset of the field in the payload, or
+                                 in the repeated block. */
+    uint8_t type;           /**< the field type, see #uGnssDecUbxType_t. */
+    uint8_t size;           /**< the size of the structure member that
+                                 the field is decoded into. */
+    uint16_t structOffset;  /**< the offset of that structure member. */
+} uGnssDecUbxField_t;
+
+/** Description of the repeated block of a UBX message.
  */
-typedef int32_t (uGnssDecKnownFunction_t) (const char *pBuffer,
-                                           size_t size,
-                                           uGnssDecUnion_t **ppBody);
+typedef struct {
+    uint16_t payloadOffset;   /**< offset of the first block in the payload. */
+    uint16_t length;          /**< the length of each block. */
+    uint16_t countOffset;     /**< offset of the field in the payload
+                                   giving the number of blocks. */
+    uint8_t countType;        /**< the type of that field. */
+    uint8_t countShift;       /**< right-shift to apply to that field. */
+    uint32_t countMask;       /**< mask to apply to that field after
+                                   shifting. */
+    uint16_t arrayOffset;     /**< offset of the array member in the
+                                   structure. */
+    uint16_t elementSize;     /**< the size of an element of the array. */
+    uint16_t maxNum;          /**< the number of elements in the array. */
+    uint16_t numDecodedOffset; /**< offset of the size_t member in the
+                                    structure which is set to the number
+                                    of elements populated. */
+    const uGnssDecUbxField_t *pFieldList; /**< the fields of each block,
+                                               decoded into an array element. */
+    size_t numFields;         /**< the number of entries at pFieldList. */
+    const uGnssDecUbxField_t *pTailFieldList; /**< fields that follow the
+                                                   blocks, may be NULL. */
+    size_t numTailFields;     /**< the number of entries at pTailFieldList. */
+} uGnssDecUbxBlock_t;
+
+/** Description of a UBX message.
+ */
+typedef struct {
+    uint16_t id;                          /**< the message class and ID,
+                                               as U_GNSS_UBX_MESSAGE(). */
+    uint16_t bodyMinLength;               /**< the minimum body length. */
+    size_t bodySize;                      /**< the size of the structure the
+                                               message is decoded into. */
+    const uGnssDecUbxField_t *pFieldList; /**< the fields of the message. */
+    size_t numFields;                     /**< the number of entries at
+                                               pFieldList. */
+    const uGnssDecUbxBlock_t *pBlock;     /**< the repeated block, NULL if
+                                               there is none. */
+} uGnssDecUbxMessage_t;
 
 /* ----------------------------------------------------------------
- * STATIC VARIABLES: MISC
+ * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
 /** A place to store the user callback.
@@ -146,10 +267,208 @@ static uGnssDecFunction_t *gpCallback = NULL;
  */
 static void *gpCallbackParam = NULL;
 
+/* The message tables below are generated by u_gnss_dec_ubx_table.py
+ * from u_gnss_dec_ubx_table.txt, both in the api directory: do not
+ * edit them by hand.
+ */
+
+// *** DO NOT MODIFY THIS LINE OR BELOW: AUTO-GENERATED BY u_gnss_dec_ubx_table.py ***
+
+// UBX-NAV-PVT.
+static const uGnssDecUbxField_t gUbxNavPvtFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, iTOW, 0, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, year, 4, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, month, 6, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, day, 7, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, hour, 8, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, min, 9, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, sec, 10, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, valid, 11, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, tAcc, 12, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, nano, 16, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, fixType, 20, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, flags, 21, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, flags2, 22, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, numSV, 23, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, lon, 24, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, lat, 28, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, height, 32, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, hMSL, 36, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, hAcc, 40, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, vAcc, 44, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, velN, 48, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, velE, 52, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, velD, 56, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, gSpeed, 60, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, headMot, 64, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, sAcc, 68, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, headAcc, 72, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, pDOP, 76, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, flags3, 78, X2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, headVeh, 84, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, magDec, 88, I2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, magAcc, 90, U2)
+};
+
+// UBX-NAV-HPPOSLLH.
+static const uGnssDecUbxField_t gUbxNavHpposllhFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, version, 0, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, flags, 3, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, iTOW, 4, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, lon, 8, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, lat, 12, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, height, 16, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, hMSL, 20, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, lonHp, 24, I1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, latHp, 25, I1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, heightHp, 26, I1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, hMSLHp, 27, I1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, hAcc, 28, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, vAcc, 32, U4)
+};
+
+// UBX-NAV-DOP.
+static const uGnssDecUbxField_t gUbxNavDopFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavDop_t, iTOW, 0, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavDop_t, gDOP, 4, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavDop_t, pDOP, 6, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavDop_t, tDOP, 8, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavDop_t, vDOP, 10, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavDop_t, hDOP, 12, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavDop_t, nDOP, 14, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavDop_t, eDOP, 16, U2)
+};
+
+// UBX-NAV-STATUS.
+static const uGnssDecUbxField_t gUbxNavStatusFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavStatus_t, iTOW, 0, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavStatus_t, gpsFix, 4, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavStatus_t, flags, 5, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavStatus_t, fixStat, 6, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavStatus_t, flags2, 7, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavStatus_t, ttff, 8, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavStatus_t, msss, 12, U4)
+};
+
+// UBX-NAV-SAT.
+static const uGnssDecUbxField_t gUbxNavSatFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSat_t, iTOW, 0, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSat_t, version, 4, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSat_t, numSvs, 5, U1)
+};
+
+static const uGnssDecUbxField_t gUbxNavSatBlockFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, gnssId, 0, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, svId, 1, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, cno, 2, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, elev, 3, I1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, azim, 4, I2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, prRes, 6, I2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, flags, 8, X4)
+};
+
+static const uGnssDecUbxBlock_t gUbxNavSatBlock =
+    U_GNSS_DEC_UBX_BLOCK(uGnssDecUbxNavSat_t, 8, 12, 5, U1, 0, 0xff,
+                         sv, uGnssDecUbxNavSatSv_t, numDecoded,
+                         gUbxNavSatBlockFieldList,
+                         NULL,
+                         0);
+
+// UBX-NAV-SIG.
+static const uGnssDecUbxField_t gUbxNavSigFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSig_t, iTOW, 0, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSig_t, version, 4, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSig_t, numSigs, 5, U1)
+};
+
+static const uGnssDecUbxField_t gUbxNavSigBlockFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, gnssId, 0, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, svId, 1, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, sigId, 2, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, freqId, 3, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, prRes, 4, I2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, cno, 6, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, qualityInd, 7, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, corrSource, 8, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, ionoModel, 9, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, sigFlags, 10, X2)
+};
+
+static const uGnssDecUbxBlock_t gUbxNavSigBlock =
+    U_GNSS_DEC_UBX_BLOCK(uGnssDecUbxNavSig_t, 8, 16, 5, U1, 0, 0xff,
+                         sig, uGnssDecUbxNavSigSig_t, numDecoded,
+                         gUbxNavSigBlockFieldList,
+                         NULL,
+                         0);
+
+// UBX-RXM-RAWX.
+static const uGnssDecUbxField_t gUbxRxmRawxFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, rcvTow, 0, R8),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, week, 8, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, leapS, 10, I1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, numMeas, 11, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, recStat, 12, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, version, 13, U1)
+};
+
+static const uGnssDecUbxField_t gUbxRxmRawxBlockFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, prMes, 0, R8),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, cpMes, 8, R8),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, doMes, 16, R4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, gnssId, 20, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, svId, 21, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, sigId, 22, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, freqId, 23, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, locktime, 24, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, cno, 26, U1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, prStdev, 27, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, cpStdev, 28, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, doStdev, 29, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, trkStat, 30, X1)
+};
+
+static const uGnssDecUbxBlock_t gUbxRxmRawxBlock =
+    U_GNSS_DEC_UBX_BLOCK(uGnssDecUbxRxmRawx_t, 16, 32, 11, U1, 0, 0xff,
+                         meas, uGnssDecUbxRxmRawxMeas_t, numDecoded,
+                         gUbxRxmRawxBlockFieldList,
+                         NULL,
+                         0);
+
+// UBX-TIM-TP.
+static const uGnssDecUbxField_t gUbxTimTpFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, towMS, 0, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, towSubMS, 4, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, qErr, 8, I4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, week, 12, U2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, flags, 14, X1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, refInfo, 15, X1)
+};
+
+// UBX-ESF-MEAS.
+static const uGnssDecUbxField_t gUbxEsfMeasFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxEsfMeas_t, timeTag, 0, U4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxEsfMeas_t, flags, 4, X2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxEsfMeas_t, id, 6, U2)
+};
+
+static const uGnssDecUbxField_t gUbxEsfMeasBlockFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxEsfMeasData_t, data, 0, X4)
+};
+
+static const uGnssDecUbxField_t gUbxEsfMeasTailFieldList[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxEsfMeas_t, calibTtag, 0, U4)
+};
+
+static const uGnssDecUbxBlock_t gUbxEsfMeasBlock =
+    U_GNSS_DEC_UBX_BLOCK(uGnssDecUbxEsfMeas_t, 8, 4, 4, X2, 11, 0x1f,
+                         data, uGnssDecUbxEsfMeasData_t, numDecoded,
+                         gUbxEsfMeasBlockFieldList,
+                         gUbxEsfMeasTailFieldList,
+                         U_GNSS_DEC_UBX_FIELD_LIST_NUM(gUbxEsfMeasTailFieldList));
+
 /** The list of known message IDs; order is important,
- * MUST be in the same order as gpFunctionList (see further
- * down in this file) and both lists must contain the same number
- * of elements.
+ * MUST be in the same order as gUbxMessageList and both lists
+ * must contain the same number of elements.
  */
 static const uGnssMessageId_t gIdList[] = {
     {
@@ -159,155 +478,214 @@ static const uGnssMessageId_t gIdList[] = {
     {
         .type = U_GNSS_PROTOCOL_UBX,
         .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_HPPOSLLH_MESSAGE_CLASS, U_GNSS_DEC_UBX_NAV_HPPOSLLH_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_DOP_MESSAGE_CLASS, U_GNSS_DEC_UBX_NAV_DOP_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_STATUS_MESSAGE_CLASS, U_GNSS_DEC_UBX_NAV_STATUS_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_SAT_MESSAGE_CLASS, U_GNSS_DEC_UBX_NAV_SAT_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_SIG_MESSAGE_CLASS, U_GNSS_DEC_UBX_NAV_SIG_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_RXM_RAWX_MESSAGE_CLASS, U_GNSS_DEC_UBX_RXM_RAWX_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_TIM_TP_MESSAGE_CLASS, U_GNSS_DEC_UBX_TIM_TP_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_ESF_MEAS_MESSAGE_CLASS, U_GNSS_DEC_UBX_ESF_MEAS_MESSAGE_ID)
     }
 };
 
-// MORE STATIC VARIABLES after the message decoders...
+/** The list of UBX message decode tables; order is important,
+ * MUST be in the same order as gIdList and both lists must
+ * contain the same number of elements.
+ */
+static const uGnssDecUbxMessage_t gUbxMessageList[] = {
+    U_GNSS_DEC_UBX_MESSAGE(NAV_PVT, uGnssDecUbxNavPvt_t, gUbxNavPvtFieldList, NULL),
+    U_GNSS_DEC_UBX_MESSAGE(NAV_HPPOSLLH, uGnssDecUbxNavHpposllh_t, gUbxNavHpposllhFieldList, NULL),
+    U_GNSS_DEC_UBX_MESSAGE(NAV_DOP, uGnssDecUbxNavDop_t, gUbxNavDopFieldList, NULL),
+    U_GNSS_DEC_UBX_MESSAGE(NAV_STATUS, uGnssDecUbxNavStatus_t, gUbxNavStatusFieldList, NULL),
+    U_GNSS_DEC_UBX_MESSAGE(NAV_SAT, uGnssDecUbxNavSat_t, gUbxNavSatFieldList, &gUbxNavSatBlock),
+    U_GNSS_DEC_UBX_MESSAGE(NAV_SIG, uGnssDecUbxNavSig_t, gUbxNavSigFieldList, &gUbxNavSigBlock),
+    U_GNSS_DEC_UBX_MESSAGE(RXM_RAWX, uGnssDecUbxRxmRawx_t, gUbxRxmRawxFieldList, &gUbxRxmRawxBlock),
+    U_GNSS_DEC_UBX_MESSAGE(TIM_TP, uGnssDecUbxTimTp_t, gUbxTimTpFieldList, NULL),
+    U_GNSS_DEC_UBX_MESSAGE(ESF_MEAS, uGnssDecUbxEsfMeas_t, gUbxEsfMeasFieldList, &gUbxEsfMeasBlock)
+};
+
+// *** DO NOT MODIFY THIS LINE OR ABOVE: DO NOT MODIFY AREA ENDS ***
 
 /* ----------------------------------------------------------------
- * STATIC FUNCTIONS: MESSAGE DECODERS
+ * STATIC FUNCTIONS: UBX MESSAGE DECODER
  * -------------------------------------------------------------- */
 
-// Decode a UBX-NAV-PVT message.
-static int32_t ubxNavPvtAlloc(const char *pBuffer, size_t size,
-                              uGnssDecUnion_t **ppBody)
+// Assemble the little-endian value of a field of the given type,
+// sign-extending it if it is signed.
+static uint64_t ubxValueDecode(const uint8_t *pData, uint8_t type)
 {
-    int32_t errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
-    uGnssDecUbxNavPvt_t *pBody;
-
-    // No need to check pBuffer or ppBody for NULLity,
-    // we will never give this function NULL for those.
-    if (size >= U_UBX_PROTOCOL_HEADER_LENGTH_BYTES + U_GNSS_DEC_UBX_NAV_PVT_BODY_MIN_LENGTH) {
-        // Move past the header so that we can use payload offsets
-        // throughout, matching the offsets in the interface manual
-        pBuffer += U_UBX_PROTOCOL_HEADER_LENGTH_BYTES;
-        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-        pBody = (uGnssDecUbxNavPvt_t *) pUPortMalloc(sizeof(uGnssDecUbxNavPvt_t));
-        if (pBody != NULL) {
-            memset(pBody, 0, sizeof(*pBody));
-            // All good now, unless we hit a field we can't decode,
-            // in which case we _could_ set U_ERROR_COMMON_BAD_DATA,
-            // but, since this message will have been checked for
-            // integrity before it gets here, it is better to trust
-            // that the module emitted stuff correctly: it knows
-            // more about this than we do
-            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-            pBody->iTOW = (int32_t) uUbxProtocolUint32Decode(pBuffer + 0);
-            pBody->year = uUbxProtocolUint16Decode(pBuffer + 4);
-            pBody->month = (uint8_t) *(pBuffer + 6); // *NOPAD* stop AStyle making * look like a multiply
-            pBody->day = (uint8_t) *(pBuffer + 7); // *NOPAD*
-            pBody->hour = (uint8_t) *(pBuffer + 8); // *NOPAD*
-            pBody->min = (uint8_t) *(pBuffer + 9); // *NOPAD*
-            pBody->sec = (uint8_t) *(pBuffer + 10); // *NOPAD*
-            pBody->valid = (uint8_t) *(pBuffer + 11); // *NOPAD*
-            pBody->tAcc = uUbxProtocolUint32Decode(pBuffer + 12);
-            pBody->nano = (int32_t) uUbxProtocolUint32Decode(pBuffer + 16);
-            pBody->fixType = (uGnssDecUbxNavPvtFixType_t) *(pBuffer + 20); // *NOPAD*
-            pBody->flags = (uint8_t) *(pBuffer + 21); // *NOPAD*
-            pBody->flags2 = (uint8_t) *(pBuffer + 22); // *NOPAD*
-            pBody->numSV = (uint8_t) *(pBuffer + 23); // *NOPAD*
-            pBody->lon = (int32_t) uUbxProtocolUint32Decode(pBuffer + 24);
-            pBody->lat = (int32_t) uUbxProtocolUint32Decode(pBuffer + 28);
-            pBody->height = (int32_t) uUbxProtocolUint32Decode(pBuffer + 32);
-            pBody->hMSL = (int32_t) uUbxProtocolUint32Decode(pBuffer + 36);
-            pBody->hAcc = uUbxProtocolUint32Decode(pBuffer + 40);
-            pBody->vAcc = uUbxProtocolUint32Decode(pBuffer + 44);
-            pBody->velN = (int32_t) uUbxProtocolUint32Decode(pBuffer + 48);
-            pBody->velE = (int32_t) uUbxProtocolUint32Decode(pBuffer + 52);
-            pBody->velD = (int32_t) uUbxProtocolUint32Decode(pBuffer + 56);
-            pBody->gSpeed = (int32_t) uUbxProtocolUint32Decode(pBuffer + 60);
-            pBody->headMot = (int32_t) uUbxProtocolUint32Decode(pBuffer + 64);
-            pBody->sAcc = uUbxProtocolUint32Decode(pBuffer + 68);
-            pBody->headAcc = uUbxProtocolUint32Decode(pBuffer + 72);
-            pBody->pDOP = uUbxProtocolUint16Decode(pBuffer + 76);
-            pBody->flags3 = uUbxProtocolUint16Decode(pBuffer + 78);
-            // 4 reserved bytes here
-            pBody->headVeh = (int32_t) uUbxProtocolUint32Decode(pBuffer + 84);
-            pBody->magDec = (int16_t) uUbxProtocolUint16Decode(pBuffer + 88);
-            pBody->magAcc = (int16_t) uUbxProtocolUint16Decode(pBuffer + 90);
-
-            // Populate the pointer that was passed in
-            *ppBody = (uGnssDecUnion_t *) pBody;
-        }
+    uint64_t value = 0;
+    size_t length = type & U_GNSS_DEC_UBX_TYPE_LENGTH_MASK;
+
+    for (size_t x = length; x > 0; x--) {
+        value = (value << 8) | pData[x - 1];
+    }
+    if (((type & U_GNSS_DEC_UBX_TYPE_FLAG_SIGNED) != 0) && (length < sizeof(value)) &&
+        ((value & (1ULL << ((length * 8) - 1))) != 0)) {
+        value |= ~0ULL << (length * 8);
     }
 
-    return errorCode;
+    return value;
+}
+
+// Store a value in a structure member of the given size.
+static void ubxValueStore(char *pMember, size_t size, uint64_t value)
+{
+    uint8_t value8;
+    uint16_t value16;
+    uint32_t value32;
+
+    // memcpy() since the member is not necessarily aligned,
+    // and may be an enum or a float
+    switch (size) {
+        case sizeof(value8):
+            value8 = (uint8_t) value;
+            memcpy(pMember, &value8, sizeof(value8));
+            break;
+        case sizeof(value16):
+            value16 = (uint16_t) value;
+            memcpy(pMember, &value16, sizeof(value16));
+            break;
+        case sizeof(value32):
+            value32 = (uint32_t) value;
+            memcpy(pMember, &value32, sizeof(value32));
+            break;
+        case sizeof(value):
+            memcpy(pMember, &value, sizeof(value));
+            break;
+        default:
+            break;
+    }
+}
+
+// Decode a list of fields from pData, of length bytes, into the
+// structure at pStruct; fields that lie beyond length are left alone.
+static void ubxFieldListDecode(const uGnssDecUbxField_t *pFieldList,
+                               size_t numFields, const uint8_t *pData,
+                               size_t length, char *pStruct)
+{
+    const uGnssDecUbxField_t *pField;
+
+    for (size_t x = 0; x < numFields; x++) {
+        pField = &(pFieldList[x]);
+        if (pField->payloadOffset + (size_t) (pField->type & U_GNSS_DEC_UBX_TYPE_LENGTH_MASK) <= length) {
+            ubxValueStore(pStruct + pField->structOffset, pField->size,
+                          ubxValueDecode(pData + pField->payloadOffset, pField->type));
+        }
+    }
 }
 
-// Decode a UBX-NAV-HPPOSLLH message.
-static int32_t ubxNavHpposllhAlloc(const char *pBuffer, size_t size,
-                                   uGnssDecUnion_t **ppBody)
+// Decode the payload of a UBX message, of payloadLength bytes, into
+// pBody, which must be at least pMessage->bodySize bytes big.
+static int32_t ubxDecode(const uGnssDecUbxMessage_t *pMessage,
+                         const uint8_t *pPayload, size_t payloadLength,
+                         void *pBody)
 {
-    int32_t errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
-    uGnssDecUbxNavHpposllh_t *pBody;
-
-    // No need to check pBuffer or ppBody for NULLity,
-    // we will never give this function NULL for those.
-    if (size >= U_UBX_PROTOCOL_HEADER_LENGTH_BYTES + U_GNSS_DEC_UBX_NAV_HPPOSLLH_BODY_MIN_LENGTH) {
-        // Move past the header so that we can use payload offsets
-        // throughout, matching the offsets in the interface manual
-        pBuffer += U_UBX_PROTOCOL_HEADER_LENGTH_BYTES;
-        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-        pBody = (uGnssDecUbxNavHpposllh_t *) pUPortMalloc(sizeof(uGnssDecUbxNavHpposllh_t));
-        if (pBody != NULL) {
-            memset(pBody, 0, sizeof(*pBody));
-            // All good now, unless we hit a field we can't decode,
-            // in which case we _could_ set U_ERROR_COMMON_BAD_DATA,
-            // but, since this message will have been checked for
-            // integrity before it gets here, it is better to trust
-            // that the module emitted stuff correctly: it knows
-            // more about this than we do
-            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-            pBody->version = (uint8_t) *(pBuffer + 0); // *NOPAD* stop AStyle making * look like a multiply
-            // 2 reserved bytes here
-            pBody->flags = (uint8_t) *(pBuffer + 3); // *NOPAD*
-            pBody->iTOW = (int32_t) uUbxProtocolUint32Decode(pBuffer + 4);
-            pBody->lon = (int32_t) uUbxProtocolUint32Decode(pBuffer + 8);
-            pBody->lat = (int32_t) uUbxProtocolUint32Decode(pBuffer + 12);
-            pBody->height = (int32_t) uUbxProtocolUint32Decode(pBuffer + 16);
-            pBody->hMSL = (int32_t) uUbxProtocolUint32Decode(pBuffer + 20);
-            pBody->lonHp = (int8_t) *(pBuffer + 24); // *NOPAD*
-            pBody->latHp = (int8_t) *(pBuffer + 25); // *NOPAD*
-            pBody->heightHp = (int8_t) *(pBuffer + 26); // *NOPAD*
-            pBody->hMSLHp = (int8_t) *(pBuffer + 27); // *NOPAD*
-            pBody->hAcc = uUbxProtocolUint32Decode(pBuffer + 28);
-            pBody->vAcc = uUbxProtocolUint32Decode(pBuffer + 32);
-
-            // Populate the pointer that was passed in
-            *ppBody = (uGnssDecUnion_t *) pBody;
+    // All good, unless we find that a repeated block is
+    // truncated; since this message will have been checked
+    // for integrity before it gets here, it is better to trust
+    // that the module emitted stuff correctly: it knows more
+    // about this than we do
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    const uGnssDecUbxBlock_t *pBlock = pMessage->pBlock;
+    char *pStruct = (char *) pBody;
+    size_t count = 0;
+    size_t available = 0;
+    size_t numDecoded;
+
+    memset(pBody, 0, pMessage->bodySize);
+    ubxFieldListDecode(pMessage->pFieldList, pMessage->numFields,
+                       pPayload, payloadLength, pStruct);
+    if (pBlock != NULL) {
+        if (pBlock->countOffset + (size_t) (pBlock->countType & U_GNSS_DEC_UBX_TYPE_LENGTH_MASK) <=
+            payloadLength) {
+            count = (size_t) ((ubxValueDecode(pPayload + pBlock->countOffset,
+                                              pBlock->countType) >> pBlock->countShift) & pBlock->countMask);
+        }
+        if (payloadLength > pBlock->payloadOffset) {
+            available = (payloadLength - pBlock->payloadOffset) / pBlock->length;
+        }
+        if (count > available) {
+            errorCode = (int32_t) U_ERROR_COMMON_BAD_DATA;
+            count = available;
+        }
+        numDecoded = count;
+        if (numDecoded > pBlock->maxNum) {
+            numDecoded = pBlock->maxNum;
+        }
+        for (size_t x = 0; x < numDecoded; x++) {
+            ubxFieldListDecode(pBlock->pFieldList, pBlock->numFields,
+                               pPayload + pBlock->payloadOffset + (x * pBlock->length),
+                               pBlock->length,
+                               pStruct + pBlock->arrayOffset + (x * pBlock->elementSize));
+        }
+        memcpy(pStruct + pBlock->numDecodedOffset, &numDecoded, sizeof(numDecoded));
+        // Anything after the repeated blocks
+        available = pBlock->payloadOffset + (count * pBlock->length);
+        if (payloadLength > available) {
+            ubxFieldListDecode(pBlock->pTailFieldList, pBlock->numTailFields,
+                               pPayload + available, payloadLength - available,
+                               pStruct);
         }
     }
 
     return errorCode;
 }
 
-/* ----------------------------------------------------------------
- * STATIC VARIABLES: MESSAGE DECODER LIST
- * -------------------------------------------------------------- */
+// Find the decode tables for a UBX message ID, NULL if there are none.
+static const uGnssDecUbxMessage_t *pUbxMessageFind(uint16_t id)
+{
+    const uGnssDecUbxMessage_t *pMessage = NULL;
 
-/** A list of message decode functions; order is important,
- * MUST be in the same order as gIdList and both lists
- * must contain the same number of elements.
- */
-static uGnssDecKnownFunction_t *gpFunctionList[] = {
-    ubxNavPvtAlloc,
-    ubxNavHpposllhAlloc
-};
+    for (size_t x = 0; (pMessage == NULL) &&
+         (x < sizeof(gUbxMessageList) / sizeof(gUbxMessageList[0])); x++) {
+        if (gUbxMessageList[x].id == id) {
+            pMessage = &(gUbxMessageList[x]);
+        }
+    }
+
+    return pMessage;
+}
 
 /* ----------------------------------------------------------------
- * PUBLIC FUNCTIONS
+ * STATIC FUNCTIONS: MISC
  * -------------------------------------------------------------- */
 
-// Decode a message buffer received from a GNSS device.
-uGnssDec_t *pUGnssDecAlloc(const char *pBuffer, size_t size)
+// Decode a message buffer received from a GNSS device, allocating
+// memory from pArena (or the heap if pArena is NULL); the user
+// callback is only called if useCallback is true.
+static uGnssDec_t *pDecode(const char *pBuffer, size_t size,
+                           uArena_t *pArena, bool useCallback)
 {
     uGnssDec_t *pDec = NULL;
     uint8_t *pBufferUint8 = (uint8_t *) pBuffer; // To avoid problems with signed char compares
-    uGnssDecKnownFunction_t *pFunction = NULL;
+    const uGnssDecUbxMessage_t *pMessage = NULL;
+    void *pBody;
     size_t x;
-    size_t y;
+    size_t y = 0;
 
-    pDec = (uGnssDec_t *) pUPortMalloc(sizeof(uGnssDec_t));
+    pDec = (uGnssDec_t *) pUArenaAlloc(pArena, sizeof(uGnssDec_t));
     if (pDec != NULL) {
         memset(pDec, 0, sizeof(*pDec));
         pDec->errorCode = (int32_t) U_ERROR_COMMON_EMPTY;
@@ -376,18 +754,26 @@ uGnssDec_t *pUGnssDecAlloc(const char *pBuffer, size_t size)
                 // Got a known protocol, an ID and a valid length, see if we have
                 // a decoder for this message ID
                 pDec->errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
-                for (x = 0; (pFunction == NULL) && (x < sizeof(gIdList) / sizeof(gIdList[0])); x++) {
-                    if (uGnssMsgIdIsWanted(&(pDec->id), (uGnssMessageId_t *) & (gIdList[x]))) {
-                        pFunction = gpFunctionList[x];
-                    }
+                if (pDec->id.type == U_GNSS_PROTOCOL_UBX) {
+                    pMessage = pUbxMessageFind(pDec->id.id.ubx);
                 }
-                if (pFunction != NULL) {
+                if (pMessage != NULL) {
                     // Found a matching decoder, run it
-                    pDec->errorCode = pFunction(pBuffer, size, &(pDec->pBody));
+                    pDec->errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
+                    if (y >= pMessage->bodyMinLength) {
+                        pDec->errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                        pBody = pUArenaAlloc(pArena, pMessage->bodySize);
+                        if (pBody != NULL) {
+                            pDec->errorCode = ubxDecode(pMessage,
+                                                        ((const uint8_t *) pBuffer) + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES,
+                                                        y, pBody);
+                            pDec->pBody = (uGnssDecUnion_t *) pBody;
+                        }
+                    }
                 }
             }
             if ((pDec->errorCode != (int32_t) U_ERROR_COMMON_SUCCESS) &&
-                (gpCallback != NULL)) {
+                (pDec->pBody == NULL) && useCallback && (gpCallback != NULL)) {
                 // Couldn't decode the message: let the user callback try
                 pDec->errorCode = gpCallback(&(pDec->id), pBuffer, size, &(pDec->pBody), gpCallbackParam);
             }
@@ -397,6 +783,71 @@ uGnssDec_t *pUGnssDecAlloc(const char *pBuffer, size_t size)
     return pDec;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Decode a message buffer received from a GNSS device.
+uGnssDec_t *pUGnssDecAlloc(const char *pBuffer, size_t size)
+{
+    return pDecode(pBuffer, size, NULL, true);
+}
+
+// Decode a message buffer received from a GNSS device into an arena.
+uGnssDec_t *pUGnssDecArenaAlloc(const char *pBuffer, size_t size,
+                                uArena_t *pArena)
+{
+    uGnssDec_t *pDec = NULL;
+
+    if (pArena != NULL) {
+        pDec = pDecode(pBuffer, size, pArena, false);
+    }
+
+    return pDec;
+}
+
+// Decode a UBX message into a structure provided by the caller.
+int32_t uGnssDecUbx(const char *pBuffer, size_t size,
+                    void *pBody, size_t bodySize)
+{
+    int32_t errorCodeOrId = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uint8_t *pBufferUint8 = (const uint8_t *) pBuffer;
+    const uGnssDecUbxMessage_t *pMessage;
+    uint16_t id;
+    size_t payloadLength;
+
+    if ((pBufferUint8 != NULL) && (pBody != NULL)) {
+        errorCodeOrId = (int32_t) U_ERROR_COMMON_UNKNOWN;
+        if ((size >= 2) && (*pBufferUint8 == 0xB5) && (*(pBufferUint8 + 1) == 0x62)) {
+            errorCodeOrId = (int32_t) U_ERROR_COMMON_TRUNCATED;
+            if (size >= U_UBX_PROTOCOL_HEADER_LENGTH_BYTES) {
+                id = U_GNSS_UBX_MESSAGE(*(pBufferUint8 + 2), *(pBufferUint8 + 3));
+                payloadLength = *(pBufferUint8 + 4) + ((size_t) *(pBufferUint8 + 5) << 8); // *NOPAD*
+                if (size >= payloadLength + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES) {
+                    errorCodeOrId = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+                    pMessage = pUbxMessageFind(id);
+                    if (pMessage != NULL) {
+                        errorCodeOrId = (int32_t) U_ERROR_COMMON_TRUNCATED;
+                        if (payloadLength >= pMessage->bodyMinLength) {
+                            errorCodeOrId = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                            if (bodySize >= pMessage->bodySize) {
+                                errorCodeOrId = ubxDecode(pMessage,
+                                                          pBufferUint8 + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES,
+                                                          payloadLength, pBody);
+                                if (errorCodeOrId == 0) {
+                                    errorCodeOrId = id;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return errorCodeOrId;
+}
+
 // Free the memory returned by pUGnssDecAlloc().
 void uGnssDecFree(uGnssDec_t *pDec)
 {
@@ -82,6 +82,7 @@
 #include "u_ubx_protocol.h"
 
 #include "u_hex_bin_convert.h"
+#include "u_trace.h"
 
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
@@ -117,6 +118,15 @@
 # define U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS 50
 #endif
 
+#ifndef U_GNSS_MSG_TASK_DATA_EVENT_TIMEOUT_MS
+/** Where the transport wakes the asynchronous message receive task
+ * when data arrives (see #U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT), the
+ * longest the task waits before checking the transport anyway, just
+ * in case.
+ */
+# define U_GNSS_MSG_TASK_DATA_EVENT_TIMEOUT_MS 1000
+#endif
+
 #if U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS < U_CFG_OS_YIELD_MS
 /* U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS must be at least as big as U_CFG_OS_YIELD_MS
  * or the asynchronous message receive task will be all-consuming.
@@ -143,12 +153,17 @@ static void msgReceiveTask(void *pParam)
     char queueItem[U_GNSS_MSG_RECEIVE_TASK_QUEUE_ITEM_SIZE_BYTES];
     uGnssPrivateMsgReceive_t *pMsgReceive = pInstance->pMsgReceive;
     uGnssPrivateMsgReader_t *pReader;
+    uint32_t readers;
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_UNKNOWN;
     int32_t receiveSize;
     int32_t yieldTimeMs;
     size_t discardSize = 0;
+    int32_t numRecords;
+    size_t offset;
+    size_t offsetEnd;
+    uRingBufferParseRecord_t *pRecord;
     uGnssMessageId_t messageId;
-    uGnssPrivateMessageId_t privateMessageId;
+    uGnssPrivateMessageId_t *pPrivateMessageId;
     char nmeaId[U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS + 1];
 
     U_PORT_MUTEX_LOCK(pMsgReceive->taskRunningMutexHandle);
@@ -177,37 +192,65 @@ static void msgReceiveTask(void *pParam)
             // Run around a loop processing the data from the ring buffer
             // for as long as we're still finding messages in it
             while (errorCodeOrLength > 0) {
-                privateMessageId.type = U_GNSS_PROTOCOL_ALL;
-                // Attempt to decode a message of any type from the ring buffer
-                errorCodeOrLength = uGnssPrivateStreamDecodeRingBuffer(&(pInstance->ringBuffer),
-                                                                       pMsgReceive->ringBufferReadHandle,
-                                                                       &privateMessageId);
-                if ((errorCodeOrLength > 0) || (errorCodeOrLength == (int32_t) U_GNSS_ERROR_NACK)) {
+                // Find all of the complete messages currently in the
+                // ring buffer in one pass
+                numRecords = uGnssPrivateStreamDecodeRingBufferBatch(&(pInstance->ringBuffer),
+                                                                     pMsgReceive->ringBufferReadHandle,
+                                                                     pMsgReceive->parseRecord,
+                                                                     pMsgReceive->parseMessageId,
+                                                                     sizeof(pMsgReceive->parseRecord) /
+                                                                     sizeof(pMsgReceive->parseRecord[0]),
+                                                                     &offsetEnd);
+                offset = 0;
+                for (int32_t x = 0; x < numRecords; x++) {
+                    pRecord = &(pMsgReceive->parseRecord[x]);
+                    pPrivateMessageId = &(pMsgReceive->parseMessageId[x]);
+                    // Discard any junk before the message
+                    uRingBufferReadHandle(&(pInstance->ringBuffer),
+                                          pMsgReceive->ringBufferReadHandle, NULL,
+                                          pRecord->offset - offset);
                     // Remember how long the message is
-                    pMsgReceive->msgBytesLeftToRead = 0;
-                    if (errorCodeOrLength > 0) {
-                        pMsgReceive->msgBytesLeftToRead = errorCodeOrLength;
-                    }
+                    pMsgReceive->msgBytesLeftToRead = pRecord->length;
 
-                    if (uGnssPrivateMessageIdToPublic(&privateMessageId, &messageId, nmeaId) == 0) {
+                    if (uGnssPrivateMessageIdToPublic(pPrivateMessageId, &messageId, nmeaId) == 0) {
                         // Got something, with a message ID now in public form;
-                        // go through the list of readers looking for those interested
+                        // find the readers that are interested
 
                         U_PORT_MUTEX_LOCK(pMsgReceive->readerMutexHandle);
 
-                        pReader = pMsgReceive->pReaderList;
+                        U_TRACE_BEGIN(U_TRACE_EVENT_GNSS_MSG_DISPATCH,
+                                      messageId.type == U_GNSS_PROTOCOL_UBX ? messageId.id.ubx :
+                                      (int32_t) messageId.type << 16);
+                        // One lookup in the compiled filters gives them,
+                        // as a bit-map in list order
+                        readers = uGnssPrivateMsgFilterReaders(&(pMsgReceive->filter),
+                                                               pPrivateMessageId);
+                        for (size_t y = 0; readers != 0; y++) {
+                            if (readers & 1) {
+                                pReader = pMsgReceive->filter.pReader[y];
+                                ((uGnssMsgReceiveCallback_t) pReader->pCallback)(pInstance->gnssHandle,
+                                                                                 &messageId,
+                                                                                 (int32_t) pRecord->length,
+                                                                                 pReader->pCallbackParam);
+                            }
+                            readers >>= 1;
+                        }
+                        // Any readers that didn't fit in the compiled
+                        // filters are checked one by one
+                        pReader = pMsgReceive->filter.pOverflow;
                         while (pReader != NULL) {
-                            if (uGnssPrivateMessageIdIsWanted(&privateMessageId,
+                            if (uGnssPrivateMessageIdIsWanted(pPrivateMessageId,
                                                               &(pReader->privateMessageId))) {
                                 // This reader is interested, call the callback
                                 ((uGnssMsgReceiveCallback_t) pReader->pCallback)(pInstance->gnssHandle,
                                                                                  &messageId,
-                                                                                 errorCodeOrLength,
+                                                                                 (int32_t) pRecord->length,
                                                                                  pReader->pCallbackParam);
                             }
                             // Next!
                             pReader = pReader->pNext;
                         }
+                        U_TRACE_END(U_TRACE_EVENT_GNSS_MSG_DISPATCH, (int32_t) pRecord->length);
 
                         U_PORT_MUTEX_UNLOCK(pMsgReceive->readerMutexHandle);
                     }
@@ -216,18 +259,43 @@ static void msgReceiveTask(void *pParam)
                     uRingBufferReadHandle(&(pInstance->ringBuffer),
                                           pMsgReceive->ringBufferReadHandle, NULL,
                                           pMsgReceive->msgBytesLeftToRead);
+                    offset = pRecord->offset + pRecord->length;
+                }
+                // Discard any junk after the last message
+                uRingBufferReadHandle(&(pInstance->ringBuffer),
+                                      pMsgReceive->ringBufferReadHandle, NULL,
+                                      offsetEnd - offset);
+                // Go around again only if the batch was full; if not,
+                // what's left is the start of an incomplete message
+                // or nothing at all
+                errorCodeOrLength = 0;
+                if (uRingBufferDataSizeHandle(&(pInstance->ringBuffer),
+                                              pMsgReceive->ringBufferReadHandle) > 0) {
+                    errorCodeOrLength = (int32_t) U_ERROR_COMMON_TIMEOUT;
+                    if (numRecords == (int32_t) (sizeof(pMsgReceive->parseRecord) /
+                                                 sizeof(pMsgReceive->parseRecord[0]))) {
+                        errorCodeOrLength = numRecords;
+                    }
                 }
             }
         }
 
-        // Relax to let others in; relax for twice as long if we last
-        // received nothing and aren't desperately seeking more data,
-        // in order to allow some data to build up
-        yieldTimeMs = U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS;
-        if ((receiveSize == 0) && (errorCodeOrLength != (int32_t) U_ERROR_COMMON_TIMEOUT))  {
-            yieldTimeMs *= 2;
+        if (pMsgReceive->dataEvent) {
+            // Wait for the transport to tell us that data has arrived
+            yieldTimeMs = U_GNSS_MSG_TASK_DATA_EVENT_TIMEOUT_MS;
+        } else {
+            // Relax to let others in; relax for twice as long if we last
+            // received nothing and aren't desperately seeking more data,
+            // in order to allow some data to build up
+            yieldTimeMs = U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS;
+            if ((receiveSize == 0) && (errorCodeOrLength != (int32_t) U_ERROR_COMMON_TIMEOUT))  {
+                yieldTimeMs *= 2;
+            }
         }
-        uPortTaskBlock(yieldTimeMs);
+        // Either way, waiting on the semaphore means that we are
+        // woken early if the application brings data into the ring
+        // buffer or we are asked to exit
+        uPortSemaphoreTryTake(pMsgReceive->dataSemaphoreHandle, yieldTimeMs);
     }
 
     // Now we can unlock our ring buffer read handle.  Phew.
@@ -309,35 +377,37 @@ int32_t uGnssMsgPrivateReceiveStart(uGnssPrivateInstance_t *pInstance,
                     // Take a "master" read handle
                     pMsgReceive->ringBufferReadHandle = uRingBufferTakeReadHandle(&(pInstance->ringBuffer));
                     if (pMsgReceive->ringBufferReadHandle >= 0) {
-                        // Allocate a temporary buffer that we can use to pull data
-                        // from the streaming source into the ring-buffer from our
-                        // asynchronous task
-                        pMsgReceive->pTemporaryBuffer = (char *) pUPortMalloc(U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
-                        if (pMsgReceive->pTemporaryBuffer != NULL) {
-                            // Create the mutex that controls access to the linked-list of readers
-                            errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->readerMutexHandle));
+                        // Create the mutex that controls access to the linked-list of readers
+                        errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->readerMutexHandle));
+                        if (errorCodeOrHandle == 0) {
+                            // Create the queue that allows us to get the task to exit
+                            errorCodeOrHandle = uPortQueueCreate(U_GNSS_MSG_RECEIVE_TASK_QUEUE_LENGTH,
+                                                                 U_GNSS_MSG_RECEIVE_TASK_QUEUE_ITEM_SIZE_BYTES,
+                                                                 &(pMsgReceive->taskExitQueueHandle));
+                            if (errorCodeOrHandle == 0) {
+                                // Create the semaphore that tells the task there is data
+                                errorCodeOrHandle = uPortSemaphoreCreate(&(pMsgReceive->dataSemaphoreHandle),
+                                                                         0, 1);
+                            }
                             if (errorCodeOrHandle == 0) {
-                                // Create the queue that allows us to get the task to exit
-                                errorCodeOrHandle = uPortQueueCreate(U_GNSS_MSG_RECEIVE_TASK_QUEUE_LENGTH,
-                                                                     U_GNSS_MSG_RECEIVE_TASK_QUEUE_ITEM_SIZE_BYTES,
-                                                                     &(pMsgReceive->taskExitQueueHandle));
+                                // Have the transport give it when data arrives, if
+                                // it can; if it can't the task will check regularly
+                                pMsgReceive->dataEvent = (uGnssPrivateStreamDataEventSet(pInstance) == 0);
+                                // Create the mutex for task running status
+                                errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->taskRunningMutexHandle));
                                 if (errorCodeOrHandle == 0) {
-                                    // Create the mutex for task running status
-                                    errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->taskRunningMutexHandle));
+                                    //... and then the task
+                                    errorCodeOrHandle = uPortTaskCreate(msgReceiveTask,
+                                                                        pTaskName,
+                                                                        U_GNSS_MSG_RECEIVE_TASK_STACK_SIZE_BYTES,
+                                                                        pInstance, U_GNSS_MSG_RECEIVE_TASK_PRIORITY,
+                                                                        &(pMsgReceive->taskHandle));
                                     if (errorCodeOrHandle == 0) {
-                                        //... and then the task
-                                        errorCodeOrHandle = uPortTaskCreate(msgReceiveTask,
-                                                                            pTaskName,
-                                                                            U_GNSS_MSG_RECEIVE_TASK_STACK_SIZE_BYTES,
-                                                                            pInstance, U_GNSS_MSG_RECEIVE_TASK_PRIORITY,
-                                                                            &(pMsgReceive->taskHandle));
-                                        if (errorCodeOrHandle == 0) {
-                                            // Wait for the task to lock the mutex,
-                                            // which shows it is running
-                                            while (uPortMutexTryLock(pMsgReceive->taskRunningMutexHandle, 0) == 0) {
-                                                uPortMutexUnlock(pMsgReceive->taskRunningMutexHandle);
-                                                uPortTaskBlock(U_CFG_OS_YIELD_MS);
-                                            }
+                                        // Wait for the task to lock the mutex,
+                                        // which shows it is running
+                                        while (uPortMutexTryLock(pMsgReceive->taskRunningMutexHandle, 0) == 0) {
+                                            uPortMutexUnlock(pMsgReceive->taskRunningMutexHandle);
+                                            uPortTaskBlock(U_CFG_OS_YIELD_MS);
                                         }
                                     }
                                 }
@@ -348,14 +418,18 @@ int32_t uGnssMsgPrivateReceiveStart(uGnssPrivateInstance_t *pInstance,
                             if (pMsgReceive->taskRunningMutexHandle != NULL) {
                                 uPortMutexDelete(pMsgReceive->taskRunningMutexHandle);
                             }
+                            if (pMsgReceive->dataEvent) {
+                                uGnssPrivateStreamDataEventRemove(pInstance);
+                            }
+                            if (pMsgReceive->dataSemaphoreHandle != NULL) {
+                                uPortSemaphoreDelete(pMsgReceive->dataSemaphoreHandle);
+                            }
                             if (pMsgReceive->taskExitQueueHandle != NULL) {
                                 uPortQueueDelete(pMsgReceive->taskExitQueueHandle);
                             }
                             if (pMsgReceive->readerMutexHandle != NULL) {
                                 uPortMutexDelete(pMsgReceive->readerMutexHandle);
                             }
-                            uPortFree(pInstance->pTemporaryBuffer);
-                            pInstance->pTemporaryBuffer = NULL;
                             uRingBufferGiveReadHandle(&(pInstance->ringBuffer),
                                                       pMsgReceive->ringBufferReadHandle);
                             uPortFree(pInstance->pMsgReceive);
@@ -388,6 +462,8 @@ int32_t uGnssMsgPrivateReceiveStart(uGnssPrivateInstance_t *pInstance,
             U_PORT_MUTEX_LOCK(pInstance->pMsgReceive->readerMutexHandle);
 
             pInstance->pMsgReceive->pReaderList = pReader;
+            uGnssPrivateMsgFilterCompile(&(pInstance->pMsgReceive->filter),
+                                         pInstance->pMsgReceive->pReaderList);
 
             U_PORT_MUTEX_UNLOCK(pInstance->pMsgReceive->readerMutexHandle);
 
@@ -433,6 +509,8 @@ int32_t uGnssMsgPrivateReceiveStop(uGnssPrivateInstance_t *pInstance,
                     pCurrent = pPrev->pNext;
                 }
             }
+            uGnssPrivateMsgFilterCompile(&(pMsgReceive->filter),
+                                         pMsgReceive->pReaderList);
 
             U_PORT_MUTEX_UNLOCK(pMsgReceive->readerMutexHandle);
 
@@ -45,6 +45,7 @@
 #include "u_port_os.h"
 #include "u_port_heap.h"
 #include "u_port_uart.h"
+#include "u_port_event_queue.h" // U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES
 #include "u_port_i2c.h"
 #include "u_port_spi.h"
 #include "u_port_debug.h"
@@ -52,6 +53,7 @@
 #include "u_timeout.h"
 
 #include "u_hex_bin_convert.h"
+#include "u_trace.h"
 
 #include "u_at_client.h"
 
@@ -76,6 +78,7 @@
 #include "u_gnss_cfg.h"
 #include "u_gnss_cfg_val_key.h"
 #include "u_gnss_cfg_private.h"
+#include "u_gnss_replay.h"
 
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
@@ -152,7 +155,7 @@ typedef struct {
     int32_t id;
     char **ppBody;   /**< a pointer to a pointer that the received
                           message body will be written to. If *ppBody is NULL
-                          memory will be allocated.  If ppBody is NULL
+                          memory will be allocated (see pArena).  If ppBody is NULL
                           then the response is not captured (but this
                           structure may still be used for cls/id matching). */
     size_t bodySize; /**< the number of bytes of storage at *ppBody;
@@ -160,6 +163,8 @@ typedef struct {
                           *ppBody is NULL.  If non-zero it MUST be
                           large enough to fit the body in or the
                           CRC calculation will fail. */
+    uArena_t *pArena; /**< if *ppBody is NULL, the arena to allocate
+                           the message body from; NULL for the heap. */
 } uGnssPrivateUbxReceiveMessage_t;
 
 /* ----------------------------------------------------------------
@@ -305,6 +310,76 @@ static bool rtcmIdMatch(uint16_t rtcmIdActual, uint16_t rtcmIdWanted)
     return (rtcmIdActual == rtcmIdWanted) || (rtcmIdWanted == U_GNSS_RTCM_MESSAGE_ID_ALL);
 }
 
+// Pack the first length characters of an NMEA talker/sentence ID
+// into a message filter key; length must be no more than the
+// length of the string and no more than
+// U_GNSS_PRIVATE_MSG_FILTER_NMEA_KEY_MAX_LENGTH.
+static uint64_t msgFilterNmeaKey(const char *pNmeaId, size_t length)
+{
+    uint64_t key = 0;
+
+    for (size_t x = 0; x < U_GNSS_PRIVATE_MSG_FILTER_NMEA_KEY_MAX_LENGTH; x++) {
+        key <<= 8;
+        if (x < length) {
+            key |= (uint8_t) pNmeaId[x];
+        }
+    }
+
+    return key;
+}
+
+// Return the index of the first entry to probe in the message
+// filter hash table for the given key.
+static size_t msgFilterHash(uGnssProtocol_t type, uint64_t key)
+{
+    // Fibonacci hashing: multiply by 2^64 / golden ratio and take
+    // the top bits
+    key = (key ^ ((uint64_t) type << 60)) * 0x9E3779B97F4A7C15ULL;
+
+    return (size_t) (key >> 32) & (U_GNSS_PRIVATE_MSG_FILTER_TABLE_SIZE - 1);
+}
+
+// Return the readers of an entry in the message filter hash table,
+// zero if there is no entry for the key.  The table always has at
+// least one empty entry, which ends the probe sequence.
+static uint32_t msgFilterFind(const uGnssPrivateMsgFilter_t *pFilter,
+                              uGnssProtocol_t type, uint64_t key)
+{
+    uint32_t readers = 0;
+    size_t x = msgFilterHash(type, key);
+    const uGnssPrivateMsgFilterEntry_t *pEntry = &(pFilter->table[x]);
+
+    while ((pEntry->readers != 0) && (readers == 0)) {
+        if ((pEntry->key == key) && (pEntry->type == type)) {
+            readers = pEntry->readers;
+        } else {
+            x = (x + 1) & (U_GNSS_PRIVATE_MSG_FILTER_TABLE_SIZE - 1);
+            pEntry = &(pFilter->table[x]);
+        }
+    }
+
+    return readers;
+}
+
+// Add a reader to the entry for a key in the message filter hash
+// table, creating the entry if there isn't one.
+static void msgFilterAdd(uGnssPrivateMsgFilter_t *pFilter,
+                         uGnssProtocol_t type, uint64_t key,
+                         uint32_t reader)
+{
+    size_t x = msgFilterHash(type, key);
+    uGnssPrivateMsgFilterEntry_t *pEntry = &(pFilter->table[x]);
+
+    while ((pEntry->readers != 0) &&
+           ((pEntry->key != key) || (pEntry->type != type))) {
+        x = (x + 1) & (U_GNSS_PRIVATE_MSG_FILTER_TABLE_SIZE - 1);
+        pEntry = &(pFilter->table[x]);
+    }
+    pEntry->key = key;
+    pEntry->type = type;
+    pEntry->readers |= reader;
+}
+
 #ifdef U_GNSS_PRIVATE_DEBUG_PARSING
 // Print out a message ID, only used when debugging message parsing.
 static void printId(uGnssPrivateMessageId_t *pId)
@@ -327,6 +402,151 @@ static void printId(uGnssPrivateMessageId_t *pId)
  * STATIC FUNCTIONS: STREAMING TRANSPORT ONLY
  * -------------------------------------------------------------- */
 
+#if U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT
+// Wake the message receive task of the given GNSS instance, if it
+// still has one; the instance is looked up under gUGnssPrivateMutex
+// since closing the event queue of a transport does not flush it,
+// hence an event may arrive after the message receive task, and
+// its semaphore, have gone.
+static void dataEventGive(uDeviceHandle_t gnssHandle)
+{
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL) &&
+            (pInstance->pMsgReceive->dataSemaphoreHandle != NULL)) {
+            uPortSemaphoreGive(pInstance->pMsgReceive->dataSemaphoreHandle);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+}
+
+// Event callback for a UART transport: wake the message receive task.
+static void uartDataEventCallback(int32_t uartHandle, uint32_t eventBitmask,
+                                  void *pParameters)
+{
+    (void) uartHandle;
+
+    if (eventBitmask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) {
+        dataEventGive((uDeviceHandle_t) pParameters);
+    }
+}
+
+// Event callback for a virtual serial transport: wake the message
+// receive task.
+static void serialDataEventCallback(struct uDeviceSerial_t *pDeviceSerial,
+                                    uint32_t eventBitmask, void *pParameters)
+{
+    (void) pDeviceSerial;
+
+    if (eventBitmask & U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED) {
+        dataEventGive((uDeviceHandle_t) pParameters);
+    }
+}
+#endif
+
+// Read up to length bytes from a streaming transport straight into
+// the spans of the internal ring buffer, returning the number of
+// bytes read or negative error code.
+static int32_t streamReadIntoSpans(uGnssPrivateInstance_t *pInstance,
+                                   int32_t privateStreamType,
+                                   uRingBufferSpan_t *pSpans,
+                                   int32_t length)
+{
+    int32_t errorCodeOrLength = 0;
+    int32_t spanLength;
+    int32_t readSize = 0;
+    uDeviceSerial_t *pDeviceSerial;
+
+    for (size_t x = 0; (x < U_RING_BUFFER_SPAN_MAX_NUM) &&
+         (length > 0) && (readSize >= 0); x++) {
+        spanLength = (int32_t) pSpans[x].length;
+        if (spanLength > length) {
+            spanLength = length;
+        }
+        readSize = 0;
+        if (spanLength > 0) {
+            switch (privateStreamType) {
+                case U_GNSS_PRIVATE_STREAM_TYPE_UART:
+                    readSize = uPortUartRead(pInstance->transportHandle.uart,
+                                             pSpans[x].pData, spanLength);
+                    break;
+                case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
+                    // A read with no register address continues
+                    // from where the last one left off, so the
+                    // data carries on across the two spans
+                    readSize = uPortI2cControllerExchange(pInstance->transportHandle.i2c,
+                                                          pInstance->i2cAddress,
+                                                          NULL, 0,
+                                                          pSpans[x].pData,
+                                                          spanLength, false);
+                    break;
+                case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
+                    readSize = (int32_t) uRingBufferRead(pInstance->pSpiRingBuffer,
+                                                         pSpans[x].pData, spanLength);
+                    break;
+                case U_GNSS_PRIVATE_STREAM_TYPE_VIRTUAL_SERIAL:
+                    pDeviceSerial = pInstance->transportHandle.pDeviceSerial;
+                    readSize = pDeviceSerial->read(pDeviceSerial, pSpans[x].pData,
+                                                   spanLength);
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (readSize >= 0) {
+            errorCodeOrLength += readSize;
+            length -= readSize;
+            if (readSize < spanLength) {
+                // No more to be had
+                length = 0;
+            }
+        } else if (errorCodeOrLength == 0) {
+            // Only report an error if we've read nothing, otherwise
+            // what we've read would be lost
+            errorCodeOrLength = readSize;
+        }
+    }
+
+    return errorCodeOrLength;
+}
+
+// Pass data just read into the spans of the internal ring buffer
+// to a recording, as a record of the capture; ringBufferWriteMutex
+// must be locked before this is called.
+static void streamRecord(uGnssPrivateInstance_t *pInstance,
+                         const uRingBufferSpan_t *pSpans,
+                         int32_t length)
+{
+    uGnssPrivateReplayRecord_t *pRecord = pInstance->pReplayRecord;
+    char header[U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES];
+    uint32_t value;
+    size_t size;
+
+    value = uUbxProtocolUint32Encode((uint32_t) (uPortGetTickTimeMs() - pRecord->startTimeMs));
+    memcpy(header, &value, sizeof(value));
+    value = uUbxProtocolUint32Encode((uint32_t) length);
+    memcpy(header + sizeof(value), &value, sizeof(value));
+    pRecord->pCallback(pInstance->gnssHandle, header, sizeof(header),
+                       pRecord->pCallbackParam);
+    for (size_t x = 0; (x < U_RING_BUFFER_SPAN_MAX_NUM) && (length > 0); x++) {
+        size = pSpans[x].length;
+        if (size > (size_t) length) {
+            size = (size_t) length;
+        }
+        if (size > 0) {
+            pRecord->pCallback(pInstance->gnssHandle, pSpans[x].pData, size,
+                               pRecord->pCallbackParam);
+            length -= (int32_t) size;
+        }
+    }
+}
+
 // Read or peek-at the data in the internal ring buffer.
 static int32_t streamGetFromRingBuffer(uGnssPrivateInstance_t *pInstance,
                                        int32_t readHandle,
@@ -498,7 +718,8 @@ static int32_t receiveUbxMessageStream(uGnssPrivateInstance_t *pInstance,
             errorCodeOrLength -= U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES;
             // Copy the body of the message into the response
             if (*(pResponse->ppBody) == NULL) {
-                *(pResponse->ppBody) = (char *) pUPortMalloc(errorCodeOrLength);
+                *(pResponse->ppBody) = (char *) pUArenaAlloc(pResponse->pArena,
+                                                             errorCodeOrLength);
             } else {
                 if (errorCodeOrLength > (int32_t) pResponse->bodySize) {
                     errorCodeOrLength = (int32_t) pResponse->bodySize;
@@ -566,7 +787,7 @@ static int32_t sendReceiveUbxMessageAt(const uAtClientHandle_t atHandle,
     if (x < U_GNSS_AT_BUFFER_LENGTH_BYTES + 1) {
         x = U_GNSS_AT_BUFFER_LENGTH_BYTES + 1;
     }
-    pBuffer = (char *) pUPortMalloc(x);
+    pBuffer = (char *) pUArenaAlloc(pResponse->pArena, x);
     if (pBuffer != NULL) {
         errorCodeOrLength = (int32_t) U_GNSS_ERROR_TRANSPORT;
         bytesToSend = uBinToHex(pSend, sendLengthBytes, pBuffer);
@@ -657,7 +878,7 @@ static int32_t sendReceiveUbxMessageAt(const uAtClientHandle_t atHandle,
         uAtClientDebugSet(atHandle, atDebugPrintOn);
 
         if (!bufferReuse) {
-            uPortFree(pBuffer);
+            uArenaFree(pResponse->pArena, pBuffer);
         }
     }
 
@@ -689,7 +910,8 @@ static int32_t sendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
         ((pResponse->bodySize == 0) || (pResponse->ppBody != NULL))) {
         errorCodeOrResponseLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
         // Allocate a buffer big enough to encode the outgoing message
-        pBuffer = (char *) pUPortMalloc(messageBodyLengthBytes + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES);
+        pBuffer = (char *) pUArenaAlloc(pResponse->pArena,
+                                        messageBodyLengthBytes + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES);
         if (pBuffer != NULL) {
             errorCodeOrResponseLength = (int32_t) U_GNSS_ERROR_TRANSPORT;
             bytesToSend = uUbxProtocolEncode(messageClass, messageId,
@@ -750,7 +972,7 @@ static int32_t sendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
             }
 
             // Free memory
-            uPortFree(pBuffer);
+            uArenaFree(pResponse->pArena, pBuffer);
         }
     }
 
@@ -1784,8 +2006,15 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
     if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL)) {
         pMsgReceive = pInstance->pMsgReceive;
 
-        // Sending the task anything will cause it to exit
+        // Stop the transport telling the task about data
+        if (pMsgReceive->dataEvent) {
+            uGnssPrivateStreamDataEventRemove(pInstance);
+        }
+
+        // Sending the task anything will cause it to exit; give
+        // the semaphore also in case it is waiting on that
         uPortQueueSend(pMsgReceive->taskExitQueueHandle, queueItem);
+        uPortSemaphoreGive(pMsgReceive->dataSemaphoreHandle);
         U_PORT_MUTEX_LOCK(pMsgReceive->taskRunningMutexHandle);
         U_PORT_MUTEX_UNLOCK(pMsgReceive->taskRunningMutexHandle);
         // Wait for the task to actually exit: the STM32F4 platform
@@ -1803,6 +2032,7 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
         // Free all the other OS resources
         uPortMutexDelete(pMsgReceive->taskRunningMutexHandle);
         uPortQueueDelete(pMsgReceive->taskExitQueueHandle);
+        uPortSemaphoreDelete(pMsgReceive->dataSemaphoreHandle);
         uPortMutexDelete(pMsgReceive->readerMutexHandle);
 
         // Pause here to allow the deletions
@@ -1810,9 +2040,6 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
         // required by some RTOSs (e.g. FreeRTOS)
         uPortTaskBlock(U_CFG_OS_YIELD_MS);
 
-        // Free the temporary buffer
-        uPortFree(pMsgReceive->pTemporaryBuffer);
-
         // Give the ring buffer handle back
         uRingBufferGiveReadHandle(&(pInstance->ringBuffer),
                                   pMsgReceive->ringBufferReadHandle);
@@ -1934,6 +2161,135 @@ bool uGnssPrivateMessageIdIsWanted(uGnssPrivateMessageId_t *pMessageId,
     return isWanted;
 }
 
+// Compile the message filters of a list of message readers.
+void uGnssPrivateMsgFilterCompile(uGnssPrivateMsgFilter_t *pFilter,
+                                  uGnssPrivateMsgReader_t *pReaderList)
+{
+    uGnssPrivateMessageId_t *pId;
+    uint32_t reader;
+    size_t length;
+    uint8_t ubxClass;
+
+    memset(pFilter, 0, sizeof(*pFilter));
+    while ((pReaderList != NULL) &&
+           (pFilter->numReaders < U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM)) {
+        reader = 1UL << pFilter->numReaders;
+        pFilter->pReader[pFilter->numReaders] = pReaderList;
+        pFilter->numReaders++;
+        pId = &(pReaderList->privateMessageId);
+        switch (pId->type) {
+            case U_GNSS_PROTOCOL_ANY:
+            case U_GNSS_PROTOCOL_ALL:
+                pFilter->anyReaders |= reader;
+                break;
+            case U_GNSS_PROTOCOL_UNKNOWN:
+                pFilter->unknownReaders |= reader;
+                break;
+            case U_GNSS_PROTOCOL_RTCM:
+                if (pId->id.rtcm == U_GNSS_RTCM_MESSAGE_ID_ALL) {
+                    pFilter->rtcmAllReaders |= reader;
+                } else {
+                    msgFilterAdd(pFilter, U_GNSS_PROTOCOL_RTCM, pId->id.rtcm, reader);
+                }
+                break;
+            case U_GNSS_PROTOCOL_NMEA:
+                // The private NMEA ID is guaranteed to be
+                // null-terminated; one that won't fit into a key
+                // is matched the same way as a wildcard
+                length = strlen(pId->id.nmea);
+                if ((strchr(pId->id.nmea, '?') != NULL) ||
+                    (length > U_GNSS_PRIVATE_MSG_FILTER_NMEA_KEY_MAX_LENGTH)) {
+                    pFilter->nmeaWildcardReaders |= reader;
+                } else {
+                    pFilter->nmeaLengthBitmap |= (uint16_t) (1U << length);
+                    msgFilterAdd(pFilter, U_GNSS_PROTOCOL_NMEA,
+                                 msgFilterNmeaKey(pId->id.nmea, length), reader);
+                }
+                break;
+            case U_GNSS_PROTOCOL_UBX:
+                if (pId->id.ubx == U_GNSS_UBX_MESSAGE_ALL) {
+                    pFilter->ubxAllReaders |= reader;
+                } else {
+                    ubxClass = (uint8_t) (pId->id.ubx >> 8);
+                    if (ubxClass == U_GNSS_UBX_MESSAGE_CLASS_ALL) {
+                        pFilter->ubxClassAll = true;
+                    } else {
+                        pFilter->ubxClassBitmap[ubxClass >> 5] |= 1UL << (ubxClass & 0x1f);
+                    }
+                    msgFilterAdd(pFilter, U_GNSS_PROTOCOL_UBX, pId->id.ubx, reader);
+                }
+                break;
+            default:
+                break;
+        }
+        pReaderList = pReaderList->pNext;
+    }
+    pFilter->pOverflow = pReaderList;
+}
+
+// Find the readers that want a given message.
+uint32_t uGnssPrivateMsgFilterReaders(const uGnssPrivateMsgFilter_t *pFilter,
+                                      const uGnssPrivateMessageId_t *pMessageId)
+{
+    uint32_t readers = pFilter->anyReaders;
+    uint32_t wildcardReaders;
+    uint16_t ubxId;
+    uint8_t ubxClass;
+    size_t length;
+
+    switch (pMessageId->type) {
+        case U_GNSS_PROTOCOL_UNKNOWN:
+            readers |= pFilter->unknownReaders;
+            break;
+        case U_GNSS_PROTOCOL_RTCM:
+            readers |= pFilter->rtcmAllReaders |
+                       msgFilterFind(pFilter, U_GNSS_PROTOCOL_RTCM, pMessageId->id.rtcm);
+            break;
+        case U_GNSS_PROTOCOL_NMEA:
+            // One lookup for each length of prefix that a reader has
+            // asked for, usually just the one
+            length = strlen(pMessageId->id.nmea);
+            if (length > U_GNSS_PRIVATE_MSG_FILTER_NMEA_KEY_MAX_LENGTH) {
+                length = U_GNSS_PRIVATE_MSG_FILTER_NMEA_KEY_MAX_LENGTH;
+            }
+            for (size_t x = 0; x <= length; x++) {
+                if (pFilter->nmeaLengthBitmap & (1U << x)) {
+                    readers |= msgFilterFind(pFilter, U_GNSS_PROTOCOL_NMEA,
+                                             msgFilterNmeaKey(pMessageId->id.nmea, x));
+                }
+            }
+            wildcardReaders = pFilter->nmeaWildcardReaders;
+            for (size_t x = 0; wildcardReaders != 0; x++) {
+                if ((wildcardReaders & 1) &&
+                    nmeaIdMatch(pMessageId->id.nmea, pFilter->pReader[x]->privateMessageId.id.nmea)) {
+                    readers |= 1UL << x;
+                }
+                wildcardReaders >>= 1;
+            }
+            break;
+        case U_GNSS_PROTOCOL_UBX:
+            readers |= pFilter->ubxAllReaders;
+            ubxId = pMessageId->id.ubx;
+            ubxClass = (uint8_t) (ubxId >> 8);
+            if (pFilter->ubxClassBitmap[ubxClass >> 5] & (1UL << (ubxClass & 0x1f))) {
+                // Someone wants this class: look for this ID
+                // and for all IDs of this class
+                readers |= msgFilterFind(pFilter, U_GNSS_PROTOCOL_UBX, ubxId) |
+                           msgFilterFind(pFilter, U_GNSS_PROTOCOL_UBX,
+                                         ubxId | U_GNSS_UBX_MESSAGE_ID_ALL);
+            }
+            if (pFilter->ubxClassAll) {
+                readers |= msgFilterFind(pFilter, U_GNSS_PROTOCOL_UBX,
+                                         ubxId | (U_GNSS_UBX_MESSAGE_CLASS_ALL << 8));
+            }
+            break;
+        default:
+            break;
+    }
+
+    return readers;
+}
+
 int32_t uGnssPrivateInfoGetVersions(uGnssPrivateInstance_t *pInstance,
                                     uGnssVersionType_t *pVer)
 {
@@ -2149,6 +2505,44 @@ int32_t uGnssPrivateStreamDecodeRingBuffer(uRingBuffer_t *pRingBuffer,
     return errorCodeOrLength;
 }
 
+// Find all of the complete messages in the ring buffer.
+int32_t uGnssPrivateStreamDecodeRingBufferBatch(uRingBuffer_t *pRingBuffer,
+                                                int32_t readHandle,
+                                                uRingBufferParseRecord_t *pRecords,
+                                                uGnssPrivateMessageId_t *pPrivateMessageIds,
+                                                size_t maxNumRecords,
+                                                size_t *pOffsetEnd)
+{
+    int32_t errorCodeOrNumRecords = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    U_RING_BUFFER_PARSER_f parserList[] = {
+        parseUbx,
+        parseNmea,
+        parseRtcm,
+        NULL
+    };
+
+    if ((pRingBuffer != NULL) && (pRecords != NULL) && (pPrivateMessageIds != NULL)) {
+        memset(pPrivateMessageIds, 0, sizeof(uGnssPrivateMessageId_t) * maxNumRecords);
+        for (size_t x = 0; x < maxNumRecords; x++) {
+            pPrivateMessageIds[x].type = U_GNSS_PROTOCOL_UNKNOWN;
+        }
+        errorCodeOrNumRecords = uRingBufferParseBatchHandle(pRingBuffer, readHandle,
+                                                            parserList, pPrivateMessageIds,
+                                                            sizeof(uGnssPrivateMessageId_t),
+                                                            pRecords, maxNumRecords,
+                                                            pOffsetEnd);
+#ifdef U_GNSS_PRIVATE_DEBUG_PARSING
+        for (int32_t x = 0; x < errorCodeOrNumRecords; x++) {
+            uPortLog("** ");
+            printId(&(pPrivateMessageIds[x]));
+            uPortLog(" offset %d size %d\n", pRecords[x].offset, pRecords[x].length);
+        }
+#endif
+    }
+
+    return errorCodeOrNumRecords;
+}
+
 // Fill the internal ring buffer with data from the GNSS chip.
 // IMPORTANT: this function should not do anything that has "global"
 // effect on the instance data since it may be called at any time
@@ -2162,18 +2556,10 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
     int32_t receiveSize;
     int32_t totalReceiveSize = 0;
     int32_t ringBufferAvailableSize;
-    char *pTemporaryBuffer;
+    int32_t readSize;
+    uRingBufferSpan_t spans[U_RING_BUFFER_SPAN_MAX_NUM];
 
     if (pInstance != NULL) {
-        pTemporaryBuffer = pInstance->pTemporaryBuffer;
-        if ((pInstance->pMsgReceive != NULL) &&
-            uPortTaskIsThis(pInstance->pMsgReceive->taskHandle)) {
-            // If we're being called from the message receive task,
-            // which does not lock gUGnssPrivateMutex, we use its
-            // temporary buffer in order to avoid clashes with
-            // the main application task
-            pTemporaryBuffer = pInstance->pMsgReceive->pTemporaryBuffer;
-        }
         errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
         privateStreamTypeOrError = uGnssPrivateGetStreamType(pInstance->transportType);
         if (privateStreamTypeOrError >= 0) {
@@ -2183,64 +2569,63 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
             // it always has one go even with a zero timeout
             do {
                 receiveSize = uGnssPrivateStreamGetReceiveSize(pInstance);
-                // Don't try to read in more than uRingBufferForceAdd()
-                // can put into the ring buffer
+                // Don't try to read in more than
+                // uRingBufferForceWriteSpanAcquire() can make room for
                 ringBufferAvailableSize = uRingBufferAvailableSizeMax(&(pInstance->ringBuffer));
                 if (receiveSize > ringBufferAvailableSize) {
                     receiveSize = ringBufferAvailableSize;
                 }
                 if (receiveSize > 0) {
-                    // Read into a temporary buffer
                     if (receiveSize > U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES) {
                         receiveSize = U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES;
                     }
-                    switch (privateStreamTypeOrError) {
-                        case U_GNSS_PRIVATE_STREAM_TYPE_UART:
-                            // For UART we ask for as much data as we can, it will just
-                            // bring in more if more has arrived between the "receive
-                            // size" call above and now
-                            receiveSize = uPortUartRead(pInstance->transportHandle.uart, pTemporaryBuffer,
-                                                        U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
-                            break;
-                        case U_GNSS_PRIVATE_STREAM_TYPE_I2C:
-                            // For I2C we need to ask for the amount we know is there since
-                            // the I2C buffer is effectively on the GNSS chip and I2C drivers
-                            // often don't say how much they've read, just giving us back
-                            // the number we asked for on a successful read
-                            receiveSize = uPortI2cControllerExchange(pInstance->transportHandle.i2c,
-                                                                     pInstance->i2cAddress,
-                                                                     NULL, 0,
-                                                                     pTemporaryBuffer,
-                                                                     receiveSize, false);
-                            break;
-                        case U_GNSS_PRIVATE_STREAM_TYPE_SPI:
-                            // For the SPI case, we need to pull the data that was
-                            // received in uGnssPrivateStreamGetReceiveSize() back
-                            // out of the SPI ring buffer and into our temporary buffer
-                            receiveSize = (int32_t) uRingBufferRead(pInstance->pSpiRingBuffer,
-                                                                    pTemporaryBuffer, receiveSize);
-                            break;
-                        case U_GNSS_PRIVATE_STREAM_TYPE_VIRTUAL_SERIAL: {
-                            // As for the UART case, we ask for as much data as we can
-                            uDeviceSerial_t *pDeviceSerial = pInstance->transportHandle.pDeviceSerial;
-                            receiveSize = pDeviceSerial->read(pDeviceSerial, pTemporaryBuffer,
-                                                              U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES);
+                    // The data is read straight into the free space of
+                    // the ring buffer, which can only have one writer
+                    // at a time: this may be the message receive task
+                    // or an application task
+                    U_PORT_MUTEX_LOCK(pInstance->ringBufferWriteMutex);
+                    // We use a forced acquire: it is up to this MCU to
+                    // keep up, we don't want to block data from the GNSS
+                    // chip, after all it has no UART flow control lines
+                    // that we can stop it with
+                    readSize = (int32_t) uRingBufferForceWriteSpanAcquire(&(pInstance->ringBuffer),
+                                                                          receiveSize, spans);
+                    if (readSize > 0) {
+                        if ((privateStreamTypeOrError == U_GNSS_PRIVATE_STREAM_TYPE_UART) ||
+                            (privateStreamTypeOrError == U_GNSS_PRIVATE_STREAM_TYPE_VIRTUAL_SERIAL)) {
+                            // For UART/virtual serial we ask for as much data as
+                            // we have room for, it will just bring in more if more
+                            // has arrived between the "receive size" call above
+                            // and now
+                            if (readSize > U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES) {
+                                readSize = U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES;
+                            }
+                        } else {
+                            // For I2C we need to ask for the amount we know is there
+                            // since the I2C buffer is effectively on the GNSS chip and
+                            // I2C drivers often don't say how much they've read, just
+                            // giving us back the number we asked for on a successful
+                            // read; for SPI the data was received in
+                            // uGnssPrivateStreamGetReceiveSize() and is pulled back
+                            // out of the SPI ring buffer
+                            readSize = receiveSize;
                         }
-                        break;
-                        default:
-                            break;
+                        receiveSize = streamReadIntoSpans(pInstance, privateStreamTypeOrError,
+                                                          spans, readSize);
+                        if (receiveSize > 0) {
+                            uRingBufferWriteSpanCommit(&(pInstance->ringBuffer), receiveSize);
+                            if (pInstance->pReplayRecord != NULL) {
+                                streamRecord(pInstance, spans, receiveSize);
+                            }
+                        }
+                    } else {
+                        receiveSize = (int32_t) U_ERROR_COMMON_NO_MEMORY;
                     }
+                    U_PORT_MUTEX_UNLOCK(pInstance->ringBufferWriteMutex);
                     if (receiveSize >= 0) {
                         totalReceiveSize += receiveSize;
                         errorCodeOrLength = totalReceiveSize;
-                        // Now stuff this into the ring buffer; we use a forced
-                        // add: it is up to this MCU to keep up, we don't want
-                        // to block data from the GNSS chip, after all it has
-                        // no UART flow control lines that we can stop it with
-                        if (!uRingBufferForceAdd(&(pInstance->ringBuffer),
-                                                 pTemporaryBuffer, receiveSize)) {
-                            errorCodeOrLength = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-                        }
+                        U_TRACE_INSTANT(U_TRACE_EVENT_GNSS_RING_BUFFER_FILL, receiveSize);
                     } else {
                         // Error case
                         errorCodeOrLength = receiveSize;
@@ -2267,11 +2652,79 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
 
     if (totalReceiveSize > 0) {
         errorCodeOrLength = totalReceiveSize;
+        if ((pInstance->pMsgReceive != NULL) &&
+            (pInstance->pMsgReceive->dataSemaphoreHandle != NULL) &&
+            !uPortTaskIsThis(pInstance->pMsgReceive->taskHandle)) {
+            // Someone else has brought data into the ring buffer:
+            // let the message receive task know
+            uPortSemaphoreGive(pInstance->pMsgReceive->dataSemaphoreHandle);
+        }
     }
 
     return errorCodeOrLength;
 }
 
+// Set the event callback of a streaming transport to wake the
+// message receive task.
+int32_t uGnssPrivateStreamDataEventSet(uGnssPrivateInstance_t *pInstance)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+#if U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT
+    uDeviceSerial_t *pDeviceSerial;
+
+    // Leave alone any event callback that the application has set
+    switch (uGnssPrivateGetStreamType(pInstance->transportType)) {
+        case U_GNSS_PRIVATE_STREAM_TYPE_UART:
+            errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+            if (uPortUartEventCallbackFilterGet(pInstance->transportHandle.uart) == 0) {
+                errorCode = uPortUartEventCallbackSet(pInstance->transportHandle.uart,
+                                                      U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                      uartDataEventCallback,
+                                                      (void *) pInstance->gnssHandle,
+                                                      U_GNSS_MSG_RECEIVE_DATA_EVENT_STACK_SIZE_BYTES,
+                                                      U_GNSS_MSG_RECEIVE_DATA_EVENT_PRIORITY);
+            }
+            break;
+        case U_GNSS_PRIVATE_STREAM_TYPE_VIRTUAL_SERIAL:
+            pDeviceSerial = (uDeviceSerial_t *) pInstance->transportHandle.pDeviceSerial;
+            errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+            if (pDeviceSerial->eventCallbackFilterGet(pDeviceSerial) == 0) {
+                errorCode = pDeviceSerial->eventCallbackSet(pDeviceSerial,
+                                                            U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED,
+                                                            serialDataEventCallback,
+                                                            (void *) pInstance->gnssHandle,
+                                                            U_GNSS_MSG_RECEIVE_DATA_EVENT_STACK_SIZE_BYTES,
+                                                            U_GNSS_MSG_RECEIVE_DATA_EVENT_PRIORITY);
+            }
+            break;
+        default:
+            break;
+    }
+#else
+    (void) pInstance;
+#endif
+
+    return errorCode;
+}
+
+// Remove the event callback of a streaming transport.
+void uGnssPrivateStreamDataEventRemove(uGnssPrivateInstance_t *pInstance)
+{
+    uDeviceSerial_t *pDeviceSerial;
+
+    switch (uGnssPrivateGetStreamType(pInstance->transportType)) {
+        case U_GNSS_PRIVATE_STREAM_TYPE_UART:
+            uPortUartEventCallbackRemove(pInstance->transportHandle.uart);
+            break;
+        case U_GNSS_PRIVATE_STREAM_TYPE_VIRTUAL_SERIAL:
+            pDeviceSerial = (uDeviceSerial_t *) pInstance->transportHandle.pDeviceSerial;
+            pDeviceSerial->eventCallbackRemove(pDeviceSerial);
+            break;
+        default:
+            break;
+    }
+}
+
 // Read data from the internal ring buffer into the given linear buffer.
 int32_t uGnssPrivateStreamReadRingBuffer(uGnssPrivateInstance_t *pInstance,
                                          int32_t readHandle,
@@ -2571,6 +3024,7 @@ int32_t uGnssPrivateSendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
     response.id = messageId;
     response.ppBody = NULL;
     response.bodySize = 0;
+    response.pArena = NULL;
     if (pResponseBody != NULL) {
         response.ppBody = &pResponseBody;
         response.bodySize = maxResponseBodyLengthBytes;
@@ -2588,6 +3042,22 @@ int32_t uGnssPrivateSendReceiveUbxMessageAlloc(uGnssPrivateInstance_t *pInstance
                                                const char *pMessageBody,
                                                size_t messageBodyLengthBytes,
                                                char **ppResponseBody)
+{
+    return uGnssPrivateSendReceiveUbxMessageArena(pInstance, messageClass,
+                                                  messageId, pMessageBody,
+                                                  messageBodyLengthBytes,
+                                                  ppResponseBody, NULL);
+}
+
+// Send a UBX format message and receive a response of unknown length
+// into memory from an arena.
+int32_t uGnssPrivateSendReceiveUbxMessageArena(uGnssPrivateInstance_t *pInstance,
+                                               int32_t messageClass,
+                                               int32_t messageId,
+                                               const char *pMessageBody,
+                                               size_t messageBodyLengthBytes,
+                                               char **ppResponseBody,
+                                               uArena_t *pArena)
 {
     uGnssPrivateUbxReceiveMessage_t response;
 
@@ -2597,6 +3067,7 @@ int32_t uGnssPrivateSendReceiveUbxMessageAlloc(uGnssPrivateInstance_t *pInstance
     response.id = messageId;
     response.ppBody = ppResponseBody;
     response.bodySize = 0;
+    response.pArena = pArena;
 
     return sendReceiveUbxMessage(pInstance, messageClass, messageId,
                                  pMessageBody, messageBodyLengthBytes,
@@ -24,6 +24,7 @@
 
 #include "u_device.h"
 #include "u_ringbuffer.h"
+#include "u_arena.h"
 #include "u_gnss_info.h" // For uGnssVersionType_t
 
 /** @file
@@ -81,6 +82,38 @@ extern "C" {
 # define U_GNSS_RING_BUFFER_MIN_FILL_TIME_MS 100
 #endif
 
+#ifndef U_GNSS_MSG_RECEIVE_TASK_PARSE_BATCH_MAX_NUM
+/** The maximum number of messages that the message receive task
+ * started by uGnssMsgReceiveStart() will find in a single pass
+ * of the ring buffer before dispatching them to the callbacks;
+ * each one costs sizeof(uRingBufferParseRecord_t) +
+ * sizeof(uGnssPrivateMessageId_t) bytes in the heap while the
+ * task is running.
+ */
+# define U_GNSS_MSG_RECEIVE_TASK_PARSE_BATCH_MAX_NUM 8
+#endif
+
+/** The number of readers whose message filters are compiled into
+ * the lookup table of the message receive task, the width of the
+ * reader bit-map in #uGnssPrivateMsgFilter_t; readers beyond this
+ * number are matched one by one.
+ */
+#define U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM 32
+
+/** The number of entries in the hash table of
+ * #uGnssPrivateMsgFilter_t: must be a power of two and should be at
+ * least twice #U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM so that
+ * probe sequences stay short.
+ */
+#define U_GNSS_PRIVATE_MSG_FILTER_TABLE_SIZE 64
+
+/** The longest NMEA ID that can be compiled into the lookup table
+ * of #uGnssPrivateMsgFilter_t, the number of characters that fit
+ * into its uint64_t key; readers of longer NMEA IDs are matched one
+ * by one.
+ */
+#define U_GNSS_PRIVATE_MSG_FILTER_NMEA_KEY_MAX_LENGTH 8
+
 /** Determine if the given feature is supported or not
  * by the pointed-to module.
  */
@@ -188,19 +221,69 @@ typedef struct uGnssPrivateMsgReader_t {
     struct uGnssPrivateMsgReader_t *pNext;
 } uGnssPrivateMsgReader_t;
 
+/** An entry in the hash table of #uGnssPrivateMsgFilter_t.
+ */
+typedef struct {
+    uint64_t key;           /**< for UBX the message class and ID, for
+                                 RTCM the message type, for NMEA up to
+                                 eight characters of talker/sentence
+                                 prefix packed from the most significant
+                                 byte down, zero-padded. */
+    uint32_t readers;       /**< bit-map of the readers that want a
+                                 message matching key; zero means the
+                                 entry is empty. */
+    uGnssProtocol_t type;   /**< the protocol of key. */
+} uGnssPrivateMsgFilterEntry_t;
+
+/** The message filters of all of the readers of the message receive
+ * task compiled into a lookup structure, so that the set of readers
+ * interested in a message can be found without walking the reader
+ * list; see uGnssPrivateMsgFilterCompile() and
+ * uGnssPrivateMsgFilterReaders().
+ */
+typedef struct {
+    uGnssPrivateMsgReader_t *pReader[U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM]; /**< the
+                                                                                      reader of
+                                                                                      each bit. */
+    size_t numReaders;            /**< the number of entries of pReader in use. */
+    uGnssPrivateMsgReader_t *pOverflow; /**< the first reader which did not
+                                             fit in pReader, NULL if there
+                                             is none. */
+    uint32_t anyReaders;          /**< readers of every message. */
+    uint32_t unknownReaders;      /**< readers of messages of unknown protocol. */
+    uint32_t ubxAllReaders;       /**< readers of all UBX messages. */
+    uint32_t rtcmAllReaders;      /**< readers of all RTCM messages. */
+    uint32_t nmeaWildcardReaders; /**< readers of NMEA messages that include a
+                                       '?' wildcard, or that are longer than
+                                       #U_GNSS_PRIVATE_MSG_FILTER_NMEA_KEY_MAX_LENGTH,
+                                       matched one by one. */
+    uint32_t ubxClassBitmap[256 / 32]; /**< bit set for each UBX message class
+                                            that appears in the table. */
+    bool ubxClassAll;             /**< true if the table includes a UBX entry
+                                       for all classes but a specific ID. */
+    uint16_t nmeaLengthBitmap;    /**< bit n set if the table includes an NMEA
+                                       prefix of length n. */
+    uGnssPrivateMsgFilterEntry_t table[U_GNSS_PRIVATE_MSG_FILTER_TABLE_SIZE];
+} uGnssPrivateMsgFilter_t;
+
 /** Structure to hold the data associated with the task running
  * the non-blocking message receive utility functions.
  */
 typedef struct {
     int32_t nextHandle;
     uPortTaskHandle_t taskHandle;
-    char *pTemporaryBuffer;
     uPortMutexHandle_t taskRunningMutexHandle;
     uPortQueueHandle_t taskExitQueueHandle;
+    uPortSemaphoreHandle_t dataSemaphoreHandle; /**< given when there may be data to process. */
+    bool dataEvent; /**< true if the transport gives dataSemaphoreHandle when data arrives. */
     uPortMutexHandle_t readerMutexHandle;
     int32_t ringBufferReadHandle;
     size_t msgBytesLeftToRead;
     uGnssPrivateMsgReader_t *pReaderList;
+    uGnssPrivateMsgFilter_t filter; /**< pReaderList compiled, protected by
+                                         readerMutexHandle. */
+    uRingBufferParseRecord_t parseRecord[U_GNSS_MSG_RECEIVE_TASK_PARSE_BATCH_MAX_NUM];
+    uGnssPrivateMessageId_t parseMessageId[U_GNSS_MSG_RECEIVE_TASK_PARSE_BATCH_MAX_NUM];
 } uGnssPrivateMsgReceive_t;
 
 /** Parameters to pass to the streamed position callback.
@@ -232,6 +315,15 @@ typedef struct {
     int32_t errorCode;
 } uGnssPrivateMga_t;
 
+/** The state of a recording of the data received from a GNSS chip,
+ * see uGnssReplayRecordStart().
+ */
+typedef struct {
+    void (*pCallback) (uDeviceHandle_t, const char *, size_t, void *);
+    void *pCallbackParam;
+    int32_t startTimeMs;
+} uGnssPrivateReplayRecord_t;
+
 /** Definition of a GNSS instance.
  * Note: a pointer to this structure is passed to the asynchronous
  * "get position" function (posGetTask()) which does NOT lock the
@@ -251,7 +343,7 @@ typedef struct uGnssPrivateInstance_t {
     char *pSpiLinearBuffer; /**< the linear buffer that will be used by pSpiRingBuffer. */
     uRingBuffer_t ringBuffer; /**< the ring buffer where we put messages from the GNSS chip. */
     char *pLinearBuffer; /**< the linear buffer that will be used by ringBuffer. */
-    char *pTemporaryBuffer; /**< a temporary buffer, used to get stuff into ringBuffer. */
+    uPortMutexHandle_t ringBufferWriteMutex; /**< mutex so that only one task at a time writes into ringBuffer. */
     int32_t ringBufferReadHandlePrivate; /**< the read handle for this code to use, -1 if there isn't one. */
     int32_t ringBufferReadHandleMsgReceive; /**< the read handle for uGnssUtilTransparentReceive(). */
     uint16_t i2cAddress; /**< the I2C address of the GNSS chip, only relevant if the transport is I2C. */
@@ -278,6 +370,8 @@ typedef struct uGnssPrivateInstance_t {
     uGnssRrlpMode_t rrlpMode; /**< The type of MEASX to use with RRLP capture. */
     uGnssPrivateMga_t *pMga; /**< Storage for AssistNow. */
     void *pFenceContext; /**< Storage for a uGeofenceContext_t. */
+    uGnssPrivateReplayRecord_t *pReplayRecord; /**< the recording in progress, if any, protected
+                                                    by ringBufferWriteMutex. */
     struct uGnssPrivateInstance_t *pNext;
 } uGnssPrivateInstance_t;
 // *INDENT-ON*
@@ -581,6 +675,37 @@ int32_t uGnssPrivateMessageIdToPublic(const uGnssPrivateMessageId_t *pPrivateMes
 bool uGnssPrivateMessageIdIsWanted(uGnssPrivateMessageId_t *pMessageId,
                                    uGnssPrivateMessageId_t *pMessageIdWanted);
 
+/** Compile the message filters of a list of message readers into
+ * a lookup structure; this must be called again whenever the list
+ * changes.  The first #U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM
+ * readers are each given a bit, in list order, and their filters
+ * are compiled; any further readers are left in pOverflow of the
+ * lookup structure to be matched one by one with
+ * uGnssPrivateMessageIdIsWanted().
+ *
+ * @param[out] pFilter     a place to put the lookup structure; cannot
+ *                         be NULL.
+ * @param[in] pReaderList  the list of readers, may be NULL.
+ */
+void uGnssPrivateMsgFilterCompile(uGnssPrivateMsgFilter_t *pFilter,
+                                  uGnssPrivateMsgReader_t *pReaderList);
+
+/** Find the readers that want a given message using a lookup
+ * structure compiled by uGnssPrivateMsgFilterCompile(); the result
+ * is the same as calling uGnssPrivateMessageIdIsWanted() for each
+ * of the readers given a bit, but at the cost of a few table lookups
+ * rather than one match per reader.
+ *
+ * @param[in] pFilter     the lookup structure; cannot be NULL.
+ * @param[in] pMessageId  the private message ID of the message;
+ *                        cannot be NULL.
+ * @return                a bit-map of the interested readers, bit n
+ *                        representing the reader at pReader[n] of
+ *                        pFilter.
+ */
+uint32_t uGnssPrivateMsgFilterReaders(const uGnssPrivateMsgFilter_t *pFilter,
+                                      const uGnssPrivateMessageId_t *pMessageId);
+
 /** Get the various information from the GNSS chip.
  *
  * Note: gUGnssPrivateMutex should be locked before this is called.
@@ -653,6 +778,31 @@ int32_t uGnssPrivateStreamGetReceiveSize(uGnssPrivateInstance_t *pInstance);
 int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
                                          int32_t timeoutMs, int32_t maxTimeMs);
 
+/** Set the event callback of a streaming transport, where the transport
+ * has one (UART or virtual serial), so that the data semaphore of the
+ * message receive task is given whenever data arrives.  An event
+ * callback that the application has already set is left alone.
+ *
+ * Note: gUGnssPrivateMutex should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL;
+ *                       pInstance->pMsgReceive must not be NULL and
+ *                       must have a data semaphore.
+ * @return               zero on success else negative error code,
+ *                       e.g. #U_ERROR_COMMON_NOT_SUPPORTED if the
+ *                       transport is I2C or SPI or #U_ERROR_COMMON_BUSY
+ *                       if the transport already has an event callback.
+ */
+int32_t uGnssPrivateStreamDataEventSet(uGnssPrivateInstance_t *pInstance);
+
+/** Remove an event callback set by uGnssPrivateStreamDataEventSet().
+ *
+ * Note: gUGnssPrivateMutex should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL.
+ */
+void uGnssPrivateStreamDataEventRemove(uGnssPrivateInstance_t *pInstance);
+
 /** Examine the given ring buffer, for the given read handle, and determine
  * if it contains the given message ID, or even the sniff of a possibility
  * of it.  If a message header is matched the read pointer for the given
@@ -699,6 +849,46 @@ int32_t uGnssPrivateStreamDecodeRingBuffer(uRingBuffer_t *pRingBuffer,
                                            int32_t readHandle,
                                            uGnssPrivateMessageId_t *pPrivateMessageId);
 
+/** Find all of the complete messages, of any type, currently in the
+ * ring buffer in a single pass; this is the batch equivalent of
+ * calling uGnssPrivateStreamDecodeRingBuffer() repeatedly with a
+ * message type of #U_GNSS_PROTOCOL_ALL, as the message receive task
+ * does.  Nothing is removed from the ring buffer: the caller should
+ * read out (or discard) each message in turn, and any junk before
+ * it, then discard any junk between the last message and
+ * *pOffsetEnd.
+ *
+ * Note: the same thread-safety rules as for
+ * uGnssPrivateStreamDecodeRingBuffer() apply.
+ *
+ * @param[in] pRingBuffer             a pointer to the ring buffer of the
+ *                                    GNSS instance, cannot be NULL.
+ * @param readHandle                  the read handle of the ring buffer to
+ *                                    read from.
+ * @param[out] pRecords               a pointer to maxNumRecords records
+ *                                    giving the offset and length of each
+ *                                    message found; cannot be NULL.
+ * @param[out] pPrivateMessageIds     a pointer to maxNumRecords message
+ *                                    IDs, entry n of which will be populated
+ *                                    with the message ID of record n;
+ *                                    cannot be NULL.
+ * @param maxNumRecords               the number of entries at pRecords and
+ *                                    at pPrivateMessageIds.
+ * @param[out] pOffsetEnd             a pointer to a place to put the offset
+ *                                    up to which the data has been accounted
+ *                                    for; anything after this is the start
+ *                                    of a message that is not yet complete.
+ *                                    May be NULL.
+ * @return                            the number of messages found, else
+ *                                    negative error code.
+ */
+int32_t uGnssPrivateStreamDecodeRingBufferBatch(uRingBuffer_t *pRingBuffer,
+                                                int32_t readHandle,
+                                                uRingBufferParseRecord_t *pRecords,
+                                                uGnssPrivateMessageId_t *pPrivateMessageIds,
+                                                size_t maxNumRecords,
+                                                size_t *pOffsetEnd);
+
 /** Read data from the internal ring buffer into the given linear buffer.
  *
  * Note: gUGnssPrivateMutex should be locked before this is called, but
@@ -966,6 +1156,38 @@ int32_t uGnssPrivateSendReceiveUbxMessageAlloc(uGnssPrivateInstance_t *pInstance
                                                size_t messageBodyLengthBytes,
                                                char **ppResponseBody);
 
+/** As uGnssPrivateSendReceiveUbxMessageAlloc() but the memory for the
+ * response body, and any transient memory used in the exchange, is
+ * allocated from an arena: the caller does not free the response
+ * body, instead it is returned when the caller releases the arena.
+ *
+ * Note: gUGnssPrivateMutex should be locked before this is called.
+ *
+ * @param[in] pInstance              a pointer to the GNSS instance, cannot
+ *                                   be NULL.
+ * @param messageClass               the UBX message class.
+ * @param messageId                  the UBX message ID.
+ * @param[in] pMessageBody           the body of the message to send; may be
+ *                                   NULL.
+ * @param messageBodyLengthBytes     the amount of data at pMessageBody; must
+ *                                   be non-zero if pMessageBody is non-NULL.
+ * @param[out] ppResponseBody        a pointer to a pointer that will be
+ *                                   populated with the memory containing
+ *                                   the body of the response.  Cannot be NULL.
+ * @param[in] pArena                 the arena to allocate from; if NULL
+ *                                   this behaves exactly as
+ *                                   uGnssPrivateSendReceiveUbxMessageAlloc().
+ * @return                           the number of bytes of data at
+ *                                   ppResponseBody, else negative error code.
+ */
+int32_t uGnssPrivateSendReceiveUbxMessageArena(uGnssPrivateInstance_t *pInstance,
+                                               int32_t messageClass,
+                                               int32_t messageId,
+                                               const char *pMessageBody,
+                                               size_t messageBodyLengthBytes,
+                                               char **ppResponseBody,
+                                               uArena_t *pArena);
+
 /** Send a UBX format message to the GNSS module that only has an Ack
  * response and check that it is Acked.  May be used with any transport.
  *
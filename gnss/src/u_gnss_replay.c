@@ -0,0 +1,556 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief This source file contains the record/replay functions of the
+ * GNSS API.  Recording happens where data is read from the transport
+ * into the ring buffer, see uGnssPrivateStreamFillRingBuffer(); replay
+ * is a virtual serial device, so the rest of this API treats it like
+ * any other streaming transport.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memcpy(), memcmp()
+
+#include "u_cfg_os_platform_specific.h" // U_CFG_OS_YIELD_MS
+#include "u_cfg_sw.h"
+#include "u_compiler.h" // U_ATOMIC_XXX
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_heap.h"
+#include "u_port_uart.h"
+#include "u_port_event_queue.h"
+
+#include "u_interface.h"
+#include "u_device_serial.h"
+
+#include "u_at_client.h"
+
+#include "u_ubx_protocol.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"
+#include "u_gnss_private.h"
+#include "u_gnss_replay.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The context of a replay, the private data of the virtual
+ * serial device.
+ */
+typedef struct {
+    const char *pCapture;
+    size_t size;
+    size_t offset;       /**< the offset in pCapture of the next byte to read. */
+    size_t recordLeft;   /**< the number of bytes of the current record left to read. */
+    int32_t speedPercent;
+    bool isOpen;         /**< nothing is replayed until the device is opened. */
+    bool started;        /**< true once the time-line of the replay has started. */
+    int32_t startTimeMs;
+    void (*pEventCallback) (struct uDeviceSerial_t *, uint32_t, void *);
+    void *pEventCallbackParam;
+    uint32_t eventFilter;
+    int32_t eventQueueHandle;       /**< pEventCallback is called from this
+                                         event queue, never directly, since
+                                         whoever is reading the replay may
+                                         hold locks that it needs; negative
+                                         if there is no event callback. */
+    uint32_t eventPending;          /**< non-zero while an event is on the
+                                         event queue, so that there is only
+                                         ever one and sending it never blocks. */
+    uPortTimerHandle_t timerHandle; /**< used to raise an event when the
+                                         next record falls due, NULL if
+                                         replaying at maximum speed. */
+} uGnssReplay_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Get the length of the record whose header is at the given offset
+// in the capture and how long it is until that record falls due,
+// zero or less meaning now; returns false if there is no record at
+// the given offset.
+static bool recordGet(uGnssReplay_t *pReplay, size_t offset,
+                      size_t *pLength, int32_t *pDelayMs)
+{
+    bool isRecord = false;
+    int64_t dueMs;
+
+    *pLength = 0;
+    *pDelayMs = 0;
+    if (pReplay->isOpen &&
+        (offset + U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES <= pReplay->size)) {
+        isRecord = true;
+        *pLength = uUbxProtocolUint32Decode(pReplay->pCapture + offset + 4);
+        offset += U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES;
+        if (*pLength > pReplay->size - offset) {
+            // Truncated capture: replay what there is
+            *pLength = pReplay->size - offset;
+        }
+        if (pReplay->speedPercent != U_GNSS_REPLAY_SPEED_MAX) {
+            if (!pReplay->started) {
+                pReplay->started = true;
+                pReplay->startTimeMs = uPortGetTickTimeMs();
+            }
+            dueMs = ((int64_t) uUbxProtocolUint32Decode(pReplay->pCapture + offset -
+                                                        U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES)) *
+                    U_GNSS_REPLAY_SPEED_REAL_TIME / pReplay->speedPercent;
+            *pDelayMs = (int32_t) (dueMs - (uPortGetTickTimeMs() - pReplay->startTimeMs));
+        }
+    }
+
+    return isRecord;
+}
+
+// Event queue handler: call the event callback.
+static void eventHandler(void *pParam, size_t paramLength)
+{
+    struct uDeviceSerial_t *pDeviceSerial = *((struct uDeviceSerial_t **) pParam);
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+    void (*pEventCallback) (struct uDeviceSerial_t *, uint32_t, void *) = pReplay->pEventCallback;
+    void *pEventCallbackParam = pReplay->pEventCallbackParam;
+
+    (void) paramLength;
+
+    // Done with pReplay, which uGnssReplayDelete() may now free;
+    // clearing this before calling the callback means that a read
+    // of the replay prompted by the callback can raise another event
+    U_ATOMIC_STORE_RELEASE(&(pReplay->eventPending), 0);
+    if (pEventCallback != NULL) {
+        pEventCallback(pDeviceSerial, U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED,
+                       pEventCallbackParam);
+    }
+}
+
+// Raise a data event by sending it to the event queue, unless one
+// is already there; since there is then at most one event on the
+// queue, and one being handled, this never blocks.
+static void eventRaise(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+
+    if (U_ATOMIC_COMPARE_AND_SWAP(&(pReplay->eventPending), 0, 1)) {
+        if (uPortEventQueueSend(pReplay->eventQueueHandle, &pDeviceSerial,
+                                sizeof(pDeviceSerial)) != 0) {
+            // The event queue has been closed
+            U_ATOMIC_STORE_RELEASE(&(pReplay->eventPending), 0);
+        }
+    }
+}
+
+// Raise an event if there is data to be read or, if the next
+// record is not yet due, set the timer to raise it when it is.
+static void eventCheck(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+    size_t length;
+    int32_t delayMs;
+
+    if ((pReplay->pEventCallback != NULL) &&
+        (pReplay->eventFilter & U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED)) {
+        delayMs = 0;
+        if ((pReplay->recordLeft > 0) ||
+            recordGet(pReplay, pReplay->offset, &length, &delayMs)) {
+            if (delayMs <= 0) {
+                eventRaise(pDeviceSerial);
+            } else if (pReplay->timerHandle != NULL) {
+                uPortTimerChange(pReplay->timerHandle, (uint32_t) delayMs);
+                uPortTimerStart(pReplay->timerHandle);
+            }
+        }
+    }
+}
+
+// Timer callback: the next record has fallen due.
+static void timerCallback(const uPortTimerHandle_t timerHandle, void *pParam)
+{
+    struct uDeviceSerial_t *pDeviceSerial = (struct uDeviceSerial_t *) pParam;
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+
+    (void) timerHandle;
+
+    if (pReplay->pEventCallback != NULL) {
+        eventRaise(pDeviceSerial);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: SERIAL INTERFACE
+ * -------------------------------------------------------------- */
+
+// Start the replay again from the beginning.
+static int32_t serialOpen(struct uDeviceSerial_t *pDeviceSerial,
+                          void *pReceiveBuffer,
+                          size_t receiveBufferSizeBytes)
+{
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+
+    (void) pReceiveBuffer;
+    (void) receiveBufferSizeBytes;
+
+    pReplay->offset = U_GNSS_REPLAY_HEADER_LENGTH_BYTES;
+    pReplay->recordLeft = 0;
+    pReplay->started = false;
+    pReplay->isOpen = true;
+    eventCheck(pDeviceSerial);
+
+    return (int32_t) U_ERROR_COMMON_SUCCESS;
+}
+
+// Stop the replay.
+static void serialClose(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+
+    pReplay->isOpen = false;
+    pReplay->recordLeft = 0;
+    if (pReplay->timerHandle != NULL) {
+        uPortTimerStop(pReplay->timerHandle);
+    }
+}
+
+// Get the number of bytes that have fallen due.
+static int32_t serialGetReceiveSize(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+    size_t receiveSize = pReplay->recordLeft;
+    size_t offset = pReplay->offset + pReplay->recordLeft;
+    size_t length;
+    int32_t delayMs;
+
+    while ((receiveSize < U_GNSS_REPLAY_RECEIVE_SIZE_MAX_BYTES) &&
+           recordGet(pReplay, offset, &length, &delayMs) && (delayMs <= 0)) {
+        receiveSize += length;
+        offset += U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES + length;
+    }
+    if (receiveSize > U_GNSS_REPLAY_RECEIVE_SIZE_MAX_BYTES) {
+        receiveSize = U_GNSS_REPLAY_RECEIVE_SIZE_MAX_BYTES;
+    }
+
+    return (int32_t) receiveSize;
+}
+
+// Read the data that has fallen due.
+static int32_t serialRead(struct uDeviceSerial_t *pDeviceSerial,
+                          void *pBuffer, size_t sizeBytes)
+{
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+    size_t readSize = 0;
+    size_t length;
+    int32_t delayMs;
+    bool keepGoing = true;
+
+    while ((readSize < sizeBytes) && keepGoing) {
+        if (pReplay->recordLeft == 0) {
+            // Move on to the next record, if it is due
+            keepGoing = recordGet(pReplay, pReplay->offset, &length, &delayMs) &&
+                        (delayMs <= 0);
+            if (keepGoing) {
+                pReplay->offset += U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES;
+                pReplay->recordLeft = length;
+            }
+        } else {
+            length = pReplay->recordLeft;
+            if (length > sizeBytes - readSize) {
+                length = sizeBytes - readSize;
+            }
+            memcpy((char *) pBuffer + readSize, pReplay->pCapture + pReplay->offset, length);
+            pReplay->offset += length;
+            pReplay->recordLeft -= length;
+            readSize += length;
+        }
+    }
+    eventCheck(pDeviceSerial);
+
+    return (int32_t) readSize;
+}
+
+// Anything written to a replay is thrown away.
+static int32_t serialWrite(struct uDeviceSerial_t *pDeviceSerial,
+                           const void *pBuffer, size_t sizeBytes)
+{
+    (void) pDeviceSerial;
+    (void) pBuffer;
+
+    return (int32_t) sizeBytes;
+}
+
+// Set the event callback, which is called from an event queue of
+// its own.
+static int32_t serialEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
+                                      uint32_t filter,
+                                      void (*pFunction)(struct uDeviceSerial_t *,
+                                                        uint32_t,
+                                                        void *),
+                                      void *pParam,
+                                      size_t stackSizeBytes,
+                                      int32_t priority)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+
+    if ((pFunction != NULL) && (filter != 0)) {
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        if (pReplay->eventQueueHandle < 0) {
+            errorCode = uPortEventQueueOpen(eventHandler, "gnssReplay",
+                                            sizeof(pDeviceSerial),
+                                            stackSizeBytes, priority, 1);
+            if (errorCode >= 0) {
+                pReplay->eventQueueHandle = errorCode;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+        if ((errorCode == 0) && (pReplay->speedPercent != U_GNSS_REPLAY_SPEED_MAX) &&
+            (pReplay->timerHandle == NULL)) {
+            errorCode = uPortTimerCreate(&(pReplay->timerHandle), "gnssReplay",
+                                         timerCallback, pDeviceSerial, 1, false);
+            if (errorCode != 0) {
+                pReplay->timerHandle = NULL;
+                uPortEventQueueClose(pReplay->eventQueueHandle);
+                pReplay->eventQueueHandle = -1;
+            }
+        }
+        if (errorCode == 0) {
+            pReplay->eventFilter = filter;
+            pReplay->pEventCallbackParam = pParam;
+            pReplay->pEventCallback = pFunction;
+            eventCheck(pDeviceSerial);
+        }
+    }
+
+    return errorCode;
+}
+
+// Remove the event callback.
+static void serialEventCallbackRemove(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+
+    pReplay->pEventCallback = NULL;
+    if (pReplay->timerHandle != NULL) {
+        uPortTimerDelete(pReplay->timerHandle);
+        pReplay->timerHandle = NULL;
+    }
+    // This does not wait for the event task, which may be blocked
+    // on a lock that our caller holds
+    if (pReplay->eventQueueHandle >= 0) {
+        uPortEventQueueClose(pReplay->eventQueueHandle);
+        pReplay->eventQueueHandle = -1;
+    }
+    pReplay->eventFilter = 0;
+    pReplay->pEventCallbackParam = NULL;
+}
+
+// Get the event callback filter.
+static uint32_t serialEventCallbackFilterGet(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+
+    return pReplay->eventFilter;
+}
+
+// Populate the vector table.
+static void initSerialInterface(struct uDeviceSerial_t *pDeviceSerial)
+{
+    pDeviceSerial->open = serialOpen;
+    pDeviceSerial->close = serialClose;
+    pDeviceSerial->getReceiveSize = serialGetReceiveSize;
+    pDeviceSerial->read = serialRead;
+    pDeviceSerial->write = serialWrite;
+    pDeviceSerial->eventCallbackSet = serialEventCallbackSet;
+    pDeviceSerial->eventCallbackRemove = serialEventCallbackRemove;
+    pDeviceSerial->eventCallbackFilterGet = serialEventCallbackFilterGet;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: RECORD
+ * -------------------------------------------------------------- */
+
+// Start recording the data received from a GNSS chip.
+int32_t uGnssReplayRecordStart(uDeviceHandle_t gnssHandle,
+                               void (*pCallback) (uDeviceHandle_t gnssHandle,
+                                                  const char *pData,
+                                                  size_t size,
+                                                  void *pCallbackParam),
+                               void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateReplayRecord_t *pRecord;
+    char header[U_GNSS_REPLAY_HEADER_LENGTH_BYTES];
+    uint32_t version;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance != NULL) && (pCallback != NULL)) {
+            errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            if (uGnssPrivateGetStreamType(pInstance->transportType) >= 0) {
+                errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+                if (pInstance->pReplayRecord == NULL) {
+                    errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                    pRecord = (uGnssPrivateReplayRecord_t *) pUPortMalloc(sizeof(*pRecord));
+                    if (pRecord != NULL) {
+                        pRecord->pCallback = pCallback;
+                        pRecord->pCallbackParam = pCallbackParam;
+                        pRecord->startTimeMs = uPortGetTickTimeMs();
+                        // Pass on the capture header before any record
+                        memcpy(header, U_GNSS_REPLAY_MAGIC, 8);
+                        version = uUbxProtocolUint32Encode(U_GNSS_REPLAY_VERSION);
+                        memcpy(header + 8, &version, sizeof(version));
+                        pCallback(gnssHandle, header, sizeof(header), pCallbackParam);
+
+                        U_PORT_MUTEX_LOCK(pInstance->ringBufferWriteMutex);
+
+                        pInstance->pReplayRecord = pRecord;
+
+                        U_PORT_MUTEX_UNLOCK(pInstance->ringBufferWriteMutex);
+
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                    }
+                }
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Stop recording the data received from a GNSS chip.
+int32_t uGnssReplayRecordStop(uDeviceHandle_t gnssHandle)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateReplayRecord_t *pRecord = NULL;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (pInstance->pReplayRecord != NULL) {
+
+                U_PORT_MUTEX_LOCK(pInstance->ringBufferWriteMutex);
+
+                pRecord = pInstance->pReplayRecord;
+                pInstance->pReplayRecord = NULL;
+
+                U_PORT_MUTEX_UNLOCK(pInstance->ringBufferWriteMutex);
+            }
+            uPortFree(pRecord);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: REPLAY
+ * -------------------------------------------------------------- */
+
+// Create a virtual serial device which replays a capture.
+uDeviceSerial_t *pUGnssReplayCreate(const char *pCapture, size_t size,
+                                    int32_t speedPercent)
+{
+    uDeviceSerial_t *pDeviceSerial = NULL;
+    uGnssReplay_t *pReplay;
+
+    if ((pCapture != NULL) && (size >= U_GNSS_REPLAY_HEADER_LENGTH_BYTES) &&
+        (memcmp(pCapture, U_GNSS_REPLAY_MAGIC, 8) == 0) &&
+        (uUbxProtocolUint32Decode(pCapture + 8) == U_GNSS_REPLAY_VERSION) &&
+        (speedPercent >= 0)) {
+        pDeviceSerial = pUDeviceSerialCreate(initSerialInterface, sizeof(uGnssReplay_t));
+        if (pDeviceSerial != NULL) {
+            pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+            pReplay->pCapture = pCapture;
+            pReplay->size = size;
+            pReplay->offset = U_GNSS_REPLAY_HEADER_LENGTH_BYTES;
+            pReplay->speedPercent = speedPercent;
+            pReplay->eventQueueHandle = -1;
+        }
+    }
+
+    return pDeviceSerial;
+}
+
+// Determine whether all of the data of a replay has been read.
+bool uGnssReplayIsFinished(uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssReplay_t *pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+
+    return pReplay->isOpen && (pReplay->recordLeft == 0) &&
+           (pReplay->offset + U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES > pReplay->size);
+}
+
+// Delete a replay.
+void uGnssReplayDelete(uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssReplay_t *pReplay;
+
+    if (pDeviceSerial != NULL) {
+        pReplay = (uGnssReplay_t *) pUInterfaceContext(pDeviceSerial);
+        if (pReplay->timerHandle != NULL) {
+            uPortTimerDelete(pReplay->timerHandle);
+        }
+        if (pReplay->eventQueueHandle >= 0) {
+            uPortEventQueueClose(pReplay->eventQueueHandle);
+        }
+        // A closed event queue still passes on what is on it, so
+        // wait for any event to be done with pReplay
+        while (U_ATOMIC_LOAD_ACQUIRE(&(pReplay->eventPending)) != 0) {
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        }
+        uDeviceSerialDelete(pDeviceSerial);
+    }
+}
+
+// End of file
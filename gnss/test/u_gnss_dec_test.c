@@ -53,6 +53,8 @@
 
 #include "u_test_util_resource_check.h"
 
+#include "u_ubx_protocol.h"
+
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss.h"
@@ -102,6 +104,18 @@
 # define U_GNSS_DEC_TEST_HEX_DUMP_WIDTH 16
 #endif
 
+#ifndef U_GNSS_DEC_TEST_BENCHMARK_ITERATIONS
+/** The number of times the recorded stream is decoded, by each
+ * decode method, in the test "gnssDecBenchmark".
+ */
+# define U_GNSS_DEC_TEST_BENCHMARK_ITERATIONS 1000
+#endif
+
+/** Room for the recorded stream used by the test "gnssDecBenchmark",
+ * which is made by concatenating all of the known test vectors.
+ */
+#define U_GNSS_DEC_TEST_BENCHMARK_STREAM_LENGTH_BYTES 1024
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -160,6 +174,16 @@ typedef struct {
     int32_t callbackDecodeIndicator;
 } uGnssDecTestDataCallback_t;
 
+/** The ways of decoding a message that are compared by the
+ * test "gnssDecBenchmark".
+ */
+typedef enum {
+    U_GNSS_DEC_TEST_METHOD_IN_PLACE, /**< uGnssDecUbx(). */
+    U_GNSS_DEC_TEST_METHOD_HEAP,     /**< pUGnssDecAlloc(). */
+    U_GNSS_DEC_TEST_METHOD_ARENA,    /**< pUGnssDecArenaAlloc(). */
+    U_GNSS_DEC_TEST_METHOD_MAX_NUM
+} uGnssDecTestMethod_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -224,11 +248,243 @@ static const uGnssDecTestDataKnown_t gUbxNavHpposllh[] = {
     }
 };
 
+/** Decoded test data for UBX-NAV-DOP, to be used by gUbxNavDop (item 0).
+ */
+static const uGnssDecUbxNavDop_t gUbxNavDopDecoded0 = {
+    486173000 /* iTOW */, 215 /* gDOP */, 189 /* pDOP */, 101 /* tDOP */,
+    152 /* vDOP */, 112 /* hDOP */, 88 /* nDOP */, 69 /* eDOP */
+};
+
+/** Array of test data for UBX-NAV-DOP.
+ */
+static const uGnssDecTestDataKnown_t gUbxNavDop[] = {
+    {
+        {
+            "\xb5\x62\x01\x04\x12\x00\x48\x69\xfa\x1c\xd7\x00\xbd\x00\x65\x00"
+            "\x98\x00\x70\x00\x58\x00\x45\x00\x7c\xf9", 26
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0104, NULL
+        },
+        (void *) &gUbxNavDopDecoded0
+    }
+};
+
+/** Decoded test data for UBX-NAV-STATUS, to be used by gUbxNavStatus (item 0).
+ */
+static const uGnssDecUbxNavStatus_t gUbxNavStatusDecoded0 = {
+    486173000 /* iTOW */, U_GNSS_DEC_UBX_NAV_STATUS_GPS_FIX_3D /* gpsFix */,
+    0x0d /* flags */, 0x00 /* fixStat */, 0x08 /* flags2 */,
+    27543 /* ttff */, 1832512 /* msss */
+};
+
+/** Array of test data for UBX-NAV-STATUS.
+ */
+static const uGnssDecTestDataKnown_t gUbxNavStatus[] = {
+    {
+        {
+            "\xb5\x62\x01\x03\x10\x00\x48\x69\xfa\x1c\x03\x0d\x00\x08\x97\x6b"
+            "\x00\x00\x40\xf6\x1b\x00\x46\xe4", 24
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0103, NULL
+        },
+        (void *) &gUbxNavStatusDecoded0
+    }
+};
+
+/** Decoded test data for UBX-NAV-SAT, to be used by gUbxNavSat (item 0).
+ */
+static const uGnssDecUbxNavSat_t gUbxNavSatDecoded0 = {
+    486173000 /* iTOW */, 1 /* version */, 3 /* numSvs */, 3 /* numDecoded */,
+    {
+        {
+            0 /* gnssId */, 5 /* svId */, 44 /* cno */, 62 /* elev */,
+            241 /* azim */, -12 /* prRes */, 0x0000191f /* flags */
+        },
+        {
+            2 /* gnssId */, 11 /* svId */, 38 /* cno */, -3 /* elev */,
+            78 /* azim */, 25 /* prRes */, 0x00001917 /* flags */
+        },
+        {
+            6 /* gnssId */, 71 /* svId */, 0 /* cno */, 0 /* elev */,
+            0 /* azim */, 0 /* prRes */, 0x00000011 /* flags */
+        }
+    }
+};
+
+/** Array of test data for UBX-NAV-SAT.
+ */
+static const uGnssDecTestDataKnown_t gUbxNavSat[] = {
+    {
+        {
+            "\xb5\x62\x01\x35\x2c\x00\x48\x69\xfa\x1c\x01\x03\x00\x00\x00\x05"
+            "\x2c\x3e\xf1\x00\xf4\xff\x1f\x19\x00\x00\x02\x0b\x26\xfd\x4e\x00"
+            "\x19\x00\x17\x19\x00\x00\x06\x47\x00\x00\x00\x00\x00\x00\x11\x00"
+            "\x00\x00\xdd\xa6", 52
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0135, NULL
+        },
+        (void *) &gUbxNavSatDecoded0
+    }
+};
+
+/** Decoded test data for UBX-NAV-SIG, to be used by gUbxNavSig (item 0).
+ */
+static const uGnssDecUbxNavSig_t gUbxNavSigDecoded0 = {
+    486173000 /* iTOW */, 0 /* version */, 2 /* numSigs */, 2 /* numDecoded */,
+    {
+        {
+            0 /* gnssId */, 5 /* svId */, 0 /* sigId */, 0 /* freqId */,
+            -12 /* prRes */, 44 /* cno */, 7 /* qualityInd */,
+            0 /* corrSource */, 1 /* ionoModel */, 0x0029 /* sigFlags */
+        },
+        {
+            2 /* gnssId */, 11 /* svId */, 6 /* sigId */, 0 /* freqId */,
+            31 /* prRes */, 38 /* cno */, 5 /* qualityInd */,
+            0 /* corrSource */, 1 /* ionoModel */, 0x0019 /* sigFlags */
+        }
+    }
+};
+
+/** Array of test data for UBX-NAV-SIG.
+ */
+static const uGnssDecTestDataKnown_t gUbxNavSig[] = {
+    {
+        {
+            "\xb5\x62\x01\x43\x28\x00\x48\x69\xfa\x1c\x00\x02\x00\x00\x00\x05"
+            "\x00\x00\xf4\xff\x2c\x07\x00\x01\x29\x00\x00\x00\x00\x00\x02\x0b"
+            "\x06\x00\x1f\x00\x26\x05\x00\x01\x19\x00\x00\x00\x00\x00\x01\x71", 48
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0143, NULL
+        },
+        (void *) &gUbxNavSigDecoded0
+    }
+};
+
+/** Decoded test data for UBX-RXM-RAWX, to be used by gUbxRxmRawx (item 0).
+ */
+static const uGnssDecUbxRxmRawx_t gUbxRxmRawxDecoded0 = {
+    486173.5 /* rcvTow */, 2279 /* week */, 18 /* leapS */, 2 /* numMeas */,
+    0x01 /* recStat */, 1 /* version */, 2 /* numDecoded */,
+    {
+        {
+            21466392.25 /* prMes */, 112806445.5 /* cpMes */, -1250.75f /* doMes */,
+            0 /* gnssId */, 5 /* svId */, 0 /* sigId */, 0 /* freqId */,
+            64500 /* locktime */, 44 /* cno */, 0x05 /* prStdev */,
+            0x02 /* cpStdev */, 0x06 /* doStdev */, 0x07 /* trkStat */
+        },
+        {
+            23788011.125 /* prMes */, 125006720.0 /* cpMes */, 2345.5f /* doMes */,
+            2 /* gnssId */, 11 /* svId */, 0 /* sigId */, 0 /* freqId */,
+            32000 /* locktime */, 38 /* cno */, 0x06 /* prStdev */,
+            0x03 /* cpStdev */, 0x07 /* doStdev */, 0x03 /* trkStat */
+        }
+    }
+};
+
+/** Array of test data for UBX-RXM-RAWX.
+ */
+static const uGnssDecTestDataKnown_t gUbxRxmRawx[] = {
+    {
+        {
+            "\xb5\x62\x02\x15\x50\x00\x00\x00\x00\x00\x76\xac\x1d\x41\xe7\x08"
+            "\x12\x02\x01\x01\x00\x00\x00\x00\x00\x84\xd1\x78\x74\x41\x00\x00"
+            "\x00\xb6\x28\xe5\x9a\x41\x00\x58\x9c\xc4\x00\x05\x00\x00\xf4\xfb"
+            "\x2c\x05\x02\x06\x07\x00\x00\x00\x00\xb2\x9e\xaf\x76\x41\x00\x00"
+            "\x00\x00\xce\xcd\x9d\x41\x00\x98\x12\x45\x02\x0b\x00\x00\x00\x7d"
+            "\x26\x06\x03\x07\x03\x00\xd9\xf7", 88
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0215, NULL
+        },
+        (void *) &gUbxRxmRawxDecoded0
+    }
+};
+
+/** Decoded test data for UBX-TIM-TP, to be used by gUbxTimTp (item 0).
+ */
+static const uGnssDecUbxTimTp_t gUbxTimTpDecoded0 = {
+    486174000 /* towMS */, 0 /* towSubMS */, -1843 /* qErr */,
+    2279 /* week */, 0x03 /* flags */, 0x30 /* refInfo */
+};
+
+/** Array of test data for UBX-TIM-TP.
+ */
+static const uGnssDecTestDataKnown_t gUbxTimTp[] = {
+    {
+        {
+            "\xb5\x62\x0d\x01\x10\x00\x30\x6d\xfa\x1c\x00\x00\x00\x00\xcd\xf8"
+            "\xff\xff\xe7\x08\x03\x30\xb6\xc1", 24
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0d01, NULL
+        },
+        (void *) &gUbxTimTpDecoded0
+    }
+};
+
+/** Decoded test data for UBX-ESF-MEAS, to be used by gUbxEsfMeas
+ * (item 0), three measurements followed by calibTtag.
+ */
+static const uGnssDecUbxEsfMeas_t gUbxEsfMeasDecoded0 = {
+    1234567 /* timeTag */, 0x1808 /* flags */, 0 /* id */, 3 /* numDecoded */,
+    {
+        {0x0b0003e8 /* data */}, {0x05fffe0c /* data */}, {0x10000123 /* data */}
+    },
+    486173123 /* calibTtag */
+};
+
+/** Decoded test data for UBX-ESF-MEAS, to be used by gUbxEsfMeas
+ * (item 1), a single measurement and no calibTtag.
+ */
+static const uGnssDecUbxEsfMeas_t gUbxEsfMeasDecoded1 = {
+    1234600 /* timeTag */, 0x0800 /* flags */, 0 /* id */, 1 /* numDecoded */,
+    {
+        {0x0b000010 /* data */}
+    },
+    0 /* calibTtag */
+};
+
+/** Array of test data for UBX-ESF-MEAS.
+ */
+static const uGnssDecTestDataKnown_t gUbxEsfMeas[] = {
+    {
+        {
+            "\xb5\x62\x10\x02\x18\x00\x87\xd6\x12\x00\x08\x18\x00\x00\xe8\x03"
+            "\x00\x0b\x0c\xfe\xff\x05\x23\x01\x00\x10\xc3\x69\xfa\x1c\x33\xdb", 32
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x1002, NULL
+        },
+        (void *) &gUbxEsfMeasDecoded0
+    },
+    {
+        {
+            "\xb5\x62\x10\x02\x0c\x00\xa8\xd6\x12\x00\x00\x08\x00\x00\x10\x00"
+            "\x00\x0b\xd1\x0f", 20
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x1002, NULL
+        },
+        (void *) &gUbxEsfMeasDecoded1
+    }
+};
+
 /** Array of arrays of test vectors for all known message types.
  */
 static const uGnssDecTestDataKnownSet_t gTestDataKnownSet[] = {
     {gUbxNavPvt, sizeof(gUbxNavPvt) / sizeof(gUbxNavPvt[0]), sizeof(gUbxNavPvtDecoded0)},
-    {gUbxNavHpposllh, sizeof(gUbxNavHpposllh) / sizeof(gUbxNavHpposllh[0]), sizeof(gUbxNavHpposllhDecoded0)}
+    {gUbxNavHpposllh, sizeof(gUbxNavHpposllh) / sizeof(gUbxNavHpposllh[0]), sizeof(gUbxNavHpposllhDecoded0)},
+    {gUbxNavDop, sizeof(gUbxNavDop) / sizeof(gUbxNavDop[0]), sizeof(gUbxNavDopDecoded0)},
+    {gUbxNavStatus, sizeof(gUbxNavStatus) / sizeof(gUbxNavStatus[0]), sizeof(gUbxNavStatusDecoded0)},
+    {gUbxNavSat, sizeof(gUbxNavSat) / sizeof(gUbxNavSat[0]), sizeof(gUbxNavSatDecoded0)},
+    {gUbxNavSig, sizeof(gUbxNavSig) / sizeof(gUbxNavSig[0]), sizeof(gUbxNavSigDecoded0)},
+    {gUbxRxmRawx, sizeof(gUbxRxmRawx) / sizeof(gUbxRxmRawx[0]), sizeof(gUbxRxmRawxDecoded0)},
+    {gUbxTimTp, sizeof(gUbxTimTp) / sizeof(gUbxTimTp[0]), sizeof(gUbxTimTpDecoded0)},
+    {gUbxEsfMeas, sizeof(gUbxEsfMeas) / sizeof(gUbxEsfMeas[0]), sizeof(gUbxEsfMeasDecoded0)}
 };
 
 /** Flag to share with the user callback.
@@ -331,6 +587,28 @@ static const uGnssDecTestDataCallback_t gTestDataCallback[] = {
     }
 };
 
+/** Somewhere to decode into for uGnssDecUbx(), kept off the
+ * stack as it is large.
+ */
+static uGnssDecUnion_t gBody;
+
+/** A recorded stream of messages for the test "gnssDecBenchmark".
+ */
+static char gStream[U_GNSS_DEC_TEST_BENCHMARK_STREAM_LENGTH_BYTES];
+
+/** An arena for the test "gnssDecBenchmark": enough for the decode
+ * structure and the largest body.
+ */
+static char gArenaBlock[sizeof(uGnssDec_t) + sizeof(uGnssDecUnion_t) + (U_ARENA_ALIGNMENT_BYTES * 3)];
+
+/** The names of the decode methods, for printing; must match
+ * the order of uGnssDecTestMethod_t.
+ */
+static const char *const gpMethodName[] = {"uGnssDecUbx()",
+                                           "pUGnssDecAlloc()",
+                                           "pUGnssDecArenaAlloc()"
+                                          };
+
 // The CRC length for each protocol type
 static const size_t gCrcLength[] = {
     2, // U_GNSS_PROTOCOL_UBX
@@ -511,6 +789,51 @@ static void testHelperFunctions(const uGnssMessageId_t *pId,
     // *INDENT-ON*
 }
 
+// Decode the recorded stream of the given length using the given
+// method, returning the number of messages successfully decoded.
+static size_t decodeStream(uGnssDecTestMethod_t method,
+                           const char *pStream, size_t length,
+                           uArena_t *pArena)
+{
+    size_t count = 0;
+    size_t messageLength;
+    uGnssDec_t *pDec;
+    uArenaMark_t mark;
+
+    while (length >= U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) {
+        messageLength = U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES +
+                        (uint8_t) pStream[4] + ((size_t) (uint8_t) pStream[5] << 8);
+        switch (method) {
+            case U_GNSS_DEC_TEST_METHOD_IN_PLACE:
+                if (uGnssDecUbx(pStream, messageLength, &gBody, sizeof(gBody)) >= 0) {
+                    count++;
+                }
+                break;
+            case U_GNSS_DEC_TEST_METHOD_HEAP:
+                pDec = pUGnssDecAlloc(pStream, messageLength);
+                if ((pDec != NULL) && (pDec->errorCode == 0)) {
+                    count++;
+                }
+                uGnssDecFree(pDec);
+                break;
+            case U_GNSS_DEC_TEST_METHOD_ARENA:
+                mark = uArenaMark(pArena);
+                pDec = pUGnssDecArenaAlloc(pStream, messageLength, pArena);
+                if ((pDec != NULL) && (pDec->errorCode == 0)) {
+                    count++;
+                }
+                uArenaRelease(pArena, mark);
+                break;
+            default:
+                break;
+        }
+        pStream += messageLength;
+        length -= messageLength;
+    }
+
+    return count;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -707,4 +1030,205 @@ U_PORT_TEST_FUNCTION("[gnssDec]", "gnssDecKnown")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+/** Test of decoding the known functions into an arena.
+ */
+U_PORT_TEST_FUNCTION("[gnssDec]", "gnssDecArena")
+{
+    int32_t resourceCount;
+    int32_t mallocCount;
+    uGnssDec_t *pDec;
+    const uGnssDecTestDataKnown_t *pTestData = NULL;
+    size_t decodedStructureSize;
+    uArena_t arena;
+    uArenaMark_t mark;
+
+    // Get the initial resource count
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uArenaInit(&arena, gArenaBlock, sizeof(gArenaBlock)) == 0);
+    U_PORT_TEST_ASSERT(pUGnssDecArenaAlloc(gTestDataKnownSet[0].pTestData->raw.p,
+                                           gTestDataKnownSet[0].pTestData->raw.length,
+                                           NULL) == NULL);
+    mallocCount = uPortHeapMallocCount();
+    for (size_t x = 0; x < sizeof(gTestDataKnownSet) / sizeof(gTestDataKnownSet[0]); x++) {
+        decodedStructureSize = gTestDataKnownSet[x].decodedStructureSize;
+        for (size_t y = 0; y < gTestDataKnownSet[x].size; y++) {
+            pTestData = gTestDataKnownSet[x].pTestData + y;
+            mark = uArenaMark(&arena);
+            pDec = pUGnssDecArenaAlloc(pTestData->raw.p,
+                                       pTestData->raw.length - gCrcLength[pTestData->id.type],
+                                       &arena);
+            U_PORT_TEST_ASSERT(pDec != NULL);
+            U_TEST_PRINT_LINE_X_Y("pUGnssDecArenaAlloc() returned error code %d.",
+                                  x, y, pDec->errorCode);
+            U_PORT_TEST_ASSERT(pDec->errorCode == 0);
+            U_PORT_TEST_ASSERT(pDec->pBody != NULL);
+            U_PORT_TEST_ASSERT(memcmp(pDec->pBody, pTestData->pDecoded, decodedStructureSize) == 0);
+            // Nothing should have come from the heap
+            U_PORT_TEST_ASSERT(uPortHeapMallocCount() == mallocCount);
+            uArenaRelease(&arena, mark);
+            U_PORT_TEST_ASSERT(arena.offset == 0);
+        }
+    }
+    U_TEST_PRINT_LINE("arena peak %d byte(s) of %d.", (int) arena.peakOffset, (int) arena.size);
+    U_PORT_TEST_ASSERT(arena.overflowCount == 0);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test of decoding the known functions into a structure provided
+ * by the caller.
+ */
+U_PORT_TEST_FUNCTION("[gnssDec]", "gnssDecUbx")
+{
+    int32_t resourceCount;
+    int32_t mallocCount;
+    int32_t errorCodeOrId;
+    const uGnssDecTestDataKnown_t *pTestData = NULL;
+    size_t decodedStructureSize;
+    char buffer[128];
+    uGnssDec_t *pDec;
+
+    // Get the initial resource count
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    mallocCount = uPortHeapMallocCount();
+    for (size_t x = 0; x < sizeof(gTestDataKnownSet) / sizeof(gTestDataKnownSet[0]); x++) {
+        decodedStructureSize = gTestDataKnownSet[x].decodedStructureSize;
+        for (size_t y = 0; y < gTestDataKnownSet[x].size; y++) {
+            pTestData = gTestDataKnownSet[x].pTestData + y;
+            memset(&gBody, 0xFF, sizeof(gBody));
+            errorCodeOrId = uGnssDecUbx(pTestData->raw.p,
+                                        pTestData->raw.length - gCrcLength[pTestData->id.type],
+                                        &gBody, decodedStructureSize);
+            U_TEST_PRINT_LINE_X_Y("uGnssDecUbx() returned 0x%04x.", x, y, errorCodeOrId);
+            U_PORT_TEST_ASSERT(errorCodeOrId == pTestData->id.idUbxOrRtcm);
+            U_PORT_TEST_ASSERT(memcmp(&gBody, pTestData->pDecoded, decodedStructureSize) == 0);
+            // Not enough room
+            U_PORT_TEST_ASSERT(uGnssDecUbx(pTestData->raw.p, pTestData->raw.length,
+                                           &gBody, decodedStructureSize - 1) ==
+                               (int32_t) U_ERROR_COMMON_NO_MEMORY);
+        }
+    }
+    // Nothing should have come from the heap
+    U_PORT_TEST_ASSERT(uPortHeapMallocCount() == mallocCount);
+
+    // Bad parameters, not UBX, not supported and too short
+    U_PORT_TEST_ASSERT(uGnssDecUbx(NULL, 0, &gBody, sizeof(gBody)) ==
+                       (int32_t) U_ERROR_COMMON_INVALID_PARAMETER);
+    U_PORT_TEST_ASSERT(uGnssDecUbx(gUbxNavSat[0].raw.p, gUbxNavSat[0].raw.length,
+                                   NULL, sizeof(gBody)) == (int32_t) U_ERROR_COMMON_INVALID_PARAMETER);
+    U_PORT_TEST_ASSERT(uGnssDecUbx(gTestDataCallback[2].raw.p, gTestDataCallback[2].raw.length,
+                                   &gBody, sizeof(gBody)) == (int32_t) U_ERROR_COMMON_UNKNOWN);
+    U_PORT_TEST_ASSERT(uGnssDecUbx(gTestDataCallback[0].raw.p, gTestDataCallback[0].raw.length,
+                                   &gBody, sizeof(gBody)) == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+    U_PORT_TEST_ASSERT(uGnssDecUbx(gUbxNavSat[0].raw.p, 10, &gBody, sizeof(gBody)) ==
+                       (int32_t) U_ERROR_COMMON_TRUNCATED);
+
+    // A UBX-NAV-SAT message which claims one more satellite than
+    // it contains: those present should be decoded
+    U_PORT_TEST_ASSERT(gUbxNavSat[0].raw.length <= sizeof(buffer));
+    memcpy(buffer, gUbxNavSat[0].raw.p, gUbxNavSat[0].raw.length);
+    buffer[U_UBX_PROTOCOL_HEADER_LENGTH_BYTES + 5]++;
+    U_PORT_TEST_ASSERT(uGnssDecUbx(buffer, gUbxNavSat[0].raw.length, &gBody, sizeof(gBody)) ==
+                       (int32_t) U_ERROR_COMMON_BAD_DATA);
+    U_PORT_TEST_ASSERT(gBody.ubxNavSat.numSvs == gUbxNavSatDecoded0.numSvs + 1);
+    U_PORT_TEST_ASSERT(gBody.ubxNavSat.numDecoded == gUbxNavSatDecoded0.numDecoded);
+    U_PORT_TEST_ASSERT(memcmp(gBody.ubxNavSat.sv, gUbxNavSatDecoded0.sv,
+                              sizeof(gUbxNavSatDecoded0.sv)) == 0);
+    pDec = pUGnssDecAlloc(buffer, gUbxNavSat[0].raw.length);
+    U_PORT_TEST_ASSERT(pDec != NULL);
+    U_PORT_TEST_ASSERT(pDec->errorCode == (int32_t) U_ERROR_COMMON_BAD_DATA);
+    U_PORT_TEST_ASSERT(pDec->pBody != NULL);
+    uGnssDecFree(pDec);
+
+    // A UBX-NAV-PVT message of only the minimum length: fields
+    // beyond the end of the message must be left at zero
+    U_PORT_TEST_ASSERT(gUbxNavPvt[0].raw.length <= sizeof(buffer));
+    memcpy(buffer, gUbxNavPvt[0].raw.p, gUbxNavPvt[0].raw.length);
+    buffer[4] = U_GNSS_DEC_UBX_NAV_PVT_BODY_MIN_LENGTH;
+    buffer[5] = 0;
+    U_PORT_TEST_ASSERT(uGnssDecUbx(buffer,
+                                   U_UBX_PROTOCOL_HEADER_LENGTH_BYTES + U_GNSS_DEC_UBX_NAV_PVT_BODY_MIN_LENGTH,
+                                   &gBody, sizeof(gBody)) == gUbxNavPvt[0].id.idUbxOrRtcm);
+    U_PORT_TEST_ASSERT(gBody.ubxNavPvt.height == gUbxNavPvtDecoded0.height);
+    U_PORT_TEST_ASSERT(gBody.ubxNavPvt.hMSL == 0);
+    U_PORT_TEST_ASSERT(gBody.ubxNavPvt.pDOP == 0);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Measure the decode throughput of a recorded stream of messages
+ * for each of the decode methods.
+ */
+U_PORT_TEST_FUNCTION("[gnssDec]", "gnssDecBenchmark")
+{
+    int32_t resourceCount;
+    int32_t mallocCount;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    size_t length = 0;
+    size_t numMessages = 0;
+    size_t count;
+    const uGnssDecTestDataKnown_t *pTestData = NULL;
+    uArena_t arena;
+
+    // Get the initial resource count
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // Make the recorded stream from all of the known test vectors,
+    // complete with checksums, as they would be received
+    for (size_t x = 0; x < sizeof(gTestDataKnownSet) / sizeof(gTestDataKnownSet[0]); x++) {
+        for (size_t y = 0; y < gTestDataKnownSet[x].size; y++) {
+            pTestData = gTestDataKnownSet[x].pTestData + y;
+            U_PORT_TEST_ASSERT(length + pTestData->raw.length <= sizeof(gStream));
+            memcpy(gStream + length, pTestData->raw.p, pTestData->raw.length);
+            length += pTestData->raw.length;
+            numMessages++;
+        }
+    }
+    U_TEST_PRINT_LINE("recorded stream is %d message(s), %d byte(s), decoding it %d time(s)"
+                      " with each method.", (int) numMessages, (int) length,
+                      U_GNSS_DEC_TEST_BENCHMARK_ITERATIONS);
+
+    U_PORT_TEST_ASSERT(uArenaInit(&arena, gArenaBlock, sizeof(gArenaBlock)) == 0);
+    for (size_t x = 0; x < U_GNSS_DEC_TEST_METHOD_MAX_NUM; x++) {
+        count = 0;
+        mallocCount = uPortHeapMallocCount();
+        startTimeMs = uPortGetTickTimeMs();
+        for (size_t y = 0; y < U_GNSS_DEC_TEST_BENCHMARK_ITERATIONS; y++) {
+            count += decodeStream((uGnssDecTestMethod_t) x, gStream, length, &arena);
+        }
+        durationMs = uPortGetTickTimeMs() - startTimeMs;
+        if (durationMs > 0) {
+            U_TEST_PRINT_LINE_X("%s decoded %d message(s) in %d ms, %d message(s)/second.",
+                                x, gpMethodName[x], (int) count, (int) durationMs,
+                                (int) (((int64_t) count * 1000) / durationMs));
+        } else {
+            U_TEST_PRINT_LINE_X("%s decoded %d message(s) in less than 1 ms.",
+                                x, gpMethodName[x], (int) count);
+        }
+        U_PORT_TEST_ASSERT(count == numMessages * U_GNSS_DEC_TEST_BENCHMARK_ITERATIONS);
+        if (x != U_GNSS_DEC_TEST_METHOD_HEAP) {
+            // Nothing should have come from the heap
+            U_PORT_TEST_ASSERT(uPortHeapMallocCount() == mallocCount);
+        }
+    }
+    U_PORT_TEST_ASSERT(arena.overflowCount == 0);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 // End of file
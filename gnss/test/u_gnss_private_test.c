@@ -56,6 +56,7 @@
 #include "u_port_os.h"
 #include "u_port_heap.h"
 #include "u_port_debug.h"
+#include "u_port_uart.h"
 
 #include "u_test_util_resource_check.h"
 
@@ -64,6 +65,7 @@
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss.h"
+#include "u_gnss_msg.h"
 #include "u_gnss_private.h"
 
 /* ----------------------------------------------------------------
@@ -104,6 +106,34 @@
  */
 #define U_GNSS_PRIVATE_TEST_NMEA_MESSAGE_0_LENGTH 72
 
+#ifndef U_GNSS_PRIVATE_TEST_LATENCY_NUM_MESSAGES
+/** The number of UBX-NAV-PVT messages to send around the UART
+ * loop-back in the latency test.
+ */
+# define U_GNSS_PRIVATE_TEST_LATENCY_NUM_MESSAGES 50
+#endif
+
+#ifndef U_GNSS_PRIVATE_TEST_LATENCY_AVERAGE_MAX_US
+/** The maximum average time from a UBX-NAV-PVT message arriving
+ * at the UART to the message receive callback being called, in
+ * microseconds, when the message receive task is woken by the
+ * data-received event of the UART.
+ */
+# define U_GNSS_PRIVATE_TEST_LATENCY_AVERAGE_MAX_US 20000
+#endif
+
+#ifndef U_GNSS_PRIVATE_TEST_MSG_FILTER_TIMING_LOOPS
+/** How many times to go around the message list when timing
+ * the message filters.
+ */
+# define U_GNSS_PRIVATE_TEST_MSG_FILTER_TIMING_LOOPS 1000
+#endif
+
+/** The number of message readers to use when testing the message
+ * filters, enough to overflow the compiled filters.
+ */
+#define U_GNSS_PRIVATE_TEST_MSG_FILTER_READERS_MAX_NUM (U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM + 8)
+
 #ifndef U_GNSS_PRIVATE_TEST_RINGBUFFER_SIZE
 /** The size of ring buffer to use in the private GNSS tests.
  */
@@ -139,6 +169,16 @@ typedef struct {
     uint16_t id;
 } uGnssPrivateTestRtcmMatch_t;
 
+/** Struct to hold a message ID for the message filter test; this
+ * is not a uGnssPrivateMessageId_t since a union can't be statically
+ * initialised when compiling as C++.
+ */
+typedef struct {
+    uGnssProtocol_t type;
+    uint16_t id;       /**< the UBX or RTCM ID. */
+    const char *pNmea; /**< the NMEA ID. */
+} uGnssPrivateTestMsgFilterId_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -159,6 +199,30 @@ static uRingBuffer_t gRingBuffer = {0};
  */
 static char *gpBody = NULL;
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
+
+/** The time a message was sent in the latency test.
+ */
+static volatile int32_t gLatencySendTimeUs = 0;
+
+/** The number of messages received in the latency test.
+ */
+static volatile int32_t gLatencyCount = 0;
+
+/** The total latency in the latency test.
+ */
+static int32_t gLatencyTotalUs = 0;
+
+/** The largest latency in the latency test.
+ */
+static int32_t gLatencyMaxUs = 0;
+
+/** A variable to track errors in the latency test callback.
+ */
+static volatile int32_t gLatencyErrorCode = 0;
+
+#endif // #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
+
 # ifndef __ZEPHYR__
 
 /** Some sample NMEA message strings, taken from
@@ -297,6 +361,75 @@ static const uGnssPrivateTestRtcmMatch_t gRtcmTestMessage[] = {
     }
 };
 
+/** Message IDs that a message reader might want, including all
+ * the flavours of wildcard.
+ */
+static const uGnssPrivateTestMsgFilterId_t gMsgFilterWanted[] = {
+    {U_GNSS_PROTOCOL_ANY, 0, NULL},
+    {U_GNSS_PROTOCOL_ALL, 0, NULL},
+    {U_GNSS_PROTOCOL_UNKNOWN, 0, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x0107, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x0107, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x01FF, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0xFF07, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0xFFFF, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x0215, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x0a04, NULL},
+    {U_GNSS_PROTOCOL_RTCM, 1005, NULL},
+    {U_GNSS_PROTOCOL_RTCM, 1077, NULL},
+    {U_GNSS_PROTOCOL_RTCM, 0xFFFF, NULL},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGGA"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GNGGA"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGSV"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GP"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "G"},
+    {U_GNSS_PROTOCOL_NMEA, 0, ""},
+    {U_GNSS_PROTOCOL_NMEA, 0, "?PGGA"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "??GSV"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGGA?"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "PUBX"},
+    // Only different if U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS
+    // is more than eight, when the second is too long for a key
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGGAXXX"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGGAXXXX"}
+};
+
+/** Message IDs of received messages for the message filter test.
+ */
+static const uGnssPrivateTestMsgFilterId_t gMsgFilterMessage[] = {
+    {U_GNSS_PROTOCOL_UNKNOWN, 0, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x0107, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x0108, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x01FF, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x0207, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x0215, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0x0a04, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0xFF07, NULL},
+    {U_GNSS_PROTOCOL_UBX, 0xFFFF, NULL},
+    {U_GNSS_PROTOCOL_RTCM, 1005, NULL},
+    {U_GNSS_PROTOCOL_RTCM, 1077, NULL},
+    {U_GNSS_PROTOCOL_RTCM, 1087, NULL},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGGA"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GNGGA"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGSV"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GLGSV"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPRMC"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "PUBX"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "G"},
+    {U_GNSS_PROTOCOL_NMEA, 0, ""},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGGAXXXX"},
+    {U_GNSS_PROTOCOL_NMEA, 0, "GPGGAXXXY"}
+};
+
+/** The message readers for the message filter test.
+ */
+static uGnssPrivateMsgReader_t gMsgFilterReader[U_GNSS_PRIVATE_TEST_MSG_FILTER_READERS_MAX_NUM];
+
+/** The compiled message filters for the message filter test, kept
+ * off the stack since they are not small.
+ */
+static uGnssPrivateMsgFilter_t gMsgFilter;
+
 #endif // #ifndef __ZEPHYR__
 
 /* ----------------------------------------------------------------
@@ -490,8 +623,105 @@ static bool checkDecodeUbx(uRingBuffer_t *pRingBuffer, int32_t readHandle,
     return passNotFail;
 }
 
+// Populate a private message ID from a message filter test ID.
+static void msgFilterIdSet(const uGnssPrivateTestMsgFilterId_t *pTestId,
+                           uGnssPrivateMessageId_t *pId)
+{
+    memset(pId, 0, sizeof(*pId));
+    pId->type = pTestId->type;
+    if (pTestId->type == U_GNSS_PROTOCOL_NMEA) {
+        strncpy(pId->id.nmea, pTestId->pNmea, sizeof(pId->id.nmea) - 1);
+    } else if (pTestId->type == U_GNSS_PROTOCOL_RTCM) {
+        pId->id.rtcm = pTestId->id;
+    } else {
+        pId->id.ubx = pTestId->id;
+    }
+}
+
+// Link the first numReaders entries of gMsgFilterReader[] into a
+// list, compile it into gMsgFilter and check that the compiled
+// filters give the same answer as matching each reader in turn
+// for all of the messages in gMsgFilterMessage[].
+static bool msgFilterCheck(size_t numReaders)
+{
+    bool passNotFail = true;
+    uGnssPrivateMessageId_t messageId;
+    uint32_t readers;
+    uint32_t readersExpected;
+    size_t numCompiled = numReaders;
+    uGnssPrivateMsgReader_t *pOverflow = NULL;
+
+    for (size_t x = 0; x < numReaders; x++) {
+        gMsgFilterReader[x].handle = (int32_t) x;
+        gMsgFilterReader[x].pNext = NULL;
+        if (x + 1 < numReaders) {
+            gMsgFilterReader[x].pNext = &(gMsgFilterReader[x + 1]);
+        }
+    }
+    if (numCompiled > U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM) {
+        numCompiled = U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM;
+        pOverflow = &(gMsgFilterReader[numCompiled]);
+    }
+    uGnssPrivateMsgFilterCompile(&gMsgFilter, numReaders > 0 ? &(gMsgFilterReader[0]) : NULL);
+    if ((gMsgFilter.numReaders != numCompiled) || (gMsgFilter.pOverflow != pOverflow)) {
+        U_TEST_PRINT_LINE("%d reader(s) compiled, expected %d (overflow %p, expected %p).",
+                          (int) gMsgFilter.numReaders, (int) numCompiled,
+                          gMsgFilter.pOverflow, pOverflow);
+        passNotFail = false;
+    }
+
+    for (size_t x = 0; passNotFail &&
+         (x < sizeof(gMsgFilterMessage) / sizeof(gMsgFilterMessage[0])); x++) {
+        msgFilterIdSet(&(gMsgFilterMessage[x]), &messageId);
+        readersExpected = 0;
+        for (size_t y = 0; y < numCompiled; y++) {
+            if (uGnssPrivateMessageIdIsWanted(&messageId,
+                                              &(gMsgFilterReader[y].privateMessageId))) {
+                readersExpected |= 1UL << y;
+            }
+        }
+        readers = uGnssPrivateMsgFilterReaders(&gMsgFilter, &messageId);
+        if (readers != readersExpected) {
+            U_TEST_PRINT_LINE("message %d, readers 0x%08x, expected 0x%08x.",
+                              (int) x, (unsigned int) readers,
+                              (unsigned int) readersExpected);
+            passNotFail = false;
+        }
+    }
+
+    return passNotFail;
+}
+
 #endif // #ifndef __ZEPHYR__
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
+
+// Message receive callback for the latency test.
+static void latencyCallback(uDeviceHandle_t gnssHandle,
+                            const uGnssMessageId_t *pMessageId,
+                            int32_t errorCodeOrLength,
+                            void *pCallbackParam)
+{
+    int32_t latencyUs = uPortGetTickTimeUs() - gLatencySendTimeUs;
+
+    (void) gnssHandle;
+    (void) pCallbackParam;
+
+    if ((pMessageId->type != U_GNSS_PROTOCOL_UBX) ||
+        (pMessageId->id.ubx != 0x0107)) {
+        gLatencyErrorCode = 1;
+    } else if (errorCodeOrLength != 92 + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES) {
+        gLatencyErrorCode = 2;
+    }
+    gLatencyTotalUs += latencyUs;
+    if (latencyUs > gLatencyMaxUs) {
+        gLatencyMaxUs = latencyUs;
+    }
+    gLatencyCount++;
+}
+
+#endif // #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -892,8 +1122,188 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateUbx")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+/** Test that the compiled message filters used by the message
+ * receive task find the same readers as matching each reader in
+ * turn; not tested on Zephyr for the same reasons as the test
+ * gnssPrivateNmea.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateMsgFilter")
+{
+    size_t numWanted = sizeof(gMsgFilterWanted) / sizeof(gMsgFilterWanted[0]);
+    size_t numReaders;
+    uGnssPrivateMessageId_t messageId[sizeof(gMsgFilterMessage) / sizeof(gMsgFilterMessage[0])];
+    uGnssPrivateMsgReader_t *pReader;
+    volatile uint32_t readers = 0;
+    int32_t startTimeUs;
+    int32_t filterTimeUs;
+    int32_t listTimeUs;
+    int32_t resourceCount;
+
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // No readers at all
+    U_PORT_TEST_ASSERT(msgFilterCheck(0));
+
+    // Each wanted ID on its own, then all of them together
+    for (size_t x = 0; x < numWanted; x++) {
+        msgFilterIdSet(&(gMsgFilterWanted[x]), &(gMsgFilterReader[0].privateMessageId));
+        U_PORT_TEST_ASSERT(msgFilterCheck(1));
+    }
+    for (size_t x = 0; x < numWanted; x++) {
+        msgFilterIdSet(&(gMsgFilterWanted[x]), &(gMsgFilterReader[x].privateMessageId));
+    }
+    U_PORT_TEST_ASSERT(msgFilterCheck(numWanted));
+
+    // Random sets of readers, up to more than will fit
+    U_TEST_PRINT_LINE("checking %d random sets of message readers...",
+                      U_GNSS_PRIVATE_TEST_NUM_LOOPS);
+    for (size_t x = 0; x < U_GNSS_PRIVATE_TEST_NUM_LOOPS; x++) {
+        numReaders = rand() % (U_GNSS_PRIVATE_TEST_MSG_FILTER_READERS_MAX_NUM + 1);
+        for (size_t y = 0; y < numReaders; y++) {
+            msgFilterIdSet(&(gMsgFilterWanted[rand() % numWanted]),
+                           &(gMsgFilterReader[y].privateMessageId));
+        }
+        U_PORT_TEST_ASSERT(msgFilterCheck(numReaders));
+    }
+
+    // For information, time a full set of compiled readers against
+    // matching each reader in turn
+    for (size_t x = 0; x < U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM; x++) {
+        msgFilterIdSet(&(gMsgFilterWanted[x % numWanted]),
+                       &(gMsgFilterReader[x].privateMessageId));
+    }
+    U_PORT_TEST_ASSERT(msgFilterCheck(U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM));
+    for (size_t x = 0; x < sizeof(messageId) / sizeof(messageId[0]); x++) {
+        msgFilterIdSet(&(gMsgFilterMessage[x]), &(messageId[x]));
+    }
+    startTimeUs = uPortGetTickTimeUs();
+    for (size_t x = 0; x < U_GNSS_PRIVATE_TEST_MSG_FILTER_TIMING_LOOPS; x++) {
+        for (size_t y = 0; y < sizeof(messageId) / sizeof(messageId[0]); y++) {
+            readers |= uGnssPrivateMsgFilterReaders(&gMsgFilter, &(messageId[y]));
+        }
+    }
+    filterTimeUs = uPortGetTickTimeUs() - startTimeUs;
+    startTimeUs = uPortGetTickTimeUs();
+    for (size_t x = 0; x < U_GNSS_PRIVATE_TEST_MSG_FILTER_TIMING_LOOPS; x++) {
+        for (size_t y = 0; y < sizeof(messageId) / sizeof(messageId[0]); y++) {
+            pReader = &(gMsgFilterReader[0]);
+            for (size_t z = 0; pReader != NULL; z++) {
+                if (uGnssPrivateMessageIdIsWanted(&(messageId[y]), &(pReader->privateMessageId))) {
+                    readers |= 1UL << z;
+                }
+                pReader = pReader->pNext;
+            }
+        }
+    }
+    listTimeUs = uPortGetTickTimeUs() - startTimeUs;
+    U_TEST_PRINT_LINE("%d message(s) dispatched to %d readers: compiled filters took"
+                      " %d us, matching each reader took %d us.",
+                      (int) (U_GNSS_PRIVATE_TEST_MSG_FILTER_TIMING_LOOPS *
+                             (sizeof(messageId) / sizeof(messageId[0]))),
+                      U_GNSS_PRIVATE_MSG_FILTER_READERS_MAX_NUM, filterTimeUs, listTimeUs);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 #endif // #ifndef __ZEPHYR__
 
+#if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
+
+/** Measure the time from a UBX-NAV-PVT message arriving to the message
+ * receive callback being called, using a UART with a loop-back
+ * in place of a GNSS chip.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateMsgReceiveLatency")
+{
+    int32_t uartHandle;
+    uGnssTransportHandle_t transportHandle;
+    uDeviceHandle_t gnssHandle = NULL;
+    uGnssMessageId_t messageId;
+    int32_t asyncHandle;
+    // Room for a UBX-NAV-PVT message
+    char message[92 + U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES];
+    char body[92];
+    int32_t length;
+    int32_t startTimeMs;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    gLatencyCount = 0;
+    gLatencyTotalUs = 0;
+    gLatencyMaxUs = 0;
+    gLatencyErrorCode = 0;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uGnssInit() == 0);
+
+    uartHandle = uPortUartOpen(U_CFG_TEST_UART_A, U_CFG_TEST_BAUD_RATE, NULL,
+                               U_CFG_TEST_UART_BUFFER_LENGTH_BYTES,
+                               U_CFG_TEST_PIN_UART_A_TXD, U_CFG_TEST_PIN_UART_A_RXD,
+                               -1, -1);
+    U_PORT_TEST_ASSERT(uartHandle >= 0);
+    transportHandle.uart = uartHandle;
+    // Leave power alone so that nothing is sent to the "GNSS chip"
+    U_PORT_TEST_ASSERT(uGnssAdd(U_GNSS_MODULE_TYPE_M9, U_GNSS_TRANSPORT_UART,
+                                transportHandle, -1, true, &gnssHandle) == 0);
+    uGnssSetUbxMessagePrint(gnssHandle, false);
+
+    messageId.type = U_GNSS_PROTOCOL_UBX;
+    messageId.id.ubx = 0x0107;
+    asyncHandle = uGnssMsgReceiveStart(gnssHandle, &messageId, latencyCallback, NULL);
+    U_PORT_TEST_ASSERT(asyncHandle >= 0);
+
+    U_TEST_PRINT_LINE("sending %d UBX-NAV-PVT message(s) around the UART loop-back...",
+                      U_GNSS_PRIVATE_TEST_LATENCY_NUM_MESSAGES);
+    memset(body, 0, sizeof(body));
+    for (int32_t x = 0; (x < U_GNSS_PRIVATE_TEST_LATENCY_NUM_MESSAGES) &&
+         (gLatencyCount == x); x++) {
+        // Put the count in iTOW, just so that the messages differ
+        body[0] = (char) x;
+        length = uUbxProtocolEncode(0x01, 0x07, body, sizeof(body), message);
+        U_PORT_TEST_ASSERT(length == sizeof(message));
+        gLatencySendTimeUs = uPortGetTickTimeUs();
+        U_PORT_TEST_ASSERT(uPortUartWrite(uartHandle, message, length) == length);
+        startTimeMs = uPortGetTickTimeMs();
+        while ((gLatencyCount == x) && (uPortGetTickTimeMs() - startTimeMs < 1000)) {
+            uPortTaskBlock(1);
+        }
+        // Vary the gap so as not to fall into step with anything
+        uPortTaskBlock(10 + ((x * 7) % 40));
+    }
+
+    U_TEST_PRINT_LINE("%d message(s) received, average latency %d us, worst case %d us.",
+                      gLatencyCount, gLatencyCount > 0 ? gLatencyTotalUs / gLatencyCount : 0,
+                      gLatencyMaxUs);
+    U_PORT_TEST_ASSERT(gLatencyErrorCode == 0);
+    U_PORT_TEST_ASSERT(gLatencyCount == U_GNSS_PRIVATE_TEST_LATENCY_NUM_MESSAGES);
+#if U_GNSS_MSG_RECEIVE_TASK_DATA_EVENT
+    U_PORT_TEST_ASSERT(gLatencyTotalUs / gLatencyCount <= U_GNSS_PRIVATE_TEST_LATENCY_AVERAGE_MAX_US);
+#endif
+
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gnssHandle, asyncHandle) == 0);
+    uGnssRemove(gnssHandle);
+    uPortUartClose(uartHandle);
+    uGnssDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+#endif // #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -0,0 +1,606 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the GNSS record/replay API; no GNSS chip is
+ * required, a capture is generated, replayed through a GNSS instance
+ * and recorded as it goes.
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+# ifdef U_CFG_OVERRIDE
+#  include "u_cfg_override.h" // For a customer's configuration override
+# endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset(), memcpy(), memcmp()
+#include "stdio.h"     // snprintf()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_heap.h"
+#include "u_port_debug.h"
+
+#include "u_test_util_resource_check.h"
+
+#include "u_device_serial.h"
+
+#include "u_ubx_protocol.h"
+
+#include "u_gnss_module_type.h"
+#include "u_gnss_type.h"
+#include "u_gnss.h"
+#include "u_gnss_msg.h"
+#include "u_gnss_replay.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_GNSS_REPLAY_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_GNSS_REPLAY_TEST_NUM_MESSAGES
+/** The number of UBX-NAV-PVT messages in the capture, each one
+ * followed by an NMEA sentence.
+ */
+# define U_GNSS_REPLAY_TEST_NUM_MESSAGES 200
+#endif
+
+#ifndef U_GNSS_REPLAY_TEST_INTERVAL_MS
+/** The interval between UBX-NAV-PVT messages in the capture.
+ */
+# define U_GNSS_REPLAY_TEST_INTERVAL_MS 10
+#endif
+
+#ifndef U_GNSS_REPLAY_TEST_SPEED_PERCENT
+/** The speed of the paced replay.
+ */
+# define U_GNSS_REPLAY_TEST_SPEED_PERCENT 1000
+#endif
+
+#ifndef U_GNSS_REPLAY_TEST_TIMEOUT_MS
+/** How long to wait for a replay to complete; allow for the
+ * message receive task polling the transport, which is much
+ * slower than being woken by the data event.
+ */
+# define U_GNSS_REPLAY_TEST_TIMEOUT_MS 30000
+#endif
+
+/** The length of the body of a UBX-NAV-PVT message.
+ */
+#define U_GNSS_REPLAY_TEST_NAV_PVT_BODY_LENGTH 92
+
+/** Room for the largest record of the capture.
+ */
+#define U_GNSS_REPLAY_TEST_RECORD_MAX_LENGTH_BYTES (U_GNSS_REPLAY_TEST_NAV_PVT_BODY_LENGTH + \
+                                                    U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES)
+
+/** The maximum size of the capture: each UBX-NAV-PVT message is
+ * split across up to two records and is followed by an NMEA
+ * sentence in a record of its own.
+ */
+#define U_GNSS_REPLAY_TEST_CAPTURE_MAX_LENGTH_BYTES (U_GNSS_REPLAY_HEADER_LENGTH_BYTES + \
+                                                     (U_GNSS_REPLAY_TEST_NUM_MESSAGES * 3 * \
+                                                      (U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES + \
+                                                       U_GNSS_REPLAY_TEST_RECORD_MAX_LENGTH_BYTES)))
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** What the message receive callback has seen.
+ */
+typedef struct {
+    int32_t ubxCount;
+    int32_t nmeaCount;
+    int32_t errorCode;
+} uGnssReplayTestReceive_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The capture to replay.
+ */
+static char *gpCapture = NULL;
+
+/** Where the recording is put.
+ */
+static char *gpRecording = NULL;
+
+/** The number of bytes at gpRecording.
+ */
+static size_t gRecordingSize = 0;
+
+/** Buffer for the message receive callback.
+ */
+static char *gpMessage = NULL;
+
+/** What the message receive callback has seen.
+ */
+static uGnssReplayTestReceive_t gReceive;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Add a record to the capture, returning the new length.
+static size_t captureAdd(char *pCapture, size_t length, uint32_t timeMs,
+                         const char *pData, size_t size)
+{
+    uint32_t value;
+
+    value = uUbxProtocolUint32Encode(timeMs);
+    memcpy(pCapture + length, &value, sizeof(value));
+    value = uUbxProtocolUint32Encode((uint32_t) size);
+    memcpy(pCapture + length + sizeof(value), &value, sizeof(value));
+    length += U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES;
+    memcpy(pCapture + length, pData, size);
+
+    return length + size;
+}
+
+// Generate a capture of UBX-NAV-PVT messages, with the count in
+// iTOW, each followed by a GPTXT sentence, returning its length;
+// every third UBX-NAV-PVT message is split across two records,
+// as would happen if the data were read while it was arriving.
+static size_t captureGenerate(char *pCapture)
+{
+    size_t length = U_GNSS_REPLAY_HEADER_LENGTH_BYTES;
+    char body[U_GNSS_REPLAY_TEST_NAV_PVT_BODY_LENGTH];
+    char message[U_GNSS_REPLAY_TEST_RECORD_MAX_LENGTH_BYTES];
+    uint32_t value;
+    uint32_t timeMs;
+    int32_t messageLength;
+    char checksum;
+
+    memcpy(pCapture, U_GNSS_REPLAY_MAGIC, 8);
+    value = uUbxProtocolUint32Encode(U_GNSS_REPLAY_VERSION);
+    memcpy(pCapture + 8, &value, sizeof(value));
+    memset(body, 0, sizeof(body));
+    for (int32_t x = 0; x < U_GNSS_REPLAY_TEST_NUM_MESSAGES; x++) {
+        timeMs = x * U_GNSS_REPLAY_TEST_INTERVAL_MS;
+        value = uUbxProtocolUint32Encode((uint32_t) x);
+        memcpy(body, &value, sizeof(value));
+        messageLength = uUbxProtocolEncode(0x01, 0x07, body, sizeof(body), message);
+        if (x % 3 == 0) {
+            length = captureAdd(pCapture, length, timeMs, message, messageLength / 2);
+            length = captureAdd(pCapture, length, timeMs + 1, message + (messageLength / 2),
+                                messageLength - (messageLength / 2));
+        } else {
+            length = captureAdd(pCapture, length, timeMs, message, messageLength);
+        }
+        messageLength = snprintf(message, sizeof(message), "$GPTXT,01,01,02,replay %04d*",
+                                 (int) x);
+        checksum = 0;
+        for (int32_t y = 1; y < messageLength - 1; y++) {
+            checksum ^= message[y];
+        }
+        messageLength += snprintf(message + messageLength, sizeof(message) - messageLength,
+                                  "%02X\r\n", (unsigned int) (unsigned char) checksum);
+        length = captureAdd(pCapture, length, timeMs + 2, message, messageLength);
+    }
+
+    return length;
+}
+
+// Check that a capture is valid and copy just the data from it,
+// without the headers, into pData; returns the length of the data
+// or -1 if the capture is not valid.
+static int32_t captureData(const char *pCapture, size_t size, char *pData)
+{
+    int32_t dataLength = -1;
+    size_t offset = U_GNSS_REPLAY_HEADER_LENGTH_BYTES;
+    size_t length;
+
+    if ((size >= U_GNSS_REPLAY_HEADER_LENGTH_BYTES) &&
+        (memcmp(pCapture, U_GNSS_REPLAY_MAGIC, 8) == 0) &&
+        (uUbxProtocolUint32Decode(pCapture + 8) == U_GNSS_REPLAY_VERSION)) {
+        dataLength = 0;
+        while ((dataLength >= 0) &&
+               (offset + U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES <= size)) {
+            length = uUbxProtocolUint32Decode(pCapture + offset + 4);
+            offset += U_GNSS_REPLAY_RECORD_HEADER_LENGTH_BYTES;
+            if (length <= size - offset) {
+                memcpy(pData + dataLength, pCapture + offset, length);
+                dataLength += (int32_t) length;
+                offset += length;
+            } else {
+                dataLength = -1;
+            }
+        }
+        if (offset != size) {
+            dataLength = -1;
+        }
+    }
+
+    return dataLength;
+}
+
+// Callback for the recording.
+static void recordCallback(uDeviceHandle_t gnssHandle, const char *pData,
+                           size_t size, void *pCallbackParam)
+{
+    (void) gnssHandle;
+    (void) pCallbackParam;
+
+    if (gRecordingSize + size <= U_GNSS_REPLAY_TEST_CAPTURE_MAX_LENGTH_BYTES) {
+        memcpy(gpRecording + gRecordingSize, pData, size);
+    }
+    gRecordingSize += size;
+}
+
+// Message receive callback: check that the messages arrive in order.
+static void messageCallback(uDeviceHandle_t gnssHandle,
+                            const uGnssMessageId_t *pMessageId,
+                            int32_t errorCodeOrLength,
+                            void *pCallbackParam)
+{
+    uGnssReplayTestReceive_t *pReceive = (uGnssReplayTestReceive_t *) pCallbackParam;
+    char expected[32];
+    int32_t length;
+
+    if (errorCodeOrLength > U_GNSS_REPLAY_TEST_RECORD_MAX_LENGTH_BYTES) {
+        pReceive->errorCode = 1;
+    } else {
+        length = uGnssMsgReceiveCallbackRead(gnssHandle, gpMessage, errorCodeOrLength);
+        if (length != errorCodeOrLength) {
+            pReceive->errorCode = 2;
+        } else if (pMessageId->type == U_GNSS_PROTOCOL_UBX) {
+            if ((length != U_GNSS_REPLAY_TEST_RECORD_MAX_LENGTH_BYTES) ||
+                (uUbxProtocolUint32Decode(gpMessage + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES) !=
+                 (uint32_t) pReceive->ubxCount)) {
+                pReceive->errorCode = 3;
+            }
+            pReceive->ubxCount++;
+        } else if (pMessageId->type == U_GNSS_PROTOCOL_NMEA) {
+            snprintf(expected, sizeof(expected), "$GPTXT,01,01,02,replay %04d*",
+                     (int) pReceive->nmeaCount);
+            if (memcmp(gpMessage, expected, strlen(expected)) != 0) {
+                pReceive->errorCode = 4;
+            }
+            pReceive->nmeaCount++;
+        } else {
+            pReceive->errorCode = 5;
+        }
+    }
+}
+
+// Message receive callback that just counts, for when messages
+// are being flushed away.
+static void countCallback(uDeviceHandle_t gnssHandle,
+                          const uGnssMessageId_t *pMessageId,
+                          int32_t errorCodeOrLength,
+                          void *pCallbackParam)
+{
+    uGnssReplayTestReceive_t *pReceive = (uGnssReplayTestReceive_t *) pCallbackParam;
+
+    (void) gnssHandle;
+    (void) pMessageId;
+    (void) errorCodeOrLength;
+
+    pReceive->ubxCount++;
+}
+
+// Replay the capture through a GNSS instance, recording it as it
+// goes, and check that everything arrives; returns the time taken
+// in milliseconds.
+static int32_t replay(uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssTransportHandle_t transportHandle;
+    uDeviceHandle_t gnssHandle = NULL;
+    uGnssMessageId_t messageId;
+    char nmeaMatch[] = "GPTXT";
+    int32_t asyncHandleUbx;
+    int32_t asyncHandleNmea;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    bool isFinished;
+
+    memset(&gReceive, 0, sizeof(gReceive));
+    gRecordingSize = 0;
+
+    transportHandle.pDeviceSerial = pDeviceSerial;
+    // Leave power alone so that nothing is sent to the "GNSS chip"
+    U_PORT_TEST_ASSERT(uGnssAdd(U_GNSS_MODULE_TYPE_M9, U_GNSS_TRANSPORT_VIRTUAL_SERIAL,
+                                transportHandle, -1, true, &gnssHandle) == 0);
+    uGnssSetUbxMessagePrint(gnssHandle, false);
+
+    U_PORT_TEST_ASSERT(uGnssReplayRecordStart(gnssHandle, recordCallback, NULL) == 0);
+    U_PORT_TEST_ASSERT(uGnssReplayRecordStart(gnssHandle, recordCallback,
+                                              NULL) == (int32_t) U_ERROR_COMMON_BUSY);
+    U_PORT_TEST_ASSERT(gRecordingSize == U_GNSS_REPLAY_HEADER_LENGTH_BYTES);
+
+    messageId.type = U_GNSS_PROTOCOL_UBX;
+    messageId.id.ubx = 0x0107;
+    asyncHandleUbx = uGnssMsgReceiveStart(gnssHandle, &messageId, messageCallback, &gReceive);
+    U_PORT_TEST_ASSERT(asyncHandleUbx >= 0);
+    messageId.type = U_GNSS_PROTOCOL_NMEA;
+    messageId.id.pNmea = nmeaMatch;
+    asyncHandleNmea = uGnssMsgReceiveStart(gnssHandle, &messageId, messageCallback, &gReceive);
+    U_PORT_TEST_ASSERT(asyncHandleNmea >= 0);
+    // Nothing should have arrived until the replay is opened
+    uPortTaskBlock(100);
+    U_PORT_TEST_ASSERT(gRecordingSize == U_GNSS_REPLAY_HEADER_LENGTH_BYTES);
+    startTimeMs = uPortGetTickTimeMs();
+    U_PORT_TEST_ASSERT(pDeviceSerial->open(pDeviceSerial, NULL, 0) == 0);
+
+    while (((gReceive.ubxCount < U_GNSS_REPLAY_TEST_NUM_MESSAGES) ||
+            (gReceive.nmeaCount < U_GNSS_REPLAY_TEST_NUM_MESSAGES)) &&
+           (gReceive.errorCode == 0) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_GNSS_REPLAY_TEST_TIMEOUT_MS)) {
+        uPortTaskBlock(1);
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gnssHandle, asyncHandleNmea) == 0);
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gnssHandle, asyncHandleUbx) == 0);
+    U_PORT_TEST_ASSERT(uGnssReplayRecordStop(gnssHandle) == 0);
+    uGnssRemove(gnssHandle);
+    isFinished = uGnssReplayIsFinished(pDeviceSerial);
+    pDeviceSerial->close(pDeviceSerial);
+
+    U_TEST_PRINT_LINE("%d UBX message(s) and %d NMEA message(s) received in %d ms.",
+                      gReceive.ubxCount, gReceive.nmeaCount, durationMs);
+    U_PORT_TEST_ASSERT(gReceive.errorCode == 0);
+    U_PORT_TEST_ASSERT(gReceive.ubxCount == U_GNSS_REPLAY_TEST_NUM_MESSAGES);
+    U_PORT_TEST_ASSERT(gReceive.nmeaCount == U_GNSS_REPLAY_TEST_NUM_MESSAGES);
+    U_PORT_TEST_ASSERT(isFinished);
+
+    return durationMs;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Generate a capture, replay it as fast as possible and then
+ * paced, recording each time and checking that the recording
+ * contains the same data as the capture.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssReplayBasic")
+{
+    uDeviceSerial_t *pDeviceSerial;
+    size_t captureSize;
+    char *pCaptureData;
+    char *pRecordingData;
+    int32_t captureDataLength;
+    int32_t durationMs;
+    int32_t expectedMs;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uGnssInit() == 0);
+
+    gpCapture = (char *) pUPortMalloc(U_GNSS_REPLAY_TEST_CAPTURE_MAX_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(gpCapture != NULL);
+    gpRecording = (char *) pUPortMalloc(U_GNSS_REPLAY_TEST_CAPTURE_MAX_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(gpRecording != NULL);
+    gpMessage = (char *) pUPortMalloc(U_GNSS_REPLAY_TEST_RECORD_MAX_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(gpMessage != NULL);
+    captureSize = captureGenerate(gpCapture);
+    U_PORT_TEST_ASSERT(captureSize <= U_GNSS_REPLAY_TEST_CAPTURE_MAX_LENGTH_BYTES);
+    U_TEST_PRINT_LINE("capture is %d byte(s).", (int) captureSize);
+
+    // Things that are not a capture
+    U_PORT_TEST_ASSERT(pUGnssReplayCreate(NULL, captureSize, U_GNSS_REPLAY_SPEED_MAX) == NULL);
+    U_PORT_TEST_ASSERT(pUGnssReplayCreate(gpCapture, U_GNSS_REPLAY_HEADER_LENGTH_BYTES - 1,
+                                          U_GNSS_REPLAY_SPEED_MAX) == NULL);
+    U_PORT_TEST_ASSERT(pUGnssReplayCreate(gpCapture, captureSize, -1) == NULL);
+    gpCapture[0]++;
+    U_PORT_TEST_ASSERT(pUGnssReplayCreate(gpCapture, captureSize, U_GNSS_REPLAY_SPEED_MAX) == NULL);
+    gpCapture[0]--;
+    gpCapture[8]++;
+    U_PORT_TEST_ASSERT(pUGnssReplayCreate(gpCapture, captureSize, U_GNSS_REPLAY_SPEED_MAX) == NULL);
+    gpCapture[8]--;
+
+    // Replay as fast as possible
+    U_TEST_PRINT_LINE("replaying at maximum speed...");
+    pDeviceSerial = pUGnssReplayCreate(gpCapture, captureSize, U_GNSS_REPLAY_SPEED_MAX);
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    U_PORT_TEST_ASSERT(!uGnssReplayIsFinished(pDeviceSerial));
+    durationMs = replay(pDeviceSerial);
+    if (durationMs > 0) {
+        U_TEST_PRINT_LINE("%d messages/second.",
+                          (int) ((U_GNSS_REPLAY_TEST_NUM_MESSAGES * 2 * 1000) / durationMs));
+    }
+    uGnssReplayDelete(pDeviceSerial);
+
+    // The recording should contain the same data as the capture,
+    // though not necessarily in the same records
+    U_PORT_TEST_ASSERT(gRecordingSize <= U_GNSS_REPLAY_TEST_CAPTURE_MAX_LENGTH_BYTES);
+    pCaptureData = (char *) pUPortMalloc(captureSize);
+    U_PORT_TEST_ASSERT(pCaptureData != NULL);
+    pRecordingData = (char *) pUPortMalloc(gRecordingSize);
+    U_PORT_TEST_ASSERT(pRecordingData != NULL);
+    captureDataLength = captureData(gpCapture, captureSize, pCaptureData);
+    U_PORT_TEST_ASSERT(captureDataLength > 0);
+    U_PORT_TEST_ASSERT(captureData(gpRecording, gRecordingSize,
+                                   pRecordingData) == captureDataLength);
+    U_PORT_TEST_ASSERT(memcmp(pCaptureData, pRecordingData, captureDataLength) == 0);
+    uPortFree(pRecordingData);
+    uPortFree(pCaptureData);
+
+    // Replay at a multiple of real-time
+    U_TEST_PRINT_LINE("replaying at %d%% of real-time...", U_GNSS_REPLAY_TEST_SPEED_PERCENT);
+    pDeviceSerial = pUGnssReplayCreate(gpCapture, captureSize, U_GNSS_REPLAY_TEST_SPEED_PERCENT);
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    durationMs = replay(pDeviceSerial);
+    uGnssReplayDelete(pDeviceSerial);
+    // The last record is due at this time
+    expectedMs = (((U_GNSS_REPLAY_TEST_NUM_MESSAGES - 1) * U_GNSS_REPLAY_TEST_INTERVAL_MS) + 2) *
+                 U_GNSS_REPLAY_SPEED_REAL_TIME / U_GNSS_REPLAY_TEST_SPEED_PERCENT;
+    U_TEST_PRINT_LINE("expected to take at least %d ms.", expectedMs);
+    U_PORT_TEST_ASSERT(durationMs >= expectedMs);
+
+    uPortFree(gpMessage);
+    gpMessage = NULL;
+    uPortFree(gpRecording);
+    gpRecording = NULL;
+    uPortFree(gpCapture);
+    gpCapture = NULL;
+
+    uGnssDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Flush, stop/start message receive and stop/start recording
+ * while a replay at maximum speed is streaming: these hold the
+ * locks that the data event of the replay needs, so the replay
+ * must never call its event callback from within a read or from
+ * setting the callback.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssReplayFlush")
+{
+    uDeviceSerial_t *pDeviceSerial;
+    uGnssTransportHandle_t transportHandle;
+    uDeviceHandle_t gnssHandle = NULL;
+    uGnssMessageId_t messageId;
+    size_t captureSize;
+    int32_t asyncHandle;
+    int32_t startTimeMs;
+    int32_t numLoops = 0;
+    bool isFinished;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uGnssInit() == 0);
+
+    gpCapture = (char *) pUPortMalloc(U_GNSS_REPLAY_TEST_CAPTURE_MAX_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(gpCapture != NULL);
+    gpRecording = (char *) pUPortMalloc(U_GNSS_REPLAY_TEST_CAPTURE_MAX_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(gpRecording != NULL);
+    captureSize = captureGenerate(gpCapture);
+    U_PORT_TEST_ASSERT(captureSize <= U_GNSS_REPLAY_TEST_CAPTURE_MAX_LENGTH_BYTES);
+    memset(&gReceive, 0, sizeof(gReceive));
+    gRecordingSize = 0;
+
+    pDeviceSerial = pUGnssReplayCreate(gpCapture, captureSize, U_GNSS_REPLAY_SPEED_MAX);
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    transportHandle.pDeviceSerial = pDeviceSerial;
+    U_PORT_TEST_ASSERT(uGnssAdd(U_GNSS_MODULE_TYPE_M9, U_GNSS_TRANSPORT_VIRTUAL_SERIAL,
+                                transportHandle, -1, true, &gnssHandle) == 0);
+    uGnssSetUbxMessagePrint(gnssHandle, false);
+    messageId.type = U_GNSS_PROTOCOL_UBX;
+    messageId.id.ubx = 0x0107;
+    asyncHandle = uGnssMsgReceiveStart(gnssHandle, &messageId, countCallback, &gReceive);
+    U_PORT_TEST_ASSERT(asyncHandle >= 0);
+
+    U_TEST_PRINT_LINE("flushing while replaying at maximum speed...");
+    startTimeMs = uPortGetTickTimeMs();
+    U_PORT_TEST_ASSERT(pDeviceSerial->open(pDeviceSerial, NULL, 0) == 0);
+    while (!uGnssReplayIsFinished(pDeviceSerial) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_GNSS_REPLAY_TEST_TIMEOUT_MS)) {
+        uGnssMsgReceiveFlush(gnssHandle, true);
+        // Stopping the only reader stops the message receive task,
+        // starting it again sets the event callback of the replay
+        U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gnssHandle, asyncHandle) == 0);
+        asyncHandle = uGnssMsgReceiveStart(gnssHandle, &messageId, countCallback, &gReceive);
+        U_PORT_TEST_ASSERT(asyncHandle >= 0);
+        U_PORT_TEST_ASSERT(uGnssReplayRecordStart(gnssHandle, recordCallback, NULL) == 0);
+        uPortTaskBlock(1);
+        U_PORT_TEST_ASSERT(uGnssReplayRecordStop(gnssHandle) == 0);
+        numLoops++;
+    }
+    isFinished = uGnssReplayIsFinished(pDeviceSerial);
+    U_TEST_PRINT_LINE("%d loop(s) in %d ms, %d UBX message(s) received.", numLoops,
+                      (int) (uPortGetTickTimeMs() - startTimeMs), gReceive.ubxCount);
+
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gnssHandle, asyncHandle) == 0);
+    uGnssRemove(gnssHandle);
+    pDeviceSerial->close(pDeviceSerial);
+    uGnssReplayDelete(pDeviceSerial);
+    U_PORT_TEST_ASSERT(isFinished);
+
+    uPortFree(gpRecording);
+    gpRecording = NULL;
+    uPortFree(gpCapture);
+    gpCapture = NULL;
+
+    uGnssDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssReplayCleanUp")
+{
+    uPortFree(gpMessage);
+    gpMessage = NULL;
+    uPortFree(gpRecording);
+    gpRecording = NULL;
+    uPortFree(gpCapture);
+    gpCapture = NULL;
+
+    uGnssDeinit();
+    uPortDeinit();
+    // Printed for information: asserting happens in the postamble
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+}
+
+// End of file
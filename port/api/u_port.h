@@ -164,6 +164,20 @@ void uPortDeinit();
  */
 int32_t uPortGetTickTimeMs();
 
+/** Get the current OS tick converted to a time in microseconds,
+ * intended for time-stamping trace events.  The same rules apply
+ * as for uPortGetTickTimeMs() except that, of course, this will
+ * wrap much sooner; treat the return value as an unsigned 32-bit
+ * quantity and compare values by subtraction.
+ *
+ * It is NOT a requirement that this API is implemented: where it
+ * is not implemented a weakly-linked default function will return
+ * uPortGetTickTimeMs() multiplied by 1000.
+ *
+ * @return the current OS tick converted to microseconds.
+ */
+int32_t uPortGetTickTimeUs();
+
 /** Get the heap high watermark, the minimum amount of heap
  * free, ever.
  *
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_PORT_CODEC_H_
+#define _U_PORT_CODEC_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __port __Port
+ *  @{
+ */
+
+/** @file
+ * @brief Porting layer for the bulk of ASCII hex encoding and
+ * decoding, as called by uBinToHex() and uHexToBin(), which do
+ * whatever is left over with look-up tables.  These functions are
+ * thread-safe.  A default implementation is provided in
+ * u_port_codec.c; you may override it in your port code.
+ *
+ * The default implementation does nothing unless U_CFG_CODEC_VECTOR
+ * is defined, in which case it works on several bytes at once: with
+ * SSE2 if the compiler is targeting it (__SSE2__ is defined), else
+ * with NEON if the compiler is targeting that (__ARM_NEON is
+ * defined), else eight characters at a time in a uint64_t.  Whether
+ * any of these is faster than the look-up tables alone depends on
+ * your processor and your compiler settings, hence the choice is
+ * left to you.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Encode binary as upper case ASCII hex, as uBinToHex() does, but
+ * only as far as is convenient: for instance a vector
+ * implementation might stop at the last whole vector.
+ *
+ * @param[in] pBin      the binary data; must not be NULL if
+ *                      binLength is greater than zero.
+ * @param binLength     the number of bytes at pBin.
+ * @param[out] pHex     a place to put the ASCII hex, must have room
+ *                      for binLength * 2 characters; no terminator
+ *                      is added.
+ * @return              the number of bytes from the start of pBin
+ *                      that have been encoded, zero if none.
+ */
+size_t uPortCodecBinToHex(const char *pBin, size_t binLength, char *pHex);
+
+/** Decode ASCII hex, upper or lower case, to binary, as uHexToBin()
+ * does, but only as far as is convenient; this must stop before
+ * any character that is not hex but need not stop exactly there.
+ *
+ * @param[in] pHex      the ASCII hex; must not be NULL if hexLength
+ *                      is greater than one.
+ * @param hexLength     the number of characters at pHex.
+ * @param[out] pBin     a place to put the binary, must have room for
+ *                      hexLength / 2 bytes.
+ * @return              the number of bytes written to pBin, which
+ *                      is half the number of characters from the
+ *                      start of pHex that have been decoded, zero
+ *                      if none.
+ */
+size_t uPortCodecHexToBin(const char *pHex, size_t hexLength, char *pBin);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_PORT_CODEC_H_
+
+// End of file
@@ -87,6 +87,26 @@
  * the task.  This is a cooperative process: your function
  * must have emptied the queue and exited for shut-down to
  * complete.
+ *
+ * If U_CFG_EVENT_QUEUE_EXECUTOR is defined then an event queue
+ * opened with a stack size no larger than
+ * #U_PORT_EVENT_QUEUE_EXECUTOR_STACK_SIZE_BYTES does not get a
+ * task of its own: it is run by a shared executor, a pool of
+ * #U_PORT_EVENT_QUEUE_EXECUTOR_NUM_WORKERS tasks which is started
+ * when the first such event queue is opened and stopped when the
+ * last one is freed.  Each worker keeps a deque of the event
+ * queues that have events waiting; an idle worker steals from
+ * the others.  The events of any one event queue are still
+ * handled one at a time and in the order they were sent, but
+ * the priority passed to uPortEventQueueOpen() is ignored (the
+ * workers run at #U_PORT_EVENT_QUEUE_EXECUTOR_PRIORITY) and an
+ * event function that blocks occupies a worker while it does so:
+ * there must be more workers than event functions that may block
+ * waiting for each other.  This reduces the number of tasks, and
+ * hence the stack memory and context switches, where many event
+ * queues are open, e.g. on a Linux gateway driving several
+ * modules.  It requires uPortQueueTryReceive() to be implemented
+ * on the platform.
  */
 
 #ifdef __cplusplus
@@ -124,6 +144,37 @@ extern "C" {
                            U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES
 #endif
 
+#ifndef U_PORT_EVENT_QUEUE_EXECUTOR_NUM_WORKERS
+/** Only relevant if U_CFG_EVENT_QUEUE_EXECUTOR is defined: the
+ * number of tasks in the shared executor.
+ */
+# define U_PORT_EVENT_QUEUE_EXECUTOR_NUM_WORKERS 3
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_EXECUTOR_STACK_SIZE_BYTES
+/** Only relevant if U_CFG_EVENT_QUEUE_EXECUTOR is defined: the
+ * stack size of each task in the shared executor; an event queue
+ * that asks for a larger stack gets a task of its own.
+ */
+# define U_PORT_EVENT_QUEUE_EXECUTOR_STACK_SIZE_BYTES (1024 * 4)
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_EXECUTOR_PRIORITY
+/** Only relevant if U_CFG_EVENT_QUEUE_EXECUTOR is defined: the
+ * priority of the tasks in the shared executor.
+ */
+# define U_PORT_EVENT_QUEUE_EXECUTOR_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+#ifndef U_PORT_EVENT_QUEUE_EXECUTOR_BATCH_SIZE
+/** Only relevant if U_CFG_EVENT_QUEUE_EXECUTOR is defined: the
+ * maximum number of events of one event queue that a worker of
+ * the shared executor handles before moving on, so that a busy
+ * event queue does not hog a worker.
+ */
+# define U_PORT_EVENT_QUEUE_EXECUTOR_BATCH_SIZE 8
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -39,9 +39,10 @@
  * will add guards either end of a memory block and check them
  * when it is free'd (U_ASSERT() will be called with false if
  * a guard is corrupted), and will also log each allocation so that
- * they can be printed with uPortHeapDump().  Note that monitoring
- * will require at least 28 additional bytes of heap storage per
- * heap allocation.
+ * they can be printed with uPortHeapDump(), and keep per call-site
+ * statistics that can be printed with uPortHeapDumpSitesCsv().  Note
+ * that monitoring will require at least 36 additional bytes of heap
+ * storage per heap allocation.
  */
 
 #ifdef __cplusplus
@@ -123,6 +124,20 @@ void uPortFree(void *pMemory);
  */
 int32_t uPortHeapAllocCount();
 
+/** Get the total number of successful pUPortMalloc() calls made
+ * since start-up, irrespective of whether they have since been
+ * free'd; used when testing to check that a code path makes no
+ * heap allocations.
+ *
+ * You do not need to implement this function: the #U_WEAK
+ * implementation returns the count kept by the #U_WEAK
+ * implementation of pUPortMalloc(), hence if you implement
+ * pUPortMalloc() yourself you should implement this also.
+ *
+ * @return   the number of successful pUPortMalloc() calls.
+ */
+int32_t uPortHeapMallocCount();
+
 /** Used ONLY for heap accounting: this function allows the
  * code to indicate that a heap allocation has been made that
  * will NEVER be free'd.
@@ -152,6 +167,18 @@ int32_t uPortHeapPerpetualAllocCount();
  */
 int32_t uPortHeapDump(const char *pPrefix);
 
+/** Print out, as CSV, statistics for each place in the code that
+ * has called pUPortMalloc() since start-up: file, line, the number
+ * of allocations made, the number outstanding, the bytes outstanding
+ * and the most bytes that have been outstanding; only useful if
+ * U_CFG_HEAP_MONITOR is defined.  The first line printed is a
+ * header naming the columns.
+ *
+ * @param[in] pPrefix  print this before each line; may be NULL.
+ * @return             the number of call sites printed.
+ */
+int32_t uPortHeapDumpSitesCsv(const char *pPrefix);
+
 /** Initialise heap monitoring: you do NOT need to call this, it
  * is called internally by the porting layer if U_CFG_HEAP_MONITOR
  * is defined.
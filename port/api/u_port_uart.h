@@ -89,6 +89,14 @@ extern "C" {
  * TYPES
  * -------------------------------------------------------------- */
 
+/** A segment of data for uPortUartWriteV(), in the style of
+ * a POSIX struct iovec.
+ */
+typedef struct {
+    const void *pData;  /**< a pointer to the data in this segment. */
+    size_t sizeBytes;   /**< the number of bytes at pData. */
+} uPortUartSegment_t;
+
 /* ----------------------------------------------------------------
  * FUNCTIONS
  * -------------------------------------------------------------- */
@@ -252,6 +260,28 @@ int32_t uPortUartRead(int32_t handle, void *pBuffer,
 int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
                        size_t sizeBytes);
 
+/** Write a number of segments of data to the given UART interface
+ * as a single operation, a "scatter-gather" write; this allows
+ * a header, a body and a trailer, for instance, to be sent without
+ * first having to be copied into a single buffer.  Will block until
+ * all of the data has been written or an error has occurred.
+ * Segments with a sizeBytes of zero are skipped.
+ *
+ * You do not need to implement this function: where it is not
+ * implemented a #U_WEAK implementation provided in
+ * u_port_uart_default.c will call uPortUartWrite() for each
+ * segment in turn.
+ *
+ * @param handle        the handle of the UART instance.
+ * @param[in] pSegments a pointer to an array of segments to send.
+ * @param numSegments   the number of entries in pSegments.
+ * @return              the number of bytes sent or negative
+ *                      error code.
+ */
+int32_t uPortUartWriteV(int32_t handle,
+                        const uPortUartSegment_t *pSegments,
+                        size_t numSegments);
+
 /** Set a callback to be called when a UART event occurs.
  * pFunction will be called asynchronously in its own task,
  * for which the stack size and priority can be specified.
@@ -259,6 +259,22 @@ int32_t uPortQueueReceive(const uPortQueueHandle_t queueHandle,
     return errorCode;
 }
 
+// Receive from the given queue from an interrupt.
+int32_t uPortQueueReceiveIrq(const uPortQueueHandle_t queueHandle,
+                             void *pEventData)
+{
+    int32_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((queueHandle != NULL) && (pEventData != NULL)) {
+        errorCode = U_ERROR_COMMON_PLATFORM;
+        if (tx_queue_receive((TX_QUEUE *)queueHandle, pEventData, TX_NO_WAIT) == 0) {
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    return errorCode;
+}
+
 // Receive from the given queue, with a wait time.
 int32_t uPortQueueTryReceive(const uPortQueueHandle_t queueHandle,
                              int32_t waitMs, void *pEventData)
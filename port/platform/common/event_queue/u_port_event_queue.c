@@ -24,6 +24,27 @@
  * protection) but, most importantly, means that no loop is required
  * to find a queue, ensuring the lowest possible latency so that
  * send-to-queue can safely be called from an interrupt.
+ *
+ * Design note: the parameter blocks are not carried on the OS queue
+ * itself, they are written into a pool of slots which is allocated
+ * when the event queue is opened; the OS queue carries only the index
+ * of a slot and a second OS queue holds the indexes of the free
+ * slots.  This way sending an event involves no heap allocation and
+ * only the parameter bytes actually sent are copied.
+ *
+ * Design note: with U_CFG_EVENT_QUEUE_EXECUTOR defined, an event
+ * queue may instead be run by the shared executor.  Each event queue
+ * keeps a count of the events sent to it that have not yet been
+ * handled: the sender that takes the count from zero schedules the
+ * event queue and the worker that takes it back to zero gives it up,
+ * so an event queue is only ever in one place, and handled by one
+ * worker, at a time, which keeps its events in order.  A scheduled
+ * event queue is a handle either on the injection queue, an OS queue
+ * which anyone (including an interrupt) can send to, or on the deque
+ * of a worker; a worker only pushes onto and takes from the bottom
+ * of its own deque (Chase-Lev) while idle workers steal from the top
+ * of the others.  Since each event queue can be scheduled only once,
+ * the deques and the injection queue can never overflow.
  */
 
 #ifdef U_CFG_OVERRIDE
@@ -34,6 +55,8 @@
 #include "stdbool.h"
 #include "string.h"    // memcpy(), memset()
 
+#include "u_compiler.h" // U_ATOMIC_XXX()
+
 #include "u_cfg_os_platform_specific.h"
 #include "u_error_common.h"
 #include "u_assert.h"
@@ -52,6 +75,44 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The index sent on the OS queue to tell the event task to exit;
+ * also put on the free slot queue to wake senders waiting for a
+ * free slot when the event queue is being freed.
+ */
+#define U_PORT_EVENT_QUEUE_SLOT_EXIT_NOW -1
+
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+# ifdef _MSC_VER
+// The deques of the shared executor rely on the ordering of
+// U_ATOMIC_LOAD_ACQUIRE() and U_ATOMIC_STORE_RELEASE(), which
+// MSVC does not provide, see the note against them in u_compiler.h
+#  error U_CFG_EVENT_QUEUE_EXECUTOR is not supported by MSVC
+# endif
+
+/** The length of the deque of each worker of the shared executor,
+ * which must be a power of two and at least
+ * #U_PORT_EVENT_QUEUE_MAX_NUM.
+ */
+# define U_PORT_EVENT_QUEUE_EXECUTOR_DEQUE_LENGTH 32
+
+# if (U_PORT_EVENT_QUEUE_MAX_NUM > U_PORT_EVENT_QUEUE_EXECUTOR_DEQUE_LENGTH)
+#  error U_PORT_EVENT_QUEUE_EXECUTOR_DEQUE_LENGTH must be at least U_PORT_EVENT_QUEUE_MAX_NUM
+# endif
+
+/** Returned by the deque functions when there is nothing to take.
+ */
+# define U_PORT_EVENT_QUEUE_EXECUTOR_NONE -1
+
+/** Sent on the injection queue to wake an idle worker so that
+ * it can steal from the others.
+ */
+# define U_PORT_EVENT_QUEUE_EXECUTOR_WAKE -2
+
+/** Sent on the injection queue to tell a worker to exit.
+ */
+# define U_PORT_EVENT_QUEUE_EXECUTOR_EXIT -3
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -62,25 +123,56 @@ typedef struct uEventQueue_t {
     bool closed; /** true if this event queue has been closed. */
     void (*pFunction)(void *, size_t); /** The function to be called. */
     int32_t handle;            /** Handle for this event queue. */
-    uPortQueueHandle_t queue; /** Handle for the OS queue. */
-    size_t paramMaxLengthBytes; /** Max length of an item on this OS queue. */
+    uPortQueueHandle_t queue; /** Handle for the OS queue, carries slot indexes. */
+    uPortQueueHandle_t freeSlotQueue; /** Handle for the OS queue of free slot indexes. */
+    char *pSlots; /** The slots: a control/size word followed by a parameter block. */
+    size_t slotSizeBytes; /** The size of each slot. */
+    size_t paramMaxLengthBytes; /** Max length of a parameter block on this event queue. */
     uPortTaskHandle_t task; /** Handle for the OS task. */
     uPortMutexHandle_t taskRunningMutex; /** Mutex to determine if task has exited. */
+    bool freeing; /** true while this event queue is being freed. */
+    int32_t numSenders; /** The number of calls to uPortEventQueueSend() using
+                            this event queue, protected by gMutex. */
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+    bool shared; /** true if this event queue is run by the shared executor. */
+    int32_t numPending; /** The number of events sent and not yet handled. */
+    int32_t exited; /** Set to 1 by the worker when it has handled the exit slot. */
+    uPortTaskHandle_t runningTask; /** The worker running this event queue, else NULL. */
+#endif
 } uEventQueue_t;
 
-/** The control/size word, prefixed to the parameter block sent to
- * the queue. Negative values are a control word, else this is the
- * size of the parameter block which follows.
+/** The control/size word at the start of a slot, giving the size
+ * of the parameter block which follows; the event task is told to
+ * exit by sending it #U_PORT_EVENT_QUEUE_SLOT_EXIT_NOW in place of
+ * a slot index.
  */
 typedef enum {
 //lint -esym(749, uEventQueueControlOrSize_t::U_EVENT_CONTROL_FORCE_INT32) Suppress enum not referenced
     U_EVENT_CONTROL_FORCE_INT32 = 0x7FFFFFFF, /* Force this enum to always
                                                * be 32 bit so that it can
                                                * also be used as a size. */
-    U_EVENT_CONTROL_NONE = 0,
-    U_EVENT_CONTROL_EXIT_NOW = -1
+    U_EVENT_CONTROL_NONE = 0
 } uEventQueueControlOrSize_t;
 
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+/** A work-stealing deque of event queue handles: the owning worker
+ * pushes and takes at the bottom, other workers steal from the top.
+ */
+typedef struct {
+    uint32_t top;
+    uint32_t bottom;
+    int32_t handle[U_PORT_EVENT_QUEUE_EXECUTOR_DEQUE_LENGTH];
+} uEventQueueDeque_t;
+
+/** A worker of the shared executor.
+ */
+typedef struct {
+    uPortTaskHandle_t task; /** Handle for the OS task. */
+    uPortMutexHandle_t taskRunningMutex; /** Mutex to determine if task has exited. */
+    uEventQueueDeque_t deque; /** The event queues scheduled on this worker. */
+} uEventQueueWorker_t;
+#endif
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -93,19 +185,63 @@ static uPortMutexHandle_t gMutex = NULL;
  */
 static uEventQueue_t *gpEventQueue[U_PORT_EVENT_QUEUE_MAX_NUM];
 
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+/** The workers of the shared executor.
+ */
+static uEventQueueWorker_t gWorker[U_PORT_EVENT_QUEUE_EXECUTOR_NUM_WORKERS];
+
+/** The injection queue of the shared executor, NULL if the
+ * shared executor is not running.
+ */
+static uPortQueueHandle_t gExecutorQueue = NULL;
+
+/** The number of event queues using the shared executor.
+ */
+static size_t gExecutorNumEventQueues = 0;
+
+/** The number of workers waiting on the injection queue.
+ */
+static int32_t gExecutorNumIdle = 0;
+
+/** Set to 1 while a wake is waiting on the injection queue, so
+ * that there is never more than one.
+ */
+static int32_t gExecutorWakePending = 0;
+#endif
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Call the user function with the parameter block in the given
+// slot and then free the slot.
+static void eventQueueCall(const uEventQueue_t *pEventQueue, int32_t slot)
+{
+    char *pSlot = pEventQueue->pSlots + (pEventQueue->slotSizeBytes * slot);
+    uEventQueueControlOrSize_t controlOrSize;
+
+    // Call the user function with the parameter block,
+    // skipping the "control or size" word at the start
+    // and passing it in instead as the size parameter
+    memcpy(&controlOrSize, pSlot, sizeof(controlOrSize));
+    if ((int32_t) controlOrSize > 0) {
+        pEventQueue->pFunction((void *) (pSlot + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES),
+                               // Cast in two stages to keep Lint happy
+                               (size_t) (int32_t) controlOrSize);
+    } else {
+        pEventQueue->pFunction(NULL, 0);
+    }
+    // Done with the slot: there is always room on the
+    // free slot queue so this will not block
+    uPortQueueSend(pEventQueue->freeSlotQueue, &slot);
+}
+
 // Run the user function.  This will be run multiple times in a
 // task of its own.
 static void eventQueueTask(void *pParam)
 {
     uEventQueue_t *pEventQueue = (uEventQueue_t *) pParam;
-    char param[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES +
-               U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES];
-    uEventQueueControlOrSize_t *pControlOrSize = (uEventQueueControlOrSize_t *)
-                                                 & (param[0]);
+    int32_t slot = 0;
 
     U_PORT_MUTEX_LOCK(pEventQueue->taskRunningMutex);
 #if defined(__NEWLIB__) && defined(_REENT_SMALL) && \
@@ -122,80 +258,530 @@ static void eventQueueTask(void *pParam)
     uPortLog("");
 #endif
 
-    *pControlOrSize = U_EVENT_CONTROL_NONE;
     // Continue until we're told to exit
-    while (*pControlOrSize != U_EVENT_CONTROL_EXIT_NOW) {
-        if (uPortQueueReceive(pEventQueue->queue, param) == 0) {
-            // If this is not a control message, call the
-            // user function with the parameter block,
-            // skipping the "control or size" word at the
-            // start and passing it in instead as the size
-            // parameter
-            if ((int32_t) *pControlOrSize >= 0) {
-                if ((int32_t) *pControlOrSize > 0) {
-                    pEventQueue->pFunction((void *) & (param[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES]),
-                                           // Cast in two stages to keep Lint happy
-                                           (size_t) (int32_t) *pControlOrSize);
-                } else {
-                    pEventQueue->pFunction(NULL, 0);
+    while (slot != U_PORT_EVENT_QUEUE_SLOT_EXIT_NOW) {
+        if ((uPortQueueReceive(pEventQueue->queue, &slot) == 0) &&
+            (slot != U_PORT_EVENT_QUEUE_SLOT_EXIT_NOW)) {
+            eventQueueCall(pEventQueue, slot);
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pEventQueue->taskRunningMutex);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+
+// Add delta to an int32_t atomically, returning the value it had
+// before; done with compare-and-swap since the return value of
+// U_ATOMIC_INCREMENT() differs between compilers.
+static int32_t atomicAdd(int32_t *pValue, int32_t delta)
+{
+    int32_t value;
+
+    do {
+        value = U_ATOMIC_GET(pValue);
+    } while (!U_ATOMIC_COMPARE_AND_SWAP(pValue, value, value + delta));
+
+    return value;
+}
+
+// Push an event queue handle onto the bottom of a deque; only
+// the worker that owns the deque may call this.
+static void dequePush(uEventQueueDeque_t *pDeque, int32_t handle)
+{
+    uint32_t bottom = pDeque->bottom;
+
+    pDeque->handle[bottom & (U_PORT_EVENT_QUEUE_EXECUTOR_DEQUE_LENGTH - 1)] = handle;
+    // The handle must be visible before the new bottom is
+    U_ATOMIC_STORE_RELEASE(&(pDeque->bottom), bottom + 1);
+}
+
+// Take an event queue handle from the bottom of a deque; only
+// the worker that owns the deque may call this.
+static int32_t dequeTake(uEventQueueDeque_t *pDeque)
+{
+    int32_t handle = U_PORT_EVENT_QUEUE_EXECUTOR_NONE;
+    uint32_t bottom = pDeque->bottom - 1;
+    uint32_t top;
+
+    // Claim the bottom entry before looking at the top, which
+    // a thief may be moving
+    U_ATOMIC_STORE_RELEASE(&(pDeque->bottom), bottom);
+    U_ATOMIC_MEMORY_BARRIER();
+    top = U_ATOMIC_GET(&(pDeque->top));
+    if ((int32_t) (bottom - top) >= 0) {
+        handle = pDeque->handle[bottom & (U_PORT_EVENT_QUEUE_EXECUTOR_DEQUE_LENGTH - 1)];
+        if (bottom == top) {
+            // The last entry: race any thief for it
+            if (!U_ATOMIC_COMPARE_AND_SWAP(&(pDeque->top), top, top + 1)) {
+                handle = U_PORT_EVENT_QUEUE_EXECUTOR_NONE;
+            }
+            U_ATOMIC_STORE_RELEASE(&(pDeque->bottom), bottom + 1);
+        }
+    } else {
+        // Empty
+        U_ATOMIC_STORE_RELEASE(&(pDeque->bottom), bottom + 1);
+    }
+
+    return handle;
+}
+
+// Steal an event queue handle from the top of another worker's
+// deque; gives up, rather than retrying, if another thief or the
+// owner gets there first.
+static int32_t dequeSteal(uEventQueueDeque_t *pDeque)
+{
+    int32_t handle = U_PORT_EVENT_QUEUE_EXECUTOR_NONE;
+    uint32_t top;
+    uint32_t bottom;
+
+    top = U_ATOMIC_LOAD_ACQUIRE(&(pDeque->top));
+    U_ATOMIC_MEMORY_BARRIER();
+    bottom = U_ATOMIC_LOAD_ACQUIRE(&(pDeque->bottom));
+    if ((int32_t) (bottom - top) > 0) {
+        handle = pDeque->handle[top & (U_PORT_EVENT_QUEUE_EXECUTOR_DEQUE_LENGTH - 1)];
+        if (!U_ATOMIC_COMPARE_AND_SWAP(&(pDeque->top), top, top + 1)) {
+            handle = U_PORT_EVENT_QUEUE_EXECUTOR_NONE;
+        }
+    }
+
+    return handle;
+}
+
+// Steal an event queue handle from any worker other than the
+// given one, starting with the next one along.
+static int32_t executorSteal(size_t index)
+{
+    int32_t handle = U_PORT_EVENT_QUEUE_EXECUTOR_NONE;
+
+    for (size_t x = 1; (handle == U_PORT_EVENT_QUEUE_EXECUTOR_NONE) &&
+         (x < sizeof(gWorker) / sizeof(gWorker[0])); x++) {
+        handle = dequeSteal(&(gWorker[(index + x) % (sizeof(gWorker) / sizeof(gWorker[0]))].deque));
+    }
+
+    return handle;
+}
+
+// Return the worker that is the current task, NULL if the
+// current task is not a worker.
+static uEventQueueWorker_t *pExecutorWorkerGet()
+{
+    uEventQueueWorker_t *pWorker = NULL;
+
+    for (size_t x = 0; (pWorker == NULL) &&
+         (x < sizeof(gWorker) / sizeof(gWorker[0])); x++) {
+        if ((gWorker[x].task != NULL) && uPortTaskIsThis(gWorker[x].task)) {
+            pWorker = &(gWorker[x]);
+        }
+    }
+
+    return pWorker;
+}
+
+// If there is an idle worker, wake one so that it can steal work.
+static void executorWake()
+{
+    int32_t handle = U_PORT_EVENT_QUEUE_EXECUTOR_WAKE;
+
+    // The push on to the deque must be visible before
+    // gExecutorNumIdle is read, see executorTask()
+    U_ATOMIC_MEMORY_BARRIER();
+    if ((U_ATOMIC_GET(&gExecutorNumIdle) > 0) &&
+        U_ATOMIC_COMPARE_AND_SWAP(&gExecutorWakePending, 0, 1)) {
+        uPortQueueSend(gExecutorQueue, &handle);
+    }
+}
+
+// Note that an event has been sent to an event queue that is run
+// by the shared executor and, if the event queue is not already
+// scheduled, schedule it: on the deque of the current task if that
+// is a worker, else on the injection queue.
+static void executorSchedule(uEventQueue_t *pEventQueue, bool isIrq)
+{
+    uEventQueueWorker_t *pWorker = NULL;
+    int32_t handle = pEventQueue->handle;
+
+    if (atomicAdd(&(pEventQueue->numPending), 1) == 0) {
+        if (!isIrq) {
+            pWorker = pExecutorWorkerGet();
+        }
+        if (pWorker != NULL) {
+            dequePush(&(pWorker->deque), handle);
+            executorWake();
+        } else if (isIrq) {
+            uPortQueueSendIrq(gExecutorQueue, &handle);
+        } else {
+            uPortQueueSend(gExecutorQueue, &handle);
+        }
+    }
+}
+
+// Handle the events of an event queue, until there are none left
+// or the batch size is reached, in which case the event queue is
+// put to the back of the injection queue to give others a chance.
+static void executorRun(const uEventQueueWorker_t *pWorker, int32_t handle)
+{
+    uEventQueue_t *pEventQueue = gpEventQueue[handle];
+    int32_t slot;
+    size_t count = 0;
+    bool done = (pEventQueue == NULL);
+
+    while (!done) {
+        // Since numPending is only incremented once an event is
+        // on the OS queue, this will not block
+        if (uPortQueueReceive(pEventQueue->queue, &slot) == 0) {
+            if (slot == U_PORT_EVENT_QUEUE_SLOT_EXIT_NOW) {
+                // The event queue may be freed as soon as this is set
+                U_ATOMIC_STORE_RELEASE(&(pEventQueue->exited), 1);
+                done = true;
+            } else {
+                pEventQueue->runningTask = pWorker->task;
+                eventQueueCall(pEventQueue, slot);
+                pEventQueue->runningTask = NULL;
+                count++;
+                if (atomicAdd(&(pEventQueue->numPending), -1) == 1) {
+                    // That was the last one, the event queue is no
+                    // longer ours
+                    done = true;
+                } else if (count >= U_PORT_EVENT_QUEUE_EXECUTOR_BATCH_SIZE) {
+                    uPortQueueSend(gExecutorQueue, &handle);
+                    done = true;
                 }
             }
         }
     }
+}
 
-    U_PORT_MUTEX_UNLOCK(pEventQueue->taskRunningMutex);
+// A worker of the shared executor.
+static void executorTask(void *pParam)
+{
+    uEventQueueWorker_t *pWorker = (uEventQueueWorker_t *) pParam;
+    size_t index = (size_t) (pWorker - gWorker);
+    int32_t handle = U_PORT_EVENT_QUEUE_EXECUTOR_NONE;
+
+    U_PORT_MUTEX_LOCK(pWorker->taskRunningMutex);
+
+    while (handle != U_PORT_EVENT_QUEUE_EXECUTOR_EXIT) {
+        // Own deque first, then the injection queue, then steal,
+        // starting with the next worker along
+        handle = dequeTake(&(pWorker->deque));
+        if ((handle == U_PORT_EVENT_QUEUE_EXECUTOR_NONE) &&
+            (uPortQueueTryReceive(gExecutorQueue, 0, &handle) != 0)) {
+            handle = U_PORT_EVENT_QUEUE_EXECUTOR_NONE;
+        }
+        if (handle == U_PORT_EVENT_QUEUE_EXECUTOR_NONE) {
+            handle = executorSteal(index);
+        }
+        if (handle == U_PORT_EVENT_QUEUE_EXECUTOR_NONE) {
+            // Nothing to do: declare ourselves idle and then look
+            // once more, since a push made before gExecutorNumIdle
+            // was raised will not have woken anyone, before waiting
+            // on the injection queue
+            atomicAdd(&gExecutorNumIdle, 1);
+            handle = executorSteal(index);
+            if ((handle == U_PORT_EVENT_QUEUE_EXECUTOR_NONE) &&
+                (uPortQueueReceive(gExecutorQueue, &handle) != 0)) {
+                handle = U_PORT_EVENT_QUEUE_EXECUTOR_NONE;
+            }
+            atomicAdd(&gExecutorNumIdle, -1);
+        }
+        if (handle == U_PORT_EVENT_QUEUE_EXECUTOR_WAKE) {
+            U_ATOMIC_STORE_RELEASE(&gExecutorWakePending, 0);
+        } else if (handle >= 0) {
+            executorRun(pWorker, handle);
+        }
+    }
+
+    U_PORT_MUTEX_UNLOCK(pWorker->taskRunningMutex);
 
     // Delete ourself
     uPortTaskDelete(NULL);
 }
 
-// Free memory held by an event queue.
+// Stop the shared executor.
 // The mutex must be locked before this is called.
-static int32_t eventQueueFree(uEventQueue_t *pEventQueue)
+static void executorStop()
+{
+    int32_t handle = U_PORT_EVENT_QUEUE_EXECUTOR_EXIT;
+
+    for (size_t x = 0; x < sizeof(gWorker) / sizeof(gWorker[0]); x++) {
+        if (gWorker[x].task != NULL) {
+            uPortQueueSend(gExecutorQueue, &handle);
+        }
+    }
+    for (size_t x = 0; x < sizeof(gWorker) / sizeof(gWorker[0]); x++) {
+        if (gWorker[x].taskRunningMutex != NULL) {
+            if (gWorker[x].task != NULL) {
+                U_PORT_MUTEX_LOCK(gWorker[x].taskRunningMutex);
+                U_PORT_MUTEX_UNLOCK(gWorker[x].taskRunningMutex);
+            }
+            uPortMutexDelete(gWorker[x].taskRunningMutex);
+        }
+    }
+    memset(gWorker, 0, sizeof(gWorker));
+    if (gExecutorQueue != NULL) {
+        uPortQueueDelete(gExecutorQueue);
+        gExecutorQueue = NULL;
+    }
+    gExecutorNumIdle = 0;
+    gExecutorWakePending = 0;
+
+    // Pause here to allow the deletions
+    // above to actually occur in the idle thread,
+    // required by some RTOSs (e.g. FreeRTOS)
+    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+}
+
+// Start the shared executor, if it is not already running.
+// The mutex must be locked before this is called.
+static int32_t executorStart()
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+
+    if (gExecutorQueue == NULL) {
+        memset(gWorker, 0, sizeof(gWorker));
+        // Room for every event queue, plus a wake, plus an exit
+        // for each worker, so that sending never blocks
+        errorCode = uPortQueueCreate(U_PORT_EVENT_QUEUE_MAX_NUM +
+                                     U_PORT_EVENT_QUEUE_EXECUTOR_NUM_WORKERS + 1,
+                                     sizeof(int32_t), &gExecutorQueue);
+        for (size_t x = 0; (errorCode == 0) &&
+             (x < sizeof(gWorker) / sizeof(gWorker[0])); x++) {
+            errorCode = uPortMutexCreate(&(gWorker[x].taskRunningMutex));
+            if (errorCode == 0) {
+                errorCode = uPortTaskCreate(executorTask, "eventQueueExecutor",
+                                            U_PORT_EVENT_QUEUE_EXECUTOR_STACK_SIZE_BYTES,
+                                            (void *) &(gWorker[x]),
+                                            U_PORT_EVENT_QUEUE_EXECUTOR_PRIORITY,
+                                            &(gWorker[x].task));
+                if (errorCode == 0) {
+                    // Wait for the worker to lock the mutex,
+                    // which shows it is running
+                    while (uPortMutexTryLock(gWorker[x].taskRunningMutex, 0) == 0) {
+                        uPortMutexUnlock(gWorker[x].taskRunningMutex);
+                        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                    }
+                } else {
+                    gWorker[x].task = NULL;
+                }
+            }
+        }
+        if (errorCode != 0) {
+            executorStop();
+        }
+    }
+
+    return errorCode;
+}
+
+#endif // #ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+
+// Create the mutex and the task for an event queue that has a
+// task of its own.
+static int32_t eventQueueTaskStart(uEventQueue_t *pEventQueue,
+                                   const char *pName,
+                                   size_t stackSizeBytes,
+                                   int32_t priority)
+{
+    int32_t errorCode;
+
+    // Create the mutex for task running status
+    errorCode = uPortMutexCreate(&(pEventQueue->taskRunningMutex));
+    if (errorCode == 0) {
+        // Create the task itself
+        errorCode = uPortTaskCreate(eventQueueTask, pName, stackSizeBytes,
+                                    (void *) pEventQueue, priority,
+                                    &(pEventQueue->task));
+        if (errorCode == 0) {
+            // Wait for the eventQueueTask to lock the mutex,
+            // which shows it is running
+            while (uPortMutexTryLock(pEventQueue->taskRunningMutex, 0) == 0) {
+                uPortMutexUnlock(pEventQueue->taskRunningMutex);
+                uPortTaskBlock(U_CFG_OS_YIELD_MS);
+            }
+        } else {
+            // Couldn't create the task, delete the mutex
+            uPortMutexDelete(pEventQueue->taskRunningMutex);
+        }
+    }
+
+    return errorCode;
+}
+
+// Delete the OS queues and the slots of an event queue.
+static void eventQueueSlotsFree(uEventQueue_t *pEventQueue)
+{
+    if (pEventQueue->freeSlotQueue != NULL) {
+        uPortQueueDelete(pEventQueue->freeSlotQueue);
+        pEventQueue->freeSlotQueue = NULL;
+    }
+    if (pEventQueue->queue != NULL) {
+        uPortQueueDelete(pEventQueue->queue);
+        pEventQueue->queue = NULL;
+    }
+    uPortFree(pEventQueue->pSlots);
+    pEventQueue->pSlots = NULL;
+}
+
+// Create the OS queues and the slots of an event queue.  There is
+// one more slot than there are entries on the OS queue since the
+// event task holds on to a slot while the user function is called;
+// the free slot queue has room for one more again, for the
+// wake-up sent by eventQueueFree().
+static int32_t eventQueueSlotsCreate(uEventQueue_t *pEventQueue,
+                                     size_t queueLength)
 {
     int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-    void *pControl;
-
-    // It would be nice to send just U_EVENT_CONTROL_EXIT_NOW
-    // on its own here but, as address sanitizer points out,
-    // the uPortQueueSend() function must copy the required
-    // length for an item on the queue so it has to be
-    // given that data size, hence we allocate the block,
-    // put U_EVENT_CONTROL_EXIT_NOW at the start of it and
-    // then free it once it is sent
-    pControl = pUPortMalloc(pEventQueue->paramMaxLengthBytes +
-                            U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-
-    if (pControl != NULL) {
+    size_t numSlots = queueLength + 1;
+
+    pEventQueue->queue = NULL;
+    pEventQueue->freeSlotQueue = NULL;
+    // Keep each slot a multiple of the control word length so that
+    // the control words stay aligned
+    pEventQueue->slotSizeBytes = ((pEventQueue->paramMaxLengthBytes +
+                                   (U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES * 2) - 1) /
+                                  U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES) *
+                                 U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES;
+    pEventQueue->pSlots = (char *) pUPortMalloc(pEventQueue->slotSizeBytes * numSlots);
+    if (pEventQueue->pSlots != NULL) {
         // Keep memory checkers (e.g. Valgrind) happy
-        memset(pControl, 0, pEventQueue->paramMaxLengthBytes +
-               U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-        *((uEventQueueControlOrSize_t *) pControl) = U_EVENT_CONTROL_EXIT_NOW;
-        // Get the task to exit, persisting until it is done
-        while (uPortQueueSend(pEventQueue->queue, pControl) != 0) {
-            uPortTaskBlock(10);
-        }
-        uPortFree(pControl);
+        memset(pEventQueue->pSlots, 0, pEventQueue->slotSizeBytes * numSlots);
+        errorCode = uPortQueueCreate(queueLength, sizeof(int32_t),
+                                     &(pEventQueue->queue));
+        if (errorCode == 0) {
+            errorCode = uPortQueueCreate(numSlots + 1, sizeof(int32_t),
+                                         &(pEventQueue->freeSlotQueue));
+        }
+        // Put all of the slots on the free queue
+        for (int32_t x = 0; (errorCode == 0) && (x < (int32_t) numSlots); x++) {
+            errorCode = uPortQueueSend(pEventQueue->freeSlotQueue, &x);
+        }
+    }
+
+    if (errorCode != 0) {
+        eventQueueSlotsFree(pEventQueue);
+    }
+
+    return errorCode;
+}
+
+// Fill a slot with a parameter block and send it to the OS queue,
+// or return it to the free queue if that fails.
+static int32_t eventQueueSlotSend(const uEventQueue_t *pEventQueue, int32_t slot,
+                                  const void *pParam, size_t paramLengthBytes,
+                                  bool isIrq)
+{
+    int32_t errorCode;
+    char *pSlot = pEventQueue->pSlots + (pEventQueue->slotSizeBytes * slot);
+    uEventQueueControlOrSize_t controlOrSize = (uEventQueueControlOrSize_t) paramLengthBytes;
+
+    // Copy in the control word, which is actually just
+    // the size in this case, and then only as much of
+    // the parameter block as there is
+    memcpy(pSlot, &controlOrSize, sizeof(controlOrSize));
+    if (pParam != NULL) {
+        memcpy(pSlot + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
+               pParam, paramLengthBytes);
+    }
+    if (isIrq) {
+        errorCode = uPortQueueSendIrq(pEventQueue->queue, &slot);
+        if (errorCode != 0) {
+            uPortQueueSendIrq(pEventQueue->freeSlotQueue, &slot);
+        }
+    } else {
+        errorCode = uPortQueueSend(pEventQueue->queue, &slot);
+        if (errorCode != 0) {
+            uPortQueueSend(pEventQueue->freeSlotQueue, &slot);
+        }
+    }
+
+    return errorCode;
+}
+
+// Free memory held by an event queue.
+// The mutex must be locked before this is called.
+static int32_t eventQueueFree(uEventQueue_t *pEventQueue)
+{
+    int32_t errorCode;
+    int32_t slot = U_PORT_EVENT_QUEUE_SLOT_EXIT_NOW;
+
+    // No new senders and no-one else freeing it from here on
+    pEventQueue->closed = true;
+    pEventQueue->freeing = true;
+
+    // Senders may still be using the queues and slots: wake those
+    // waiting for a free slot, each passes the wake-up on and gives
+    // up, then wait for all of them to be done, releasing the mutex
+    // meanwhile so that they can; the event task is still running
+    // so a sender waiting for room on the OS queue will get it
+    if (pEventQueue->numSenders > 0) {
+        // There is always room for this, see eventQueueSlotsCreate()
+        uPortQueueSend(pEventQueue->freeSlotQueue, &slot);
+        while (pEventQueue->numSenders > 0) {
+            uPortMutexUnlock(gMutex);
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+            uPortMutexLock(gMutex);
+        }
+    }
+
+    // Get the task to exit, persisting until it is done
+    while (uPortQueueSend(pEventQueue->queue, &slot) != 0) {
+        uPortTaskBlock(10);
+    }
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+    if (pEventQueue->shared) {
+        executorSchedule(pEventQueue, false);
+        // Wait for a worker to get to the exit slot; the mutex
+        // is released meanwhile as the event function that a
+        // worker is running may be calling this API
+        while (U_ATOMIC_LOAD_ACQUIRE(&(pEventQueue->exited)) == 0) {
+            uPortMutexUnlock(gMutex);
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+            uPortMutexLock(gMutex);
+        }
+    } else
+#endif
+    {
         U_PORT_MUTEX_LOCK(pEventQueue->taskRunningMutex);
         U_PORT_MUTEX_UNLOCK(pEventQueue->taskRunningMutex);
-
-        // Tidy up
         uPortMutexDelete(pEventQueue->taskRunningMutex);
-        errorCode = uPortQueueDelete(pEventQueue->queue);
-
-        // Pause here to allow the deletions
-        // above to actually occur in the idle thread,
-        // required by some RTOSs (e.g. FreeRTOS)
-        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+    }
 
-        // Now remove it from the list and free it
-        gpEventQueue[pEventQueue->handle] = NULL;
-        uPortFree(pEventQueue);
+    // Tidy up
+    errorCode = uPortQueueDelete(pEventQueue->queue);
+    pEventQueue->queue = NULL;
+    eventQueueSlotsFree(pEventQueue);
+
+    // Pause here to allow the deletions
+    // above to actually occur in the idle thread,
+    // required by some RTOSs (e.g. FreeRTOS)
+    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+
+    // Now remove it from the list and free it
+    gpEventQueue[pEventQueue->handle] = NULL;
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+    if (pEventQueue->shared) {
+        gExecutorNumEventQueues--;
+        if (gExecutorNumEventQueues == 0) {
+            executorStop();
+        }
     }
+#endif
+    uPortFree(pEventQueue);
 
     return errorCode;
 }
 
+// Return true if an event queue has been closed and may be freed.
+static bool eventQueueIsFreeable(const uEventQueue_t *pEventQueue)
+{
+    // Another task may be part way through freeing it
+    return pEventQueue->closed && !pEventQueue->freeing;
+}
+
 // Get the next free event handle.
 // The mutex must be locked before this is called.
 static int32_t nextEventHandleGet()
@@ -208,7 +794,7 @@ static int32_t nextEventHandleGet()
         if (gpEventQueue[x] == NULL) {
             handle = (int32_t) x;
         } else {
-            if (gpEventQueue[x]->closed) {
+            if (eventQueueIsFreeable(gpEventQueue[x])) {
                 eventQueueFree(gpEventQueue[x]);
                 gpEventQueue[x] = NULL;
                 handle = (int32_t) x;
@@ -325,55 +911,49 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                 // Malloc a structure to represent the event queue
                 pEventQueue = (uEventQueue_t *) pUPortMalloc(sizeof(uEventQueue_t));
                 if (pEventQueue != NULL) {
+                    memset(pEventQueue, 0, sizeof(*pEventQueue));
                     pEventQueue->closed = false;
                     pEventQueue->pFunction = pFunction;
                     pEventQueue->paramMaxLengthBytes = paramMaxLengthBytes;
-                    // Create the queue
-                    handleOrError = (uErrorCode_t) uPortQueueCreate(queueLength,
-                                                                    paramMaxLengthBytes +
-                                                                    U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
-                                                                    &(pEventQueue->queue));
+                    // Create the queues and the slots
+                    handleOrError = (uErrorCode_t) eventQueueSlotsCreate(pEventQueue,
+                                                                         queueLength);
                     if (handleOrError == U_ERROR_COMMON_SUCCESS) {
-                        // Create the mutex for task running status
-                        handleOrError = (uErrorCode_t) uPortMutexCreate(&(pEventQueue->taskRunningMutex));
-                        if (handleOrError == U_ERROR_COMMON_SUCCESS) {
-                            // Finally, create the task itself
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+                        pEventQueue->shared = (stackSizeBytes <=
+                                               U_PORT_EVENT_QUEUE_EXECUTOR_STACK_SIZE_BYTES);
+                        if (pEventQueue->shared) {
+                            // Run it with the shared executor
+                            handleOrError = (uErrorCode_t) executorStart();
+                            if (handleOrError == U_ERROR_COMMON_SUCCESS) {
+                                gExecutorNumEventQueues++;
+                            }
+                        } else
+#endif
+                        {
+                            // Create the task that runs it
                             if (pName != NULL) {
                                 pTaskName = pName;
                             }
-                            handleOrError = (uErrorCode_t) uPortTaskCreate(eventQueueTask,
-                                                                           pTaskName,
-                                                                           stackSizeBytes,
-                                                                           (void *) pEventQueue,
-                                                                           priority,
-                                                                           &(pEventQueue->task));
-                            if (handleOrError == U_ERROR_COMMON_SUCCESS) {
-                                // Wait for the eventQueueTask to lock the mutex,
-                                // which shows it is running
-                                while (uPortMutexTryLock(pEventQueue->taskRunningMutex, 0) == 0) {
-                                    uPortMutexUnlock(pEventQueue->taskRunningMutex);
-                                    uPortTaskBlock(U_CFG_OS_YIELD_MS);
-                                }
-                                // Add the event queue structure to the list
-                                pEventQueue->handle = handle;
-                                gpEventQueue[handle] = pEventQueue;
-                                // Return the handle
-                                handleOrError = (uErrorCode_t) handle;
-                            } else {
-                                // Couldn't create the task, delete the
-                                // mutex and queue and free the structure
-                                uPortMutexDelete(pEventQueue->taskRunningMutex);
-                                uPortQueueDelete(pEventQueue->queue);
-                                uPortFree(pEventQueue);
-                            }
+                            handleOrError = (uErrorCode_t) eventQueueTaskStart(pEventQueue,
+                                                                               pTaskName,
+                                                                               stackSizeBytes,
+                                                                               priority);
+                        }
+                        if (handleOrError == U_ERROR_COMMON_SUCCESS) {
+                            // Add the event queue structure to the list
+                            pEventQueue->handle = handle;
+                            gpEventQueue[handle] = pEventQueue;
+                            // Return the handle
+                            handleOrError = (uErrorCode_t) handle;
                         } else {
-                            // Couldn't create the mutex, delete the queue
-                            // and free the structure
-                            uPortQueueDelete(pEventQueue->queue);
+                            // Couldn't start it, delete the queues
+                            // and slots and free the structure
+                            eventQueueSlotsFree(pEventQueue);
                             uPortFree(pEventQueue);
                         }
                     } else {
-                        // Couldn't create the queue, free the structure
+                        // Couldn't create the queues, free the structure
                         uPortFree(pEventQueue);
                     }
                 }
@@ -392,8 +972,7 @@ int32_t uPortEventQueueSend(int32_t handle, const void *pParam,
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
     uEventQueue_t *pEventQueue;
-    char *pBlock = NULL;
-    uPortQueueHandle_t queue = NULL;
+    int32_t slot;
 
     if (gMutex != NULL) {
 
@@ -404,46 +983,44 @@ int32_t uPortEventQueueSend(int32_t handle, const void *pParam,
         if ((pEventQueue != NULL) &&
             (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
             ((pParam != NULL) || (paramLengthBytes == 0))) {
-            queue = pEventQueue->queue;
-            errorCode = U_ERROR_COMMON_NO_MEMORY;
-            // We need to add the control word to the start, so pUPortMalloc
-            // a block that is paramMaxLengthBytes (i.e. paramMaxLengthBytes
-            // of the queue, not just the paramLengthBytes passed in, since
-            // uPortQueueSend() will expect to copy the full length) plus
-            // plus the control word length
-            pBlock = (char *) pUPortMalloc(pEventQueue->paramMaxLengthBytes +
-                                           U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-            if (pBlock != NULL) {
-                // Keep memory checkers (e.g. Valgrind) happy
-                memset(pBlock, 0, pEventQueue->paramMaxLengthBytes +
-                       U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-                // Copy in the control word, which is actually just
-                // the size in this case
-                //lint -e(826) Suppress area too small; the size of pBlock is always
-                // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
-                *((uEventQueueControlOrSize_t *) pBlock) = (uEventQueueControlOrSize_t) paramLengthBytes;
-                if (pParam != NULL) {
-                    // Copy in param
-                    //lint -e{826} Suppress pointed-to area too small, we make sure it is OK above
-                    memcpy(pBlock + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
-                           pParam, paramLengthBytes);
-                }
-            }
+            // Once the mutex is released the event queue may be
+            // closed: this stops it being freed until we're done
+            pEventQueue->numSenders++;
+        } else {
+            pEventQueue = NULL;
         }
 
-        // We release the mutex before sending to the
-        // queue since the send process may block (e.g.
-        // if the queue is full) and we don't want
+        // We release the mutex before waiting for a slot
+        // and sending to the queue since either may block
+        // (e.g. if the queue is full) and we don't want
         // that to block the entire API
         U_PORT_MUTEX_UNLOCK(gMutex);
 
-        if (pBlock != NULL) {
-            if (queue != NULL) {
-                // Send it off
-                errorCode = (uErrorCode_t) uPortQueueSend(queue, pBlock);
+        if (pEventQueue != NULL) {
+            errorCode = (uErrorCode_t) uPortQueueReceive(pEventQueue->freeSlotQueue, &slot);
+            if (errorCode == U_ERROR_COMMON_SUCCESS) {
+                if (slot != U_PORT_EVENT_QUEUE_SLOT_EXIT_NOW) {
+                    errorCode = (uErrorCode_t) eventQueueSlotSend(pEventQueue, slot,
+                                                                  pParam, paramLengthBytes,
+                                                                  false);
+                } else {
+                    // Woken up by eventQueueFree(): pass it
+                    // on to any other waiting sender and give up
+                    uPortQueueSend(pEventQueue->freeSlotQueue, &slot);
+                    errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+                }
+            }
+
+            U_PORT_MUTEX_LOCK(gMutex);
+
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+            if ((errorCode == U_ERROR_COMMON_SUCCESS) && pEventQueue->shared) {
+                executorSchedule(pEventQueue, false);
             }
-            // Free memory again
-            uPortFree(pBlock);
+#endif
+            pEventQueue->numSenders--;
+
+            U_PORT_MUTEX_UNLOCK(gMutex);
         }
     }
 
@@ -454,11 +1031,9 @@ int32_t uPortEventQueueSend(int32_t handle, const void *pParam,
 int32_t uPortEventQueueSendIrq(int32_t handle, const void *pParam,
                                size_t paramLengthBytes)
 {
-#ifndef _WIN32
     uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
     uEventQueue_t *pEventQueue;
-    char block[paramLengthBytes +
-               U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES];
+    int32_t slot;
 
     if (gMutex != NULL) {
         // Can't lock the mutex, we're in an interrupt.
@@ -467,35 +1042,30 @@ int32_t uPortEventQueueSendIrq(int32_t handle, const void *pParam,
         if ((pEventQueue != NULL) &&
             (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
             ((pParam != NULL) || (paramLengthBytes == 0))) {
-            // Copy in the control word, which is actually just
-            // the size in this case
-            //lint -e(826) Suppress area too small; the size of pBlock is always
-            // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
-            uEventQueueControlOrSize_t *pControlOrSize = (uEventQueueControlOrSize_t *) block;
-            *pControlOrSize = (uEventQueueControlOrSize_t) paramLengthBytes;
-            if (pParam != NULL) {
-                // Copy in param
-                memcpy(block + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
-                       pParam, paramLengthBytes);
-            }
-            // Send it off
-            errorCode = (uErrorCode_t) uPortQueueSendIrq(pEventQueue->queue,
-                                                         block);
-        }
-    }
-#else
-    // It would have been nice to leave this function as-is for win32
-    // and just let uPortQueueSendIrq() return an error ('cos the IRQ
-    // functions are not supported for the Windows platform), however
-    // MSVC, which we use on Windows, doesn't support dynamically sized
-    // arrays and hence we'd need to switch to using a static buffer for
-    // block, which is entirely unnecessary.  Hence this compiler switch.
-    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_SUPPORTED;
-
-    (void) handle;
-    (void) pParam;
-    (void) paramLengthBytes;
+            // Grab a free slot, without waiting
+            errorCode = (uErrorCode_t) uPortQueueReceiveIrq(pEventQueue->freeSlotQueue,
+                                                            &slot);
+            if ((errorCode == U_ERROR_COMMON_SUCCESS) &&
+                (slot == U_PORT_EVENT_QUEUE_SLOT_EXIT_NOW)) {
+                // The event queue is being freed, see uPortEventQueueSend()
+                uPortQueueSendIrq(pEventQueue->freeSlotQueue, &slot);
+                errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+            } else if (errorCode == U_ERROR_COMMON_SUCCESS) {
+                errorCode = (uErrorCode_t) eventQueueSlotSend(pEventQueue, slot,
+                                                              pParam, paramLengthBytes,
+                                                              true);
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+                if ((errorCode == U_ERROR_COMMON_SUCCESS) && pEventQueue->shared) {
+                    executorSchedule(pEventQueue, true);
+                }
 #endif
+            } else if (errorCode == U_ERROR_COMMON_NOT_IMPLEMENTED) {
+                // Platforms which can't receive from a queue in an
+                // interrupt can't send from one either
+                errorCode = U_ERROR_COMMON_NOT_SUPPORTED;
+            }
+        }
+    }
 
     return (int32_t) errorCode;
 }
@@ -512,7 +1082,17 @@ bool uPortEventQueueIsTask(int32_t handle)
 
         pEventQueue = pEventQueueGet(handle);
         if (pEventQueue != NULL) {
-            isEventTask = uPortTaskIsThis(pEventQueue->task);
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+            if (pEventQueue->shared) {
+                // True only while a worker is running the
+                // event function of this event queue
+                isEventTask = (pEventQueue->runningTask != NULL) &&
+                              uPortTaskIsThis(pEventQueue->runningTask);
+            } else
+#endif
+            {
+                isEventTask = uPortTaskIsThis(pEventQueue->task);
+            }
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -526,6 +1106,9 @@ int32_t uPortEventQueueStackMinFree(int32_t handle)
 {
     int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
     uEventQueue_t *pEventQueue;
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+    int32_t y;
+#endif
 
     if (gMutex != NULL) {
 
@@ -534,7 +1117,21 @@ int32_t uPortEventQueueStackMinFree(int32_t handle)
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
         pEventQueue = pEventQueueGet(handle);
         if (pEventQueue != NULL) {
-            sizeOrErrorCode = uPortTaskStackMinFree(pEventQueue->task);
+#ifdef U_CFG_EVENT_QUEUE_EXECUTOR
+            if (pEventQueue->shared) {
+                // Could be any of the workers: take the worst
+                sizeOrErrorCode = INT32_MAX;
+                for (size_t x = 0; x < sizeof(gWorker) / sizeof(gWorker[0]); x++) {
+                    y = uPortTaskStackMinFree(gWorker[x].task);
+                    if (y < sizeOrErrorCode) {
+                        sizeOrErrorCode = y;
+                    }
+                }
+            } else
+#endif
+            {
+                sizeOrErrorCode = uPortTaskStackMinFree(pEventQueue->task);
+            }
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -609,7 +1206,7 @@ void uPortEventQueueCleanUp(void)
         for (size_t x = 0;
              x < sizeof(gpEventQueue) / sizeof(gpEventQueue[0]);
              x++) {
-            if ((gpEventQueue[x] != NULL) && (gpEventQueue[x]->closed)) {
+            if ((gpEventQueue[x] != NULL) && eventQueueIsFreeable(gpEventQueue[x])) {
                 eventQueueFree(gpEventQueue[x]);
             }
         }
@@ -40,6 +40,8 @@
 #include "u_port_heap.h"
 #include "u_port_debug.h"
 
+#include "u_trace.h"
+
 #include "u_log_ram.h"
 #include "u_log_ram_enum.h"
 #include "u_log_ram_string.h"
@@ -48,6 +50,11 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The trace ring that holds the log entries, which follows the
+ * context in memory.
+ */
+#define U_LOG_RAM_RING(pContext) ((void *) ((pContext) + 1))
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -64,7 +71,7 @@ static uLogRamContext_t *gpContext = NULL;
  */
 static bool gContextMalloced = false;
 
-/** Mutex to arbitrate logging.
+/** Mutex to arbitrate reading the log.
  */
 static uPortMutexHandle_t gMutex = NULL;
 
@@ -76,15 +83,23 @@ static uPortMutexHandle_t gMutex = NULL;
 static void printItem(const uLogRamEntry_t *pItem, size_t itemIndex)
 {
     if (pItem->event > gULogRamNumStrings) {
-        uPortLog("%10d: out of range event at entry %u (%u when max is %d).\n",
-                 pItem->timestamp, itemIndex, pItem->event, gULogRamNumStrings);
+        uPortLog("%10u: out of range event at entry %u (%u when max is %d).\n",
+                 (uint32_t) pItem->timestamp, itemIndex, pItem->event, gULogRamNumStrings);
     } else {
-        uPortLog("%10d: [%3u] %s %d (%#x)\n",  pItem->timestamp,
+        uPortLog("%10u: [%3u] %s %d (%#x)\n", (uint32_t) pItem->timestamp,
                  pItem->event, gULogRamString[pItem->event],
                  pItem->parameter, pItem->parameter);
     }
 }
 
+// Convert a trace ring entry into a log entry.
+static void entryFromTrace(uLogRamEntry_t *pItem, const uTraceEntry_t *pTraceEntry)
+{
+    pItem->timestamp = (int32_t) pTraceEntry->timeUs;
+    pItem->event = pTraceEntry->event;
+    pItem->parameter = pTraceEntry->parameter;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -94,6 +109,7 @@ bool uLogRamInit(void *pBuffer)
 {
     bool success = false;
     bool freshStart = false;
+    const uTraceRing_t *pRing;
 
     if (gMutex == NULL) {
         uPortMutexCreate(&gMutex);
@@ -102,34 +118,37 @@ bool uLogRamInit(void *pBuffer)
     if (gMutex != NULL) {
         if (pBuffer == NULL) {
             pBuffer = pUPortMalloc(U_LOG_RAM_STORE_SIZE);
-            memset(pBuffer, 0, U_LOG_RAM_STORE_SIZE);
-            gContextMalloced = true;
+            if (pBuffer != NULL) {
+                memset(pBuffer, 0, U_LOG_RAM_STORE_SIZE);
+                gContextMalloced = true;
+            }
         }
         if (pBuffer != NULL) {
             gpContext = (uLogRamContext_t *) pBuffer;
         }
         if (gpContext != NULL) {
+            pRing = (const uTraceRing_t *) U_LOG_RAM_RING(gpContext);
             // If the context is uninitialised, initialise it
             if ((gpContext->magicWord != 0x123456) ||
-                (gpContext->version != U_LOG_RAM_VERSION)) {
+                (gpContext->version != U_LOG_RAM_VERSION) ||
+                (pRing->numEntries != U_LOG_RAM_ENTRIES_MAX_NUM)) {
                 freshStart = true;
                 memset(gpContext, 0, sizeof(*gpContext));
                 gpContext->version = U_LOG_RAM_VERSION;
-                gpContext->pLog = (uLogRamEntry_t * ) ((char *) pBuffer + sizeof(*gpContext));
-                gpContext->pLogNextEmpty = gpContext->pLog;
-                gpContext->pLogFirstFull = gpContext->pLog;
-                gpContext->numLogItems = 0;
-                gpContext->logEntriesOverwritten = 0;
-                gpContext->lastLogTime = uPortGetTickTimeMs();
+                gpContext->nextSequence = 0;
+                gpContext->lastLogTime = uPortGetTickTimeUs();
                 gpContext->magicWord = 0x123456;
             }
 
-            if (freshStart) {
-                uLogRam(U_LOG_RAM_EVENT_START, U_LOG_RAM_VERSION);
-            } else {
-                uLogRam(U_LOG_RAM_EVENT_START_AGAIN, U_LOG_RAM_VERSION);
+            if (uTraceRingInit(U_LOG_RAM_RING(gpContext),
+                               U_LOG_RAM_ENTRIES_MAX_NUM, !freshStart) == 0) {
+                if (freshStart) {
+                    uLogRam(U_LOG_RAM_EVENT_START, U_LOG_RAM_VERSION);
+                } else {
+                    uLogRam(U_LOG_RAM_EVENT_START_AGAIN, U_LOG_RAM_VERSION);
+                }
+                success = true;
             }
-            success = true;
         }
     }
 
@@ -162,95 +181,85 @@ void uLogRamDeinit()
 // Log an event plus parameter.
 void uLogRam(uLogRamEvent_t event, int32_t parameter)
 {
-    int32_t timestamp = uPortGetTickTimeMs();
-
-    if ((gpContext != NULL) && (gpContext->pLogNextEmpty)) {
-        // Check if the timestamp has wrapped and
-        // insert a log point before this one if that's the
-        // case (coding gods: please excuse my recursion)
-        if (timestamp < gpContext->lastLogTime) {
-            gpContext->lastLogTime = timestamp;
-            uLogRam(U_LOG_RAM_EVENT_TIME_WRAP, timestamp);
-        }
-        gpContext->lastLogTime = timestamp;
-        gpContext->pLogNextEmpty->timestamp = timestamp;
-        gpContext->pLogNextEmpty->event = (uint32_t) event;
-        gpContext->pLogNextEmpty->parameter = parameter;
+    uLogRamContext_t *pContext = gpContext;
 #if defined(U_LOG_RAM_PRINT) || defined(U_LOG_RAM_PRINT_ONLY)
-        printItem(gpContext->pLogNextEmpty, 0);
+    uLogRamEntry_t item;
 #endif
-#ifndef U_LOG_RAM_PRINT_ONLY
-        if (gpContext->pLogNextEmpty < gpContext->pLog + U_LOG_RAM_ENTRIES_MAX_NUM - 1) {
-            gpContext->pLogNextEmpty++;
-        } else {
-            gpContext->pLogNextEmpty = gpContext->pLog;
-        }
 
-        if (gpContext->pLogNextEmpty == gpContext->pLogFirstFull) {
-            // Logging has wrapped, so move the
-            // first pointer on to reflect the
-            // overwrite
-            if (gpContext->pLogFirstFull < gpContext->pLog + U_LOG_RAM_ENTRIES_MAX_NUM - 1) {
-                gpContext->pLogFirstFull++;
-            } else {
-                gpContext->pLogFirstFull = gpContext->pLog;
-            }
-            gpContext->logEntriesOverwritten++;
-        } else {
-            gpContext->numLogItems++;
-        }
+    if (pContext != NULL) {
+#if defined(U_LOG_RAM_PRINT) || defined(U_LOG_RAM_PRINT_ONLY)
+        item.timestamp = uPortGetTickTimeUs();
+        item.event = (uint32_t) event;
+        item.parameter = parameter;
+        printItem(&item, 0);
+#endif
+#ifndef U_LOG_RAM_PRINT_ONLY
+        // The trace ring is lock-free so there is no danger
+        // of entries from two tasks becoming mixed up here
+        uTraceRingWrite(U_LOG_RAM_RING(pContext), (uint32_t) event, parameter);
 #endif
     }
 }
 
-// Log an event plus parameter, this time with mutex protection.
+// Log an event plus parameter, retained for compatibility.
 void uLogRamX(uLogRamEvent_t event, int32_t parameter)
 {
-    if (gMutex != NULL) {
-
-        U_PORT_MUTEX_LOCK(gMutex);
-
-        uLogRam(event, parameter);
-
-        U_PORT_MUTEX_UNLOCK(gMutex);
-    }
+    uLogRam(event, parameter);
 }
 
 // Get the first N RAM log entries.
 size_t uLogRamGet(uLogRamEntry_t *pEntries, size_t numEntries)
 {
-    const uLogRamEntry_t *pItem;
+    uTraceEntry_t traceEntry;
+    uint32_t sequence;
+    size_t numRead;
+    size_t numLost;
     size_t itemCount = 0;
 
     if ((gpContext != NULL) && (gMutex != NULL)) {
 
         U_PORT_MUTEX_LOCK(gMutex);
 
-        pItem = gpContext->pLogFirstFull;
-        while ((pItem != gpContext->pLogNextEmpty) &&
-               (itemCount < numEntries)) {
-            if (gpContext->logEntriesOverwritten > 0) {
-                uLogRamEntry_t insert = {pItem->timestamp,
-                                         U_LOG_RAM_EVENT_ENTRIES_OVERWRITTEN,
-                                         (int32_t) gpContext->logEntriesOverwritten
-                                        };
-                memcpy(pEntries, &insert, sizeof(*pEntries));
+        while (itemCount < numEntries) {
+            sequence = gpContext->nextSequence;
+            numRead = uTraceRingRead(U_LOG_RAM_RING(gpContext), &sequence,
+                                     &traceEntry, 1, &numLost);
+            if (numLost > 0) {
+                pEntries->timestamp = gpContext->lastLogTime;
+                if (numRead > 0) {
+                    pEntries->timestamp = (int32_t) traceEntry.timeUs;
+                }
+                pEntries->event = U_LOG_RAM_EVENT_ENTRIES_OVERWRITTEN;
+                pEntries->parameter = (int32_t) numLost;
+                pEntries++;
                 itemCount++;
+            }
+            if (numRead == 0) {
+                gpContext->nextSequence = sequence;
+                break;
+            }
+            // Check if the timestamp has wrapped and insert
+            // a log point before this one if that's the case;
+            // entries may be slightly out of time order when
+            // tasks collide, hence the big margin
+            if ((itemCount < numEntries) &&
+                (traceEntry.timeUs < (uint32_t) gpContext->lastLogTime) &&
+                ((uint32_t) gpContext->lastLogTime - traceEntry.timeUs > 0x80000000)) {
+                pEntries->timestamp = (int32_t) traceEntry.timeUs;
+                pEntries->event = U_LOG_RAM_EVENT_TIME_WRAP;
+                pEntries->parameter = (int32_t) traceEntry.timeUs;
                 pEntries++;
-                gpContext->logEntriesOverwritten = 0;
+                itemCount++;
             }
+            gpContext->lastLogTime = (int32_t) traceEntry.timeUs;
             if (itemCount < numEntries) {
-                memcpy(pEntries, pItem, sizeof(*pEntries));
-                itemCount++;
+                entryFromTrace(pEntries, &traceEntry);
                 pEntries++;
-                pItem++;
-                if (gpContext->numLogItems > 0) {
-                    gpContext->numLogItems--;
-                }
-                if (pItem >= gpContext->pLog + U_LOG_RAM_ENTRIES_MAX_NUM) {
-                    pItem = gpContext->pLog;
-                }
-                gpContext->pLogFirstFull = pItem;
+                itemCount++;
+                gpContext->nextSequence = sequence;
+            } else {
+                // No room, leave the entry for next time
+                gpContext->nextSequence = traceEntry.sequence - 1;
             }
         }
 
@@ -269,7 +278,8 @@ size_t uLogRamGetNumEntries()
 
         U_PORT_MUTEX_LOCK(gMutex);
 
-        numLogItems = gpContext->numLogItems;
+        numLogItems = uTraceRingGetNumEntries(U_LOG_RAM_RING(gpContext),
+                                              gpContext->nextSequence);
 
         U_PORT_MUTEX_UNLOCK(gMutex);
     }
@@ -280,7 +290,9 @@ size_t uLogRamGetNumEntries()
 // Print out the log.
 void uLogRamPrint()
 {
-    const uLogRamEntry_t *pItem;
+    uTraceEntry_t traceEntry;
+    uLogRamEntry_t item;
+    uint32_t sequence;
     size_t x = 0;
 
     if (gpContext != NULL) {
@@ -290,15 +302,13 @@ void uLogRamPrint()
         }
 
         uPortLog("------------- uLogRam starts -------------\n");
-        // Print the log items from RAM
-        pItem = gpContext->pLogFirstFull;
-        while (pItem != gpContext->pLogNextEmpty) {
-            printItem(pItem, x);
+        // Print the log items from RAM without removing them
+        sequence = gpContext->nextSequence;
+        while (uTraceRingRead(U_LOG_RAM_RING(gpContext), &sequence,
+                              &traceEntry, 1, NULL) > 0) {
+            entryFromTrace(&item, &traceEntry);
+            printItem(&item, x);
             x++;
-            pItem++;
-            if (pItem >= gpContext->pLog + U_LOG_RAM_ENTRIES_MAX_NUM) {
-                pItem = gpContext->pLog;
-            }
         }
         uPortLog("-------------- uLogRam ends --------------\n");
 
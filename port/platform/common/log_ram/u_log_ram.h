@@ -22,18 +22,21 @@
  * of another module should be included here; otherwise
  * please keep #includes to your .c files. */
 
+#include "stddef.h"
 #include "stdint.h"
 #include "stdbool.h"
 
+#include "u_trace.h"
 #include "u_log_ram_enum.h"
 
 /** @file
  * @brief This logging utility allows events to be logged to RAM at minimal
  * run-time cost.  Each entry includes an event, a 32 bit parameter (which
- * is printed with the event) and a millisecond time-stamp.  This code
+ * is printed with the event) and a microsecond time-stamp.  This code
  * is not multithreaded in that there can only be a single log buffer
- * at any one time, however the functions, aside from uLogRam(),
- * are mutex-protected.
+ * at any one time; uLogRam() is lock-free, being built on a trace ring
+ * (see u_trace.h), and may be called by any number of tasks at once,
+ * while the other functions are mutex-protected.
  */
 
 #ifdef __cplusplus
@@ -44,10 +47,10 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-/** The number of log entries (must be 1 or greater).
+/** The number of log entries (must be a power of two).
  */
 #ifndef U_LOG_RAM_ENTRIES_MAX_NUM
-# define U_LOG_RAM_ENTRIES_MAX_NUM 500
+# define U_LOG_RAM_ENTRIES_MAX_NUM 512
 #endif
 
 /* ----------------------------------------------------------------
@@ -57,29 +60,26 @@ extern "C" {
 /** An entry in the log.
  */
 typedef struct {
-    int32_t timestamp;
+    int32_t timestamp; // In microseconds, wrapping as an unsigned 32-bit value
     uint32_t event; // This will be #uLogRamEvent_t but it is stored as an int
     // so that we are guaranteed to get a 32-bit value,
     // making it easier to decode logs on another platform
     int32_t parameter;
 } uLogRamEntry_t;
 
-/** Type used to store logging context data.
+/** Type used to store logging context data; the trace ring that
+ * holds the log entries follows it in memory.
  */
 typedef struct {
     uint32_t magicWord;
     int32_t version;
-    uLogRamEntry_t *pLog;
-    uLogRamEntry_t *pLogNextEmpty;
-    uLogRamEntry_t const *pLogFirstFull;
-    size_t numLogItems;
-    size_t logEntriesOverwritten;
-    int32_t lastLogTime;
+    uint32_t nextSequence; // The next entry of the trace ring that uLogRamGet() will return
+    int32_t lastLogTime; // For time-wrap detection in uLogRamGet()
 } uLogRamContext_t;
 
 /** The size of the log store, given the number of entries requested.
  */
-#define U_LOG_RAM_STORE_SIZE (sizeof(uLogRamContext_t) + (sizeof(uLogRamEntry_t) * U_LOG_RAM_ENTRIES_MAX_NUM))
+#define U_LOG_RAM_STORE_SIZE (sizeof(uLogRamContext_t) + U_TRACE_RING_SIZE(U_LOG_RAM_ENTRIES_MAX_NUM))
 
 /* ----------------------------------------------------------------
  * FUNCTIONS
@@ -101,17 +101,18 @@ bool uLogRamInit(void *pBuffer);
  */
 void uLogRamDeinit();
 
-/** Log an event plus parameter to RAM.
+/** Log an event plus parameter to RAM.  This takes no mutex and
+ * may be called by any number of tasks at the same time.
  *
  * @param event     the event.
  * @param parameter the parameter.
  */
 void uLogRam(uLogRamEvent_t event, int32_t parameter);
 
-/** Log an event plus parameter to RAM, employing a mutex to protect the
- * log contents.  This will take longer, potentially a lot longer,
- * than uLogRam() so call this only in applications where you don't
- * care about speed.
+/** Log an event plus parameter to RAM; this used to employ a mutex
+ * to protect the log contents but uLogRam() is now safe to call
+ * from any number of tasks, so it is simply the same as uLogRam(),
+ * retained for compatibility.
  *
  * @param event     the event.
  * @param parameter the parameter.
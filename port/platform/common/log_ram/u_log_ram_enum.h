@@ -35,9 +35,10 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-/** Increment this variable if you make any changes to the enum below.
+/** Increment this variable if you make any changes to the enum below
+ * or to the layout of the log store.
  */
-#define U_LOG_RAM_VERSION 0
+#define U_LOG_RAM_VERSION 1
 
 /* ----------------------------------------------------------------
  * TYPES
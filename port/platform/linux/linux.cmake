@@ -69,6 +69,9 @@ set(UBXLIB_SRC_PORT
 # Add the platform-specific tests and examples
 list(APPEND UBXLIB_TEST_SRC
     ${UBXLIB_BASE}/port/platform/${UBXLIB_PLATFORM}/test/u_linux_ppp_test.c
+    ${UBXLIB_BASE}/port/platform/${UBXLIB_PLATFORM}/test/u_linux_queue_test.c
+    ${UBXLIB_BASE}/port/platform/${UBXLIB_PLATFORM}/test/u_linux_timer_test.c
+    ${UBXLIB_BASE}/port/platform/${UBXLIB_PLATFORM}/test/u_linux_uart_test.c
     ${UBXLIB_BASE}/example/sockets/main_ppp_linux.c
 )
 
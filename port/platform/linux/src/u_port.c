@@ -123,6 +123,20 @@ int32_t uPortGetTickTimeMs()
     return ms;
 }
 
+// Get the current tick converted to a time in microseconds.
+int32_t uPortGetTickTimeUs()
+{
+    uint32_t us = 0;
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC_RAW, &ts) == 0) {
+        // Let it wrap as an unsigned 32-bit quantity
+        us = (uint32_t) ((((uint64_t) ts.tv_sec) * 1000000) + (((uint64_t) ts.tv_nsec) / 1000));
+    }
+
+    return (int32_t) us;
+}
+
 // Get the minimum amount of heap free, ever, in bytes.
 int32_t uPortGetHeapMinFree()
 {
@@ -73,7 +73,6 @@
 #include "semaphore.h"
 #include "sched.h"
 #include "pthread.h"
-#include "fcntl.h"
 #include "time.h"
 #include "signal.h"
 #include "errno.h"
@@ -106,35 +105,100 @@ int32_t _uPortMutexUnlock(uPortMutexHandle_t mutexHandle);
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The number of bits of the tick that index each level of the
+ * timer wheel.
+ */
+#define U_PORT_OS_TIMER_WHEEL_LEVEL_BITS 6
+
+/** The number of slots in each level of the timer wheel.
+ */
+#define U_PORT_OS_TIMER_WHEEL_NUM_SLOTS (1 << U_PORT_OS_TIMER_WHEEL_LEVEL_BITS)
+
+/** Mask for a slot index of the timer wheel.
+ */
+#define U_PORT_OS_TIMER_WHEEL_SLOT_MASK (U_PORT_OS_TIMER_WHEEL_NUM_SLOTS - 1)
+
+/** The index of the slot for the given tick in the given level
+ * of the timer wheel.
+ */
+#define U_PORT_OS_TIMER_WHEEL_INDEX(tick, level) \
+    (((tick) >> ((level) * U_PORT_OS_TIMER_WHEEL_LEVEL_BITS)) & U_PORT_OS_TIMER_WHEEL_SLOT_MASK)
+
+/** The number of levels of the timer wheel: with a tick of one
+ * millisecond, four levels of 64 slots reach out about four and
+ * a half hours; a timer further out than that is parked in the
+ * top level and sorted again when its slot comes around.
+ */
+#define U_PORT_OS_TIMER_WHEEL_NUM_LEVELS 4
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
 /* Structures for storing os specific type data to be kept in linked lists. */
 
-/** Queues are implemented using Posix pipes. A mutex is protecting the
- *  available count and a semaphore is used for synchronisation.
- *  Pipe descriptor 0 is used for reading and 1 for writing.
+/** Queues are implemented as an in-process ring buffer of items,
+ *  allocated along with this structure, protected by a mutex, with
+ *  a condition variable for each direction: a receiver waits on
+ *  notEmpty, a sender on notFull.  The condition variables use
+ *  CLOCK_MONOTONIC so that timed waits are not upset by changes
+ *  to the wall-clock time.
 */
 typedef struct {
-    uPortMutexHandle_t mutex;
-    uPortSemaphoreHandle_t semHandle;
-    int fd[2];            /*!< Pipe in/out descriptor. */
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+    char *pBuffer;        /*!< Storage for queueLength items. */
     size_t queueLength;   /*!< Max number of elements. */
     size_t itemSizeBytes; /*!< Element size */
-    size_t readCount;     /*!< Unread bytes in the queue. */
+    size_t readIndex;     /*!< Index of the oldest item in the queue. */
+    size_t count;         /*!< The number of items in the queue. */
 } uPortQueue_t;
 
-/** Timers are implemented using Posix timer_t timers.
+/** Timers are held in a hierarchical timer wheel, see
+ *  uPortTimerWheel_t.  A started timer is in exactly one list, either
+ *  a slot of the wheel or the list of expired timers waiting for
+ *  their callback to be called; the lists are doubly linked so that
+ *  starting or stopping a timer is O(1).
 */
-typedef struct {
-    timer_t timerId;             /*!< Posix timer ID. */
-    struct itimerspec timerSpec; /*!< Posix structure for timer start values and intervals.*/
+typedef struct uPortTimer_t {
+    struct uPortTimer_t *pNext;   /*!< Next timer in the same list. */
+    struct uPortTimer_t **ppPrev; /*!< The pointer that points to this timer,
+                                       NULL if the timer is not in a list. */
+    uint64_t expiryTick;          /*!< The tick at which the timer expires. */
+    uint32_t intervalMs;
     bool periodic;
+    bool expired;                 /*!< True if in the list of expired timers. */
     pTimerCallback_t *pCallback;
     void *pCallbackParam;
 } uPortTimer_t;
 
+/** The timer wheel: a single timer-service thread, ticking once a
+ *  millisecond on CLOCK_MONOTONIC, moves the timers of each tick
+ *  into a list of expired timers and then calls their callbacks,
+ *  as a batch, with the mutex released.  Level 0 of the wheel holds
+ *  the timers due in the next 64 ticks, one slot per tick, level 1
+ *  those due in the next 64 * 64 ticks, one slot per 64 ticks, and
+ *  so on; as level 0 wraps, the next slot of level 1 is emptied
+ *  into level 0, etc.  The thread sleeps until the first tick that
+ *  has something to do, or for ever if no timer is started.
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;          /*!< Signalled to wake the timer-service thread. */
+    pthread_cond_t callbackDone;  /*!< Broadcast whenever a callback returns. */
+    pthread_t thread;
+    bool running;
+    bool exit;
+    uint64_t currentTick;         /*!< The next tick to be processed. */
+    uint64_t wakeTick;            /*!< When the thread next wakes, UINT64_MAX for never. */
+    size_t count;                 /*!< The number of timers in the wheel. */
+    uPortTimer_t *pSlot[U_PORT_OS_TIMER_WHEEL_NUM_LEVELS][U_PORT_OS_TIMER_WHEEL_NUM_SLOTS];
+    uPortTimer_t *pExpired;       /*!< Expired timers, oldest first. */
+    uPortTimer_t **ppExpiredTail; /*!< The pNext of the last expired timer. */
+    uPortTimer_t *pCallbackTimer; /*!< The timer whose callback is being called. */
+} uPortTimerWheel_t;
+
 /** Threads are implemented using Posix pthreads. As the Posix api wants the callback
  *  to return a void pointer we have to use this struct as a middle man.
 */
@@ -163,6 +227,12 @@ uLinkedList_t *gpThreadList = NULL;
 uPortMutexHandle_t gMutexTimer = NULL;
 uLinkedList_t *gpTimerList = NULL;
 
+// The timer wheel; the mutex is statically initialised so that
+// timers may be deleted even after the port is deinitialised.
+static uPortTimerWheel_t gTimerWheel = {.mutex = PTHREAD_MUTEX_INITIALIZER,
+                                        .ppExpiredTail = &gTimerWheel.pExpired
+                                       };
+
 // Posix has no suspend/resume functions for threads and this is needed
 // for the critical section implementation of the port layer. We therefore
 // use a mutex in combination with a Linux signal USR1 to achieve this.
@@ -247,32 +317,316 @@ static int32_t suspendOrResumeAllTasks(bool suspend)
 }
 #endif
 
-// Posix timer callback function in required format.
-static void timerCallback(union sigval sv)
+// Get the current CLOCK_MONOTONIC time as a timer wheel tick.
+static uint64_t timerWheelTickNow()
 {
-    uPortTimer_t *pTimer = (uPortTimer_t *)sv.sival_ptr;
-    pTimer->pCallback(pTimer, pTimer->pCallbackParam);
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((uint64_t) t.tv_sec * 1000) + (t.tv_nsec / 1000000);
 }
 
-// Read from a queue if an event is available.
-static uErrorCode_t readFromQueue(uPortQueue_t *pQueue,
-                                  void *pEventData)
+// Put a timer into the slot of the wheel for its expiry tick; the
+// timer must not be in a list and the wheel mutex must be locked.
+static void timerWheelInsert(uPortTimer_t *pTimer)
 {
-    uErrorCode_t errorCode = U_ERROR_COMMON_EMPTY;
-    MTX_FN(uPortMutexLock(pQueue->mutex));
-    if (pQueue->readCount >= pQueue->itemSizeBytes) {
-        errorCode = U_ERROR_COMMON_TRUNCATED;
-        size_t readCount = read(pQueue->fd[0], pEventData, pQueue->itemSizeBytes);
-        if (readCount == pQueue->itemSizeBytes) {
-            errorCode = U_ERROR_COMMON_SUCCESS;
+    uPortTimerWheel_t *pWheel = &gTimerWheel;
+    uint64_t tick;
+    uint64_t delta;
+    size_t level = 0;
+    uPortTimer_t **ppSlot;
+
+    if (pTimer->expiryTick < pWheel->currentTick) {
+        // Overdue: do it on the next tick
+        pTimer->expiryTick = pWheel->currentTick;
+    }
+    tick = pTimer->expiryTick;
+    delta = tick - pWheel->currentTick;
+    while ((level < U_PORT_OS_TIMER_WHEEL_NUM_LEVELS - 1) &&
+           ((delta >> ((level + 1) * U_PORT_OS_TIMER_WHEEL_LEVEL_BITS)) != 0)) {
+        level++;
+    }
+    if ((delta >> (U_PORT_OS_TIMER_WHEEL_NUM_LEVELS * U_PORT_OS_TIMER_WHEEL_LEVEL_BITS)) != 0) {
+        // Beyond the reach of the wheel: park the timer as far out
+        // as possible, it will be sorted again from there
+        tick = pWheel->currentTick +
+               (1ULL << (U_PORT_OS_TIMER_WHEEL_NUM_LEVELS * U_PORT_OS_TIMER_WHEEL_LEVEL_BITS)) - 1;
+    }
+    ppSlot = &(pWheel->pSlot[level][U_PORT_OS_TIMER_WHEEL_INDEX(tick, level)]);
+    pTimer->pNext = *ppSlot;
+    if (pTimer->pNext != NULL) {
+        pTimer->pNext->ppPrev = &(pTimer->pNext);
+    }
+    *ppSlot = pTimer;
+    pTimer->ppPrev = ppSlot;
+    pTimer->expired = false;
+}
+
+// Take a timer out of whichever list it is in, if any; the wheel
+// mutex must be locked.
+static void timerWheelRemove(uPortTimer_t *pTimer)
+{
+    uPortTimerWheel_t *pWheel = &gTimerWheel;
+
+    if (pTimer->ppPrev != NULL) {
+        *(pTimer->ppPrev) = pTimer->pNext;
+        if (pTimer->pNext != NULL) {
+            pTimer->pNext->ppPrev = pTimer->ppPrev;
+        } else if (pTimer->expired) {
+            pWheel->ppExpiredTail = pTimer->ppPrev;
+        }
+        if (!pTimer->expired) {
+            pWheel->count--;
+        }
+        pTimer->pNext = NULL;
+        pTimer->ppPrev = NULL;
+        pTimer->expired = false;
+    }
+}
+
+// Empty a slot of the wheel, either into the list of expired timers,
+// if it is a slot of level 0, or into the lower levels of the wheel;
+// the wheel mutex must be locked.
+static void timerWheelEmptySlot(size_t level, size_t index)
+{
+    uPortTimerWheel_t *pWheel = &gTimerWheel;
+    uPortTimer_t *pTimer = pWheel->pSlot[level][index];
+    uPortTimer_t *pNext;
+
+    pWheel->pSlot[level][index] = NULL;
+    while (pTimer != NULL) {
+        pNext = pTimer->pNext;
+        if ((level > 0) || (pTimer->expiryTick > pWheel->currentTick)) {
+            timerWheelInsert(pTimer);
+        } else {
+            pTimer->pNext = NULL;
+            pTimer->ppPrev = pWheel->ppExpiredTail;
+            *(pWheel->ppExpiredTail) = pTimer;
+            pWheel->ppExpiredTail = &(pTimer->pNext);
+            pTimer->expired = true;
+            pWheel->count--;
         }
-        if (readCount >= 0) {
-            pQueue->readCount -= readCount;
+        pTimer = pNext;
+    }
+}
+
+// Turn the wheel up to and including the given tick; the wheel
+// mutex must be locked.
+static void timerWheelAdvance(uint64_t tick)
+{
+    uPortTimerWheel_t *pWheel = &gTimerWheel;
+    size_t level;
+
+    while (pWheel->currentTick <= tick) {
+        if (pWheel->count == 0) {
+            // Nothing in the wheel, no need to turn it
+            pWheel->currentTick = tick + 1;
         } else {
-            errorCode = U_ERROR_COMMON_PLATFORM;
+            // When a level wraps, bring down the next slot of the
+            // level above it
+            for (level = 1; (level < U_PORT_OS_TIMER_WHEEL_NUM_LEVELS) &&
+                 (U_PORT_OS_TIMER_WHEEL_INDEX(pWheel->currentTick, level - 1) == 0); level++) {
+                timerWheelEmptySlot(level, U_PORT_OS_TIMER_WHEEL_INDEX(pWheel->currentTick, level));
+            }
+            timerWheelEmptySlot(0, U_PORT_OS_TIMER_WHEEL_INDEX(pWheel->currentTick, 0));
+            pWheel->currentTick++;
         }
     }
-    MTX_FN(uPortMutexUnlock(pQueue->mutex));
+}
+
+// Work out the next tick on which the wheel has something to do;
+// the wheel mutex must be locked.
+static uint64_t timerWheelNextTick()
+{
+    uPortTimerWheel_t *pWheel = &gTimerWheel;
+    uint64_t tick = UINT64_MAX;
+    uint64_t x;
+
+    if (pWheel->count > 0) {
+        // Unless something turns up below, wake up at the
+        // second wrap of level 0 from now
+        tick = ((pWheel->currentTick + U_PORT_OS_TIMER_WHEEL_SLOT_MASK) &
+                ~((uint64_t) U_PORT_OS_TIMER_WHEEL_SLOT_MASK)) + U_PORT_OS_TIMER_WHEEL_NUM_SLOTS;
+        for (size_t y = 0; y < U_PORT_OS_TIMER_WHEEL_NUM_SLOTS; y++) {
+            x = pWheel->currentTick + y;
+            if ((U_PORT_OS_TIMER_WHEEL_INDEX(x, 0) == 0) &&
+                ((pWheel->pSlot[1][U_PORT_OS_TIMER_WHEEL_INDEX(x, 1)] != NULL) ||
+                 (U_PORT_OS_TIMER_WHEEL_INDEX(x, 1) == 0))) {
+                // Level 0 wraps with something to bring down
+                tick = x;
+                break;
+            }
+            if (pWheel->pSlot[0][U_PORT_OS_TIMER_WHEEL_INDEX(x, 0)] != NULL) {
+                tick = x;
+                break;
+            }
+        }
+    }
+
+    return tick;
+}
+
+// The timer-service thread.
+static void *timerWheelTask(void *pParam)
+{
+    uPortTimerWheel_t *pWheel = &gTimerWheel;
+    uPortTimer_t *pTimer;
+    pTimerCallback_t *pCallback;
+    void *pCallbackParam;
+    struct timespec t;
+
+    (void) pParam;
+
+    pthread_mutex_lock(&pWheel->mutex);
+    while (!pWheel->exit) {
+        timerWheelAdvance(timerWheelTickNow());
+        // Call the callbacks of everything that has expired
+        while ((pWheel->pExpired != NULL) && !pWheel->exit) {
+            pTimer = pWheel->pExpired;
+            timerWheelRemove(pTimer);
+            if (pTimer->periodic) {
+                // Keep to the original phase rather than drifting
+                pTimer->expiryTick += (pTimer->intervalMs > 0) ? pTimer->intervalMs : 1;
+                timerWheelInsert(pTimer);
+                pWheel->count++;
+            }
+            pCallback = pTimer->pCallback;
+            pCallbackParam = pTimer->pCallbackParam;
+            pWheel->pCallbackTimer = pTimer;
+            pthread_mutex_unlock(&pWheel->mutex);
+            if (pCallback != NULL) {
+                pCallback((uPortTimerHandle_t) pTimer, pCallbackParam);
+            }
+            pthread_mutex_lock(&pWheel->mutex);
+            pWheel->pCallbackTimer = NULL;
+            pthread_cond_broadcast(&pWheel->callbackDone);
+        }
+        if (!pWheel->exit) {
+            pWheel->wakeTick = timerWheelNextTick();
+            if (pWheel->wakeTick == UINT64_MAX) {
+                pthread_cond_wait(&pWheel->wake, &pWheel->mutex);
+            } else {
+                t.tv_sec = pWheel->wakeTick / 1000;
+                t.tv_nsec = (pWheel->wakeTick % 1000) * 1000000;
+                pthread_cond_timedwait(&pWheel->wake, &pWheel->mutex, &t);
+            }
+        }
+    }
+    pthread_mutex_unlock(&pWheel->mutex);
+
+    return NULL;
+}
+
+// Start the timer-service thread.
+static int32_t timerWheelStart()
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_SUCCESS;
+    uPortTimerWheel_t *pWheel = &gTimerWheel;
+    pthread_condattr_t condAttr;
+
+    if (!pWheel->running) {
+        errorCode = U_ERROR_COMMON_PLATFORM;
+        pthread_condattr_init(&condAttr);
+        pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+        if (pthread_cond_init(&pWheel->wake, &condAttr) == 0) {
+            if (pthread_cond_init(&pWheel->callbackDone, NULL) == 0) {
+                pWheel->exit = false;
+                pWheel->wakeTick = UINT64_MAX;
+                if (pthread_create(&pWheel->thread, NULL, timerWheelTask, NULL) == 0) {
+                    pWheel->running = true;
+                    errorCode = U_ERROR_COMMON_SUCCESS;
+                } else {
+                    pthread_cond_destroy(&pWheel->callbackDone);
+                    pthread_cond_destroy(&pWheel->wake);
+                }
+            } else {
+                pthread_cond_destroy(&pWheel->wake);
+            }
+        }
+        pthread_condattr_destroy(&condAttr);
+    }
+
+    return (int32_t) errorCode;
+}
+
+// Stop the timer-service thread; any timers that are started
+// remain in the wheel but their callbacks will not be called.
+static void timerWheelStop()
+{
+    uPortTimerWheel_t *pWheel = &gTimerWheel;
+
+    if (pWheel->running) {
+        pthread_mutex_lock(&pWheel->mutex);
+        pWheel->exit = true;
+        pthread_cond_signal(&pWheel->wake);
+        pthread_mutex_unlock(&pWheel->mutex);
+        pthread_join(pWheel->thread, NULL);
+        pthread_cond_destroy(&pWheel->callbackDone);
+        pthread_cond_destroy(&pWheel->wake);
+        pWheel->running = false;
+    }
+}
+
+// Create an absolute CLOCK_MONOTONIC time structure for a wait
+// of the given number of milliseconds from now.
+static void msToMonotonicTimeSpec(int32_t ms, struct timespec *t)
+{
+    clock_gettime(CLOCK_MONOTONIC, t);
+    t->tv_sec += ms / 1000;
+    t->tv_nsec += (ms % 1000) * 1000000;
+    if (t->tv_nsec >= 1000000000) {
+        t->tv_nsec -= 1000000000;
+        t->tv_sec++;
+    }
+}
+
+// Wait for an item to be in a queue, for ever if waitMs is negative;
+// must be called with the queue mutex locked.
+static uErrorCode_t waitForItem(uPortQueue_t *pQueue, int32_t waitMs)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_SUCCESS;
+    struct timespec t;
+
+    if (waitMs > 0) {
+        msToMonotonicTimeSpec(waitMs, &t);
+    }
+    while ((pQueue->count == 0) && (errorCode == U_ERROR_COMMON_SUCCESS)) {
+        if (waitMs < 0) {
+            pthread_cond_wait(&pQueue->notEmpty, &pQueue->mutex);
+        } else if ((waitMs == 0) ||
+                   (pthread_cond_timedwait(&pQueue->notEmpty, &pQueue->mutex, &t) == ETIMEDOUT)) {
+            errorCode = U_ERROR_COMMON_TIMEOUT;
+        }
+    }
+
+    return errorCode;
+}
+
+// Receive from a queue, waiting for ever if waitMs is negative.
+static uErrorCode_t receiveFromQueue(uPortQueue_t *pQueue, void *pEventData,
+                                     int32_t waitMs)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pQueue != NULL) && (pEventData != NULL)) {
+        pthread_mutex_lock(&pQueue->mutex);
+        errorCode = waitForItem(pQueue, waitMs);
+        if (errorCode == U_ERROR_COMMON_SUCCESS) {
+            memcpy(pEventData, pQueue->pBuffer + (pQueue->readIndex * pQueue->itemSizeBytes),
+                   pQueue->itemSizeBytes);
+            pQueue->readIndex++;
+            if (pQueue->readIndex >= pQueue->queueLength) {
+                pQueue->readIndex = 0;
+            }
+            pQueue->count--;
+        }
+        pthread_mutex_unlock(&pQueue->mutex);
+        if (errorCode == U_ERROR_COMMON_SUCCESS) {
+            // Signal outside the lock so that a woken sender
+            // doesn't immediately block on the mutex
+            pthread_cond_signal(&pQueue->notFull);
+        }
+    }
+
     return errorCode;
 }
 
@@ -340,6 +694,9 @@ int32_t uPortOsPrivateInit(void)
     if ((errorCode == 0) && (gMutexCriticalSection == NULL)) {
         errorCode = MTX_FN(uPortMutexCreate(&gMutexCriticalSection));
     }
+    if (errorCode == 0) {
+        errorCode = timerWheelStart();
+    }
     if (errorCode != 0) {
         // Tidy up on error
         if (gMutexThread != NULL) {
@@ -361,6 +718,8 @@ int32_t uPortOsPrivateInit(void)
 // De-initialise the private bits of the OS of the porting layer.
 void uPortOsPrivateDeinit(void)
 {
+    timerWheelStop();
+
     if (gMutexTimer != NULL) {
         MTX_FN(uPortMutexLock(gMutexTimer));
         // Tidy away the timers
@@ -510,33 +869,41 @@ int32_t uPortQueueCreate(size_t queueLength,
                          uPortQueueHandle_t *pQueueHandle)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-    if (pQueueHandle != NULL) {
+    pthread_condattr_t condAttr;
+    if ((pQueueHandle != NULL) && (queueLength > 0) && (itemSizeBytes > 0)) {
         errorCode = U_ERROR_COMMON_NO_MEMORY;
-        uPortQueue_t *pQueue = (uPortQueue_t *)pUPortMalloc(sizeof(uPortQueue_t));
+        // The item storage goes on the end of the structure
+        uPortQueue_t *pQueue = (uPortQueue_t *)pUPortMalloc(sizeof(uPortQueue_t) +
+                                                            (queueLength * itemSizeBytes));
         if (pQueue) {
-            uPortMutexHandle_t mutex;
-            uPortSemaphoreHandle_t semHandle;
-            if (uPortSemaphoreCreate(&semHandle, 0, queueLength) != 0) {
-                uPortFree(pQueue);
-            } else if (MTX_FN(uPortMutexCreate(&mutex)) == 0) {
-                // Create a non blocking pipe.
-                if (pipe2(pQueue->fd, O_NONBLOCK) == 0) {
-                    if (queueLength * itemSizeBytes < fcntl(pQueue->fd[1], F_GETPIPE_SZ)) {
-                        pQueue->mutex = mutex;
-                        pQueue->semHandle = semHandle;
+            errorCode = U_ERROR_COMMON_PLATFORM;
+            pthread_condattr_init(&condAttr);
+            pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+            if (pthread_mutex_init(&pQueue->mutex, NULL) == 0) {
+                if (pthread_cond_init(&pQueue->notEmpty, &condAttr) == 0) {
+                    if (pthread_cond_init(&pQueue->notFull, &condAttr) == 0) {
+                        pQueue->pBuffer = (char *) (pQueue + 1);
                         pQueue->queueLength = queueLength;
                         pQueue->itemSizeBytes = itemSizeBytes;
-                        pQueue->readCount = 0;
+                        pQueue->readIndex = 0;
+                        pQueue->count = 0;
                         *pQueueHandle = pQueue;
                         errorCode = U_ERROR_COMMON_SUCCESS;
                         U_ATOMIC_INCREMENT(&gResourceAllocCount);
-                        U_PORT_OS_DEBUG_PRINT_QUEUE_CREATE(*pQueueHandle, queueLength, itemSizeBytes);
+                        U_PORT_OS_DEBUG_PRINT_QUEUE_CREATE(*pQueueHandle, queueLength,
+                                                           itemSizeBytes);
+                    } else {
+                        pthread_cond_destroy(&pQueue->notEmpty);
+                        pthread_mutex_destroy(&pQueue->mutex);
                     }
                 } else {
-                    MTX_FN(uPortMutexDelete(mutex));
-                    uPortFree(pQueue);
+                    pthread_mutex_destroy(&pQueue->mutex);
                 }
             }
+            pthread_condattr_destroy(&condAttr);
+            if (errorCode != U_ERROR_COMMON_SUCCESS) {
+                uPortFree(pQueue);
+            }
         }
     }
     return (int32_t) errorCode;
@@ -548,10 +915,9 @@ int32_t uPortQueueDelete(const uPortQueueHandle_t queueHandle)
     uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
     uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
     if (pQueue != NULL) {
-        close(pQueue->fd[0]);
-        close(pQueue->fd[1]);
-        MTX_FN(uPortMutexDelete(pQueue->mutex));
-        uPortSemaphoreDelete(pQueue->semHandle);
+        pthread_cond_destroy(&pQueue->notFull);
+        pthread_cond_destroy(&pQueue->notEmpty);
+        pthread_mutex_destroy(&pQueue->mutex);
         uPortFree(pQueue);
         errorCode = U_ERROR_COMMON_SUCCESS;
         U_ATOMIC_DECREMENT(&gResourceAllocCount);
@@ -566,20 +932,23 @@ int32_t uPortQueueSend(const uPortQueueHandle_t queueHandle,
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
     uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
-    if (pQueue != NULL) {
-        errorCode = U_ERROR_COMMON_TRUNCATED;
-        MTX_FN(uPortMutexLock(pQueue->mutex));
-        size_t writeCount = write(pQueue->fd[1], pEventData, pQueue->itemSizeBytes);
-        if (writeCount == pQueue->itemSizeBytes) {
-            errorCode = U_ERROR_COMMON_SUCCESS;
+    size_t writeIndex;
+    if ((pQueue != NULL) && (pEventData != NULL)) {
+        pthread_mutex_lock(&pQueue->mutex);
+        // Block until there is room
+        while (pQueue->count >= pQueue->queueLength) {
+            pthread_cond_wait(&pQueue->notFull, &pQueue->mutex);
         }
-        if (writeCount >= 0) {
-            pQueue->readCount += writeCount;
-        } else {
-            errorCode = U_ERROR_COMMON_PLATFORM;
+        writeIndex = pQueue->readIndex + pQueue->count;
+        if (writeIndex >= pQueue->queueLength) {
+            writeIndex -= pQueue->queueLength;
         }
-        MTX_FN(uPortMutexUnlock(pQueue->mutex));
-        uPortSemaphoreGive(pQueue->semHandle);
+        memcpy(pQueue->pBuffer + (writeIndex * pQueue->itemSizeBytes), pEventData,
+               pQueue->itemSizeBytes);
+        pQueue->count++;
+        pthread_mutex_unlock(&pQueue->mutex);
+        pthread_cond_signal(&pQueue->notEmpty);
+        errorCode = U_ERROR_COMMON_SUCCESS;
     }
     return (int32_t)errorCode;
 }
@@ -596,14 +965,7 @@ int32_t uPortQueueSendIrq(const uPortQueueHandle_t queueHandle,
 int32_t uPortQueueReceive(const uPortQueueHandle_t queueHandle,
                           void *pEventData)
 {
-    uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
-    uErrorCode_t errorCode = readFromQueue(pQueue, pEventData);
-    while (errorCode == U_ERROR_COMMON_EMPTY) {
-        // Not available, blocking wait.
-        uPortSemaphoreTake(pQueue->semHandle);
-        errorCode = readFromQueue(pQueue, pEventData);
-    }
-    return (int32_t)errorCode;
+    return (int32_t) receiveFromQueue((uPortQueue_t *) queueHandle, pEventData, -1);
 }
 
 // Receive from the given queue, non-blocking.
@@ -617,23 +979,28 @@ int32_t uPortQueueReceiveIrq(const uPortQueueHandle_t queueHandle,
 int32_t uPortQueueTryReceive(const uPortQueueHandle_t queueHandle,
                              int32_t waitMs, void *pEventData)
 {
-    uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
-    uErrorCode_t errorCode = readFromQueue(pQueue, pEventData);
-    if (errorCode != U_ERROR_COMMON_SUCCESS) {
-        // Not available, timeout wait.
-        errorCode = uPortSemaphoreTryTake(pQueue->semHandle, waitMs);
-        if (errorCode == U_ERROR_COMMON_SUCCESS) {
-            errorCode = readFromQueue(pQueue, pEventData);
-        }
+    if (waitMs < 0) {
+        waitMs = 0;
     }
-    return (int32_t)errorCode;
+    return (int32_t) receiveFromQueue((uPortQueue_t *) queueHandle, pEventData, waitMs);
 }
 
 // Peek the given queue.
 int32_t uPortQueuePeek(const uPortQueueHandle_t queueHandle,
                        void *pEventData)
 {
-    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+    uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
+    if ((pQueue != NULL) && (pEventData != NULL)) {
+        pthread_mutex_lock(&pQueue->mutex);
+        errorCode = waitForItem(pQueue, 0);
+        if (errorCode == U_ERROR_COMMON_SUCCESS) {
+            memcpy(pEventData, pQueue->pBuffer + (pQueue->readIndex * pQueue->itemSizeBytes),
+                   pQueue->itemSizeBytes);
+        }
+        pthread_mutex_unlock(&pQueue->mutex);
+    }
+    return (int32_t)errorCode;
 }
 
 // Get the number of free spaces in the given queue.
@@ -642,9 +1009,9 @@ int32_t uPortQueueGetFree(const uPortQueueHandle_t queueHandle)
     uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
     if (pQueue != NULL) {
         int32_t freeSpaces;
-        MTX_FN(uPortMutexLock(pQueue->mutex));
-        freeSpaces = pQueue->queueLength - (pQueue->readCount / pQueue->itemSizeBytes);
-        MTX_FN(uPortMutexUnlock(pQueue->mutex));
+        pthread_mutex_lock(&pQueue->mutex);
+        freeSpaces = (int32_t) (pQueue->queueLength - pQueue->count);
+        pthread_mutex_unlock(&pQueue->mutex);
         return freeSpaces;
     } else {
         return (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
@@ -887,25 +1254,15 @@ int32_t uPortTimerCreate(uPortTimerHandle_t *pTimerHandle,
         errorCode = U_ERROR_COMMON_NO_MEMORY;
         uPortTimer_t *pTimer = pUPortMalloc(sizeof(uPortTimer_t));
         if (pTimer != NULL) {
-            errorCode = U_ERROR_COMMON_PLATFORM;
-            struct sigevent sev = {0};
-            sev.sigev_notify = SIGEV_THREAD;
-            sev.sigev_notify_function = timerCallback;
-            sev.sigev_value.sival_ptr = (void *)pTimer;
+            memset(pTimer, 0, sizeof(*pTimer));
+            pTimer->intervalMs = intervalMs;
             pTimer->periodic = periodic;
             pTimer->pCallback = pCallback;
             pTimer->pCallbackParam = pCallbackParam;
-            msToTimeSpec((int32_t)intervalMs, &(pTimer->timerSpec.it_value), false);
-            msToTimeSpec(pTimer->periodic ? (int32_t)intervalMs : 0,
-                         &(pTimer->timerSpec.it_interval), false);
-            if (timer_create(CLOCK_REALTIME, &sev, &(pTimer->timerId)) == 0) {
-                *pTimerHandle = (uPortTimerHandle_t *)pTimer;
-                errorCode = U_ERROR_COMMON_SUCCESS;
-                U_ATOMIC_INCREMENT(&gResourceAllocCount);
-                U_PORT_OS_DEBUG_PRINT_TIMER_CREATE(*pTimerHandle, pName, intervalMs, periodic);
-            } else {
-                uPortFree(pTimer);
-            }
+            *pTimerHandle = (uPortTimerHandle_t *)pTimer;
+            errorCode = U_ERROR_COMMON_SUCCESS;
+            U_ATOMIC_INCREMENT(&gResourceAllocCount);
+            U_PORT_OS_DEBUG_PRINT_TIMER_CREATE(*pTimerHandle, pName, intervalMs, periodic);
         }
     }
     return (int32_t)errorCode;
@@ -916,14 +1273,20 @@ int32_t uPortTimerDelete(const uPortTimerHandle_t timerHandle)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
     if (timerHandle != NULL) {
-        errorCode = U_ERROR_COMMON_PLATFORM;
         uPortTimer_t *pTimer = (uPortTimer_t *)timerHandle;
-        if (timer_delete(pTimer->timerId) == 0) {
-            uPortFree(pTimer);
-            errorCode = U_ERROR_COMMON_SUCCESS;
-            U_ATOMIC_DECREMENT(&gResourceAllocCount);
-            U_PORT_OS_DEBUG_PRINT_TIMER_DELETE(timerHandle);
+        pthread_mutex_lock(&gTimerWheel.mutex);
+        timerWheelRemove(pTimer);
+        // If the callback of this timer is being called, wait for
+        // it to return, unless this is that callback
+        while ((gTimerWheel.pCallbackTimer == pTimer) &&
+               !pthread_equal(pthread_self(), gTimerWheel.thread)) {
+            pthread_cond_wait(&gTimerWheel.callbackDone, &gTimerWheel.mutex);
         }
+        pthread_mutex_unlock(&gTimerWheel.mutex);
+        uPortFree(pTimer);
+        errorCode = U_ERROR_COMMON_SUCCESS;
+        U_ATOMIC_DECREMENT(&gResourceAllocCount);
+        U_PORT_OS_DEBUG_PRINT_TIMER_DELETE(timerHandle);
     }
     return (int32_t)errorCode;
 }
@@ -933,11 +1296,29 @@ int32_t uPortTimerStart(const uPortTimerHandle_t timerHandle)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
     if (timerHandle != NULL) {
-        errorCode = U_ERROR_COMMON_PLATFORM;
+        errorCode = U_ERROR_COMMON_NOT_INITIALISED;
         uPortTimer_t *pTimer = (uPortTimer_t *)timerHandle;
-        if (timer_settime(pTimer->timerId, 0, &(pTimer->timerSpec), NULL) == 0) {
+        uint64_t now = timerWheelTickNow();
+        pthread_mutex_lock(&gTimerWheel.mutex);
+        if (gTimerWheel.running) {
+            timerWheelRemove(pTimer);
+            if ((gTimerWheel.count == 0) && (gTimerWheel.currentTick < now)) {
+                // The wheel is empty and so may jump forward
+                gTimerWheel.currentTick = now;
+            }
+            // Plus one since now is part way through a tick and
+            // the timer must not expire early
+            pTimer->expiryTick = now + pTimer->intervalMs + 1;
+            timerWheelInsert(pTimer);
+            gTimerWheel.count++;
+            if (pTimer->expiryTick < gTimerWheel.wakeTick) {
+                // Get the timer-service thread to re-think when it wakes up
+                gTimerWheel.wakeTick = pTimer->expiryTick;
+                pthread_cond_signal(&gTimerWheel.wake);
+            }
             errorCode = U_ERROR_COMMON_SUCCESS;
         }
+        pthread_mutex_unlock(&gTimerWheel.mutex);
     }
     return (int32_t)errorCode;
 }
@@ -947,18 +1328,18 @@ int32_t uPortTimerStop(const uPortTimerHandle_t timerHandle)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
     if (timerHandle != NULL) {
-        errorCode = U_ERROR_COMMON_PLATFORM;
         uPortTimer_t *pTimer = (uPortTimer_t *)timerHandle;
-        struct itimerspec its;
-        memset(&its, 0, sizeof(its));
-        if (timer_settime(pTimer->timerId, 0, &its, NULL) == 0) {
-            errorCode = U_ERROR_COMMON_SUCCESS;
-        }
+        pthread_mutex_lock(&gTimerWheel.mutex);
+        timerWheelRemove(pTimer);
+        pthread_mutex_unlock(&gTimerWheel.mutex);
+        errorCode = U_ERROR_COMMON_SUCCESS;
     }
     return (int32_t)errorCode;
 }
 
-// Change a timer interval.
+// Change a timer interval; a timer that is running will pick
+// up the new interval the next time it is started or, if it is
+// periodic, after it has next expired.
 int32_t uPortTimerChange(const uPortTimerHandle_t timerHandle,
                          uint32_t intervalMs)
 {
@@ -966,9 +1347,9 @@ int32_t uPortTimerChange(const uPortTimerHandle_t timerHandle,
     if (timerHandle != NULL) {
         errorCode = U_ERROR_COMMON_SUCCESS;
         uPortTimer_t *pTimer = (uPortTimer_t *)timerHandle;
-        msToTimeSpec((int32_t)intervalMs, &(pTimer->timerSpec.it_value), false);
-        msToTimeSpec(pTimer->periodic ? (int32_t)intervalMs : 0,
-                     &(pTimer->timerSpec.it_interval), false);
+        pthread_mutex_lock(&gTimerWheel.mutex);
+        pTimer->intervalMs = intervalMs;
+        pthread_mutex_unlock(&gTimerWheel.mutex);
     }
     return (int32_t)errorCode;
 }
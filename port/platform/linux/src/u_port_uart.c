@@ -31,9 +31,11 @@
 #include "fcntl.h"
 #include "termios.h"
 #include "unistd.h"
-#include "sys/select.h"
+#include "sys/epoll.h"
+#include "sys/eventfd.h"
 #include "pthread.h"  // threadId
 #include "sys/ioctl.h"
+#include "sys/uio.h"   // writev()
 #include "sys/param.h"
 #include "u_error_common.h"
 #include "u_linked_list.h"
@@ -54,17 +56,33 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-#ifndef U_PORT_UART_READ_WAIT_MS
-/** How long to wait when there is nothing to read from the UART.
+#ifndef U_PORT_UART_IO_TASK_STACK_SIZE_BYTES
+/** The stack size of the I/O task that reads from all UARTs.
  */
-# define U_PORT_UART_READ_WAIT_MS 10
+# define U_PORT_UART_IO_TASK_STACK_SIZE_BYTES (1024 * 4)
 #endif
 
-#ifndef U_PORT_UART_START_STOP_WAIT_MS
-/** How long to wait for a UART, mostly the read task, to start up
- * and shut down.
+#ifndef U_PORT_UART_IO_TASK_PRIORITY
+/** The priority of the I/O task that reads from all UARTs.
  */
-# define U_PORT_UART_START_STOP_WAIT_MS (U_PORT_UART_READ_WAIT_MS * 10)
+# define U_PORT_UART_IO_TASK_PRIORITY (U_CFG_OS_PRIORITY_MAX - 5)
+#endif
+
+#ifndef U_PORT_UART_IO_MAX_NUM_EVENTS
+/** The maximum number of events the I/O task will collect from
+ * a single call to epoll_wait(); the array is on the stack of the
+ * I/O task, any more are simply returned by the next call.
+ */
+# define U_PORT_UART_IO_MAX_NUM_EVENTS 8
+#endif
+
+#ifndef U_PORT_UART_WRITEV_MAX_NUM_SEGMENTS
+/** The maximum number of segments that uPortUartWriteV() will pass
+ * to a single writev() call; the iovec array is on the stack, hence
+ * this is kept modest, more segments than this are simply passed
+ * in further calls.
+ */
+# define U_PORT_UART_WRITEV_MAX_NUM_SEGMENTS 16
 #endif
 
 /* ----------------------------------------------------------------
@@ -75,7 +93,9 @@ typedef struct uPortUartData_t {
     int32_t id;
     int uartFd;
     bool markedForDeletion;
-    uPortTaskHandle_t rxTask;
+    bool ioRegistered; // true if uartFd has been added to gEpollFd
+    bool rxPaused; // true if uartFd is not being listened to because the buffer is full
+    bool rxHungUp; // true if uartFd is not being listened to because it has hung up
     uPortMutexHandle_t mutex;
     bool bufferAllocated;
     char *pBuffer;
@@ -129,6 +149,46 @@ static uLinkedList_t *gpUartPrefixList = NULL;
  */
 static volatile int32_t gResourceAllocCount = 0;
 
+/** Mutex to protect the starting and stopping of the I/O task;
+ * if this and gMutex are both to be locked, this must be locked
+ * first.
+ */
+static uPortMutexHandle_t gIoMutex = NULL;
+
+/** Mutex that is held by the I/O task while it is running.
+ */
+static uPortMutexHandle_t gIoTaskRunningMutex = NULL;
+
+/** The handle of the I/O task that reads from all UARTs.
+ */
+static uPortTaskHandle_t gIoTask = NULL;
+
+/** Flag set by the I/O task once it has started.
+ */
+static volatile bool gIoTaskRunning = false;
+
+/** Flag to tell the I/O task to exit.
+ */
+static volatile bool gIoTaskExit = false;
+
+/** The epoll file descriptor that the I/O task waits on; it
+ * listens to the file descriptors of all of the UARTs plus
+ * gEventFd.
+ */
+static int gEpollFd = -1;
+
+/** An eventfd that is used to wake up the I/O task, e.g. when
+ * uPortUartRead() has made space in a full buffer or when the
+ * I/O task is to exit.
+ */
+static int gEventFd = -1;
+
+/** The number of UARTs registered with the I/O task; the I/O
+ * task is started when the first one is registered and stopped
+ * when the last one is deregistered.
+ */
+static size_t gIoUartCount = 0;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -145,76 +205,6 @@ static void eventHandler(void *pParam, size_t paramLength)
     }
 }
 
-// Task handling incoming uart data
-static void readTask(void *pParam)
-{
-    uPortUartData_t *p = (uPortUartData_t *)pParam;
-    // Need a brief pause before calling select after open.
-    uPortTaskBlock(10);
-    while (!p->markedForDeletion) {
-        // Initiate a set for select operation.
-        fd_set set;
-        FD_ZERO(&set);
-        FD_SET(p->uartFd, &set);
-        // Select timeout
-        struct timeval tv = {0};
-        tv.tv_usec = U_CFG_OS_YIELD_MS * 1000;
-        // Wait for input
-        int res = select(p->uartFd + 1, &set, NULL, NULL, &tv);
-        if (res > 0) {
-            // Input is available.
-            int available;
-            do {
-                available = 0;
-                ioctl(p->uartFd, FIONREAD, &available);
-                size_t cnt = 0;
-                size_t tot = 0;
-                // Sample readPos
-                size_t readPos = p->readPos;
-                U_PORT_MUTEX_LOCK(p->mutex);
-                if (p->writePos >= readPos) {
-                    // Write pos ahead of read. Use the remaining area in the
-                    // buffer first.
-                    cnt = MIN(available, p->bufferSize - p->writePos);
-                    cnt = read(p->uartFd, p->pBuffer + p->writePos, cnt);
-                    if (cnt > 0) {
-                        available -= cnt;
-                        p->writePos = (p->writePos + cnt) % p->bufferSize;
-                    }
-                    tot = cnt;
-                }
-                if ((available > 0) && (p->writePos < readPos)) {
-                    // Read pos ahead of write.
-                    cnt = MIN(available, readPos - p->writePos);
-                    cnt = read(p->uartFd, p->pBuffer + p->writePos, cnt);
-                    if (cnt > 0) {
-                        available -= cnt;
-                        p->writePos = (p->writePos + cnt) % p->bufferSize;
-                        // We might have filled up the buffer, in which case we must wait below.
-                        p->bufferFull = p->writePos == readPos;
-                    }
-                    tot += cnt;
-                }
-                U_PORT_MUTEX_UNLOCK(p->mutex);
-                if ((tot > 0) &&
-                    (p->eventQueueHandle >= 0)) {
-                    // Call the user callback
-                    uPortUartEvent_t event;
-                    event.uartHandle = p->uartFd;
-                    event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
-                    event.pEventCallback = p->pEventCallback;
-                    event.pEventCallbackParam = p->pEventCallbackParam;
-                    uPortEventQueueSend(p->eventQueueHandle, &event, sizeof(event));
-                }
-                while (p->bufferFull && !p->markedForDeletion) {
-                    // Buffer is full, wait for consumption.
-                    uPortTaskBlock(U_PORT_UART_READ_WAIT_MS);
-                }
-            } while ((available > 0) && !p->markedForDeletion);
-        }
-    }
-}
-
 static uPortUartPrefix_t *pFindPrefix(pthread_t threadId)
 {
     uLinkedList_t *p = gpUartPrefixList;
@@ -254,16 +244,302 @@ static uPortUartData_t *pFindUartById(int32_t id)
     return NULL;
 }
 
+// Wake up the I/O task.
+static void ioTaskWake()
+{
+    uint64_t one = 1;
+
+    if (write(gEventFd, &one, sizeof(one)) < 0) {
+        // Nothing we can do; the eventfd is non-blocking and can only
+        // fail if its counter is about to overflow, in which case
+        // the I/O task is awake already
+    }
+}
+
+// Enable or disable listening to a UART; must be called with the
+// UART mutex locked.
+static void ioListen(uPortUartData_t *p, bool onNotOff)
+{
+    struct epoll_event event = {0};
+
+    if (onNotOff) {
+        event.events = EPOLLIN;
+    }
+    event.data.fd = p->uartFd;
+    epoll_ctl(gEpollFd, EPOLL_CTL_MOD, p->uartFd, &event);
+}
+
+// Read what is available from a UART into its buffer, returning
+// the number of bytes read; must be called with the UART mutex locked.
+static size_t readIntoBuffer(uPortUartData_t *p)
+{
+    int available = 0;
+    ssize_t cnt = 0;
+    size_t tot = 0;
+
+    ioctl(p->uartFd, FIONREAD, &available);
+    if ((available > 0) && !p->bufferFull) {
+        if (p->writePos >= p->readPos) {
+            // Write pos ahead of read. Use the remaining area in the
+            // buffer first.
+            cnt = MIN((size_t) available, p->bufferSize - p->writePos);
+            cnt = read(p->uartFd, p->pBuffer + p->writePos, cnt);
+            if (cnt > 0) {
+                available -= cnt;
+                p->writePos = (p->writePos + cnt) % p->bufferSize;
+                tot = cnt;
+            }
+        }
+        if ((available > 0) && (p->writePos < p->readPos)) {
+            // Read pos ahead of write.
+            cnt = MIN((size_t) available, p->readPos - p->writePos);
+            cnt = read(p->uartFd, p->pBuffer + p->writePos, cnt);
+            if (cnt > 0) {
+                p->writePos = (p->writePos + cnt) % p->bufferSize;
+                tot += cnt;
+            }
+        }
+        if ((tot > 0) && (p->writePos == p->readPos)) {
+            // We have filled up the buffer: stop listening
+            // until uPortUartRead() has made some space
+            p->bufferFull = true;
+            p->rxPaused = true;
+            ioListen(p, false);
+        }
+    }
+
+    return tot;
+}
+
+// Service an epoll event on a UART.
+static void ioServiceUart(int fd, uint32_t epollEvents)
+{
+    uPortUartData_t *p;
+    size_t received = 0;
+    int32_t eventQueueHandle = -1;
+    uPortUartEvent_t event;
+
+    // gMutex is locked while the UART data is used, which
+    // stops it being disposed of from under us
+    U_PORT_MUTEX_LOCK(gMutex);
+    p = pFindUart(fd);
+    if ((p != NULL) && !p->markedForDeletion) {
+        U_PORT_MUTEX_LOCK(p->mutex);
+        if (!p->rxPaused && !p->rxHungUp) {
+            received = readIntoBuffer(p);
+            if ((received == 0) && ((epollEvents & (EPOLLHUP | EPOLLERR)) != 0)) {
+                // Nothing to read and nothing ever will be: stop
+                // listening or epoll will keep on telling us about it
+                p->rxHungUp = true;
+                ioListen(p, false);
+            }
+        }
+        U_PORT_MUTEX_UNLOCK(p->mutex);
+        if ((received > 0) && (p->eventQueueHandle >= 0)) {
+            eventQueueHandle = p->eventQueueHandle;
+            event.uartHandle = p->uartFd;
+            event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
+            event.pEventCallback = p->pEventCallback;
+            event.pEventCallbackParam = p->pEventCallbackParam;
+        }
+    } else {
+        // Must be on its way out: stop listening to it so that
+        // epoll doesn't keep on telling us about it
+        struct epoll_event ignore = {0};
+        ignore.data.fd = fd;
+        epoll_ctl(gEpollFd, EPOLL_CTL_MOD, fd, &ignore);
+    }
+    U_PORT_MUTEX_UNLOCK(gMutex);
+
+    if (eventQueueHandle >= 0) {
+        // Call the user callback; done outside gMutex since
+        // the callback will likely call uPortUartRead()
+        uPortEventQueueSend(eventQueueHandle, &event, sizeof(event));
+    }
+}
+
+// Resume listening to any UARTs that were paused because their
+// buffer was full and now have space.
+static void ioResumeUarts()
+{
+    uLinkedList_t *pList;
+    uPortUartData_t *p;
+
+    U_PORT_MUTEX_LOCK(gMutex);
+    pList = gpUartList;
+    while (pList != NULL) {
+        p = (uPortUartData_t *) (pList->p);
+        if (!p->markedForDeletion) {
+            U_PORT_MUTEX_LOCK(p->mutex);
+            if (p->rxPaused && !p->bufferFull) {
+                p->rxPaused = false;
+                if (!p->rxHungUp) {
+                    ioListen(p, true);
+                }
+            }
+            U_PORT_MUTEX_UNLOCK(p->mutex);
+        }
+        pList = pList->pNext;
+    }
+    U_PORT_MUTEX_UNLOCK(gMutex);
+}
+
+// The I/O task: waits on gEpollFd for data to arrive on any
+// UART or for gEventFd to be written.
+static void ioTask(void *pParam)
+{
+    struct epoll_event events[U_PORT_UART_IO_MAX_NUM_EVENTS];
+    int numEvents;
+    uint64_t count;
+
+    (void) pParam;
+
+    // Lock the task mutex to indicate that we're running
+    U_PORT_MUTEX_LOCK(gIoTaskRunningMutex);
+    gIoTaskRunning = true;
+
+    while (!gIoTaskExit) {
+        numEvents = epoll_wait(gEpollFd, events,
+                               sizeof(events) / sizeof(events[0]), -1);
+        for (int x = 0; (x < numEvents) && !gIoTaskExit; x++) {
+            if (events[x].data.fd == gEventFd) {
+                // Clear the eventfd and see if any UARTs
+                // can be listened to again
+                if (read(gEventFd, &count, sizeof(count)) == sizeof(count)) {
+                    ioResumeUarts();
+                }
+            } else {
+                ioServiceUart(events[x].data.fd, events[x].events);
+            }
+        }
+    }
+
+    // Unlock the task mutex to indicate we're done
+    U_PORT_MUTEX_UNLOCK(gIoTaskRunningMutex);
+
+    uPortTaskDelete(NULL);
+}
+
+// Stop the I/O task and free its resources; must be called with
+// gIoMutex locked and gMutex NOT locked.
+static void ioStop()
+{
+    if (gIoTask != NULL) {
+        // Tell the task to exit and wait for it to do so
+        gIoTaskExit = true;
+        ioTaskWake();
+        U_PORT_MUTEX_LOCK(gIoTaskRunningMutex);
+        U_PORT_MUTEX_UNLOCK(gIoTaskRunningMutex);
+        gIoTask = NULL;
+        gIoTaskRunning = false;
+    }
+    if (gIoTaskRunningMutex != NULL) {
+        uPortMutexDelete(gIoTaskRunningMutex);
+        gIoTaskRunningMutex = NULL;
+    }
+    if (gEventFd >= 0) {
+        close(gEventFd);
+        gEventFd = -1;
+    }
+    if (gEpollFd >= 0) {
+        close(gEpollFd);
+        gEpollFd = -1;
+    }
+}
+
+// Start the I/O task; must be called with gIoMutex locked.
+static int32_t ioStart()
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+    struct epoll_event event = {0};
+
+    gEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    gEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((gEpollFd >= 0) && (gEventFd >= 0)) {
+        event.events = EPOLLIN;
+        event.data.fd = gEventFd;
+        if (epoll_ctl(gEpollFd, EPOLL_CTL_ADD, gEventFd, &event) == 0) {
+            errorCode = uPortMutexCreate(&gIoTaskRunningMutex);
+            if (errorCode == 0) {
+                gIoTaskExit = false;
+                gIoTaskRunning = false;
+                errorCode = uPortTaskCreate(ioTask, "uartIo",
+                                            U_PORT_UART_IO_TASK_STACK_SIZE_BYTES,
+                                            NULL, U_PORT_UART_IO_TASK_PRIORITY,
+                                            &gIoTask);
+                if (errorCode == 0) {
+                    // Wait for the task to lock its mutex
+                    while (!gIoTaskRunning) {
+                        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                    }
+                } else {
+                    gIoTask = NULL;
+                }
+            }
+        }
+    }
+
+    if (errorCode != 0) {
+        ioStop();
+    }
+
+    return errorCode;
+}
+
+// Add a UART to the set the I/O task listens to, starting the I/O
+// task if required; the UART must already be in gpUartList.
+static int32_t ioRegister(uPortUartData_t *p)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    struct epoll_event event = {0};
+
+    U_PORT_MUTEX_LOCK(gIoMutex);
+    if (gIoUartCount == 0) {
+        errorCode = ioStart();
+    }
+    if (errorCode == 0) {
+        event.events = EPOLLIN;
+        event.data.fd = p->uartFd;
+        if (epoll_ctl(gEpollFd, EPOLL_CTL_ADD, p->uartFd, &event) == 0) {
+            p->ioRegistered = true;
+            gIoUartCount++;
+        } else {
+            errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            if (gIoUartCount == 0) {
+                ioStop();
+            }
+        }
+    }
+    U_PORT_MUTEX_UNLOCK(gIoMutex);
+
+    return errorCode;
+}
+
+// Remove a UART from the set the I/O task listens to, stopping the
+// I/O task if it was the last one.
+static void ioDeregister(uPortUartData_t *p)
+{
+    U_PORT_MUTEX_LOCK(gIoMutex);
+    if (p->ioRegistered) {
+        epoll_ctl(gEpollFd, EPOLL_CTL_DEL, p->uartFd, NULL);
+        p->ioRegistered = false;
+        gIoUartCount--;
+        if (gIoUartCount == 0) {
+            ioStop();
+        }
+    }
+    U_PORT_MUTEX_UNLOCK(gIoMutex);
+}
+
 static void disposeUartData(uPortUartData_t *p)
 {
     if (p != NULL) {
+        ioDeregister(p);
+        // Removing the UART from the list within gMutex
+        // means that the I/O task can no longer be using it
+        U_PORT_MUTEX_LOCK(gMutex);
         uLinkedListRemove(&gpUartList, p);
-        if (p->rxTask != NULL) {
-            uPortTaskDelete(p->rxTask);
-            // Wait for the task to exit before
-            // we pull the structures out from under it
-            uPortTaskBlock(U_PORT_UART_START_STOP_WAIT_MS);
-        }
+        U_PORT_MUTEX_UNLOCK(gMutex);
         if (p->eventQueueHandle >= 0) {
             uPortEventQueueClose(p->eventQueueHandle);
         }
@@ -333,6 +609,13 @@ int32_t uPortUartInit()
     uErrorCode_t errorCode = U_ERROR_COMMON_SUCCESS;
     if (gMutex == NULL) {
         errorCode = uPortMutexCreate(&gMutex);
+        if (errorCode == U_ERROR_COMMON_SUCCESS) {
+            errorCode = uPortMutexCreate(&gIoMutex);
+            if (errorCode != U_ERROR_COMMON_SUCCESS) {
+                uPortMutexDelete(gMutex);
+                gMutex = NULL;
+            }
+        }
     }
     return (int32_t) errorCode;
 }
@@ -372,6 +655,10 @@ void uPortUartDeinit()
         U_PORT_MUTEX_UNLOCK(gMutex);
         uPortMutexDelete(gMutex);
         gMutex = NULL;
+        // The I/O task will have been stopped when the
+        // last UART was disposed of
+        uPortMutexDelete(gIoMutex);
+        gIoMutex = NULL;
     }
 }
 
@@ -506,15 +793,14 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
     if (uPortMutexCreate(&(pUartData->mutex)) != 0) {
         FAIL(U_ERROR_COMMON_NO_MEMORY);
     }
-    if (uPortTaskCreate(readTask, "", 4 * 1024, pUartData, U_CFG_OS_PRIORITY_MAX - 5,
-                        &(pUartData->rxTask)) != 0) {
-        FAIL(U_ERROR_COMMON_PLATFORM);
-    }
-    // Wait for the read task to start
-    uPortTaskBlock(U_PORT_UART_START_STOP_WAIT_MS);
+    // Must be in the list before the I/O task can
+    // be told about it
     U_PORT_MUTEX_LOCK(gMutex);
     uLinkedListAdd(&gpUartList, (void *)pUartData);
     U_PORT_MUTEX_UNLOCK(gMutex);
+    if (ioRegister(pUartData) != 0) {
+        FAIL(U_ERROR_COMMON_PLATFORM);
+    }
     U_ATOMIC_INCREMENT(&gResourceAllocCount);
     pUartData->id = uart;
     return (int32_t)(pUartData->uartFd);
@@ -611,8 +897,10 @@ int32_t uPortUartRead(int32_t handle, void *pBuffer,
                 }
             }
             if (pUartData->bufferFull && (sizeOrErrorCode > 0)) {
-                // Release possible waiting read task.
+                // Wake up the I/O task so that it
+                // starts listening to this UART again
                 pUartData->bufferFull = false;
+                ioTaskWake();
             }
             U_PORT_MUTEX_UNLOCK(pUartData->mutex);
         }
@@ -642,6 +930,64 @@ int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
     return sizeOrErrorCode;
 }
 
+// Scatter-gather write to a UART.
+int32_t uPortUartWriteV(int32_t handle,
+                        const uPortUartSegment_t *pSegments,
+                        size_t numSegments)
+{
+    int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
+    struct iovec iov[U_PORT_UART_WRITEV_MAX_NUM_SEGMENTS];
+    size_t numIov;
+    size_t sizeToWrite;
+    size_t sizeWritten = 0;
+    ssize_t thisSizeWritten;
+    size_t x = 0;
+
+    if (gMutex != NULL) {
+        U_PORT_MUTEX_LOCK(gMutex);
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        uPortUartData_t *pUartData = pFindUart(handle);
+        if (((pSegments != NULL) || (numSegments == 0)) &&
+            (pUartData != NULL) && !pUartData->markedForDeletion) {
+            sizeOrErrorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            while ((x < numSegments) && (sizeOrErrorCode == 0)) {
+                // Gather as many non-empty segments as will fit
+                numIov = 0;
+                sizeToWrite = 0;
+                while ((x < numSegments) && (numIov < U_PORT_UART_WRITEV_MAX_NUM_SEGMENTS)) {
+                    if (pSegments[x].sizeBytes > 0) {
+                        // writev() takes a non-const base pointer but
+                        // does not write to it
+                        iov[numIov].iov_base = (void *) pSegments[x].pData;
+                        iov[numIov].iov_len = pSegments[x].sizeBytes;
+                        sizeToWrite += pSegments[x].sizeBytes;
+                        numIov++;
+                    }
+                    x++;
+                }
+                if (numIov > 0) {
+                    thisSizeWritten = writev(pUartData->uartFd, iov, (int) numIov);
+                    if (thisSizeWritten < 0) {
+                        sizeOrErrorCode = (int32_t)U_ERROR_COMMON_PLATFORM;
+                    } else {
+                        sizeWritten += thisSizeWritten;
+                        if ((size_t) thisSizeWritten < sizeToWrite) {
+                            // Short write, as for uPortUartWrite(),
+                            // return what we managed
+                            break;
+                        }
+                    }
+                }
+            }
+            if (sizeOrErrorCode == 0) {
+                sizeOrErrorCode = (int32_t) sizeWritten;
+            }
+        }
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+    return sizeOrErrorCode;
+}
+
 // Set an event callback.
 int32_t uPortUartEventCallbackSet(int32_t handle,
                                   uint32_t filter,
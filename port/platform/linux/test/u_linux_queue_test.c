@@ -0,0 +1,432 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Tests of the Linux queue implementation: a ping-pong latency
+ * benchmark, comparing the uPortQueue API with a reference queue
+ * built, as uPortQueue used to be, from a pipe, a semaphore and a mutex,
+ * plus checks of behaviour with queues deeper than a pipe could hold.
+ *
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+// For pipe2()
+#define _GNU_SOURCE
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+#include "unistd.h"    // pipe2(), read(), write(), close()
+#include "fcntl.h"     // O_CLOEXEC
+#include "semaphore.h"
+#include "pthread.h"
+#include "time.h"      // clock_gettime()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_debug.h"
+
+#include "u_test_util_resource_check.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_LINUX_QUEUE_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_LINUX_QUEUE_TEST_NUM_ROUND_TRIPS
+/** The number of round trips to make in the ping-pong benchmark.
+ */
+# define U_LINUX_QUEUE_TEST_NUM_ROUND_TRIPS 20000
+#endif
+
+#ifndef U_LINUX_QUEUE_TEST_DEEP_QUEUE_LENGTH
+/** The length of the queue used in the deep-queue test: the
+ * items must add up to more than the 64 kbytes a pipe will
+ * normally hold.
+ */
+# define U_LINUX_QUEUE_TEST_DEEP_QUEUE_LENGTH 10000
+#endif
+
+/** The item value that tells the echo task to exit.
+ */
+#define U_LINUX_QUEUE_TEST_EXIT -1
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The reference queue: a pipe carrying the items, with a
+ * semaphore counting them and a mutex protecting the count of
+ * unread bytes, which is how uPortQueue used to work.
+ */
+typedef struct {
+    int fd[2];
+    sem_t semaphore;
+    pthread_mutex_t mutex;
+    size_t readCount;
+} uLinuxQueueTestPipe_t;
+
+/** An item for the deep-queue test, big enough that the queue
+ * would not fit into a pipe.
+ */
+typedef struct {
+    int32_t index;
+    char padding[12];
+} uLinuxQueueTestItem_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The queues carrying the ping and the pong.
+ */
+static uPortQueueHandle_t gQueuePing = NULL;
+static uPortQueueHandle_t gQueuePong = NULL;
+
+/** The reference queues carrying the ping and the pong.
+ */
+static uLinuxQueueTestPipe_t gPipePing = {.fd = {-1, -1}};
+static uLinuxQueueTestPipe_t gPipePong = {.fd = {-1, -1}};
+
+/** Handle of the echo task.
+ */
+static uPortTaskHandle_t gTaskHandle = NULL;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return the number of nanoseconds from pStart to pEnd.
+static int64_t durationNs(const struct timespec *pStart, const struct timespec *pEnd)
+{
+    return ((int64_t) (pEnd->tv_sec - pStart->tv_sec) * 1000000000) +
+           (pEnd->tv_nsec - pStart->tv_nsec);
+}
+
+// Open a reference queue.
+static bool pipeOpen(uLinuxQueueTestPipe_t *pPipe)
+{
+    bool success = false;
+
+    if (pipe2(pPipe->fd, O_CLOEXEC) == 0) {
+        if (sem_init(&pPipe->semaphore, 0, 0) == 0) {
+            pthread_mutex_init(&pPipe->mutex, NULL);
+            pPipe->readCount = 0;
+            success = true;
+        } else {
+            close(pPipe->fd[0]);
+            close(pPipe->fd[1]);
+            pPipe->fd[0] = -1;
+            pPipe->fd[1] = -1;
+        }
+    }
+
+    return success;
+}
+
+// Close a reference queue.
+static void pipeClose(uLinuxQueueTestPipe_t *pPipe)
+{
+    if (pPipe->fd[0] >= 0) {
+        pthread_mutex_destroy(&pPipe->mutex);
+        sem_destroy(&pPipe->semaphore);
+        close(pPipe->fd[0]);
+        close(pPipe->fd[1]);
+        pPipe->fd[0] = -1;
+        pPipe->fd[1] = -1;
+    }
+}
+
+// Send an item to a reference queue.
+static void pipeSend(uLinuxQueueTestPipe_t *pPipe, int32_t item)
+{
+    pthread_mutex_lock(&pPipe->mutex);
+    if (write(pPipe->fd[1], &item, sizeof(item)) == sizeof(item)) {
+        pPipe->readCount += sizeof(item);
+        sem_post(&pPipe->semaphore);
+    }
+    pthread_mutex_unlock(&pPipe->mutex);
+}
+
+// Receive an item from a reference queue, blocking.
+static int32_t pipeReceive(uLinuxQueueTestPipe_t *pPipe)
+{
+    int32_t item = U_LINUX_QUEUE_TEST_EXIT;
+
+    while (sem_wait(&pPipe->semaphore) != 0) {}
+    pthread_mutex_lock(&pPipe->mutex);
+    if (read(pPipe->fd[0], &item, sizeof(item)) == sizeof(item)) {
+        pPipe->readCount -= sizeof(item);
+    } else {
+        item = U_LINUX_QUEUE_TEST_EXIT;
+    }
+    pthread_mutex_unlock(&pPipe->mutex);
+
+    return item;
+}
+
+// Echo task for uPortQueue: send back whatever arrives on
+// the ping queue on the pong queue.
+static void echoTask(void *pParameters)
+{
+    int32_t item = 0;
+
+    (void) pParameters;
+
+    while (item != U_LINUX_QUEUE_TEST_EXIT) {
+        uPortQueueReceive(gQueuePing, &item);
+        uPortQueueSend(gQueuePong, &item);
+    }
+
+    uPortTaskDelete(NULL);
+}
+
+// Echo task for the reference queue.
+static void echoPipeTask(void *pParameters)
+{
+    int32_t item = 0;
+
+    (void) pParameters;
+
+    while (item != U_LINUX_QUEUE_TEST_EXIT) {
+        item = pipeReceive(&gPipePing);
+        pipeSend(&gPipePong, item);
+    }
+
+    uPortTaskDelete(NULL);
+}
+
+// Task that waits a while and then receives one item from the
+// queue passed in, to unblock a sender.
+static void receiveLaterTask(void *pParameters)
+{
+    uLinuxQueueTestItem_t item;
+
+    uPortTaskBlock(100);
+    uPortQueueReceive((uPortQueueHandle_t) pParameters, &item);
+
+    uPortTaskDelete(NULL);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Ping-pong an item between two tasks, first with uPortQueue and
+ * then with the reference queue, printing the round-trip time.
+ */
+U_PORT_TEST_FUNCTION("[linuxQueue]", "linuxQueuePingPong")
+{
+    int32_t resourceCount;
+    struct timespec startTime;
+    struct timespec endTime;
+    int64_t queueNs;
+    int64_t pipeNs;
+    int32_t item;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // uPortQueue first
+    U_PORT_TEST_ASSERT(uPortQueueCreate(1, sizeof(int32_t), &gQueuePing) == 0);
+    U_PORT_TEST_ASSERT(uPortQueueCreate(1, sizeof(int32_t), &gQueuePong) == 0);
+    U_PORT_TEST_ASSERT(uPortTaskCreate(echoTask, "echoTask",
+                                       U_CFG_OS_APP_TASK_STACK_SIZE_BYTES,
+                                       NULL, U_CFG_OS_APP_TASK_PRIORITY,
+                                       &gTaskHandle) == 0);
+    U_TEST_PRINT_LINE("%d round trip(s) with uPortQueue...",
+                      U_LINUX_QUEUE_TEST_NUM_ROUND_TRIPS);
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (int32_t x = 0; x < U_LINUX_QUEUE_TEST_NUM_ROUND_TRIPS; x++) {
+        U_PORT_TEST_ASSERT(uPortQueueSend(gQueuePing, &x) == 0);
+        U_PORT_TEST_ASSERT(uPortQueueReceive(gQueuePong, &item) == 0);
+        U_PORT_TEST_ASSERT(item == x);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    queueNs = durationNs(&startTime, &endTime);
+    item = U_LINUX_QUEUE_TEST_EXIT;
+    U_PORT_TEST_ASSERT(uPortQueueSend(gQueuePing, &item) == 0);
+    U_PORT_TEST_ASSERT(uPortQueueReceive(gQueuePong, &item) == 0);
+    U_PORT_TEST_ASSERT(item == U_LINUX_QUEUE_TEST_EXIT);
+    // Let the echo task exit
+    uPortTaskBlock(100);
+    gTaskHandle = NULL;
+    uPortQueueDelete(gQueuePing);
+    gQueuePing = NULL;
+    uPortQueueDelete(gQueuePong);
+    gQueuePong = NULL;
+
+    // ...then the reference
+    U_PORT_TEST_ASSERT(pipeOpen(&gPipePing));
+    U_PORT_TEST_ASSERT(pipeOpen(&gPipePong));
+    U_PORT_TEST_ASSERT(uPortTaskCreate(echoPipeTask, "echoPipeTask",
+                                       U_CFG_OS_APP_TASK_STACK_SIZE_BYTES,
+                                       NULL, U_CFG_OS_APP_TASK_PRIORITY,
+                                       &gTaskHandle) == 0);
+    U_TEST_PRINT_LINE("%d round trip(s) with a pipe, a semaphore and a mutex...",
+                      U_LINUX_QUEUE_TEST_NUM_ROUND_TRIPS);
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (int32_t x = 0; x < U_LINUX_QUEUE_TEST_NUM_ROUND_TRIPS; x++) {
+        pipeSend(&gPipePing, x);
+        U_PORT_TEST_ASSERT(pipeReceive(&gPipePong) == x);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    pipeNs = durationNs(&startTime, &endTime);
+    pipeSend(&gPipePing, U_LINUX_QUEUE_TEST_EXIT);
+    U_PORT_TEST_ASSERT(pipeReceive(&gPipePong) == U_LINUX_QUEUE_TEST_EXIT);
+    uPortTaskBlock(100);
+    gTaskHandle = NULL;
+    pipeClose(&gPipePing);
+    pipeClose(&gPipePong);
+
+    U_TEST_PRINT_LINE("round trip: uPortQueue %d ns, pipe/semaphore/mutex %d ns.",
+                      (int32_t) (queueNs / U_LINUX_QUEUE_TEST_NUM_ROUND_TRIPS),
+                      (int32_t) (pipeNs / U_LINUX_QUEUE_TEST_NUM_ROUND_TRIPS));
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Fill a queue that is deeper than a pipe could hold and check
+ * that GetFree, Peek and TryReceive behave, and that a send to a
+ * full queue blocks until there is room.
+ */
+U_PORT_TEST_FUNCTION("[linuxQueue]", "linuxQueueDeep")
+{
+    int32_t resourceCount;
+    uLinuxQueueTestItem_t item;
+    int32_t startTimeMs;
+    int32_t durationMs;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_TEST_PRINT_LINE("filling a queue of %d %d-byte item(s)...",
+                      U_LINUX_QUEUE_TEST_DEEP_QUEUE_LENGTH, sizeof(item));
+    U_PORT_TEST_ASSERT(uPortQueueCreate(U_LINUX_QUEUE_TEST_DEEP_QUEUE_LENGTH,
+                                        sizeof(item), &gQueuePing) == 0);
+    U_PORT_TEST_ASSERT(uPortQueueGetFree(gQueuePing) == U_LINUX_QUEUE_TEST_DEEP_QUEUE_LENGTH);
+    U_PORT_TEST_ASSERT(uPortQueuePeek(gQueuePing, &item) == (int32_t) U_ERROR_COMMON_TIMEOUT);
+    memset(&item, 0, sizeof(item));
+    for (int32_t x = 0; x < U_LINUX_QUEUE_TEST_DEEP_QUEUE_LENGTH; x++) {
+        item.index = x;
+        U_PORT_TEST_ASSERT(uPortQueueSend(gQueuePing, &item) == 0);
+    }
+    U_PORT_TEST_ASSERT(uPortQueueGetFree(gQueuePing) == 0);
+    U_PORT_TEST_ASSERT(uPortQueuePeek(gQueuePing, &item) == 0);
+    U_PORT_TEST_ASSERT(item.index == 0);
+    // Peeking must not remove anything
+    U_PORT_TEST_ASSERT(uPortQueueGetFree(gQueuePing) == 0);
+
+    // A send to the full queue should block until the
+    // task below takes the oldest item off it
+    U_PORT_TEST_ASSERT(uPortTaskCreate(receiveLaterTask, "receiveLaterTask",
+                                       U_CFG_OS_APP_TASK_STACK_SIZE_BYTES,
+                                       gQueuePing, U_CFG_OS_APP_TASK_PRIORITY,
+                                       &gTaskHandle) == 0);
+    startTimeMs = uPortGetTickTimeMs();
+    item.index = U_LINUX_QUEUE_TEST_DEEP_QUEUE_LENGTH;
+    U_PORT_TEST_ASSERT(uPortQueueSend(gQueuePing, &item) == 0);
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("send to a full queue blocked for %d ms.", durationMs);
+    U_PORT_TEST_ASSERT(durationMs >= 50);
+    uPortTaskBlock(100);
+    gTaskHandle = NULL;
+
+    // Everything should come out in order, starting from 1
+    for (int32_t x = 1; x <= U_LINUX_QUEUE_TEST_DEEP_QUEUE_LENGTH; x++) {
+        U_PORT_TEST_ASSERT(uPortQueueTryReceive(gQueuePing, 0, &item) == 0);
+        U_PORT_TEST_ASSERT(item.index == x);
+    }
+    U_PORT_TEST_ASSERT(uPortQueueGetFree(gQueuePing) == U_LINUX_QUEUE_TEST_DEEP_QUEUE_LENGTH);
+
+    // TryReceive on an empty queue should wait and then time out
+    startTimeMs = uPortGetTickTimeMs();
+    U_PORT_TEST_ASSERT(uPortQueueTryReceive(gQueuePing, 100,
+                                            &item) == (int32_t) U_ERROR_COMMON_TIMEOUT);
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("receive from an empty queue timed out after %d ms.", durationMs);
+    U_PORT_TEST_ASSERT(durationMs >= 90);
+
+    uPortQueueDelete(gQueuePing);
+    gQueuePing = NULL;
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[linuxQueue]", "linuxQueueCleanUp")
+{
+    if (gQueuePing != NULL) {
+        uPortQueueDelete(gQueuePing);
+        gQueuePing = NULL;
+    }
+    if (gQueuePong != NULL) {
+        uPortQueueDelete(gQueuePong);
+        gQueuePong = NULL;
+    }
+    pipeClose(&gPipePing);
+    pipeClose(&gPipePong);
+    uPortDeinit();
+}
+
+// End of file
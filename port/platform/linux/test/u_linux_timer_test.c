@@ -0,0 +1,331 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Tests of the Linux timer implementation, the timer wheel:
+ * lots of timers are started and stopped, measuring how long that
+ * takes and how far from the expected time the callbacks are called.
+ *
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+#include "time.h"      // clock_gettime()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_debug.h"
+
+#include "u_test_util_resource_check.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_LINUX_TIMER_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_LINUX_TIMER_TEST_NUM_TIMERS
+/** The number of timers to start and stop; every other one is
+ * stopped before it expires.
+ */
+# define U_LINUX_TIMER_TEST_NUM_TIMERS 10000
+#endif
+
+#ifndef U_LINUX_TIMER_TEST_MAX_INTERVAL_MS
+/** The longest interval of the timers: the intervals are spread
+ * from a few milliseconds up to this, so that the timers land in
+ * more than one level of the timer wheel.
+ */
+# define U_LINUX_TIMER_TEST_MAX_INTERVAL_MS 2000
+#endif
+
+#ifndef U_LINUX_TIMER_TEST_MAX_JITTER_US
+/** The maximum lateness of a timer callback to permit, in
+ * microseconds; deliberately generous since the test may be
+ * running on a loaded machine, what matters is the printed result.
+ */
+# define U_LINUX_TIMER_TEST_MAX_JITTER_US 100000
+#endif
+
+#ifndef U_LINUX_TIMER_TEST_PERIOD_MS
+/** The period of the timer in the periodic test.
+ */
+# define U_LINUX_TIMER_TEST_PERIOD_MS 10
+#endif
+
+#ifndef U_LINUX_TIMER_TEST_NUM_PERIODS
+/** The number of periods to run the periodic test for.
+ */
+# define U_LINUX_TIMER_TEST_NUM_PERIODS 100
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** What is known about a timer under test.
+ */
+typedef struct {
+    uPortTimerHandle_t handle;
+    int32_t intervalMs;
+    int64_t startUs;         /*!< When the timer was started. */
+    int64_t callbackUs;      /*!< When the callback was last called. */
+    volatile int32_t count;  /*!< The number of times the callback was called. */
+} uLinuxTimerTest_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The timers under test.
+ */
+static uLinuxTimerTest_t gTimer[U_LINUX_TIMER_TEST_NUM_TIMERS];
+
+/** The total number of timer callbacks; they are all called from
+ * the one timer-service thread.
+ */
+static volatile int32_t gCallbackCount = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return the CLOCK_MONOTONIC time in microseconds.
+static int64_t timeUs()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((int64_t) t.tv_sec * 1000000) + (t.tv_nsec / 1000);
+}
+
+// Timer callback: note the time and count.
+static void timerCallback(const uPortTimerHandle_t timerHandle, void *pParameter)
+{
+    uLinuxTimerTest_t *pTimer = (uLinuxTimerTest_t *) pParameter;
+
+    (void) timerHandle;
+
+    pTimer->callbackUs = timeUs();
+    pTimer->count++;
+    gCallbackCount++;
+}
+
+// Timer callback that deletes its own timer.
+static void timerCallbackDelete(const uPortTimerHandle_t timerHandle, void *pParameter)
+{
+    uLinuxTimerTest_t *pTimer = (uLinuxTimerTest_t *) pParameter;
+
+    uPortTimerDelete(timerHandle);
+    pTimer->handle = NULL;
+    pTimer->count++;
+}
+
+// Delete all of the timers under test.
+static void deleteTimers()
+{
+    for (size_t x = 0; x < sizeof(gTimer) / sizeof(gTimer[0]); x++) {
+        if (gTimer[x].handle != NULL) {
+            uPortTimerDelete(gTimer[x].handle);
+            gTimer[x].handle = NULL;
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Start lots of one-shot timers, stop half of them and measure
+ * the jitter of the callbacks of the rest.
+ */
+U_PORT_TEST_FUNCTION("[linuxTimer]", "linuxTimerJitter")
+{
+    int32_t resourceCount;
+    int64_t startUs;
+    int64_t startDurationUs;
+    int64_t stopDurationUs;
+    int64_t jitterUs;
+    int64_t minUs = INT64_MAX;
+    int64_t maxUs = INT64_MIN;
+    int64_t totalUs = 0;
+    int32_t numExpected = 0;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    memset(gTimer, 0, sizeof(gTimer));
+    gCallbackCount = 0;
+    for (size_t x = 0; x < U_LINUX_TIMER_TEST_NUM_TIMERS; x++) {
+        gTimer[x].intervalMs = 10 + ((x * 7) % U_LINUX_TIMER_TEST_MAX_INTERVAL_MS);
+        U_PORT_TEST_ASSERT(uPortTimerCreate(&gTimer[x].handle, NULL, timerCallback,
+                                            &gTimer[x], gTimer[x].intervalMs, false) == 0);
+    }
+
+    U_TEST_PRINT_LINE("starting %d timer(s)...", U_LINUX_TIMER_TEST_NUM_TIMERS);
+    startUs = timeUs();
+    for (size_t x = 0; x < U_LINUX_TIMER_TEST_NUM_TIMERS; x++) {
+        gTimer[x].startUs = timeUs();
+        U_PORT_TEST_ASSERT(uPortTimerStart(gTimer[x].handle) == 0);
+    }
+    startDurationUs = timeUs() - startUs;
+
+    // Stop every other one
+    startUs = timeUs();
+    for (size_t x = 1; x < U_LINUX_TIMER_TEST_NUM_TIMERS; x += 2) {
+        U_PORT_TEST_ASSERT(uPortTimerStop(gTimer[x].handle) == 0);
+    }
+    stopDurationUs = timeUs() - startUs;
+    U_TEST_PRINT_LINE("start took %d ns per timer, stop %d ns per timer.",
+                      (int32_t) ((startDurationUs * 1000) / U_LINUX_TIMER_TEST_NUM_TIMERS),
+                      (int32_t) ((stopDurationUs * 2000) / U_LINUX_TIMER_TEST_NUM_TIMERS));
+
+    // Wait for the rest to expire, and a little more in case
+    // any of the stopped ones are going to go off
+    numExpected = (U_LINUX_TIMER_TEST_NUM_TIMERS + 1) / 2;
+    startUs = timeUs();
+    while ((gCallbackCount < numExpected) &&
+           (timeUs() - startUs < (U_LINUX_TIMER_TEST_MAX_INTERVAL_MS + 1000) * 1000LL)) {
+        uPortTaskBlock(100);
+    }
+    uPortTaskBlock(100);
+    U_TEST_PRINT_LINE("%d callback(s), expected %d.", gCallbackCount, numExpected);
+    U_PORT_TEST_ASSERT(gCallbackCount == numExpected);
+
+    for (size_t x = 0; x < U_LINUX_TIMER_TEST_NUM_TIMERS; x++) {
+        if (x & 1) {
+            U_PORT_TEST_ASSERT(gTimer[x].count == 0);
+        } else {
+            U_PORT_TEST_ASSERT(gTimer[x].count == 1);
+            jitterUs = gTimer[x].callbackUs - (gTimer[x].startUs + (gTimer[x].intervalMs * 1000LL));
+            if (jitterUs < minUs) {
+                minUs = jitterUs;
+            }
+            if (jitterUs > maxUs) {
+                maxUs = jitterUs;
+            }
+            totalUs += jitterUs;
+        }
+    }
+    U_TEST_PRINT_LINE("jitter: min %d us, average %d us, max %d us.", (int32_t) minUs,
+                      (int32_t) (totalUs / numExpected), (int32_t) maxUs);
+    // A timer must never expire early
+    U_PORT_TEST_ASSERT(minUs >= 0);
+    U_PORT_TEST_ASSERT(maxUs < U_LINUX_TIMER_TEST_MAX_JITTER_US);
+
+    deleteTimers();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Check that a periodic timer keeps to its period without
+ * drifting, and that a timer may delete itself from its callback.
+ */
+U_PORT_TEST_FUNCTION("[linuxTimer]", "linuxTimerPeriodic")
+{
+    int32_t resourceCount;
+    int64_t driftUs;
+    int32_t count;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    memset(gTimer, 0, sizeof(gTimer));
+    gCallbackCount = 0;
+    U_PORT_TEST_ASSERT(uPortTimerCreate(&gTimer[0].handle, NULL, timerCallback,
+                                        &gTimer[0], U_LINUX_TIMER_TEST_PERIOD_MS, true) == 0);
+    U_PORT_TEST_ASSERT(uPortTimerCreate(&gTimer[1].handle, NULL, timerCallbackDelete,
+                                        &gTimer[1], U_LINUX_TIMER_TEST_PERIOD_MS, false) == 0);
+    U_TEST_PRINT_LINE("running a %d ms periodic timer for %d period(s)...",
+                      U_LINUX_TIMER_TEST_PERIOD_MS, U_LINUX_TIMER_TEST_NUM_PERIODS);
+    gTimer[0].startUs = timeUs();
+    U_PORT_TEST_ASSERT(uPortTimerStart(gTimer[0].handle) == 0);
+    U_PORT_TEST_ASSERT(uPortTimerStart(gTimer[1].handle) == 0);
+    while (gCallbackCount < U_LINUX_TIMER_TEST_NUM_PERIODS) {
+        uPortTaskBlock(1);
+    }
+    U_PORT_TEST_ASSERT(uPortTimerStop(gTimer[0].handle) == 0);
+    count = gTimer[0].count;
+    driftUs = gTimer[0].callbackUs - (gTimer[0].startUs +
+                                      (count * U_LINUX_TIMER_TEST_PERIOD_MS * 1000LL));
+    U_TEST_PRINT_LINE("after %d period(s) the timer was %d us late.", count, (int32_t) driftUs);
+    U_PORT_TEST_ASSERT(driftUs < U_LINUX_TIMER_TEST_MAX_JITTER_US);
+    // Having been stopped, it should stay stopped
+    uPortTaskBlock(U_LINUX_TIMER_TEST_PERIOD_MS * 5);
+    U_PORT_TEST_ASSERT(gTimer[0].count == count);
+
+    // The timer that deleted itself should have done so once
+    U_PORT_TEST_ASSERT(gTimer[1].count == 1);
+    U_PORT_TEST_ASSERT(gTimer[1].handle == NULL);
+
+    deleteTimers();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[linuxTimer]", "linuxTimerCleanUp")
+{
+    deleteTimers();
+    uPortDeinit();
+}
+
+// End of file
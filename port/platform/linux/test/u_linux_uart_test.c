@@ -0,0 +1,361 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Tests of the Linux UART port that need no hardware: a
+ * pseudo-terminal stands in for the UART, the test writing to the
+ * "master" side and the UART port reading from the "slave" side.
+ *
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+// For posix_openpt(), grantpt(), unlockpt() and ptsname()
+#define _GNU_SOURCE
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdlib.h"    // posix_openpt(), ptsname() etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strlen(), strrchr()
+#include "unistd.h"    // write(), close()
+#include "fcntl.h"     // O_RDWR etc.
+#include "termios.h"
+#include "time.h"      // clock_gettime()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port_clib_platform_specific.h" /* Integer stdio, must be included
+                                              before the other port files if
+                                              any print or scan function is used. */
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_debug.h"
+#include "u_port_uart.h"
+
+#include "u_test_util_resource_check.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_LINUX_UART_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_LINUX_UART_TEST_NUM_LATENCY_SAMPLES
+/** The number of times to measure the latency from a byte being
+ * written to the callback being called.
+ */
+# define U_LINUX_UART_TEST_NUM_LATENCY_SAMPLES 200
+#endif
+
+#ifndef U_LINUX_UART_TEST_MAX_LATENCY_US
+/** The maximum latency to permit, in microseconds; deliberately
+ * generous since the test may be running on a loaded machine,
+ * what matters is the printed result.
+ */
+# define U_LINUX_UART_TEST_MAX_LATENCY_US 100000
+#endif
+
+#ifndef U_LINUX_UART_TEST_BUFFER_SIZE
+/** The receive buffer size to use for the UART under test; kept
+ * small so that the buffer-full test is easy to arrange.
+ */
+# define U_LINUX_UART_TEST_BUFFER_SIZE 64
+#endif
+
+#ifndef U_LINUX_UART_TEST_TIMEOUT_MS
+/** How long to wait for data to arrive before giving up.
+ */
+# define U_LINUX_UART_TEST_TIMEOUT_MS 1000
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The master side of the pseudo-terminal.
+ */
+static int gMasterFd = -1;
+
+/** Handle of the UART under test.
+ */
+static int32_t gUartHandle = -1;
+
+/** Semaphore given by the UART event callback.
+ */
+static uPortSemaphoreHandle_t gSemaphore = NULL;
+
+/** The time at which the UART event callback was last called.
+ */
+static struct timespec gCallbackTime;
+
+/** The number of bytes read by the UART event callback.
+ */
+static volatile size_t gBytesRead = 0;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Return the number of microseconds from pStart to pEnd.
+static int64_t durationUs(const struct timespec *pStart, const struct timespec *pEnd)
+{
+    return ((int64_t) (pEnd->tv_sec - pStart->tv_sec) * 1000000) +
+           ((pEnd->tv_nsec - pStart->tv_nsec) / 1000);
+}
+
+// Open a pseudo-terminal and then a UART on its slave side,
+// returning the UART handle.
+static int32_t openPtyUart()
+{
+    int32_t handle = (int32_t) U_ERROR_COMMON_PLATFORM;
+    const char *pSlaveName;
+    const char *pNumber;
+    char prefix[U_PORT_UART_MAX_PREFIX_LENGTH + 1];
+    struct termios options;
+
+    gMasterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((gMasterFd >= 0) && (grantpt(gMasterFd) == 0) && (unlockpt(gMasterFd) == 0)) {
+        // No echo or character translation on the master side
+        tcgetattr(gMasterFd, &options);
+        cfmakeraw(&options);
+        tcsetattr(gMasterFd, TCSANOW, &options);
+        // The slave name is something like "/dev/pts/3": the
+        // UART port wants a prefix and a number
+        pSlaveName = ptsname(gMasterFd);
+        if (pSlaveName != NULL) {
+            pNumber = strrchr(pSlaveName, '/');
+            if ((pNumber != NULL) && ((size_t) (pNumber + 1 - pSlaveName) < sizeof(prefix))) {
+                pNumber++;
+                memcpy(prefix, pSlaveName, pNumber - pSlaveName);
+                prefix[pNumber - pSlaveName] = 0;
+                U_TEST_PRINT_LINE("using pseudo-terminal %s.", pSlaveName);
+                if (uPortUartPrefix(prefix) == 0) {
+                    handle = uPortUartOpen(atoi(pNumber), 115200, NULL,
+                                           U_LINUX_UART_TEST_BUFFER_SIZE,
+                                           -1, -1, -1, -1);
+                }
+            }
+        }
+    }
+
+    return handle;
+}
+
+// Close the UART and the pseudo-terminal.
+static void closePtyUart()
+{
+    if (gUartHandle >= 0) {
+        uPortUartClose(gUartHandle);
+        gUartHandle = -1;
+    }
+    if (gMasterFd >= 0) {
+        close(gMasterFd);
+        gMasterFd = -1;
+    }
+}
+
+// UART event callback: record the time, read the data and
+// give the semaphore.
+static void eventCallback(int32_t uartHandle, uint32_t eventBitmask, void *pParameters)
+{
+    char buffer[16];
+    int32_t x;
+
+    (void) pParameters;
+
+    if (eventBitmask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) {
+        clock_gettime(CLOCK_MONOTONIC, &gCallbackTime);
+        do {
+            x = uPortUartRead(uartHandle, buffer, sizeof(buffer));
+            if (x > 0) {
+                gBytesRead += x;
+            }
+        } while (x > 0);
+        uPortSemaphoreGive(gSemaphore);
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Measure the latency from a byte being written to the
+ * pseudo-terminal to the UART event callback being called.
+ */
+U_PORT_TEST_FUNCTION("[linuxUart]", "linuxUartLatency")
+{
+    int32_t resourceCount;
+    struct timespec writeTime;
+    int64_t latencyUs;
+    int64_t minUs = INT64_MAX;
+    int64_t maxUs = 0;
+    int64_t totalUs = 0;
+    char c = 'x';
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uPortUartInit() == 0);
+    U_PORT_TEST_ASSERT(uPortSemaphoreCreate(&gSemaphore, 0, 1) == 0);
+
+    gUartHandle = openPtyUart();
+    U_PORT_TEST_ASSERT(gUartHandle >= 0);
+    U_PORT_TEST_ASSERT(uPortUartEventCallbackSet(gUartHandle,
+                                                 U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                 eventCallback, NULL,
+                                                 U_CFG_OS_APP_TASK_STACK_SIZE_BYTES,
+                                                 U_CFG_OS_APP_TASK_PRIORITY + 1) == 0);
+
+    U_TEST_PRINT_LINE("measuring latency from write to callback %d time(s)...",
+                      U_LINUX_UART_TEST_NUM_LATENCY_SAMPLES);
+    gBytesRead = 0;
+    for (size_t x = 0; x < U_LINUX_UART_TEST_NUM_LATENCY_SAMPLES; x++) {
+        clock_gettime(CLOCK_MONOTONIC, &writeTime);
+        U_PORT_TEST_ASSERT(write(gMasterFd, &c, 1) == 1);
+        U_PORT_TEST_ASSERT(uPortSemaphoreTryTake(gSemaphore, U_LINUX_UART_TEST_TIMEOUT_MS) == 0);
+        latencyUs = durationUs(&writeTime, &gCallbackTime);
+        if (latencyUs < minUs) {
+            minUs = latencyUs;
+        }
+        if (latencyUs > maxUs) {
+            maxUs = latencyUs;
+        }
+        totalUs += latencyUs;
+    }
+    U_TEST_PRINT_LINE("latency: min %d us, average %d us, max %d us.", (int32_t) minUs,
+                      (int32_t) (totalUs / U_LINUX_UART_TEST_NUM_LATENCY_SAMPLES),
+                      (int32_t) maxUs);
+    U_PORT_TEST_ASSERT(gBytesRead == U_LINUX_UART_TEST_NUM_LATENCY_SAMPLES);
+    U_PORT_TEST_ASSERT(maxUs < U_LINUX_UART_TEST_MAX_LATENCY_US);
+
+    closePtyUart();
+    uPortSemaphoreDelete(gSemaphore);
+    gSemaphore = NULL;
+    uPortUartDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Fill the receive buffer of the UART and check that, once it is
+ * read, reception resumes without any data being lost.
+ */
+U_PORT_TEST_FUNCTION("[linuxUart]", "linuxUartBufferFull")
+{
+    int32_t resourceCount;
+    char txBuffer[U_LINUX_UART_TEST_BUFFER_SIZE * 4];
+    char rxBuffer[sizeof(txBuffer)];
+    size_t received = 0;
+    int32_t startTimeMs;
+    int32_t x;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uPortUartInit() == 0);
+
+    gUartHandle = openPtyUart();
+    U_PORT_TEST_ASSERT(gUartHandle >= 0);
+
+    for (size_t y = 0; y < sizeof(txBuffer); y++) {
+        txBuffer[y] = (char) y;
+    }
+    U_TEST_PRINT_LINE("writing %d byte(s) into a %d byte receive buffer...",
+                      sizeof(txBuffer), U_LINUX_UART_TEST_BUFFER_SIZE);
+    U_PORT_TEST_ASSERT(write(gMasterFd, txBuffer, sizeof(txBuffer)) == sizeof(txBuffer));
+
+    // Wait for the buffer to fill up
+    startTimeMs = uPortGetTickTimeMs();
+    while ((uPortUartGetReceiveSize(gUartHandle) < U_LINUX_UART_TEST_BUFFER_SIZE) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_LINUX_UART_TEST_TIMEOUT_MS)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(uPortUartGetReceiveSize(gUartHandle) == U_LINUX_UART_TEST_BUFFER_SIZE);
+
+    // Now read it all out
+    startTimeMs = uPortGetTickTimeMs();
+    while ((received < sizeof(rxBuffer)) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_LINUX_UART_TEST_TIMEOUT_MS)) {
+        x = uPortUartRead(gUartHandle, rxBuffer + received, sizeof(rxBuffer) - received);
+        U_PORT_TEST_ASSERT(x >= 0);
+        if (x > 0) {
+            received += x;
+        } else {
+            uPortTaskBlock(1);
+        }
+    }
+    U_TEST_PRINT_LINE("%d byte(s) received.", received);
+    U_PORT_TEST_ASSERT(received == sizeof(txBuffer));
+    U_PORT_TEST_ASSERT(memcmp(rxBuffer, txBuffer, sizeof(txBuffer)) == 0);
+
+    closePtyUart();
+    uPortUartDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[linuxUart]", "linuxUartCleanUp")
+{
+    closePtyUart();
+    if (gSemaphore != NULL) {
+        uPortSemaphoreDelete(gSemaphore);
+        gSemaphore = NULL;
+    }
+    uPortUartDeinit();
+    uPortDeinit();
+}
+
+// End of file
@@ -136,6 +136,12 @@ int32_t uPortGetTickTimeMs()
     return k_uptime_get();
 }
 
+// Get the current tick converted to a time in microseconds.
+int32_t uPortGetTickTimeUs()
+{
+    return (int32_t) (uint32_t) k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
 // Get the minimum amount of heap free, ever, in bytes.
 int32_t uPortGetHeapMinFree()
 {
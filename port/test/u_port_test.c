@@ -236,12 +236,37 @@
  */
 #define U_PORT_TEST_OS_EVENT_QUEUE_PARAM_MIN_SIZE_BYTES 4
 
+/** Number of interations for the event queue heap allocation test.
+ */
+#define U_PORT_TEST_OS_EVENT_QUEUE_NO_MALLOC_ITERATIONS 1000
+
+/** Number of event queues in the event queue ordering test.
+ */
+#define U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_QUEUES 4
+
+/** Number of tasks, in addition to the test task itself, that
+ * send events in the event queue ordering test.
+ */
+#define U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_TASKS 2
+
+/** Number of events each sender sends to each event queue in
+ * the event queue ordering test.
+ */
+#define U_PORT_TEST_OS_EVENT_QUEUE_ORDER_ITERATIONS 200
+
 #ifndef U_PORT_MALLOC_LENGTH_BYTES
 /** How much to allocate in the heap test; deliberately an odd size.
  */
 # define U_PORT_MALLOC_LENGTH_BYTES 9
 #endif
 
+#ifndef U_PORT_TEST_HEAP_MONITOR_NUM_BLOCKS
+/** The number of heap blocks to have outstanding at once in the
+ * heap monitor test.
+ */
+# define U_PORT_TEST_HEAP_MONITOR_NUM_BLOCKS 5000
+#endif
+
 /** How long to wait to receive  a message on a queue in osTestTask.
  */
 #define U_PORT_OS_TEST_TASK_TRY_RECEIVE_MS 10
@@ -381,6 +406,52 @@ static int32_t gEventQueueMinErrorFlag;
 // Counter for event queue callback min length
 static int32_t gEventQueueMinCounter;
 
+// Error flag for event queue callback in the heap allocation test
+static int32_t gEventQueueNoMallocErrorFlag;
+
+// Counter for event queue callback in the heap allocation test
+static volatile int32_t gEventQueueNoMallocCounter;
+
+// Handles for the event queue ordering test.
+static int32_t gEventQueueOrderHandle[U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_QUEUES];
+
+// The sequence number expected next by each event queue from each
+// sender in the event queue ordering test; the extra sender is the
+// callback of the first event queue, which forwards to the second.
+static int32_t gEventQueueOrderNext[U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_QUEUES]
+[U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_TASKS + 2];
+
+// Number of events forwarded by the first event queue in the
+// event queue ordering test.
+static int32_t gEventQueueOrderNumForwarded;
+
+// Error flag for the event queue ordering test.
+static volatile int32_t gEventQueueOrderErrorFlag;
+
+// Total number of events received in the event queue ordering test.
+static volatile int32_t gEventQueueOrderCounter;
+
+// Number of sending tasks still running in the event queue
+// ordering test.
+static volatile int32_t gEventQueueOrderNumTasks;
+
+// Handle for the event queue close test.
+static int32_t gEventQueueCloseHandle;
+
+// Set to 1 to hold the event function of the event queue close test.
+static volatile int32_t gEventQueueCloseHold;
+
+// Number of events received in the event queue close test.
+static volatile int32_t gEventQueueCloseCounter;
+
+// What uPortEventQueueSend() returned to the sending task of the
+// event queue close test, 1 while it has yet to return.
+static volatile int32_t gEventQueueCloseSendResult;
+
+// Set to 1 when the clean-up task of the event queue close
+// test has finished.
+static volatile int32_t gEventQueueCloseCleanedUp;
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
 
 // The data to send during UART testing.
@@ -872,6 +943,124 @@ static void eventQueueMinFunction(void *pParam,
     gEventQueueMinCounter++;
 }
 
+// Event queue function for the heap allocation test: for call N
+// expect a parameter of length
+// (N % U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES) + 1 filled with N.
+static void eventQueueNoMallocFunction(void *pParam,
+                                       size_t paramLength)
+{
+    uint8_t *pByte = (uint8_t *) pParam;
+
+    if (paramLength != (size_t) (gEventQueueNoMallocCounter %
+                                 U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES) + 1) {
+        gEventQueueNoMallocErrorFlag = 1;
+    }
+    for (size_t x = 0; (gEventQueueNoMallocErrorFlag == 0) && (x < paramLength); x++) {
+        if (*pByte != (uint8_t) gEventQueueNoMallocCounter) {
+            gEventQueueNoMallocErrorFlag = 2;
+        }
+        pByte++;
+    }
+
+    gEventQueueNoMallocCounter++;
+}
+
+// Event queue function for the ordering test: the parameter
+// is the event queue index, the sender and the sequence number.
+static void eventQueueOrderFunction(void *pParam, size_t paramLength)
+{
+    int32_t *pEvent = (int32_t *) pParam;
+    int32_t queue = pEvent[0];
+    int32_t sender = pEvent[1];
+    int32_t event[3];
+
+    if ((paramLength != sizeof(event)) || (queue < 0) ||
+        (queue >= U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_QUEUES) ||
+        (sender < 0) || (sender >= U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_TASKS + 2) ||
+        !uPortEventQueueIsTask(gEventQueueOrderHandle[queue])) {
+        gEventQueueOrderErrorFlag = 1;
+    } else {
+        // The events of one event queue are never handled in
+        // parallel so this needs no protection
+        if (pEvent[2] != gEventQueueOrderNext[queue][sender]) {
+            gEventQueueOrderErrorFlag = 2;
+        }
+        gEventQueueOrderNext[queue][sender]++;
+        if (queue == 0) {
+            // Forward to the next event queue, as a different sender
+            event[0] = 1;
+            event[1] = U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_TASKS + 1;
+            event[2] = gEventQueueOrderNumForwarded;
+            gEventQueueOrderNumForwarded++;
+            if (uPortEventQueueSend(gEventQueueOrderHandle[1], event, sizeof(event)) != 0) {
+                gEventQueueOrderErrorFlag = 3;
+            }
+        }
+    }
+
+    U_ATOMIC_INCREMENT(&gEventQueueOrderCounter);
+}
+
+// Send events to all of the event queues of the ordering test.
+static void eventQueueOrderSend(int32_t sender)
+{
+    int32_t event[3];
+
+    event[1] = sender;
+    for (int32_t x = 0; x < U_PORT_TEST_OS_EVENT_QUEUE_ORDER_ITERATIONS; x++) {
+        event[2] = x;
+        for (int32_t y = 0; y < U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_QUEUES; y++) {
+            event[0] = y;
+            if (uPortEventQueueSend(gEventQueueOrderHandle[y], event, sizeof(event)) != 0) {
+                gEventQueueOrderErrorFlag = 4;
+            }
+        }
+    }
+}
+
+// Task that sends events in the ordering test.
+static void eventQueueOrderTask(void *pParameters)
+{
+    eventQueueOrderSend(*((int32_t *) pParameters));
+    U_ATOMIC_DECREMENT(&gEventQueueOrderNumTasks);
+    uPortTaskDelete(NULL);
+}
+
+// Event queue function for the close test: holds on to
+// each event until told to let go.
+static void eventQueueCloseFunction(void *pParam, size_t paramLength)
+{
+    (void) pParam;
+    (void) paramLength;
+
+    U_ATOMIC_INCREMENT(&gEventQueueCloseCounter);
+    while (gEventQueueCloseHold) {
+        uPortTaskBlock(10);
+    }
+}
+
+// Task that sends an event in the close test.
+static void eventQueueCloseSendTask(void *pParameters)
+{
+    int32_t x = 0;
+
+    (void) pParameters;
+
+    gEventQueueCloseSendResult = uPortEventQueueSend(gEventQueueCloseHandle,
+                                                     &x, sizeof(x));
+    uPortTaskDelete(NULL);
+}
+
+// Task that frees closed event queues in the close test.
+static void eventQueueCloseCleanUpTask(void *pParameters)
+{
+    (void) pParameters;
+
+    uPortEventQueueCleanUp();
+    gEventQueueCloseCleanedUp = 1;
+    uPortTaskDelete(NULL);
+}
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
 
 // Callback that is called when data arrives at the UART
@@ -2132,6 +2321,235 @@ U_PORT_TEST_FUNCTION("[port]", "portEventQueue")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+/** Test that, once an event queue is open, sending to it makes
+ * no heap allocations at all.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portEventQueueNoMalloc")
+{
+    int32_t handle;
+    uint8_t param[U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES];
+    size_t paramLength;
+    int32_t mallocCount;
+    int32_t startTimeMs;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    gEventQueueNoMallocErrorFlag = 0;
+    gEventQueueNoMallocCounter = 0;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    handle = uPortEventQueueOpen(eventQueueNoMallocFunction, NULL,
+                                 U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES,
+                                 U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                 U_CFG_TEST_OS_TASK_PRIORITY,
+                                 U_PORT_TEST_QUEUE_LENGTH);
+    U_PORT_TEST_ASSERT(handle >= 0);
+
+    U_TEST_PRINT_LINE("sending %d event(s) of varying length...",
+                      U_PORT_TEST_OS_EVENT_QUEUE_NO_MALLOC_ITERATIONS);
+    mallocCount = uPortHeapMallocCount();
+    for (size_t x = 0; x < U_PORT_TEST_OS_EVENT_QUEUE_NO_MALLOC_ITERATIONS; x++) {
+        paramLength = (x % U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES) + 1;
+        memset(param, (uint8_t) x, paramLength);
+        U_PORT_TEST_ASSERT(uPortEventQueueSend(handle, param, paramLength) == 0);
+    }
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gEventQueueNoMallocCounter < U_PORT_TEST_OS_EVENT_QUEUE_NO_MALLOC_ITERATIONS) &&
+           (uPortGetTickTimeMs() - startTimeMs < 5000)) {
+        uPortTaskBlock(10);
+    }
+    mallocCount = uPortHeapMallocCount() - mallocCount;
+    U_TEST_PRINT_LINE("%d event(s) received, %d heap allocation(s) made.",
+                      gEventQueueNoMallocCounter, mallocCount);
+    U_PORT_TEST_ASSERT(gEventQueueNoMallocErrorFlag == 0);
+    U_PORT_TEST_ASSERT(gEventQueueNoMallocCounter == U_PORT_TEST_OS_EVENT_QUEUE_NO_MALLOC_ITERATIONS);
+    U_PORT_TEST_ASSERT(mallocCount == 0);
+
+    U_PORT_TEST_ASSERT(uPortEventQueueClose(handle) == 0);
+    uPortDeinit();
+
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(100);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test that the events of each event queue are handled in the
+ * order they were sent when several event queues are being sent to
+ * from several tasks at once, including from the event function of
+ * another event queue; with U_CFG_EVENT_QUEUE_EXECUTOR defined this
+ * exercises the shared executor.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portEventQueueOrder")
+{
+    uPortTaskHandle_t taskHandle[U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_TASKS];
+    int32_t taskParameter[U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_TASKS];
+    int32_t numEvents;
+    int32_t startTimeMs;
+    int32_t stackMinFreeBytes;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    gEventQueueOrderErrorFlag = 0;
+    gEventQueueOrderCounter = 0;
+    gEventQueueOrderNumForwarded = 0;
+    memset(gEventQueueOrderNext, 0, sizeof(gEventQueueOrderNext));
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    for (size_t x = 0; x < U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_QUEUES; x++) {
+        gEventQueueOrderHandle[x] = uPortEventQueueOpen(eventQueueOrderFunction, NULL,
+                                                        sizeof(int32_t) * 3,
+                                                        U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                                        U_CFG_TEST_OS_TASK_PRIORITY,
+                                                        U_PORT_TEST_QUEUE_LENGTH);
+        U_PORT_TEST_ASSERT(gEventQueueOrderHandle[x] >= 0);
+    }
+
+    // Start the sending tasks and send from here also
+    gEventQueueOrderNumTasks = U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_TASKS;
+    for (size_t x = 0; x < U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_TASKS; x++) {
+        taskParameter[x] = (int32_t) x + 1;
+        U_PORT_TEST_ASSERT(uPortTaskCreate(eventQueueOrderTask, "eventQueueOrderTask",
+                                           U_CFG_TEST_OS_TASK_STACK_SIZE_BYTES,
+                                           &(taskParameter[x]),
+                                           U_CFG_TEST_OS_TASK_PRIORITY,
+                                           &(taskHandle[x])) == 0);
+    }
+    eventQueueOrderSend(0);
+
+    // Each sender sends to every event queue and what goes to
+    // the first event queue is forwarded to the second
+    numEvents = (U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_QUEUES + 1) *
+                (U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_TASKS + 1) *
+                U_PORT_TEST_OS_EVENT_QUEUE_ORDER_ITERATIONS;
+    startTimeMs = uPortGetTickTimeMs();
+    while (((gEventQueueOrderCounter < numEvents) || (gEventQueueOrderNumTasks > 0)) &&
+           (uPortGetTickTimeMs() - startTimeMs < 10000)) {
+        uPortTaskBlock(10);
+    }
+    U_TEST_PRINT_LINE("%d event(s) of %d received in %d ms.", gEventQueueOrderCounter,
+                      numEvents, uPortGetTickTimeMs() - startTimeMs);
+    U_PORT_TEST_ASSERT(gEventQueueOrderErrorFlag == 0);
+    U_PORT_TEST_ASSERT(gEventQueueOrderCounter == numEvents);
+    U_PORT_TEST_ASSERT(gEventQueueOrderNumTasks == 0);
+    for (size_t x = 0; x < U_PORT_TEST_OS_EVENT_QUEUE_ORDER_NUM_QUEUES; x++) {
+        stackMinFreeBytes = uPortEventQueueStackMinFree(gEventQueueOrderHandle[x]);
+        if (stackMinFreeBytes != (int32_t) U_ERROR_COMMON_NOT_SUPPORTED) {
+            U_PORT_TEST_ASSERT(stackMinFreeBytes > 0);
+        }
+        U_PORT_TEST_ASSERT(uPortEventQueueClose(gEventQueueOrderHandle[x]) == 0);
+    }
+
+    uPortDeinit();
+
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(100);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test that freeing an event queue which has been closed while
+ * a sender is waiting for room on it wakes the sender up, rather
+ * than pulling the event queue out from under it.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portEventQueueCloseSender")
+{
+    uPortTaskHandle_t taskHandle;
+    int32_t x = 0;
+    int32_t startTimeMs;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    gEventQueueCloseHold = 1;
+    gEventQueueCloseCounter = 0;
+    gEventQueueCloseSendResult = 1;
+    gEventQueueCloseCleanedUp = 0;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    gEventQueueCloseHandle = uPortEventQueueOpen(eventQueueCloseFunction, NULL,
+                                                 sizeof(x),
+                                                 U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                                 U_CFG_TEST_OS_TASK_PRIORITY, 1);
+    U_PORT_TEST_ASSERT(gEventQueueCloseHandle >= 0);
+
+    // Fill the event queue: one event held by the event
+    // function and one waiting on the OS queue behind it
+    U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueueCloseHandle, &x, sizeof(x)) == 0);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gEventQueueCloseCounter == 0) && (uPortGetTickTimeMs() - startTimeMs < 5000)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(gEventQueueCloseCounter == 1);
+    U_PORT_TEST_ASSERT(uPortEventQueueSend(gEventQueueCloseHandle, &x, sizeof(x)) == 0);
+
+    // A third sender now has to wait
+    U_PORT_TEST_ASSERT(uPortTaskCreate(eventQueueCloseSendTask, "eventQueueCloseSend",
+                                       U_CFG_TEST_OS_TASK_STACK_SIZE_BYTES, NULL,
+                                       U_CFG_TEST_OS_TASK_PRIORITY, &taskHandle) == 0);
+    uPortTaskBlock(100);
+    U_PORT_TEST_ASSERT(gEventQueueCloseSendResult == 1);
+
+    // Close the event queue and free it from another task, since
+    // that can't complete until the event function lets go
+    U_TEST_PRINT_LINE("closing the event queue with a sender waiting...");
+    U_PORT_TEST_ASSERT(uPortEventQueueClose(gEventQueueCloseHandle) == 0);
+    U_PORT_TEST_ASSERT(uPortTaskCreate(eventQueueCloseCleanUpTask, "eventQueueCloseCleanUp",
+                                       U_CFG_TEST_OS_TASK_STACK_SIZE_BYTES, NULL,
+                                       U_CFG_TEST_OS_TASK_PRIORITY, &taskHandle) == 0);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gEventQueueCloseSendResult == 1) && (uPortGetTickTimeMs() - startTimeMs < 5000)) {
+        uPortTaskBlock(10);
+    }
+    U_TEST_PRINT_LINE("the waiting sender got %d.", gEventQueueCloseSendResult);
+    U_PORT_TEST_ASSERT(gEventQueueCloseSendResult < 0);
+
+    // Now let the event queue go
+    gEventQueueCloseHold = 0;
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gEventQueueCloseCleanedUp == 0) && (uPortGetTickTimeMs() - startTimeMs < 5000)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(gEventQueueCloseCleanedUp == 1);
+    U_PORT_TEST_ASSERT(gEventQueueCloseCounter == 2);
+
+    uPortDeinit();
+
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(100);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Test heap API.
  *
  * NOTE: for this to work fully U_ASSERT_HOOK_FUNCTION_TEST_RETURN must be defined.
@@ -2211,6 +2629,58 @@ U_PORT_TEST_FUNCTION("[port]", "portHeap")
     uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
 }
 
+/** Test that, with many heap blocks outstanding, freeing them oldest
+ * first (the worst case for a heap monitor that has to search for
+ * the block) works and, if U_CFG_HEAP_MONITOR is defined, that
+ * per-call-site statistics are kept.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portHeapMonitor")
+{
+    void **ppBlocks;
+    int32_t startTimeMs;
+    int32_t x;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    ppBlocks = (void **) pUPortMalloc(sizeof(void *) * U_PORT_TEST_HEAP_MONITOR_NUM_BLOCKS);
+    U_PORT_TEST_ASSERT(ppBlocks != NULL);
+    for (size_t y = 0; y < U_PORT_TEST_HEAP_MONITOR_NUM_BLOCKS; y++) {
+        *(ppBlocks + y) = pUPortMalloc(U_PORT_MALLOC_LENGTH_BYTES + (y % 16));
+        U_PORT_TEST_ASSERT(*(ppBlocks + y) != NULL);
+    }
+
+    x = uPortHeapDumpSitesCsv(U_TEST_PREFIX);
+#ifdef U_CFG_HEAP_MONITOR
+    // At least the two pUPortMalloc() calls above
+    U_PORT_TEST_ASSERT(x >= 2);
+#else
+    U_PORT_TEST_ASSERT(x == 0);
+#endif
+
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t y = 0; y < U_PORT_TEST_HEAP_MONITOR_NUM_BLOCKS; y++) {
+        uPortFree(*(ppBlocks + y));
+    }
+    U_TEST_PRINT_LINE("freeing %d block(s), oldest first, took %d ms.",
+                      U_PORT_TEST_HEAP_MONITOR_NUM_BLOCKS,
+                      uPortGetTickTimeMs() - startTimeMs);
+    uPortFree(ppBlocks);
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Test: strtok_r since we have our own implementation on
  * some platforms.
  */
@@ -0,0 +1,336 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Default implementation of uPortCodecBinToHex() and
+ * uPortCodecHexToBin(): SSE2, NEON or SWAR if U_CFG_CODEC_VECTOR
+ * is defined, else nothing at all.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"     // size_t
+#include "stdint.h"     // uint64_t etc.
+#include "stdbool.h"
+#include "string.h"     // memcpy()
+#include "u_compiler.h" // U_WEAK, U_INLINE
+
+#ifdef U_CFG_CODEC_VECTOR
+# if defined(__SSE2__)
+#  include "emmintrin.h"
+# elif defined(__ARM_NEON)
+#  include "arm_neon.h"
+# endif
+#endif
+
+#include "u_port_codec.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+#ifdef U_CFG_CODEC_VECTOR
+# if !defined(__SSE2__) && !defined(__ARM_NEON)
+/** Repeat a byte across a uint64_t.
+ */
+#  define U_PORT_CODEC_REPEAT(x) (((uint64_t) (x)) * 0x0101010101010101ULL)
+# endif
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+#ifdef U_CFG_CODEC_VECTOR
+
+# if defined(__SSE2__)
+
+// Convert each byte of a vector, 0 to 15, to upper case ASCII hex.
+static U_INLINE __m128i nibbleToHex(__m128i nibble)
+{
+    __m128i isLetter = _mm_cmpgt_epi8(nibble, _mm_set1_epi8(9));
+
+    return _mm_add_epi8(_mm_add_epi8(nibble, _mm_set1_epi8('0')),
+                        _mm_and_si128(isLetter, _mm_set1_epi8('A' - '0' - 10)));
+}
+
+// Convert each byte of a vector of ASCII hex to its value, setting
+// *pIsHex to false if any byte is not hex.
+static U_INLINE __m128i hexToNibble(__m128i hex, bool *pIsHex)
+{
+    // Signed compares are fine: anything with the top bit set
+    // is negative and so is below '0'
+    __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(hex, _mm_set1_epi8('0' - 1)),
+                                    _mm_cmplt_epi8(hex, _mm_set1_epi8('9' + 1)));
+    __m128i lower = _mm_or_si128(hex, _mm_set1_epi8(0x20));
+    __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                     _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+    if (_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xffff) {
+        *pIsHex = false;
+    }
+
+    return _mm_or_si128(_mm_and_si128(isDigit, _mm_sub_epi8(hex, _mm_set1_epi8('0'))),
+                        _mm_and_si128(isLetter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+// Combine each pair of nibbles, high then low, in a vector of
+// eight pairs into a byte, zero extended into 16 bits.
+static U_INLINE __m128i nibblePairToByte(__m128i nibblePair)
+{
+    return _mm_or_si128(_mm_and_si128(_mm_slli_epi16(nibblePair, 4), _mm_set1_epi16(0x00f0)),
+                        _mm_srli_epi16(nibblePair, 8));
+}
+
+# elif defined(__ARM_NEON)
+
+// Convert each byte of a vector, 0 to 15, to upper case ASCII hex.
+static U_INLINE uint8x16_t nibbleToHex(uint8x16_t nibble)
+{
+    uint8x16_t isLetter = vcgtq_u8(nibble, vdupq_n_u8(9));
+
+    return vaddq_u8(vaddq_u8(nibble, vdupq_n_u8('0')),
+                    vandq_u8(isLetter, vdupq_n_u8('A' - '0' - 10)));
+}
+
+// Convert each byte of a vector of ASCII hex to its value, setting
+// *pIsHex to false if any byte is not hex.
+static U_INLINE uint8x16_t hexToNibble(uint8x16_t hex, bool *pIsHex)
+{
+    // Unsigned, so anything below '0' or 'a' wraps to be large
+    uint8x16_t digit = vsubq_u8(hex, vdupq_n_u8('0'));
+    uint8x16_t letter = vsubq_u8(vorrq_u8(hex, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isDigit = vcleq_u8(digit, vdupq_n_u8(9));
+    uint8x16_t isDigitOrLetter = vorrq_u8(isDigit, vcleq_u8(letter, vdupq_n_u8(5)));
+    uint8x8_t isHex;
+
+    // Pairwise minimum down to a single byte, 0xff only if all are
+    isHex = vpmin_u8(vget_low_u8(isDigitOrLetter), vget_high_u8(isDigitOrLetter));
+    isHex = vpmin_u8(isHex, isHex);
+    isHex = vpmin_u8(isHex, isHex);
+    isHex = vpmin_u8(isHex, isHex);
+    if (vget_lane_u8(isHex, 0) != 0xff) {
+        *pIsHex = false;
+    }
+
+    return vbslq_u8(isDigit, digit, vaddq_u8(letter, vdupq_n_u8(10)));
+}
+
+# else
+
+// Convert eight nibbles, one in each byte of a uint64_t, to upper
+// case ASCII hex.
+static U_INLINE uint64_t nibbleToHex(uint64_t nibble)
+{
+    // Adding 0x76 to a nibble sets the top bit of its byte
+    // if it is 10 or more
+    uint64_t isLetter = ((nibble + U_PORT_CODEC_REPEAT(0x76)) >> 7) & U_PORT_CODEC_REPEAT(0x01);
+
+    return nibble + U_PORT_CODEC_REPEAT('0') + (isLetter * ('A' - '0' - 10));
+}
+
+// Read numBytes (up to eight) bytes from pBuffer into a uint64_t,
+// the first in the least significant byte.
+static U_INLINE uint64_t readLittleEndian(const uint8_t *pBuffer, size_t numBytes)
+{
+    uint64_t x = 0;
+
+#  if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    memcpy(&x, pBuffer, numBytes);
+#  else
+    for (size_t y = 0; y < numBytes; y++) {
+        x |= ((uint64_t) *(pBuffer + y)) << (y * 8);
+    }
+#  endif
+
+    return x;
+}
+
+// Write the numBytes (up to eight) least significant bytes of x to
+// pBuffer, the least significant first.
+static U_INLINE void writeLittleEndian(uint64_t x, uint8_t *pBuffer, size_t numBytes)
+{
+#  if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    memcpy(pBuffer, &x, numBytes);
+#  else
+    for (size_t y = 0; y < numBytes; y++) {
+        *(pBuffer + y) = (uint8_t) (x >> (y * 8));
+    }
+#  endif
+}
+
+// Return a uint64_t with the top bit of each byte set if that byte
+// of x is at least min, where no byte of x has its top bit set.
+static U_INLINE uint64_t atLeast(uint64_t x, uint8_t min)
+{
+    return (x + U_PORT_CODEC_REPEAT(0x80 - min)) & U_PORT_CODEC_REPEAT(0x80);
+}
+
+# endif
+
+#endif // U_CFG_CODEC_VECTOR
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Default implementation of binary to ASCII hex.
+U_WEAK size_t uPortCodecBinToHex(const char *pBin, size_t binLength, char *pHex)
+{
+    size_t length = 0;
+#ifdef U_CFG_CODEC_VECTOR
+# if defined(__SSE2__)
+    __m128i bin;
+    __m128i high;
+    __m128i low;
+
+    // Sixteen bytes at a time
+    for (; length + 16 <= binLength; length += 16) {
+        bin = _mm_loadu_si128((const __m128i *) (pBin + length));
+        high = nibbleToHex(_mm_and_si128(_mm_srli_epi16(bin, 4), _mm_set1_epi8(0x0f)));
+        low = nibbleToHex(_mm_and_si128(bin, _mm_set1_epi8(0x0f)));
+        _mm_storeu_si128((__m128i *) (pHex + (length * 2)), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i *) (pHex + (length * 2) + 16), _mm_unpackhi_epi8(high, low));
+    }
+# elif defined(__ARM_NEON)
+    uint8x16_t bin;
+    uint8x16x2_t hex;
+
+    // Sixteen bytes at a time, vst2q_u8() interleaving the
+    // high and low characters
+    for (; length + 16 <= binLength; length += 16) {
+        bin = vld1q_u8((const uint8_t *) (pBin + length));
+        hex.val[0] = nibbleToHex(vshrq_n_u8(bin, 4));
+        hex.val[1] = nibbleToHex(vandq_u8(bin, vdupq_n_u8(0x0f)));
+        vst2q_u8((uint8_t *) (pHex + (length * 2)), hex);
+    }
+# else
+    uint64_t x;
+
+    // Four bytes at a time: spread them out so that each is in
+    // the bottom of a 16-bit lane, then put the high nibble in the
+    // lower byte of its lane, since it comes first, and the low
+    // nibble in the upper
+    for (; length + 4 <= binLength; length += 4) {
+        x = readLittleEndian((const uint8_t *) (pBin + length), 4);
+        x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+        x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+        x = nibbleToHex(((x >> 4) & 0x000f000f000f000fULL) |
+                        ((x & 0x000f000f000f000fULL) << 8));
+        writeLittleEndian(x, (uint8_t *) (pHex + (length * 2)), 8);
+    }
+# endif
+#else
+    (void) pBin;
+    (void) binLength;
+    (void) pHex;
+#endif
+
+    return length;
+}
+
+// Default implementation of ASCII hex to binary.
+U_WEAK size_t uPortCodecHexToBin(const char *pHex, size_t hexLength, char *pBin)
+{
+    size_t length = 0;
+#ifdef U_CFG_CODEC_VECTOR
+    size_t binLength = hexLength / 2;
+    bool isHex = true;
+# if defined(__SSE2__)
+    __m128i nibbleA;
+    __m128i nibbleB;
+
+    // Sixteen bytes at a time, leaving the rest to the caller
+    // if there is anything that is not hex
+    while (isHex && (length + 16 <= binLength)) {
+        nibbleA = hexToNibble(_mm_loadu_si128((const __m128i *) (pHex + (length * 2))), &isHex);
+        nibbleB = hexToNibble(_mm_loadu_si128((const __m128i *) (pHex + (length * 2) + 16)),
+                              &isHex);
+        if (isHex) {
+            _mm_storeu_si128((__m128i *) (pBin + length),
+                             _mm_packus_epi16(nibblePairToByte(nibbleA),
+                                              nibblePairToByte(nibbleB)));
+            length += 16;
+        }
+    }
+# elif defined(__ARM_NEON)
+    uint8x16x2_t hex;
+    uint8x16_t high;
+    uint8x16_t low;
+
+    // Sixteen bytes at a time, vld2q_u8() de-interleaving the
+    // high and low characters
+    while (isHex && (length + 16 <= binLength)) {
+        hex = vld2q_u8((const uint8_t *) (pHex + (length * 2)));
+        high = hexToNibble(hex.val[0], &isHex);
+        low = hexToNibble(hex.val[1], &isHex);
+        if (isHex) {
+            vst1q_u8((uint8_t *) (pBin + length), vorrq_u8(vshlq_n_u8(high, 4), low));
+            length += 16;
+        }
+    }
+# else
+    uint64_t x;
+    uint64_t lower;
+    uint64_t isDigit;
+    uint64_t isLetter;
+
+    // Four bytes at a time: take eight characters, check that
+    // they are all hex and convert them to nibbles, then combine
+    // each pair, which are in a 16-bit lane with the high nibble
+    // in the lower byte, and gather the results together
+    while (isHex && (length + 4 <= binLength)) {
+        x = readLittleEndian((const uint8_t *) (pHex + (length * 2)), 8);
+        lower = x | U_PORT_CODEC_REPEAT(0x20);
+        isDigit = atLeast(x, '0') & ~atLeast(x, '9' + 1);
+        isLetter = atLeast(lower, 'a') & ~atLeast(lower, 'f' + 1);
+        if (((x & U_PORT_CODEC_REPEAT(0x80)) == 0) &&
+            ((isDigit | isLetter) == U_PORT_CODEC_REPEAT(0x80))) {
+            // '0' to '9' and 'a' to 'f' have the values we want
+            // in their bottom nibble, apart from needing nine
+            // adding for a letter
+            x = (x & U_PORT_CODEC_REPEAT(0x0f)) + ((isLetter >> 7) * 9);
+            x = ((x << 4) & 0x00f000f000f000f0ULL) | ((x >> 8) & 0x000f000f000f000fULL);
+            x = (x | (x >> 8)) & 0x0000ffff0000ffffULL;
+            x = (x | (x >> 16)) & 0x00000000ffffffffULL;
+            writeLittleEndian(x, (uint8_t *) (pBin + length), 4);
+            length += 4;
+        } else {
+            // Leave the rest to the caller
+            isHex = false;
+        }
+    }
+# endif
+#else
+    (void) pHex;
+    (void) hexLength;
+    (void) pBin;
+#endif
+
+    return length;
+}
+
+// End of file
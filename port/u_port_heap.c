@@ -64,7 +64,21 @@
 
 /** The size of uPortHeapBlock_t, _without_ any packing on the end.
  */
-#define U_PORT_HEAP_STRUCTURE_SIZE_NO_END_PACKING ((sizeof(void *) * 2) + (sizeof(int32_t) * 3))
+#define U_PORT_HEAP_STRUCTURE_SIZE_NO_END_PACKING ((sizeof(void *) * 4) + (sizeof(int32_t) * 3))
+
+#ifndef U_PORT_HEAP_MONITOR_MAX_NUM_SITES
+/** The number of distinct call sites (file/line) of pUPortMalloc()
+ * for which statistics are kept when U_CFG_HEAP_MONITOR is defined;
+ * must be a power of two.  Allocations from call sites beyond this
+ * number are still monitored, they just don't appear in the output
+ * of uPortHeapDumpSitesCsv().
+ */
+# define U_PORT_HEAP_MONITOR_MAX_NUM_SITES 128
+#endif
+
+#if (U_PORT_HEAP_MONITOR_MAX_NUM_SITES & (U_PORT_HEAP_MONITOR_MAX_NUM_SITES - 1)) != 0
+# error U_PORT_HEAP_MONITOR_MAX_NUM_SITES must be a power of two
+#endif
 
 #ifndef U_PORT_HEAP_BUFFER_OVERRUN_MARKER
 /** The string to prefix a buffer overrun with.
@@ -78,6 +92,13 @@
 # define U_PORT_HEAP_BUFFER_UNDERRUN_MARKER " *** BUFFER UNDERRUN *** "
 #endif
 
+#ifndef U_PORT_HEAP_BAD_FREE_MARKER
+/** The string to prefix the free of a block that is not on the
+ * heap (e.g. because it has already been freed) with.
+ */
+# define U_PORT_HEAP_BAD_FREE_MARKER " *** BAD FREE *** "
+#endif
+
 /** Local version of the lock helper, since this can't necessarily
  * use the normal one.
  */
@@ -113,12 +134,26 @@
  */
 typedef struct uPortHeapBlock_t {
     struct uPortHeapBlock_t *pNext;
+    struct uPortHeapBlock_t *pPrev;
+    struct uPortHeapSite_t *pSite; /**< NULL if the site table was full. */
     const char *pFile;
     int32_t line;
     int32_t size;
     int32_t timeMilliseconds;
 } uPortHeapBlock_t;
 
+/** Statistics for a call site of pUPortMalloc(), kept when
+ * U_CFG_HEAP_MONITOR is defined.
+ */
+typedef struct uPortHeapSite_t {
+    const char *pFile; /**< NULL if this entry is not in use. */
+    int32_t line;
+    int32_t allocCount; /**< the number of allocations ever made. */
+    int32_t liveCount;  /**< the number of allocations outstanding. */
+    int32_t liveBytes;  /**< the number of bytes outstanding. */
+    int32_t peakBytes;  /**< the most bytes that have been outstanding. */
+} uPortHeapSite_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -128,17 +163,26 @@ typedef struct uPortHeapBlock_t {
  */
 static int32_t gHeapAllocCount = 0;
 
+/** Variable to keep track of the total number of heap allocations
+ * ever made.
+ */
+static int32_t gHeapMallocCount = 0;
+
 /** Variable to keep track of the total number of perpetual heap
  * allocations.
  */
 static int32_t gHeapPerpetualAllocCount = 0;
 
 #ifdef U_CFG_HEAP_MONITOR
-/** Root of linked list of blocks on the heap.
+/** Root of the doubly-linked list of blocks on the heap, newest first.
  */
 static uPortHeapBlock_t *gpHeapBlockList = NULL;
 
-/** Mutex to protect the linked list.
+/** Table of call sites of pUPortMalloc(), hashed on file/line.
+ */
+static uPortHeapSite_t gSites[U_PORT_HEAP_MONITOR_MAX_NUM_SITES];
+
+/** Mutex to protect the linked list and the site table.
  */
 static uPortMutexHandle_t gMutex = NULL;
 
@@ -172,6 +216,31 @@ static void printBlock(const char *pPrefix, const uPortHeapBlock_t *pBlock)
     }
 }
 
+// Find the entry for a call site in gSites[], adding it if it is
+// not there, or return NULL if the table is full; gMutex must
+// be locked before this is called.
+static uPortHeapSite_t *pSiteGet(const char *pFile, int32_t line)
+{
+    uPortHeapSite_t *pSite = NULL;
+    uint32_t hash = (uint32_t) (((uintptr_t) pFile) >> 2) ^ (((uint32_t) line) * 2654435761UL);
+    size_t index;
+
+    // Open addressing with linear probing: entries are never
+    // removed so the first empty slot ends the search
+    for (size_t x = 0; (pSite == NULL) && (x < U_PORT_HEAP_MONITOR_MAX_NUM_SITES); x++) {
+        index = (hash + x) & (U_PORT_HEAP_MONITOR_MAX_NUM_SITES - 1);
+        if (gSites[index].pFile == NULL) {
+            gSites[index].pFile = pFile;
+            gSites[index].line = line;
+            pSite = &(gSites[index]);
+        } else if ((gSites[index].pFile == pFile) && (gSites[index].line == line)) {
+            pSite = &(gSites[index]);
+        }
+    }
+
+    return pSite;
+}
+
 static void printMemory(const char *pMemory, size_t size)
 {
     for (size_t x = 0; x < size; x++, pMemory++) {
@@ -199,6 +268,7 @@ U_WEAK void *pUPortMalloc(size_t sizeBytes)
     void *pMalloc = malloc(sizeBytes);
     if (pMalloc != NULL) {
         gHeapAllocCount++;
+        gHeapMallocCount++;
     }
     return pMalloc;
 }
@@ -211,7 +281,7 @@ void *pUPortMallocMonitor(size_t sizeBytes, const char *pFile,
 {
     void *pMemory = NULL;
     uPortHeapBlock_t *pBlock;
-    uPortHeapBlock_t *pBlockTmp;
+    uPortHeapSite_t *pSite;
     char *pTmp;
     size_t blockSizeBytes;
     uint32_t heapGuard = U_PORT_HEAP_GUARD;
@@ -241,10 +311,23 @@ void *pUPortMallocMonitor(size_t sizeBytes, const char *pFile,
 
             U_PORT_HEAP_MUTEX_LOCK(gMutex);
 
-            // Add the block to the list
-            pBlockTmp = gpHeapBlockList;
+            // Add the block to the head of the list
+            pBlock->pNext = gpHeapBlockList;
+            if (gpHeapBlockList != NULL) {
+                gpHeapBlockList->pPrev = pBlock;
+            }
             gpHeapBlockList = pBlock;
-            pBlock->pNext = pBlockTmp;
+            // Account for it against its call site
+            pSite = pSiteGet(pFile, line);
+            if (pSite != NULL) {
+                pSite->allocCount++;
+                pSite->liveCount++;
+                pSite->liveBytes += (int32_t) sizeBytes;
+                if (pSite->liveBytes > pSite->peakBytes) {
+                    pSite->peakBytes = pSite->liveBytes;
+                }
+            }
+            pBlock->pSite = pSite;
 
             U_PORT_HEAP_MUTEX_UNLOCK(gMutex);
         }
@@ -258,61 +341,84 @@ U_WEAK void uPortFree(void *pMemory)
 {
 #ifdef U_CFG_HEAP_MONITOR
     uPortHeapBlock_t *pBlock;
-    uPortHeapBlock_t *pBlockTmp1;
-    uPortHeapBlock_t *pBlockTmp2 = NULL;
     char *pTmp;
     const char *pMarker = NULL;
     uint32_t heapGuard = U_PORT_HEAP_GUARD;
+    bool guardIntact;
+    bool isLinked;
 
     if ((pMemory != NULL) && (gMutex != NULL)) {
         // Wind back to the start of the block
         pBlock = (uPortHeapBlock_t *) (((char *) pMemory) - (U_PORT_HEAP_STRUCTURE_SIZE_NO_END_PACKING +
                                                              U_PORT_HEAP_GUARD_SIZE));
-        // Check the guards
+        // Check the guards; if the opening guard has gone then
+        // neither the size nor the links of the block can be
+        // trusted, it may even have been freed already
         pTmp = ((char *) pMemory) - U_PORT_HEAP_GUARD_SIZE;
-        if (memcmp(pTmp, &heapGuard, U_PORT_HEAP_GUARD_SIZE) != 0) {
+        guardIntact = (memcmp(pTmp, &heapGuard, U_PORT_HEAP_GUARD_SIZE) == 0);
+        if (!guardIntact) {
             pMarker = U_PORT_HEAP_BUFFER_UNDERRUN_MARKER;
             uPortLog("%sexpected: ", pMarker);
             printMemory((char *) &heapGuard, U_PORT_HEAP_GUARD_SIZE);
             uPortLog(", got: ");
             printMemory(pTmp, U_PORT_HEAP_GUARD_SIZE);
             uPortLog("\n");
-        }
-        pTmp += U_PORT_HEAP_GUARD_SIZE + pBlock->size;
-        if (memcmp(pTmp, &heapGuard, U_PORT_HEAP_GUARD_SIZE) != 0) {
-            pMarker = U_PORT_HEAP_BUFFER_OVERRUN_MARKER;
-            uPortLog("%sexpected: ", pMarker);
-            printMemory((char *) &heapGuard, U_PORT_HEAP_GUARD_SIZE);
-            uPortLog(", got: ");
-            printMemory(pTmp, U_PORT_HEAP_GUARD_SIZE);
-            uPortLog("\n");
-        }
-        if (pMarker != NULL) {
-            printBlock(pMarker, pBlock);
+        } else {
+            pTmp += U_PORT_HEAP_GUARD_SIZE + pBlock->size;
+            if (memcmp(pTmp, &heapGuard, U_PORT_HEAP_GUARD_SIZE) != 0) {
+                pMarker = U_PORT_HEAP_BUFFER_OVERRUN_MARKER;
+                uPortLog("%sexpected: ", pMarker);
+                printMemory((char *) &heapGuard, U_PORT_HEAP_GUARD_SIZE);
+                uPortLog(", got: ");
+                printMemory(pTmp, U_PORT_HEAP_GUARD_SIZE);
+                uPortLog("\n");
+            }
         }
 
         U_PORT_HEAP_MUTEX_LOCK(gMutex);
 
-        // Remove the block from the list
-        pBlockTmp1 = gpHeapBlockList;
-        while ((pBlockTmp1 != NULL) && (pBlockTmp1 != pBlock)) {
-            pBlockTmp2 = pBlockTmp1;
-            pBlockTmp1 = pBlockTmp1->pNext;
-        }
-        if (pBlockTmp1 != NULL) {
-            if (pBlockTmp2 == NULL) {
-                // Must be at head
-                gpHeapBlockList = pBlockTmp1->pNext;
+        // Only remove the block from the list if it is really on it
+        isLinked = guardIntact &&
+                   ((pBlock->pPrev != NULL) ? (pBlock->pPrev->pNext == pBlock) :
+                    (gpHeapBlockList == pBlock)) &&
+                   ((pBlock->pNext == NULL) || (pBlock->pNext->pPrev == pBlock));
+        if (isLinked) {
+            if (pBlock->pPrev != NULL) {
+                pBlock->pPrev->pNext = pBlock->pNext;
             } else {
-                pBlockTmp2->pNext = pBlockTmp1->pNext;
+                // Must be at head
+                gpHeapBlockList = pBlock->pNext;
             }
+            if (pBlock->pNext != NULL) {
+                pBlock->pNext->pPrev = pBlock->pPrev;
+            }
+            if (pBlock->pSite != NULL) {
+                pBlock->pSite->liveCount--;
+                pBlock->pSite->liveBytes -= pBlock->size;
+            }
+            // Wipe the opening guard so that freeing
+            // the block a second time is caught
+            memset(((char *) pMemory) - U_PORT_HEAP_GUARD_SIZE, 0, U_PORT_HEAP_GUARD_SIZE);
         }
 
         U_PORT_HEAP_MUTEX_UNLOCK(gMutex);
 
+        if (isLinked) {
+            if (pMarker != NULL) {
+                printBlock(pMarker, pBlock);
+            }
+            // pBlock is what we need to free
+            pMemory = pBlock;
+        } else {
+            // Not on the list (e.g. already freed) or too
+            // damaged to tell: leave it alone
+            if (guardIntact) {
+                pMarker = U_PORT_HEAP_BAD_FREE_MARKER;
+                uPortLog("%saddress %p.\n", pMarker, pMemory);
+            }
+            pMemory = NULL;
+        }
         U_ASSERT(pMarker == NULL);
-        // pBlock is what we need to free
-        pMemory = pBlock;
     }
 #endif
 
@@ -327,6 +433,11 @@ U_WEAK int32_t uPortHeapAllocCount()
     return gHeapAllocCount;
 }
 
+U_WEAK int32_t uPortHeapMallocCount()
+{
+    return gHeapMallocCount;
+}
+
 U_WEAK void uPortHeapPerpetualAllocAdd()
 {
     gHeapPerpetualAllocCount++;
@@ -360,6 +471,33 @@ int32_t uPortHeapDump(const char *pPrefix)
     return x;
 }
 
+// Print out the statistics for each call site as CSV.
+int32_t uPortHeapDumpSitesCsv(const char *pPrefix)
+{
+    int32_t x = 0;
+
+#ifdef U_CFG_HEAP_MONITOR
+    const uPortHeapSite_t *pSite = gSites;
+
+    if (pPrefix == NULL) {
+        pPrefix = "";
+    }
+    uPortLog("%sfile,line,alloc count,live count,live bytes,peak bytes\n", pPrefix);
+    for (size_t y = 0; y < U_PORT_HEAP_MONITOR_MAX_NUM_SITES; y++, pSite++) {
+        if (pSite->pFile != NULL) {
+            uPortLog("%s%s,%d,%d,%d,%d,%d\n", pPrefix, pSite->pFile,
+                     pSite->line, pSite->allocCount, pSite->liveCount,
+                     pSite->liveBytes, pSite->peakBytes);
+            x++;
+        }
+    }
+#else
+    (void) pPrefix;
+#endif
+
+    return x;
+}
+
 // Initialise heap monitoring.
 int32_t uPortHeapMonitorInit(int32_t (*pMutexCreate) (uPortMutexHandle_t *),
                              int32_t (*pMutexLock) (const uPortMutexHandle_t),
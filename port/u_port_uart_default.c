@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Default implementations of UART functions.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+/* ----------------------------------------------------------------
+ * INCLUDE FILES
+ * -------------------------------------------------------------- */
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_compiler.h"  // U_WEAK
+
+#include "u_error_common.h"
+
+#include "u_port_uart.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Default implementation of a scatter-gather UART write: just
+// write each segment in turn.
+U_WEAK int32_t uPortUartWriteV(int32_t handle,
+                               const uPortUartSegment_t *pSegments,
+                               size_t numSegments)
+{
+    int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    int32_t thisSizeOrErrorCode;
+    size_t sizeWritten = 0;
+
+    if ((pSegments != NULL) || (numSegments == 0)) {
+        sizeOrErrorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        for (size_t x = 0; (x < numSegments) && (sizeOrErrorCode >= 0); x++) {
+            if (pSegments[x].sizeBytes > 0) {
+                thisSizeOrErrorCode = uPortUartWrite(handle, pSegments[x].pData,
+                                                     pSegments[x].sizeBytes);
+                if (thisSizeOrErrorCode >= 0) {
+                    sizeWritten += thisSizeOrErrorCode;
+                    if ((size_t) thisSizeOrErrorCode < pSegments[x].sizeBytes) {
+                        // Short write: stop here and let the caller
+                        // deal with it, as it would for uPortUartWrite()
+                        break;
+                    }
+                } else {
+                    sizeOrErrorCode = thisSizeOrErrorCode;
+                }
+            }
+        }
+        if (sizeOrErrorCode >= 0) {
+            sizeOrErrorCode = (int32_t) sizeWritten;
+        }
+    }
+
+    return sizeOrErrorCode;
+}
+
+// End of file
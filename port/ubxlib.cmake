@@ -169,6 +169,12 @@ list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_heap.c)
 # Default uPortGetTimezoneOffsetSeconds() implementation
 list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_timezone.c)
 
+# Default uPortGetTickTimeUs() implementation
+list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_tick_time_us.c)
+
+# Default uPortCodecXxx() implementation
+list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_codec.c)
+
 # Default uPortXxxResource implementation
 list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_resource.c)
 
@@ -176,6 +182,9 @@ list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_resource.c)
 list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_i2c_default.c)
 list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_spi_default.c)
 
+# Default implementation for uPortUartWriteV()
+list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_uart_default.c)
+
 # Default implementation for uPortNamePipeXxx()
 list(APPEND UBXLIB_SRC ${UBXLIB_BASE}/port/u_port_named_pipe_default.c)
 
@@ -71,6 +71,12 @@ SRC_LIST += ${UBXLIB_BASE}/port/u_port_heap.c
 # Default uPortGetTimezoneOffsetSeconds() implementation
 SRC_LIST += ${UBXLIB_BASE}/port/u_port_timezone.c
 
+# Default uPortGetTickTimeUs() implementation
+SRC_LIST += ${UBXLIB_BASE}/port/u_port_tick_time_us.c
+
+# Default uPortCodecXxx() implementation
+SRC_LIST += ${UBXLIB_BASE}/port/u_port_codec.c
+
 # Default uPortXxxResource implementation
 SRC_LIST += ${UBXLIB_BASE}/port/u_port_resource.c
 
@@ -78,6 +84,9 @@ SRC_LIST += ${UBXLIB_BASE}/port/u_port_resource.c
 SRC_LIST += ${UBXLIB_BASE}/port/u_port_i2c_default.c
 SRC_LIST += ${UBXLIB_BASE}/port/u_port_spi_default.c
 
+# Default implementation for uPortUartWriteV()
+SRC_LIST += ${UBXLIB_BASE}/port/u_port_uart_default.c
+
 # Default implementation for uPortNamePipeXxx()
 SRC_LIST += ${UBXLIB_BASE}/port/u_port_named_pipe_default.c
 
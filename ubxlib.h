@@ -85,6 +85,9 @@
 #include <u_network_config_wifi.h>
 #include <u_base64.h>
 #include <u_hex_bin_convert.h>
+#include <u_arena.h>
+#include <u_trace.h>
+#include <u_log.h>
 #include <u_mempool.h>
 #include <u_ringbuffer.h>
 #include <u_linked_list.h>
@@ -149,9 +152,17 @@
 #include <u_gnss_dec.h>
 #include <u_gnss_dec_ubx_nav_pvt.h>
 #include <u_gnss_dec_ubx_nav_hpposllh.h>
+#include <u_gnss_dec_ubx_nav_dop.h>
+#include <u_gnss_dec_ubx_nav_status.h>
+#include <u_gnss_dec_ubx_nav_sat.h>
+#include <u_gnss_dec_ubx_nav_sig.h>
+#include <u_gnss_dec_ubx_rxm_rawx.h>
+#include <u_gnss_dec_ubx_tim_tp.h>
+#include <u_gnss_dec_ubx_esf_meas.h>
 #include <u_gnss_mga.h>
 #include <u_gnss_geofence.h>
 #include <u_gnss_util.h>
+#include <u_gnss_replay.h>
 #include <u_wifi.h>
 #include <u_wifi_cfg.h>
 #include <u_wifi_mqtt.h>